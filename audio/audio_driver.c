@@ -75,6 +75,7 @@
 #endif
 
 #include "../configuration.h"
+#include "../performance_trace.h"
 #include "../driver.h"
 #include "../frontend/frontend_driver.h"
 #include "../retroarch.h"
@@ -891,7 +892,7 @@ static void audio_mixer_fold_float_voices_into_s16(int16_t *dst,
 }
 #endif
 
-static void audio_driver_flush(audio_driver_state_t *audio_st,
+static void audio_driver_flush_internal(audio_driver_state_t *audio_st,
       float slowmotion_ratio,
       const void *data, size_t samples, bool is_float,
       bool is_slowmotion, bool is_fastforward)
@@ -1637,6 +1638,17 @@ static void audio_driver_flush(audio_driver_state_t *audio_st,
    }
 }
 
+static void audio_driver_flush(audio_driver_state_t *audio_st,
+      float slowmotion_ratio,
+      const void *data, size_t samples, bool is_float,
+      bool is_slowmotion, bool is_fastforward)
+{
+   PERF_TRACE_BEGIN("audio_flush");
+   audio_driver_flush_internal(audio_st, slowmotion_ratio, data, samples,
+         is_float, is_slowmotion, is_fastforward);
+   PERF_TRACE_END("audio_flush");
+}
+
 #ifdef HAVE_AUDIOMIXER
 audio_mixer_stream_t *audio_driver_mixer_get_stream(unsigned i)
 {
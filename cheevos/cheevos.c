@@ -59,6 +59,8 @@
 #include "cheevos_client.h"
 #include "cheevos_menu.h"
 #include "cheevos_locals.h"
+#include "cheevos_snapshot.h"
+#include "cheevos_hash_cache.h"
 
 #include "../network/netplay/netplay.h"
 
@@ -656,8 +658,396 @@ static void rcheevos_server_reconnected(void)
 #endif
 }
 
+/*****************************************************************************
+Background evaluation.
+
+With cheevos_background_eval enabled, rcheevos_test() copies the memory
+the achievement set reads into a snapshot at the end of each frame and
+hands the frame to a worker thread, which evaluates it while the core is
+running the next one. The worker only reads the snapshot, so achievements
+trigger on the same frame as when evaluated synchronously; the events it
+raises and the server requests it makes (awards, submissions, pings) are
+queued and dispatched on the main thread one frame later. Nothing is ever
+reported or sent from the worker: if the queue cannot grow, what did not
+fit is lost and background evaluation stays off until the game is
+unloaded.
+
+The pages to snapshot are learned from the reads of a few synchronous
+frames after starting. A read the snapshot cannot serve later on (an
+indirect address that moved) is never made from the worker, which would
+race the core: the worker waits until the main thread next waits for it,
+outside the core, and the main thread makes the read there. That value
+is a frame late, and the page is added from the next frame on.
+
+Anything outside the frame loop that uses the game state of the client
+first waits for the worker through rcheevos_bg_sync(), from any thread.
+Only the main thread can make a late read, so it syncs before it blocks
+on a task that might sync in turn: see rcheevos_sync().
+*****************************************************************************/
+#if defined(HAVE_THREADS) && !defined(RC_NO_THREADS)
+#define HAVE_RCHEEVOS_BG_EVAL
+
+#define RCHEEVOS_BG_WARMUP_FRAMES 2
+
+/* A server request made on the worker, with its own copy of the
+ * strings, which rc_client frees as soon as server_call returns */
+typedef struct rcheevos_bg_call
+{
+   struct rcheevos_bg_call* next;
+   rc_client_server_callback_t callback;
+   void* callback_data;
+   const char* url;
+   const char* post_data;
+   const char* content_type;
+} rcheevos_bg_call_t;
+
+typedef struct rcheevos_bg
+{
+   sthread_t* thread;
+   slock_t* lock;
+   scond_t* cond;
+   rcheevos_snapshot_t* snapshot;
+   rc_client_event_t* events;         /* raised by the worker, not dispatched yet */
+   rcheevos_bg_call_t* calls;         /* made by the worker, not issued yet */
+   rcheevos_bg_call_t** calls_tail;
+   unsigned event_count;
+   unsigned event_capacity;
+   unsigned warmup;                   /* synchronous frames left before the first snapshot */
+   unsigned frames;
+   unsigned late_reads;               /* worker reads the snapshot could not serve */
+   uint32_t miss_address;
+   uint32_t miss_bytes;
+   uint32_t miss_read;
+   uint8_t miss_data[4];              /* rc_client never peeks more at once */
+   bool busy;                         /* worker is evaluating a frame */
+   bool miss;                         /* worker waits for miss_* to be read */
+   bool learning;                     /* main thread is evaluating a warm-up frame */
+   bool quit;
+   bool dropped;                      /* the worker could not queue an event or call */
+   bool failed;                       /* stays off until the game is unloaded */
+} rcheevos_bg_t;
+
+static rcheevos_bg_t rcheevos_bg;
+
+static void rcheevos_client_event_handler(const rc_client_event_t* event,
+      rc_client_t* client);
+
+static uint32_t rcheevos_bg_peek(uint32_t address,
+      uint8_t* buffer, uint32_t num_bytes, void* userdata)
+{
+   return rc_libretro_memory_read(&rcheevos_locals.memory,
+         address, buffer, num_bytes);
+}
+
+static void rcheevos_bg_thread(void* userdata)
+{
+   slock_lock(rcheevos_bg.lock);
+   for (;;)
+   {
+      while (!rcheevos_bg.busy && !rcheevos_bg.quit)
+         scond_wait(rcheevos_bg.cond, rcheevos_bg.lock);
+      if (rcheevos_bg.quit)
+         break;
+      slock_unlock(rcheevos_bg.lock);
+
+      rc_client_do_frame(rcheevos_locals.client);
+
+      slock_lock(rcheevos_bg.lock);
+      rcheevos_bg.busy = false;
+      scond_broadcast(rcheevos_bg.cond);
+   }
+   slock_unlock(rcheevos_bg.lock);
+}
+
+/* Waits for the worker to finish its frame. On the main thread, which
+ * is never inside the core here, this also makes the reads the worker
+ * hands over; anywhere else those wait for the main thread. */
+static void rcheevos_bg_wait(void)
+{
+   bool main_thread = task_is_on_main_thread();
+
+   slock_lock(rcheevos_bg.lock);
+   while (rcheevos_bg.busy)
+   {
+      if (rcheevos_bg.miss && main_thread)
+      {
+         rcheevos_bg.miss_read = rc_libretro_memory_read(
+               &rcheevos_locals.memory, rcheevos_bg.miss_address,
+               rcheevos_bg.miss_data, rcheevos_bg.miss_bytes);
+         rcheevos_bg.miss      = false;
+         scond_broadcast(rcheevos_bg.cond);
+         continue;
+      }
+      scond_wait(rcheevos_bg.cond, rcheevos_bg.lock);
+   }
+   slock_unlock(rcheevos_bg.lock);
+}
+
+/* Called on the worker for a read the snapshot cannot serve. */
+static uint32_t rcheevos_bg_read_late(uint32_t address,
+      uint8_t* buffer, uint32_t num_bytes)
+{
+   uint32_t read;
+
+   if (num_bytes > sizeof(rcheevos_bg.miss_data))
+      return 0;
+
+   slock_lock(rcheevos_bg.lock);
+   rcheevos_bg.miss_address = address;
+   rcheevos_bg.miss_bytes   = num_bytes;
+   rcheevos_bg.miss         = true;
+   scond_broadcast(rcheevos_bg.cond);
+   while (rcheevos_bg.miss)
+      scond_wait(rcheevos_bg.cond, rcheevos_bg.lock);
+   read = rcheevos_bg.miss_read;
+   memcpy(buffer, rcheevos_bg.miss_data, read);
+   rcheevos_bg.late_reads++;
+   slock_unlock(rcheevos_bg.lock);
+   return read;
+}
+
+/* Called by the event handler on the worker thread. Events that point
+ * at data owned by a server response cannot be kept until the next
+ * frame; they are raised by response callbacks, which run on the main
+ * thread unless a request could not be queued. */
+static bool rcheevos_bg_queue_event(const rc_client_event_t* event)
+{
+   if (     event->type == RC_CLIENT_EVENT_SERVER_ERROR
+         || event->type == RC_CLIENT_EVENT_LEADERBOARD_SCOREBOARD)
+      return false;
+
+   if (rcheevos_bg.event_count == rcheevos_bg.event_capacity)
+   {
+      unsigned capacity         = rcheevos_bg.event_capacity
+         ? rcheevos_bg.event_capacity * 2 : 16;
+      rc_client_event_t* events = (rc_client_event_t*)realloc(
+            rcheevos_bg.events, capacity * sizeof(*events));
+      if (!events)
+         return false;
+      rcheevos_bg.events         = events;
+      rcheevos_bg.event_capacity = capacity;
+   }
+
+   rcheevos_bg.events[rcheevos_bg.event_count++] = *event;
+   return true;
+}
+
+/* Called by the server_call hook on the worker thread, where pushing
+ * the HTTP task would race the main thread over the task queue. */
+static bool rcheevos_bg_queue_call(const rc_api_request_t* request,
+      rc_client_server_callback_t callback, void* callback_data)
+{
+   char* s;
+   rcheevos_bg_call_t* call;
+   size_t url_len  = strlen(request->url) + 1;
+   size_t post_len = request->post_data
+      ? strlen(request->post_data) + 1 : 0;
+   size_t type_len = request->content_type
+      ? strlen(request->content_type) + 1 : 0;
+
+   if (!(call = (rcheevos_bg_call_t*)malloc(
+               sizeof(*call) + url_len + post_len + type_len)))
+      return false;
+
+   s                   = (char*)(call + 1);
+   call->next          = NULL;
+   call->callback      = callback;
+   call->callback_data = callback_data;
+   call->url           = s;
+   memcpy(s, request->url, url_len);
+   s                  += url_len;
+   call->post_data     = NULL;
+   if (post_len)
+   {
+      call->post_data  = s;
+      memcpy(s, request->post_data, post_len);
+      s               += post_len;
+   }
+   call->content_type  = NULL;
+   if (type_len)
+   {
+      call->content_type = s;
+      memcpy(s, request->content_type, type_len);
+   }
+
+   if (!rcheevos_bg.calls_tail)
+      rcheevos_bg.calls_tail = &rcheevos_bg.calls;
+   *rcheevos_bg.calls_tail = call;
+   rcheevos_bg.calls_tail  = &call->next;
+   return true;
+}
+
+static void rcheevos_bg_dispatch(void)
+{
+   unsigned i;
+   rc_client_event_t* events = rcheevos_bg.events;
+   unsigned count            = rcheevos_bg.event_count;
+   rcheevos_bg_call_t* call  = rcheevos_bg.calls;
+
+   if (!count && !call)
+      return;
+
+   /* Detach the queues first: a handler can end up back in here, or
+    * stop the worker, e.g. when an event resets the game. */
+   rcheevos_bg.events         = NULL;
+   rcheevos_bg.event_count    = 0;
+   rcheevos_bg.event_capacity = 0;
+   rcheevos_bg.calls          = NULL;
+   rcheevos_bg.calls_tail     = NULL;
+
+   for (i = 0; i < count; i++)
+      rcheevos_client_event_handler(&events[i], rcheevos_locals.client);
+   free(events);
+
+   while (call)
+   {
+      rc_api_request_t request;
+      rcheevos_bg_call_t* next = call->next;
+
+      memset(&request, 0, sizeof(request));
+      request.url          = call->url;
+      request.post_data    = call->post_data;
+      request.content_type = call->content_type;
+      rcheevos_client_server_call(&request, call->callback,
+            call->callback_data, rcheevos_locals.client);
+
+      free(call);
+      call = next;
+   }
+}
+
+static void rcheevos_bg_stop(void)
+{
+   if (!rcheevos_bg.thread)
+      return;
+
+   rcheevos_bg_wait();
+   slock_lock(rcheevos_bg.lock);
+   rcheevos_bg.quit = true;
+   scond_broadcast(rcheevos_bg.cond);
+   slock_unlock(rcheevos_bg.lock);
+   sthread_join(rcheevos_bg.thread);
+   rcheevos_bg.thread = NULL;
+
+   CHEEVOS_LOG(RCHEEVOS_TAG "Background evaluation stopped: %u frames, %u pages per frame, %u reads outside the snapshot\n",
+         rcheevos_bg.frames, rcheevos_snapshot_page_count(rcheevos_bg.snapshot),
+         rcheevos_bg.late_reads);
+
+   /* The lock and condition stay: a savestate task may be syncing
+    * from another thread right now. */
+   rcheevos_snapshot_free(rcheevos_bg.snapshot);
+   rcheevos_bg.snapshot = NULL;
+
+   /* Whatever the last frame raised still has to be reported */
+   rcheevos_bg_dispatch();
+}
+
+static bool rcheevos_bg_start(void)
+{
+   rcheevos_bg.busy       = false;
+   rcheevos_bg.quit       = false;
+   rcheevos_bg.frames     = 0;
+   rcheevos_bg.late_reads = 0;
+   rcheevos_bg.miss       = false;
+   rcheevos_bg.dropped    = false;
+   rcheevos_bg.warmup     = RCHEEVOS_BG_WARMUP_FRAMES;
+
+   if (     !(rcheevos_bg.snapshot = rcheevos_snapshot_new(
+                  rcheevos_locals.memory.total_size))
+         || (!rcheevos_bg.lock && !(rcheevos_bg.lock = slock_new()))
+         || (!rcheevos_bg.cond && !(rcheevos_bg.cond = scond_new()))
+         || !(rcheevos_bg.thread = sthread_create(rcheevos_bg_thread, NULL)))
+   {
+      CHEEVOS_ERR(RCHEEVOS_TAG "Could not start background evaluation\n");
+      rcheevos_snapshot_free(rcheevos_bg.snapshot);
+      rcheevos_bg.snapshot = NULL;
+      rcheevos_bg.failed   = true;
+      return false;
+   }
+
+   CHEEVOS_LOG(RCHEEVOS_TAG "Background evaluation started\n");
+   return true;
+}
+
+/* Waits for the frame being evaluated and, on the main thread, reports
+ * what it raised. A savestate task on another thread still has to wait,
+ * so that the progress it saves includes the last frame. */
+static void rcheevos_bg_sync(void)
+{
+   if (!rcheevos_bg.thread)
+      return;
+   rcheevos_bg_wait();
+   if (task_is_on_main_thread())
+      rcheevos_bg_dispatch();
+}
+
+/* Returns true if the frame was taken care of, false if the caller
+ * has to evaluate it. */
+static bool rcheevos_bg_frame(void)
+{
+   if (     !config_get_ptr()->bools.cheevos_background_eval
+         || !rcheevos_is_game_loaded())
+   {
+      rcheevos_bg_stop();
+      return false;
+   }
+
+   if (!rcheevos_bg.thread)
+   {
+      if (rcheevos_bg.failed || !rcheevos_bg_start())
+         return false;
+   }
+   else
+   {
+      rcheevos_bg_wait();
+      rcheevos_snapshot_commit_misses(rcheevos_bg.snapshot);
+      rcheevos_bg_dispatch();
+      if (rcheevos_bg.dropped)
+      {
+         CHEEVOS_ERR(RCHEEVOS_TAG "Out of memory, evaluating in the foreground\n");
+         rcheevos_bg_stop();
+         rcheevos_bg.failed = true;
+      }
+      if (!rcheevos_bg.thread)
+         return false;
+   }
+
+   if (rcheevos_bg.warmup)
+   {
+      rcheevos_bg.warmup--;
+      rcheevos_bg.learning = true;
+      rc_client_do_frame(rcheevos_locals.client);
+      rcheevos_bg.learning = false;
+      return true;
+   }
+
+   rcheevos_snapshot_capture(rcheevos_bg.snapshot, rcheevos_bg_peek, NULL);
+   rcheevos_snapshot_swap(rcheevos_bg.snapshot);
+   rcheevos_bg.frames++;
+
+   slock_lock(rcheevos_bg.lock);
+   rcheevos_bg.busy = true;
+   scond_broadcast(rcheevos_bg.cond);
+   slock_unlock(rcheevos_bg.lock);
+   return true;
+}
+#endif
+
 static void rcheevos_client_event_handler(const rc_client_event_t* event, rc_client_t* client)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   if (rcheevos_bg.thread && sthread_isself(rcheevos_bg.thread))
+   {
+      if (!rcheevos_bg_queue_event(event))
+      {
+         CHEEVOS_ERR(RCHEEVOS_TAG "Lost event %d raised during background evaluation\n",
+               event->type);
+         rcheevos_bg.dropped = true;
+      }
+      return;
+   }
+#endif
+
    switch (event->type)
    {
 #ifdef HAVE_GFX_WIDGETS
@@ -729,6 +1119,9 @@ static void rcheevos_client_event_handler(const rc_client_event_t* event, rc_cli
 
 int rcheevos_get_richpresence(char* s, size_t len)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
    if (!rcheevos_is_player_active())
    {
       if (!rcheevos_is_game_loaded())
@@ -767,6 +1160,10 @@ static void rcheevos_hide_widgets(bool widgets_ready)
 
 void rcheevos_reset_game(bool widgets_ready)
 {
+   /* The memory map is rebuilt below, restart from a fresh snapshot */
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_stop();
+#endif
 #if defined(HAVE_GFX_WIDGETS)
    /* Hide any visible trackers */
    rcheevos_hide_widgets(widgets_ready);
@@ -782,6 +1179,9 @@ void rcheevos_reset_game(bool widgets_ready)
 
 void rcheevos_refresh_memory(void)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_stop();
+#endif
    if (rcheevos_locals.memory.total_size > 0)
       rcheevos_init_memory(&rcheevos_locals);
 }
@@ -809,6 +1209,11 @@ bool rcheevos_unload(void)
 {
    const bool was_loaded = rcheevos_is_game_loaded();
 
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_stop();
+   rcheevos_bg.failed = false;
+#endif
+
 #ifdef HAVE_THREADS
    /* Bump the load generation FIRST, before any other state
     * mutation. Any background load callback already in flight
@@ -894,6 +1299,10 @@ static void rcheevos_toggle_hardcore_active(rcheevos_locals_t* locals)
    bool notification_show_cheats_applied =
       settings->bools.notification_show_cheats_applied;
 
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
+
    if (!was_enabled)
    {
       locals->hardcore_being_enabled = true;
@@ -1155,28 +1564,58 @@ void rcheevos_test(void)
 #endif
 
    if (rcheevos_locals.memory.count != 0)
+   {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+      if (rcheevos_bg_frame())
+         return;
+#endif
       rc_client_do_frame(rcheevos_locals.client);
+   }
    else
+   {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+      rcheevos_bg_stop();
+#endif
       rc_client_idle(rcheevos_locals.client);
+   }
 }
 
 void rcheevos_idle(void)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
    rc_client_idle(rcheevos_locals.client);
 }
 
+void rcheevos_sync(void)
+{
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
+}
+
 size_t rcheevos_get_serialize_size(void)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
    return rc_client_progress_size(rcheevos_locals.client);
 }
 
 bool rcheevos_get_serialized_data(void* buffer)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
    return (rc_client_serialize_progress(rcheevos_locals.client, (uint8_t*)buffer) == RC_OK);
 }
 
 bool rcheevos_set_serialized_data(void* buffer)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_sync();
+#endif
    if (rcheevos_is_game_loaded() && buffer)
    {
       const int result = rc_client_deserialize_progress(
@@ -1276,8 +1715,9 @@ static void* rc_hash_handle_chd_open_track(
       CHEEVOS_FREE(file);
       cdfs_close_track(cdfs_track); /* ASSERT: this free()s cdfs_track */
    }
-   else
+   else if (task_is_on_main_thread())
    {
+      /* Not when prewarming the hash cache on a task thread */
       rcheevos_locals.hash_error = "Could not open CHD file";
    }
 
@@ -1340,7 +1780,8 @@ static void* rc_hash_handle_cd_open_track(
 
       return rc_hash_handle_chd_open_track(path, track);
 #else
-      rcheevos_locals.hash_error = "No CHD support";
+      if (task_is_on_main_thread())
+         rcheevos_locals.hash_error = "No CHD support";
       CHEEVOS_LOG(RCHEEVOS_TAG "Cannot generate hash from CHD without HAVE_CHD compile flag\n");
       return NULL;
 #endif
@@ -1362,8 +1803,171 @@ static void rc_hash_reset_cdreader_hooks(void)
    rc_hash_init_custom_cdreader(&cdreader);
 }
 
+/* Same readers as above, but set on the iterator only, for hashing
+ * off the main thread without touching the rc_hash globals */
+static void rc_hash_init_iterator_hooks(rc_hash_iterator_t* iterator)
+{
+   iterator->callbacks.filereader.open  = rc_hash_handle_file_open;
+   iterator->callbacks.filereader.seek  = rc_hash_handle_file_seek;
+   iterator->callbacks.filereader.tell  = rc_hash_handle_file_tell;
+   iterator->callbacks.filereader.read  = rc_hash_handle_file_read;
+   iterator->callbacks.filereader.close = rc_hash_handle_file_close;
+   rc_hash_get_default_cdreader(&iterator->callbacks.cdreader);
+   iterator->callbacks.cdreader.open_track_iterator = rc_hash_handle_cd_open_track;
+}
+
 /* end hooks */
 
+/* Hash cache
+ *
+ * A load that finds the content in cheevos_hash_cache.c asks the
+ * server for the cached hash directly, instead of having rc_client
+ * hash the content. Hashes the prewarm task computed have not been
+ * seen by the server yet and may be several, one per console the
+ * file could be for; they are tried in turn, as identify would. The
+ * hash that identified the game replaces them. */
+
+static struct
+{
+   rcheevos_hash_cache_record_t record;
+   char key[PATH_MAX_LENGTH];  /* content as the cache knows it; empty
+                                  if this load is not cached */
+   unsigned next;              /* record.hashes[] to try next */
+   bool from_cache;            /* the load is trying record.hashes[] */
+} rcheevos_hash_load;
+
+static bool rcheevos_hash_cache_ready(const settings_t* settings)
+{
+   char path[PATH_MAX_LENGTH];
+
+   if (     !settings->bools.cheevos_hash_cache
+         || !*settings->paths.directory_playlist)
+      return false;
+
+   fill_pathname_join_special(path, settings->paths.directory_playlist,
+         FILE_PATH_CHEEVOS_HASH_CACHE, sizeof(path));
+   return rcheevos_hash_cache_open(path);
+}
+
+/* Content extracted from an archive is loaded from a temporary copy;
+ * the cache knows it by the archive member instead. Any other copy
+ * is not cached. */
+static bool rcheevos_hash_cache_key(const char* path, char* s, size_t len)
+{
+   const char* content = path_get(RARCH_PATH_CONTENT);
+
+   if (!string_is_equal(path, content))
+   {
+      if (     !content
+            || !*content
+            || (  !path_contains_compressed_file(content)
+               && !path_is_compressed_file(content)))
+         return false;
+      path = content;
+   }
+
+   return strlcpy(s, path, len) < len;
+}
+
+static void rcheevos_hash_cache_store_game(const rc_client_game_t* game)
+{
+   rcheevos_hash_cache_record_t* rec = &rcheevos_hash_load.record;
+
+   /* Unidentified games carry the hashes tried, comma separated */
+   if (     !*rcheevos_hash_load.key
+         || (rcheevos_hash_load.from_cache && rec->verified)
+         || !game->id
+         || !game->hash
+         || strlen(game->hash) != 32)
+      return;
+
+   /* The key was set by the stat done before the content was hashed */
+   rec->console_ids[0] = game->console_id;
+   strlcpy(rec->hashes[0], game->hash, sizeof(rec->hashes[0]));
+   rec->count          = 1;
+   rec->verified       = true;
+
+   rcheevos_hash_cache_store(rcheevos_hash_load.key, rec);
+   rcheevos_hash_cache_write();
+}
+
+bool rcheevos_prewarm_begin(void)
+{
+   const settings_t* settings = config_get_ptr();
+   return settings && rcheevos_hash_cache_ready(settings);
+}
+
+enum rcheevos_prewarm_result rcheevos_prewarm_hash(const char* path)
+{
+   char hash[33];
+   rc_hash_iterator_t iterator;
+   rcheevos_hash_cache_record_t rec;
+
+   /* rc_hash cannot look inside an archive; such content is hashed
+    * when loaded, from the extracted copy */
+   if (     !path
+         || !*path
+         || path_contains_compressed_file(path)
+         || path_is_compressed_file(path))
+      return RCHEEVOS_PREWARM_SKIPPED;
+
+   rcheevos_hash_cache_stat(path, &rec);
+   if (!rec.mtime)
+      return RCHEEVOS_PREWARM_SKIPPED;
+   if (rcheevos_hash_cache_lookup(path, &rec))
+      return RCHEEVOS_PREWARM_CACHED;
+
+   rec.count    = 0;
+   rec.verified = false;
+
+   rc_hash_initialize_iterator(&iterator, path, NULL, 0);
+   rc_hash_init_iterator_hooks(&iterator);
+
+#ifdef HAVE_CHEEVOS_RVZ
+   if (string_is_equal_noncase(path_get_extension(path), "rvz"))
+   {
+      uint32_t console_id = rcheevos_rvz_get_console_id(path);
+
+      iterator.callbacks.filereader.open  = rcheevos_rvz_open;
+      iterator.callbacks.filereader.seek  = rcheevos_rvz_seek;
+      iterator.callbacks.filereader.tell  = rcheevos_rvz_tell;
+      iterator.callbacks.filereader.read  = rcheevos_rvz_read;
+      iterator.callbacks.filereader.close = rcheevos_rvz_close;
+
+      if (     console_id != RC_CONSOLE_UNKNOWN
+            && rc_hash_generate(hash, console_id, &iterator))
+      {
+         rec.console_ids[0] = console_id;
+         strlcpy(rec.hashes[0], hash, sizeof(rec.hashes[0]));
+         rec.count          = 1;
+      }
+   }
+   else
+#endif
+   {
+      while (     rec.count < RCHEEVOS_HASH_CACHE_MAX_HASHES
+               && rc_hash_iterate(hash, &iterator))
+      {
+         rec.console_ids[rec.count] = iterator.consoles[iterator.index - 1];
+         strlcpy(rec.hashes[rec.count], hash, sizeof(rec.hashes[0]));
+         rec.count++;
+      }
+   }
+
+   rc_hash_destroy_iterator(&iterator);
+
+   if (!rec.count)
+      return RCHEEVOS_PREWARM_FAILED;
+
+   rcheevos_hash_cache_store(path, &rec);
+   return RCHEEVOS_PREWARM_HASHED;
+}
+
+bool rcheevos_prewarm_end(void)
+{
+   return rcheevos_hash_cache_write();
+}
+
 static void rcheevos_show_game_placard(void)
 {
    size_t _len;
@@ -1448,6 +2052,21 @@ static void rcheevos_show_game_placard(void)
 static uint32_t rcheevos_client_read_memory(uint32_t address,
    uint8_t* buffer, uint32_t num_bytes, rc_client_t* client)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   if (rcheevos_bg.snapshot)
+   {
+      if (sthread_isself(rcheevos_bg.thread))
+      {
+         uint32_t read;
+         if (rcheevos_snapshot_read(rcheevos_bg.snapshot,
+                  address, buffer, num_bytes, &read))
+            return read;
+         return rcheevos_bg_read_late(address, buffer, num_bytes);
+      }
+      else if (rcheevos_bg.learning)
+         rcheevos_snapshot_add(rcheevos_bg.snapshot, address, num_bytes);
+   }
+#endif
    return rc_libretro_memory_read(&rcheevos_locals.memory, address, buffer, num_bytes);
 }
 
@@ -1495,6 +2114,27 @@ static uint32_t rcheevos_client_read_memory_uninitialized(uint32_t address,
    return rcheevos_client_read_memory_unavailable(address, buffer, num_bytes, client);
 }
 
+static void rcheevos_client_server_call_deferred(const rc_api_request_t* request,
+   rc_client_server_callback_t callback, void* callback_data, rc_client_t* client)
+{
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   if (rcheevos_bg.thread && sthread_isself(rcheevos_bg.thread))
+   {
+      /* Same zeroed response as for a request that cannot be sent, so
+       * that rc_client does not wait for a reply */
+      if (!rcheevos_bg_queue_call(request, callback, callback_data))
+      {
+         rc_api_server_response_t server_response;
+         memset(&server_response, 0, sizeof(server_response));
+         rcheevos_bg.dropped = true;
+         callback(&server_response, callback_data);
+      }
+      return;
+   }
+#endif
+   rcheevos_client_server_call(request, callback, callback_data, client);
+}
+
 static void rcheevos_client_login_callback(int result,
    const char* error_message, rc_client_t* client, void* userdata)
 {
@@ -1711,6 +2351,18 @@ static void rcheevos_client_load_game_callback(int result,
    }
 #endif
 
+   /* A cached hash for another of the consoles the content could be
+    * for: try the next one, as identify would have */
+   if (     result == RC_NO_GAME_LOADED
+         && rcheevos_hash_load.from_cache
+         && rcheevos_hash_load.next < rcheevos_hash_load.record.count)
+   {
+      rc_client_begin_load_game(client,
+         rcheevos_hash_load.record.hashes[rcheevos_hash_load.next++],
+         rcheevos_client_load_game_callback, userdata);
+      return;
+   }
+
 #if defined(HAVE_GFX_WIDGETS)
    gfx_widget_set_cheevos_set_loading(false);
 #endif
@@ -1786,6 +2438,8 @@ static void rcheevos_client_load_game_callback(int result,
       rc_client_set_read_memory_function(client, rcheevos_client_read_memory);
    }
 
+   rcheevos_hash_cache_store_game(game);
+
    rcheevos_finalize_game_load(client);
 
    /* Hardcore is active. we're going to start processing
@@ -1873,11 +2527,16 @@ bool rcheevos_load(const void *data)
       rcheevos_locals.user_agent_core,
       sizeof(rcheevos_locals.user_agent_core));
 
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_stop();
+#endif
+
    if (rcheevos_locals.client)
       rc_client_unload_game(rcheevos_locals.client);
    else
    {
-      rcheevos_locals.client = rc_client_create(rcheevos_client_read_memory, rcheevos_client_server_call);
+      rcheevos_locals.client = rc_client_create(rcheevos_client_read_memory,
+            rcheevos_client_server_call_deferred);
       rc_client_enable_logging(rcheevos_locals.client, RC_CLIENT_LOG_LEVEL_VERBOSE, rcheevos_client_log_message);
       rc_client_set_event_handler(rcheevos_locals.client, rcheevos_client_event_handler);
       rc_client_set_get_time_millisecs_function(rcheevos_locals.client, rcheevos_client_get_time_millisecs);
@@ -1960,9 +2619,7 @@ bool rcheevos_load(const void *data)
 #endif
 
       {
-#ifdef HAVE_THREADS
-         intptr_t gen;
-#endif
+         void* userdata      = NULL;
          const uint8_t* data = (const uint8_t*)info->data;
          size_t data_size = info->size;
 
@@ -1977,6 +2634,28 @@ bool rcheevos_load(const void *data)
             }
          }
 
+         rcheevos_hash_load.key[0]     = '\0';
+         rcheevos_hash_load.from_cache = false;
+
+         /* Only content hashed from its file is cached; what the core
+          * was handed in memory may have been softpatched */
+         if (     !data
+               && rcheevos_hash_cache_ready(settings)
+               && rcheevos_hash_cache_key(info->path, rcheevos_hash_load.key,
+                     sizeof(rcheevos_hash_load.key)))
+         {
+            rcheevos_hash_cache_stat(rcheevos_hash_load.key,
+                  &rcheevos_hash_load.record);
+            if (rcheevos_hash_cache_lookup(rcheevos_hash_load.key,
+                     &rcheevos_hash_load.record))
+            {
+               CHEEVOS_LOG(RCHEEVOS_TAG "Using cached hash %s\n",
+                     rcheevos_hash_load.record.hashes[0]);
+               rcheevos_hash_load.from_cache = true;
+               rcheevos_hash_load.next       = 1;
+            }
+         }
+
 #ifdef HAVE_THREADS
          /* Capture the current load generation; the callback
           * compares this against the live value to detect a
@@ -1985,14 +2664,16 @@ bool rcheevos_load(const void *data)
           * loses information only if HAVE_THREADS is enabled
           * and a generation counter overflows intptr_t, which
           * would require ~2^31 (or ~2^63) load events. */
-         gen = (intptr_t)retro_atomic_load_acquire_int(
+         userdata = (void*)(intptr_t)retro_atomic_load_acquire_int(
                &rcheevos_locals.load_generation);
-         rc_client_begin_identify_and_load_game(rcheevos_locals.client, console_id,
-            info->path, data, data_size, rcheevos_client_load_game_callback, (void*)gen);
-#else
-         rc_client_begin_identify_and_load_game(rcheevos_locals.client, console_id,
-            info->path, data, data_size, rcheevos_client_load_game_callback, NULL);
 #endif
+         if (rcheevos_hash_load.from_cache)
+            rc_client_begin_load_game(rcheevos_locals.client,
+               rcheevos_hash_load.record.hashes[0],
+               rcheevos_client_load_game_callback, userdata);
+         else
+            rc_client_begin_identify_and_load_game(rcheevos_locals.client, console_id,
+               info->path, data, data_size, rcheevos_client_load_game_callback, userdata);
       }
    }
 
@@ -2028,8 +2709,36 @@ static void rcheevos_client_change_media_callback(int result,
 
 void rcheevos_change_disc(const char* new_disc_path, bool initial_disc)
 {
+#ifdef HAVE_RCHEEVOS_BG_EVAL
+   rcheevos_bg_stop();
+#endif
    if (rcheevos_locals.client)
    {
+      const rc_client_game_t* game = rc_client_get_game_info(rcheevos_locals.client);
+      rcheevos_hash_cache_record_t rec;
+
+      /* Discs the prewarm task found through an m3u are cached with
+       * a hash for each console they could be for */
+      if (     game
+            && game->console_id != RC_CONSOLE_UNKNOWN
+            && rcheevos_hash_cache_ready(config_get_ptr()))
+      {
+         unsigned i;
+         rcheevos_hash_cache_stat(new_disc_path, &rec);
+         if (rcheevos_hash_cache_lookup(new_disc_path, &rec))
+         {
+            for (i = 0; i < rec.count; i++)
+            {
+               if (rec.console_ids[i] == game->console_id)
+               {
+                  rc_client_begin_change_media(rcheevos_locals.client,
+                     rec.hashes[i], rcheevos_client_change_media_callback, NULL);
+                  return;
+               }
+            }
+         }
+      }
+
       rc_client_begin_identify_and_change_media(rcheevos_locals.client, new_disc_path,
          NULL, 0, rcheevos_client_change_media_callback, NULL);
    }
@@ -37,6 +37,12 @@ bool rcheevos_unload(void);
 void rcheevos_test(void);
 void rcheevos_idle(void);
 
+/* Waits for the frame achievements are evaluating in the background,
+ * if any. The main thread calls this before it blocks on a task that
+ * may wait for that frame itself, since only the main thread can finish
+ * it. */
+void rcheevos_sync(void);
+
 void rcheevos_reset_game(bool widgets_ready);
 void rcheevos_refresh_memory(void);
 
@@ -63,6 +69,24 @@ bool rcheevos_is_badge_available(const char* badge, bool locked);
 
 uint8_t* rcheevos_patch_address(unsigned address);
 
+enum rcheevos_prewarm_result
+{
+   RCHEEVOS_PREWARM_FAILED = 0,
+   RCHEEVOS_PREWARM_SKIPPED,
+   RCHEEVOS_PREWARM_CACHED,
+   RCHEEVOS_PREWARM_HASHED
+};
+
+/* Filling the hash cache ahead of the loads that would otherwise
+ * compute the hashes. rcheevos_prewarm_begin() runs on the main
+ * thread and returns false if the cache is disabled; the other two
+ * may then run on a task thread. rcheevos_prewarm_hash() reads the
+ * content unless its hashes are already cached, and
+ * rcheevos_prewarm_end() writes the cache out. */
+bool rcheevos_prewarm_begin(void);
+enum rcheevos_prewarm_result rcheevos_prewarm_hash(const char* path);
+bool rcheevos_prewarm_end(void);
+
 RETRO_END_DECLS
 
 #endif /* __RARCH_CHEEVOS_CHEEVOS_H */
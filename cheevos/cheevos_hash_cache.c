@@ -0,0 +1,406 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2019-2023 - Brian Weiss
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Content hashes computed by earlier loads.
+ *
+ * Identifying a game means hashing its content, and for a CD or DVD
+ * image that can mean reading and decompressing hundreds of megabytes
+ * before the game starts. The hash depends only on the file, so it is
+ * recorded here along with the file's size and modification time;
+ * while both still agree, the next load takes the hash from the
+ * record instead of reading the file.
+ *
+ * Content inside an archive is keyed by the archive. A cue sheet or
+ * m3u playlist is keyed by itself, not by the tracks or discs it
+ * names: replacing a track in place without touching the sheet is
+ * not noticed.
+ *
+ * The file is a header followed by one record per content file, all
+ * integers little endian:
+ *
+ *   "RAHC" u32 version  u32 count
+ *   u16 len, path       u64 file size   i64 mtime
+ *   u8 verified         u8 count        count * (u32 console, 32 byte hash)
+ *
+ * It is read and written through streams/cache_file.h. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <array/rhmap.h>
+#include <file/file_path.h>
+#include <streams/cache_file.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "cheevos_hash_cache.h"
+#include "cheevos_locals.h"
+
+#define RCHEEVOS_HASH_CACHE_MAGIC      "RAHC"
+/* Offset of the record count in the header */
+#define RCHEEVOS_HASH_CACHE_COUNT_OFS  8
+
+typedef struct rcheevos_hash_cache_entry
+{
+   /* Also the map key, which borrows it */
+   char *path;
+   rcheevos_hash_cache_record_t record;
+} rcheevos_hash_cache_entry_t;
+
+static struct
+{
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   rcheevos_hash_cache_entry_t **map;
+   bool dirty;
+   char path[PATH_MAX_LENGTH];
+} rcheevos_hash_cache;
+
+#ifdef HAVE_THREADS
+#define RCHEEVOS_HASH_CACHE_LOCK()   slock_lock(rcheevos_hash_cache.lock)
+#define RCHEEVOS_HASH_CACHE_UNLOCK() slock_unlock(rcheevos_hash_cache.lock)
+#else
+#define RCHEEVOS_HASH_CACHE_LOCK()
+#define RCHEEVOS_HASH_CACHE_UNLOCK()
+#endif
+
+static void rcheevos_hash_cache_entry_free(rcheevos_hash_cache_entry_t *e)
+{
+   if (!e)
+      return;
+   free(e->path);
+   free(e);
+}
+
+static void rcheevos_hash_cache_map_free(rcheevos_hash_cache_entry_t **map)
+{
+   size_t i, cap;
+
+   for (i = 0, cap = RHMAP_CAP(map); i != cap; i++)
+      if (RHMAP_KEY(map, i))
+         rcheevos_hash_cache_entry_free(map[i]);
+   RHMAP_FREE(map);
+}
+
+/* Takes @e into @map, replacing any entry for the same path. Frees
+ * @e if it cannot be added. */
+static rcheevos_hash_cache_entry_t **rcheevos_hash_cache_map_put(
+      rcheevos_hash_cache_entry_t **map, rcheevos_hash_cache_entry_t *e)
+{
+   ptrdiff_t idx;
+
+   if (!map)
+   {
+      RHMAP_FIT(map, 16);
+      if (!map)
+      {
+         rcheevos_hash_cache_entry_free(e);
+         return NULL;
+      }
+      RHMAP_BORROW_KEYS(map);
+   }
+
+   /* The old entry owns the key the map holds: swap the value in place
+    * rather than delete and re-insert */
+   if ((idx = RHMAP_IDX_STR(map, e->path)) >= 0)
+   {
+      rcheevos_hash_cache_entry_t *old = map[idx];
+      RHMAP_KEY_STR(map, idx)          = e->path;
+      map[idx]                         = e;
+      rcheevos_hash_cache_entry_free(old);
+      return map;
+   }
+
+   if (!RHMAP_TRYFIT(map, RHMAP_LEN(map) + 1))
+   {
+      rcheevos_hash_cache_entry_free(e);
+      return map;
+   }
+
+   RHMAP_SET_STR(map, e->path, e);
+   return map;
+}
+
+/* Parses one record. Returns NULL if the record is cut short or makes
+ * no sense. */
+static rcheevos_hash_cache_entry_t *rcheevos_hash_cache_get_entry(
+      cache_file_reader_t *r)
+{
+   unsigned i;
+   rcheevos_hash_cache_entry_t *e;
+
+   if (!(e = (rcheevos_hash_cache_entry_t*)calloc(1, sizeof(*e))))
+      return NULL;
+   if (!(e->path = cache_file_get_strdup(r)) || !*e->path)
+   {
+      rcheevos_hash_cache_entry_free(e);
+      return NULL;
+   }
+
+   e->record.file_size = cache_file_get64(r);
+   e->record.mtime     = (int64_t)cache_file_get64(r);
+   e->record.verified  = (cache_file_get8(r) != 0);
+   e->record.count     = cache_file_get8(r);
+
+   if (     r->error
+         || !e->record.count
+         ||  e->record.count > RCHEEVOS_HASH_CACHE_MAX_HASHES)
+   {
+      rcheevos_hash_cache_entry_free(e);
+      return NULL;
+   }
+
+   for (i = 0; i < e->record.count; i++)
+   {
+      const uint8_t *hash;
+      e->record.console_ids[i] = cache_file_get32(r);
+      if (!(hash = cache_file_get(r, 32)))
+      {
+         rcheevos_hash_cache_entry_free(e);
+         return NULL;
+      }
+      memcpy(e->record.hashes[i], hash, 32);
+      e->record.hashes[i][32]  = '\0';
+   }
+
+   return e;
+}
+
+static rcheevos_hash_cache_entry_t **rcheevos_hash_cache_load(
+      const char *path)
+{
+   uint32_t i, count;
+   cache_file_reader_t r;
+   const uint8_t *magic;
+   void *data                        = NULL;
+   int64_t len                       = 0;
+   rcheevos_hash_cache_entry_t **map = NULL;
+
+   if (!path_is_valid(path))
+      return NULL;
+
+   if (!filestream_read_file(path, &data, &len) || !data)
+      return NULL;
+
+   cache_file_reader_init(&r, data, (size_t)len);
+   magic = cache_file_get(&r, 4);
+
+   if (     !magic
+         || memcmp(magic, RCHEEVOS_HASH_CACHE_MAGIC, 4)
+         || cache_file_get32(&r) != RCHEEVOS_HASH_CACHE_VERSION)
+   {
+      CHEEVOS_LOG(RCHEEVOS_TAG "Ignoring hash cache of another version: \"%s\"\n",
+            path);
+      free(data);
+      return NULL;
+   }
+
+   count = cache_file_get32(&r);
+
+   for (i = 0; i < count; i++)
+   {
+      rcheevos_hash_cache_entry_t *e = rcheevos_hash_cache_get_entry(&r);
+      if (!e)
+         break;
+      map = rcheevos_hash_cache_map_put(map, e);
+   }
+
+   if (i < count)
+      CHEEVOS_ERR(RCHEEVOS_TAG "Hash cache is truncated, kept %u of %u entries\n",
+            (unsigned)i, (unsigned)count);
+
+   free(data);
+   return map;
+}
+
+/* Returns false if @e cannot be represented, and then adds nothing */
+static bool rcheevos_hash_cache_put_entry(cache_file_writer_t *w,
+      const rcheevos_hash_cache_entry_t *e)
+{
+   unsigned i;
+   size_t mark = w->len;
+
+   if (!*e->path || !cache_file_put_str(w, e->path))
+   {
+      w->len = mark;
+      return false;
+   }
+
+   cache_file_put64(w, e->record.file_size);
+   cache_file_put64(w, (uint64_t)e->record.mtime);
+   cache_file_put8(w, e->record.verified ? 1 : 0);
+   cache_file_put8(w, e->record.count);
+
+   for (i = 0; i < e->record.count; i++)
+   {
+      cache_file_put32(w, e->record.console_ids[i]);
+      cache_file_put(w, e->record.hashes[i], 32);
+   }
+   return true;
+}
+
+bool rcheevos_hash_cache_open(const char *path)
+{
+   if (!path || !*path)
+      return false;
+
+#ifdef HAVE_THREADS
+   if (!rcheevos_hash_cache.lock && !(rcheevos_hash_cache.lock = slock_new()))
+      return false;
+#endif
+
+   RCHEEVOS_HASH_CACHE_LOCK();
+   if (!string_is_equal(rcheevos_hash_cache.path, path))
+   {
+      rcheevos_hash_cache_map_free(rcheevos_hash_cache.map);
+      strlcpy(rcheevos_hash_cache.path, path,
+            sizeof(rcheevos_hash_cache.path));
+      rcheevos_hash_cache.map   = rcheevos_hash_cache_load(path);
+      rcheevos_hash_cache.dirty = false;
+
+      if (rcheevos_hash_cache.map)
+         CHEEVOS_LOG(RCHEEVOS_TAG "Hash cache holds %u entries\n",
+               (unsigned)RHMAP_LEN(rcheevos_hash_cache.map));
+   }
+   RCHEEVOS_HASH_CACHE_UNLOCK();
+
+   return true;
+}
+
+void rcheevos_hash_cache_stat(const char *name,
+      rcheevos_hash_cache_record_t *rec)
+{
+   char path[PATH_MAX_LENGTH];
+   const char *delim = path_get_archive_delim(name);
+   int64_t size, mtime;
+
+   rec->file_size    = 0;
+   rec->mtime        = 0;
+
+   /* An archive member changes only with its archive */
+   if (delim)
+   {
+      size_t _len = (size_t)(delim - name);
+      if (_len >= sizeof(path))
+         return;
+      memcpy(path, name, _len);
+      path[_len] = '\0';
+      name       = path;
+   }
+
+   if (path_get_size_mtime(name, &size, &mtime))
+   {
+      rec->file_size = (uint64_t)size;
+      rec->mtime     = mtime;
+   }
+}
+
+bool rcheevos_hash_cache_lookup(const char *name,
+      rcheevos_hash_cache_record_t *rec)
+{
+   ptrdiff_t idx;
+   bool found = false;
+
+   if (!name || !rec->mtime)
+      return false;
+
+   RCHEEVOS_HASH_CACHE_LOCK();
+   if ((idx = RHMAP_IDX_STR(rcheevos_hash_cache.map, name)) >= 0)
+   {
+      const rcheevos_hash_cache_record_t *e =
+         &rcheevos_hash_cache.map[idx]->record;
+      if (     e->mtime     == rec->mtime
+            && e->file_size == rec->file_size)
+      {
+         memcpy(rec, e, sizeof(*rec));
+         found = true;
+      }
+   }
+   RCHEEVOS_HASH_CACHE_UNLOCK();
+
+   return found;
+}
+
+void rcheevos_hash_cache_store(const char *name,
+      const rcheevos_hash_cache_record_t *rec)
+{
+   rcheevos_hash_cache_entry_t *e;
+
+   if (     !name
+         || !*name
+         || !rec->mtime
+         || !rec->count
+         ||  rec->count > RCHEEVOS_HASH_CACHE_MAX_HASHES)
+      return;
+
+   if (!(e = (rcheevos_hash_cache_entry_t*)calloc(1, sizeof(*e))))
+      return;
+   if (!(e->path = strdup(name)))
+   {
+      free(e);
+      return;
+   }
+   memcpy(&e->record, rec, sizeof(*rec));
+
+   RCHEEVOS_HASH_CACHE_LOCK();
+   if (*rcheevos_hash_cache.path)
+   {
+      rcheevos_hash_cache.map   = rcheevos_hash_cache_map_put(
+            rcheevos_hash_cache.map, e);
+      rcheevos_hash_cache.dirty = true;
+   }
+   else
+      rcheevos_hash_cache_entry_free(e);
+   RCHEEVOS_HASH_CACHE_UNLOCK();
+}
+
+bool rcheevos_hash_cache_write(void)
+{
+   size_t i, cap;
+   cache_file_writer_t w;
+   uint32_t count = 0;
+   bool ok        = true;
+
+   RCHEEVOS_HASH_CACHE_LOCK();
+
+   if (rcheevos_hash_cache.dirty && *rcheevos_hash_cache.path)
+   {
+      memset(&w, 0, sizeof(w));
+      cache_file_put(&w, RCHEEVOS_HASH_CACHE_MAGIC, 4);
+      cache_file_put32(&w, RCHEEVOS_HASH_CACHE_VERSION);
+      cache_file_put32(&w, 0); /* count, patched below */
+
+      for (i = 0, cap = RHMAP_CAP(rcheevos_hash_cache.map); i != cap; i++)
+         if (     RHMAP_KEY(rcheevos_hash_cache.map, i)
+               && rcheevos_hash_cache_put_entry(&w, rcheevos_hash_cache.map[i]))
+            count++;
+
+      cache_file_patch32(&w, RCHEEVOS_HASH_CACHE_COUNT_OFS, count);
+
+      if ((ok = cache_file_write(&w, rcheevos_hash_cache.path)))
+         rcheevos_hash_cache.dirty = false;
+      else
+         CHEEVOS_ERR(RCHEEVOS_TAG "Failed to write hash cache: \"%s\"\n",
+               rcheevos_hash_cache.path);
+
+      cache_file_writer_free(&w);
+   }
+
+   RCHEEVOS_HASH_CACHE_UNLOCK();
+   return ok;
+}
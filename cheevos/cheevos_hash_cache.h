@@ -0,0 +1,93 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2019-2023 - Brian Weiss
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_CHEEVOS_HASH_CACHE_H
+#define __RARCH_CHEEVOS_HASH_CACHE_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Bumped whenever the record layout changes, or an update of
+ * deps/rcheevos changes the hash it produces for some console; a cache
+ * of another version is ignored */
+#define RCHEEVOS_HASH_CACHE_VERSION 1
+
+/* Candidate consoles kept per file; rc_hash knows at most 12 for an
+ * extension, and none of the common ones come close to this */
+#define RCHEEVOS_HASH_CACHE_MAX_HASHES 8
+
+typedef struct rcheevos_hash_cache_record
+{
+   uint64_t file_size;
+   int64_t mtime;        /* 0 if the platform cannot say: never cached */
+   uint32_t console_ids[RCHEEVOS_HASH_CACHE_MAX_HASHES];
+   char hashes[RCHEEVOS_HASH_CACHE_MAX_HASHES][33];
+   unsigned count;
+   bool verified;        /* hashes[0] identified a game on the server */
+} rcheevos_hash_cache_record_t;
+
+/**
+ * rcheevos_hash_cache_open:
+ * @path                 : cache file; need not exist yet
+ *
+ * Loads the cache, unless @path is the one already loaded. Must be
+ * called on the main thread, before anything else here is used; the
+ * other functions may then run on any thread.
+ *
+ * Returns: false if @path is empty or the cache could not be set up.
+ **/
+bool rcheevos_hash_cache_open(const char *path);
+
+/**
+ * rcheevos_hash_cache_stat:
+ * @name                 : content path, possibly an archive member
+ *
+ * Fills in the key of @rec: the size and modification time of @name,
+ * or of the archive holding it.
+ **/
+void rcheevos_hash_cache_stat(const char *name,
+      rcheevos_hash_cache_record_t *rec);
+
+/**
+ * rcheevos_hash_cache_lookup:
+ * @rec                  : keyed by rcheevos_hash_cache_stat()
+ *
+ * Returns: true, with the hashes of @rec filled in, if they were
+ * recorded for @name at this size and modification time.
+ **/
+bool rcheevos_hash_cache_lookup(const char *name,
+      rcheevos_hash_cache_record_t *rec);
+
+/* Records @rec for @name, replacing what was there */
+void rcheevos_hash_cache_store(const char *name,
+      const rcheevos_hash_cache_record_t *rec);
+
+/**
+ * rcheevos_hash_cache_write:
+ *
+ * Writes the cache back to its file if anything was stored since it
+ * was loaded or last written.
+ *
+ * Returns: false if the write failed.
+ **/
+bool rcheevos_hash_cache_write(void);
+
+RETRO_END_DECLS
+
+#endif /* __RARCH_CHEEVOS_HASH_CACHE_H */
@@ -0,0 +1,253 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2019-2023 - Brian Weiss
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cheevos_snapshot.h"
+
+#define RCHEEVOS_SNAPSHOT_PAGE_MASK (RCHEEVOS_SNAPSHOT_PAGE_SIZE - 1)
+
+struct rcheevos_snapshot
+{
+   int32_t* slots;        /* page -> slot in the buffers, -1 if not captured */
+   uint32_t* pages;       /* slot -> page */
+   uint8_t* data[2];      /* page contents, one buffer per side */
+   uint16_t* avail[2];    /* bytes of each page the core exposed */
+   uint32_t total_size;
+   uint32_t page_total;   /* pages covering total_size */
+   uint32_t count;        /* slots in use */
+   uint32_t capacity;     /* slots allocated */
+   uint32_t captured;     /* slots of the back buffer filled since the last swap */
+   uint32_t misses[RCHEEVOS_SNAPSHOT_MAX_MISSES];
+   unsigned miss_count;
+   unsigned front;
+};
+
+rcheevos_snapshot_t* rcheevos_snapshot_new(uint32_t total_size)
+{
+   uint32_t i;
+   rcheevos_snapshot_t* snapshot;
+
+   if (!total_size)
+      return NULL;
+   if (!(snapshot = (rcheevos_snapshot_t*)calloc(1, sizeof(*snapshot))))
+      return NULL;
+
+   snapshot->total_size = total_size;
+   snapshot->page_total = (uint32_t)(((uint64_t)total_size
+         + RCHEEVOS_SNAPSHOT_PAGE_MASK) >> RCHEEVOS_SNAPSHOT_PAGE_SHIFT);
+
+   if (!(snapshot->slots = (int32_t*)malloc(
+               snapshot->page_total * sizeof(int32_t))))
+   {
+      free(snapshot);
+      return NULL;
+   }
+   for (i = 0; i < snapshot->page_total; i++)
+      snapshot->slots[i] = -1;
+
+   return snapshot;
+}
+
+void rcheevos_snapshot_free(rcheevos_snapshot_t* snapshot)
+{
+   if (!snapshot)
+      return;
+   free(snapshot->slots);
+   free(snapshot->pages);
+   free(snapshot->data[0]);
+   free(snapshot->data[1]);
+   free(snapshot->avail[0]);
+   free(snapshot->avail[1]);
+   free(snapshot);
+}
+
+static bool rcheevos_snapshot_grow(rcheevos_snapshot_t* snapshot)
+{
+   unsigned i;
+   uint32_t capacity = snapshot->capacity ? snapshot->capacity * 2 : 64;
+   uint32_t* pages   = (uint32_t*)realloc(snapshot->pages,
+         capacity * sizeof(uint32_t));
+
+   if (!pages)
+      return false;
+   snapshot->pages = pages;
+
+   /* Existing slots keep their contents, so a grow between two
+    * captures of the same frame does not lose what was copied. */
+   for (i = 0; i < 2; i++)
+   {
+      uint8_t* data   = (uint8_t*)realloc(snapshot->data[i],
+            (size_t)capacity * RCHEEVOS_SNAPSHOT_PAGE_SIZE);
+      uint16_t* avail;
+      if (!data)
+         return false;
+      snapshot->data[i] = data;
+      if (!(avail = (uint16_t*)realloc(snapshot->avail[i],
+                  capacity * sizeof(uint16_t))))
+         return false;
+      snapshot->avail[i] = avail;
+   }
+
+   snapshot->capacity = capacity;
+   return true;
+}
+
+static bool rcheevos_snapshot_add_page(rcheevos_snapshot_t* snapshot,
+      uint32_t page)
+{
+   if (page >= snapshot->page_total || snapshot->slots[page] >= 0)
+      return true;
+   if (snapshot->count == snapshot->capacity
+         && !rcheevos_snapshot_grow(snapshot))
+      return false;
+
+   /* Until it is captured the page reads as empty from the front
+    * buffer, so it fails over to a live read rather than returning
+    * stale bytes. */
+   snapshot->avail[0][snapshot->count] = 0;
+   snapshot->avail[1][snapshot->count] = 0;
+   snapshot->pages[snapshot->count]    = page;
+   snapshot->slots[page]               = (int32_t)snapshot->count++;
+   return true;
+}
+
+bool rcheevos_snapshot_add(rcheevos_snapshot_t* snapshot,
+      uint32_t address, uint32_t num_bytes)
+{
+   uint32_t page, last;
+
+   if (!num_bytes)
+      return true;
+   page = address >> RCHEEVOS_SNAPSHOT_PAGE_SHIFT;
+   last = (uint32_t)(((uint64_t)address + num_bytes - 1)
+         >> RCHEEVOS_SNAPSHOT_PAGE_SHIFT);
+
+   for (; page <= last; page++)
+      if (!rcheevos_snapshot_add_page(snapshot, page))
+         return false;
+   return true;
+}
+
+unsigned rcheevos_snapshot_commit_misses(rcheevos_snapshot_t* snapshot)
+{
+   unsigned i;
+   unsigned added = 0;
+   uint32_t count = snapshot->count;
+
+   for (i = 0; i < snapshot->miss_count; i++)
+      if (!rcheevos_snapshot_add_page(snapshot, snapshot->misses[i]))
+         break;
+   added                = snapshot->count - count;
+   snapshot->miss_count = 0;
+   return added;
+}
+
+size_t rcheevos_snapshot_capture(rcheevos_snapshot_t* snapshot,
+      rcheevos_snapshot_peek_t peek, void* userdata)
+{
+   size_t copied   = 0;
+   unsigned back   = snapshot->front ^ 1;
+   uint8_t* data   = snapshot->data[back];
+   uint16_t* avail = snapshot->avail[back];
+   uint32_t slot   = snapshot->captured;
+
+   for (; slot < snapshot->count; slot++)
+   {
+      uint32_t address = snapshot->pages[slot] << RCHEEVOS_SNAPSHOT_PAGE_SHIFT;
+      uint32_t len     = peek(address,
+            data + (size_t)slot * RCHEEVOS_SNAPSHOT_PAGE_SIZE,
+            RCHEEVOS_SNAPSHOT_PAGE_SIZE, userdata);
+      avail[slot]      = (uint16_t)len;
+      copied          += len;
+   }
+
+   snapshot->captured = slot;
+   return copied;
+}
+
+void rcheevos_snapshot_swap(rcheevos_snapshot_t* snapshot)
+{
+   snapshot->front   ^= 1;
+   snapshot->captured = 0;
+}
+
+bool rcheevos_snapshot_read(rcheevos_snapshot_t* snapshot, uint32_t address,
+      uint8_t* buffer, uint32_t num_bytes, uint32_t* read)
+{
+   const uint8_t* data   = snapshot->data[snapshot->front];
+   const uint16_t* avail = snapshot->avail[snapshot->front];
+   uint32_t done         = 0;
+
+   while (done < num_bytes)
+   {
+      uint32_t page   = address >> RCHEEVOS_SNAPSHOT_PAGE_SHIFT;
+      uint32_t offset = address & RCHEEVOS_SNAPSHOT_PAGE_MASK;
+      uint32_t expect, chunk;
+      int32_t slot;
+
+      /* Past the end of the address space: a live read stops here too */
+      if (page >= snapshot->page_total)
+         break;
+
+      if ((slot = snapshot->slots[page]) < 0)
+      {
+         unsigned i;
+         for (i = 0; i < snapshot->miss_count; i++)
+            if (snapshot->misses[i] == page)
+               break;
+         if (i == snapshot->miss_count
+               && snapshot->miss_count < RCHEEVOS_SNAPSHOT_MAX_MISSES)
+            snapshot->misses[snapshot->miss_count++] = page;
+         return false;
+      }
+
+      chunk = RCHEEVOS_SNAPSHOT_PAGE_SIZE - offset;
+      if (chunk > num_bytes - done)
+         chunk = num_bytes - done;
+
+      if (offset + chunk > avail[slot])
+      {
+         /* The page was short when captured. If that is just the end
+          * of the address space the live read would be short as well;
+          * otherwise the core has a hole here and only a live read
+          * knows where the memory resumes. */
+         expect = snapshot->total_size - (page << RCHEEVOS_SNAPSHOT_PAGE_SHIFT);
+         if (expect > RCHEEVOS_SNAPSHOT_PAGE_SIZE || avail[slot] < expect)
+            return false;
+         if (offset >= avail[slot])
+            break;
+         chunk = avail[slot] - offset;
+         memcpy(buffer + done, data
+               + ((size_t)slot << RCHEEVOS_SNAPSHOT_PAGE_SHIFT) + offset, chunk);
+         done += chunk;
+         break;
+      }
+
+      memcpy(buffer + done, data
+            + ((size_t)slot << RCHEEVOS_SNAPSHOT_PAGE_SHIFT) + offset, chunk);
+      done    += chunk;
+      address += chunk;
+   }
+
+   *read = done;
+   return true;
+}
+
+uint32_t rcheevos_snapshot_page_count(const rcheevos_snapshot_t* snapshot)
+{
+   return snapshot ? snapshot->count : 0;
+}
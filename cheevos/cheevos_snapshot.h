@@ -0,0 +1,115 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2019-2023 - Brian Weiss
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_CHEEVOS_SNAPSHOT_H
+#define __RARCH_CHEEVOS_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Per-frame copy of the memory an achievement set reads.
+ *
+ * The achievement address space is split into pages, and only the
+ * pages that have been read at least once are copied. There are two
+ * copies: the front one is read by whoever evaluates the achievements,
+ * the back one is refilled from core memory at the end of each frame
+ * and then swapped to the front. This lets the evaluation of frame N
+ * run on another thread while the core is already emulating frame N+1.
+ *
+ * A read that lands on a page the snapshot does not hold fails and is
+ * remembered; rcheevos_snapshot_commit_misses() adds those pages so
+ * that they are captured from the next frame on. Everything except
+ * rcheevos_snapshot_read() must be called while no read is running. */
+
+#define RCHEEVOS_SNAPSHOT_PAGE_SHIFT 8
+#define RCHEEVOS_SNAPSHOT_PAGE_SIZE  (1 << RCHEEVOS_SNAPSHOT_PAGE_SHIFT)
+#define RCHEEVOS_SNAPSHOT_MAX_MISSES 64
+
+typedef struct rcheevos_snapshot rcheevos_snapshot_t;
+
+/* Reads core memory, same contract as the rc_client read callback. */
+typedef uint32_t (*rcheevos_snapshot_peek_t)(uint32_t address,
+      uint8_t* buffer, uint32_t num_bytes, void* userdata);
+
+rcheevos_snapshot_t* rcheevos_snapshot_new(uint32_t total_size);
+void rcheevos_snapshot_free(rcheevos_snapshot_t* snapshot);
+
+/**
+ * rcheevos_snapshot_add:
+ *
+ * Makes sure the pages covering @address..@address+@num_bytes are
+ * captured from the next rcheevos_snapshot_capture() on.
+ *
+ * Returns: false if the page table could not grow.
+ **/
+bool rcheevos_snapshot_add(rcheevos_snapshot_t* snapshot,
+      uint32_t address, uint32_t num_bytes);
+
+/**
+ * rcheevos_snapshot_commit_misses:
+ *
+ * Adds the pages that rcheevos_snapshot_read() could not serve since
+ * the last call.
+ *
+ * Returns: the number of pages added.
+ **/
+unsigned rcheevos_snapshot_commit_misses(rcheevos_snapshot_t* snapshot);
+
+/**
+ * rcheevos_snapshot_capture:
+ *
+ * Copies every page added since the last rcheevos_snapshot_swap() and
+ * not yet captured into the back buffer. Calling it twice between
+ * swaps only copies what was added in between.
+ *
+ * Returns: the number of bytes copied.
+ **/
+size_t rcheevos_snapshot_capture(rcheevos_snapshot_t* snapshot,
+      rcheevos_snapshot_peek_t peek, void* userdata);
+
+/**
+ * rcheevos_snapshot_swap:
+ *
+ * Makes the captured back buffer the one rcheevos_snapshot_read()
+ * serves from.
+ **/
+void rcheevos_snapshot_swap(rcheevos_snapshot_t* snapshot);
+
+/**
+ * rcheevos_snapshot_read:
+ *
+ * Reads from the front buffer. Safe to call from one thread while the
+ * core runs, as long as none of the other functions are called.
+ *
+ * Returns: false if part of the range is not held by the snapshot; the
+ * page is remembered and the caller has to read core memory once the
+ * core is not running.
+ * Otherwise true, with @read set to the number of bytes a live read
+ * would have returned.
+ **/
+bool rcheevos_snapshot_read(rcheevos_snapshot_t* snapshot, uint32_t address,
+      uint8_t* buffer, uint32_t num_bytes, uint32_t* read);
+
+/* Number of pages captured per frame. */
+uint32_t rcheevos_snapshot_page_count(const rcheevos_snapshot_t* snapshot);
+
+RETRO_END_DECLS
+
+#endif /* __RARCH_CHEEVOS_SNAPSHOT_H */
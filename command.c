@@ -62,6 +62,7 @@
 #include "dynamic.h"
 #include "list_special.h"
 #include "paths.h"
+#include "performance_trace.h"
 #include "retroarch.h"
 #include "runloop.h"
 #include "verbosity.h"
@@ -960,6 +961,43 @@ bool command_seek_replay(command_t *cmd, const char *arg)
 #endif
 }
 
+bool command_seek_rewind(command_t *cmd, const char *arg)
+{
+#ifdef HAVE_REWIND
+   char reply[32];
+   size_t _len;
+   char *endptr                = NULL;
+   unsigned entries            = 0;
+   runloop_state_t *runloop_st = runloop_state_get_ptr();
+   settings_t *settings        = config_get_ptr();
+   unsigned granularity        = settings->uints.rewind_granularity;
+   long frames                 = strtol(arg, &endptr, 10);
+
+   if (!granularity)
+      granularity = 1;
+   /* Each rewind buffer entry is one capture, taken every
+    * 'granularity' frames */
+   if (endptr != arg && frames > 0)
+      entries = state_manager_seek(&runloop_st->rewind_st,
+            (unsigned)((frames + granularity - 1) / granularity));
+   if (entries)
+   {
+      _len  = strlcpy(reply, "OK ", sizeof(reply));
+      _len += snprintf(reply + _len, sizeof(reply) - _len,
+            "%u", entries * granularity);
+   }
+   else
+      _len  = strlcpy(reply, "NO", sizeof(reply));
+   reply[_len]   = '\n';
+   reply[++_len] = '\0';
+   cmd->replier(cmd, reply, _len);
+   return entries != 0;
+#else
+   cmd->replier(cmd, "NO\n", 4);
+   return false;
+#endif
+}
+
 bool command_save_savefiles(command_t *cmd, const char* arg)
 {
    char reply[4];
@@ -1244,6 +1282,32 @@ bool command_drivers_reinit(command_t *cmd, const char* arg)
    return true;
 }
 
+/* TRACE_START / TRACE_STOP / TRACE_DUMP <path>
+ *
+ * Frame tracing without restarting with --trace. The dump can be taken
+ * while tracing is still running and holds whatever the per-thread
+ * rings currently cover, i.e. the last few seconds. */
+bool command_trace_start(command_t *cmd, const char* arg)
+{
+   bool ret = perf_trace_start();
+   cmd->replier(cmd, ret ? "OK\n" : "NO\n", 3);
+   return ret;
+}
+
+bool command_trace_stop(command_t *cmd, const char* arg)
+{
+   perf_trace_stop();
+   cmd->replier(cmd, "OK\n", 3);
+   return true;
+}
+
+bool command_trace_dump(command_t *cmd, const char* arg)
+{
+   bool ret = arg && *arg && perf_trace_write(arg);
+   cmd->replier(cmd, ret ? "OK\n" : "NO\n", 3);
+   return ret;
+}
+
 static const rarch_memory_descriptor_t* command_memory_get_descriptor(const rarch_memory_map_t* mmap, unsigned address, size_t* offset)
 {
    const rarch_memory_descriptor_t* desc = mmap->descriptors;
@@ -441,8 +441,12 @@ bool command_load_state_slot(command_t *cmd, const char* arg);
 bool command_save_state_slot(command_t* cmd, const char* arg);
 bool command_play_replay_slot(command_t *cmd, const char* arg);
 bool command_seek_replay(command_t *cmd, const char *arg);
+bool command_seek_rewind(command_t *cmd, const char *arg);
 bool command_save_savefiles(command_t *cmd, const char* arg);
 bool command_load_savefiles(command_t *cmd, const char* arg);
+bool command_trace_start(command_t *cmd, const char* arg);
+bool command_trace_stop(command_t *cmd, const char* arg);
+bool command_trace_dump(command_t *cmd, const char* arg);
 #ifdef HAVE_CHEEVOS
 bool command_read_ram(command_t *cmd, const char *arg);
 bool command_write_ram(command_t *cmd, const char *arg);
@@ -479,6 +483,7 @@ static const struct cmd_action_map action_map[] = {
    { "SAVE_STATE_SLOT",command_save_state_slot, "<slot number>"},
    { "PLAY_REPLAY_SLOT",command_play_replay_slot, "<slot number>"},
    { "SEEK_REPLAY",command_seek_replay, "<frame number>"},
+   { "SEEK_REWIND",command_seek_rewind, "<frames back>"},
 
    { "SAVE_FILES", command_save_savefiles, "No argument"},
    { "LOAD_FILES", command_load_savefiles, "No argument"},
@@ -491,6 +496,10 @@ static const struct cmd_action_map action_map[] = {
    { "VIDEO_REINIT", command_video_reinit, "No argument"},
    { "AUDIO_REINIT", command_audio_reinit, "No argument"},
    { "DRIVERS_REINIT", command_drivers_reinit, "No argument"},
+
+   { "TRACE_START", command_trace_start, "No argument"},
+   { "TRACE_STOP", command_trace_stop, "No argument"},
+   { "TRACE_DUMP", command_trace_dump, "<path>"},
 };
 
 static const struct cmd_map map[] = {
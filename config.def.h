@@ -497,6 +497,12 @@
 #define DEFAULT_VIDEO_THREADED false
 #endif
 
+/* Threaded video hands frames over through a three-slot mailbox
+ * instead of a single buffer, so the core never waits on, or drops a
+ * frame because of, a present that is still in flight. Costs two
+ * extra frame buffers. */
+#define DEFAULT_VIDEO_THREADED_MAILBOX false
+
 #if defined(HAVE_THREADS)
 #if defined(GEKKO) || defined(PSP) || defined(PS2)
 /* For single-core consoles right now it's best to have this be disabled. */
@@ -508,6 +514,10 @@
 #define DEFAULT_THREADED_DATA_RUNLOOP_ENABLE false
 #endif
 
+/* Worker threads for threaded tasks. One runs them in turn,
+ * as before the pool existed. */
+#define DEFAULT_THREADED_DATA_RUNLOOP_WORKERS 1
+
 /* Set to true if HW render cores should get their private context. */
 #define DEFAULT_VIDEO_SHARED_CONTEXT false
 
@@ -1397,6 +1407,9 @@
 #define DEFAULT_REWIND_BUFFER_SIZE (1 << 20)
 #define DEFAULT_REWIND_BUFFER_SIZE_STEP 1
 #define DEFAULT_REWIND_GRANULARITY 6
+/* Single core: a capture thread has nothing to overlap with */
+#define DEFAULT_REWIND_THREADED false
+#define DEFAULT_REWIND_COMPRESSION false
 #else
 /* The buffer size for the rewind buffer. This needs to be about
  * 15-20MB per minute. Very game dependant. */
@@ -1407,8 +1420,20 @@
 
 /* How many frames to rewind at a time. */
 #define DEFAULT_REWIND_GRANULARITY 1
+
+/* Compress captured rewind states on a worker thread
+ * while the next frame runs. */
+#define DEFAULT_REWIND_THREADED true
+
+/* Pass each rewind buffer entry through Zstandard as well.
+ * Roughly doubles the history a given buffer size holds. */
+#define DEFAULT_REWIND_COMPRESSION true
 #endif
 
+/* Store every this many rewind states whole, so that seeking
+ * back a long way decodes from the nearest one. 0 disables. */
+#define DEFAULT_REWIND_KEYFRAME_INTERVAL 0
+
 /* Pause gameplay when window loses focus. */
 #define DEFAULT_PAUSE_NONACTIVE true
 
@@ -1560,6 +1585,11 @@
 /* Enable runloop for variable refresh rate screens. Force x1 speed while handling fast forward too. */
 #define DEFAULT_VRR_RUNLOOP_ENABLE false
 
+/* Frame limiter sleeps until a little before each deadline and polls
+ * the clock for the remainder, so an OS sleep that wakes late does not
+ * delay the frame. */
+#define DEFAULT_FRAME_LIMIT_PRECISE false
+
 /* Run core logic one or more frames ahead then load the state back to reduce perceived input lag. */
 #define DEFAULT_RUN_AHEAD_FRAMES 1
 
@@ -1569,6 +1599,10 @@
 /* Hide warning messages when using the Run Ahead feature. */
 #define DEFAULT_RUN_AHEAD_HIDE_WARNINGS false
 
+/* Pick the Run Ahead mode and frame count from measured costs,
+ * up to the configured frame count. */
+#define DEFAULT_RUN_AHEAD_AUTO false
+
 /* Enable stdin/network command interface. */
 #define DEFAULT_NETWORK_CMD_ENABLE false
 #define DEFAULT_NETWORK_CMD_PORT 55355
@@ -212,6 +212,7 @@ typedef struct settings
       unsigned frontend_log_level;
       unsigned libretro_log_level;
       unsigned rewind_granularity;
+      unsigned rewind_keyframe_interval;
       unsigned rewind_buffer_size_step;
       unsigned autosave_interval;
       unsigned savestate_automatic_interval;
@@ -349,6 +350,7 @@ typedef struct settings
       unsigned window_auto_height_max;
 
       unsigned video_record_threads;
+      unsigned threaded_data_runloop_workers;
 
       unsigned libnx_overclock;
       unsigned ai_service_mode;
@@ -563,6 +565,7 @@ typedef struct settings
       bool video_shader_preset_save_reference_enable;
       bool video_scan_subframes;
       bool video_threaded;
+      bool video_threaded_mailbox;
       bool video_font_enable;
       bool video_disable_composition;
       bool video_post_filter_record;
@@ -881,6 +884,8 @@ typedef struct settings
       bool cheevos_verbose_enable;
       bool cheevos_auto_screenshot;
       bool cheevos_start_active;
+      bool cheevos_background_eval;
+      bool cheevos_hash_cache;
       bool cheevos_unlock_sound_enable;
       bool cheevos_challenge_indicators;
       bool cheevos_appearance_padding_auto;
@@ -938,14 +943,18 @@ typedef struct settings
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_threaded;
+      bool rewind_compression;
       bool fastforward_frameskip;
       bool vrr_runloop_enable;
+      bool frame_limit_precise;
       bool menu_throttle_framerate;
       bool apply_cheats_after_toggle;
       bool apply_cheats_after_load;
       bool run_ahead_enabled;
       bool run_ahead_secondary_instance;
       bool run_ahead_hide_warnings;
+      bool run_ahead_auto;
       bool preemptive_frames_enable;
       bool pause_nonactive;
       bool pause_on_disconnect;
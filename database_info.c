@@ -19,7 +19,6 @@
 #include <stdint.h>
 
 #include <compat/strl.h>
-#include <retro_endianness.h>
 #include <file/file_path.h>
 #include <lists/string_list.h>
 #include <lists/dir_list.h>
@@ -231,6 +230,28 @@ char *bin_to_hex_alloc(const uint8_t *data, size_t len)
 #define DB_EXTRACT_SCAN_FIELDS \
    (DB_EXTRACT_NAME | DB_EXTRACT_CRC | DB_EXTRACT_SERIAL | DB_EXTRACT_SIZE)
 
+/* The crc is stored big endian, in as few bytes as it needs.  Built up
+ * a byte at a time: the buffer may point into the mapped database at
+ * any offset, where a wider load would be unaligned. */
+static uint32_t database_info_get_crc(const struct rmsgpack_dom_value *val)
+{
+   const uint8_t *p = (const uint8_t*)val->val.binary.buff;
+
+   switch (val->val.binary.len)
+   {
+      case 1:
+         return p[0];
+      case 2:
+         return ((uint32_t)p[0] << 8)  |  (uint32_t)p[1];
+      case 4:
+         return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+              | ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+      default:
+         break;
+   }
+   return 0;
+}
+
 static int database_cursor_iterate(libretrodb_cursor_t *cur,
       database_info_t *db_info)
 {
@@ -312,25 +333,7 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
             if (memcmp(str, "crc", 3) == 0)
             {
                if (val->type == RDT_BINARY)
-               {
-                  switch (val->val.binary.len)
-                  {
-                     case 1:
-                        db_info->crc32 = *(uint8_t*)val->val.binary.buff;
-                        break;
-                     case 2:
-                        db_info->crc32 = swap_if_little16(
-                              *(uint16_t*)val->val.binary.buff);
-                        break;
-                     case 4:
-                        db_info->crc32 = swap_if_little32(
-                              *(uint32_t*)val->val.binary.buff);
-                        break;
-                     default:
-                        db_info->crc32 = 0;
-                        break;
-                  }
-               }
+                  db_info->crc32 = database_info_get_crc(val);
             }
             else if (memcmp(str, "md5", 3) == 0)
             {
@@ -582,13 +585,36 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
  *
  * @fields: Bitmask of DB_EXTRACT_* flags. 0 = extract all.
  */
+/* Copy of a string or binary value, or NULL when it is empty.  Goes
+ * by len rather than the terminator: records read as views into the
+ * mapped database have none.  Stops at an embedded NUL, as the
+ * strdup() this replaced did. */
+static char *database_info_dup_value(const struct rmsgpack_dom_value *val)
+{
+   char *s;
+   const char *nul;
+   const char *buff = val->val.string.buff;
+   size_t _len      = val->val.string.len;
+
+   if (!buff || !_len)
+      return NULL;
+   if ((nul = (const char*)memchr(buff, '\0', _len)))
+      _len = (size_t)(nul - buff);
+   if (!_len || !(s = (char*)malloc(_len + 1)))
+      return NULL;
+   memcpy(s, buff, _len);
+   s[_len] = '\0';
+   return s;
+}
+
 /* Extract @fields from an already-read record.  Split out of
  * database_cursor_iterate_filtered() below so the crc-index path,
  * which reads records by offset rather than through a cursor, fills
  * database_info_t through exactly the same code.
  *
  * Returns 0 when the record was a map and was extracted, 1 otherwise.
- * Does not free @item; the caller owns it. */
+ * Does not free @item; the caller owns it.  @item may be a view into
+ * the mapped database, so nothing here relies on a terminator. */
 static int database_info_fill_from_dom(struct rmsgpack_dom_value *item,
       database_info_t *db_info, unsigned fields)
 {
@@ -621,15 +647,7 @@ static int database_info_fill_from_dom(struct rmsgpack_dom_value *item,
             if ((fields & DB_EXTRACT_CRC) && memcmp(str, "crc", 3) == 0)
             {
                if (val->type == RDT_BINARY)
-               {
-                  switch (val->val.binary.len)
-                  {
-                     case 1:  db_info->crc32 = *(uint8_t*)val->val.binary.buff; break;
-                     case 2:  db_info->crc32 = swap_if_little16(*(uint16_t*)val->val.binary.buff); break;
-                     case 4:  db_info->crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff); break;
-                     default: db_info->crc32 = 0; break;
-                  }
-               }
+                  db_info->crc32 = database_info_get_crc(val);
             }
             else if ((fields & DB_EXTRACT_MD5) && memcmp(str, "md5", 3) == 0)
             {
@@ -648,11 +666,7 @@ static int database_info_fill_from_dom(struct rmsgpack_dom_value *item,
                 * data straight into the playlist label.  Matches the
                 * md5/sha1 handling above. */
                if (val->type == RDT_STRING)
-               {
-                  const char *vs = val->val.string.buff;
-                  if (vs && *vs)
-                     db_info->name = strdup(vs);
-               }
+                  db_info->name = database_info_dup_value(val);
             }
             else if ((fields & DB_EXTRACT_SIZE) && memcmp(str, "size", 4) == 0)
             {
@@ -676,11 +690,7 @@ static int database_info_fill_from_dom(struct rmsgpack_dom_value *item,
                 * note on val_string in database_info_fill_from_dom's
                 * sibling above. */
                if (val->type == RDT_STRING || val->type == RDT_BINARY)
-               {
-                  const char *vs = val->val.string.buff;
-                  if (vs && *vs)
-                     db_info->serial = strdup(vs);
-               }
+                  db_info->serial = database_info_dup_value(val);
             }
             break;
 
@@ -702,11 +712,13 @@ static int database_cursor_iterate_filtered(libretrodb_cursor_t *cur,
    if (fields == 0)
       return database_cursor_iterate(cur, db_info);
 
-   if (libretrodb_cursor_read_item(cur, &item) != 0)
+   /* Only a handful of fields are copied out, so read the record in
+    * place rather than duplicating every string in it first. */
+   if (libretrodb_cursor_read_item_view(cur, &item) != 0)
       return -1;
 
    rv = database_info_fill_from_dom(&item, db_info, fields);
-   rmsgpack_dom_value_free(&item);
+   libretrodb_cursor_item_free(cur, &item);
    return rv;
 }
 
@@ -92,6 +92,9 @@ RETRO_BEGIN_DECLS
 #endif
 #define FILE_PATH_CORE_INFO_CACHE "core_info.cache"
 #define FILE_PATH_CORE_INFO_CACHE_REFRESH "core_info.refresh"
+#define FILE_PATH_CONTENT_SCAN_CACHE "content_scan.cache"
+#define FILE_PATH_CHEEVOS_HASH_CACHE "cheevos_hash.cache"
+#define FILE_PATH_EXPLORE_CACHE "explore.cache"
 
 #ifdef HAVE_LAKKA
  #ifdef HAVE_LAKKA_SERVER
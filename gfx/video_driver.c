@@ -24,6 +24,7 @@
 #include <retro_math.h>
 #include <retro_timers.h>
 #include <time/rtime.h>
+#include <queues/task_queue.h>
 
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
@@ -71,6 +72,7 @@
 #include "../verbosity.h"
 #include "../command.h"
 #include "../configuration.h"
+#include "../performance_trace.h"
 #include "video_shader_parse.h"
 
 #define TIME_TO_FPS(last_time, new_time, frames) ((1000000.0f * (frames)) / ((new_time) - (last_time)))
@@ -4590,6 +4592,7 @@ bool video_driver_init_internal(bool *video_is_threaded, bool verbosity_enabled)
 
 #ifdef HAVE_THREADS
    video.is_threaded                 = VIDEO_DRIVER_IS_THREADED_INTERNAL(video_st);
+   video.thread_mailbox              = settings->bools.video_threaded_mailbox;
    *video_is_threaded                = video.is_threaded;
 
    if (video.is_threaded)
@@ -4794,7 +4797,7 @@ VIDEO_NOINLINE static const void *video_driver_convert_xrgb2101010(
    return video_st->pix10_convert_buf;
 }
 
-void video_driver_frame(const void *data, unsigned width,
+static void video_driver_frame_internal(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
    char status_text[256];
@@ -5444,6 +5447,9 @@ void video_driver_frame(const void *data, unsigned width,
       video_info.osd_stat_params.color_hp    = NULL;
 
       {
+#ifdef HAVE_RUNAHEAD
+         runahead_auto_stats_t auto_stats;
+#endif
          size_t __len = snprintf(video_info.stat_text, sizeof(video_info.stat_text),
                "CORE AV_INFO\n"
                " Size:       %ux%u\n"
@@ -5540,6 +5546,33 @@ void video_driver_frame(const void *data, unsigned width,
                   (1000.0f / video_info.refresh_rate) - video_st->frame_delay_effective - (runloop_st->core_run_time / 1000.0f),
                   video_st->frame_time_reserve / 1000.0f);
 
+#ifdef HAVE_RUNAHEAD
+         if (runahead_auto_get_stats(&auto_stats))
+         {
+            static const char *auto_modes[] = {
+               "Off", "SinInst", "SecInst", "Preempt" };
+            __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
+                  " Run-Ahead: %u %s Auto\n"
+                  " -Run:      %5.2f ms\n"
+                  " -Save:     %5.2f ms\n"
+                  " -Load:     %5.2f ms\n"
+                  " -Cost:     %5.2f / %5.2f ms\n"
+                  " -Headroom: %5.2f ms\n"
+                  " -Peak:     %5.2f ms\n"
+                  " -Back-offs:%5u\n",
+                  auto_stats.frames,
+                  auto_modes[auto_stats.mode],
+                  auto_stats.run_usec  / 1000.0f,
+                  auto_stats.save_usec / 1000.0f,
+                  auto_stats.load_usec / 1000.0f,
+                  auto_stats.cost_usec / 1000.0f,
+                  auto_stats.budget_usec / 1000.0f,
+                  (auto_stats.budget_usec - auto_stats.cost_usec) / 1000.0f,
+                  auto_stats.peak_usec / 1000.0f,
+                  auto_stats.back_offs);
+         }
+         else
+#endif
          if (video_info.runahead && !video_info.runahead_second_instance)
             __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
                   " Run-Ahead: %u SinInst\n",
@@ -5553,6 +5586,105 @@ void video_driver_frame(const void *data, unsigned width,
                   " Run-Ahead: %u Preempt\n",
                   video_info.runahead_frames);
 
+         if (runloop_st->frame_limit_count)
+         {
+            const uint32_t *hist = runloop_st->frame_limit_hist;
+            float pct            = 100.0f / runloop_st->frame_limit_count;
+            __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
+                  " Limiter:    %s\n"
+                  " -Spin:      %5.2f ms\n"
+                  " -Late <50us:%5.1f %%\n"
+                  " -<250us:    %5.1f %%\n"
+                  " -<1ms:      %5.1f %%\n"
+                  " -Over:      %5.1f %%\n"
+                  " -Max:       %5.2f ms\n",
+                  settings->bools.frame_limit_precise ? "Precise" : "Sleep",
+                  settings->bools.frame_limit_precise
+                  ? runloop_st->frame_limit_spin_usec / 1000.0f : 0.0f,
+                  (hist[0] + hist[1]) * pct,
+                  (hist[2] + hist[3]) * pct,
+                  (hist[4] + hist[5]) * pct,
+                  hist[6] * pct,
+                  runloop_st->frame_limit_late_max / 1000.0f);
+         }
+
+#ifdef HAVE_THREADS
+         {
+            video_thread_stats_t thr_stats;
+            if (video_thread_get_stats(&thr_stats))
+               __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
+                     " Threaded:   %s\n"
+                     " -Pushed:  %8u\n"
+                     " -%s %6u\n"
+                     " -ZeroCopy:%8u\n"
+                     " -Avg:       %5.2f ms\n"
+                     " -Max:       %5.2f ms\n",
+                     thr_stats.mailbox ? "Mailbox" : "Single",
+                     thr_stats.hit_count,
+                     thr_stats.mailbox ? "Replaced:" : "Dropped: ",
+                     thr_stats.mailbox
+                     ? thr_stats.replaced_count : thr_stats.miss_count,
+                     thr_stats.zero_copy_count,
+                     thr_stats.presented_count
+                     ? (float)thr_stats.latency_total
+                       / thr_stats.presented_count / 1000.0f
+                     : 0.0f,
+                     thr_stats.latency_max / 1000.0f);
+         }
+
+         {
+            task_queue_stats_t task_stats;
+            task_queue_get_stats(&task_stats);
+            if (task_stats.workers)
+               __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
+                     " Tasks:      %u worker%s\n"
+                     " -Latency: %3u queued, %5.1f/%5.1f ms\n"
+                     " -Bulk:    %3u queued, %5.1f/%5.1f ms\n",
+                     task_stats.workers, (task_stats.workers == 1) ? "" : "s",
+                     task_stats.depth[TASK_PRIORITY_LATENCY],
+                     task_stats.started[TASK_PRIORITY_LATENCY]
+                     ? (float)task_stats.wait_total[TASK_PRIORITY_LATENCY]
+                       / task_stats.started[TASK_PRIORITY_LATENCY] / 1000.0f
+                     : 0.0f,
+                     task_stats.wait_max[TASK_PRIORITY_LATENCY] / 1000.0f,
+                     task_stats.depth[TASK_PRIORITY_BULK],
+                     task_stats.started[TASK_PRIORITY_BULK]
+                     ? (float)task_stats.wait_total[TASK_PRIORITY_BULK]
+                       / task_stats.started[TASK_PRIORITY_BULK] / 1000.0f
+                     : 0.0f,
+                     task_stats.wait_max[TASK_PRIORITY_BULK] / 1000.0f);
+         }
+#endif
+
+#ifdef HAVE_REWIND
+         {
+            state_manager_stats_t rewind_stats;
+            if (     state_manager_get_stats(&runloop_st->rewind_st,
+                        &rewind_stats)
+                  && rewind_stats.used
+                  && av_info->timing.fps > 0.0)
+            {
+               unsigned granularity = settings->uints.rewind_granularity;
+               float seconds        = (float)(rewind_stats.entries
+                     * (granularity ? granularity : 1)
+                     / av_info->timing.fps);
+               float mb             = rewind_stats.used / 1000000.0f;
+               __len += snprintf(video_info.stat_text + __len, sizeof(video_info.stat_text) - __len,
+                     "REWIND%s\n"
+                     " History:  %7.1f s\n"
+                     " -Buffer:  %5.1f/%.0f MB\n"
+                     " -Per MB:  %7.1f s\n"
+                     " -Keyframes:%6u\n",
+                     rewind_stats.compressed ? " (ZSTD)" : "",
+                     seconds,
+                     mb,
+                     rewind_stats.capacity / 1000000.0f,
+                     seconds / mb,
+                     rewind_stats.keyframes);
+            }
+         }
+#endif
+
          /* Tracked length of stat_text; consumed by driver frame()
           * callbacks instead of strlen on every frame. */
          video_info.stat_text_len = __len;
@@ -5689,6 +5821,14 @@ void video_driver_frame(const void *data, unsigned width,
             video_info.refresh_rate, video_info.frame_time_target, runloop_st->core_run_time);
 }
 
+void video_driver_frame(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   PERF_TRACE_BEGIN("video_driver_frame");
+   video_driver_frame_internal(data, width, height, pitch);
+   PERF_TRACE_END("video_driver_frame");
+}
+
 static void video_driver_reinit_context(settings_t *settings, int flags)
 {
    /* RARCH_DRIVER_CTL_UNINIT clears the callback struct so we
@@ -334,6 +334,10 @@ typedef struct video_info
 
    bool is_threaded;
 
+   /* Threaded video only: hand frames to the worker through a
+    * three-slot mailbox instead of dropping them while it is busy. */
+   bool thread_mailbox;
+
    /* Use 32bit RGBA rather than native RGB565/XBGR1555.
     *
     * XRGB1555 format is 16-bit and has byte ordering: 0RRRRRGGGGGBBBBB,
@@ -448,7 +452,7 @@ typedef struct video_frame_info
 
    uint16_t frame_time_target;
 
-   char stat_text[1024];
+   char stat_text[2048];
    size_t stat_text_len;
 
    bool widgets_active;
@@ -63,6 +63,11 @@
 #define VIDEO_THREAD_CMD_WAIT_LEAVE(thr) do { } while (0)
 #endif
 
+/* Or'ed into thread_video_t::frame.latest while the slot it names has
+ * been published but not yet taken by the worker. */
+#define VIDEO_THREAD_SLOT_FRESH 0x100
+#define VIDEO_THREAD_SLOT_MASK  0xff
+
 static void *video_thread_init_never_call(const video_info_t *video,
       input_driver_t **input, void **input_data)
 {
@@ -524,6 +529,28 @@ static bool video_thread_handle_packet(
    return false;
 }
 
+/* Picks the slot the worker should present next. In mailbox mode this
+ * swaps the worker's previous slot back into the mailbox in exchange
+ * for the newest published one; returns NULL if nothing new arrived
+ * since the last swap (the user thread raced us to frame.updated). */
+static thread_video_slot_t *video_thread_acquire_slot(thread_video_t *thr)
+{
+#ifdef RETRO_ATOMIC_HAS_CAS
+   if (thr->frame.mailbox)
+   {
+      int latest;
+      if (!(retro_atomic_load_acquire_int(&thr->frame.latest)
+               & VIDEO_THREAD_SLOT_FRESH))
+         return NULL;
+      latest           = retro_atomic_exchange_int(&thr->frame.latest,
+            thr->frame.front);
+      thr->frame.front = latest & VIDEO_THREAD_SLOT_MASK;
+      return &thr->frame.slots[thr->frame.front];
+   }
+#endif
+   return &thr->frame.slots[0];
+}
+
 static void video_thread_loop(void *data)
 {
    thread_packet_t pkt;
@@ -552,80 +579,107 @@ static void video_thread_loop(void *data)
       if (updated)
       {
          struct video_viewport vp;
-         bool               alive = false;
-         bool               focus = false;
-         bool        has_windowed = false;
-
-         vp.x                     = 0;
-         vp.y                     = 0;
-         vp.width                 = 0;
-         vp.height                = 0;
-         vp.full_width            = 0;
-         vp.full_height           = 0;
-
-         slock_lock(thr->frame.lock);
-
-         thread_update_driver_state(thr);
-
-         if (thr->driver_data && thr->driver)
+         bool               alive    = false;
+         bool               focus    = false;
+         bool        has_windowed    = false;
+         retro_time_t       latency  = -1;
+         thread_video_slot_t *slot   = video_thread_acquire_slot(thr);
+
+         vp.x                        = 0;
+         vp.y                        = 0;
+         vp.width                    = 0;
+         vp.height                   = 0;
+         vp.full_width               = 0;
+         vp.full_height              = 0;
+
+         if (slot)
          {
-            if (thr->driver->frame)
-            {
-               video_frame_info_t video_info;
-               bool               ret;
-
-               /* Built by video_driver_frame() on the main thread and
-                * carried across with the frame data.  Do not call
-                * video_driver_build_info() here: it reads video_driver_st
-                * and runloop_state while the main thread writes them. */
-               video_info = thr->frame.video_info;
-
-               /* video_driver_build_info() resolves userdata from
-                * video_driver_st, and video_thread_free() clears
-                * VIDEO_FLAG_THREAD_WRAPPER_ACTIVE before this thread
-                * stops, so a frame built inside that window would carry
-                * the thread_video_t wrapper instead of the real driver
-                * data.  This thread knows its own. */
-               video_info.userdata = thr->driver_data;
-
-               ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count, thr->frame.pitch,
-                  *thr->frame.msg ? thr->frame.msg : NULL,
-                  &video_info);
+            slock_lock(thr->frame.lock);
 
-               slock_unlock(thr->frame.lock);
+            thread_update_driver_state(thr);
 
-               if (ret)
+            if (thr->driver_data && thr->driver)
+            {
+               if (thr->driver->frame)
                {
-                  if (thr->driver->alive)
-                     alive = thr->driver->alive(thr->driver_data);
-                  if (thr->driver->focus)
-                     focus = thr->driver->focus(thr->driver_data);
-                  if (thr->driver->has_windowed)
-                     has_windowed = thr->driver->has_windowed(thr->driver_data);
+                  video_frame_info_t video_info;
+                  bool               ret;
+
+                  /* Built by video_driver_frame() on the main thread and
+                   * carried across with the frame data.  Do not call
+                   * video_driver_build_info() here: it reads
+                   * video_driver_st and runloop_state while the main
+                   * thread writes them. */
+                  video_info = slot->video_info;
+
+                  /* video_driver_build_info() resolves userdata from
+                   * video_driver_st, and video_thread_free() clears
+                   * VIDEO_FLAG_THREAD_WRAPPER_ACTIVE before this thread
+                   * stops, so a frame built inside that window would
+                   * carry the thread_video_t wrapper instead of the real
+                   * driver data.  This thread knows its own. */
+                  video_info.userdata = thr->driver_data;
+
+                  latency = cpu_features_get_time_usec() - slot->published;
+
+                  ret = thr->driver->frame(thr->driver_data,
+                     slot->buffer, slot->width, slot->height,
+                     slot->count, slot->pitch,
+                     *slot->msg ? slot->msg : NULL,
+                     &video_info);
+
+                  slock_unlock(thr->frame.lock);
+
+                  if (ret)
+                  {
+                     if (thr->driver->alive)
+                        alive = thr->driver->alive(thr->driver_data);
+                     if (thr->driver->focus)
+                        focus = thr->driver->focus(thr->driver_data);
+                     if (thr->driver->has_windowed)
+                        has_windowed = thr->driver->has_windowed(
+                              thr->driver_data);
+                  }
                }
+               else
+                  slock_unlock(thr->frame.lock);
+
+               if (thr->driver->viewport_info)
+                  thr->driver->viewport_info(thr->driver_data, &vp);
             }
             else
                slock_unlock(thr->frame.lock);
-
-            if (thr->driver->viewport_info)
-               thr->driver->viewport_info(thr->driver_data, &vp);
          }
-         else
-            slock_unlock(thr->frame.lock);
 
          slock_lock(thr->lock);
-         thr->alive         = alive;
-         thr->focus         = focus;
-         thr->has_windowed  = has_windowed;
-         thr->vp            = vp;
-         /* Statistics. The viewport maths ran on this thread during
-          * thr->driver->frame() above, so publish the result rather
-          * than letting the main thread read video_driver_st. */
-         thr->scale_width   = video_state_get_ptr()->scale_width;
-         thr->scale_height  = video_state_get_ptr()->scale_height;
-         thr->frame.updated = false;
+         if (slot)
+         {
+            thr->alive         = alive;
+            thr->focus         = focus;
+            thr->has_windowed  = has_windowed;
+            thr->vp            = vp;
+            /* Statistics. The viewport maths ran on this thread during
+             * thr->driver->frame() above, so publish the result rather
+             * than letting the main thread read video_driver_st. */
+            thr->scale_width   = video_state_get_ptr()->scale_width;
+            thr->scale_height  = video_state_get_ptr()->scale_height;
+         }
+         if (latency >= 0)
+         {
+            thr->stats.presented_count++;
+            thr->stats.latency_total += (uint64_t)latency;
+            if (latency > thr->stats.latency_max)
+               thr->stats.latency_max = latency;
+         }
+#ifdef RETRO_ATOMIC_HAS_CAS
+         /* A frame published while this one was being presented is
+          * still waiting; stay busy and go round again. */
+         if (thr->frame.mailbox)
+            thr->frame.updated = (retro_atomic_load_acquire_int(
+                     &thr->frame.latest) & VIDEO_THREAD_SLOT_FRESH) != 0;
+         else
+#endif
+            thr->frame.updated = false;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -705,10 +759,83 @@ static bool video_thread_has_windowed(void *data)
    return ret;
 }
 
+/* Copies a core frame into a slot. Touches nothing but the slot, so
+ * mailbox mode runs it without holding any lock. */
+static void video_thread_fill_slot(thread_video_t *thr,
+      thread_video_slot_t *slot, const void *frame_,
+      unsigned width, unsigned height, uint64_t frame_count,
+      unsigned pitch, const char *msg, const video_frame_info_t *video_info)
+{
+   const uint8_t *src   = (const uint8_t*)frame_;
+   uint8_t       *dst   = slot->buffer;
+   unsigned copy_stride = width *
+      (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+   /* A core that rendered straight into the slot handed out by
+    * thread_get_current_software_framebuffer() needs no copy at all,
+    * and its rows are laid out at the pitch it was lent, which may be
+    * wider than the frame it submits. */
+   bool zero_copy       = src && src == dst;
+   unsigned stride      = zero_copy ? pitch : copy_stride;
+   /* The buffer holds the maximum geometry the core declared at init.
+    * A core is free to hand over a bigger frame than that, so publish
+    * only the rows that fit: the worker renders slot->height out of
+    * this same buffer, so an unclamped height would be read past the
+    * end of the allocation whether or not anything was copied into
+    * it. A stride too wide for a single row yields zero. */
+   unsigned rows        = stride
+      ? (unsigned)(thr->frame.buffer_size / stride)
+      : 0;
+
+   if (height > rows)
+      height            = rows;
+
+   if (src && !zero_copy)
+   {
+      unsigned i;
+      for (i = 0; i < height; i++, src += pitch, dst += copy_stride)
+         memcpy(dst, src, copy_stride);
+   }
+
+   slot->width          = width;
+   slot->height         = height;
+   slot->count          = frame_count;
+   slot->pitch          = stride;
+
+   /* Hand the caller's video_frame_info_t across with the frame data.
+    * It was built by video_driver_frame() on this thread; rebuilding
+    * it on the worker races the main thread's writes to
+    * video_driver_st and runloop_state. */
+   if (video_info)
+      slot->video_info  = *video_info;
+
+   if (msg)
+      strlcpy(slot->msg, msg, sizeof(slot->msg));
+   else
+      *slot->msg        = '\0';
+
+   slot->published      = cpu_features_get_time_usec();
+}
+
+/* Whether the frame pacing wait in video_thread_frame() should keep
+ * waiting. The classic path can only publish once the worker has
+ * finished the last frame. Mailbox mode can always publish, and only
+ * holds back while the previous frame has not even been picked up, so
+ * that the core is not paced faster than the display. */
+static bool video_thread_frame_pending(thread_video_t *thr)
+{
+#ifdef RETRO_ATOMIC_HAS_CAS
+   if (thr->frame.mailbox)
+      return (retro_atomic_load_acquire_int(&thr->frame.latest)
+            & VIDEO_THREAD_SLOT_FRESH) != 0;
+#endif
+   return thr->frame.updated;
+}
+
 static bool video_thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
+   bool published      = false;
    thread_video_t *thr = (thread_video_t*)data;
 
    if (!thr)
@@ -737,7 +864,7 @@ static bool video_thread_frame(void *data, const void *frame_,
 
       /* Ideally, use absolute time, but that is only a good idea on POSIX. */
       VIDEO_THREAD_CMD_WAIT_ENTER(thr);
-      while (thr->frame.updated)
+      while (video_thread_frame_pending(thr))
       {
          retro_time_t current = cpu_features_get_time_usec();
          retro_time_t delta   = target - current;
@@ -751,52 +878,62 @@ static bool video_thread_frame(void *data, const void *frame_,
       VIDEO_THREAD_CMD_WAIT_LEAVE(thr);
    }
 
+#ifdef RETRO_ATOMIC_HAS_CAS
+   if (thr->frame.mailbox)
+   {
+      int prev;
+      bool zero_copy  = frame_
+         && frame_ == thr->frame.slots[thr->frame.back].buffer;
+
+      /* The back slot belongs to this thread alone, so the copy runs
+       * with no lock held and regardless of what the worker is doing. */
+      slock_unlock(thr->lock);
+
+      /* A dupe has no data of its own, and the back slot still holds
+       * whatever was published before last: repeat the last published
+       * frame instead. The worker may be presenting that slot, but it
+       * only ever reads it. */
+      if (!frame_)
+      {
+         const thread_video_slot_t *last =
+            &thr->frame.slots[thr->frame.last];
+         frame_ = last->buffer;
+         width  = last->width;
+         height = last->height;
+         pitch  = last->pitch;
+      }
+
+      video_thread_fill_slot(thr, &thr->frame.slots[thr->frame.back],
+            frame_, width, height, frame_count, pitch, msg, video_info);
+
+      thr->frame.last = thr->frame.back;
+      prev            = retro_atomic_exchange_int(&thr->frame.latest,
+            thr->frame.back | VIDEO_THREAD_SLOT_FRESH);
+      thr->frame.back = prev & VIDEO_THREAD_SLOT_MASK;
+
+      slock_lock(thr->lock);
+      /* The worker never got to the previous frame; it now presents
+       * this one in its place, so latency stays bounded to one frame. */
+      if (prev & VIDEO_THREAD_SLOT_FRESH)
+         thr->stats.replaced_count++;
+      if (zero_copy)
+         thr->stats.zero_copy_count++;
+      published = true;
+   }
+   else
+#endif
    /* Drop frame if updated flag is still set, as thread is
     * still working on last frame. */
    if (!thr->frame.updated)
    {
-      const uint8_t *src   = (const uint8_t*)frame_;
-      uint8_t       *dst   = thr->frame.buffer;
-      unsigned copy_stride = width *
-         (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
-      /* The buffer holds the maximum geometry the core declared at init.
-       * A core is free to hand over a bigger frame than that, so publish
-       * only the rows that fit: the worker renders thr->frame.height out
-       * of this same buffer, so an unclamped height would be read past
-       * the end of the allocation whether or not anything was copied
-       * into it. A stride too wide for a single row yields zero. */
-      unsigned rows        = copy_stride
-         ? (unsigned)(thr->frame.buffer_size / copy_stride)
-         : 0;
-
-      if (height > rows)
-         height            = rows;
-
-      if (src)
-      {
-         int i; /* TODO/FIXME - increment counter never meaningfully used */
-         for (i = 0; i < (int)height; i++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
+      video_thread_fill_slot(thr, &thr->frame.slots[0],
+            frame_, width, height, frame_count, pitch, msg, video_info);
+      published = true;
+   }
 
+   if (published)
+   {
       thr->frame.updated = true;
-      thr->frame.width   = width;
-      thr->frame.height  = height;
-      thr->frame.count   = frame_count;
-      thr->frame.pitch   = copy_stride;
-
-      /* Hand the caller's video_frame_info_t across with the frame data.
-       * It was built by video_driver_frame() on this thread; rebuilding
-       * it on the worker races the main thread's writes to
-       * video_driver_st and runloop_state. */
-      if (video_info)
-         thr->frame.video_info = *video_info;
-
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
-
       scond_signal(thr->cond_thread);
 
 #ifdef HAVE_MENU
@@ -818,10 +955,10 @@ static bool video_thread_frame(void *data, const void *frame_,
          VIDEO_THREAD_CMD_WAIT_LEAVE(thr);
       }
 #endif
-      thr->hit_count++;
+      thr->stats.hit_count++;
    }
    else
-      thr->miss_count++;
+      thr->stats.miss_count++;
 
    slock_unlock(thr->lock);
 
@@ -858,22 +995,37 @@ static bool video_thread_init(thread_video_t *thr,
       return false;
 
    {
+      unsigned i, slots;
       size_t max_size        = info.input_scale * RARCH_SCALE_BASE;
       max_size              *= max_size;
       max_size              *= info.rgb32 ?
          sizeof(uint32_t) : sizeof(uint16_t);
 
+#ifdef RETRO_ATOMIC_HAS_CAS
+      thr->frame.mailbox     = info.thread_mailbox;
+#endif
+      slots                  = thr->frame.mailbox
+         ? VIDEO_THREAD_FRAME_SLOTS : 1;
+
+      for (i = 0; i < slots; i++)
+      {
 #ifdef _3DS
-      thr->frame.buffer      = linearMemAlign(max_size, 0x80);
+         thr->frame.slots[i].buffer = (uint8_t*)linearMemAlign(max_size, 0x80);
 #else
-      thr->frame.buffer      = (uint8_t*)malloc(max_size);
+         thr->frame.slots[i].buffer = (uint8_t*)malloc(max_size);
 #endif
-      if (!thr->frame.buffer)
-         return false;
+         if (!thr->frame.slots[i].buffer)
+            return false;
 
-      thr->frame.buffer_size = max_size;
+         memset(thr->frame.slots[i].buffer, 0x80, max_size);
+      }
 
-      memset(thr->frame.buffer, 0x80, max_size);
+      thr->frame.buffer_size = max_size;
+      thr->frame.back        = 0;
+      thr->frame.front       = 1;
+      thr->frame.last        = 2;
+      retro_atomic_int_init(&thr->frame.latest, 2);
+      thr->stats.mailbox     = thr->frame.mailbox;
    }
 
    thr->input                = input;
@@ -1006,12 +1158,21 @@ static void video_thread_free(void *data)
             thr->driver->free(thr->driver_data);
       }
 
-      free(thr->texture.frame);
+      {
+         unsigned i;
+         for (i = 0; i < VIDEO_THREAD_FRAME_SLOTS; i++)
+         {
+            if (!thr->frame.slots[i].buffer)
+               continue;
 #ifdef _3DS
-      linearFree(thr->frame.buffer);
+            linearFree(thr->frame.slots[i].buffer);
 #else
-      free(thr->frame.buffer);
+            free(thr->frame.slots[i].buffer);
 #endif
+         }
+      }
+
+      free(thr->texture.frame);
       free(thr->alpha_mod);
 
       slock_free(thr->frame.lock);
@@ -1021,8 +1182,14 @@ static void video_thread_free(void *data)
       scond_free(thr->cond_thread);
 
       RARCH_LOG(
-         "Threaded video stats: Frames pushed: %u, Frames dropped: %u.\n",
-         thr->hit_count, thr->miss_count);
+         "Threaded video stats: Frames pushed: %u, Frames dropped: %u, "
+         "Frames replaced: %u, Average latency: %.2f ms.\n",
+         thr->stats.hit_count, thr->stats.miss_count,
+         thr->stats.replaced_count,
+         thr->stats.presented_count
+         ? (double)thr->stats.latency_total
+           / thr->stats.presented_count / 1000.0
+         : 0.0);
 
       free(thr);
    }
@@ -1483,6 +1650,51 @@ static uintptr_t thread_load_texture_compressed(void *video_data,
    return 0;
 }
 
+/* Mailbox mode lends the core the back slot to render into, so that
+ * video_thread_frame() can publish it without copying. The back slot
+ * only changes hands inside video_thread_frame(), which runs on this
+ * same thread after retro_run() has finished drawing, so the worker
+ * never sees it while the core is still writing. The single-buffer
+ * path has no slot the worker is guaranteed not to be reading. */
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+   enum retro_pixel_format fmt;
+   size_t pitch;
+
+   if (!thr || !thr->frame.mailbox || !framebuffer)
+      return false;
+
+   fmt   = video_state_get_ptr()->pix_fmt;
+
+   /* The slot is handed to the driver as-is, so it can only be lent
+    * out in a format the wrapper passes through untouched. */
+   if (thr->info.rgb32)
+   {
+      if (fmt != RETRO_PIXEL_FORMAT_XRGB8888)
+         return false;
+      pitch = framebuffer->width * sizeof(uint32_t);
+   }
+   else
+   {
+      if (fmt != RETRO_PIXEL_FORMAT_RGB565)
+         return false;
+      pitch = framebuffer->width * sizeof(uint16_t);
+   }
+
+   if (     !pitch
+         || framebuffer->height > thr->frame.buffer_size / pitch)
+      return false;
+
+   framebuffer->data         = thr->frame.slots[thr->frame.back].buffer;
+   framebuffer->pitch        = pitch;
+   framebuffer->format       = fmt;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+
+   return true;
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_get_flags,
    thread_load_texture,
@@ -1503,7 +1715,7 @@ static const video_poke_interface_t thread_poke = {
    thread_show_mouse,
    thread_grab_mouse_toggle,
    thread_get_current_shader,
-   NULL, /* get_current_software_framebuffer */
+   thread_get_current_software_framebuffer,
    NULL, /* get_hw_render_interface */
    thread_set_hdr_menu_nits,
    thread_set_hdr_paper_white_nits,
@@ -1763,3 +1975,23 @@ void video_thread_wait_idle(void)
    VIDEO_THREAD_CMD_WAIT_LEAVE(thr);
    slock_unlock(thr->lock);
 }
+
+bool video_thread_get_stats(video_thread_stats_t *stats)
+{
+   video_driver_state_t *video_st = video_state_get_ptr();
+   thread_video_t       *thr;
+
+   if (!(video_st->flags & VIDEO_FLAG_THREAD_WRAPPER_ACTIVE))
+      return false;
+
+   thr = (thread_video_t*)video_st->data;
+
+   if (!thr)
+      return false;
+
+   slock_lock(thr->lock);
+   *stats = thr->stats;
+   slock_unlock(thr->lock);
+
+   return true;
+}
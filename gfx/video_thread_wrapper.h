@@ -21,6 +21,7 @@
 
 #include <boolean.h>
 #include <retro_common_api.h>
+#include <retro_atomic.h>
 #include <rthreads/rthreads.h>
 #include <retro_miscellaneous.h>
 
@@ -168,6 +169,50 @@ typedef struct thread_packet
    enum thread_cmd type;
 } thread_packet_t;
 
+/* Frame slots handed between the user thread and the worker. The
+ * classic path only ever uses slot 0; mailbox mode rotates all three
+ * (one being written, one published, one being presented). */
+#define VIDEO_THREAD_FRAME_SLOTS 3
+
+typedef struct thread_video_slot
+{
+   uint64_t count;
+   /* Time the user thread published this slot, for the latency
+    * statistics. */
+   retro_time_t published;
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   char msg[NAME_MAX_LENGTH];
+   /* Built by the caller (main thread) in video_thread_frame() and
+    * consumed by video_thread_loop().  video_driver_build_info()
+    * reads video_driver_st and runloop_state, both of which the main
+    * thread mutates, so it must not be called from the worker. */
+   video_frame_info_t video_info;
+} thread_video_slot_t;
+
+typedef struct video_thread_stats
+{
+   /* Summed publish-to-present time of every presented frame, usec. */
+   uint64_t latency_total;
+   retro_time_t latency_max;
+   /* Frames accepted from the core. */
+   unsigned hit_count;
+   /* Frames dropped because the worker had not taken the last one
+    * (classic mode only). */
+   unsigned miss_count;
+   /* Frames superseded in the mailbox by a newer one before the
+    * worker picked them up (mailbox mode only). */
+   unsigned replaced_count;
+   /* Frames the core rendered straight into a mailbox slot lent out
+    * through GET_CURRENT_SOFTWARE_FRAMEBUFFER, so no copy was made. */
+   unsigned zero_copy_count;
+   /* Frames the worker actually handed to the driver. */
+   unsigned presented_count;
+   bool mailbox;
+} video_thread_stats_t;
+
 typedef struct thread_video
 {
    retro_time_t last_time;
@@ -222,8 +267,8 @@ typedef struct thread_video
       bool full_screen;
    } texture;
 
-   unsigned hit_count;
-   unsigned miss_count;
+   /* Guarded by 'lock'. */
+   video_thread_stats_t stats;
    unsigned alpha_mods;
 
    struct video_viewport vp;
@@ -246,24 +291,31 @@ typedef struct thread_video
 
    struct
    {
-      uint64_t count;
       slock_t *lock;
-      uint8_t *buffer;
-      /* Bytes allocated for 'buffer' at thread_init, from the core's
-       * declared maximum geometry. A core that then hands over a larger
-       * frame than it declared would otherwise be copied past the end. */
+      /* Bytes allocated for each slot buffer at thread_init, from the
+       * core's declared maximum geometry. A core that then hands over a
+       * larger frame than it declared would otherwise be copied past
+       * the end. */
       size_t   buffer_size;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      char msg[NAME_MAX_LENGTH];
-      /* Built by the caller (main thread) in video_thread_frame() and
-       * consumed by video_thread_loop().  video_driver_build_info()
-       * reads video_driver_st and runloop_state, both of which the main
-       * thread mutates, so it must not be called from the worker. */
-      video_frame_info_t video_info;
+      thread_video_slot_t slots[VIDEO_THREAD_FRAME_SLOTS];
+      /* Mailbox mode only. 'latest' holds the index of the most
+       * recently published slot, or'ed with VIDEO_THREAD_SLOT_FRESH
+       * until the worker swaps it out. 'back' is owned by the user
+       * thread and 'front' by the worker; neither is ever touched by
+       * the other side, so a slot changes hands only through the
+       * exchange on 'latest'. */
+      retro_atomic_int_t latest;
+      int back;
+      int front;
+      /* Mailbox mode only, user thread only: the slot published last.
+       * Never 'back', and never written by the worker, so its contents
+       * can be copied forward when the core dupes a frame. */
+      int last;
+      /* Set while a published frame is waiting for, or being
+       * presented by, the worker. Guarded by 'lock'. */
       bool updated;
       bool within_thread;
+      bool mailbox;
    } frame;
 
    bool apply_state_changes;
@@ -325,6 +377,10 @@ uintptr_t video_thread_texture_handle(void *data,
  * video or when called from the video thread. */
 void video_thread_wait_idle(void);
 
+/* Copies the frame handoff counters of the active thread wrapper.
+ * Returns false when threaded video is not running. */
+bool video_thread_get_stats(video_thread_stats_t *stats);
+
 RETRO_END_DECLS
 
 #endif
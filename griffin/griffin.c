@@ -223,6 +223,8 @@ ACHIEVEMENTS
 #include "../cheevos/cheevos.c"
 #include "../cheevos/cheevos_client.c"
 #include "../cheevos/cheevos_menu.c"
+#include "../cheevos/cheevos_snapshot.c"
+#include "../cheevos/cheevos_hash_cache.c"
 
 #if defined(HAVE_CHEEVOS_RVZ)
 #if defined(HAVE_ZSTD) || defined(HAVE_RZSTD)
@@ -1184,6 +1186,7 @@ FILE
 #include "../libretro-common/file/retro_dirent.c"
 #include "../libretro-common/file/file_watch.c"
 #include "../libretro-common/streams/file_stream.c"
+#include "../libretro-common/streams/cache_file.c"
 #include "../libretro-common/streams/file_stream_transforms.c"
 #include "../libretro-common/streams/interface_stream.c"
 #include "../libretro-common/streams/memory_stream.c"
@@ -1308,6 +1311,7 @@ RETROARCH
 ============================================================ */
 #include "../retroarch.c"
 #include "../runloop.c"
+#include "../performance_trace.c"
 #ifdef HAVE_RUNAHEAD
 #include "../runahead.c"
 #endif
@@ -1428,6 +1432,8 @@ DATA RUNLOOP
 #include "../tasks/task_database.c"
 #ifdef HAVE_LIBRETRODB
 #include "../tasks/task_database_cue.c"
+#include "../tasks/task_database_hash.c"
+#include "../tasks/task_database_scan_cache.c"
 #endif
 #if defined(HAVE_NETWORKING) && defined(HAVE_MENU)
 #include "../tasks/task_core_updater.c"
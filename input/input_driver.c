@@ -69,6 +69,7 @@
 #include "../list_special.h"
 #include "../paths.h"
 #include "../performance_counters.h"
+#include "../performance_trace.h"
 #include "../retroarch.h"
 #include "../tasks/tasks_internal.h"
 #include "../verbosity.h"
@@ -7127,7 +7128,7 @@ static void input_keys_pressed(
    } /* kb_blocked scope */
 }
 
-void input_driver_poll(void)
+static void input_driver_poll_internal(void)
 {
    size_t i, j;
    rarch_joypad_info_t joypad_info[MAX_USERS];
@@ -7750,6 +7751,13 @@ void input_driver_poll(void)
 #endif
 }
 
+void input_driver_poll(void)
+{
+   PERF_TRACE_BEGIN("input_poll");
+   input_driver_poll_internal();
+   PERF_TRACE_END("input_poll");
+}
+
 int16_t input_driver_state_wrapper(unsigned port, unsigned device,
       unsigned idx, unsigned id)
 {
@@ -22288,6 +22288,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST,
    "Validate core associations and remove invalid and duplicate entries."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM,
+   "Cache Achievement Hashes"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM,
+   "Compute the RetroAchievements hash of every entry in the background, so that starting them later does not have to read the whole file first."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_PLAYLIST_MANAGER_REFRESH_PLAYLIST,
    "Refresh Playlist"
@@ -31372,6 +31380,14 @@ MSG_HASH(
    MSG_PLAYLIST_MANAGER_PLAYLIST_CLEANED,
    "Playlist cleaned: "
    )
+MSG_HASH(
+   MSG_PLAYLIST_MANAGER_CHEEVOS_HASHING,
+   "Caching achievement hashes: "
+   )
+MSG_HASH(
+   MSG_PLAYLIST_MANAGER_CHEEVOS_HASHED,
+   "Achievement hashes cached: "
+   )
 MSG_HASH(
    MSG_PLAYLIST_MANAGER_REFRESH_MISSING_CONFIG,
    "Refresh failed - playlist contains no valid scan record: "
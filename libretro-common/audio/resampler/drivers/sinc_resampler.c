@@ -34,6 +34,7 @@
 
 #include <retro_environment.h>
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <filters.h>
 #include <memalign.h>
 
@@ -43,8 +44,23 @@
 #include <xmmintrin.h>
 #endif
 
-#if defined(__AVX__)
+/* The wide x86 kernels are compiled per-ISA with target attributes and
+ * picked at init from the SIMD mask (cpu_features_get() in practice),
+ * so baseline x86-64 builds still use them on CPUs that have them.
+ * Compilers without target attributes only get the AVX kernel, and
+ * only when the whole file is built for AVX. */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
 #include <immintrin.h>
+#define SINC_TARGET_AVX    __attribute__((target("avx")))
+#define SINC_TARGET_FMA    __attribute__((target("avx2,fma")))
+#define SINC_TARGET_AVX512 __attribute__((target("avx512f")))
+#define SINC_HAVE_AVX 1
+#define SINC_HAVE_FMA 1
+#define SINC_HAVE_AVX512 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define SINC_TARGET_AVX
+#define SINC_HAVE_AVX 1
 #endif
 
 /* Rough SNR values for upsampling:
@@ -66,8 +82,9 @@ enum sinc_window
 
 /* For the little amount of taps we're using,
  * SSE1 is faster than AVX for some reason.
- * AVX code is kept here though as by increasing number
- * of sinc taps, the AVX code is clearly faster than SSE1.
+ * The wide kernels are kept here though as by increasing number
+ * of sinc taps, they are clearly faster than SSE1; init only picks
+ * them for the long filters (see sinc_kernels).
  */
 
 typedef struct rarch_sinc_resampler
@@ -253,7 +270,8 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 }
 #endif
 
-#if defined(__AVX__)
+#ifdef SINC_HAVE_AVX
+SINC_TARGET_AVX
 static void resampler_sinc_process_avx_kaiser(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
@@ -322,6 +340,7 @@ static void resampler_sinc_process_avx_kaiser(void *re_, struct resampler_data *
    data->output_frames = out_frames;
 }
 
+SINC_TARGET_AVX
 static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
@@ -385,6 +404,244 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 }
 #endif
 
+#ifdef SINC_HAVE_FMA
+/* Same as the AVX kernels, with the multiply-adds fused. */
+SINC_TARGET_FMA
+static void resampler_sinc_process_fma_kaiser(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+   unsigned taps2                 = taps * 2;
+
+   while (frames)
+   {
+      SINC_PUSH_INPUT_SAMPLES(resamp, input, taps, phases, frames);
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            /* C89: all declarations at top of block */
+            int i;
+            __m128 res_l, res_r;
+            unsigned phase     = resamp->time >> resamp->subphase_bits;
+            float *phase_table = resamp->phase_table + phase * taps2;
+            float *delta_table = phase_table + taps;
+            __m256 delta       = _mm256_set1_ps((float)
+                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+            __m256 sum_l       = _mm256_setzero_ps();
+            __m256 sum_r       = _mm256_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 8)
+            {
+               __m256 sinc_v = _mm256_fmadd_ps(_mm256_load_ps(delta_table + i),
+                     delta, _mm256_load_ps((const float*)phase_table + i));
+
+               sum_l         = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i),
+                     sinc_v, sum_l);
+               sum_r         = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i),
+                     sinc_v, sum_r);
+            }
+
+            /* Fold the high lane onto the low one, then reduce the
+             * remaining four floats. */
+            res_l = _mm_add_ps(_mm256_castps256_ps128(sum_l),
+                  _mm256_extractf128_ps(sum_l, 1));
+            res_r = _mm_add_ps(_mm256_castps256_ps128(sum_r),
+                  _mm256_extractf128_ps(sum_r, 1));
+            res_l = _mm_hadd_ps(res_l, res_r);
+            res_l = _mm_hadd_ps(res_l, res_l);
+
+            /* res_l = { R, L, R, L } */
+            _mm_storel_pi((__m64*)output, res_l);
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+
+SINC_TARGET_FMA
+static void resampler_sinc_process_fma(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases    = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t ratio     = phases / data->ratio;
+   const float *input = data->data_in;
+   float *output      = data->data_out;
+   size_t frames      = data->input_frames;
+   size_t out_frames  = 0;
+   unsigned taps      = resamp->taps;
+
+   while (frames)
+   {
+      SINC_PUSH_INPUT_SAMPLES(resamp, input, taps, phases, frames);
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            /* C89: all declarations at top of block */
+            int i;
+            __m128 res_l, res_r;
+            unsigned phase     = resamp->time >> resamp->subphase_bits;
+            float *phase_table = resamp->phase_table + phase * taps;
+            __m256 sum_l       = _mm256_setzero_ps();
+            __m256 sum_r       = _mm256_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 8)
+            {
+               __m256 sinc_v = _mm256_load_ps((const float*)phase_table + i);
+
+               sum_l         = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i),
+                     sinc_v, sum_l);
+               sum_r         = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i),
+                     sinc_v, sum_r);
+            }
+
+            res_l = _mm_add_ps(_mm256_castps256_ps128(sum_l),
+                  _mm256_extractf128_ps(sum_l, 1));
+            res_r = _mm_add_ps(_mm256_castps256_ps128(sum_r),
+                  _mm256_extractf128_ps(sum_r, 1));
+            res_l = _mm_hadd_ps(res_l, res_r);
+            res_l = _mm_hadd_ps(res_l, res_l);
+
+            _mm_storel_pi((__m64*)output, res_l);
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+#endif
+
+#ifdef SINC_HAVE_AVX512
+/* Needs taps to be a multiple of 16; the kernel table only offers it
+ * for filters that are. */
+SINC_TARGET_AVX512
+static void resampler_sinc_process_avx512_kaiser(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
+   unsigned taps2                 = taps * 2;
+
+   while (frames)
+   {
+      SINC_PUSH_INPUT_SAMPLES(resamp, input, taps, phases, frames);
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            /* C89: all declarations at top of block */
+            int i;
+            unsigned phase     = resamp->time >> resamp->subphase_bits;
+            float *phase_table = resamp->phase_table + phase * taps2;
+            float *delta_table = phase_table + taps;
+            __m512 delta       = _mm512_set1_ps((float)
+                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
+            __m512 sum_l       = _mm512_setzero_ps();
+            __m512 sum_r       = _mm512_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 16)
+            {
+               __m512 sinc_v = _mm512_fmadd_ps(_mm512_load_ps(delta_table + i),
+                     delta, _mm512_load_ps((const float*)phase_table + i));
+
+               sum_l         = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_l + i),
+                     sinc_v, sum_l);
+               sum_r         = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_r + i),
+                     sinc_v, sum_r);
+            }
+
+            output[0]     = _mm512_reduce_add_ps(sum_l);
+            output[1]     = _mm512_reduce_add_ps(sum_r);
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+
+SINC_TARGET_AVX512
+static void resampler_sinc_process_avx512(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases    = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t ratio     = phases / data->ratio;
+   const float *input = data->data_in;
+   float *output      = data->data_out;
+   size_t frames      = data->input_frames;
+   size_t out_frames  = 0;
+   unsigned taps      = resamp->taps;
+
+   while (frames)
+   {
+      SINC_PUSH_INPUT_SAMPLES(resamp, input, taps, phases, frames);
+
+      {
+         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
+         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
+         while (resamp->time < phases)
+         {
+            /* C89: all declarations at top of block */
+            int i;
+            unsigned phase     = resamp->time >> resamp->subphase_bits;
+            float *phase_table = resamp->phase_table + phase * taps;
+            __m512 sum_l       = _mm512_setzero_ps();
+            __m512 sum_r       = _mm512_setzero_ps();
+
+            for (i = 0; i < (int)taps; i += 16)
+            {
+               __m512 sinc_v = _mm512_load_ps((const float*)phase_table + i);
+
+               sum_l         = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_l + i),
+                     sinc_v, sum_l);
+               sum_r         = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_r + i),
+                     sinc_v, sum_r);
+            }
+
+            output[0]     = _mm512_reduce_add_ps(sum_l);
+            output[1]     = _mm512_reduce_add_ps(sum_r);
+
+            output += 2;
+            out_frames++;
+            resamp->time += ratio;
+         }
+      }
+   }
+
+   data->output_frames = out_frames;
+}
+#endif
+
 #if defined(__SSE__)
 static void resampler_sinc_process_sse_kaiser(void *re_, struct resampler_data *data)
 {
@@ -666,6 +923,60 @@ static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
    data->output_frames = out_frames;
 }
 
+typedef void (*sinc_process_t)(void *re, struct resampler_data *data);
+
+/* Every kernel built into this file, most preferred first. init takes
+ * the first one whose instruction sets are all in the SIMD mask and
+ * that has a variant for the filter's window. */
+struct sinc_kernel
+{
+   const char *ident;
+   sinc_process_t lanczos;
+   sinc_process_t kaiser;
+   resampler_simd_mask_t simd;
+   /* taps must be a multiple of this for the kernel to be usable. */
+   unsigned tap_multiple;
+   /* Only wins over SSE on the long filters; see the note above
+    * rarch_sinc_resampler_t. */
+   bool wide;
+};
+
+static const struct sinc_kernel sinc_kernels[] = {
+#ifdef SINC_HAVE_AVX512
+   { "avx512", resampler_sinc_process_avx512,
+      resampler_sinc_process_avx512_kaiser,
+      RESAMPLER_SIMD_AVX512, 16, true },
+#endif
+#ifdef SINC_HAVE_FMA
+   { "avx2+fma", resampler_sinc_process_fma,
+      resampler_sinc_process_fma_kaiser,
+      RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA3, 8, true },
+#endif
+#ifdef SINC_HAVE_AVX
+   { "avx", resampler_sinc_process_avx,
+      resampler_sinc_process_avx_kaiser,
+      RESAMPLER_SIMD_AVX, 8, true },
+#endif
+#if defined(__SSE__)
+   { "sse", resampler_sinc_process_sse,
+      resampler_sinc_process_sse_kaiser,
+      RESAMPLER_SIMD_SSE, 4, false },
+#endif
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(HAVE_NEON))
+#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
+   { "neon", resampler_sinc_process_neon, NULL,
+      RESAMPLER_SIMD_NEON, 8, false },
+#else
+   { "neon", resampler_sinc_process_neon,
+      resampler_sinc_process_neon_kaiser,
+      RESAMPLER_SIMD_NEON, 8, false },
+#endif
+#endif
+   { "c", resampler_sinc_process_c,
+      resampler_sinc_process_c_kaiser,
+      0, 4, false }
+};
+
 static void resampler_sinc_free(void *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)data;
@@ -814,6 +1125,7 @@ static void *resampler_sinc_new(const struct resampler_config *config,
       double bandwidth_mod, enum resampler_quality quality,
       resampler_simd_mask_t mask)
 {
+   size_t i;
    double cutoff                  = 0.0;
    size_t phase_elems             = 0;
    size_t elems                   = 0;
@@ -925,38 +1237,20 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          goto error;
    }
 
-   re->process = resampler_sinc_process_c;
-   if (window_type == SINC_WINDOW_KAISER)
-      re->process    = resampler_sinc_process_c_kaiser;
-
-   if (mask & RESAMPLER_SIMD_AVX && enable_avx)
+   for (i = 0; i < ARRAY_SIZE(sinc_kernels); i++)
    {
-#if defined(__AVX__)
-      re->process    = resampler_sinc_process_avx;
-      if (window_type == SINC_WINDOW_KAISER)
-         re->process = resampler_sinc_process_avx_kaiser;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_SSE)
-   {
-#if defined(__SSE__)
-      re->process = resampler_sinc_process_sse;
-      if (window_type == SINC_WINDOW_KAISER)
-         re->process = resampler_sinc_process_sse_kaiser;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_NEON)
-   {
-#if (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(HAVE_NEON))
-#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
-      if (window_type != SINC_WINDOW_KAISER)
-         re->process = resampler_sinc_process_neon;
-#else
-      re->process = resampler_sinc_process_neon;
-      if (window_type == SINC_WINDOW_KAISER)
-         re->process = resampler_sinc_process_neon_kaiser;
-#endif
-#endif
+      const struct sinc_kernel *k = &sinc_kernels[i];
+      sinc_process_t process      = (window_type == SINC_WINDOW_KAISER)
+         ? k->kaiser : k->lanczos;
+
+      if (     !process
+            || (mask & k->simd) != k->simd
+            || (re->taps % k->tap_multiple)
+            || (k->wide && !enable_avx))
+         continue;
+
+      re->process = process;
+      break;
    }
 
    return re;
@@ -0,0 +1,179 @@
+/* Throughput / agreement harness for the float sinc resampler kernels.
+ * Runs every kernel built into drivers/sinc_resampler.c that this CPU
+ * supports, at every resampler_quality level, on the same input, and
+ * reports the time per output second plus the largest deviation from
+ * the scalar kernel.  The driver is included directly so that kernels
+ * init would not pick on its own (the wide ones at low tap counts) can
+ * still be timed.
+ *
+ * Build:  cc -O2 -Wall bench_sinc_simd.c \
+ *            ../../../features/features_cpu.c ../../../memmap/memalign.c \
+ *            -I ../../../include -lm -o bench_sinc_simd */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <features/features_cpu.h>
+
+#include "../drivers/sinc_resampler.c"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Seconds of input pushed through each kernel. */
+#define BENCH_SECONDS 4
+/* Frames handed to process() per call, as the audio driver would. */
+#define BENCH_CHUNK   1024
+
+static size_t bench_run(const struct sinc_kernel *k, enum resampler_quality q,
+      double in_rate, double out_rate, const float *in, size_t in_frames,
+      float *out, retro_time_t *elapsed)
+{
+   struct resampler_config conf;
+   struct resampler_data data;
+   rarch_sinc_resampler_t *re;
+   retro_time_t start;
+   size_t pos       = 0;
+   size_t out_total = 0;
+   double ratio     = out_rate / in_rate;
+
+   memset(&conf, 0, sizeof(conf));
+
+   /* A zero mask leaves the scalar kernel in place; the one under test
+    * is swapped in afterwards. */
+   if (!(re = (rarch_sinc_resampler_t*)resampler_sinc_new(
+               &conf, ratio, q, 0)))
+      return 0;
+
+   /* Only the Kaiser window sets a beta. */
+   re->process = (re->kaiser_beta > 0.0f) ? k->kaiser : k->lanczos;
+
+   start = cpu_features_get_time_usec();
+   while (pos < in_frames)
+   {
+      size_t chunk       = in_frames - pos;
+      if (chunk > BENCH_CHUNK)
+         chunk           = BENCH_CHUNK;
+
+      data.data_in       = in  + pos * 2;
+      data.data_out      = out + out_total * 2;
+      data.input_frames  = chunk;
+      data.output_frames = 0;
+      data.ratio         = ratio;
+
+      resampler_sinc_process(re, &data);
+
+      pos               += chunk;
+      out_total         += data.output_frames;
+   }
+   *elapsed = cpu_features_get_time_usec() - start;
+
+   resampler_sinc_free(re);
+   return out_total;
+}
+
+int main(void)
+{
+   static const struct { enum resampler_quality q; const char *name; } quals[] = {
+      { RESAMPLER_QUALITY_LOWEST,  "LOWEST"  },
+      { RESAMPLER_QUALITY_LOWER,   "LOWER"   },
+      { RESAMPLER_QUALITY_NORMAL,  "NORMAL"  },
+      { RESAMPLER_QUALITY_HIGHER,  "HIGHER"  },
+      { RESAMPLER_QUALITY_HIGHEST, "HIGHEST" }
+   };
+   static const struct { double in, out; } rates[] = {
+      { 32040.0, 48000.0 }, /* upsampling, as from most 16-bit cores */
+      { 48000.0, 44100.0 }  /* downsampling, taps grow with the ratio */
+   };
+   uint64_t cpu       = cpu_features_get();
+   size_t in_frames   = (size_t)(48000.0 * BENCH_SECONDS);
+   size_t out_cap     = (size_t)(48000.0 * 1.6 * BENCH_SECONDS) + 1024;
+   float *in          = (float*)malloc(sizeof(float) * 2 * in_frames);
+   float *ref         = (float*)malloc(sizeof(float) * 2 * out_cap);
+   float *out         = (float*)malloc(sizeof(float) * 2 * out_cap);
+   const struct sinc_kernel *scalar = &sinc_kernels[ARRAY_SIZE(sinc_kernels) - 1];
+   size_t q, r, k, n;
+   int rc             = 0;
+
+   if (!in || !ref || !out)
+      return 1;
+
+   for (n = 0; n < in_frames; n++)
+   {
+      in[2 * n]     = 0.5f * (float)sin(2.0 * M_PI * 1000.0 * n / 48000.0);
+      in[2 * n + 1] = 0.5f * (float)sin(2.0 * M_PI * 1500.0 * n / 48000.0);
+   }
+
+   printf("%-8s %-15s %-9s %6s %12s %12s\n",
+         "quality", "rate", "kernel", "taps", "us/out-sec", "max |diff|");
+
+   for (q = 0; q < ARRAY_SIZE(quals); q++)
+   {
+      for (r = 0; r < ARRAY_SIZE(rates); r++)
+      {
+         struct resampler_config conf;
+         retro_time_t ref_time;
+         size_t ref_frames;
+         unsigned taps    = 0;
+         double ratio     = rates[r].out / rates[r].in;
+         void *probe;
+
+         memset(&conf, 0, sizeof(conf));
+         if ((probe = resampler_sinc_new(&conf, ratio, quals[q].q, 0)))
+         {
+            taps = ((rarch_sinc_resampler_t*)probe)->taps;
+            resampler_sinc_free(probe);
+         }
+
+         ref_frames = bench_run(scalar, quals[q].q, rates[r].in,
+               rates[r].out, in, in_frames, ref, &ref_time);
+
+         for (k = 0; k < ARRAY_SIZE(sinc_kernels); k++)
+         {
+            char rate[32];
+            retro_time_t elapsed;
+            size_t frames;
+            float maxd                  = 0.0f;
+            const struct sinc_kernel *kn = &sinc_kernels[k];
+
+            if ((cpu & kn->simd) != kn->simd || (taps % kn->tap_multiple))
+               continue;
+            if (!kn->lanczos || !kn->kaiser)
+               continue;
+
+            frames = bench_run(kn, quals[q].q, rates[r].in, rates[r].out,
+                  in, in_frames, out, &elapsed);
+
+            for (n = 0; n < 2 * frames && n < 2 * ref_frames; n++)
+            {
+               float d = (float)fabs(out[n] - ref[n]);
+               if (d > maxd)
+                  maxd  = d;
+            }
+
+            if (frames != ref_frames || maxd > 1e-4f)
+               rc = 1;
+
+            snprintf(rate, sizeof(rate), "%.0f->%.0f",
+                  rates[r].in, rates[r].out);
+            printf("%-8s %-15s %-9s %6u %12.1f %12.3g%s\n",
+                  quals[q].name, rate, kn->ident, taps,
+                  (double)elapsed / BENCH_SECONDS, maxd,
+                  (frames != ref_frames) ? "  FRAME COUNT MISMATCH" : "");
+         }
+      }
+      printf("\n");
+   }
+
+   free(in);
+   free(ref);
+   free(out);
+
+   if (rc)
+      printf("FAIL: a kernel disagrees with the scalar path\n");
+   return rc;
+}
@@ -1952,6 +1952,7 @@ struct rdeflate
    uint32_t crc;       /* gzip: running crc32 of the input              */
    uint32_t total_in;  /* gzip: mod 2^32, for ISIZE                     */
    int      final_in;    /* caller signalled end of input                  */
+   int      flush_in;    /* caller asked for a sync point                  */
    int      done;
    int      error;
 
@@ -2601,6 +2602,13 @@ void rdeflate_finish(void *data)
    s->final_in = 1;
 }
 
+/* end what has been supplied so far on a byte boundary, and carry on */
+void rdeflate_flush(void *data)
+{
+   struct rdeflate *s = (struct rdeflate*)data;
+   s->flush_in = 1;
+}
+
 /* ------- the parser: consume win[block_start..win_len) into symbols ------- */
 /* Fills the symbol buffer using greedy/lazy matching.  Leaves s->pos at the
  * first unprocessed byte.  Stops early if the symbol buffer is near full.
@@ -2755,8 +2763,9 @@ static void rd_parse(struct rdeflate *s)
       }
    }
 
-   /* flush a deferred match/literal at true end of input */
-   if (s->final_in && s->pos >= end && s->have_prev
+   /* flush a deferred match/literal at true end of input, or at a sync
+    * point, which the symbols before it have to be complete for */
+   if ((s->final_in || s->flush_in) && s->pos >= end && s->have_prev
        && s->nsyms < RD_BLOCK_SYMS - 2)
    {
       s->have_prev = 0;
@@ -3314,8 +3323,13 @@ int rdeflate_process(void *data, size_t *read, size_t *wrote)
       s->in_pos  += n;
    }
 
+   /* Resume a sync marker the output ran out of room for */
+   if (s->emit_phase == 21)
+      goto sync_marker;
+
    /* We only emit once we know the block is complete: either the symbol
-    * buffer is full, the window is full, or input has finished. */
+    * buffer is full, the window is full, input has finished, or the
+    * caller asked for a sync point. */
    for (;;)
    {
       /* Resume emitting a block that was mid-output */
@@ -3381,6 +3395,11 @@ int rdeflate_process(void *data, size_t *read, size_t *wrote)
             s->win_len += (uint32_t)n;
             s->in_pos  += n;
          }
+         if (s->flush_in && s->in_pos >= s->in_size && s->pos >= s->win_len)
+         {
+            s->emit_phase = 20;   /* everything is out: mark the sync point */
+            break;
+         }
          continue;
       }
 
@@ -3402,6 +3421,17 @@ int rdeflate_process(void *data, size_t *read, size_t *wrote)
             block_ready  = 1;
             is_final     = 1;
          }
+         else if (s->flush_in && s->in_pos >= s->in_size
+               && s->pos >= s->win_len)
+         {
+            /* nothing parsed since the last block: no block to close */
+            if (s->nsyms == 0)
+            {
+               s->emit_phase = 20;
+               break;
+            }
+            block_ready  = 1;
+         }
          if (!block_ready) /* need more input */
             goto suspend;   
          s->block_final  = is_final;
@@ -3410,6 +3440,32 @@ int rdeflate_process(void *data, size_t *read, size_t *wrote)
       }
    }
 
+   /* sync point: an empty stored block, as zlib's Z_SYNC_FLUSH writes.
+    * Its header pads to a byte boundary, so whatever follows - more of
+    * this stream, or another stream's blocks - starts on a whole byte. */
+   if (s->emit_phase == 20)
+   {
+      rd_putbits(s, 0, 3);       /* BFINAL=0, BTYPE=00 */
+      if (s->bitcnt & 7)
+         rd_putbits(s, 0, 8 - (s->bitcnt & 7));
+      rd_putbits(s, 0x0000, 16); /* LEN  */
+      rd_putbits(s, 0xffff, 16); /* NLEN */
+      s->emit_phase = 21;
+   }
+sync_marker:
+   if (s->emit_phase == 21)
+   {
+      if (!rd_flush_bytes(s))
+         goto suspend;
+      s->emit_phase = 0;
+      s->flush_in   = 0;
+      if (read)
+         *read  = s->in_pos  - in_start;
+      if (wrote)
+         *wrote = s->out_pos - out_start;
+      return RDEFLATE_PROCESS_BLOCK;
+   }
+
    /* trailer: flush bits + (wrapped) adler32, byte-aligned big-endian */
    if (s->emit_phase == 10)
    {
@@ -57,6 +57,14 @@
 #include <unistd.h> /* stat() is defined here */
 #endif
 
+#if defined(_WIN32) && !defined(_XBOX)
+#include <encodings/utf.h>
+#define PATH_HAVE_STAT_MTIME
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+#include <sys/types.h>
+#define PATH_HAVE_STAT_MTIME
+#endif
+
 /* <direct.h> (MinGW, included just above) can re-establish the mkdir
  * macro after the earlier #undef, so drop it again here before the use
  * site below.  Same rationale for stat, defensively. */
@@ -143,6 +151,59 @@ int64_t path_get_size(const char *path)
    return -1;
 }
 
+/**
+ * path_get_size_mtime:
+ * @path               : path
+ * @size               : receives the size in bytes
+ * @mtime              : receives the modification time, in seconds
+ *
+ * Goes to the platform directly: the VFS stat callbacks carry no
+ * modification time.
+ *
+ * @return true if @path is a regular file and the platform can say
+ * both; otherwise false, with @size and @mtime set to 0.
+ */
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime)
+{
+   bool ok = false;
+
+   *size   = 0;
+   *mtime  = 0;
+
+   if (!path || !*path)
+      return false;
+
+#if defined(PATH_HAVE_STAT_MTIME) && defined(_WIN32)
+   {
+#if defined(LEGACY_WIN32)
+      struct _stat st;
+      ok             = _stat(path, &st) == 0;
+#else
+      struct __stat64 st;
+      wchar_t *wpath = utf8_to_utf16_string_alloc(path);
+      ok             = wpath && _wstat64(wpath, &st) == 0;
+      free(wpath);
+#endif
+      if ((ok = ok && !(st.st_mode & _S_IFDIR)))
+      {
+         *size  = (int64_t)st.st_size;
+         *mtime = (int64_t)st.st_mtime;
+      }
+   }
+#elif defined(PATH_HAVE_STAT_MTIME)
+   {
+      struct stat st;
+      if ((ok = (stat(path, &st) == 0 && !S_ISDIR(st.st_mode))))
+      {
+         *size  = (int64_t)st.st_size;
+         *mtime = (int64_t)st.st_mtime;
+      }
+   }
+#endif
+
+   return ok;
+}
+
 /**
  * path_mkdir:
  * @dir                : directory
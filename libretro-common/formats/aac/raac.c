@@ -59,6 +59,51 @@
 #include <stdio.h>
 #endif
 
+/* Four-lane float kernels for the FFT butterflies, the IMDCT twiddles,
+ * windowing/overlap-add and the dequantisation gain. Each lane does the
+ * scalar code's float operations in the same order, so output is
+ * bit-identical with the scalar path (which raac_open leaves selected
+ * only where neither is compiled in) -- as long as the compiler is not
+ * contracting the scalar multiply-adds into FMAs. NEON is AArch64 only:
+ * ARMv7 NEON flushes denormals, which VFP does not. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAAC_SSE2 1
+#include <emmintrin.h>
+typedef __m128 raac_v4;
+#define RAAC_LD(p)       _mm_loadu_ps(p)
+#define RAAC_ST(p, v)    _mm_storeu_ps((p), (v))
+#define RAAC_SET1(x)     _mm_set1_ps(x)
+#define RAAC_ADD(a, b)   _mm_add_ps((a), (b))
+#define RAAC_SUB(a, b)   _mm_sub_ps((a), (b))
+#define RAAC_MUL(a, b)   _mm_mul_ps((a), (b))
+#define RAAC_NEG(a)      _mm_xor_ps((a), _mm_set1_ps(-0.0f))
+#define RAAC_REV(a)      _mm_shuffle_ps((a), (a), _MM_SHUFFLE(0, 1, 2, 3))
+#define RAAC_EVEN(a, b)  _mm_shuffle_ps((a), (b), _MM_SHUFFLE(2, 0, 2, 0))
+#define RAAC_ODD(a, b)   _mm_shuffle_ps((a), (b), _MM_SHUFFLE(3, 1, 3, 1))
+#define RAAC_ZIPLO(a, b) _mm_unpacklo_ps((a), (b))
+#define RAAC_ZIPHI(a, b) _mm_unpackhi_ps((a), (b))
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#define RAAC_NEON 1
+#include <arm_neon.h>
+typedef float32x4_t raac_v4;
+#define RAAC_LD(p)       vld1q_f32(p)
+#define RAAC_ST(p, v)    vst1q_f32((p), (v))
+#define RAAC_SET1(x)     vdupq_n_f32(x)
+#define RAAC_ADD(a, b)   vaddq_f32((a), (b))
+#define RAAC_SUB(a, b)   vsubq_f32((a), (b))
+#define RAAC_MUL(a, b)   vmulq_f32((a), (b))
+#define RAAC_NEG(a)      vnegq_f32(a)
+#define RAAC_REV(a)      vcombine_f32(vrev64_f32(vget_high_f32(a)), \
+                                      vrev64_f32(vget_low_f32(a)))
+#define RAAC_EVEN(a, b)  vuzpq_f32((a), (b)).val[0]
+#define RAAC_ODD(a, b)   vuzpq_f32((a), (b)).val[1]
+#define RAAC_ZIPLO(a, b) vzipq_f32((a), (b)).val[0]
+#define RAAC_ZIPHI(a, b) vzipq_f32((a), (b)).val[1]
+#endif
+#if defined(RAAC_SSE2) || defined(RAAC_NEON)
+#define RAAC_VEC 1
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -74,6 +119,14 @@
 /* quantised spectrum values live in -8191..8191 (13 bit + escape) */
 #define RAAC_ESC_BOOK  11
 
+/* |q|^(4/3) is tabulated below this magnitude; larger escapes (the
+ * syntax allows them, conforming encoders stay under 8192) still go
+ * through pow() */
+#define RAAC_IQ_TAB    8192
+
+/* largest power-of-two FFT: the 2048-point IMDCT's 512-point core */
+#define RAAC_FFT_MAX   512
+
 /* section codebook meanings */
 #define RAAC_CB_ZERO       0
 #define RAAC_CB_INTENSITY2 14
@@ -1593,6 +1646,10 @@ struct raac
    float    tw512_re[1024], tw512_im[1024];    /* pre+post twiddles 2048 */
    float    tw64_re[128],  tw64_im[128];       /* pre+post twiddles 256  */
    float    fft_re[512], fft_im[512];          /* scratch                */
+   float    fft_tw_re[RAAC_FFT_MAX - 1];       /* per-stage butterfly    */
+   float    fft_tw_im[RAAC_FFT_MAX - 1];       /* twiddles, see below    */
+   float    iq[RAAC_IQ_TAB];                   /* |q|^(4/3)              */
+   int      simd;                              /* vector kernels         */
    unsigned frame_len;                          /* 1024, or 960 when the
                                                 * short frame length is
                                                 * signalled at open     */
@@ -1692,9 +1749,34 @@ static void raac_sine_window(float *w, int n)
  * MDCT symmetries. Output is the full N time samples of this frame's
  * windowed contribution before overlap-add (scale 2/N folded in). */
 
-static void raac_fft(float *re, float *im, int n)
+/* Stage len of raac_fft (2..RAAC_FFT_MAX) takes its len/2 twiddles
+ * from [len/2 - 1, len - 1). They come from the rotation recurrence the
+ * butterfly loop used to run inline for every group, float for float,
+ * so the values are the ones it produced -- computed once at open
+ * rather than n/len times per transform, and loadable four at a time. */
+static void raac_make_fft_twiddles(float *twr, float *twi)
+{
+   int len, j;
+   for (len = 2; len <= RAAC_FFT_MAX; len <<= 1)
+   {
+      double ang = -2.0 * M_PI / len;
+      float  wr0 = (float)cos(ang), wi0 = (float)sin(ang);
+      float  wr = 1.0f, wi = 0.0f;
+      for (j = 0; j < len / 2; j++)
+      {
+         float nr;
+         twr[len / 2 - 1 + j] = wr;
+         twi[len / 2 - 1 + j] = wi;
+         nr = wr * wr0 - wi * wi0;
+         wi = wr * wi0 + wi * wr0;
+         wr = nr;
+      }
+   }
+}
+
+static void raac_fft(const raac_t *a, float *re, float *im, int n)
 {
-   int i, j, k, len;
+   int i, j, len;
    /* bit reversal */
    for (i = 1, j = 0; i < n; i++)
    {
@@ -1711,28 +1793,40 @@ static void raac_fft(float *re, float *im, int n)
    }
    for (len = 2; len <= n; len <<= 1)
    {
-      double ang = -2.0 * M_PI / len;
-      float  wr0 = (float)cos(ang), wi0 = (float)sin(ang);
+      int          h   = len / 2;
+      const float *twr = a->fft_tw_re + h - 1;
+      const float *twi = a->fft_tw_im + h - 1;
       for (i = 0; i < n; i += len)
       {
-         float wr = 1.0f, wi = 0.0f;
-         for (j = 0; j < len / 2; j++)
+         float *ar = re + i, *ai = im + i;
+         float *br = re + i + h, *bi = im + i + h;
+         j = 0;
+#ifdef RAAC_VEC
+         if (a->simd)
+            for (; j + 4 <= h; j += 4)
+            {
+               raac_v4 ur = RAAC_LD(ar + j), ui = RAAC_LD(ai + j);
+               raac_v4 vr = RAAC_LD(br + j), vi = RAAC_LD(bi + j);
+               raac_v4 wr = RAAC_LD(twr + j), wi = RAAC_LD(twi + j);
+               raac_v4 tr = RAAC_SUB(RAAC_MUL(vr, wr), RAAC_MUL(vi, wi));
+               raac_v4 ti = RAAC_ADD(RAAC_MUL(vr, wi), RAAC_MUL(vi, wr));
+               RAAC_ST(ar + j, RAAC_ADD(ur, tr));
+               RAAC_ST(ai + j, RAAC_ADD(ui, ti));
+               RAAC_ST(br + j, RAAC_SUB(ur, tr));
+               RAAC_ST(bi + j, RAAC_SUB(ui, ti));
+            }
+#endif
+         for (; j < h; j++)
          {
-            float ur = re[i + j],           ui = im[i + j];
-            float vr = re[i + j + len / 2], vi = im[i + j + len / 2];
-            float tr = vr * wr - vi * wi;
-            float ti = vr * wi + vi * wr;
-            float nr;
-            re[i + j] = ur + tr; im[i + j] = ui + ti;
-            re[i + j + len / 2] = ur - tr;
-            im[i + j + len / 2] = ui - ti;
-            nr = wr * wr0 - wi * wi0;
-            wi = wr * wi0 + wi * wr0;
-            wr = nr;
+            float ur = ar[j], ui = ai[j];
+            float vr = br[j], vi = bi[j];
+            float tr = vr * twr[j] - vi * twi[j];
+            float ti = vr * twi[j] + vi * twr[j];
+            ar[j] = ur + tr; ai[j] = ui + ti;
+            br[j] = ur - tr; bi[j] = ui - ti;
          }
       }
    }
-   (void)k;
 }
 
 /* Mixed-radix complex FFT for the 960-frame transforms, whose cores
@@ -1778,6 +1872,71 @@ static void raac_fft_mr(const float *in_re, const float *in_im,
       }
 }
 
+/* Pre-twiddle: fre + j*fim = (x[2k] + j*x[n2-1-2k]) * (pr + j*pi), the
+ * even coefficients forward and the odd ones backward. */
+static void raac_pretwiddle(const raac_t *a, const float *x, int n2,
+      const float *pr, const float *pi_, float *fre, float *fim, int n4)
+{
+   int k = 0;
+#ifdef RAAC_VEC
+   if (a->simd)
+      for (; k + 4 <= n4; k += 4)
+      {
+         const float *o  = x + n2 - 8 - 2 * k;
+         raac_v4      xr = RAAC_EVEN(RAAC_LD(x + 2 * k), RAAC_LD(x + 2 * k + 4));
+         raac_v4      xi = RAAC_REV(RAAC_ODD(RAAC_LD(o), RAAC_LD(o + 4)));
+         raac_v4      wr = RAAC_LD(pr + k), wi = RAAC_LD(pi_ + k);
+         RAAC_ST(fre + k, RAAC_SUB(RAAC_MUL(xr, wr), RAAC_MUL(xi, wi)));
+         RAAC_ST(fim + k, RAAC_ADD(RAAC_MUL(xr, wi), RAAC_MUL(xi, wr)));
+      }
+#endif
+   for (; k < n4; k++)
+   {
+      float xr = x[2 * k];
+      float xi = x[n2 - 1 - 2 * k];
+      fre[k] = xr * pr[k] - xi * pi_[k];
+      fim[k] = xr * pi_[k] + xi * pr[k];
+   }
+}
+
+/* Post-twiddle and interleave: y = (fre + j*fim) * (qr + j*qi), then
+ * v[2k] = Re y[k] and v[n2-1-2k] = -Im y[k]. The vector path twiddles
+ * in place first, since each four-sample run of v interleaves one block
+ * of real parts with the mirrored block of imaginary ones. */
+static void raac_posttwiddle(const raac_t *a, float *fre, float *fim,
+      const float *qr, const float *qi, float *v, int n4)
+{
+   int n2 = n4 * 2;
+   int k  = 0;
+#ifdef RAAC_VEC
+   if (a->simd && !(n4 & 3))
+   {
+      for (k = 0; k < n4; k += 4)
+      {
+         raac_v4 fr = RAAC_LD(fre + k), fi = RAAC_LD(fim + k);
+         raac_v4 wr = RAAC_LD(qr + k),  wi = RAAC_LD(qi + k);
+         RAAC_ST(fre + k, RAAC_SUB(RAAC_MUL(fr, wr), RAAC_MUL(fi, wi)));
+         RAAC_ST(fim + k, RAAC_ADD(RAAC_MUL(fr, wi), RAAC_MUL(fi, wr)));
+      }
+      for (k = 0; k < n4; k += 4)
+      {
+         raac_v4 yr = RAAC_LD(fre + k);
+         raac_v4 yi = RAAC_NEG(RAAC_REV(RAAC_LD(fim + n4 - 4 - k)));
+         RAAC_ST(v + 2 * k,     RAAC_ZIPLO(yr, yi));
+         RAAC_ST(v + 2 * k + 4, RAAC_ZIPHI(yr, yi));
+      }
+      return;
+   }
+#endif
+   for (; k < n4; k++)
+   {
+      float yr = fre[k] * qr[k] - fim[k] * qi[k];
+      float yi = fre[k] * qi[k] + fim[k] * qr[k];
+      v[2 * k]          =  yr;
+      v[n2 - 1 - 2 * k] = -yi;
+   }
+}
+
 /* in: N/2 spectral coefficients X, out: N time samples (2/N folded in).
  * Derivation: y is a signed/mirrored rearrangement of the length-N/2
  * DCT-IV of X, and the DCT-IV runs on an N/4-point complex FFT with
@@ -1796,17 +1955,12 @@ static void raac_imdct(raac_t *a, const float *x, float *out, int n)
    const float *qr  = lng ? a->tw512_re + n4 : a->tw64_re + n4;
    const float *qi  = lng ? a->tw512_im + n4 : a->tw64_im + n4;
    float *v   = a->imdct_v;
-   int    k;
+   float  s   = 2.0f / n;
+   int    k   = 0;
 
-   for (k = 0; k < n4; k++)
-   {
-      float xr = x[2 * k];
-      float xi = x[n2 - 1 - 2 * k];
-      fre[k] = xr * pr[k] - xi * pi_[k];
-      fim[k] = xr * pi_[k] + xi * pr[k];
-   }
+   raac_pretwiddle(a, x, n2, pr, pi_, fre, fim, n4);
    if ((n4 & (n4 - 1)) == 0)
-      raac_fft(fre, fim, n4);
+      raac_fft(a, fre, fim, n4);
    else
    {
       const float *wr = (n4 == 480) ? a->w480_re : a->w60_re;
@@ -1816,16 +1970,25 @@ static void raac_imdct(raac_t *a, const float *x, float *out, int n)
       memcpy(fre, a->mr_re, sizeof(float) * (size_t)n4);
       memcpy(fim, a->mr_im, sizeof(float) * (size_t)n4);
    }
-   for (k = 0; k < n4; k++)
+   raac_posttwiddle(a, fre, fim, qr, qi, v, n4);
+#ifdef RAAC_VEC
+   if (a->simd)
    {
-      float yr = fre[k] * qr[k] - fim[k] * qi[k];
-      float yi = fre[k] * qi[k] + fim[k] * qr[k];
-      v[2 * k]           =  yr;
-      v[n2 - 1 - 2 * k]  = -yi;
+      raac_v4 vs = RAAC_SET1(s);
+      for (; k + 4 <= n4; k += 4)
+      {
+         RAAC_ST(out + k, RAAC_MUL(RAAC_LD(v + n4 + k), vs));
+         RAAC_ST(out + n4 + k, RAAC_MUL(
+               RAAC_NEG(RAAC_REV(RAAC_LD(v + n2 - 4 - k))), vs));
+         RAAC_ST(out + n2 + k, RAAC_MUL(
+               RAAC_NEG(RAAC_REV(RAAC_LD(v + n4 - 4 - k))), vs));
+         RAAC_ST(out + n2 + n4 + k, RAAC_MUL(
+               RAAC_NEG(RAAC_LD(v + k)), vs));
+      }
    }
-   for (k = 0; k < n4; k++)
+#endif
+   for (; k < n4; k++)
    {
-      float s = 2.0f / n;
       out[k]           =  v[n4 + k] * s;
       out[n4 + k]      = -v[n2 - 1 - k] * s;
       out[n2 + k]      = -v[n4 - 1 - k] * s;
@@ -2175,6 +2338,77 @@ static float raac_iquant(int q)
    return q < 0 ? -v : v;
 }
 
+/* dst[i] = x[i] * w[i]; dst may be x */
+static void raac_vmul(const raac_t *a, float *dst, const float *x,
+      const float *w, int n)
+{
+   int i = 0;
+#ifdef RAAC_VEC
+   if (a->simd)
+      for (; i + 4 <= n; i += 4)
+         RAAC_ST(dst + i, RAAC_MUL(RAAC_LD(x + i), RAAC_LD(w + i)));
+#endif
+   for (; i < n; i++)
+      dst[i] = x[i] * w[i];
+}
+
+/* dst[i] += x[i] * w[i] */
+static void raac_vmac(const raac_t *a, float *dst, const float *x,
+      const float *w, int n)
+{
+   int i = 0;
+#ifdef RAAC_VEC
+   if (a->simd)
+      for (; i + 4 <= n; i += 4)
+         RAAC_ST(dst + i, RAAC_ADD(RAAC_LD(dst + i),
+                  RAAC_MUL(RAAC_LD(x + i), RAAC_LD(w + i))));
+#endif
+   for (; i < n; i++)
+      dst[i] += x[i] * w[i];
+}
+
+/* dst[i] = x[i] + y[i] */
+static void raac_vadd(const raac_t *a, float *dst, const float *x,
+      const float *y, int n)
+{
+   int i = 0;
+#ifdef RAAC_VEC
+   if (a->simd)
+      for (; i + 4 <= n; i += 4)
+         RAAC_ST(dst + i, RAAC_ADD(RAAC_LD(x + i), RAAC_LD(y + i)));
+#endif
+   for (; i < n; i++)
+      dst[i] = x[i] + y[i];
+}
+
+/* One band of one window: the signed |q|^(4/3) from the table (pow()
+ * only past it), then the band gain across the run. Same products as
+ * raac_iquant(q) * gain, value for value. */
+static void raac_dequant_band(const raac_t *a, float *dst, const int *q,
+      int n, float gain)
+{
+   int i = 0;
+   for (i = 0; i < n; i++)
+   {
+      int m = q[i] < 0 ? -q[i] : q[i];
+      if (m < RAAC_IQ_TAB)
+         dst[i] = q[i] < 0 ? -a->iq[m] : a->iq[m];
+      else
+         dst[i] = raac_iquant(q[i]);
+   }
+   i = 0;
+#ifdef RAAC_VEC
+   if (a->simd)
+   {
+      raac_v4 g = RAAC_SET1(gain);
+      for (; i + 4 <= n; i += 4)
+         RAAC_ST(dst + i, RAAC_MUL(RAAC_LD(dst + i), g));
+   }
+#endif
+   for (; i < n; i++)
+      dst[i] *= gain;
+}
+
 /* quantised -> scaled spectrum, in window-interleaved layout for
  * short sequences (as spectral_data stored it: groups x windows x 128) */
 static void raac_dequant(raac_t *a, raac_ch *c, const int quant[RAAC_FRAME])
@@ -2195,10 +2429,9 @@ static void raac_dequant(raac_t *a, raac_ch *c, const int quant[RAAC_FRAME])
          gain = (float)pow(2.0, 0.25 * (c->sf[g][k] - 100));
          for (w = 0; w < glen; w++)
          {
-            int base = win_base + w * 128 + ((c->window_sequence == 2) ? 0 : 0);
-            int i;
-            for (i = swb[k]; i < swb[k + 1]; i++)
-               c->coef[base + i] = raac_iquant(quant[base + i]) * gain;
+            int base = win_base + w * 128 + swb[k];
+            raac_dequant_band(a, c->coef + base, quant + base,
+                  swb[k + 1] - swb[k], gain);
          }
       }
       win_base += glen * ((c->window_sequence == 2) ? 128 : 1024);
@@ -2407,15 +2640,13 @@ static void raac_filterbank(raac_t *a, raac_ch *c, float out[RAAC_FRAME])
       {
          case 0:  /* only long  */
          case 1:  /* long start */
-            for (i = 0; i < L; i++)
-               buf[i] = buf[i] * long_prev[i];
+            raac_vmul(a, buf, buf, long_prev, L);
             break;
          default: /* long stop: zero head, short rise, then a flat
                    * run that the in-place windowing leaves alone   */
             for (i = 0; i < flat; i++)
                buf[i] = 0.0f;
-            for (i = 0; i < Ls; i++)
-               buf[flat + i] = buf[flat + i] * shrt_prev[i];
+            raac_vmul(a, buf + flat, buf + flat, shrt_prev, Ls);
             break;
       }
       /* second half: this frame's trailing shape */
@@ -2423,13 +2654,11 @@ static void raac_filterbank(raac_t *a, raac_ch *c, float out[RAAC_FRAME])
       {
          case 0:  /* long tail */
          case 3:
-            for (i = 0; i < L; i++)
-               buf[L + i] = buf[L + i] * long_cur[L + i];
+            raac_vmul(a, buf + L, buf + L, long_cur + L, L);
             break;
          default: /* long start: a flat run kept as it stands, then
                    * a short fall and a zero tail                   */
-            for (i = 0; i < Ls; i++)
-               buf[L + flat + i] = buf[L + flat + i] * shrt_cur[Ls + i];
+            raac_vmul(a, buf + L + flat, buf + L + flat, shrt_cur + Ls, Ls);
             for (i = L + flat + Ls; i < nl; i++)
                buf[i] = 0.0f;
             break;
@@ -2445,18 +2674,15 @@ static void raac_filterbank(raac_t *a, raac_ch *c, float out[RAAC_FRAME])
       memset(buf, 0, sizeof(a->fb_win));
       for (w = 0; w < 8; w++)
       {
+         const float *head = (w == 0) ? shrt_prev : shrt_cur;
+         float       *dst  = buf + flat + w * Ls;
          raac_imdct(a, c->coef + w * 128, sbuf, ns);
-         for (i = 0; i < ns; i++)
-         {
-            const float *head = (w == 0) ? shrt_prev : shrt_cur;
-            float win = (i < Ls) ? head[i] : shrt_cur[i];
-            buf[flat + w * Ls + i] += sbuf[i] * win;
-         }
+         raac_vmac(a, dst, sbuf, head, Ls);
+         raac_vmac(a, dst + Ls, sbuf + Ls, shrt_cur + Ls, ns - Ls);
       }
    }
 
-   for (i = 0; i < L; i++)
-      out[i] = buf[i] + c->overlap[i];
+   raac_vadd(a, out, buf, c->overlap, L);
    memcpy(c->overlap, buf + L, sizeof(float) * (size_t)L);
    c->prev_window_shape = c->window_shape;
 }
@@ -3346,22 +3572,9 @@ static void raac_imdct_half128(raac_t *a, const float in[64],
    float *fre = a->fft_re, *fim = a->fft_im;
    float  v[64], full[128];
    int    k;
-   for (k = 0; k < 32; k++)
-   {
-      float xr = in[2 * k], xi = in[63 - 2 * k];
-      float pr = a->tw32_re[k], pi_ = a->tw32_im[k];
-      fre[k] = xr * pr - xi * pi_;
-      fim[k] = xr * pi_ + xi * pr;
-   }
-   raac_fft(fre, fim, 32);
-   for (k = 0; k < 32; k++)
-   {
-      float qr = a->tw32_re[32 + k], qi = a->tw32_im[32 + k];
-      float yr = fre[k] * qr - fim[k] * qi;
-      float yi = fre[k] * qi + fim[k] * qr;
-      v[2 * k]      =  yr;
-      v[63 - 2 * k] = -yi;
-   }
+   raac_pretwiddle(a, in, 64, a->tw32_re, a->tw32_im, fre, fim, 32);
+   raac_fft(a, fre, fim, 32);
+   raac_posttwiddle(a, fre, fim, a->tw32_re + 32, a->tw32_im + 32, v, 32);
    for (k = 0; k < 32; k++)
    {
       full[k]      =  v[32 + k];
@@ -4745,6 +4958,11 @@ raac_t *raac_open(const uint8_t *asc, size_t asc_size)
    a->channels    = channels;
    a->frame_len   = frame_960 ? 960 : 1024;
    a->noise_state = 0x1f2e3d4cu;
+#ifdef RAAC_VEC
+   a->simd        = 1;
+#endif
+   for (i = 0; i < RAAC_IQ_TAB; i++)
+      a->iq[i] = raac_iquant(i);
 
    /* output-rate contract, fixed for the life of the instance:
     * - explicit SBR signaling at twice the core rate turns the
@@ -4816,6 +5034,7 @@ raac_t *raac_open(const uint8_t *asc, size_t asc_size)
       raac_make_twiddles(a->tw512_re, a->tw512_im, nl / 4, nl);
       raac_make_twiddles(a->tw64_re, a->tw64_im, ns / 4, ns);
       raac_make_twiddles(a->tw32_re, a->tw32_im, 32, 128);
+      raac_make_fft_twiddles(a->fft_tw_re, a->fft_tw_im);
       if (a->frame_len == 960)
       {
          int k;
@@ -84,7 +84,8 @@
  *   By byte range, by hunk including a final hunk that is partly
  *   padding, and by sector, where each sector is emitted at its own
  *   track's size. Parent references chain through a bound parent.
- *   One decoded hunk is cached.
+ *   Decoded hunks are cached and the least recently used is evicted:
+ *   one by default, as many as rchd_set_cache_hunks() asks for.
  *
  * SUPPLYING BYTES
  *   Requests are named by where they read from, so bytes can be
@@ -235,6 +236,7 @@ static const char rchd_end_of_list[16] =
 
 static int rchd_build_tracks(rchd_t *chd);
 static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req);
+static void rchd_cache_drop(rchd_t *chd);
 
 /* -------- byte access --------
  *
@@ -355,10 +357,15 @@ struct rchd
    uint16_t          *av_lookup;
    int16_t           *av_samples;
 
-   /* One decoded hunk, kept so a range spanning several hunks, or two
-    * reads inside one, decode each hunk once. */
-   uint8_t           *cache;
-   uint32_t           cached;
+   /* Decoded hunks, kept so a range spanning several hunks, two reads
+    * inside one, or a reader coming back to a hunk it has left, decode
+    * each hunk once. cache_hunks slots, each made on first use; the one
+    * used least recently is the one a miss replaces. */
+   uint8_t          **cache;
+   uint32_t          *cache_tag;
+   uint32_t          *cache_used;
+   uint32_t           cache_hunks;
+   uint32_t           cache_clock;
 
    /* One hunk's worth of sector and subchannel data, before the two are
     * interleaved into the caller's buffer. */
@@ -1090,7 +1097,7 @@ void rchd_free(rchd_t *chd)
 #ifdef HAVE_RCHD_LZMA
    free(chd->lzma);
 #endif
-   free(chd->cache);
+   rchd_cache_drop(chd);
    free(chd->cd_scratch);
    free(chd->tracks);
    free(chd->sec_frame);
@@ -2324,18 +2331,113 @@ static int rchd_build_hunk(rchd_t *chd, uint32_t hunk,
  *
  * A read walks the hunks its byte range covers. For each one it names
  * the blob it needs, decodes it once into a cache, and copies out the
- * slice wanted. The cache means a range spanning several hunks, or two
- * reads within one hunk, decode each hunk once.
+ * slice wanted. The cache means a range spanning several hunks, two
+ * reads within one hunk, or a reader returning to a hunk it read a few
+ * hunks ago, decode each hunk once.
  */
 
+static void rchd_cache_drop(rchd_t *chd)
+{
+   uint32_t i;
+
+   if (chd->cache)
+      for (i = 0; i < chd->cache_hunks; i++)
+         free(chd->cache[i]);
+   free(chd->cache);
+   free(chd->cache_tag);
+   free(chd->cache_used);
+   chd->cache      = NULL;
+   chd->cache_tag  = NULL;
+   chd->cache_used = NULL;
+}
+
 static int rchd_cache_alloc(rchd_t *chd)
 {
-   if (!chd->cache)
+   uint32_t i;
+
+   if (chd->cache)
+      return RCHD_OK;
+   if (!chd->cache_hunks)
+      chd->cache_hunks = 1;
+
+   chd->cache      = (uint8_t**)calloc(chd->cache_hunks, sizeof(uint8_t*));
+   chd->cache_tag  = (uint32_t*)malloc(chd->cache_hunks * sizeof(uint32_t));
+   chd->cache_used = (uint32_t*)calloc(chd->cache_hunks, sizeof(uint32_t));
+   if (!chd->cache || !chd->cache_tag || !chd->cache_used)
    {
-      if (!(chd->cache = (uint8_t*)malloc(chd->info.hunk_bytes)))
-         return RCHD_ERROR_MEM;
-      chd->cached = (uint32_t)-1;
+      rchd_cache_drop(chd);
+      return RCHD_ERROR_MEM;
    }
+   for (i = 0; i < chd->cache_hunks; i++)
+      chd->cache_tag[i] = (uint32_t)-1;
+   chd->cache_clock = 0;
+   return RCHD_OK;
+}
+
+/* The next use stamp. On wrapping every slot is made equally old, which
+ * costs one round of eviction order and nothing else. */
+static uint32_t rchd_cache_tick(rchd_t *chd)
+{
+   if (++chd->cache_clock == 0)
+   {
+      memset(chd->cache_used, 0, chd->cache_hunks * sizeof(uint32_t));
+      chd->cache_clock = 1;
+   }
+   return chd->cache_clock;
+}
+
+/* The slot holding decoded hunk @hunk, or -1. A linear scan: the cache
+ * is tens of hunks at most, and each hit saves a whole decode. */
+static int rchd_cache_find(rchd_t *chd, uint32_t hunk)
+{
+   uint32_t i;
+
+   for (i = 0; i < chd->cache_hunks; i++)
+      if (chd->cache_tag[i] == hunk)
+      {
+         chd->cache_used[i] = rchd_cache_tick(chd);
+         return (int)i;
+      }
+   return -1;
+}
+
+/* Picks the slot a miss decodes into: an empty one if any, else the one
+ * used least recently. It is untagged before anything is written to it,
+ * so a decode that fails or is abandoned leaves no stale entry behind. */
+static int rchd_cache_claim(rchd_t *chd)
+{
+   uint32_t i, victim = 0;
+
+   for (i = 0; i < chd->cache_hunks; i++)
+   {
+      if (chd->cache_tag[i] == (uint32_t)-1)
+      {
+         victim = i;
+         break;
+      }
+      if (chd->cache_used[i] < chd->cache_used[victim])
+         victim = i;
+   }
+
+   if (!chd->cache[victim]
+         && !(chd->cache[victim] = (uint8_t*)malloc(chd->info.hunk_bytes)))
+      return -1;
+   chd->cache_tag[victim] = (uint32_t)-1;
+   return (int)victim;
+}
+
+int rchd_set_cache_hunks(rchd_t *chd, uint32_t hunks)
+{
+   if (!chd || !hunks)
+      return RCHD_ERROR_PARAM;
+   /* A read in progress may be decoding into a slot this would free. */
+   if (chd->reading || chd->sec_active)
+      return RCHD_ERROR_STATE;
+   if (hunks == chd->cache_hunks)
+      return RCHD_OK;
+
+   rchd_cache_drop(chd);
+   chd->cache_hunks = hunks;
    return RCHD_OK;
 }
 
@@ -2782,6 +2884,7 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
       uint32_t skip  = (uint32_t)(at % chd->info.hunk_bytes);
       size_t   avail = chd->info.hunk_bytes - skip;
       uint32_t src_hunk;
+      int      slot;
       int      err;
 
       if (avail > chd->rd_len - chd->rd_done)
@@ -2802,7 +2905,7 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
       if ((err = rchd_resolve_self(chd, hunk, &src_hunk)) != RCHD_OK)
          return err;
 
-      if (chd->cached != src_hunk)
+      if ((slot = rchd_cache_find(chd, src_hunk)) < 0)
       {
          const rchd_map_entry_t *e;
          e = &chd->map[src_hunk];
@@ -2814,9 +2917,11 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
          {
             if (!chd->parent)
                return RCHD_ERROR_NO_PARENT;
+            if ((slot = rchd_cache_claim(chd)) < 0)
+               return RCHD_ERROR_MEM;
             err = rchd_read_begin(chd->parent,
                   e->offset * chd->info.unit_bytes,
-                  chd->cache, chd->info.hunk_bytes);
+                  chd->cache[slot], chd->info.hunk_bytes);
             if (err != RCHD_OK)
                return err;
             for (;;)
@@ -2831,7 +2936,6 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
                   return err;
                break;
             }
-            chd->cached = src_hunk;
          }
          else
          {
@@ -2847,8 +2951,10 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
                   return RCHD_PENDING;
             }
 
+            if ((slot = rchd_cache_claim(chd)) < 0)
+               return RCHD_ERROR_MEM;
             err = rchd_build_hunk(chd, src_hunk, chd->pending,
-                  (uint32_t)need, chd->cache);
+                  (uint32_t)need, chd->cache[slot]);
             if (err != RCHD_OK)
                return err;
 
@@ -2856,15 +2962,16 @@ static int rchd_read_step_bytes(rchd_t *chd, rchd_request_t *req)
              * the only integrity signal those images carry. */
             if (chd->info.version >= 3 && chd->info.version <= 4
                   && e->crc != 0
-                  && encoding_crc32(0, chd->cache, chd->info.hunk_bytes)
-                     != e->crc)
+                  && encoding_crc32(0, chd->cache[slot],
+                     chd->info.hunk_bytes) != e->crc)
                return RCHD_ERROR_CRC;
-
-            chd->cached = src_hunk;
          }
+
+         chd->cache_tag[slot]  = src_hunk;
+         chd->cache_used[slot] = rchd_cache_tick(chd);
       }
 
-      memcpy(chd->rd_dst + chd->rd_done, chd->cache + skip, avail);
+      memcpy(chd->rd_dst + chd->rd_done, chd->cache[slot] + skip, avail);
       chd->rd_done += avail;
    }
 
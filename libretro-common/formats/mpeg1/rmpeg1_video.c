@@ -44,11 +44,33 @@
 #include <string.h>
 
 #include <retro_inline.h>
+#include <features/features_cpu.h>
 
 #include <formats/rmpeg1_video.h>
 
 #include "rmpeg1_tables.h"
 
+/* Vector kernels for the IDCT, motion compensation and colour conversion.
+ * Each one reproduces its scalar counterpart bit for bit, so a stream
+ * decodes to the same pixels on every host -- the rule the integer IDCT
+ * already exists for. SSE2 is compiled in whenever the target has it and
+ * AVX2 through a target attribute; both are picked at init from
+ * cpu_features_get(). NEON is compiled in only where it is baseline. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RMPEG1_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(RMPEG1_SSE2) && (defined(__GNUC__) || defined(__clang__)) \
+      && (defined(__i386__) || defined(__x86_64__))
+#define RMPEG1_AVX2 1
+#define RMPEG1_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RMPEG1_NEON 1
+#include <arm_neon.h>
+#endif
+
 /* The generated tables stay the single source of truth; the decoder builds a
  * lookup index over them at init rather than carrying a second, hand-written
  * copy of the same data in a faster shape.
@@ -151,6 +173,20 @@ static const unsigned rmpeg1_fps_den[16] =
 /* State                                                                 */
 /* --------------------------------------------------------------------- */
 
+/* The per-block stages, chosen once per decoder by rmpeg1_dsp_init(). */
+typedef struct
+{
+   void (*idct_put)(const int16_t *blk, uint8_t *dst, unsigned stride);
+   void (*idct_add)(const int16_t *blk, uint8_t *dst, unsigned stride);
+   /* An in-bounds prediction, bw 8 or 16 wide; mode is hx | hy << 1 */
+   void (*mc_put)(const uint8_t *src, unsigned stride,
+         uint8_t *dst, unsigned dstride,
+         unsigned bw, unsigned bh, unsigned mode);
+   /* dst = (dst + src + 1) >> 1, for bidirectional prediction */
+   void (*mc_avg)(uint8_t *dst, unsigned dstride,
+         const uint8_t *src, unsigned sstride, unsigned bw, unsigned bh);
+} rmpeg1_dsp_t;
+
 struct rmpeg1_video
 {
    uint8_t  *buf;
@@ -212,6 +248,8 @@ struct rmpeg1_video
 
    uint32_t  skipped;
    uint32_t  errors;
+
+   rmpeg1_dsp_t dsp;
 };
 
 /* --------------------------------------------------------------------- */
@@ -734,10 +772,725 @@ static void idct_block_add(const int16_t *blk, uint8_t *dst, unsigned stride)
       idct_col_add(tmp + i, dst + i, stride);
 }
 
+/* The vector IDCTs run the same two passes on whole vectors -- lanes are
+ * rows in the first pass and columns in the second, with a transpose in
+ * front of each -- and match the scalar one to the bit. The all-zero
+ * shortcuts above are not branches here; they only skip work that would
+ * produce the same value. The one rewrite is the 181/256 rotation, whose
+ * 64-bit product has no cheap vector form: 181 * (s >> 8) plus
+ * (181 * (s & 255) + 128) >> 8 floors to the same result and stays in 32
+ * bits.
+ *
+ * A block whose only coefficient is DC -- most non-intra residuals that
+ * code anything at all -- is a flat (DC * 8 + 32) >> 6 either way, and is
+ * written directly.
+ *
+ * sh/bias are the input scaling of the pass, pre/presh the rounding of the
+ * W products (the row pass has none) and fin the final shift. */
+#define RMPEG1_IDCT_PASS(T, V, in, out, sh, bias, pre, presh, fin) \
+   do \
+   { \
+      T x0, x1, x2, x3, x4, x5, x6, x7, x8; \
+      x0 = V##_add(V##_sll(in[0], sh), V##_set1(bias)); \
+      x1 = V##_sll(in[4], sh); \
+      x2 = in[6]; \
+      x3 = in[2]; \
+      x4 = in[1]; \
+      x5 = in[7]; \
+      x6 = in[5]; \
+      x7 = in[3]; \
+      x8 = V##_add(V##_mulc(V##_add(x4, x5), W7), V##_set1(pre)); \
+      x4 = V##_sra(V##_add(x8, V##_mulc(x4, W1 - W7)), presh); \
+      x5 = V##_sra(V##_sub(x8, V##_mulc(x5, W1 + W7)), presh); \
+      x8 = V##_add(V##_mulc(V##_add(x6, x7), W3), V##_set1(pre)); \
+      x6 = V##_sra(V##_sub(x8, V##_mulc(x6, W3 - W5)), presh); \
+      x7 = V##_sra(V##_sub(x8, V##_mulc(x7, W3 + W5)), presh); \
+      x8 = V##_add(x0, x1); \
+      x0 = V##_sub(x0, x1); \
+      x1 = V##_add(V##_mulc(V##_add(x3, x2), W6), V##_set1(pre)); \
+      x2 = V##_sra(V##_sub(x1, V##_mulc(x2, W2 + W6)), presh); \
+      x3 = V##_sra(V##_add(x1, V##_mulc(x3, W2 - W6)), presh); \
+      x1 = V##_add(x4, x6); \
+      x4 = V##_sub(x4, x6); \
+      x6 = V##_add(x5, x7); \
+      x5 = V##_sub(x5, x7); \
+      x7 = V##_add(x8, x3); \
+      x8 = V##_sub(x8, x3); \
+      x3 = V##_add(x0, x2); \
+      x0 = V##_sub(x0, x2); \
+      x2 = V##_rot(V##_add(x4, x5)); \
+      x4 = V##_rot(V##_sub(x4, x5)); \
+      out[0] = V##_sra(V##_add(x7, x1), fin); \
+      out[1] = V##_sra(V##_add(x3, x2), fin); \
+      out[2] = V##_sra(V##_add(x0, x4), fin); \
+      out[3] = V##_sra(V##_add(x8, x6), fin); \
+      out[4] = V##_sra(V##_sub(x8, x6), fin); \
+      out[5] = V##_sra(V##_sub(x0, x4), fin); \
+      out[6] = V##_sra(V##_sub(x3, x2), fin); \
+      out[7] = V##_sra(V##_sub(x7, x1), fin); \
+   } while (0)
+
+#define RMPEG1_IDCT_ROWS(T, V, in, out) \
+   RMPEG1_IDCT_PASS(T, V, in, out, 11, 128, 0, 0, 8)
+#define RMPEG1_IDCT_COLS(T, V, in, out) \
+   RMPEG1_IDCT_PASS(T, V, in, out, 8, 8192, 4, 3, 14)
+
+static INLINE int idct_dc_value(const int16_t *blk)
+{
+   return ((int)blk[0] * 8 + 32) >> 6;
+}
+
+#ifdef RMPEG1_SSE2
+#define rm_sse2_add  _mm_add_epi32
+#define rm_sse2_sub  _mm_sub_epi32
+#define rm_sse2_sll  _mm_slli_epi32
+#define rm_sse2_sra  _mm_srai_epi32
+#define rm_sse2_set1 _mm_set1_epi32
+
+/* SSE2 has no 32-bit mullo; the low half of the unsigned 32x32 products
+ * is the same thing. */
+static INLINE __m128i rm_sse2_mulc(__m128i a, int c)
+{
+   __m128i k    = _mm_set1_epi32(c);
+   __m128i even = _mm_mul_epu32(a, k);
+   __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), k);
+   return _mm_unpacklo_epi32(
+         _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+         _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static INLINE __m128i rm_sse2_rot(__m128i s)
+{
+   __m128i hi = rm_sse2_mulc(_mm_srai_epi32(s, 8), 181);
+   __m128i lo = rm_sse2_mulc(_mm_and_si128(s, _mm_set1_epi32(255)), 181);
+   return _mm_add_epi32(hi,
+         _mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(128)), 8));
+}
+
+static INLINE void rm_sse2_transpose8x16(const __m128i *r, __m128i *c)
+{
+   __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+   __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+   __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+   __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+   __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+   __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+   __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+   __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+   __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+   __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+   __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+   __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+   __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+   __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+   __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+   __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+   c[0] = _mm_unpacklo_epi64(b0, b4);
+   c[1] = _mm_unpackhi_epi64(b0, b4);
+   c[2] = _mm_unpacklo_epi64(b1, b5);
+   c[3] = _mm_unpackhi_epi64(b1, b5);
+   c[4] = _mm_unpacklo_epi64(b2, b6);
+   c[5] = _mm_unpackhi_epi64(b2, b6);
+   c[6] = _mm_unpacklo_epi64(b3, b7);
+   c[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+static INLINE void rm_sse2_transpose4x32(const __m128i *x, __m128i *y)
+{
+   __m128i t0 = _mm_unpacklo_epi32(x[0], x[1]);
+   __m128i t1 = _mm_unpacklo_epi32(x[2], x[3]);
+   __m128i t2 = _mm_unpackhi_epi32(x[0], x[1]);
+   __m128i t3 = _mm_unpackhi_epi32(x[2], x[3]);
+   y[0] = _mm_unpacklo_epi64(t0, t1);
+   y[1] = _mm_unpackhi_epi64(t0, t1);
+   y[2] = _mm_unpacklo_epi64(t2, t3);
+   y[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* Loads the block as eight columns of 16-bit coefficients; returns
+ * nonzero when every AC coefficient is zero. */
+static INLINE int rm_sse2_load_cols(const int16_t *blk, __m128i *c)
+{
+   __m128i r[8];
+   __m128i acc;
+   int k;
+
+   for (k = 0; k < 8; k++)
+      r[k] = _mm_loadu_si128((const __m128i*)(const void*)(blk + 8 * k));
+   acc = _mm_and_si128(r[0], _mm_set_epi16(-1, -1, -1, -1, -1, -1, -1, 0));
+   for (k = 1; k < 8; k++)
+      acc = _mm_or_si128(acc, r[k]);
+   if (_mm_movemask_epi8(_mm_cmpeq_epi16(acc, _mm_setzero_si128())) == 0xFFFF)
+      return 1;
+   rm_sse2_transpose8x16(r, c);
+   return 0;
+}
+
+/* Eight rows of the result, saturated to 16 bits. Saturation cannot
+ * change what either store below writes: anything beyond int16 clamps to
+ * 0 or 255 with or without it. */
+static void idct_sse2(const __m128i *c, __m128i *res)
+{
+   __m128i in_lo[8], in_hi[8], b_lo[8], b_hi[8], t[8], o_lo[8], o_hi[8];
+   int k;
+
+   for (k = 0; k < 8; k++)
+   {
+      in_lo[k] = _mm_srai_epi32(_mm_unpacklo_epi16(c[k], c[k]), 16);
+      in_hi[k] = _mm_srai_epi32(_mm_unpackhi_epi16(c[k], c[k]), 16);
+   }
+   RMPEG1_IDCT_ROWS(__m128i, rm_sse2, in_lo, b_lo);
+   RMPEG1_IDCT_ROWS(__m128i, rm_sse2, in_hi, b_hi);
+
+   rm_sse2_transpose4x32(b_lo, t);
+   rm_sse2_transpose4x32(b_hi, t + 4);
+   RMPEG1_IDCT_COLS(__m128i, rm_sse2, t, o_lo);
+   rm_sse2_transpose4x32(b_lo + 4, t);
+   rm_sse2_transpose4x32(b_hi + 4, t + 4);
+   RMPEG1_IDCT_COLS(__m128i, rm_sse2, t, o_hi);
+
+   for (k = 0; k < 8; k++)
+      res[k] = _mm_packs_epi32(o_lo[k], o_hi[k]);
+}
+
+static INLINE void rm_sse2_store_put(const __m128i *res,
+      uint8_t *dst, unsigned stride)
+{
+   int k;
+   for (k = 0; k < 8; k++)
+      _mm_storel_epi64((__m128i*)(void*)(dst + (size_t)k * stride),
+            _mm_packus_epi16(res[k], res[k]));
+}
+
+static INLINE void rm_sse2_store_add(const __m128i *res,
+      uint8_t *dst, unsigned stride)
+{
+   __m128i z = _mm_setzero_si128();
+   int k;
+   for (k = 0; k < 8; k++)
+   {
+      uint8_t *d = dst + (size_t)k * stride;
+      __m128i p  = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(const void*)d), z);
+      p          = _mm_adds_epi16(p, res[k]);
+      _mm_storel_epi64((__m128i*)(void*)d, _mm_packus_epi16(p, p));
+   }
+}
+
+static void idct_put_sse2(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   __m128i c[8], res[8];
+   int k;
+
+   if (rm_sse2_load_cols(blk, c))
+   {
+      for (k = 0; k < 8; k++)
+         res[k] = _mm_set1_epi16((short)idct_dc_value(blk));
+   }
+   else
+      idct_sse2(c, res);
+   rm_sse2_store_put(res, dst, stride);
+}
+
+static void idct_add_sse2(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   __m128i c[8], res[8];
+   int k;
+
+   if (rm_sse2_load_cols(blk, c))
+   {
+      for (k = 0; k < 8; k++)
+         res[k] = _mm_set1_epi16((short)idct_dc_value(blk));
+   }
+   else
+      idct_sse2(c, res);
+   rm_sse2_store_add(res, dst, stride);
+}
+#endif
+
+#ifdef RMPEG1_AVX2
+/* Same shape with a full column in each register, so the row pass is one
+ * set of butterflies instead of two and the transpose between passes is a
+ * single 8x8. */
+#define rm_avx2_add  _mm256_add_epi32
+#define rm_avx2_sub  _mm256_sub_epi32
+#define rm_avx2_sll  _mm256_slli_epi32
+#define rm_avx2_sra  _mm256_srai_epi32
+#define rm_avx2_set1 _mm256_set1_epi32
+#define rm_avx2_mulc(a, c) _mm256_mullo_epi32((a), _mm256_set1_epi32(c))
+
+RMPEG1_TARGET_AVX2
+static INLINE __m256i rm_avx2_rot(__m256i s)
+{
+   __m256i hi = rm_avx2_mulc(_mm256_srai_epi32(s, 8), 181);
+   __m256i lo = rm_avx2_mulc(_mm256_and_si256(s, _mm256_set1_epi32(255)), 181);
+   return _mm256_add_epi32(hi,
+         _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_set1_epi32(128)), 8));
+}
+
+RMPEG1_TARGET_AVX2
+static INLINE void rm_avx2_transpose8x32(const __m256i *x, __m256i *y)
+{
+   __m256i a0 = _mm256_unpacklo_epi32(x[0], x[1]);
+   __m256i a1 = _mm256_unpackhi_epi32(x[0], x[1]);
+   __m256i a2 = _mm256_unpacklo_epi32(x[2], x[3]);
+   __m256i a3 = _mm256_unpackhi_epi32(x[2], x[3]);
+   __m256i a4 = _mm256_unpacklo_epi32(x[4], x[5]);
+   __m256i a5 = _mm256_unpackhi_epi32(x[4], x[5]);
+   __m256i a6 = _mm256_unpacklo_epi32(x[6], x[7]);
+   __m256i a7 = _mm256_unpackhi_epi32(x[6], x[7]);
+   __m256i b0 = _mm256_unpacklo_epi64(a0, a2);
+   __m256i b1 = _mm256_unpackhi_epi64(a0, a2);
+   __m256i b2 = _mm256_unpacklo_epi64(a1, a3);
+   __m256i b3 = _mm256_unpackhi_epi64(a1, a3);
+   __m256i b4 = _mm256_unpacklo_epi64(a4, a6);
+   __m256i b5 = _mm256_unpackhi_epi64(a4, a6);
+   __m256i b6 = _mm256_unpacklo_epi64(a5, a7);
+   __m256i b7 = _mm256_unpackhi_epi64(a5, a7);
+   y[0] = _mm256_permute2x128_si256(b0, b4, 0x20);
+   y[1] = _mm256_permute2x128_si256(b1, b5, 0x20);
+   y[2] = _mm256_permute2x128_si256(b2, b6, 0x20);
+   y[3] = _mm256_permute2x128_si256(b3, b7, 0x20);
+   y[4] = _mm256_permute2x128_si256(b0, b4, 0x31);
+   y[5] = _mm256_permute2x128_si256(b1, b5, 0x31);
+   y[6] = _mm256_permute2x128_si256(b2, b6, 0x31);
+   y[7] = _mm256_permute2x128_si256(b3, b7, 0x31);
+}
+
+RMPEG1_TARGET_AVX2
+static void idct_avx2(const __m128i *c, __m128i *res)
+{
+   __m256i in[8], b[8], t[8], o[8];
+   int k;
+
+   for (k = 0; k < 8; k++)
+      in[k] = _mm256_cvtepi16_epi32(c[k]);
+   RMPEG1_IDCT_ROWS(__m256i, rm_avx2, in, b);
+   rm_avx2_transpose8x32(b, t);
+   RMPEG1_IDCT_COLS(__m256i, rm_avx2, t, o);
+   for (k = 0; k < 8; k++)
+      res[k] = _mm_packs_epi32(_mm256_castsi256_si128(o[k]),
+            _mm256_extracti128_si256(o[k], 1));
+}
+
+RMPEG1_TARGET_AVX2
+static void idct_put_avx2(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   __m128i c[8], res[8];
+   int k;
+
+   if (rm_sse2_load_cols(blk, c))
+   {
+      for (k = 0; k < 8; k++)
+         res[k] = _mm_set1_epi16((short)idct_dc_value(blk));
+   }
+   else
+      idct_avx2(c, res);
+   rm_sse2_store_put(res, dst, stride);
+}
+
+RMPEG1_TARGET_AVX2
+static void idct_add_avx2(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   __m128i c[8], res[8];
+   int k;
+
+   if (rm_sse2_load_cols(blk, c))
+   {
+      for (k = 0; k < 8; k++)
+         res[k] = _mm_set1_epi16((short)idct_dc_value(blk));
+   }
+   else
+      idct_avx2(c, res);
+   rm_sse2_store_add(res, dst, stride);
+}
+#endif
+
+#ifdef RMPEG1_NEON
+#define rm_neon_add  vaddq_s32
+#define rm_neon_sub  vsubq_s32
+#define rm_neon_set1 vdupq_n_s32
+#define rm_neon_mulc vmulq_n_s32
+#define rm_neon_sll(a, n) vshlq_s32((a), vdupq_n_s32(n))
+#define rm_neon_sra(a, n) vshlq_s32((a), vdupq_n_s32(-(n)))
+
+static INLINE int32x4_t rm_neon_rot(int32x4_t s)
+{
+   int32x4_t hi = vmulq_n_s32(vshrq_n_s32(s, 8), 181);
+   int32x4_t lo = vmulq_n_s32(vandq_s32(s, vdupq_n_s32(255)), 181);
+   return vaddq_s32(hi, vshrq_n_s32(vaddq_s32(lo, vdupq_n_s32(128)), 8));
+}
+
+/* A 4x4 transpose of 32-bit lanes through memory: vld4 de-interleaves
+ * exactly the way a transpose needs. */
+static INLINE void rm_neon_transpose4x32(const int32x4_t *x, int32x4_t *y)
+{
+   int32_t     tmp[16];
+   int32x4x4_t q;
+
+   vst1q_s32(tmp,      x[0]);
+   vst1q_s32(tmp + 4,  x[1]);
+   vst1q_s32(tmp + 8,  x[2]);
+   vst1q_s32(tmp + 12, x[3]);
+   q    = vld4q_s32(tmp);
+   y[0] = q.val[0];
+   y[1] = q.val[1];
+   y[2] = q.val[2];
+   y[3] = q.val[3];
+}
+
+/* Returns nonzero, without transforming, when every AC coefficient is
+ * zero; otherwise eight rows of the result saturated to 16 bits. */
+static int idct_neon(const int16_t *blk, int16x8_t *res)
+{
+   int16x8_t   r[8];
+   int16x8_t   acc;
+   int16x8x2_t t01, t23, t45, t67;
+   int32x4x2_t u02, u13, u46, u57;
+   int32x4_t   in_lo[8], in_hi[8], b_lo[8], b_hi[8], t[8], o_lo[8], o_hi[8];
+   int         k;
+
+   for (k = 0; k < 8; k++)
+      r[k] = vld1q_s16(blk + 8 * k);
+   acc = vsetq_lane_s16(0, r[0], 0);
+   for (k = 1; k < 8; k++)
+      acc = vorrq_s16(acc, r[k]);
+   if (!vget_lane_u64(vreinterpret_u64_s16(
+               vorr_s16(vget_low_s16(acc), vget_high_s16(acc))), 0))
+      return 1;
+
+   t01 = vtrnq_s16(r[0], r[1]);
+   t23 = vtrnq_s16(r[2], r[3]);
+   t45 = vtrnq_s16(r[4], r[5]);
+   t67 = vtrnq_s16(r[6], r[7]);
+   u02 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[0]),
+         vreinterpretq_s32_s16(t23.val[0]));
+   u13 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[1]),
+         vreinterpretq_s32_s16(t23.val[1]));
+   u46 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[0]),
+         vreinterpretq_s32_s16(t67.val[0]));
+   u57 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[1]),
+         vreinterpretq_s32_s16(t67.val[1]));
+
+   /* u02/u13 hold the columns of rows 0-3, u46/u57 those of rows 4-7:
+    * columns 0 and 4 in val[0] of the first, 2 and 6 in its val[1], and
+    * the odd columns the same way in the second. */
+#define RM_NEON_WIDEN(u, half) \
+   vmovl_s16(vget_##half##_s16(vreinterpretq_s16_s32(u)))
+   in_lo[0] = RM_NEON_WIDEN(u02.val[0], low);
+   in_lo[4] = RM_NEON_WIDEN(u02.val[0], high);
+   in_lo[2] = RM_NEON_WIDEN(u02.val[1], low);
+   in_lo[6] = RM_NEON_WIDEN(u02.val[1], high);
+   in_lo[1] = RM_NEON_WIDEN(u13.val[0], low);
+   in_lo[5] = RM_NEON_WIDEN(u13.val[0], high);
+   in_lo[3] = RM_NEON_WIDEN(u13.val[1], low);
+   in_lo[7] = RM_NEON_WIDEN(u13.val[1], high);
+   in_hi[0] = RM_NEON_WIDEN(u46.val[0], low);
+   in_hi[4] = RM_NEON_WIDEN(u46.val[0], high);
+   in_hi[2] = RM_NEON_WIDEN(u46.val[1], low);
+   in_hi[6] = RM_NEON_WIDEN(u46.val[1], high);
+   in_hi[1] = RM_NEON_WIDEN(u57.val[0], low);
+   in_hi[5] = RM_NEON_WIDEN(u57.val[0], high);
+   in_hi[3] = RM_NEON_WIDEN(u57.val[1], low);
+   in_hi[7] = RM_NEON_WIDEN(u57.val[1], high);
+#undef RM_NEON_WIDEN
+
+   RMPEG1_IDCT_ROWS(int32x4_t, rm_neon, in_lo, b_lo);
+   RMPEG1_IDCT_ROWS(int32x4_t, rm_neon, in_hi, b_hi);
+
+   rm_neon_transpose4x32(b_lo, t);
+   rm_neon_transpose4x32(b_hi, t + 4);
+   RMPEG1_IDCT_COLS(int32x4_t, rm_neon, t, o_lo);
+   rm_neon_transpose4x32(b_lo + 4, t);
+   rm_neon_transpose4x32(b_hi + 4, t + 4);
+   RMPEG1_IDCT_COLS(int32x4_t, rm_neon, t, o_hi);
+
+   for (k = 0; k < 8; k++)
+      res[k] = vcombine_s16(vqmovn_s32(o_lo[k]), vqmovn_s32(o_hi[k]));
+   return 0;
+}
+
+static void idct_put_neon(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   int16x8_t res[8];
+   int k;
+
+   if (idct_neon(blk, res))
+   {
+      uint8x8_t dc = vqmovun_s16(vdupq_n_s16((int16_t)idct_dc_value(blk)));
+      for (k = 0; k < 8; k++)
+         vst1_u8(dst + (size_t)k * stride, dc);
+      return;
+   }
+   for (k = 0; k < 8; k++)
+      vst1_u8(dst + (size_t)k * stride, vqmovun_s16(res[k]));
+}
+
+static void idct_add_neon(const int16_t *blk, uint8_t *dst, unsigned stride)
+{
+   int16x8_t res[8];
+   int k;
+
+   if (idct_neon(blk, res))
+   {
+      for (k = 0; k < 8; k++)
+         res[k] = vdupq_n_s16((int16_t)idct_dc_value(blk));
+   }
+   for (k = 0; k < 8; k++)
+   {
+      uint8_t  *d = dst + (size_t)k * stride;
+      int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(d)));
+      vst1_u8(d, vqmovun_s16(vqaddq_s16(p, res[k])));
+   }
+}
+#endif
+
 /* --------------------------------------------------------------------- */
 /* Motion compensation                                                   */
 /* --------------------------------------------------------------------- */
 
+/* The in-bounds prediction: the source block, plus the extra row and
+ * column a half-sample position touches, lies inside the reference. mode
+ * is hx | hy << 1. */
+static void mc_put_c(const uint8_t *src, unsigned stride,
+      uint8_t *dst, unsigned dstride,
+      unsigned bw, unsigned bh, unsigned mode)
+{
+   unsigned i, j;
+
+   if (mode == 0)
+   {
+      for (j = 0; j < bh; j++)
+         memcpy(dst + (size_t)j * dstride, src + (size_t)j * stride, bw);
+   }
+   else if (mode == 1)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         const uint8_t *r = src + (size_t)j * stride;
+         uint8_t       *d = dst + (size_t)j * dstride;
+         for (i = 0; i < bw; i++)
+            d[i] = (uint8_t)((r[i] + r[i + 1] + 1) >> 1);
+      }
+   }
+   else if (mode == 2)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         const uint8_t *r = src + (size_t)j * stride;
+         uint8_t       *d = dst + (size_t)j * dstride;
+         for (i = 0; i < bw; i++)
+            d[i] = (uint8_t)((r[i] + r[i + stride] + 1) >> 1);
+      }
+   }
+   else
+   {
+      for (j = 0; j < bh; j++)
+      {
+         const uint8_t *r = src + (size_t)j * stride;
+         uint8_t       *d = dst + (size_t)j * dstride;
+         for (i = 0; i < bw; i++)
+            d[i] = (uint8_t)((r[i] + r[i + 1]
+                            + r[i + stride] + r[i + stride + 1] + 2) >> 2);
+      }
+   }
+}
+
+static void mc_avg_c(uint8_t *dst, unsigned dstride,
+      const uint8_t *src, unsigned sstride, unsigned bw, unsigned bh)
+{
+   unsigned i, j;
+
+   for (j = 0; j < bh; j++)
+   {
+      uint8_t       *d = dst + (size_t)j * dstride;
+      const uint8_t *r = src + (size_t)j * sstride;
+      for (i = 0; i < bw; i++)
+         d[i] = (uint8_t)((d[i] + r[i] + 1) >> 1);
+   }
+}
+
+/* The vector versions handle the only widths the decoder asks for, 16 for
+ * luma and 8 for chroma, a row per iteration. The rounding averages map
+ * straight onto pavgb/vrhadd, which compute (a + b + 1) >> 1 exactly; the
+ * four-tap case is summed in 16 bits. There is no AVX2 variant: a 16-byte
+ * row already fills an SSE register, and splitting rows across lanes costs
+ * more than it saves. */
+#ifdef RMPEG1_SSE2
+#define RM_SSE2_LOAD(p, wide) ((wide) \
+      ? _mm_loadu_si128((const __m128i*)(const void*)(p)) \
+      : _mm_loadl_epi64((const __m128i*)(const void*)(p)))
+
+static INLINE void rm_sse2_store_row(uint8_t *p, __m128i v, int wide)
+{
+   if (wide)
+      _mm_storeu_si128((__m128i*)(void*)p, v);
+   else
+      _mm_storel_epi64((__m128i*)(void*)p, v);
+}
+
+static void mc_put_sse2(const uint8_t *src, unsigned stride,
+      uint8_t *dst, unsigned dstride,
+      unsigned bw, unsigned bh, unsigned mode)
+{
+   const __m128i two = _mm_set1_epi16(2);
+   const __m128i z   = _mm_setzero_si128();
+   int wide          = bw == 16;
+   unsigned j;
+
+   if (bw != 16 && bw != 8)
+   {
+      mc_put_c(src, stride, dst, dstride, bw, bh, mode);
+      return;
+   }
+
+   for (j = 0; j < bh; j++)
+   {
+      const uint8_t *r = src + (size_t)j * stride;
+      uint8_t       *d = dst + (size_t)j * dstride;
+      __m128i a        = RM_SSE2_LOAD(r, wide);
+
+      switch (mode)
+      {
+         case 1:
+            a = _mm_avg_epu8(a, RM_SSE2_LOAD(r + 1, wide));
+            break;
+         case 2:
+            a = _mm_avg_epu8(a, RM_SSE2_LOAD(r + stride, wide));
+            break;
+         case 3:
+            {
+               __m128i b  = RM_SSE2_LOAD(r + 1, wide);
+               __m128i c  = RM_SSE2_LOAD(r + stride, wide);
+               __m128i e  = RM_SSE2_LOAD(r + stride + 1, wide);
+               __m128i lo = _mm_add_epi16(
+                     _mm_add_epi16(_mm_unpacklo_epi8(a, z),
+                        _mm_unpacklo_epi8(b, z)),
+                     _mm_add_epi16(_mm_unpacklo_epi8(c, z),
+                        _mm_unpacklo_epi8(e, z)));
+               __m128i hi = _mm_add_epi16(
+                     _mm_add_epi16(_mm_unpackhi_epi8(a, z),
+                        _mm_unpackhi_epi8(b, z)),
+                     _mm_add_epi16(_mm_unpackhi_epi8(c, z),
+                        _mm_unpackhi_epi8(e, z)));
+               lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+               hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+               a  = _mm_packus_epi16(lo, hi);
+            }
+            break;
+         default:
+            break;
+      }
+      rm_sse2_store_row(d, a, wide);
+   }
+}
+
+static void mc_avg_sse2(uint8_t *dst, unsigned dstride,
+      const uint8_t *src, unsigned sstride, unsigned bw, unsigned bh)
+{
+   int wide = bw == 16;
+   unsigned j;
+
+   if (bw != 16 && bw != 8)
+   {
+      mc_avg_c(dst, dstride, src, sstride, bw, bh);
+      return;
+   }
+   for (j = 0; j < bh; j++)
+   {
+      uint8_t *d = dst + (size_t)j * dstride;
+      rm_sse2_store_row(d, _mm_avg_epu8(RM_SSE2_LOAD(d, wide),
+               RM_SSE2_LOAD(src + (size_t)j * sstride, wide)), wide);
+   }
+}
+#endif
+
+#ifdef RMPEG1_NEON
+static INLINE uint8x8_t rm_neon_avg4(uint8x8_t a, uint8x8_t b,
+      uint8x8_t c, uint8x8_t d)
+{
+   return vrshrn_n_u16(vaddq_u16(vaddl_u8(a, b), vaddl_u8(c, d)), 2);
+}
+
+static void mc_put_neon(const uint8_t *src, unsigned stride,
+      uint8_t *dst, unsigned dstride,
+      unsigned bw, unsigned bh, unsigned mode)
+{
+   unsigned j;
+
+   if (bw == 16)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         const uint8_t *r = src + (size_t)j * stride;
+         uint8x16_t     a = vld1q_u8(r);
+
+         if (mode == 1)
+            a = vrhaddq_u8(a, vld1q_u8(r + 1));
+         else if (mode == 2)
+            a = vrhaddq_u8(a, vld1q_u8(r + stride));
+         else if (mode == 3)
+         {
+            uint8x16_t b = vld1q_u8(r + 1);
+            uint8x16_t c = vld1q_u8(r + stride);
+            uint8x16_t e = vld1q_u8(r + stride + 1);
+            a = vcombine_u8(
+                  rm_neon_avg4(vget_low_u8(a), vget_low_u8(b),
+                     vget_low_u8(c), vget_low_u8(e)),
+                  rm_neon_avg4(vget_high_u8(a), vget_high_u8(b),
+                     vget_high_u8(c), vget_high_u8(e)));
+         }
+         vst1q_u8(dst + (size_t)j * dstride, a);
+      }
+   }
+   else if (bw == 8)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         const uint8_t *r = src + (size_t)j * stride;
+         uint8x8_t      a = vld1_u8(r);
+
+         if (mode == 1)
+            a = vrhadd_u8(a, vld1_u8(r + 1));
+         else if (mode == 2)
+            a = vrhadd_u8(a, vld1_u8(r + stride));
+         else if (mode == 3)
+            a = rm_neon_avg4(a, vld1_u8(r + 1),
+                  vld1_u8(r + stride), vld1_u8(r + stride + 1));
+         vst1_u8(dst + (size_t)j * dstride, a);
+      }
+   }
+   else
+      mc_put_c(src, stride, dst, dstride, bw, bh, mode);
+}
+
+static void mc_avg_neon(uint8_t *dst, unsigned dstride,
+      const uint8_t *src, unsigned sstride, unsigned bw, unsigned bh)
+{
+   unsigned j;
+
+   if (bw == 16)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         uint8_t *d = dst + (size_t)j * dstride;
+         vst1q_u8(d, vrhaddq_u8(vld1q_u8(d),
+                  vld1q_u8(src + (size_t)j * sstride)));
+      }
+   }
+   else if (bw == 8)
+   {
+      for (j = 0; j < bh; j++)
+      {
+         uint8_t *d = dst + (size_t)j * dstride;
+         vst1_u8(d, vrhadd_u8(vld1_u8(d), vld1_u8(src + (size_t)j * sstride)));
+      }
+   }
+   else
+      mc_avg_c(dst, dstride, src, sstride, bw, bh);
+}
+#endif
+
 /* Copy a bw x bh region from the reference with half-sample interpolation.
  *
  * Motion vectors are in half-sample units, so the integer part is an
@@ -749,7 +1502,8 @@ static void idct_block_add(const int16_t *blk, uint8_t *dst, unsigned stride)
  * Source coordinates are clamped. A conforming stream never points a vector
  * outside the reference frame, but a damaged one can, and reading off the
  * end of the plane is not an acceptable way to find out. */
-static void mc_predict(const uint8_t *ref, unsigned stride,
+static void mc_predict(const rmpeg1_dsp_t *dsp,
+      const uint8_t *ref, unsigned stride,
       unsigned pw, unsigned ph,
       uint8_t *dst, unsigned dstride,
       int x, int y, int mvx, int mvy, unsigned bw, unsigned bh)
@@ -770,44 +1524,8 @@ static void mc_predict(const uint8_t *ref, unsigned stride,
          && (unsigned)(sx + (int)bw + (int)hx) <= pw
          && (unsigned)(sy + (int)bh + (int)hy) <= ph)
    {
-      const uint8_t *src = ref + (size_t)sy * stride + sx;
-
-      if (!hx && !hy)
-      {
-         for (j = 0; j < bh; j++)
-            memcpy(dst + (size_t)j * dstride, src + (size_t)j * stride, bw);
-      }
-      else if (hx && !hy)
-      {
-         for (j = 0; j < bh; j++)
-         {
-            const uint8_t *r = src + (size_t)j * stride;
-            uint8_t       *d = dst + (size_t)j * dstride;
-            for (i = 0; i < bw; i++)
-               d[i] = (uint8_t)((r[i] + r[i + 1] + 1) >> 1);
-         }
-      }
-      else if (!hx && hy)
-      {
-         for (j = 0; j < bh; j++)
-         {
-            const uint8_t *r = src + (size_t)j * stride;
-            uint8_t       *d = dst + (size_t)j * dstride;
-            for (i = 0; i < bw; i++)
-               d[i] = (uint8_t)((r[i] + r[i + stride] + 1) >> 1);
-         }
-      }
-      else
-      {
-         for (j = 0; j < bh; j++)
-         {
-            const uint8_t *r = src + (size_t)j * stride;
-            uint8_t       *d = dst + (size_t)j * dstride;
-            for (i = 0; i < bw; i++)
-               d[i] = (uint8_t)((r[i] + r[i + 1]
-                               + r[i + stride] + r[i + stride + 1] + 2) >> 2);
-         }
-      }
+      dsp->mc_put(ref + (size_t)sy * stride + sx, stride,
+            dst, dstride, bw, bh, hx | (hy << 1));
       return;
    }
 
@@ -1181,7 +1899,7 @@ static bool decode_inter_macroblock(rmpeg1_video_t *v, unsigned addr,
             dsy = v->y_stride; dsc = v->c_stride;
          }
 
-         mc_predict(RM_Y(v, slot), v->y_stride, v->y_stride, ph,
+         mc_predict(&v->dsp, RM_Y(v, slot), v->y_stride, v->y_stride, ph,
                     dy, dsy, (int)mx * 16, (int)my * 16,
                     mv[d][0], mv[d][1], 16, 16);
 
@@ -1192,30 +1910,17 @@ static bool decode_inter_macroblock(rmpeg1_video_t *v, unsigned addr,
          cmvx = mv[d][0] / 2;
          cmvy = mv[d][1] / 2;
 
-         mc_predict(RM_CB(v, slot), v->c_stride, v->c_stride, ch,
+         mc_predict(&v->dsp, RM_CB(v, slot), v->c_stride, v->c_stride, ch,
                     dcb, dsc, (int)mx * 8, (int)my * 8, cmvx, cmvy, 8, 8);
-         mc_predict(RM_CR(v, slot), v->c_stride, v->c_stride, ch,
+         mc_predict(&v->dsp, RM_CR(v, slot), v->c_stride, v->c_stride, ch,
                     dcr, dsc, (int)mx * 8, (int)my * 8, cmvx, cmvy, 8, 8);
       }
 
       if (fwd_on && bwd_on)
       {
-         unsigned r, c;
-
-         for (r = 0; r < 16; r++)
-            for (c = 0; c < 16; c++)
-            {
-               uint8_t *p = py + (size_t)r * v->y_stride + c;
-               *p = (uint8_t)((*p + tmp_y[r * 16 + c] + 1) >> 1);
-            }
-         for (r = 0; r < 8; r++)
-            for (c = 0; c < 8; c++)
-            {
-               uint8_t *p = pcb + (size_t)r * v->c_stride + c;
-               uint8_t *q = pcr + (size_t)r * v->c_stride + c;
-               *p = (uint8_t)((*p + tmp_cb[r * 8 + c] + 1) >> 1);
-               *q = (uint8_t)((*q + tmp_cr[r * 8 + c] + 1) >> 1);
-            }
+         v->dsp.mc_avg(py,  v->y_stride, tmp_y,  16, 16, 16);
+         v->dsp.mc_avg(pcb, v->c_stride, tmp_cb, 8,  8,  8);
+         v->dsp.mc_avg(pcr, v->c_stride, tmp_cr, 8,  8,  8);
       }
    }
 
@@ -1227,7 +1932,7 @@ static bool decode_inter_macroblock(rmpeg1_video_t *v, unsigned addr,
                            + (size_t)(i & 1) * 8;
          if (!decode_inter_block(v, blk))
             return false;
-         idct_block_add(blk, dst, v->y_stride);
+         v->dsp.idct_add(blk, dst, v->y_stride);
       }
    }
 
@@ -1235,13 +1940,13 @@ static bool decode_inter_macroblock(rmpeg1_video_t *v, unsigned addr,
    {
       if (!decode_inter_block(v, blk))
          return false;
-      idct_block_add(blk, pcb, v->c_stride);
+      v->dsp.idct_add(blk, pcb, v->c_stride);
    }
    if (cbp & 0x01)
    {
       if (!decode_inter_block(v, blk))
          return false;
-      idct_block_add(blk, pcr, v->c_stride);
+      v->dsp.idct_add(blk, pcr, v->c_stride);
    }
 
    return true;
@@ -1264,16 +1969,16 @@ static bool decode_intra_macroblock(rmpeg1_video_t *v, unsigned addr)
 
       if (!decode_intra_block(v, blk, 0))
          return false;
-      idct_block(blk, dst, v->y_stride);
+      v->dsp.idct_put(blk, dst, v->y_stride);
    }
 
    if (!decode_intra_block(v, blk, 1))
       return false;
-   idct_block(blk, pcb, v->c_stride);
+   v->dsp.idct_put(blk, pcb, v->c_stride);
 
    if (!decode_intra_block(v, blk, 2))
       return false;
-   idct_block(blk, pcr, v->c_stride);
+   v->dsp.idct_put(blk, pcr, v->c_stride);
 
    return true;
 }
@@ -1697,6 +2402,293 @@ static void emit_picture(rmpeg1_video_t *v, rmpeg1_video_frame_t *out)
     * valid for the lifetime the header promises. */
 }
 
+/* --------------------------------------------------------------------- */
+/* Kernel selection and colour conversion                                */
+/* --------------------------------------------------------------------- */
+
+/* simd is a RETRO_SIMD_* mask, normally cpu_features_get(); passing 0
+ * selects the scalar kernels, which is how the bench compares them. */
+static void rmpeg1_dsp_init(rmpeg1_dsp_t *dsp, uint64_t simd)
+{
+   dsp->idct_put = idct_block;
+   dsp->idct_add = idct_block_add;
+   dsp->mc_put   = mc_put_c;
+   dsp->mc_avg   = mc_avg_c;
+#ifdef RMPEG1_SSE2
+   if (simd & RETRO_SIMD_SSE2)
+   {
+      dsp->idct_put = idct_put_sse2;
+      dsp->idct_add = idct_add_sse2;
+      dsp->mc_put   = mc_put_sse2;
+      dsp->mc_avg   = mc_avg_sse2;
+   }
+#endif
+#ifdef RMPEG1_AVX2
+   if ((simd & RETRO_SIMD_SSE2) && (simd & RETRO_SIMD_AVX2))
+   {
+      dsp->idct_put = idct_put_avx2;
+      dsp->idct_add = idct_add_avx2;
+   }
+#endif
+#ifdef RMPEG1_NEON
+   if (simd & RETRO_SIMD_NEON)
+   {
+      dsp->idct_put = idct_put_neon;
+      dsp->idct_add = idct_add_neon;
+      dsp->mc_put   = mc_put_neon;
+      dsp->mc_avg   = mc_avg_neon;
+   }
+#endif
+   (void)simd;
+}
+
+/* BT.601 studio range to full-range RGB, 8 fractional bits:
+ *
+ *   R = (298 (Y - 16)                 + 409 (Cr - 128) + 128) >> 8
+ *   G = (298 (Y - 16) - 100 (Cb - 128) - 208 (Cr - 128) + 128) >> 8
+ *   B = (298 (Y - 16) + 516 (Cb - 128)                 + 128) >> 8
+ *
+ * each clamped to 0..255. Every intermediate fits 16 bits before the
+ * multiply and 32 after it, which is what lets the vector rows below use
+ * 16x16->32 multiplies and still agree with this one exactly. */
+static INLINE uint32_t yuv_pixel(int y, int cb, int cr)
+{
+   int c = 298 * (y - 16) + 128;
+   int d = cb - 128;
+   int e = cr - 128;
+   int r = (c + 409 * e) >> 8;
+   int g = (c - 100 * d - 208 * e) >> 8;
+   int b = (c + 516 * d) >> 8;
+
+   r = r < 0 ? 0 : (r > 255 ? 255 : r);
+   g = g < 0 ? 0 : (g > 255 ? 255 : g);
+   b = b < 0 ? 0 : (b > 255 ? 255 : b);
+   return 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+}
+
+typedef void (*rmpeg1_yuv_row_t)(const uint8_t *y, const uint8_t *cb,
+      const uint8_t *cr, uint32_t *dst, unsigned width, unsigned x);
+
+/* Converts pixels x..width-1 of one row; the vector rows hand their tail
+ * here. */
+static void yuv_row_c(const uint8_t *y, const uint8_t *cb,
+      const uint8_t *cr, uint32_t *dst, unsigned width, unsigned x)
+{
+   for (; x < width; x++)
+      dst[x] = yuv_pixel(y[x], cb[x >> 1], cr[x >> 1]);
+}
+
+#ifdef RMPEG1_SSE2
+/* Eight pixels: four chroma samples, each doubled to cover its pair. */
+static INLINE void rm_sse2_yuv8(__m128i y16, __m128i d16, __m128i e16,
+      __m128i *lo, __m128i *hi)
+{
+   const __m128i k_c  = _mm_set_epi16(128, 298, 128, 298, 128, 298, 128, 298);
+   const __m128i k_r  = _mm_set1_epi32(409);
+   const __m128i k_g  = _mm_set_epi16(-208, -100, -208, -100,
+                                      -208, -100, -208, -100);
+   const __m128i k_b  = _mm_set1_epi32(516);
+   const __m128i one  = _mm_set1_epi16(1);
+   const __m128i z    = _mm_setzero_si128();
+   __m128i c16        = _mm_sub_epi16(y16, _mm_set1_epi16(16));
+   __m128i c_lo       = _mm_madd_epi16(_mm_unpacklo_epi16(c16, one), k_c);
+   __m128i c_hi       = _mm_madd_epi16(_mm_unpackhi_epi16(c16, one), k_c);
+   __m128i r16, g16, b16, bg, ra;
+
+   r16 = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(c_lo,
+               _mm_madd_epi16(_mm_unpacklo_epi16(e16, z), k_r)), 8),
+         _mm_srai_epi32(_mm_add_epi32(c_hi,
+               _mm_madd_epi16(_mm_unpackhi_epi16(e16, z), k_r)), 8));
+   g16 = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(c_lo,
+               _mm_madd_epi16(_mm_unpacklo_epi16(d16, e16), k_g)), 8),
+         _mm_srai_epi32(_mm_add_epi32(c_hi,
+               _mm_madd_epi16(_mm_unpackhi_epi16(d16, e16), k_g)), 8));
+   b16 = _mm_packs_epi32(
+         _mm_srai_epi32(_mm_add_epi32(c_lo,
+               _mm_madd_epi16(_mm_unpacklo_epi16(d16, z), k_b)), 8),
+         _mm_srai_epi32(_mm_add_epi32(c_hi,
+               _mm_madd_epi16(_mm_unpackhi_epi16(d16, z), k_b)), 8));
+
+   bg  = _mm_unpacklo_epi8(_mm_packus_epi16(b16, b16),
+         _mm_packus_epi16(g16, g16));
+   ra  = _mm_unpacklo_epi8(_mm_packus_epi16(r16, r16),
+         _mm_set1_epi8((char)0xFF));
+   *lo = _mm_unpacklo_epi16(bg, ra);
+   *hi = _mm_unpackhi_epi16(bg, ra);
+}
+
+static INLINE __m128i rm_sse2_chroma8(const uint8_t *p)
+{
+   int32_t w;
+   __m128i c;
+
+   memcpy(&w, p, 4);
+   c = _mm_cvtsi32_si128(w);
+   c = _mm_unpacklo_epi8(c, c);
+   return _mm_sub_epi16(_mm_unpacklo_epi8(c, _mm_setzero_si128()),
+         _mm_set1_epi16(128));
+}
+
+static void yuv_row_sse2(const uint8_t *y, const uint8_t *cb,
+      const uint8_t *cr, uint32_t *dst, unsigned width, unsigned x)
+{
+   const __m128i z = _mm_setzero_si128();
+
+   for (; x + 8 <= width; x += 8)
+   {
+      __m128i lo, hi;
+      __m128i y16 = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(const void*)(y + x)), z);
+      rm_sse2_yuv8(y16, rm_sse2_chroma8(cb + (x >> 1)),
+            rm_sse2_chroma8(cr + (x >> 1)), &lo, &hi);
+      _mm_storeu_si128((__m128i*)(void*)(dst + x),     lo);
+      _mm_storeu_si128((__m128i*)(void*)(dst + x + 4), hi);
+   }
+   yuv_row_c(y, cb, cr, dst, width, x);
+}
+#endif
+
+#ifdef RMPEG1_AVX2
+/* The SSE2 row on sixteen pixels: every step stays inside its 128-bit
+ * lane, so the only cross-lane work is the final permute back into
+ * pixel order. */
+RMPEG1_TARGET_AVX2
+static void yuv_row_avx2(const uint8_t *y, const uint8_t *cb,
+      const uint8_t *cr, uint32_t *dst, unsigned width, unsigned x)
+{
+   const __m256i k_c  = _mm256_broadcastsi128_si256(
+         _mm_set_epi16(128, 298, 128, 298, 128, 298, 128, 298));
+   const __m256i k_r  = _mm256_set1_epi32(409);
+   const __m256i k_g  = _mm256_broadcastsi128_si256(
+         _mm_set_epi16(-208, -100, -208, -100, -208, -100, -208, -100));
+   const __m256i k_b  = _mm256_set1_epi32(516);
+   const __m256i one  = _mm256_set1_epi16(1);
+   const __m256i z    = _mm256_setzero_si256();
+   const __m256i bias = _mm256_set1_epi16(128);
+
+   for (; x + 16 <= width; x += 16)
+   {
+      __m128i cb8  = _mm_loadl_epi64((const __m128i*)(const void*)(cb + (x >> 1)));
+      __m128i cr8  = _mm_loadl_epi64((const __m128i*)(const void*)(cr + (x >> 1)));
+      __m256i c16  = _mm256_sub_epi16(_mm256_cvtepu8_epi16(
+               _mm_loadu_si128((const __m128i*)(const void*)(y + x))),
+            _mm256_set1_epi16(16));
+      __m256i d16  = _mm256_sub_epi16(
+            _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(cb8, cb8)), bias);
+      __m256i e16  = _mm256_sub_epi16(
+            _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(cr8, cr8)), bias);
+      __m256i c_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(c16, one), k_c);
+      __m256i c_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(c16, one), k_c);
+      __m256i r16, g16, b16, bg, ra, lo, hi;
+
+      r16 = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(c_lo,
+                  _mm256_madd_epi16(_mm256_unpacklo_epi16(e16, z), k_r)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(c_hi,
+                  _mm256_madd_epi16(_mm256_unpackhi_epi16(e16, z), k_r)), 8));
+      g16 = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(c_lo,
+                  _mm256_madd_epi16(_mm256_unpacklo_epi16(d16, e16), k_g)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(c_hi,
+                  _mm256_madd_epi16(_mm256_unpackhi_epi16(d16, e16), k_g)), 8));
+      b16 = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(c_lo,
+                  _mm256_madd_epi16(_mm256_unpacklo_epi16(d16, z), k_b)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(c_hi,
+                  _mm256_madd_epi16(_mm256_unpackhi_epi16(d16, z), k_b)), 8));
+
+      bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(b16, b16),
+            _mm256_packus_epi16(g16, g16));
+      ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(r16, r16),
+            _mm256_set1_epi8((char)0xFF));
+      lo = _mm256_unpacklo_epi16(bg, ra);
+      hi = _mm256_unpackhi_epi16(bg, ra);
+      _mm256_storeu_si256((__m256i*)(void*)(dst + x),
+            _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256((__m256i*)(void*)(dst + x + 8),
+            _mm256_permute2x128_si256(lo, hi, 0x31));
+   }
+   yuv_row_sse2(y, cb, cr, dst, width, x);
+}
+#endif
+
+#ifdef RMPEG1_NEON
+static INLINE int16x8_t rm_neon_chroma8(const uint8_t *p)
+{
+   uint32_t  w;
+   uint8x8_t c;
+
+   /* Four bytes only; an 8-byte load could run off the end of the plane */
+   memcpy(&w, p, 4);
+   c = vreinterpret_u8_u32(vdup_n_u32(w));
+   c = vzip_u8(c, c).val[0];
+   return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(c)), vdupq_n_s16(128));
+}
+
+static void yuv_row_neon(const uint8_t *y, const uint8_t *cb,
+      const uint8_t *cr, uint32_t *dst, unsigned width, unsigned x)
+{
+   for (; x + 8 <= width; x += 8)
+   {
+      int16x8_t  c = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))),
+            vdupq_n_s16(16));
+      int16x8_t  d = rm_neon_chroma8(cb + (x >> 1));
+      int16x8_t  e = rm_neon_chroma8(cr + (x >> 1));
+      int32x4_t  c_lo = vmull_n_s16(vget_low_s16(c),  298);
+      int32x4_t  c_hi = vmull_n_s16(vget_high_s16(c), 298);
+      uint8x8x4_t px;
+
+      /* vrshrn adds the 128 before shifting */
+      px.val[2] = vqmovun_s16(vcombine_s16(
+               vrshrn_n_s32(vmlal_n_s16(c_lo, vget_low_s16(e),  409), 8),
+               vrshrn_n_s32(vmlal_n_s16(c_hi, vget_high_s16(e), 409), 8)));
+      px.val[1] = vqmovun_s16(vcombine_s16(
+               vrshrn_n_s32(vmlsl_n_s16(vmlsl_n_s16(c_lo,
+                        vget_low_s16(d), 100), vget_low_s16(e), 208), 8),
+               vrshrn_n_s32(vmlsl_n_s16(vmlsl_n_s16(c_hi,
+                        vget_high_s16(d), 100), vget_high_s16(e), 208), 8)));
+      px.val[0] = vqmovun_s16(vcombine_s16(
+               vrshrn_n_s32(vmlal_n_s16(c_lo, vget_low_s16(d),  516), 8),
+               vrshrn_n_s32(vmlal_n_s16(c_hi, vget_high_s16(d), 516), 8)));
+      px.val[3] = vdup_n_u8(0xFF);
+      vst4_u8((uint8_t*)(dst + x), px);
+   }
+   yuv_row_c(y, cb, cr, dst, width, x);
+}
+#endif
+
+static rmpeg1_yuv_row_t yuv_row_select(uint64_t simd)
+{
+#ifdef RMPEG1_AVX2
+   if ((simd & RETRO_SIMD_SSE2) && (simd & RETRO_SIMD_AVX2))
+      return yuv_row_avx2;
+#endif
+#ifdef RMPEG1_SSE2
+   if (simd & RETRO_SIMD_SSE2)
+      return yuv_row_sse2;
+#endif
+#ifdef RMPEG1_NEON
+   if (simd & RETRO_SIMD_NEON)
+      return yuv_row_neon;
+#endif
+   (void)simd;
+   return yuv_row_c;
+}
+
+static void frame_to_argb(const rmpeg1_video_frame_t *f,
+      uint32_t *dst, size_t pitch, rmpeg1_yuv_row_t row)
+{
+   unsigned j;
+
+   for (j = 0; j < f->height; j++)
+      row(f->y  + (size_t)j * f->y_stride,
+          f->cb + (size_t)(j >> 1) * f->c_stride,
+          f->cr + (size_t)(j >> 1) * f->c_stride,
+          (uint32_t*)((uint8_t*)dst + (size_t)j * pitch), f->width, 0);
+}
+
 /* --------------------------------------------------------------------- */
 /* Public entry points                                                   */
 /* --------------------------------------------------------------------- */
@@ -1717,6 +2709,7 @@ rmpeg1_video_t *rmpeg1_video_init(void)
    v->cap = RMPEG1_WINDOW;
 
    build_luts(v);
+   rmpeg1_dsp_init(&v->dsp, cpu_features_get());
 
    memcpy(v->intra_q, rmpeg1_default_intra, 64);
    memset(v->non_intra_q, 16, 64);
@@ -1984,3 +2977,11 @@ uint32_t rmpeg1_video_errors(const rmpeg1_video_t *v)
 {
    return v ? v->errors : 0;
 }
+
+void rmpeg1_video_frame_to_argb(const rmpeg1_video_frame_t *f,
+      uint32_t *dst, size_t pitch)
+{
+   if (!f || !dst)
+      return;
+   frame_to_argb(f, dst, pitch, yuv_row_select(cpu_features_get()));
+}
@@ -29,6 +29,10 @@
 #include <streams/interface_stream.h>
 #include <streams/trans_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 /* SIMD acceleration: SSE2 on x86/x86-64, NEON on ARM.  Same gating as
  * the decoder in rpng.c. */
 #if defined(__SSE2__)
@@ -638,6 +642,182 @@ static unsigned filter_paeth(uint8_t *target,
    return cnt;
 }
 
+/* Per-row scratch.  ~width*bpp each -- trivial compared to the
+ * frame-sized encode_buf the old full-buffer path allocated.
+ *
+ * Every row buffer carries one spare byte in front so the PNG filter
+ * tag can be written immediately before the filtered data and the
+ * whole thing handed to deflate as one span.  The old shape copied
+ * the winning row into a separate tag+data buffer, a full extra pass
+ * over the row for nothing. */
+struct rpng_rows
+{
+   uint8_t *base[6];
+   uint8_t *prev;     /* the previous row, unfiltered: the predictor */
+   uint8_t *cur;
+   uint8_t *up;
+   uint8_t *sub;
+   uint8_t *avg;
+   uint8_t *paeth;
+   size_t line_len;
+   unsigned width;
+   unsigned bpp;
+   enum rpng_pixfmt fmt;
+};
+
+static void rpng_rows_free(struct rpng_rows *rows)
+{
+   unsigned i;
+   for (i = 0; i < 6; i++)
+   {
+      free(rows->base[i]);
+      rows->base[i] = NULL;
+   }
+}
+
+static bool rpng_rows_init(struct rpng_rows *rows, unsigned width,
+      enum rpng_pixfmt fmt)
+{
+   unsigned i;
+
+   rows->width    = width;
+   rows->fmt      = fmt;
+   rows->bpp      = rpng_pixfmt_bpp(fmt);
+   rows->line_len = (size_t)width * rows->bpp;
+
+   /* The top row is predicted from zeroes */
+   rows->base[0]  = (uint8_t*)calloc(1, rows->line_len + 1);
+   for (i = 1; i < 6; i++)
+      rows->base[i] = (uint8_t*)malloc(rows->line_len + 1);
+   for (i = 0; i < 6; i++)
+   {
+      if (!rows->base[i])
+      {
+         rpng_rows_free(rows);
+         return false;
+      }
+   }
+
+   rows->prev     = rows->base[0] + 1;
+   rows->cur      = rows->base[1] + 1;
+   rows->up       = rows->base[2] + 1;
+   rows->sub      = rows->base[3] + 1;
+   rows->avg      = rows->base[4] + 1;
+   rows->paeth    = rows->base[5] + 1;
+   return true;
+}
+
+/* Converts one source row into PNG channel order in rows->cur. */
+static void rpng_rows_load(struct rpng_rows *rows, const uint8_t *data)
+{
+   switch (rows->fmt)
+   {
+      case RPNG_PIXFMT_ARGB32:
+         copy_argb_line(rows->cur, (const uint32_t*)data, rows->width);
+         break;
+      case RPNG_PIXFMT_RGBA32:
+         copy_rgba_line(rows->cur, data, rows->width);
+         break;
+      case RPNG_PIXFMT_RGB48:
+         copy_rgb48_line(rows->cur, (const uint16_t*)data, rows->width);
+         break;
+      case RPNG_PIXFMT_XRGB8888:
+         copy_xrgb8888_line(rows->cur, (const uint32_t*)(const void*)data, rows->width);
+         break;
+      case RPNG_PIXFMT_RGB565:
+         copy_rgb565_line(rows->cur, (const uint16_t*)(const void*)data, rows->width);
+         break;
+      case RPNG_PIXFMT_BGR24:
+      default:
+         copy_bgr24_line(rows->cur, data, rows->width);
+         break;
+   }
+}
+
+/* This row becomes the next row's predictor.  Swapping the two
+ * buffers replaces a second full-row copy; both were allocated
+ * the same way, so either can serve as either. */
+static void rpng_rows_advance(struct rpng_rows *rows)
+{
+   uint8_t *tmp = rows->prev;
+   rows->prev   = rows->cur;
+   rows->cur    = tmp;
+}
+
+/* Makes a source row the predictor without encoding it, for a band
+ * that starts below the top of the image. */
+static void rpng_rows_prime(struct rpng_rows *rows, const uint8_t *data)
+{
+   rpng_rows_load(rows, data);
+   rpng_rows_advance(rows);
+}
+
+/* Filters one source row against the previous one.  Returns the
+ * filter tag followed by the filtered row, line_len + 1 bytes, valid
+ * until the next call. */
+static const uint8_t *rpng_rows_filter(struct rpng_rows *rows,
+      const uint8_t *data)
+{
+   uint8_t filter;
+   unsigned none_score, up_score, sub_score, avg_score, paeth_score;
+   unsigned min_sad;
+   uint8_t *chosen_filtered;
+   unsigned width = rows->width;
+   unsigned bpp   = rows->bpp;
+
+   rpng_rows_load(rows, data);
+
+   /* Filter selection unchanged from the previous implementation:
+    * try every filter, pick the one with lowest sum-of-abs-deviation. */
+   none_score  = count_sad(rows->cur, rows->line_len);
+   up_score    = filter_up   (rows->up,    rows->cur, rows->prev, width, bpp);
+   sub_score   = filter_sub  (rows->sub,   rows->cur,             width, bpp);
+   avg_score   = filter_avg  (rows->avg,   rows->cur, rows->prev, width, bpp);
+   paeth_score = filter_paeth(rows->paeth, rows->cur, rows->prev, width, bpp);
+
+   filter          = 0;
+   min_sad         = none_score;
+   chosen_filtered = rows->cur;
+   if (sub_score < min_sad)   { filter = 1; chosen_filtered = rows->sub;   min_sad = sub_score;   }
+   if (up_score < min_sad)    { filter = 2; chosen_filtered = rows->up;    min_sad = up_score;    }
+   if (avg_score < min_sad)   { filter = 3; chosen_filtered = rows->avg;   min_sad = avg_score;   }
+   if (paeth_score < min_sad) { filter = 4; chosen_filtered = rows->paeth;                        }
+
+   /* Tag goes in the spare byte ahead of the winning buffer, so the
+    * row is fed to deflate in place.  When that is cur itself it
+    * survives the swap below untouched: no filter reads prev[-1]. */
+   chosen_filtered[-1] = filter;
+
+   rpng_rows_advance(rows);
+   return chosen_filtered - 1;
+}
+
+/* Signature, IHDR and the optional HDR chunks: everything up to the
+ * first IDAT. */
+static bool png_write_head(intfstream_t *intf_s, unsigned width,
+      unsigned height, unsigned bpp, const struct rpng_hdr_metadata *hdr)
+{
+   struct png_ihdr ihdr = {0};
+
+   if (intfstream_write(intf_s, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+      return false;
+
+   ihdr.width      = width;
+   ihdr.height     = height;
+   /* bpp is bytes per pixel: 6 = 16-bit RGB, 4 = 8-bit RGBA, 3 = 8-bit RGB. */
+   ihdr.depth      = (bpp == 6) ? 16 : 8;
+   ihdr.color_type = (bpp == sizeof(uint32_t)) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr_string(intf_s, &ihdr))
+      return false;
+
+   /* HDR colour-space chunks (cICP / cLLI / mDCV) belong after IHDR and
+    * before IDAT. Only written when the caller supplied metadata. */
+   if (hdr)
+      if (!png_write_hdr_chunks(intf_s, hdr))
+         return false;
+   return true;
+}
+
 /* Size of the per-chunk deflate output buffer.  A screenshot-sized
  * encode will fill this many times over and produce multiple IDAT
  * chunks; smaller than zlib's default window (32 KiB) to keep
@@ -666,29 +846,15 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
       enum rpng_pixfmt fmt, const struct rpng_hdr_metadata *hdr)
 {
    unsigned h;
-   unsigned bpp = rpng_pixfmt_bpp(fmt);
-   struct png_ihdr ihdr = {0};
    bool ret = true;
    const struct trans_stream_backend *stream_backend = NULL;
-   uint8_t *rgba_line        = NULL;
-   uint8_t *prev_base        = NULL;
-   uint8_t *rgba_base        = NULL;
-   uint8_t *up_base          = NULL;
-   uint8_t *sub_base         = NULL;
-   uint8_t *avg_base         = NULL;
-   uint8_t *paeth_base       = NULL;
-   uint8_t *up_filtered      = NULL;
-   uint8_t *sub_filtered     = NULL;
-   uint8_t *avg_filtered     = NULL;
-   uint8_t *paeth_filtered   = NULL;
-   uint8_t *prev_encoded     = NULL;
+   struct rpng_rows rows     = {{0}};
    /* chunk_buf is the IDAT-chunk staging buffer:
     *   [0..4):        length field (filled in at flush time)
     *   [4..8):        "IDAT"
     *   [8..8+IDAT_CHUNK_SIZE): deflate output */
    uint8_t *chunk_buf        = NULL;
    void *stream              = NULL;
-   size_t line_len           = (size_t)width * bpp;
    /* How many bytes deflate has produced into the current chunk_buf
     * since the last set_out.  Reset to 0 after every flush_idat_chunk. */
    size_t chunk_fill         = 0;
@@ -699,48 +865,13 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
 
    stream_backend = trans_stream_get_zlib_deflate_backend();
 
-   if (intfstream_write(intf_s, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+   if (!png_write_head(intf_s, width, height, rpng_pixfmt_bpp(fmt), hdr))
       GOTO_END_ERROR();
 
-   ihdr.width      = width;
-   ihdr.height     = height;
-   /* bpp is bytes per pixel: 6 = 16-bit RGB, 4 = 8-bit RGBA, 3 = 8-bit RGB. */
-   ihdr.depth      = (bpp == 6) ? 16 : 8;
-   ihdr.color_type = (bpp == sizeof(uint32_t)) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr_string(intf_s, &ihdr))
-      GOTO_END_ERROR();
-
-   /* HDR colour-space chunks (cICP / cLLI / mDCV) belong after IHDR and
-    * before IDAT. Only written when the caller supplied metadata. */
-   if (hdr)
-      if (!png_write_hdr_chunks(intf_s, hdr))
-         GOTO_END_ERROR();
-
-   /* Per-row scratch.  ~width*bpp each -- trivial compared to the
-    * frame-sized encode_buf the old full-buffer path allocated. */
-   /* Every row buffer carries one spare byte in front so the PNG filter
-    * tag can be written immediately before the filtered data and the
-    * whole thing handed to deflate as one span.  The old shape copied
-    * the winning row into a separate tag+data buffer, a full extra pass
-    * over the row for nothing. */
-   prev_base      = (uint8_t*)calloc(1, line_len + 1);
-   rgba_base      = (uint8_t*)malloc(line_len + 1);
-   up_base        = (uint8_t*)malloc(line_len + 1);
-   sub_base       = (uint8_t*)malloc(line_len + 1);
-   avg_base       = (uint8_t*)malloc(line_len + 1);
-   paeth_base     = (uint8_t*)malloc(line_len + 1);
    chunk_buf      = (uint8_t*)malloc(IDAT_CHUNK_SIZE + 8);
-   if (!prev_base || !rgba_base || !up_base || !sub_base
-         || !avg_base || !paeth_base || !chunk_buf)
+   if (!chunk_buf || !rpng_rows_init(&rows, width, fmt))
       GOTO_END_ERROR();
 
-   prev_encoded   = prev_base  + 1;
-   rgba_line      = rgba_base  + 1;
-   up_filtered    = up_base    + 1;
-   sub_filtered   = sub_base   + 1;
-   avg_filtered   = avg_base   + 1;
-   paeth_filtered = paeth_base + 1;
-
    stream = stream_backend->stream_new();
 
    /* Both deflate backends default to level 9, which is the wrong
@@ -814,53 +945,7 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
    for (h = 0; h < height; h++, data += pitch)
    {
       uint32_t rd, wn;
-      uint8_t filter;
-      unsigned none_score, up_score, sub_score, avg_score, paeth_score;
-      unsigned min_sad;
-      uint8_t *chosen_filtered;
-
-      switch (fmt)
-      {
-         case RPNG_PIXFMT_ARGB32:
-            copy_argb_line(rgba_line, (const uint32_t*)data, width);
-            break;
-         case RPNG_PIXFMT_RGBA32:
-            copy_rgba_line(rgba_line, data, width);
-            break;
-         case RPNG_PIXFMT_RGB48:
-            copy_rgb48_line(rgba_line, (const uint16_t*)data, width);
-            break;
-         case RPNG_PIXFMT_XRGB8888:
-            copy_xrgb8888_line(rgba_line, (const uint32_t*)(const void*)data, width);
-            break;
-         case RPNG_PIXFMT_RGB565:
-            copy_rgb565_line(rgba_line, (const uint16_t*)(const void*)data, width);
-            break;
-         case RPNG_PIXFMT_BGR24:
-         default:
-            copy_bgr24_line(rgba_line, data, width);
-            break;
-      }
-
-      /* Filter selection unchanged from the previous implementation:
-       * try every filter, pick the one with lowest sum-of-abs-deviation. */
-      none_score  = count_sad(rgba_line, line_len);
-      up_score    = filter_up   (up_filtered,    rgba_line, prev_encoded, width, bpp);
-      sub_score   = filter_sub  (sub_filtered,   rgba_line,               width, bpp);
-      avg_score   = filter_avg  (avg_filtered,   rgba_line, prev_encoded, width, bpp);
-      paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
-
-      filter          = 0;
-      min_sad         = none_score;
-      chosen_filtered = rgba_line;
-      if (sub_score < min_sad)   { filter = 1; chosen_filtered = sub_filtered;   min_sad = sub_score;   }
-      if (up_score < min_sad)    { filter = 2; chosen_filtered = up_filtered;    min_sad = up_score;    }
-      if (avg_score < min_sad)   { filter = 3; chosen_filtered = avg_filtered;   min_sad = avg_score;   }
-      if (paeth_score < min_sad) { filter = 4; chosen_filtered = paeth_filtered;                        }
-
-      /* Tag goes in the spare byte ahead of the winning buffer, so the
-       * row is fed to deflate in place. */
-      chosen_filtered[-1] = filter;
+      const uint8_t *row = rpng_rows_filter(&rows, data);
 
       /* Feed this row into deflate. The loop handles the case where
        * our chunk buffer fills mid-row (BUFFER_FULL): flush IDAT,
@@ -870,8 +955,8 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
        * consumed what we gave it but hasn't finalized (no Z_FINISH
        * was requested) -- that's the normal "ok, send more data
        * next time" signal.  We break out and feed the next row. */
-      stream_backend->set_in(stream, chosen_filtered - 1,
-            (uint32_t)(line_len + 1));
+      stream_backend->set_in(stream, row,
+            (uint32_t)(rows.line_len + 1));
       for (;;)
       {
          bool ok = stream_backend->trans(stream, false, &rd, &wn, &err);
@@ -907,15 +992,6 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
          stream_backend->set_out(stream,
                chunk_buf + 8, (uint32_t)IDAT_CHUNK_SIZE);
       }
-
-      /* This row becomes the next row's predictor.  Swapping the two
-       * buffers replaces a second full-row copy; both were allocated
-       * the same way, so either can serve as either. */
-      {
-         uint8_t *tmp = prev_encoded;
-         prev_encoded = rgba_line;
-         rgba_line    = tmp;
-      }
    }
 
    /* All rows consumed.  Drain deflate with Z_FINISH, emitting IDATs
@@ -963,12 +1039,7 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
       GOTO_END_ERROR();
 
 end:
-   free(rgba_base);
-   free(prev_base);
-   free(up_base);
-   free(sub_base);
-   free(avg_base);
-   free(paeth_base);
+   rpng_rows_free(&rows);
    free(chunk_buf);
 
    if (stream_backend)
@@ -982,6 +1053,294 @@ end:
    return ret;
 }
 
+#ifdef HAVE_THREADS
+/* Sliced encode: the rows are cut into horizontal bands and each band
+ * is filtered and deflated on its own thread into its own IDAT chunk.
+ * Every band but the last ends on a sync flush - an empty stored
+ * block, so the band ends byte-aligned and with no final bit set -
+ * which makes the concatenation of the bands one valid raw deflate
+ * stream.  The zlib header goes in front of the first band, and the
+ * Adler-32 of the whole filtered image, combined from each band's,
+ * after the last.  The bands start with an empty window, so matches
+ * never cross a band boundary; that costs a little size, which is what
+ * the minimum band height bounds. */
+#define RPNG_SLICE_MIN_ROWS 64
+
+#define RPNG_ADLER_BASE 65521U
+/* Largest n such that 255n(n+1)/2 + (n+1)(BASE-1) fits in 32 bits */
+#define RPNG_ADLER_NMAX 5552
+
+struct rpng_slice
+{
+   const uint8_t *data;  /* first row of the band */
+   const uint8_t *above; /* row before it, the band's first predictor */
+   uint8_t *chunk;       /* length, "IDAT", payload, 4 bytes spare */
+   sthread_t *thread;
+   size_t chunk_size;
+   size_t payload;
+   size_t in_bytes;      /* filtered bytes, for combining the Adler-32 */
+   signed pitch;
+   unsigned width;
+   unsigned rows;
+   enum rpng_pixfmt fmt;
+   uint32_t adler;
+   uint32_t crc;         /* of "IDAT" and the payload */
+   bool first;
+   bool last;
+   bool ok;
+};
+
+static uint32_t rpng_adler32(uint32_t adler, const uint8_t *buf, size_t len)
+{
+   uint32_t a = adler & 0xffff;
+   uint32_t b = adler >> 16;
+
+   while (len)
+   {
+      size_t n = len < RPNG_ADLER_NMAX ? len : RPNG_ADLER_NMAX;
+      len     -= n;
+      while (n--)
+      {
+         a += *buf++;
+         b += a;
+      }
+      a %= RPNG_ADLER_BASE;
+      b %= RPNG_ADLER_BASE;
+   }
+   return (b << 16) | a;
+}
+
+/* Adler-32 of A followed by B, given those of A and B and the length
+ * of B; the same arithmetic as zlib's adler32_combine. */
+static uint32_t rpng_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t len2)
+{
+   uint32_t rem  = (uint32_t)(len2 % RPNG_ADLER_BASE);
+   uint32_t sum1 = adler1 & 0xffff;
+   uint32_t sum2 = (rem * sum1) % RPNG_ADLER_BASE;
+
+   sum1 += (adler2 & 0xffff) + RPNG_ADLER_BASE - 1;
+   sum2 += (adler1 >> 16) + (adler2 >> 16) + RPNG_ADLER_BASE - rem;
+   if (sum1 >= RPNG_ADLER_BASE)
+      sum1 -= RPNG_ADLER_BASE;
+   if (sum1 >= RPNG_ADLER_BASE)
+      sum1 -= RPNG_ADLER_BASE;
+   if (sum2 >= RPNG_ADLER_BASE << 1)
+      sum2 -= RPNG_ADLER_BASE << 1;
+   if (sum2 >= RPNG_ADLER_BASE)
+      sum2 -= RPNG_ADLER_BASE;
+   return sum1 | (sum2 << 16);
+}
+
+/* Doubles the band's chunk buffer and re-points deflate past what it
+ * has written so far, keeping the 4 spare bytes for the trailer. */
+static bool rpng_slice_grow(struct rpng_slice *slice,
+      const struct trans_stream_backend *backend, void *stream,
+      size_t fill)
+{
+   size_t   size  = slice->chunk_size * 2;
+   uint8_t *chunk = (uint8_t*)realloc(slice->chunk, size);
+   if (!chunk)
+      return false;
+   slice->chunk      = chunk;
+   slice->chunk_size = size;
+   backend->set_out(stream, chunk + fill, (uint32_t)(size - fill - 4));
+   return true;
+}
+
+static void rpng_slice_encode(void *data)
+{
+   unsigned h;
+   struct rpng_slice *slice = (struct rpng_slice*)data;
+   struct rpng_rows rows    = {{0}};
+   const struct trans_stream_backend *backend =
+      trans_stream_get_zlib_deflate_backend();
+   void *stream             = NULL;
+   const uint8_t *src       = slice->data;
+   /* Past the chunk header */
+   size_t fill              = 8;
+   enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+
+   slice->ok    = false;
+   slice->adler = 1;
+   if (!rpng_rows_init(&rows, slice->width, slice->fmt))
+      return;
+
+   /* A quarter of the raw size is a fair first guess for screen
+    * content; the buffer doubles when it is not. */
+   slice->in_bytes   = (size_t)slice->rows * (rows.line_len + 1);
+   slice->chunk_size = slice->in_bytes / 4 + 1024;
+   if (!(slice->chunk = (uint8_t*)malloc(slice->chunk_size)))
+      goto end;
+   if (!(stream = backend->stream_new()))
+      goto end;
+
+   /* Same level as the serial encoder; see the measurements there. */
+   backend->define(stream, "level", 6);
+   /* Raw deflate: the zlib header and trailer belong to the image,
+    * not to any one band. */
+   backend->define(stream, "window_bits", (uint32_t)-15);
+   if (!slice->last)
+      backend->define(stream, "sync_flush", 1);
+
+   memcpy(slice->chunk + 4, "IDAT", 4);
+   if (slice->first)
+   {
+      /* CMF/FLG: 32 KiB window, default compression, no dictionary */
+      slice->chunk[fill++] = 0x78;
+      slice->chunk[fill++] = 0x9c;
+   }
+   if (slice->above)
+      rpng_rows_prime(&rows, slice->above);
+
+   backend->set_out(stream, slice->chunk + fill,
+         (uint32_t)(slice->chunk_size - fill - 4));
+
+   for (h = 0; h <= slice->rows; h++)
+   {
+      uint32_t rd, wn;
+      bool flush = (h == slice->rows);
+
+      if (flush)
+         backend->set_in(stream, NULL, 0);
+      else
+      {
+         const uint8_t *row = rpng_rows_filter(&rows, src);
+         slice->adler = rpng_adler32(slice->adler, row, rows.line_len + 1);
+         backend->set_in(stream, row, (uint32_t)(rows.line_len + 1));
+         src += slice->pitch;
+      }
+
+      for (;;)
+      {
+         bool ok = backend->trans(stream, flush, &rd, &wn, &err);
+         fill   += wn;
+
+         if (ok)
+         {
+            /* All input taken; while flushing, NONE also means the
+             * flush is complete.  Otherwise deflate wants more room,
+             * or is about to on the next row. */
+            if (flush ? err == TRANS_STREAM_ERROR_NONE
+                      : fill < slice->chunk_size - 4)
+               break;
+         }
+         else if (err != TRANS_STREAM_ERROR_BUFFER_FULL)
+            goto end;
+
+         if (!rpng_slice_grow(slice, backend, stream, fill))
+            goto end;
+         if (ok && !flush)
+            break;
+      }
+   }
+
+   slice->payload = fill - 8;
+   slice->crc     = encoding_crc32(0, slice->chunk + 4, slice->payload + 4);
+   slice->ok      = true;
+
+end:
+   if (stream)
+      backend->stream_free(stream);
+   rpng_rows_free(&rows);
+}
+#endif
+
+bool rpng_save_image_stream_fmt_threaded(const uint8_t *data,
+      intfstream_t *intf_s, unsigned width, unsigned height, signed pitch,
+      enum rpng_pixfmt fmt, const struct rpng_hdr_metadata *hdr,
+      unsigned threads)
+{
+#ifdef HAVE_THREADS
+   unsigned i, band;
+   uint32_t adler;
+   uint8_t *trailer;
+   bool ret = true;
+   struct rpng_slice slices[RPNG_MAX_THREADS];
+   unsigned count   = threads < RPNG_MAX_THREADS ? threads : RPNG_MAX_THREADS;
+
+   if (count > height / RPNG_SLICE_MIN_ROWS)
+      count = height / RPNG_SLICE_MIN_ROWS;
+   if (count < 2)
+      return rpng_save_image_stream_fmt(data, intf_s, width, height,
+            pitch, fmt, hdr);
+   if (!intf_s)
+      return false;
+
+   memset(slices, 0, sizeof(slices));
+   band = (height + count - 1) / count;
+   for (i = 0; i < count; i++)
+   {
+      unsigned top      = i * band;
+      slices[i].data    = data + (ptrdiff_t)pitch * top;
+      slices[i].above   = i ? slices[i].data - pitch : NULL;
+      slices[i].pitch   = pitch;
+      slices[i].width   = width;
+      slices[i].rows    = (height - top < band) ? height - top : band;
+      slices[i].fmt     = fmt;
+      slices[i].first   = (i == 0);
+      slices[i].last    = (i == count - 1);
+   }
+
+   /* The first band runs here, which would otherwise only wait.  A
+    * band that could not get a thread is encoded here too, late. */
+   for (i = 1; i < count; i++)
+      slices[i].thread = sthread_create(rpng_slice_encode, &slices[i]);
+   rpng_slice_encode(&slices[0]);
+   for (i = 1; i < count; i++)
+   {
+      if (slices[i].thread)
+         sthread_join(slices[i].thread);
+      else
+         rpng_slice_encode(&slices[i]);
+   }
+
+   adler = slices[0].adler;
+   for (i = 0; i < count; i++)
+   {
+      if (!slices[i].ok)
+         GOTO_END_ERROR();
+      if (i)
+         adler = rpng_adler32_combine(adler, slices[i].adler,
+               slices[i].in_bytes);
+   }
+
+   /* The zlib trailer rides at the end of the last band's chunk */
+   trailer = slices[count - 1].chunk + 8 + slices[count - 1].payload;
+   dword_write_be(trailer, adler);
+   slices[count - 1].crc      = encoding_crc32(slices[count - 1].crc,
+         trailer, 4);
+   slices[count - 1].payload += 4;
+
+   if (!png_write_head(intf_s, width, height, rpng_pixfmt_bpp(fmt), hdr))
+      GOTO_END_ERROR();
+
+   for (i = 0; i < count; i++)
+   {
+      uint8_t crc[4];
+      dword_write_be(slices[i].chunk, (uint32_t)slices[i].payload);
+      dword_write_be(crc, slices[i].crc);
+      if (intfstream_write(intf_s, slices[i].chunk, slices[i].payload + 8)
+            != (int64_t)(slices[i].payload + 8))
+         GOTO_END_ERROR();
+      if (intfstream_write(intf_s, crc, 4) != 4)
+         GOTO_END_ERROR();
+   }
+
+   if (!png_write_iend_string(intf_s))
+      GOTO_END_ERROR();
+
+end:
+   for (i = 0; i < count; i++)
+      free(slices[i].chunk);
+   return ret;
+#else
+   (void)threads;
+   return rpng_save_image_stream_fmt(data, intf_s, width, height,
+         pitch, fmt, hdr);
+#endif
+}
+
 /* Bytes-per-pixel entry point kept for callers outside this file, which
  * predate the format enum.  bpp is unambiguous for every format it could
  * already express; RGBA32 is reachable only through the fmt worker or
@@ -41,6 +41,7 @@
 #include <formats/image.h>
 #include <formats/rwebp.h>
 #include <formats/rvp8.h>
+#include <features/features_cpu.h>
 
 /* ===== RIFF Container ===== */
 
@@ -436,26 +437,357 @@ static uint32_t px_cash(uint32_t a, uint32_t b)
         |  (uint32_t)px_clb((int)( a     &0xFF)+((int)( a     &0xFF)-(int)( b     &0xFF))/2);
 }
 
-static uint32_t px_predict(int m, uint32_t L, uint32_t T, uint32_t TL, uint32_t TR)
+/* ===== VP8L inverse-transform kernels =====
+ * Row kernels for the predictor, cross-colour, subtract-green and final
+ * channel-swap passes, picked per decode from the CPU feature mask the
+ * way rjpeg picks its IDCT. The scalar kernels are the reference; the
+ * SSE2/NEON ones handle four pixels per step wherever a pixel does not
+ * depend on its left neighbour (predictor modes 0, 2, 3, 4, 8 and 9 and
+ * the three pointwise passes), compute the same byte arithmetic and are
+ * bit-exact with them. The L-dependent predictor modes stay serial in
+ * every build.
+ *
+ * A predictor kernel adds its prediction to n pixels of cur in place;
+ * up is the row above at the same x, so up[-1] is TL and up[1] is TR
+ * (the last column's TR wraps to cur[0], as the flat buffer does). */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RWEBP_VL_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RWEBP_VL_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* A bench or test that includes this file may define this to force a
+ * kernel set. */
+#ifndef RWEBP_CPU_FEATURES
+#define RWEBP_CPU_FEATURES() cpu_features_get()
+#endif
+
+typedef void (*vl_pred_fn)(uint32_t *cur, const uint32_t *up, int n);
+
+typedef struct
+{
+   vl_pred_fn pred[16];
+   void (*add_green)(uint32_t *p, int n);
+   void (*color_xf)(uint32_t *p, int n, uint32_t td);
+   void (*swap_rb)(uint32_t *p, size_t n);
+} vl_dsp;
+
+/* each kernel reads only the neighbours its mode names */
+#define L  cur[x - 1]
+#define T  up[x]
+#define TL up[x - 1]
+#define TR up[x + 1]
+#define VL_PRED_C(name, expr) \
+static void name(uint32_t *cur, const uint32_t *up, int n) \
+{ \
+   int x; \
+   (void)up; \
+   for (x = 0; x < n; x++) \
+      cur[x] = px_add(cur[x], (expr)); \
+}
+
+VL_PRED_C(vl_pred0_c,  0xFF000000u)
+VL_PRED_C(vl_pred1_c,  L)
+VL_PRED_C(vl_pred2_c,  T)
+VL_PRED_C(vl_pred3_c,  TR)
+VL_PRED_C(vl_pred4_c,  TL)
+VL_PRED_C(vl_pred5_c,  px_avg2(px_avg2(L, TR), T))
+VL_PRED_C(vl_pred6_c,  px_avg2(L, TL))
+VL_PRED_C(vl_pred7_c,  px_avg2(L, T))
+VL_PRED_C(vl_pred8_c,  px_avg2(TL, T))
+VL_PRED_C(vl_pred9_c,  px_avg2(T, TR))
+VL_PRED_C(vl_pred10_c, px_avg2(px_avg2(L, TL), px_avg2(T, TR)))
+VL_PRED_C(vl_pred11_c, px_select(TL, T, L))
+VL_PRED_C(vl_pred12_c, px_casf(L, T, TL))
+VL_PRED_C(vl_pred13_c, px_cash(px_avg2(L, T), TL))
+#undef L
+#undef T
+#undef TL
+#undef TR
+
+static void vl_add_green_c(uint32_t *p, int n)
+{
+   int j;
+   for (j = 0; j < n; j++)
+   {
+      uint32_t c = p[j];
+      uint32_t g = (c >> 8) & 0xFF;
+      uint32_t r = (((c >> 16) & 0xFF) + g) & 0xFF;
+      uint32_t b2 = ((c & 0xFF) + g) & 0xFF;
+      p[j] = (c & 0xFF00FF00u) | (r << 16) | b2;
+   }
+}
+
+/* td is the block's transform element: libwebp ColorCodeToMultipliers
+ * puts green_to_red in the BLUE byte, green_to_blue in GREEN and
+ * red_to_blue in RED. Channel values are SIGNED here (libwebp
+ * ColorTransformDelta takes int8_t). */
+static void vl_color_xf_c(uint32_t *p, int n, uint32_t td)
+{
+   int     j;
+   int8_t  g2r = (int8_t)(td & 0xFF);
+   int8_t  g2b = (int8_t)((td >>  8) & 0xFF);
+   int8_t  r2b = (int8_t)((td >> 16) & 0xFF);
+   for (j = 0; j < n; j++)
+   {
+      uint32_t c2 = p[j];
+      int g  = (int)(int8_t)((c2 >> 8) & 0xFF);
+      int r  = (int)((c2 >> 16) & 0xFF);
+      int b2 = (int)(c2 & 0xFF);
+      r  = (r + ((g2r * g) >> 5)) & 0xFF;
+      b2 = b2 + ((g2b * g) >> 5);
+      b2 = (b2 + ((r2b * (int)(int8_t)r) >> 5)) & 0xFF;
+      p[j] = (c2 & 0xFF00FF00u) | ((uint32_t)r << 16) | (uint32_t)b2;
+   }
+}
+
+/* Swap the R and B channel bytes of n words in place (ARGB <-> the
+ * memory R,G,B,A layout). */
+static void vl_swap_px(uint32_t *p, size_t n)
+{
+   size_t i;
+   for (i = 0; i < n; i++)
+   {
+      uint32_t v = p[i];
+      p[i] = (v & 0xFF00FF00u) | ((v & 0xFF) << 16) | ((v >> 16) & 0xFF);
+   }
+}
+
+#if defined(RWEBP_VL_SSE2)
+/* px_avg2 per byte: floor((a + b) / 2). _mm_avg_epu8 rounds up. */
+static INLINE __m128i vl_avg2_sse2(__m128i a, __m128i b)
+{
+   return _mm_add_epi32(_mm_and_si128(a, b), _mm_srli_epi32(
+         _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi32(0xFEFEFEFE)),
+         1));
+}
+
+#define VL_PRED_SSE2(name, tail, expr) \
+static void name(uint32_t *cur, const uint32_t *up, int n) \
+{ \
+   int x = 0; \
+   for (; x + 4 <= n; x += 4) \
+   { \
+      __m128i c = _mm_loadu_si128((const __m128i*)(cur + x)); \
+      _mm_storeu_si128((__m128i*)(cur + x), _mm_add_epi8(c, (expr))); \
+   } \
+   if (x < n) \
+      tail(cur + x, up + x, n - x); \
+}
+#define VL_LD(p) _mm_loadu_si128((const __m128i*)(p))
+
+VL_PRED_SSE2(vl_pred0_sse2, vl_pred0_c, _mm_set1_epi32((int)0xFF000000u))
+VL_PRED_SSE2(vl_pred2_sse2, vl_pred2_c, VL_LD(up + x))
+VL_PRED_SSE2(vl_pred3_sse2, vl_pred3_c, VL_LD(up + x + 1))
+VL_PRED_SSE2(vl_pred4_sse2, vl_pred4_c, VL_LD(up + x - 1))
+VL_PRED_SSE2(vl_pred8_sse2, vl_pred8_c,
+      vl_avg2_sse2(VL_LD(up + x - 1), VL_LD(up + x)))
+VL_PRED_SSE2(vl_pred9_sse2, vl_pred9_c,
+      vl_avg2_sse2(VL_LD(up + x), VL_LD(up + x + 1)))
+
+static void vl_add_green_sse2(uint32_t *p, int n)
+{
+   const __m128i ag = _mm_set1_epi32((int)0xFF00FF00u);
+   const __m128i rb = _mm_set1_epi32(0x00FF00FF);
+   const __m128i m8 = _mm_set1_epi32(0xFF);
+   int j = 0;
+   for (; j + 4 <= n; j += 4)
+   {
+      __m128i c  = VL_LD(p + j);
+      __m128i g  = _mm_and_si128(_mm_srli_epi32(c, 8), m8);
+      __m128i gg = _mm_or_si128(g, _mm_slli_epi32(g, 16));
+      _mm_storeu_si128((__m128i*)(p + j), _mm_or_si128(_mm_and_si128(c, ag),
+            _mm_and_si128(_mm_add_epi32(_mm_and_si128(c, rb), gg), rb)));
+   }
+   if (j < n)
+      vl_add_green_c(p + j, n - j);
+}
+
+/* The 8-bit by 8-bit signed products fit 16 bits, so each is one
+ * _mm_madd_epi16 of a sign-extended channel (low half of its 32-bit
+ * lane, high half zero) with the multiplier laid out the same way. */
+static void vl_color_xf_sse2(uint32_t *p, int n, uint32_t td)
+{
+   const __m128i lo16 = _mm_set1_epi32(0xFFFF);
+   const __m128i m8   = _mm_set1_epi32(0xFF);
+   const __m128i ag   = _mm_set1_epi32((int)0xFF00FF00u);
+   const __m128i g2r  = _mm_set1_epi32((int)(int8_t)(td & 0xFF) & 0xFFFF);
+   const __m128i g2b  = _mm_set1_epi32((int)(int8_t)((td >> 8) & 0xFF) & 0xFFFF);
+   const __m128i r2b  = _mm_set1_epi32((int)(int8_t)((td >> 16) & 0xFF) & 0xFFFF);
+   int j = 0;
+   for (; j + 4 <= n; j += 4)
+   {
+      __m128i c  = VL_LD(p + j);
+      __m128i g  = _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(c, 16), 24),
+            lo16);
+      __m128i r  = _mm_and_si128(_mm_srli_epi32(c, 16), m8);
+      __m128i b  = _mm_and_si128(c, m8);
+      __m128i rs;
+      r  = _mm_and_si128(_mm_add_epi32(r,
+               _mm_srai_epi32(_mm_madd_epi16(g2r, g), 5)), m8);
+      rs = _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(r, 24), 24), lo16);
+      b  = _mm_add_epi32(b, _mm_srai_epi32(_mm_madd_epi16(g2b, g), 5));
+      b  = _mm_and_si128(_mm_add_epi32(b,
+               _mm_srai_epi32(_mm_madd_epi16(r2b, rs), 5)), m8);
+      _mm_storeu_si128((__m128i*)(p + j), _mm_or_si128(_mm_and_si128(c, ag),
+            _mm_or_si128(_mm_slli_epi32(r, 16), b)));
+   }
+   if (j < n)
+      vl_color_xf_c(p + j, n - j, td);
+}
+
+static void vl_swap_px_sse2(uint32_t *p, size_t n)
+{
+   const __m128i ag = _mm_set1_epi32((int)0xFF00FF00u);
+   const __m128i m8 = _mm_set1_epi32(0xFF);
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      __m128i v = VL_LD(p + i);
+      _mm_storeu_si128((__m128i*)(p + i), _mm_or_si128(_mm_and_si128(v, ag),
+            _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, m8), 16),
+               _mm_and_si128(_mm_srli_epi32(v, 16), m8))));
+   }
+   if (i < n)
+      vl_swap_px(p + i, n - i);
+}
+#undef VL_LD
+#endif /* RWEBP_VL_SSE2 */
+
+#if defined(RWEBP_VL_NEON)
+#define VL_PRED_NEON(name, tail, expr) \
+static void name(uint32_t *cur, const uint32_t *up, int n) \
+{ \
+   int x = 0; \
+   for (; x + 4 <= n; x += 4) \
+   { \
+      uint8x16_t c = vreinterpretq_u8_u32(vld1q_u32(cur + x)); \
+      vst1q_u32(cur + x, vreinterpretq_u32_u8(vaddq_u8(c, (expr)))); \
+   } \
+   if (x < n) \
+      tail(cur + x, up + x, n - x); \
+}
+#define VL_LD(p) vreinterpretq_u8_u32(vld1q_u32(p))
+
+/* vhaddq_u8 truncates, matching px_avg2 */
+VL_PRED_NEON(vl_pred0_neon, vl_pred0_c,
+      vreinterpretq_u8_u32(vdupq_n_u32(0xFF000000u)))
+VL_PRED_NEON(vl_pred2_neon, vl_pred2_c, VL_LD(up + x))
+VL_PRED_NEON(vl_pred3_neon, vl_pred3_c, VL_LD(up + x + 1))
+VL_PRED_NEON(vl_pred4_neon, vl_pred4_c, VL_LD(up + x - 1))
+VL_PRED_NEON(vl_pred8_neon, vl_pred8_c,
+      vhaddq_u8(VL_LD(up + x - 1), VL_LD(up + x)))
+VL_PRED_NEON(vl_pred9_neon, vl_pred9_c,
+      vhaddq_u8(VL_LD(up + x), VL_LD(up + x + 1)))
+
+static void vl_add_green_neon(uint32_t *p, int n)
+{
+   int j = 0;
+   for (; j + 4 <= n; j += 4)
+   {
+      uint32x4_t c  = vld1q_u32(p + j);
+      uint32x4_t g  = vandq_u32(vshrq_n_u32(c, 8), vdupq_n_u32(0xFF));
+      uint32x4_t gg = vorrq_u32(g, vshlq_n_u32(g, 16));
+      vst1q_u32(p + j, vreinterpretq_u32_u8(vaddq_u8(
+            vreinterpretq_u8_u32(c), vreinterpretq_u8_u32(gg))));
+   }
+   if (j < n)
+      vl_add_green_c(p + j, n - j);
+}
+
+static void vl_color_xf_neon(uint32_t *p, int n, uint32_t td)
 {
-   switch (m)
+   const uint32x4_t m8  = vdupq_n_u32(0xFF);
+   const uint32x4_t ag  = vdupq_n_u32(0xFF00FF00u);
+   const int32x4_t  g2r = vdupq_n_s32((int8_t)(td & 0xFF));
+   const int32x4_t  g2b = vdupq_n_s32((int8_t)((td >> 8) & 0xFF));
+   const int32x4_t  r2b = vdupq_n_s32((int8_t)((td >> 16) & 0xFF));
+   int j = 0;
+   for (; j + 4 <= n; j += 4)
    {
-      case 0: return 0xFF000000u;
-      case 1: return L;
-      case 2: return T;
-      case 3: return TR;
-      case 4: return TL;
-      case 5: return px_avg2(px_avg2(L,TR),T);
-      case 6: return px_avg2(L,TL);
-      case 7: return px_avg2(L,T);
-      case 8: return px_avg2(TL,T);
-      case 9: return px_avg2(T,TR);
-      case 10: return px_avg2(px_avg2(L,TL),px_avg2(T,TR));
-      case 11: return px_select(TL,T,L);
-      case 12: return px_casf(L,T,TL);
-      case 13: return px_cash(px_avg2(L,T),TL);
-      default: return 0xFF000000u;
+      uint32x4_t c = vld1q_u32(p + j);
+      int32x4_t  g = vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(c), 16), 24);
+      int32x4_t  r = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(c, 16), m8));
+      int32x4_t  b = vreinterpretq_s32_u32(vandq_u32(c, m8));
+      int32x4_t  rs;
+      r  = vandq_s32(vaddq_s32(r, vshrq_n_s32(vmulq_s32(g2r, g), 5)),
+            vreinterpretq_s32_u32(m8));
+      rs = vshrq_n_s32(vshlq_n_s32(r, 24), 24);
+      b  = vaddq_s32(b, vshrq_n_s32(vmulq_s32(g2b, g), 5));
+      b  = vandq_s32(vaddq_s32(b, vshrq_n_s32(vmulq_s32(r2b, rs), 5)),
+            vreinterpretq_s32_u32(m8));
+      vst1q_u32(p + j, vorrq_u32(vandq_u32(c, ag), vorrq_u32(
+            vshlq_n_u32(vreinterpretq_u32_s32(r), 16),
+            vreinterpretq_u32_s32(b))));
    }
+   if (j < n)
+      vl_color_xf_c(p + j, n - j, td);
+}
+
+static void vl_swap_px_neon(uint32_t *p, size_t n)
+{
+   size_t i = 0;
+   for (; i + 16 <= n; i += 16)
+   {
+      uint8x16x4_t v = vld4q_u8((const uint8_t*)(p + i));
+      uint8x16_t   t = v.val[0];
+      v.val[0] = v.val[2];
+      v.val[2] = t;
+      vst4q_u8((uint8_t*)(p + i), v);
+   }
+   if (i < n)
+      vl_swap_px(p + i, n - i);
+}
+#undef VL_LD
+#endif /* RWEBP_VL_NEON */
+
+/* simd is a RETRO_SIMD_* mask, normally cpu_features_get(); 0 selects
+ * the scalar kernels. Modes 14 and 15 predict like mode 0. */
+static void vl_dsp_init(vl_dsp *d, uint64_t simd)
+{
+   d->pred[0]  = vl_pred0_c;   d->pred[1]  = vl_pred1_c;
+   d->pred[2]  = vl_pred2_c;   d->pred[3]  = vl_pred3_c;
+   d->pred[4]  = vl_pred4_c;   d->pred[5]  = vl_pred5_c;
+   d->pred[6]  = vl_pred6_c;   d->pred[7]  = vl_pred7_c;
+   d->pred[8]  = vl_pred8_c;   d->pred[9]  = vl_pred9_c;
+   d->pred[10] = vl_pred10_c;  d->pred[11] = vl_pred11_c;
+   d->pred[12] = vl_pred12_c;  d->pred[13] = vl_pred13_c;
+   d->add_green = vl_add_green_c;
+   d->color_xf  = vl_color_xf_c;
+   d->swap_rb   = vl_swap_px;
+#if defined(RWEBP_VL_SSE2)
+   if (simd & RETRO_SIMD_SSE2)
+   {
+      d->pred[0]   = vl_pred0_sse2;
+      d->pred[2]   = vl_pred2_sse2;
+      d->pred[3]   = vl_pred3_sse2;
+      d->pred[4]   = vl_pred4_sse2;
+      d->pred[8]   = vl_pred8_sse2;
+      d->pred[9]   = vl_pred9_sse2;
+      d->add_green = vl_add_green_sse2;
+      d->color_xf  = vl_color_xf_sse2;
+      d->swap_rb   = vl_swap_px_sse2;
+   }
+#endif
+#if defined(RWEBP_VL_NEON)
+   if (simd & RETRO_SIMD_NEON)
+   {
+      d->pred[0]   = vl_pred0_neon;
+      d->pred[2]   = vl_pred2_neon;
+      d->pred[3]   = vl_pred3_neon;
+      d->pred[4]   = vl_pred4_neon;
+      d->pred[8]   = vl_pred8_neon;
+      d->pred[9]   = vl_pred9_neon;
+      d->add_green = vl_add_green_neon;
+      d->color_xf  = vl_color_xf_neon;
+      d->swap_rb   = vl_swap_px_neon;
+   }
+#endif
+   d->pred[14] = d->pred[15] = d->pred[0];
 }
 
 /* Distance mapping, per libwebp PlaneCodeToDistance: the decoded distance
@@ -757,20 +1089,9 @@ typedef struct vlbd
    uint32_t *xout;  /* CIDX expansion target */
    int swap_rb;     /* emit memory R,G,B,A words instead of ARGB */
    int swrow;       /* final-buffer rows already channel-swapped */
+   vl_dsp dsp;      /* inverse-transform kernels */
 } vlbd;
 
-/* Swap the R and B channel bytes of n words in place (ARGB <-> the
- * memory R,G,B,A layout). */
-static void vl_swap_px(uint32_t *p, size_t n)
-{
-   size_t i;
-   for (i = 0; i < n; i++)
-   {
-      uint32_t v = p[i];
-      p[i] = (v & 0xFF00FF00u) | ((v & 0xFF) << 16) | ((v >> 16) & 0xFF);
-   }
-}
-
 static void vlbd_abort(vlbd *s)
 {
    int i;
@@ -789,6 +1110,7 @@ static int vlbd_begin(vlbd *s, vbr *br2, uint32_t width, uint32_t height)
 
    memset(s, 0, sizeof(*s));
    if (width > 16384 || height > 16384) return -1;
+   vl_dsp_init(&s->dsp, RWEBP_CPU_FEATURES());
    xf = s->xf;
    cw = (int)width; ch = (int)height;
 
@@ -887,7 +1209,7 @@ static int vlbd_xform_rows(vlbd *s, int nrows)
       {
          int r1s = s->swrow + nrows;
          if (r1s > (int)height) r1s = (int)height;
-         vl_swap_px(s->st.pix + (size_t)s->swrow * width,
+         s->dsp.swap_rb(s->st.pix + (size_t)s->swrow * width,
                (size_t)(r1s - s->swrow) * width);
          s->swrow = r1s;
          return (s->swrow < (int)height) ? 1 : 0;
@@ -947,76 +1269,56 @@ static int vlbd_xform_rows(vlbd *s, int nrows)
             break;
          }
          case XF_SUBG:
-         {
-            int j, j0 = r0 * cw, j1 = r1 * cw;
-            for (j = j0; j < j1; j++)
-            {
-               uint32_t c = pix[j];
-               uint32_t g = (c >> 8) & 0xFF;
-               uint32_t r = (((c >> 16) & 0xFF) + g) & 0xFF;
-               uint32_t b2 = ((c & 0xFF) + g) & 0xFF;
-               pix[j] = (c & 0xFF00FF00u) | (r << 16) | b2;
-            }
+            s->dsp.add_green(pix + (size_t)r0 * cw, (r1 - r0) * cw);
             break;
-         }
          case XF_PRED:
          {
-            int bw = x->dw;
+            /* Row by row, in runs of pixels sharing a block (and so a
+             * mode); the first row predicts from L and the first
+             * column from T, whatever the block says. */
+            int bw = x->dw, bs = 1 << x->bits;
             uint32_t *td = x->data;
             int px2, py2;
             for (py2 = r0; py2 < r1; py2++)
             {
-               for (px2 = 0; px2 < cw; px2++)
+               uint32_t *cur = pix + (size_t)py2 * cw;
+               const uint32_t *up = cur - cw;
+               const uint32_t *modes = td + (py2 >> x->bits) * bw;
+               if (py2 == 0)
+               {
+                  cur[0] = px_add(cur[0], 0xFF000000u);
+                  s->dsp.pred[1](cur + 1, NULL, cw - 1);
+                  continue;
+               }
+               s->dsp.pred[2](cur, up, 1);
+               for (px2 = 1; px2 < cw; )
                {
-                  uint32_t L  = (px2 > 0)            ? pix[py2*cw+px2-1]     : 0xFF000000u;
-                  uint32_t T  = (py2 > 0)             ? pix[(py2-1)*cw+px2]   : 0xFF000000u;
-                  uint32_t TL = (px2>0 && py2>0)      ? pix[(py2-1)*cw+px2-1] : 0xFF000000u;
-                  /* TR at the last column wraps to the current row's
-                   * first pixel (libwebp reads upper[x+1] in the flat
-                   * buffer, which is contiguous with the next row). */
-                  uint32_t TR = (py2 > 0)             ? pix[(py2-1)*cw+px2+1] : 0xFF000000u;
-                  int bx = px2 >> x->bits, by = py2 >> x->bits;
-                  int mode;
+                  int end = (px2 & ~(bs - 1)) + bs;
+                  int bx  = px2 >> x->bits;
+                  if (end > cw) end = cw;
                   if (bx >= bw) bx = bw - 1;
-                  mode = (td[by * bw + bx] >> 8) & 0xF;
-                  if (px2 == 0 && py2 == 0) mode = 0;
-                  else if (px2 == 0) mode = 2;
-                  else if (py2 == 0) mode = 1;
-                  pix[py2*cw+px2] = px_add(pix[py2*cw+px2], px_predict(mode, L, T, TL, TR));
+                  s->dsp.pred[(modes[bx] >> 8) & 0xF](cur + px2, up + px2,
+                        end - px2);
+                  px2 = end;
                }
             }
             break;
          }
          case XF_CCOL:
          {
-            int bw = x->dw;
+            int bw = x->dw, bs = 1 << x->bits;
             uint32_t *td = x->data;
             int px2, py2;
             for (py2 = r0; py2 < r1; py2++)
             {
-               for (px2 = 0; px2 < cw; px2++)
+               uint32_t *cur = pix + (size_t)py2 * cw;
+               const uint32_t *blk = td + (py2 >> x->bits) * bw;
+               for (px2 = 0; px2 < cw; px2 += bs)
                {
-                  int bx = px2 >> x->bits, by = py2 >> x->bits;
-                  uint32_t td2, c2;
-                  int8_t g2r, g2b, r2b;
-                  int r, g, b2;
+                  int bx = px2 >> x->bits;
                   if (bx >= bw) bx = bw - 1;
-                  td2 = td[by * bw + bx];
-                  /* libwebp ColorCodeToMultipliers: green_to_red in the
-                   * BLUE byte, green_to_blue in GREEN, red_to_blue in RED. */
-                  g2r = (int8_t)(td2 & 0xFF);
-                  g2b = (int8_t)((td2 >>  8) & 0xFF);
-                  r2b = (int8_t)((td2 >> 16) & 0xFF);
-                  c2 = pix[py2 * cw + px2];
-                  /* Channel values are SIGNED in the color transform
-                   * (libwebp ColorTransformDelta takes int8_t). */
-                  g = (int)(int8_t)((c2 >> 8) & 0xFF);
-                  r = (int)((c2 >> 16) & 0xFF);
-                  b2 = (int)(c2 & 0xFF);
-                  r = (r + ((g2r * g) >> 5)) & 0xFF;
-                  b2 = b2 + ((g2b * g) >> 5);
-                  b2 = (b2 + ((r2b * (int)(int8_t)r) >> 5)) & 0xFF;
-                  pix[py2*cw+px2] = (c2 & 0xFF00FF00u) | ((uint32_t)r << 16) | (uint32_t)b2;
+                  s->dsp.color_xf(cur + px2, cw - px2 < bs ? cw - px2 : bs,
+                        blk[bx]);
                }
             }
             break;
@@ -1047,7 +1349,7 @@ static int vlbd_xform_rows(vlbd *s, int nrows)
       if (safe > s->swrow)
       {
          uint32_t *fin = s->xout ? s->xout : s->st.pix;
-         vl_swap_px(fin + (size_t)s->swrow * width,
+         s->dsp.swap_rb(fin + (size_t)s->swrow * width,
                (size_t)(safe - s->swrow) * width);
          s->swrow = safe;
       }
@@ -62,7 +62,8 @@ enum
 {
    RDEFLATE_PROCESS_ERROR = -2,
    RDEFLATE_PROCESS_END   =  1,
-   /* stop-at-block: a deflate block just ended and another follows */
+   /* stop-at-block: a deflate block just ended and another follows; when
+    * compressing, a sync point asked for by rdeflate_flush() is out */
    RDEFLATE_PROCESS_BLOCK = 2,
    RDEFLATE_PROCESS_NEXT  =  0
 };
@@ -122,6 +123,12 @@ void  rdeflate_set_out(void *stream, uint8_t *out, size_t out_size);
  * is consumed, so the final block and trailer can be emitted. */
 void  rdeflate_finish(void *stream);
 
+/* Emit everything supplied so far, ending on a byte boundary with an empty
+ * stored block (zlib's Z_SYNC_FLUSH), and keep the stream open.  process()
+ * returns RDEFLATE_PROCESS_BLOCK once all of it is out.  A raw stream cut
+ * this way can have another raw stream's blocks appended to it. */
+void  rdeflate_flush(void *stream);
+
 int   rdeflate_process(void *stream, size_t *read, size_t *wrote);
 
 RETRO_END_DECLS
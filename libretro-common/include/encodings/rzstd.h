@@ -38,10 +38,10 @@
  * Encoding is minimal: it produces frames any conforming decoder reads,
  * but makes no attempt to match the reference implementation's ratio or
  * its output byte-for-byte. There is no optimal parse, no long-distance
- * matching and no dictionary support. This is sized for the one caller
- * that compresses -- input replay payloads -- where the input is small,
- * the work happens off the critical path, and a few percent of ratio is
- * not worth an order of magnitude more code.
+ * matching and no dictionary support. This is sized for the callers
+ * that compress -- input replay payloads and rewind buffer entries --
+ * where each input is small, and a few percent of ratio is not worth
+ * an order of magnitude more code.
  *
  * Both directions are non-blocking and resumable in the style of
  * <encodings/deflate.h>, with a one-shot entry point for the callers
@@ -52,8 +52,13 @@
  *   input/bsv/bsvmovie.c      compresses at level 3 and decompresses,
  *                             both one-shot, and needs a bound on the
  *                             compressed size before it allocates.
- *                             This is the only caller that compresses,
- *                             and the reason the encoder exists at all.
+ *                             This was the first caller that
+ *                             compressed, and the reason the encoder
+ *                             exists at all.
+ *   state_manager.c           compresses each rewind buffer entry at
+ *                             level 1, one-shot, into a buffer sized by
+ *                             the bound, and decodes it back with the
+ *                             exact frame length.
  *   cheevos/cheevos_rvz.c     decompresses one-shot, and reads a
  *                             frame's declared content size to size
  *                             its buffer.
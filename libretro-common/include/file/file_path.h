@@ -685,6 +685,19 @@ bool path_is_valid(const char *path);
 
 int64_t path_get_size(const char *path);
 
+/**
+ * path_get_size_mtime:
+ * @path               : path
+ * @size               : receives the size in bytes
+ * @mtime              : receives the modification time, in seconds
+ *
+ * For telling whether a file has changed since it was last seen.
+ *
+ * @return true if @path is a regular file and the platform can say
+ * both; otherwise false, with @size and @mtime set to 0.
+ */
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime);
+
 bool is_path_accessible_using_standard_io(const char *path);
 
 RETRO_END_DECLS
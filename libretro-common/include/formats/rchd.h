@@ -494,6 +494,25 @@ size_t rchd_read_progress(const rchd_t *chd);
  */
 int rchd_read_hunk_begin(rchd_t *chd, uint32_t hunk, void *dst);
 
+/**
+ * rchd_set_cache_hunks:
+ * @chd        : decoder, open or not, with no read in progress
+ * @hunks      : decoded hunks to keep, at least 1
+ *
+ * Sizes the cache of decoded hunks reads are served from. One is the
+ * default, which is enough for a reader that moves forward; a reader
+ * that jumps about -- a CD core seeking between a file table and the
+ * data it names -- otherwise decompresses the same hunks over and
+ * over. Each slot costs hunk_bytes, taken when the slot is first
+ * filled, and a full cache replaces the hunk used least recently.
+ *
+ * Resizing empties the cache.
+ *
+ * Returns: RCHD_OK, RCHD_ERROR_PARAM if @hunks is zero, or
+ * RCHD_ERROR_STATE if a read is in progress.
+ */
+int rchd_set_cache_hunks(rchd_t *chd, uint32_t hunks);
+
 /* -------- pipelining -------- */
 
 /**
@@ -61,6 +61,13 @@ size_t rmpeg1_video_write(rmpeg1_video_t *v, const uint8_t *data, size_t len);
  * more input is needed. The frame's planes stay valid until the next call. */
 int rmpeg1_video_decode(rmpeg1_video_t *v, rmpeg1_video_frame_t *out);
 
+/* Convert a decoded frame to width x height 0xFFRRGGBB pixels, rows pitch
+ * bytes apart. BT.601 studio-range coefficients, which is what 11172-2
+ * content is mastered with; each chroma sample covers its 2x2 luma block.
+ * Vectorised where the CPU allows, with identical output either way. */
+void rmpeg1_video_frame_to_argb(const rmpeg1_video_frame_t *f,
+      uint32_t *dst, size_t pitch);
+
 /* Signal that no more input is coming. A picture is normally known to be
  * complete only when the following start code arrives, so without this the
  * last picture of a stream is never emitted -- streams do not always end
@@ -140,6 +140,21 @@ bool rpng_save_image_stream_fmt(const uint8_t *data,
       intfstream_t *intf_s, unsigned width, unsigned height, signed pitch,
       enum rpng_pixfmt fmt, const struct rpng_hdr_metadata *hdr);
 
+/* Most bands rpng_save_image_stream_fmt_threaded will cut an image into */
+#define RPNG_MAX_THREADS 8
+
+/* rpng_save_image_stream_fmt, with the rows cut into up to `threads`
+ * horizontal bands that are filtered and deflated in parallel, one
+ * IDAT chunk per band.  The result is an ordinary PNG holding a single
+ * zlib stream, a little larger than the serial encoder's since matches
+ * do not cross bands.  Bands are at least 64 rows; an image too short
+ * for two, a `threads` below 2, or a build without HAVE_THREADS takes
+ * the serial path.  Peak scratch memory is the compressed image. */
+bool rpng_save_image_stream_fmt_threaded(const uint8_t *data,
+      intfstream_t *intf_s, unsigned width, unsigned height, signed pitch,
+      enum rpng_pixfmt fmt, const struct rpng_hdr_metadata *hdr,
+      unsigned threads);
+
 /* Bytes-per-pixel variant of rpng_save_image_stream_fmt, kept for
  * callers that predate the format enum: 3 = BGR24, 4 = ARGB32,
  * 6 = RGB48.  RGBA32 is only reachable through the fmt entry point. */
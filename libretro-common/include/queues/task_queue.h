@@ -53,6 +53,29 @@ enum task_style
    TASK_STYLE_NEGATIVE
 };
 
+/**
+ * Scheduling class of a task on the threaded queue.
+ * A free worker always takes a runnable latency task before a bulk one;
+ * within a class, tasks take turns as they always have.
+ * The unthreaded queue runs every task once per update regardless.
+ */
+enum task_priority
+{
+   /** Background work: scans, downloads, decompression. The default. */
+   TASK_PRIORITY_BULK = 0,
+   /** Work the user is waiting on: savestates, screenshots, image decode. */
+   TASK_PRIORITY_LATENCY,
+
+   TASK_PRIORITY_COUNT
+};
+
+/** \c retro_task::affinity for a task that any worker may run.
+ * Zero, so that tasks allocated with calloc() get it. */
+#define TASK_AFFINITY_ANY 0
+
+/** Upper bound for \c task_queue_set_workers. */
+#define TASK_QUEUE_MAX_WORKERS 8
+
 typedef struct retro_task retro_task_t;
 
 /** @copydoc retro_task::callback */
@@ -287,7 +310,39 @@ struct retro_task
    enum task_type type;
    enum task_style style;
 
+   /**
+    * Scheduling class on the threaded queue.
+    * Set by the caller; defaults to \c TASK_PRIORITY_BULK.
+    * @see task_priority
+    */
+   enum task_priority priority;
+
+   /**
+    * @private When this task became runnable, for the wait-time counters;
+    * 0 once its handler has first been called.
+    * Managed by the task system.
+    */
+   retro_time_t queued;
+
    uint8_t flags;
+
+   /**
+    * Which worker of the threaded queue runs this task.
+    * \c TASK_AFFINITY_ANY (the default) lets whichever worker is free
+    * take it on each handler call. Any other value n binds it to worker
+    * n - 1 (modulo the pool size), so tasks sharing a value never run at
+    * the same time and a task never changes threads - for tasks written when
+    * every task ran on one thread, which share state without locking.
+    * Set by the caller before pushing. Ignored by the unthreaded queue,
+    * and by the GCD queue, which has no fixed workers.
+    */
+   int8_t affinity;
+
+   /**
+    * @private Worker currently inside this task's handler, or -1.
+    * Managed by the task system.
+    */
+   int8_t worker;
 };
 
 /**
@@ -596,6 +651,52 @@ void task_queue_unset_threaded(void);
  */
 bool task_queue_is_threaded(void);
 
+/**
+ * Sets the number of worker threads the threaded queue runs.
+ *
+ * Takes effect at the next \c task_queue_check,
+ * which restarts the workers if the count changed.
+ * Running tasks carry over, as with \c task_queue_set_threaded.
+ *
+ * @param workers Pool size, clamped to 1..\c TASK_QUEUE_MAX_WORKERS.
+ * The default of 1 runs tasks one at a time, as the queue always has.
+ */
+void task_queue_set_workers(unsigned workers);
+
+/**
+ * Counters for spotting a starved or backed-up queue.
+ * Indexed by \c task_priority where an array.
+ * @see task_queue_get_stats
+ */
+typedef struct task_queue_stats
+{
+   /** Tasks pushed and not yet finished, running ones included. */
+   unsigned depth[TASK_PRIORITY_COUNT];
+
+   /** Tasks whose handler has been called at least once. */
+   uint64_t started[TASK_PRIORITY_COUNT];
+
+   /**
+    * Time from becoming runnable (pushed, or \c retro_task::when passed)
+    * to the first handler call, in microseconds: summed over \c started,
+    * and the worst seen.
+    */
+   retro_time_t wait_total[TASK_PRIORITY_COUNT];
+   retro_time_t wait_max[TASK_PRIORITY_COUNT];
+
+   /** Worker threads running; 0 when the queue is not threaded. */
+   unsigned workers;
+} task_queue_stats_t;
+
+/**
+ * Fills \c stats with the queue's current depth
+ * and its wait-time counters since startup.
+ * Thread-safe if the task queue is threaded.
+ *
+ * @param stats Receives the counters. Must not be \c NULL.
+ */
+void task_queue_get_stats(task_queue_stats_t *stats);
+
 /**
  * Calls the function given in \c find_data for each task
  * until it returns \c true for one of them,
@@ -723,9 +824,15 @@ void task_queue_deinit(void);
  * Must be called before any other task_queue_* function,
  * and must only be called from the main thread.
  *
- * @param threaded \c true if tasks should run on a separate thread,
+ * @param threaded \c true if tasks should run on separate threads,
  * \c false if they should remain on the calling thread.
- * All tasks run in sequence on a single thread.
+ * Threaded tasks run on a pool of workers sized by
+ * \c task_queue_set_workers, one worker by default,
+ * in which case all tasks run in sequence on a single thread.
+ * With more, two tasks may run at the same time even if they share
+ * a handler; only one task is never run on two workers at once.
+ * Tasks that share state without locking need a common
+ * \c retro_task::affinity.
  * If you want to scale a task to multiple threads,
  * you must do so within the task itself.
  * @param msg_push The task system will call this function to output messages.
@@ -0,0 +1,171 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (cache_file.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_CACHE_FILE_H
+#define __LIBRETRO_SDK_CACHE_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Building and parsing small binary cache files.
+ *
+ * A cache file only saves work that can be done again: a file that is
+ * missing, truncated or otherwise fails to parse must be treated as
+ * empty, which makes the caller slower but never wrong.  Integers are
+ * little endian; a string is a u16 length followed by that many bytes.
+ *
+ * Errors are sticky on both sides.  After a failed allocation the
+ * writer ignores further puts and cache_file_write() refuses it; after
+ * a read past the end the reader returns zeroes and NULLs, so a parser
+ * may read a whole record and check \c error once. */
+
+typedef struct cache_file_writer
+{
+   uint8_t *data;
+   size_t len;
+   size_t cap;
+   bool error;
+} cache_file_writer_t;
+
+typedef struct cache_file_reader
+{
+   const uint8_t *ptr;
+   const uint8_t *end;
+   bool error;
+} cache_file_reader_t;
+
+#define CACHE_FILE_STR_MAX 0xFFFF
+
+/**
+ * Appends bytes to a writer, growing its buffer as needed.
+ * A zeroed writer is empty and ready for use.
+ *
+ * @param w The writer.
+ * @param data The bytes to append.
+ * @param len Number of bytes in \c data.
+ */
+void cache_file_put(cache_file_writer_t *w, const void *data, size_t len);
+
+void cache_file_put8(cache_file_writer_t *w, unsigned v);
+
+void cache_file_put16(cache_file_writer_t *w, unsigned v);
+
+void cache_file_put32(cache_file_writer_t *w, uint32_t v);
+
+void cache_file_put64(cache_file_writer_t *w, uint64_t v);
+
+/**
+ * Appends \c v as a LEB128 varint: seven bits per byte, low bits first,
+ * with the top bit set on every byte but the last.
+ */
+void cache_file_put_varint(cache_file_writer_t *w, uint32_t v);
+
+/**
+ * Appends a string as a u16 length and its bytes.
+ *
+ * @param w The writer.
+ * @param s The string; \c NULL is written as an empty one.
+ * @return \c false if \c s is longer than \c CACHE_FILE_STR_MAX,
+ * in which case nothing is appended.  A caller writing a record
+ * should drop the whole record rather than store a cut string;
+ * see cache_file_writer_t::len.
+ */
+bool cache_file_put_str(cache_file_writer_t *w, const char *s);
+
+/**
+ * Overwrites the u32 at \c offset, such as a record count that was
+ * not known when the header was written.  Does nothing if the bytes
+ * are not there.
+ */
+void cache_file_patch32(cache_file_writer_t *w, size_t offset, uint32_t v);
+
+/**
+ * Writes the contents of a writer to \c path.
+ *
+ * The data is written to a temporary beside \c path and then moved over
+ * it with filestream_replace(), so that an interrupted write leaves the
+ * previous cache rather than a torn one.
+ *
+ * @param w The writer.
+ * @param path The cache file.
+ * @return \c true if \c path now holds the data; \c false if the writer
+ * ran out of memory or the file could not be written, in which case
+ * \c path is unchanged.
+ */
+bool cache_file_write(const cache_file_writer_t *w, const char *path);
+
+/**
+ * Frees a writer's buffer and empties it.
+ */
+void cache_file_writer_free(cache_file_writer_t *w);
+
+void cache_file_reader_init(cache_file_reader_t *r,
+      const void *data, size_t len);
+
+/**
+ * Consumes \c len bytes.
+ *
+ * @return Pointer to them, or \c NULL if fewer remain, in which case
+ * the reader is put in error and moved to the end.
+ */
+const uint8_t *cache_file_get(cache_file_reader_t *r, size_t len);
+
+unsigned cache_file_get8(cache_file_reader_t *r);
+
+unsigned cache_file_get16(cache_file_reader_t *r);
+
+uint32_t cache_file_get32(cache_file_reader_t *r);
+
+uint64_t cache_file_get64(cache_file_reader_t *r);
+
+/**
+ * Reads a varint written by cache_file_put_varint().  One longer than
+ * five bytes puts the reader in error.
+ */
+uint32_t cache_file_get_varint(cache_file_reader_t *r);
+
+/**
+ * Reads a string written by cache_file_put_str() in place.
+ *
+ * @param r The reader.
+ * @param len Set to the length of the string.
+ * @return Pointer to its bytes, which are not NUL terminated,
+ * or \c NULL if the data is cut short.
+ */
+const char *cache_file_get_str(cache_file_reader_t *r, size_t *len);
+
+/**
+ * Reads a string written by cache_file_put_str() into a new buffer.
+ *
+ * @return The string, "" for an empty one, to be freed by the caller;
+ * or \c NULL if the data is cut short or out of memory.
+ */
+char *cache_file_get_strdup(cache_file_reader_t *r);
+
+RETRO_END_DECLS
+
+#endif
@@ -27,6 +27,7 @@
 #include <stddef.h>
 
 #include <retro_common_api.h>
+#include <boolean.h>
 
 RETRO_BEGIN_DECLS
 
@@ -39,10 +40,30 @@ typedef struct chdstream chdstream_t;
 /* Primary (largest) data track, used for CRC identification purposes */
 #define CHDSTREAM_TRACK_PRIMARY (-3)
 
+/* Decoded hunks a stream keeps, so seeking back and forth between a few
+ * places on the disc does not decompress the same hunks again */
+#define CHDSTREAM_CACHE_HUNKS 16
+/* Hunks decoded on worker threads ahead of a stream read in order */
+#define CHDSTREAM_READAHEAD_HUNKS 4
+
 chdstream_t *chdstream_open(const char *path, int32_t track);
 
 void chdstream_close(chdstream_t *stream);
 
+/**
+ * chdstream_set_cache:
+ * @cache_hunks          : decoded hunks to keep
+ * @readahead_hunks      : hunks to decode ahead of a sequential reader,
+ *                         0 for none
+ *
+ * Overrides CHDSTREAM_CACHE_HUNKS and CHDSTREAM_READAHEAD_HUNKS.  Reading
+ * ahead needs HAVE_THREADS and is left off without it.
+ *
+ * Returns: false if the reader this was built against has no such cache.
+ **/
+bool chdstream_set_cache(chdstream_t *stream, uint32_t cache_hunks,
+      uint32_t readahead_hunks);
+
 ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes);
 
 int chdstream_getc(chdstream_t *stream);
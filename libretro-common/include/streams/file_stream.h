@@ -343,6 +343,18 @@ int filestream_error(RFILE *stream);
  */
 int filestream_flush(RFILE *stream);
 
+/**
+ * Flushes pending writes, then asks the operating system to commit
+ * the file to storage, so that it survives a crash or power loss.
+ * Where there is no way to ask, or the file goes through a VFS
+ * interface provided by the frontend, this is only a flush.
+ *
+ * @param stream The file to sync.
+ * @return 0 if successful, or -1 if there was an error.
+ * @see filestream_flush
+ */
+int filestream_sync(RFILE *stream);
+
 /**
  * Deletes the file at the given path.
  * If the file is open by any process,
@@ -369,6 +381,22 @@ int filestream_delete(const char *path);
  */
 int filestream_rename(const char *old_path, const char *new_path);
 
+/**
+ * Moves a completed file over another, replacing it.
+ *
+ * Intended for writing a file to a temporary beside its destination
+ * and then moving it into place.  A plain rename where that replaces;
+ * otherwise the destination is moved aside first and restored if the
+ * move fails, so a failure never leaves the destination missing.
+ *
+ * @param from Path to the new file.
+ * @param to The file to replace, which need not exist.
+ * @return 0 if \c from now sits at \c to,
+ * or -1 if there was an error, in which case \c to is unchanged.
+ * @see filestream_rename
+ */
+int filestream_replace(const char *from, const char *to);
+
 /**
  * Copies a file to a new location.
  *
@@ -33,7 +33,8 @@
 RETRO_BEGIN_DECLS
 
 /* Rudimentary interface for streaming data to/from a
- * zlib-compressed chunk-based RZIP archive file.
+ * zlib- or Zstandard-compressed chunk-based RZIP
+ * archive file.
  * 
  * This is somewhat less efficient than using regular
  * gzip code, but this is by design - the intention here
@@ -62,11 +63,20 @@ RETRO_BEGIN_DECLS
  * <size of next compressed chunk>: 4 bytes, little endian order
  *                                  - size on-disk of next compressed data
  *                                    chunk, in bytes
- * <next compressed chunk>:         n bytes of zlib compressed data
+ * <next compressed chunk>:         n bytes of compressed data
  * ...
  * <size of next compressed chunk> : repeated until end of file
  * <next compressed chunk>         :
  * 
+ * The file format version selects the chunk codec:
+ * - 1: each chunk is a complete zlib stream
+ * - 2: each chunk is one Zstandard frame
+ * Version 2 is written when built with HAVE_ZSTD,
+ * version 1 otherwise. Version 1 is always read;
+ * version 2 is read with either HAVE_ZSTD or
+ * HAVE_RZSTD, and without both fails to open rather
+ * than being mistaken for uncompressed data.
+ * 
  */
 
 /* Prevent direct access to rzipstream_t members */
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include <queues/task_queue.h>
 
@@ -78,6 +79,19 @@ static task_queue_t tasks_retiring          = {NULL, NULL};
 
 static struct retro_task_impl *impl_current = NULL;
 static bool task_threaded_enable            = false;
+/* Worker pool size requested through task_queue_set_workers() */
+static unsigned task_worker_count           = 1;
+
+/* Wait-time counters, per task_priority. Under running_lock when the
+ * queue is threaded, on the updating thread otherwise. */
+static uint64_t     task_started[TASK_PRIORITY_COUNT];
+static retro_time_t task_wait_total[TASK_PRIORITY_COUNT];
+static retro_time_t task_wait_max[TASK_PRIORITY_COUNT];
+
+/* A priority the caller set out of range counts as bulk */
+#define TASK_PRIORITY_INDEX(t) \
+   (((t)->priority == TASK_PRIORITY_LATENCY) \
+    ? TASK_PRIORITY_LATENCY : TASK_PRIORITY_BULK)
 
 #ifdef HAVE_THREADS
 static uintptr_t main_thread_id             = 0;
@@ -86,7 +100,9 @@ static slock_t *finished_lock               = NULL;
 static slock_t *property_lock               = NULL;
 static slock_t *queue_lock                  = NULL;
 static scond_t *worker_cond                 = NULL;
-static sthread_t *worker_thread             = NULL;
+static sthread_t *worker_threads[TASK_QUEUE_MAX_WORKERS];
+/* Workers actually running; 0 when not threaded */
+static unsigned worker_count                = 0;
 static bool worker_continue                 = true;
 /* use running_lock when touching it */
 #endif
@@ -241,6 +257,26 @@ static void retro_task_internal_retire_cleanup(retro_task_t *task)
 #endif
 }
 
+/* Records how long a task waited for its first handler call */
+static void task_queue_note_start(retro_task_t *task)
+{
+   if (task->queued)
+   {
+      unsigned     prio = TASK_PRIORITY_INDEX(task);
+      retro_time_t wait = cpu_features_get_time_usec() - task->queued;
+
+      if (wait < 0)
+         wait = 0;
+
+      task_started[prio]++;
+      task_wait_total[prio] += wait;
+      if (wait > task_wait_max[prio])
+         task_wait_max[prio]   = wait;
+
+      task->queued = 0;
+   }
+}
+
 static void retro_task_internal_gather(void)
 {
    retro_task_t *task = NULL;
@@ -296,6 +332,8 @@ static void retro_task_regular_gather(void)
 
       if (!task->when || task->when < cpu_features_get_time_usec())
       {
+         task_queue_note_start(task);
+
          /* Time the handler only when someone is listening: with no
           * callback registered this costs nothing at all. */
          if (task_slow_handler_cb)
@@ -468,7 +506,9 @@ static void retro_task_threaded_push_running(retro_task_t *task)
    slock_lock(running_lock);
    slock_lock(queue_lock);
    task_queue_put(&tasks_running, task);
-   scond_signal(worker_cond);
+   /* Workers differ in which tasks they may take, so a single wakeup
+    * could land on one that cannot run this task. */
+   scond_broadcast(worker_cond);
    slock_unlock(queue_lock);
    slock_unlock(running_lock);
 }
@@ -688,13 +728,70 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
    slock_unlock(running_lock);
 }
 
+/* 'running_lock' must be held for the duration of this function.
+ *
+ * Picks the task worker 'index' should run next: the first runnable
+ * latency task, else the first runnable bulk task, skipping tasks
+ * another worker is inside of and tasks bound to another worker. The
+ * queue is sorted by 'when', so the first task not yet due ends the
+ * scan; 'delay' then receives how long until it is. */
+static retro_task_t *task_queue_pick(unsigned index, retro_time_t *delay)
+{
+   retro_task_t *task = NULL;
+   retro_task_t *bulk = NULL;
+   retro_time_t now   = 0;
+
+   *delay             = 0;
+
+   for (task = tasks_running.front; task; task = task->next)
+   {
+      if (task->worker >= 0)
+         continue;
+      if (     task->affinity > TASK_AFFINITY_ANY
+            && (unsigned)(task->affinity - 1) % worker_count != index)
+         continue;
+
+      if (task->when)
+      {
+         if (!now)
+            now = cpu_features_get_time_usec();
+         /* allow half a millisecond for context switching */
+         if (task->when - now - 500 > 0)
+         {
+            *delay = task->when - now - 500;
+            break;
+         }
+      }
+
+      if (task->priority == TASK_PRIORITY_LATENCY)
+         return task;
+      if (!bulk)
+         bulk = task;
+   }
+
+   if (bulk)
+      *delay = 0;
+
+   return bulk;
+}
+
 static void threaded_worker(void *userdata)
 {
-   sthread_setname("ra-task");
+   unsigned index = (unsigned)(uintptr_t)userdata;
+
+   if (index)
+   {
+      char name[24];
+      snprintf(name, sizeof(name), "ra-task-%u", index);
+      sthread_setname(name);
+   }
+   else
+      sthread_setname("ra-task");
 
    for (;;)
    {
       retro_task_t *task  = NULL;
+      retro_time_t delay  = 0;
       bool       finished = false;
 
       slock_lock(running_lock);
@@ -705,25 +802,21 @@ static void threaded_worker(void *userdata)
          break; /* should we keep running until all tasks finished? */
       }
 
-      /* Get first task to run */
-      if (!(task = tasks_running.front))
+      /* Get next task to run */
+      if (!(task = task_queue_pick(index, &delay)))
       {
-         scond_wait(worker_cond, running_lock);
+         if (delay > 0)
+            scond_wait_timeout(worker_cond, running_lock, delay);
+         else
+            scond_wait(worker_cond, running_lock);
          slock_unlock(running_lock);
          continue;
       }
 
-      if (task->when)
-      {
-         retro_time_t now   = cpu_features_get_time_usec();
-         retro_time_t delay = task->when - now - 500; /* allow half a millisecond for context switching */
-         if (delay > 0)
-         {
-            scond_wait_timeout(worker_cond, running_lock, delay);
-            slock_unlock(running_lock);
-            continue;
-         }
-      }
+      /* Claim it so no other worker runs this task meanwhile.  Other
+       * tasks with the same handler still may; see affinity. */
+      task->worker = (int8_t)index;
+      task_queue_note_start(task);
 
       slock_unlock(running_lock);
       task->handler(task);
@@ -748,13 +841,19 @@ static void threaded_worker(void *userdata)
          slock_lock(running_lock);
          slock_lock(queue_lock);
 
+         task->worker = -1;
+
          /* do nothing if only item in queue */
          if (task->next)
          {
             task_queue_remove(&tasks_running, task);
             task_queue_put(&tasks_running, task);
-            scond_signal(worker_cond);
          }
+
+         /* The task is free again, and may be one only another
+          * worker can take */
+         if (task->next || worker_count > 1)
+            scond_broadcast(worker_cond);
          slock_unlock(queue_lock);
          slock_unlock(running_lock);
       }
@@ -785,6 +884,8 @@ static void threaded_worker(void *userdata)
 
 static void retro_task_threaded_init(void)
 {
+   unsigned i;
+
    running_lock    = slock_new();
    finished_lock   = slock_new();
    property_lock   = slock_new();
@@ -793,19 +894,29 @@ static void retro_task_threaded_init(void)
 
    slock_lock(running_lock);
    worker_continue = true;
+   worker_count    = task_worker_count;
    slock_unlock(running_lock);
 
-   worker_thread   = sthread_create(threaded_worker, NULL);
+   for (i = 0; i < task_worker_count; i++)
+      worker_threads[i] = sthread_create(threaded_worker,
+            (void*)(uintptr_t)i);
 }
 
 static void retro_task_threaded_deinit(void)
 {
+   unsigned i;
+
    slock_lock(running_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
+   scond_broadcast(worker_cond);
    slock_unlock(running_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < worker_count; i++)
+   {
+      sthread_join(worker_threads[i]);
+      worker_threads[i] = NULL;
+   }
+   worker_count    = 0;
 
    scond_free(worker_cond);
    slock_free(running_lock);
@@ -813,7 +924,6 @@ static void retro_task_threaded_deinit(void)
    slock_free(property_lock);
    slock_free(queue_lock);
 
-   worker_thread   = NULL;
    worker_cond     = NULL;
    running_lock    = NULL;
    finished_lock   = NULL;
@@ -837,6 +947,12 @@ static struct retro_task_impl impl_threaded = {
 
 #ifdef HAVE_GCD
 
+/* GCD has no workers to pin tasks to, but its QoS classes map
+ * onto the priority lanes */
+#define TASK_GCD_QUEUE(t) dispatch_get_global_queue( \
+      ((t)->priority == TASK_PRIORITY_LATENCY) \
+      ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED, 0)
+
 static void gcd_worker(retro_task_t *task)
 {
    bool       finished = false;
@@ -858,13 +974,14 @@ static void gcd_worker(retro_task_t *task)
       if (delay > 0)
       {
          dispatch_time_t after = dispatch_time(DISPATCH_TIME_NOW, delay);
-         dispatch_after(after, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+         dispatch_after(after, TASK_GCD_QUEUE(task),
                         ^{ gcd_worker(task); });
          slock_unlock(running_lock);
          return;
       }
    }
 
+   task_queue_note_start(task);
    slock_unlock(running_lock);
 
    task->handler(task);
@@ -874,7 +991,7 @@ static void gcd_worker(retro_task_t *task)
    slock_unlock(property_lock);
 
    if (!finished)
-      dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+      dispatch_async(TASK_GCD_QUEUE(task),
                      ^{ gcd_worker(task); });
    else
    {
@@ -901,7 +1018,7 @@ static void retro_task_gcd_push_running(retro_task_t *task)
    slock_lock(queue_lock);
    task_queue_put(&tasks_running, task);
    gcd_queue_count++;
-   dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+   dispatch_async(TASK_GCD_QUEUE(task),
                   ^{ gcd_worker(task); });
    slock_unlock(queue_lock);
    slock_unlock(running_lock);
@@ -948,7 +1065,7 @@ static void retro_task_gcd_init(void)
    for (task = tasks_running.front; task; task = task->next)
    {
       gcd_queue_count++;
-      dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+      dispatch_async(TASK_GCD_QUEUE(task),
                      ^{ gcd_worker(task); });
    };
    slock_unlock(running_lock);
@@ -1022,6 +1139,15 @@ void task_queue_init(bool threaded, retro_task_queue_msg_t msg_push)
    impl_current->init();
 }
 
+void task_queue_set_workers(unsigned workers)
+{
+   if (workers < 1)
+      workers = 1;
+   else if (workers > TASK_QUEUE_MAX_WORKERS)
+      workers = TASK_QUEUE_MAX_WORKERS;
+   task_worker_count = workers;
+}
+
 void task_queue_set_threaded(void)
 {
    task_threaded_enable = true;
@@ -1055,6 +1181,11 @@ void task_queue_check(void)
 
    if (want_threaded != current_threaded)
       task_queue_deinit();
+#ifndef HAVE_GCD
+   /* Resize the worker pool */
+   else if (current_threaded && worker_count != task_worker_count)
+      task_queue_deinit();
+#endif
 
    if (!impl_current)
       task_queue_init(want_threaded, msg_push_bak);
@@ -1094,6 +1225,11 @@ bool task_queue_push(retro_task_t *task)
          return false;
    }
 
+   task->worker = -1;
+   task->queued = cpu_features_get_time_usec();
+   if (task->when > task->queued)
+      task->queued = task->when;
+
    /* The lack of NULL checks in the following functions
     * is proposital to ensure correct control flow by the users. */
    impl_current->push_running(task);
@@ -1101,6 +1237,45 @@ bool task_queue_push(retro_task_t *task)
    return true;
 }
 
+void task_queue_get_stats(task_queue_stats_t *stats)
+{
+   unsigned i;
+   retro_task_t *task = NULL;
+
+   memset(stats, 0, sizeof(*stats));
+
+#ifdef HAVE_THREADS
+   slock_lock(running_lock);
+#endif
+   for (task = tasks_running.front; task; task = task->next)
+      stats->depth[TASK_PRIORITY_INDEX(task)]++;
+#ifdef HAVE_THREADS
+   slock_lock(finished_lock);
+#endif
+   for (task = tasks_finished.front; task; task = task->next)
+      stats->depth[TASK_PRIORITY_INDEX(task)]++;
+#ifdef HAVE_THREADS
+   slock_unlock(finished_lock);
+#endif
+
+   for (i = 0; i < TASK_PRIORITY_COUNT; i++)
+   {
+      stats->started[i]    = task_started[i];
+      stats->wait_total[i] = task_wait_total[i];
+      stats->wait_max[i]   = task_wait_max[i];
+   }
+
+#ifdef HAVE_THREADS
+   if (impl_current && impl_current != &impl_regular)
+#ifdef HAVE_GCD
+      stats->workers       = 1;
+#else
+      stats->workers       = worker_count;
+#endif
+   slock_unlock(running_lock);
+#endif
+}
+
 void task_queue_wait(retro_task_condition_fn_t cond, void* data)
 {
    impl_current->wait(cond, data);
@@ -1393,6 +1568,10 @@ retro_task_t *task_init(void)
    task->frontend_userdata = NULL;
    task->next              = NULL;
    task->when              = 0;
+   task->queued            = 0;
+   task->priority          = TASK_PRIORITY_BULK;
+   task->affinity          = TASK_AFFINITY_ANY;
+   task->worker            = -1;
 
    return task;
 }
@@ -0,0 +1,164 @@
+/* Synthetic AAC-LC access units for the raac test and benchmark.
+ *
+ * Both programs include raac.c itself, so this borrows its Huffman
+ * tables and scale factor band offsets to write mono raw_data_blocks
+ * (one SCE, then END) the decoder accepts: every band on codebook 11
+ * with random pairs that thin out towards the top of the spectrum the
+ * way music does, a share of the low ones escaped, and small random
+ * scale factor steps. The window sequence and shape cycle frame by frame so
+ * all four sequences, both window shapes and every transition between
+ * them get decoded.
+ */
+#ifndef RAAC_SYNTH_H__
+#define RAAC_SYNTH_H__
+
+typedef struct
+{
+   uint8_t *buf;
+   size_t   cap;
+   size_t   pos; /* in bits */
+} synth_bits;
+
+static uint32_t synth_rng = 0x9e3779b9u;
+static uint32_t synth_rand(void)
+{
+   synth_rng ^= synth_rng << 13;
+   synth_rng ^= synth_rng >> 17;
+   synth_rng ^= synth_rng << 5;
+   return synth_rng;
+}
+
+static void synth_put(synth_bits *b, uint32_t v, int n)
+{
+   while (n-- > 0)
+   {
+      size_t byte = b->pos >> 3;
+      if (byte >= b->cap)
+         return;
+      if ((v >> n) & 1)
+         b->buf[byte] |= (uint8_t)(0x80u >> (b->pos & 7));
+      b->pos++;
+   }
+}
+
+/* An AudioSpecificConfig for mono AAC-LC at 48 kHz: 48 kHz keeps the
+ * decoder out of the 16-24 kHz implicit-SBR window, so it decodes at
+ * the core rate. */
+static void synth_asc(uint8_t asc[2], int short_frame)
+{
+   asc[0] = (uint8_t)((2 << 3) | (3 >> 1));
+   asc[1] = (uint8_t)(((3 & 1) << 7) | (1 << 3) | (short_frame ? 4 : 0));
+}
+
+static int synth_value(int amp)
+{
+   uint32_t r = synth_rand();
+   int      v;
+   if (amp > 4 && (r & 63) == 0)
+      v = 16 + (int)((r >> 5) % 9000);    /* escape, some past 8191 */
+   else
+      v = (int)((r >> 5) % (unsigned)(amp + 1));
+   return (r & 0x80000000u) ? -v : v;
+}
+
+static void synth_escape(synth_bits *b, int v)
+{
+   int m = v < 0 ? -v : v, nb = 4;
+   if (m < 16)
+      return;
+   while ((1 << (nb + 1)) <= m)
+      nb++;
+   synth_put(b, (1u << (nb - 4)) - 1, nb - 4);  /* nb - 4 ones       */
+   synth_put(b, 0, 1);
+   synth_put(b, (uint32_t)(m - (1 << nb)), nb);
+}
+
+/* Writes frame number `n` for decoder `a` (only its sampling tables
+ * are read) and returns its size in bytes. */
+static size_t synth_frame(const raac_t *a, unsigned n, uint8_t *buf,
+      size_t cap)
+{
+   static const int seq_cycle[6] = { 0, 1, 2, 2, 3, 0 };
+   synth_bits      b;
+   int             seq   = seq_cycle[n % 6];
+   int             shape = (int)((n / 6) & 1);
+   int             sw    = (seq == 2);
+   const uint16_t *swb   = raac_swb_off(a, sw);
+   int             nswb  = raac_num_swb(a, sw);
+   int             max_sfb = nswb - (int)(synth_rand() % 4);
+   int             groups  = sw ? 3 : 1;
+   int             glen[3] = { 1, 4, 3 };
+   int             sect_bits = sw ? 3 : 5;
+   int             g, k, w, i, sf = 100;
+
+   b.buf = buf;
+   b.cap = cap;
+   b.pos = 0;
+   memset(buf, 0, cap);
+
+   synth_put(&b, 0, 3);                  /* SCE                      */
+   synth_put(&b, 0, 4);                  /* element_instance_tag     */
+   synth_put(&b, (uint32_t)sf, 8);       /* global_gain              */
+   synth_put(&b, 0, 1);                  /* ics_reserved_bit         */
+   synth_put(&b, (uint32_t)seq, 2);
+   synth_put(&b, (uint32_t)shape, 1);
+   if (sw)
+   {
+      synth_put(&b, (uint32_t)max_sfb, 4);
+      synth_put(&b, 0x3b, 7);            /* groups of 1, 4 and 3     */
+   }
+   else
+   {
+      synth_put(&b, (uint32_t)max_sfb, 6);
+      synth_put(&b, 0, 1);               /* predictor_data_present   */
+   }
+
+   /* one codebook-11 section per group */
+   for (g = 0; g < groups; g++)
+   {
+      int left = max_sfb, esc = (1 << sect_bits) - 1;
+      synth_put(&b, 11, 4);
+      while (left >= esc)
+      {
+         synth_put(&b, (uint32_t)esc, sect_bits);
+         left -= esc;
+      }
+      synth_put(&b, (uint32_t)left, sect_bits);
+   }
+   /* scale factors wander in small steps around unity gain */
+   for (g = 0; g < groups; g++)
+      for (k = 0; k < max_sfb; k++)
+      {
+         int d = (int)(synth_rand() % 7) - 3;
+         if (sf + d < 70 || sf + d > 130)
+            d = -d;
+         sf += d;
+         synth_put(&b, raac_sf_code[d + 60], raac_sf_bits[d + 60]);
+      }
+   synth_put(&b, 0, 1);                  /* pulse_data_present       */
+   synth_put(&b, 0, 1);                  /* tns_data_present         */
+   synth_put(&b, 0, 1);                  /* gain_control_data_present */
+
+   for (g = 0; g < groups; g++)
+      for (k = 0; k < max_sfb; k++)
+         for (w = 0; w < glen[g]; w++)
+            for (i = swb[k]; i < swb[k + 1]; i += 2)
+            {
+               int amp = k < max_sfb / 3 ? 7 : (k < max_sfb * 2 / 3 ? 2 : 1);
+               int y   = synth_value(amp), z = synth_value(amp);
+               int ay  = y < 0 ? -y : y, az = z < 0 ? -z : z;
+               int idx = (ay > 16 ? 16 : ay) * 17 + (az > 16 ? 16 : az);
+               synth_put(&b, raac_hcb11_code[idx], raac_hcb11_bits[idx]);
+               if (y)
+                  synth_put(&b, y < 0, 1);
+               if (z)
+                  synth_put(&b, z < 0, 1);
+               synth_escape(&b, y);
+               synth_escape(&b, z);
+            }
+
+   synth_put(&b, 7, 3);                  /* END                      */
+   return (b.pos + 7) >> 3;
+}
+
+#endif
@@ -0,0 +1,256 @@
+/* Benchmark for the sliced PNG encoder: the same capture encoded by
+ * rpng_save_image_stream_fmt (one deflate stream on one thread) and by
+ * rpng_save_image_stream_fmt_threaded at several thread counts, at
+ * 1080p and 4K, on XRGB8888 frames shaped like what gets captured:
+ *
+ *   pixelart : an upscaled 256x224 tile screen, flat runs everywhere
+ *   gradient : a smooth ramp with light dither, like a menu backdrop
+ *   scene    : smooth shading plus per-pixel noise, like 3D output
+ *
+ * Wall time and output size are reported for each; the size column is
+ * what slicing costs, since matches never cross a band.
+ *
+ * It also checks the output.  Filter selection sees the same rows and
+ * predictors in both encoders, so inflating the IDAT data of a sliced
+ * PNG must give exactly the bytes the serial one inflates to, and zlib
+ * must accept its header and Adler-32 trailer while doing it.  Any
+ * difference exits non-zero.
+ *
+ * Usage:
+ *   rpng_slice_bench [--width N --height N] [--iters N]
+ *
+ * Build (see Makefile):
+ *   make -C libretro-common/samples/formats/bench rpng_slice_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#include <libretro.h>
+#include <formats/rpng.h>
+#include <streams/interface_stream.h>
+
+static uint32_t prng_state = 0x1234567u;
+static uint32_t prng(void)
+{
+   prng_state ^= prng_state << 13;
+   prng_state ^= prng_state >> 17;
+   prng_state ^= prng_state << 5;
+   return prng_state;
+}
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void fill(uint32_t *frame, unsigned w, unsigned h, const char *pattern)
+{
+   unsigned x, y;
+
+   prng_state = 0x1234567u;
+   if (!strcmp(pattern, "pixelart"))
+   {
+      uint32_t tiles[64];
+      for (x = 0; x < 64; x++)
+         tiles[x] = prng() & 0x00FFFFFFu;
+      for (y = 0; y < h; y++)
+         for (x = 0; x < w; x++)
+         {
+            unsigned sx = x * 256 / w;
+            unsigned sy = y * 224 / h;
+            frame[(size_t)y * w + x] = tiles[((sx >> 3) * 7 + (sy >> 3) * 3
+                  + ((sx ^ sy) & 1)) & 63];
+         }
+   }
+   else if (!strcmp(pattern, "gradient"))
+   {
+      for (y = 0; y < h; y++)
+         for (x = 0; x < w; x++)
+         {
+            unsigned r = x * 255 / w, g = y * 255 / h, b = 128;
+            unsigned d = prng() & 1;
+            frame[(size_t)y * w + x] = ((r + d) << 16) | ((g + d) << 8) | b;
+         }
+   }
+   else
+   {
+      for (y = 0; y < h; y++)
+         for (x = 0; x < w; x++)
+         {
+            unsigned n = prng() & 15;
+            unsigned r = (x * 191 / w) + n;
+            unsigned g = ((x + y) * 127 / (w + h)) + 64 + (n >> 1);
+            unsigned b = (y * 191 / h) + n;
+            frame[(size_t)y * w + x] = (r << 16) | (g << 8) | b;
+         }
+   }
+}
+
+/* Encodes into memory; 0 threads is the serial encoder.  Returns the
+ * PNG size, or 0 on failure. */
+static size_t encode(const uint32_t *frame, unsigned w, unsigned h,
+      unsigned threads, uint8_t *out, size_t out_size)
+{
+   bool ok;
+   int64_t len          = 0;
+   intfstream_t *intf_s = intfstream_open_memory(out,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE, out_size);
+
+   if (!intf_s)
+      return 0;
+   if (threads)
+      ok = rpng_save_image_stream_fmt_threaded((const uint8_t*)frame,
+            intf_s, w, h, (signed)(w * 4), RPNG_PIXFMT_XRGB8888, NULL,
+            threads);
+   else
+      ok = rpng_save_image_stream_fmt((const uint8_t*)frame,
+            intf_s, w, h, (signed)(w * 4), RPNG_PIXFMT_XRGB8888, NULL);
+   len = intfstream_get_ptr(intf_s);
+   intfstream_close(intf_s);
+   free(intf_s);
+   return ok ? (size_t)len : 0;
+}
+
+/* Concatenates the IDAT payloads of `png` and inflates them into
+ * `raw`, which must hold the whole filtered image.  Returns the count
+ * of IDAT chunks, or 0 if zlib rejects the stream. */
+static unsigned inflate_idat(const uint8_t *png, size_t len,
+      uint8_t *raw, size_t raw_size)
+{
+   size_t pos      = 8;
+   size_t zlen     = 0;
+   unsigned chunks = 0;
+   uLongf out_len  = (uLongf)raw_size;
+   uint8_t *z      = (uint8_t*)malloc(len);
+
+   if (!z)
+      return 0;
+   while (pos + 12 <= len)
+   {
+      size_t n = ((size_t)png[pos] << 24) | ((size_t)png[pos + 1] << 16)
+               | ((size_t)png[pos + 2] << 8) | png[pos + 3];
+      if (!memcmp(png + pos + 4, "IDAT", 4))
+      {
+         memcpy(z + zlen, png + pos + 8, n);
+         zlen += n;
+         chunks++;
+      }
+      pos += n + 12;
+   }
+   if (uncompress(raw, &out_len, z, (uLong)zlen) != Z_OK
+         || out_len != raw_size)
+      chunks = 0;
+   free(z);
+   return chunks;
+}
+
+int main(int argc, char **argv)
+{
+   static const char *patterns[]        = { "pixelart", "gradient", "scene" };
+   static const unsigned thread_counts[] = { 0, 2, 4, 8 };
+   static const unsigned sizes[][2]     = { { 1920, 1080 }, { 3840, 2160 } };
+   unsigned only_w = 0, only_h = 0;
+   int iters       = 1;
+   int bad         = 0;
+   size_t s, p, t;
+   int a;
+
+   for (a = 1; a + 1 < argc; a += 2)
+   {
+      if (!strcmp(argv[a], "--width"))
+         only_w = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--height"))
+         only_h = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--iters"))
+         iters = atoi(argv[a + 1]);
+      else
+      {
+         fprintf(stderr, "unknown option %s\n", argv[a]);
+         return 1;
+      }
+   }
+   if (iters < 1 || (!only_w != !only_h))
+   {
+      fprintf(stderr, "invalid dimensions or iteration count\n");
+      return 1;
+   }
+
+   for (s = 0; s < (only_w ? 1 : sizeof(sizes) / sizeof(sizes[0])); s++)
+   {
+      unsigned w      = only_w ? only_w : sizes[s][0];
+      unsigned h      = only_w ? only_h : sizes[s][1];
+      size_t raw_size = (size_t)h * (w * 3 + 1);
+      size_t out_size = (size_t)w * h * 4 + 65536;
+      uint32_t *frame = (uint32_t*)malloc((size_t)w * h * 4);
+      uint8_t *out    = (uint8_t*)malloc(out_size);
+      uint8_t *ref    = (uint8_t*)malloc(raw_size);
+      uint8_t *raw    = (uint8_t*)malloc(raw_size);
+
+      if (!frame || !out || !ref || !raw)
+      {
+         fprintf(stderr, "allocation failed\n");
+         return 1;
+      }
+
+      for (p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++)
+      {
+         double serial_ms = 0.0;
+
+         fill(frame, w, h, patterns[p]);
+         printf("%ux%u %s\n", w, h, patterns[p]);
+
+         for (t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+         {
+            double best   = 0.0;
+            size_t len    = 0;
+            unsigned idat;
+            uint8_t *dest = t ? raw : ref;
+            int it;
+
+            for (it = 0; it < iters; it++)
+            {
+               double t0 = now_ms();
+               double dt;
+               len       = encode(frame, w, h, thread_counts[t], out, out_size);
+               dt        = now_ms() - t0;
+               if (it == 0 || dt < best)
+                  best = dt;
+            }
+            if (!len || !(idat = inflate_idat(out, len, dest, raw_size)))
+            {
+               printf("  %-8s encode or inflate failed\n",
+                     t ? "sliced" : "serial");
+               bad = 1;
+               continue;
+            }
+            if (!t)
+               serial_ms = best;
+
+            if (t)
+               printf("  sliced %u  %8.1f ms  x%.2f  %6.2f MB  %3u IDAT %s\n",
+                     thread_counts[t], best, best > 0 ? serial_ms / best : 0.0,
+                     len / 1e6, idat,
+                     memcmp(raw, ref, raw_size) ? "MISMATCH" : "");
+            else
+               printf("  serial    %8.1f ms         %6.2f MB  %3u IDAT\n",
+                     best, len / 1e6, idat);
+            if (t && memcmp(raw, ref, raw_size))
+               bad = 1;
+         }
+      }
+
+      free(frame);
+      free(out);
+      free(ref);
+      free(raw);
+   }
+   return bad;
+}
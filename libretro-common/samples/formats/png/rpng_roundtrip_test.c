@@ -15,6 +15,10 @@
  *                                via the (unsigned)(-pitch) convention used
  *                                by task_screenshot's viewport fast path)
  *
+ *   - rpng_save_image_stream_fmt_threaded (XRGB8888 / RGB565 sources
+ *                                cut into bands deflated in parallel,
+ *                                both orientations, several band counts)
+ *
  * Exercised sizes: tiny (4x4), moderate non-power-of-two (37x29),
  * and screenshot-shaped (320x240). The last is big enough that a
  * streaming encoder would span multiple deflate output chunks.
@@ -597,9 +601,12 @@ out:
  * (the exact call shape the screenshot task's direct fast paths use),
  * load, compare.  For RGB565 the expected 888 value uses the scaler's
  * (c << 3) | (c >> 2) expansion, locking the encoder's conversion to
- * the historical convert-then-encode output. */
+ * the historical convert-then-encode output.  A nonzero `threads`
+ * encodes through the sliced encoder instead, whose output must decode
+ * to the same pixels. */
 static void test_fmt_roundtrip(const char *path, enum rpng_pixfmt fmt,
-      unsigned w, unsigned h, enum pattern pat, bool flip_bottom_up)
+      unsigned w, unsigned h, enum pattern pat, bool flip_bottom_up,
+      unsigned threads)
 {
    uint8_t  *src = NULL;
    uint32_t *got = NULL;
@@ -610,7 +617,9 @@ static void test_fmt_roundtrip(const char *path, enum rpng_pixfmt fmt,
    const char *fname      = (fmt == RPNG_PIXFMT_XRGB8888)
          ? "xrgb8888" : "rgb565";
    const char *pname      = pattern_name(pat);
-   const char *orient     = flip_bottom_up ? "bottom-up" : "top-down";
+   const char *orient     = flip_bottom_up
+         ? (threads ? "bottom-up sliced" : "bottom-up")
+         : (threads ? "top-down sliced"  : "top-down");
    bool ok                = false;
 
    src = (uint8_t*)malloc(stride * h);
@@ -656,8 +665,11 @@ static void test_fmt_roundtrip(const char *path, enum rpng_pixfmt fmt,
          signed pitch        = flip_bottom_up
                ? -(signed)stride
                :  (signed)stride;
-         ok = rpng_save_image_stream_fmt(base, intf_s,
-               w, h, pitch, fmt, NULL);
+         ok = threads
+               ? rpng_save_image_stream_fmt_threaded(base, intf_s,
+                     w, h, pitch, fmt, NULL, threads)
+               : rpng_save_image_stream_fmt(base, intf_s,
+                     w, h, pitch, fmt, NULL);
          intfstream_close(intf_s);
          free(intf_s);
       }
@@ -822,13 +834,13 @@ int main(int argc, char *argv[])
          test_bgr24_roundtrip(path, sizes[i].w, sizes[i].h, (enum pattern)p, false);
          test_bgr24_roundtrip(path, sizes[i].w, sizes[i].h, (enum pattern)p, true);
          test_fmt_roundtrip(path, RPNG_PIXFMT_XRGB8888,
-               sizes[i].w, sizes[i].h, (enum pattern)p, false);
+               sizes[i].w, sizes[i].h, (enum pattern)p, false, 0);
          test_fmt_roundtrip(path, RPNG_PIXFMT_XRGB8888,
-               sizes[i].w, sizes[i].h, (enum pattern)p, true);
+               sizes[i].w, sizes[i].h, (enum pattern)p, true, 0);
          test_fmt_roundtrip(path, RPNG_PIXFMT_RGB565,
-               sizes[i].w, sizes[i].h, (enum pattern)p, false);
+               sizes[i].w, sizes[i].h, (enum pattern)p, false, 0);
          test_fmt_roundtrip(path, RPNG_PIXFMT_RGB565,
-               sizes[i].w, sizes[i].h, (enum pattern)p, true);
+               sizes[i].w, sizes[i].h, (enum pattern)p, true, 0);
       }
    }
 
@@ -872,6 +884,36 @@ int main(int argc, char *argv[])
       }
    }
 
+   /* Sliced encoder.  Bands are at least 64 rows, so these heights
+    * give two bands, an uneven split whose last band is short, and the
+    * full thread count; the 63-row case must fall back to the serial
+    * path.  Each band but the last ends on a sync flush and the zlib
+    * trailer is stitched on afterwards, so any slip there shows up as
+    * a decode failure or a pixel mismatch on the rows past it.  Without
+    * HAVE_THREADS these run the serial path and still must pass. */
+   {
+      static const struct size_case sliced[] = {
+         {320, 128}, {257, 1000}, {33, 63}, {640, 540}
+      };
+      static const unsigned thread_counts[] = {2, 3, 8};
+      size_t si, ti;
+      for (si = 0; si < sizeof(sliced) / sizeof(sliced[0]); si++)
+      {
+         for (ti = 0; ti < sizeof(thread_counts) / sizeof(thread_counts[0]); ti++)
+         {
+            for (p = 0; p < PAT_COUNT; p++)
+            {
+               test_fmt_roundtrip(path, RPNG_PIXFMT_XRGB8888,
+                     sliced[si].w, sliced[si].h, (enum pattern)p, false,
+                     thread_counts[ti]);
+               test_fmt_roundtrip(path, RPNG_PIXFMT_RGB565,
+                     sliced[si].w, sliced[si].h, (enum pattern)p, true,
+                     thread_counts[ti]);
+            }
+         }
+      }
+   }
+
    /* Best-effort cleanup; not fatal if it fails. */
    remove(path);
 
@@ -0,0 +1,325 @@
+/* Decode timings for rwebp with its lossless transform kernels forced
+ * to the scalar set and with the set the CPU feature mask selects,
+ * over a corpus of WebP files (thumbnail boxarts, say) given as files
+ * or directories on the command line.
+ *
+ * Without arguments it decodes built-in lossless images instead, sized
+ * like boxart thumbnails. They are written by a minimal VP8L encoder
+ * below: subtract-green, predictor and cross-colour transforms with a
+ * random predictor mode and random multipliers per block, over random
+ * residuals coded with flat 8-bit Huffman codes. That makes every
+ * predictor mode, every multiplier sign and every run/tail split occur.
+ *
+ * Both kernel sets must decode every image to the same pixels, in both
+ * channel orders; any difference exits non-zero. The lossy (VP8) path
+ * is timed too, but its kernels in rvp8 are chosen at compile time, so
+ * the two columns run the same code there.
+ *
+ * Usage:
+ *   webp_decode_bench [--iters N] [file.webp | dir ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+
+#include <features/features_cpu.h>
+
+static uint64_t bench_simd;
+#define RWEBP_CPU_FEATURES() bench_simd
+#include "../../../formats/webp/rwebp.c"
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static uint32_t prng_state = 0x1234567u;
+static uint32_t prng(void)
+{
+   prng_state ^= prng_state << 13;
+   prng_state ^= prng_state >> 17;
+   prng_state ^= prng_state << 5;
+   return prng_state;
+}
+
+/* ---- minimal VP8L writer ---- */
+
+typedef struct
+{
+   uint8_t *buf;
+   size_t   cap, pos; /* pos in bits, LSB first */
+} bw_t;
+
+static void bw_put(bw_t *b, uint32_t v, int n)
+{
+   int i;
+   for (i = 0; i < n; i++, b->pos++)
+      if ((v >> i) & 1)
+         b->buf[b->pos >> 3] |= (uint8_t)(1u << (b->pos & 7));
+}
+
+/* A code giving each of the first 256 symbols 8 bits and the rest of
+ * the ns-symbol alphabet none: the code-length code has two 1-bit
+ * codes, '0' for length 0 and '1' for length 8. */
+static void bw_flat_code(bw_t *b, int ns)
+{
+   /* order 17 18 0 1 2 3 4 5 16 6 7 8 */
+   static const int cl[12] = { 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+   int i;
+   bw_put(b, 0, 1);                     /* normal code             */
+   bw_put(b, 12 - 4, 4);
+   for (i = 0; i < 12; i++)
+      bw_put(b, (uint32_t)cl[i], 3);
+   bw_put(b, 0, 1);                     /* no max_symbol           */
+   for (i = 0; i < ns; i++)
+      bw_put(b, i < 256, 1);
+}
+
+/* Canonical codes come out MSB first. */
+static void bw_sym(bw_t *b, uint32_t s)
+{
+   int i;
+   for (i = 7; i >= 0; i--)
+      bw_put(b, (s >> i) & 1, 1);
+}
+
+static void bw_image(bw_t *b, const uint32_t *px, int n, int main_image)
+{
+   int i;
+   bw_put(b, 0, 1);                     /* no colour cache         */
+   if (main_image)
+      bw_put(b, 0, 1);                  /* no meta prefix codes    */
+   bw_flat_code(b, 256 + 24);
+   bw_flat_code(b, 256);
+   bw_flat_code(b, 256);
+   bw_flat_code(b, 256);
+   bw_put(b, 1, 1);                     /* distance: simple, one   */
+   bw_put(b, 0, 1);                     /* symbol, 1-bit symbol 0  */
+   bw_put(b, 0, 1);
+   bw_put(b, 0, 1);
+   for (i = 0; i < n; i++)
+   {
+      bw_sym(b, (px[i] >> 8) & 0xFF);
+      bw_sym(b, (px[i] >> 16) & 0xFF);
+      bw_sym(b, px[i] & 0xFF);
+      bw_sym(b, px[i] >> 24);
+   }
+}
+
+/* Returns a RIFF WebP of w x h in a malloc'd buffer. Residuals are
+ * small around zero so the picture stays smooth, as artwork is. */
+static uint8_t *synth_webp(int w, int h, int pbits, int cbits, size_t *len)
+{
+   size_t    cap = 64 + (size_t)w * h * 4 * 2;
+   uint8_t  *out = (uint8_t*)calloc(1, cap);
+   bw_t      b;
+   int       pw = ((w - 1) >> pbits) + 1, ph = ((h - 1) >> pbits) + 1;
+   int       cw = ((w - 1) >> cbits) + 1, ch = ((h - 1) >> cbits) + 1;
+   uint32_t *tmp = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)w * h);
+   size_t    size;
+   int       i;
+
+   b.buf = out + 20;
+   b.cap = cap - 20;
+   b.pos = 0;
+   bw_put(&b, 0x2F, 8);
+   bw_put(&b, (uint32_t)(w - 1), 14);
+   bw_put(&b, (uint32_t)(h - 1), 14);
+   bw_put(&b, 1, 1);
+   bw_put(&b, 0, 3);
+
+   bw_put(&b, 1, 1);
+   bw_put(&b, XF_SUBG, 2);
+   bw_put(&b, 1, 1);
+   bw_put(&b, XF_PRED, 2);
+   bw_put(&b, (uint32_t)(pbits - 2), 3);
+   for (i = 0; i < pw * ph; i++)
+      tmp[i] = 0xFF000000u | ((prng() % 16) << 8);
+   bw_image(&b, tmp, pw * ph, 0);
+   bw_put(&b, 1, 1);
+   bw_put(&b, XF_CCOL, 2);
+   bw_put(&b, (uint32_t)(cbits - 2), 3);
+   for (i = 0; i < cw * ch; i++)
+      tmp[i] = 0xFF000000u | (prng() & 0xFFFFFF);
+   bw_image(&b, tmp, cw * ch, 0);
+   bw_put(&b, 0, 1);
+
+   for (i = 0; i < w * h; i++)
+   {
+      uint32_t r = prng();
+      tmp[i] = (uint32_t)(((r & 7) - 3) & 0xFF) << 24
+             | (uint32_t)(((r >> 3 & 15) - 7) & 0xFF) << 16
+             | (uint32_t)(((r >> 7 & 15) - 7) & 0xFF) << 8
+             | (uint32_t)(((r >> 11 & 15) - 7) & 0xFF);
+   }
+   bw_image(&b, tmp, w * h, 1);
+   free(tmp);
+
+   size = (b.pos + 7) >> 3;
+   memcpy(out, "RIFF", 4);
+   out[4]  = (uint8_t)(size + 12 + (size & 1));
+   out[5]  = (uint8_t)((size + 12 + (size & 1)) >> 8);
+   out[6]  = (uint8_t)((size + 12 + (size & 1)) >> 16);
+   out[7]  = (uint8_t)((size + 12 + (size & 1)) >> 24);
+   memcpy(out + 8, "WEBPVP8L", 8);
+   out[16] = (uint8_t)size;
+   out[17] = (uint8_t)(size >> 8);
+   out[18] = (uint8_t)(size >> 16);
+   out[19] = (uint8_t)(size >> 24);
+   *len = 20 + size + (size & 1);
+   return out;
+}
+
+/* ---- bench ---- */
+
+static int iters = 5;
+static int bad;
+
+/* Decodes buf with the given kernel mask; returns the best time, and
+ * the pixels through *pix (caller frees). */
+static double time_decode(const uint8_t *buf, size_t len, uint64_t simd,
+      int rgba, uint32_t **pix, unsigned *w, unsigned *h)
+{
+   double best = 0.0;
+   int    it;
+   bench_simd = simd;
+   *pix       = NULL;
+   for (it = 0; it < iters; it++)
+   {
+      double    t0 = now_ms(), dt;
+      uint32_t *p  = rwebp_do(buf, len, w, h, rgba ? true : false);
+      dt = now_ms() - t0;
+      if (!p)
+         return -1.0;
+      if (it == 0 || dt < best)
+         best = dt;
+      free(*pix);
+      *pix = p;
+   }
+   return best;
+}
+
+static void bench_one(const char *name, const uint8_t *buf, size_t len)
+{
+   uint64_t  simd = cpu_features_get();
+   rw_ctr    c;
+   double    t[2];
+   uint32_t *p[2];
+   unsigned  w = 0, h = 0, w2 = 0, h2 = 0;
+   int       rgba, same = 1;
+
+   for (rgba = 0; rgba < 2; rgba++)
+   {
+      t[0] = time_decode(buf, len, 0,    rgba, &p[0], &w,  &h);
+      t[1] = time_decode(buf, len, simd, rgba, &p[1], &w2, &h2);
+      if (t[0] < 0 || t[1] < 0)
+      {
+         printf("  %-28s decode failed\n", name);
+         bad = 1;
+      }
+      else if (w != w2 || h != h2 || memcmp(p[0], p[1],
+               sizeof(uint32_t) * (size_t)w * h))
+         same = 0;
+      free(p[0]);
+      free(p[1]);
+      if (t[0] < 0 || t[1] < 0)
+         return;
+   }
+   /* the times printed are the RGBA decode's, what thumbnails use */
+   printf("  %-28s %5ux%-5u %s  scalar %8.2f ms  simd %8.2f ms  x%.2f %s\n",
+         name, w, h, (rw_parse(buf, len, &c) && c.vp8l)
+         ? "lossless" : "lossy   ", t[0], t[1],
+         t[1] > 0 ? t[0] / t[1] : 0.0, same ? "" : "MISMATCH");
+   if (!same)
+      bad = 1;
+}
+
+static void bench_file(const char *path)
+{
+   FILE    *f = fopen(path, "rb");
+   long     sz;
+   uint8_t *buf;
+   const char *base = strrchr(path, '/');
+
+   if (!f)
+      return;
+   fseek(f, 0, SEEK_END);
+   sz = ftell(f);
+   fseek(f, 0, SEEK_SET);
+   buf = (uint8_t*)malloc(sz > 0 ? (size_t)sz : 1);
+   if (buf && sz > 0 && fread(buf, 1, (size_t)sz, f) == (size_t)sz)
+      bench_one(base ? base + 1 : path, buf, (size_t)sz);
+   fclose(f);
+   free(buf);
+}
+
+static void bench_path(const char *path)
+{
+   DIR *d = opendir(path);
+   struct dirent *e;
+
+   if (!d)
+   {
+      bench_file(path);
+      return;
+   }
+   while ((e = readdir(d)))
+   {
+      size_t n = strlen(e->d_name);
+      char   full[4096];
+      if (n < 5 || strcmp(e->d_name + n - 5, ".webp"))
+         continue;
+      snprintf(full, sizeof(full), "%s/%s", path, e->d_name);
+      bench_file(full);
+   }
+   closedir(d);
+}
+
+int main(int argc, char **argv)
+{
+   static const int synth[][4] = {
+      /* w, h, predictor bits, cross-colour bits */
+      {  256,  256, 2, 2 },
+      {  512,  512, 3, 4 },
+      {  640,  897, 4, 5 },   /* odd sizes: partial blocks and tails */
+      { 1000,  709, 5, 2 },
+   };
+   int a, files = 0;
+
+   for (a = 1; a < argc; a++)
+   {
+      if (!strcmp(argv[a], "--iters") && a + 1 < argc)
+      {
+         if ((iters = atoi(argv[++a])) < 1)
+         {
+            fprintf(stderr, "invalid iteration count\n");
+            return 1;
+         }
+      }
+      else
+      {
+         bench_path(argv[a]);
+         files++;
+      }
+   }
+
+   if (!files)
+   {
+      size_t i;
+      for (i = 0; i < sizeof(synth) / sizeof(synth[0]); i++)
+      {
+         char     name[64];
+         size_t   len;
+         uint8_t *buf = synth_webp(synth[i][0], synth[i][1],
+               synth[i][2], synth[i][3], &len);
+         snprintf(name, sizeof(name), "synthetic-%d", (int)i);
+         bench_one(name, buf, len);
+         free(buf);
+      }
+   }
+   return bad;
+}
@@ -0,0 +1,308 @@
+/* Regression test for the threaded task queue's worker pool,
+ * priority lanes and counters in libretro-common/queues/task_queue.c.
+ *
+ * What this test asserts
+ * ----------------------
+ * 1. With two workers, two tasks of TASK_AFFINITY_ANY have their
+ *    handlers running at the same time.
+ * 2. With two workers, two tasks bound to the same worker never do,
+ *    and each only ever runs on one thread.
+ * 3. With one worker kept busy, a latency task pushed after three
+ *    bulk tasks is started before any of them.
+ * 4. task_queue_get_stats() counts the started tasks per lane,
+ *    reports the pool size, and shows an empty queue once drained.
+ *
+ * The handlers sleep rather than spin, so (1) holds on a single
+ * core too.  Every wait is bounded; a wedged queue fails the test
+ * rather than hanging CI.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <queues/task_queue.h>
+#include <rthreads/rthreads.h>
+#include <retro_timers.h>
+
+#define WORKERS_TEST_CALLS 5
+
+static int failures = 0;
+
+static slock_t *state_lock = NULL;
+static int inside          = 0;
+static int inside_peak     = 0;
+
+/* Order in which the priority test's tasks were first called */
+static int order[8];
+static int order_count     = 0;
+static bool gate_entered   = false;
+static bool gate_open      = false;
+
+struct worker_task_state
+{
+   int id;
+   int calls;
+   bool thread_changed;
+   uintptr_t thread;
+};
+
+static void overlap_handler(retro_task_t *task)
+{
+   struct worker_task_state *st = (struct worker_task_state*)task->state;
+   uintptr_t self               = sthread_get_current_thread_id();
+
+   slock_lock(state_lock);
+   if (st->calls && st->thread != self)
+      st->thread_changed = true;
+   st->thread = self;
+   if (++inside > inside_peak)
+      inside_peak = inside;
+   slock_unlock(state_lock);
+
+   retro_sleep(20);
+
+   slock_lock(state_lock);
+   inside--;
+   slock_unlock(state_lock);
+
+   if (++st->calls >= WORKERS_TEST_CALLS)
+      task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static void gate_handler(retro_task_t *task)
+{
+   int i;
+
+   slock_lock(state_lock);
+   gate_entered = true;
+   slock_unlock(state_lock);
+
+   /* Hold the only worker until the main thread has queued
+    * everything, bounded at two seconds */
+   for (i = 0; i < 2000; i++)
+   {
+      bool open;
+      slock_lock(state_lock);
+      open = gate_open;
+      slock_unlock(state_lock);
+      if (open)
+         break;
+      retro_sleep(1);
+   }
+
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static void order_handler(retro_task_t *task)
+{
+   struct worker_task_state *st = (struct worker_task_state*)task->state;
+
+   slock_lock(state_lock);
+   if (order_count < (int)(sizeof(order) / sizeof(order[0])))
+      order[order_count++] = st->id;
+   slock_unlock(state_lock);
+
+   task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static retro_task_t *make_task(retro_task_handler_t handler,
+      struct worker_task_state *st, enum task_priority priority,
+      int8_t affinity)
+{
+   retro_task_t *task = task_init();
+
+   if (!task)
+   {
+      printf("[FATAL] OOM in make_task\n");
+      exit(2);
+   }
+
+   task->handler  = handler;
+   task->state    = st;
+   task->priority = priority;
+   task->affinity = affinity;
+   return task;
+}
+
+/* Runs the queue until it drains or two seconds pass */
+static bool drain(void)
+{
+   return task_queue_wait_timeout(NULL, NULL, 2000000);
+}
+
+static void run_overlap(const char *name, int8_t affinity,
+      int want_peak)
+{
+   struct worker_task_state a, b;
+
+   memset(&a, 0, sizeof(a));
+   memset(&b, 0, sizeof(b));
+   inside      = 0;
+   inside_peak = 0;
+
+   task_queue_set_workers(2);
+   task_queue_check();
+
+   task_queue_push(make_task(overlap_handler, &a,
+            TASK_PRIORITY_BULK, affinity));
+   task_queue_push(make_task(overlap_handler, &b,
+            TASK_PRIORITY_BULK, affinity));
+
+   if (!drain())
+   {
+      printf("[ERROR] %s: queue did not drain\n", name);
+      failures++;
+   }
+   else if (inside_peak != want_peak)
+   {
+      printf("[ERROR] %s: %d handlers ran at once, expected %d\n",
+            name, inside_peak, want_peak);
+      failures++;
+   }
+   else if (affinity != TASK_AFFINITY_ANY
+         && (a.thread_changed || b.thread_changed || a.thread != b.thread))
+   {
+      printf("[ERROR] %s: bound tasks ran on more than one thread\n", name);
+      failures++;
+   }
+   else
+      printf("[SUCCESS] %s\n", name);
+}
+
+static void test_priority(void)
+{
+   struct worker_task_state gate, bulk[3], latency;
+   int i;
+
+   memset(&gate, 0, sizeof(gate));
+   memset(bulk, 0, sizeof(bulk));
+   memset(&latency, 0, sizeof(latency));
+   order_count  = 0;
+   gate_entered = false;
+   gate_open    = false;
+
+   task_queue_set_workers(1);
+   task_queue_check();
+
+   task_queue_push(make_task(gate_handler, &gate,
+            TASK_PRIORITY_BULK, TASK_AFFINITY_ANY));
+
+   for (i = 0; i < 2000; i++)
+   {
+      bool entered;
+      slock_lock(state_lock);
+      entered = gate_entered;
+      slock_unlock(state_lock);
+      if (entered)
+         break;
+      retro_sleep(1);
+   }
+
+   for (i = 0; i < 3; i++)
+   {
+      bulk[i].id = i + 1;
+      task_queue_push(make_task(order_handler, &bulk[i],
+               TASK_PRIORITY_BULK, TASK_AFFINITY_ANY));
+   }
+   latency.id = 100;
+   task_queue_push(make_task(order_handler, &latency,
+            TASK_PRIORITY_LATENCY, TASK_AFFINITY_ANY));
+
+   slock_lock(state_lock);
+   gate_open = true;
+   slock_unlock(state_lock);
+
+   if (!drain())
+   {
+      printf("[ERROR] priority: queue did not drain\n");
+      failures++;
+   }
+   else if (order_count != 4 || order[0] != 100)
+   {
+      printf("[ERROR] priority: latency task was not started first "
+            "(%d tasks ran, first id %d)\n",
+            order_count, order_count ? order[0] : -1);
+      failures++;
+   }
+   else
+      printf("[SUCCESS] priority\n");
+}
+
+static void test_stats(void)
+{
+   task_queue_stats_t stats;
+
+   task_queue_get_stats(&stats);
+
+   /* Two overlap runs of two tasks, then the gate and three bulk
+    * tasks; one latency task */
+   if (     stats.started[TASK_PRIORITY_BULK]    != 8
+         || stats.started[TASK_PRIORITY_LATENCY] != 1)
+   {
+      printf("[ERROR] stats: started %u bulk / %u latency, "
+            "expected 8 / 1\n",
+            (unsigned)stats.started[TASK_PRIORITY_BULK],
+            (unsigned)stats.started[TASK_PRIORITY_LATENCY]);
+      failures++;
+   }
+   else if (stats.depth[TASK_PRIORITY_BULK]
+         || stats.depth[TASK_PRIORITY_LATENCY])
+   {
+      printf("[ERROR] stats: drained queue reports depth %u / %u\n",
+            stats.depth[TASK_PRIORITY_BULK],
+            stats.depth[TASK_PRIORITY_LATENCY]);
+      failures++;
+   }
+   else if (stats.workers != 1)
+   {
+      printf("[ERROR] stats: %u workers, expected 1\n", stats.workers);
+      failures++;
+   }
+   else if (stats.wait_max[TASK_PRIORITY_LATENCY]
+         > stats.wait_total[TASK_PRIORITY_LATENCY])
+   {
+      printf("[ERROR] stats: worst wait exceeds total wait\n");
+      failures++;
+   }
+   else
+      printf("[SUCCESS] stats\n");
+}
+
+/* -----------------------------------------------------------------
+ * task_queue.c times 'when' and the wait counters with
+ * cpu_features_get_time_usec(); a monotonic clock is all it needs.
+ * ----------------------------------------------------------------- */
+
+retro_time_t cpu_features_get_time_usec(void);
+retro_time_t cpu_features_get_time_usec(void)
+{
+   struct timespec tv;
+   if (clock_gettime(CLOCK_MONOTONIC, &tv) < 0)
+      return 0;
+   return (retro_time_t)tv.tv_sec * 1000000 + (tv.tv_nsec + 500) / 1000;
+}
+
+int main(void)
+{
+   state_lock = slock_new();
+
+   task_queue_init(true, NULL);
+
+   run_overlap("overlap_any", TASK_AFFINITY_ANY, 2);
+   run_overlap("overlap_bound", 1, 1);
+   test_priority();
+   test_stats();
+
+   task_queue_deinit();
+   slock_free(state_lock);
+
+   if (failures)
+   {
+      printf("\n%d task_queue worker test(s) failed\n", failures);
+      return 1;
+   }
+   printf("\nAll task_queue worker tests passed.\n");
+   return 0;
+}
@@ -0,0 +1,484 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rzip_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Compares the two RZIP chunk codecs on save-state data: version 1
+ * (zlib level 6, 128 KiB chunks) against version 2 (Zstandard, 1 MiB
+ * chunks), with each Zstandard encoder this was built with - the
+ * reference library under HAVE_ZSTD, which is what rzip_stream.c
+ * writes with, and the built-in one under HAVE_RZSTD, which it does
+ * not, for comparison.
+ *
+ * Each input is cut into chunks exactly as rzip_stream.c cuts it, and
+ * every chunk is compressed and decompressed on its own, so the
+ * timings are those of a single-threaded state save and load minus
+ * the file I/O.  The ratio is the on-disk size including the headers.
+ *
+ * It also checks the compatibility promise of the format: the files
+ * assembled from each codec's chunks must read back through
+ * rzipstream_read_file(), and so must what rzipstream_write_file()
+ * writes today.  A mismatch exits non-zero.
+ *
+ * Pass save states on the command line to measure real core data
+ * (uncompressed .state files, or RZIP ones, which are expanded first).
+ * Without arguments a synthetic 2 MiB state is used: zeroed and
+ * pattern-filled RAM, tile data and a little noise, which is roughly
+ * what console cores serialise.
+ *
+ * Usage:
+ *   rzip_bench [--iters N] [state ...]
+ *
+ * Build with HAVE_ZSTD=1 (see Makefile) to include the reference
+ * encoder.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+#include <streams/trans_stream.h>
+#include <streams/rzip_stream.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_RZSTD
+#include <encodings/rzstd.h>
+#endif
+
+/* Keep in step with rzip_stream.c */
+#define BENCH_HEADER_SIZE     20
+#define BENCH_ZLIB_CHUNK_SIZE 131072
+#define BENCH_ZLIB_LEVEL      6
+#define BENCH_ZSTD_CHUNK_SIZE 1048576
+#define BENCH_ZSTD_LEVEL      3
+
+enum bench_codec
+{
+   BENCH_ZLIB = 0,
+   BENCH_ZSTD_REFERENCE,
+   BENCH_ZSTD_BUILTIN
+};
+
+static uint32_t prng_state = 0x1234567u;
+static uint32_t prng(void)
+{
+   prng_state ^= prng_state << 13;
+   prng_state ^= prng_state >> 17;
+   prng_state ^= prng_state << 5;
+   return prng_state;
+}
+
+static void put_le(uint8_t *p, uint64_t v, unsigned n)
+{
+   unsigned i;
+   for (i = 0; i < n; i++)
+      p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static uint8_t *make_synthetic_state(size_t len)
+{
+   size_t i;
+   uint8_t *buf = (uint8_t*)malloc(len);
+
+   if (!buf)
+      return NULL;
+
+   for (i = 0; i < len; i++)
+   {
+      size_t region = (i * 8) / len;
+
+      switch (region)
+      {
+         case 0: /* Work RAM: mostly small counters and flags */
+            buf[i] = (prng() & 7) ? 0 : (uint8_t)(prng() & 0x1f);
+            break;
+         case 1:
+         case 2: /* Tile data: short patterns, repeated */
+            buf[i] = (uint8_t)((i >> 3) * 0x11 + (i & 3));
+            if (!(prng() & 63))
+               buf[i] ^= (uint8_t)prng();
+            break;
+         case 3: /* Tile map: runs of the same index */
+            buf[i] = (uint8_t)((i >> 6) & 0xff);
+            break;
+         case 4: /* Sound RAM: noisy samples */
+            buf[i] = (uint8_t)(prng() & 0xff);
+            break;
+         default: /* Unused memory */
+            buf[i] = 0;
+            break;
+      }
+   }
+
+   return buf;
+}
+
+typedef struct
+{
+   uint64_t enc_usec;
+   uint64_t dec_usec;
+   uint64_t packed;
+   bool ok;
+} codec_result_t;
+
+static uint32_t get_le32(const uint8_t *p)
+{
+   return (uint32_t)p[0]
+        | ((uint32_t)p[1] <<  8)
+        | ((uint32_t)p[2] << 16)
+        | ((uint32_t)p[3] << 24);
+}
+
+/* Compresses one chunk into 'out'; returns its size, or 0 */
+static size_t bench_compress(enum bench_codec codec, void *state,
+      uint8_t *out, size_t out_cap, const uint8_t *in, size_t len)
+{
+   switch (codec)
+   {
+      case BENCH_ZLIB:
+         {
+            const struct trans_stream_backend *def =
+                  trans_stream_get_zlib_deflate_backend();
+            uint32_t rd = 0, wr = 0;
+
+            def->set_in(state, in, (uint32_t)len);
+            def->set_out(state, out, (uint32_t)out_cap);
+            if (!def->trans(state, true, &rd, &wr, NULL) || (rd != len))
+               return 0;
+            return wr;
+         }
+#ifdef HAVE_ZSTD
+      case BENCH_ZSTD_REFERENCE:
+         {
+            size_t wr = ZSTD_compressCCtx((ZSTD_CCtx*)state,
+                  out, out_cap, in, len, BENCH_ZSTD_LEVEL);
+            return ZSTD_isError(wr) ? 0 : wr;
+         }
+#endif
+#ifdef HAVE_RZSTD
+      case BENCH_ZSTD_BUILTIN:
+         {
+            size_t wr = 0;
+            if (rzstd_encode(out, out_cap, in, len,
+                  BENCH_ZSTD_LEVEL, &wr) != RZSTD_PROCESS_END)
+               return 0;
+            return wr;
+         }
+#endif
+      default:
+         break;
+   }
+   return 0;
+}
+
+/* Decompresses one chunk into 'out'; returns its size, or 0 */
+static size_t bench_decompress(enum bench_codec codec, void *state,
+      uint8_t *out, size_t out_cap, const uint8_t *in, size_t len)
+{
+   if (codec == BENCH_ZLIB)
+   {
+      const struct trans_stream_backend *inf =
+            trans_stream_get_zlib_inflate_backend();
+      uint32_t rd = 0, wr = 0;
+      enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+
+      inf->set_in(state, in, (uint32_t)len);
+      inf->set_out(state, out, (uint32_t)out_cap);
+      if (   !inf->trans(state, true, &rd, &wr, &err)
+          || (err != TRANS_STREAM_ERROR_NONE))
+         return 0;
+      return wr;
+   }
+
+   /* Whichever decoder rzip_stream.c would use */
+#ifdef HAVE_RZSTD
+   {
+      size_t wr = 0;
+      if (rzstd_decode(out, out_cap, in, len, &wr) != RZSTD_PROCESS_END)
+         return 0;
+      return wr;
+   }
+#elif defined(HAVE_ZSTD)
+   {
+      size_t wr = ZSTD_decompress(out, out_cap, in, len);
+      return ZSTD_isError(wr) ? 0 : wr;
+   }
+#else
+   return 0;
+#endif
+}
+
+/* Compresses every chunk of 'data' into 'file', laid out as an RZIP
+ * file of the codec's version would be, then decompresses it all
+ * again, 'iters' times over */
+static void bench_codec(enum bench_codec codec,
+      const uint8_t *data, size_t len, unsigned iters,
+      uint8_t *file, size_t file_cap, uint8_t *scratch,
+      codec_result_t *res)
+{
+   const struct trans_stream_backend *def =
+         trans_stream_get_zlib_deflate_backend();
+   const struct trans_stream_backend *inf =
+         trans_stream_get_zlib_inflate_backend();
+   size_t chunk = (codec == BENCH_ZLIB)
+         ? BENCH_ZLIB_CHUNK_SIZE : BENCH_ZSTD_CHUNK_SIZE;
+   void *enc    = NULL;
+   void *dec    = NULL;
+   unsigned it;
+
+   memset(res, 0, sizeof(*res));
+
+   switch (codec)
+   {
+      case BENCH_ZLIB:
+         if ((enc = def->stream_new()))
+            def->define(enc, "level", BENCH_ZLIB_LEVEL);
+         dec = inf->stream_new();
+         res->ok = enc && dec;
+         break;
+#ifdef HAVE_ZSTD
+      case BENCH_ZSTD_REFERENCE:
+         res->ok = !!(enc = ZSTD_createCCtx());
+         break;
+#endif
+      default:
+         res->ok = true;
+         break;
+   }
+
+   for (it = 0; res->ok && (it < iters); it++)
+   {
+      size_t   off;
+      size_t   pos = BENCH_HEADER_SIZE;
+      uint64_t t0  = cpu_features_get_time_usec();
+
+      for (off = 0; res->ok && (off < len); off += chunk)
+      {
+         size_t n  = (len - off < chunk) ? len - off : chunk;
+         size_t wr = bench_compress(codec, enc, file + pos + 4,
+               file_cap - pos - 4, data + off, n);
+
+         if (!wr)
+            res->ok = false;
+         put_le(file + pos, wr, 4);
+         pos += 4 + wr;
+      }
+      res->enc_usec += cpu_features_get_time_usec() - t0;
+      res->packed    = pos;
+
+      t0 = cpu_features_get_time_usec();
+      for (off = 0, pos = BENCH_HEADER_SIZE; res->ok && (off < len);
+            off += chunk)
+      {
+         size_t   n  = (len - off < chunk) ? len - off : chunk;
+         uint32_t cn = get_le32(file + pos);
+
+         if (   (bench_decompress(codec, dec, scratch, chunk,
+                  file + pos + 4, cn) != n)
+             || memcmp(scratch, data + off, n))
+            res->ok = false;
+         pos += 4 + cn;
+      }
+      res->dec_usec += cpu_features_get_time_usec() - t0;
+   }
+
+   if (codec == BENCH_ZLIB)
+   {
+      if (enc)
+         def->stream_free(enc);
+      if (dec)
+         inf->stream_free(dec);
+   }
+#ifdef HAVE_ZSTD
+   else if (enc)
+      ZSTD_freeCCtx((ZSTD_CCtx*)enc);
+#endif
+
+   /* Finish the header around the chunks */
+   memcpy(file, "#RZIPv\x01#", 8);
+   file[6] = (codec == BENCH_ZLIB) ? 1 : 2;
+   put_le(file + 8,  chunk, 4);
+   put_le(file + 12, len, 8);
+}
+
+/* Reads 'path' back through rzip_stream.c and compares it with 'data' */
+static bool read_back_matches(const char *path,
+      const uint8_t *data, size_t len)
+{
+   void   *buf = NULL;
+   int64_t got = 0;
+   bool    ok  = rzipstream_read_file(path, &buf, &got)
+         && (got == (int64_t)len)
+         && !memcmp(buf, data, len);
+
+   free(buf);
+   return ok;
+}
+
+static void print_codec(const char *name, const codec_result_t *res,
+      const codec_result_t *base, size_t len, unsigned iters)
+{
+   double mb = (double)len * iters / (1024.0 * 1024.0);
+
+   printf("  %-12s ratio %6.2f%%  compress %8.1f MB/s  "
+         "decompress %8.1f MB/s",
+         name, 100.0 * (double)res->packed / (double)len,
+         mb / ((double)(res->enc_usec ? res->enc_usec : 1) / 1e6),
+         mb / ((double)(res->dec_usec ? res->dec_usec : 1) / 1e6));
+   if (base)
+      printf("  (%.2fx / %.2fx, %+.2f%% size)",
+            (double)base->enc_usec
+                  / (double)(res->enc_usec ? res->enc_usec : 1),
+            (double)base->dec_usec
+                  / (double)(res->dec_usec ? res->dec_usec : 1),
+            100.0 * ((double)res->packed - (double)base->packed)
+                  / (double)base->packed);
+   printf("\n");
+}
+
+static int bench_state(const char *label, const uint8_t *data, size_t len,
+      unsigned iters)
+{
+   static const struct
+   {
+      enum bench_codec codec;
+      const char *name;
+   } codecs[] = {
+      { BENCH_ZLIB,           "v1 zlib"  },
+#ifdef HAVE_ZSTD
+      { BENCH_ZSTD_REFERENCE, "v2 zstd"  },
+#endif
+#ifdef HAVE_RZSTD
+      { BENCH_ZSTD_BUILTIN,   "v2 rzstd" },
+#endif
+   };
+   const char *tmp_path = "rzip_bench.tmp";
+   /* Worst case of either codec on incompressible input is well
+    * under double; the chunk headers are counted separately */
+   size_t file_cap      = BENCH_HEADER_SIZE + len * 2
+         + (len / BENCH_ZLIB_CHUNK_SIZE + 1) * (4 + 1024);
+   uint8_t *file        = (uint8_t*)malloc(file_cap);
+   uint8_t *scratch     = (uint8_t*)malloc(BENCH_ZSTD_CHUNK_SIZE);
+   codec_result_t base;
+   unsigned i;
+   int ret              = 1;
+
+   if (!file || !scratch || !len)
+      goto done;
+
+   printf("%s: %u bytes, %u iterations\n",
+         label, (unsigned)len, iters);
+
+   for (i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++)
+   {
+      codec_result_t res;
+
+      bench_codec(codecs[i].codec, data, len, iters,
+            file, file_cap, scratch, &res);
+      if (!res.ok)
+      {
+         printf("  %s round trip FAILED\n", codecs[i].name);
+         goto done;
+      }
+      if (i == 0)
+         base = res;
+      print_codec(codecs[i].name, &res, i ? &base : NULL, len, iters);
+
+      /* What bench_codec() left behind is a complete RZIP file of
+       * that version: it has to read back */
+      if (   !filestream_write_file(tmp_path, file, (int64_t)res.packed)
+          || !read_back_matches(tmp_path, data, len))
+      {
+         printf("  %s file FAILED to read back\n", codecs[i].name);
+         goto done;
+      }
+   }
+
+   /* And so must what the stream writes today */
+   if (   !rzipstream_write_file(tmp_path, data, (int64_t)len)
+       || !read_back_matches(tmp_path, data, len))
+   {
+      printf("  current format FAILED to read back\n");
+      goto done;
+   }
+
+   ret = 0;
+
+done:
+   filestream_delete(tmp_path);
+   free(file);
+   free(scratch);
+   return ret;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   int ret        = 0;
+   unsigned iters = 5;
+   bool any_state = false;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "--iters") && (i + 1 < argc))
+      {
+         iters = (unsigned)strtoul(argv[++i], NULL, 10);
+         if (!iters)
+            iters = 1;
+         continue;
+      }
+
+      {
+         void   *data = NULL;
+         int64_t len  = 0;
+
+         any_state = true;
+         /* Expands RZIP states, passes raw ones through */
+         if (!rzipstream_read_file(argv[i], &data, &len) || (len <= 0))
+         {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            free(data);
+            ret = 1;
+            continue;
+         }
+         ret |= bench_state(argv[i], (const uint8_t*)data,
+               (size_t)len, iters);
+         free(data);
+      }
+   }
+
+   if (!any_state)
+   {
+      size_t   len  = 2 * 1024 * 1024;
+      uint8_t *data = make_synthetic_state(len);
+
+      if (!data)
+         return 1;
+      ret = bench_state("synthetic state", data, len, iters);
+      free(data);
+   }
+
+   return ret;
+}
@@ -0,0 +1,244 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (cache_file.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <streams/cache_file.h>
+
+void cache_file_put(cache_file_writer_t *w, const void *data, size_t len)
+{
+   if (w->error)
+      return;
+
+   if (w->len + len > w->cap)
+   {
+      uint8_t *tmp;
+      size_t cap = w->cap ? w->cap : 16 * 1024;
+
+      while (cap < w->len + len)
+         cap *= 2;
+      if (!(tmp = (uint8_t*)realloc(w->data, cap)))
+      {
+         w->error = true;
+         return;
+      }
+      w->data = tmp;
+      w->cap  = cap;
+   }
+
+   memcpy(w->data + w->len, data, len);
+   w->len += len;
+}
+
+void cache_file_put8(cache_file_writer_t *w, unsigned v)
+{
+   uint8_t b = (uint8_t)v;
+   cache_file_put(w, &b, 1);
+}
+
+void cache_file_put16(cache_file_writer_t *w, unsigned v)
+{
+   uint8_t b[2];
+   b[0] = (uint8_t)v;
+   b[1] = (uint8_t)(v >> 8);
+   cache_file_put(w, b, sizeof(b));
+}
+
+void cache_file_put32(cache_file_writer_t *w, uint32_t v)
+{
+   uint8_t b[4];
+   b[0] = (uint8_t)v;
+   b[1] = (uint8_t)(v >> 8);
+   b[2] = (uint8_t)(v >> 16);
+   b[3] = (uint8_t)(v >> 24);
+   cache_file_put(w, b, sizeof(b));
+}
+
+void cache_file_put64(cache_file_writer_t *w, uint64_t v)
+{
+   cache_file_put32(w, (uint32_t)v);
+   cache_file_put32(w, (uint32_t)(v >> 32));
+}
+
+void cache_file_put_varint(cache_file_writer_t *w, uint32_t v)
+{
+   uint8_t b[5];
+   size_t len = 0;
+   while (v >= 0x80)
+   {
+      b[len++] = (uint8_t)(v | 0x80);
+      v      >>= 7;
+   }
+   b[len++] = (uint8_t)v;
+   cache_file_put(w, b, len);
+}
+
+bool cache_file_put_str(cache_file_writer_t *w, const char *s)
+{
+   size_t len = s ? strlen(s) : 0;
+   if (len > CACHE_FILE_STR_MAX)
+      return false;
+   cache_file_put16(w, (unsigned)len);
+   cache_file_put(w, s, len);
+   return true;
+}
+
+void cache_file_patch32(cache_file_writer_t *w, size_t offset, uint32_t v)
+{
+   if (w->error || offset + 4 > w->len)
+      return;
+   w->data[offset    ] = (uint8_t)v;
+   w->data[offset + 1] = (uint8_t)(v >> 8);
+   w->data[offset + 2] = (uint8_t)(v >> 16);
+   w->data[offset + 3] = (uint8_t)(v >> 24);
+}
+
+bool cache_file_write(const cache_file_writer_t *w, const char *path)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   size_t len;
+
+   if (w->error || !path || !*path)
+      return false;
+
+   len = strlcpy(tmp_path, path, sizeof(tmp_path));
+   if (len + STRLEN_CONST(".tmp") >= sizeof(tmp_path))
+      return false;
+   strlcpy(tmp_path + len, ".tmp", sizeof(tmp_path) - len);
+
+   if (!filestream_write_file(tmp_path, w->data, (int64_t)w->len))
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   if (filestream_replace(tmp_path, path) != 0)
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   return true;
+}
+
+void cache_file_writer_free(cache_file_writer_t *w)
+{
+   free(w->data);
+   w->data  = NULL;
+   w->len   = 0;
+   w->cap   = 0;
+   w->error = false;
+}
+
+void cache_file_reader_init(cache_file_reader_t *r,
+      const void *data, size_t len)
+{
+   r->ptr   = (const uint8_t*)data;
+   r->end   = r->ptr + len;
+   r->error = false;
+}
+
+const uint8_t *cache_file_get(cache_file_reader_t *r, size_t len)
+{
+   const uint8_t *p = r->ptr;
+   if ((size_t)(r->end - r->ptr) < len)
+   {
+      r->error = true;
+      r->ptr   = r->end;
+      return NULL;
+   }
+   r->ptr += len;
+   return p;
+}
+
+unsigned cache_file_get8(cache_file_reader_t *r)
+{
+   const uint8_t *p = cache_file_get(r, 1);
+   return p ? p[0] : 0;
+}
+
+unsigned cache_file_get16(cache_file_reader_t *r)
+{
+   const uint8_t *p = cache_file_get(r, 2);
+   return p ? (unsigned)(p[0] | (p[1] << 8)) : 0;
+}
+
+uint32_t cache_file_get32(cache_file_reader_t *r)
+{
+   const uint8_t *p = cache_file_get(r, 4);
+   if (!p)
+      return 0;
+   return    (uint32_t)p[0]        | ((uint32_t)p[1] << 8)
+          | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t cache_file_get64(cache_file_reader_t *r)
+{
+   uint64_t lo = cache_file_get32(r);
+   return lo | ((uint64_t)cache_file_get32(r) << 32);
+}
+
+uint32_t cache_file_get_varint(cache_file_reader_t *r)
+{
+   unsigned shift;
+   uint32_t v = 0;
+   for (shift = 0; shift < 35; shift += 7)
+   {
+      const uint8_t *p = cache_file_get(r, 1);
+      if (!p)
+         return 0;
+      v |= (uint32_t)(*p & 0x7F) << shift;
+      if (!(*p & 0x80))
+         return v;
+   }
+   r->error = true;
+   return 0;
+}
+
+const char *cache_file_get_str(cache_file_reader_t *r, size_t *len)
+{
+   *len = cache_file_get16(r);
+   if (r->error)
+   {
+      *len = 0;
+      return NULL;
+   }
+   return (const char*)cache_file_get(r, *len);
+}
+
+char *cache_file_get_strdup(cache_file_reader_t *r)
+{
+   size_t len;
+   char *s;
+   const char *p = cache_file_get_str(r, &len);
+
+   if (!p || !(s = (char*)malloc(len + 1)))
+      return NULL;
+   memcpy(s, p, len);
+   s[len] = '\0';
+   return s;
+}
@@ -32,6 +32,9 @@
 #ifdef HAVE_RCHD
 #include <formats/rchd.h>
 #include <streams/file_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 #else
 #include <libchdr/chd.h>
 #endif
@@ -41,6 +44,51 @@
 #define SUBCODE_SIZE 96
 #define TRACK_PAD 4
 
+#ifdef HAVE_RCHD
+/* Size of the buffer a step loop reads requested ranges through */
+#define CHDSTREAM_IO_SIZE 65536
+
+#ifdef HAVE_THREADS
+/* Threads decoding ahead of one stream, at most */
+#define CHDSTREAM_AHEAD_THREADS 2
+/* Consecutive hunks read in order before the read-ahead starts, so a
+ * stream opened to hash a few sectors never spawns a thread */
+#define CHDSTREAM_AHEAD_TRIGGER 3
+
+enum chdstream_slot_state
+{
+   CHDSTREAM_SLOT_FREE = 0,
+   CHDSTREAM_SLOT_QUEUED,
+   CHDSTREAM_SLOT_BUSY,
+   CHDSTREAM_SLOT_READY,
+   CHDSTREAM_SLOT_FAILED
+};
+
+typedef struct chdstream_slot
+{
+   uint8_t *data;
+   uint32_t hunk;
+   enum chdstream_slot_state state;
+} chdstream_slot_t;
+
+/* Hunks being decoded ahead of a sequential reader. Each thread opens
+ * the image for itself, since an rchd handle decodes one hunk at a time
+ * and holds the codec state doing it; the slots are all they share. */
+typedef struct chdstream_ahead
+{
+   slock_t          *lock;
+   scond_t          *cond;
+   sthread_t        *threads[CHDSTREAM_AHEAD_THREADS];
+   chdstream_slot_t *slots;
+   char             *path;
+   uint32_t          count;
+   uint32_t          hunk_bytes;
+   unsigned          thread_count;
+   bool              quit;
+} chdstream_ahead_t;
+#endif
+#endif
+
 struct chdstream
 {
 #ifdef HAVE_RCHD
@@ -48,8 +96,19 @@ struct chdstream
    /* rchd never touches a file: it names the byte ranges it needs and
     * this supplies them, so the stream owns the handle. */
    RFILE    *file;
+   uint8_t  *iobuf;
    uint32_t  hunk_bytes;
    uint32_t  unit_bytes;
+   uint32_t  hunk_count;
+#ifdef HAVE_THREADS
+   chdstream_ahead_t *ahead;
+   /* Image path, for the read-ahead threads to open their own handles */
+   char     *path;
+   /* Hunks to decode ahead, and how many in a row have been read in
+    * order so far */
+   uint32_t  readahead;
+   uint32_t  run;
+#endif
 #else
    chd_file *chd;
 #endif
@@ -385,13 +444,12 @@ chdstream_find_track(chd_file *fd, int32_t track, metadata_t *meta)
 
 #ifdef HAVE_RCHD
 /* Drives an rchd step loop, supplying whatever range it asks for from
- * the open file. rchd asks for one range at a time and says so by
- * returning RCHD_PENDING, so this is the whole of the I/O. */
+ * the open file through @buf, CHDSTREAM_IO_SIZE bytes. rchd asks for
+ * one range at a time and says so by returning RCHD_PENDING, so this is
+ * the whole of the I/O. */
 static bool chdstream_pump(RFILE *f, rchd_t *chd, int opening,
-      rchd_request_t *rq)
+      rchd_request_t *rq, uint8_t *buf)
 {
-   static uint8_t buf[65536];
-
    for (;;)
    {
       int    e = opening ? rchd_open_step(chd, rq)
@@ -403,7 +461,8 @@ static bool chdstream_pump(RFILE *f, rchd_t *chd, int opening,
       if (e != RCHD_PENDING)
          return false;
 
-      want = rq->length > sizeof(buf) ? sizeof(buf) : rq->length;
+      want = rq->length > CHDSTREAM_IO_SIZE ? CHDSTREAM_IO_SIZE
+                                            : rq->length;
       if (filestream_seek(f, (int64_t)rq->offset,
                RETRO_VFS_SEEK_POSITION_START) < 0)
          return false;
@@ -474,6 +533,221 @@ static const rchd_track_t *chdstream_track_of(rchd_t *chd, int32_t track)
    }
    return NULL;
 }
+
+#ifdef HAVE_THREADS
+/* The queued slot nearest the reader, which is the one it needs soonest */
+static chdstream_slot_t *chdstream_ahead_next(chdstream_ahead_t *ahead)
+{
+   uint32_t          i;
+   chdstream_slot_t *next = NULL;
+
+   for (i = 0; i < ahead->count; i++)
+   {
+      chdstream_slot_t *slot = &ahead->slots[i];
+
+      if (slot->state == CHDSTREAM_SLOT_QUEUED
+            && (!next || slot->hunk < next->hunk))
+         next = slot;
+   }
+   return next;
+}
+
+static void chdstream_ahead_thread(void *data)
+{
+   rchd_request_t     rq;
+   chdstream_ahead_t *ahead = (chdstream_ahead_t*)data;
+   rchd_t            *chd   = NULL;
+   uint8_t           *iobuf = (uint8_t*)malloc(CHDSTREAM_IO_SIZE);
+   RFILE             *file  = filestream_open(ahead->path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   /* A thread that cannot open the image just leaves: whatever it would
+    * have decoded stays queued, and the reader decodes that itself. */
+   if (     iobuf
+         && file
+         && (chd = rchd_new())
+         && chdstream_pump(file, chd, 1, &rq, iobuf))
+   {
+      slock_lock(ahead->lock);
+      while (!ahead->quit)
+      {
+         bool              ok;
+         chdstream_slot_t *slot = chdstream_ahead_next(ahead);
+
+         if (!slot)
+         {
+            scond_wait(ahead->cond, ahead->lock);
+            continue;
+         }
+
+         slot->state = CHDSTREAM_SLOT_BUSY;
+         slock_unlock(ahead->lock);
+
+         ok = rchd_read_hunk_begin(chd, slot->hunk, slot->data) == RCHD_OK
+            && chdstream_pump(file, chd, 0, &rq, iobuf);
+
+         slock_lock(ahead->lock);
+         slot->state = ok ? CHDSTREAM_SLOT_READY : CHDSTREAM_SLOT_FAILED;
+         scond_broadcast(ahead->cond);
+      }
+      slock_unlock(ahead->lock);
+   }
+
+   if (chd)
+      rchd_free(chd);
+   if (file)
+      filestream_close(file);
+   free(iobuf);
+}
+
+static void chdstream_ahead_free(chdstream_ahead_t *ahead)
+{
+   unsigned i;
+
+   if (!ahead)
+      return;
+
+   if (ahead->thread_count)
+   {
+      slock_lock(ahead->lock);
+      ahead->quit = true;
+      scond_broadcast(ahead->cond);
+      slock_unlock(ahead->lock);
+      for (i = 0; i < ahead->thread_count; i++)
+         sthread_join(ahead->threads[i]);
+   }
+
+   if (ahead->slots)
+      for (i = 0; i < ahead->count; i++)
+         free(ahead->slots[i].data);
+   free(ahead->slots);
+   if (ahead->cond)
+      scond_free(ahead->cond);
+   if (ahead->lock)
+      slock_free(ahead->lock);
+   free(ahead);
+}
+
+static chdstream_ahead_t *chdstream_ahead_new(const chdstream_t *stream)
+{
+   uint32_t           i;
+   unsigned           threads;
+   chdstream_ahead_t *ahead = (chdstream_ahead_t*)calloc(1, sizeof(*ahead));
+
+   if (!ahead)
+      return NULL;
+
+   ahead->path       = stream->path;
+   ahead->count      = stream->readahead;
+   ahead->hunk_bytes = stream->hunk_bytes;
+   if (     !(ahead->lock  = slock_new())
+         || !(ahead->cond  = scond_new())
+         || !(ahead->slots = (chdstream_slot_t*)calloc(ahead->count,
+               sizeof(chdstream_slot_t))))
+      goto error;
+   for (i = 0; i < ahead->count; i++)
+      if (!(ahead->slots[i].data = (uint8_t*)malloc(ahead->hunk_bytes)))
+         goto error;
+
+   threads = ahead->count < CHDSTREAM_AHEAD_THREADS
+      ? ahead->count : CHDSTREAM_AHEAD_THREADS;
+   while (ahead->thread_count < threads)
+   {
+      sthread_t *thread = sthread_create(chdstream_ahead_thread, ahead);
+      if (!thread)
+         break;
+      ahead->threads[ahead->thread_count++] = thread;
+   }
+   if (!ahead->thread_count)
+      goto error;
+   return ahead;
+
+error:
+   chdstream_ahead_free(ahead);
+   return NULL;
+}
+
+/* Hands the reader @hunk if a thread decoded it, swapping buffers rather
+ * than copying. Waits only for a hunk a thread is decoding right now;
+ * one still queued is taken back and left to the caller. */
+static bool chdstream_ahead_take(chdstream_t *stream, uint32_t hunk)
+{
+   uint32_t           i;
+   bool               taken = false;
+   chdstream_ahead_t *ahead = stream->ahead;
+
+   slock_lock(ahead->lock);
+   for (i = 0; i < ahead->count; i++)
+   {
+      chdstream_slot_t *slot = &ahead->slots[i];
+
+      if (slot->state == CHDSTREAM_SLOT_FREE || slot->hunk != hunk)
+         continue;
+
+      while (slot->state == CHDSTREAM_SLOT_BUSY)
+         scond_wait(ahead->cond, ahead->lock);
+
+      if (slot->state == CHDSTREAM_SLOT_READY)
+      {
+         uint8_t *data   = slot->data;
+         slot->data      = stream->hunkmem;
+         stream->hunkmem = data;
+         taken           = true;
+      }
+      slot->state = CHDSTREAM_SLOT_FREE;
+      break;
+   }
+   slock_unlock(ahead->lock);
+   return taken;
+}
+
+/* Queues the hunks after @hunk that are not already in hand. A slot
+ * holding anything outside that window is fair game, unless a thread is
+ * busy with it. */
+static void chdstream_ahead_queue(chdstream_t *stream, uint32_t hunk)
+{
+   uint32_t           i, j;
+   chdstream_ahead_t *ahead = stream->ahead;
+
+   slock_lock(ahead->lock);
+   for (i = 1; i <= ahead->count; i++)
+   {
+      chdstream_slot_t *slot = NULL;
+      uint32_t          want = hunk + i;
+
+      if (want >= stream->hunk_count)
+         break;
+
+      for (j = 0; j < ahead->count; j++)
+         if (     ahead->slots[j].state != CHDSTREAM_SLOT_FREE
+               && ahead->slots[j].hunk  == want)
+            break;
+      if (j < ahead->count)
+         continue;
+
+      for (j = 0; j < ahead->count; j++)
+      {
+         chdstream_slot_t *s = &ahead->slots[j];
+
+         if (s->state == CHDSTREAM_SLOT_FREE)
+         {
+            slot = s;
+            break;
+         }
+         if (     s->state != CHDSTREAM_SLOT_BUSY
+               && (s->hunk <= hunk || s->hunk > hunk + ahead->count))
+            slot = s;
+      }
+      if (!slot)
+         break;
+
+      slot->hunk  = want;
+      slot->state = CHDSTREAM_SLOT_QUEUED;
+   }
+   scond_broadcast(ahead->cond);
+   slock_unlock(ahead->lock);
+}
+#endif  /* HAVE_THREADS */
 #endif  /* HAVE_RCHD */
 
 #ifdef HAVE_RCHD
@@ -486,24 +760,35 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    rchd_t             *chd    = NULL;
    RFILE              *file   = filestream_open(path,
          RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   uint8_t            *iobuf  = (uint8_t*)malloc(CHDSTREAM_IO_SIZE);
    uint32_t            pregap = 0;
 
-   if (!file)
-      return NULL;
+   if (!file || !iobuf)
+      goto error;
    if (!(chd = rchd_new()))
       goto error;
-   if (!chdstream_pump(file, chd, 1, &rq))
+   if (!chdstream_pump(file, chd, 1, &rq, iobuf))
       goto error;
    if (!(t = chdstream_track_of(chd, track)))
       goto error;
+   if (rchd_set_cache_hunks(chd, CHDSTREAM_CACHE_HUNKS) != RCHD_OK)
+      goto error;
    if (!(stream = (chdstream_t*)malloc(sizeof(*stream))))
       goto error;
 
    info                    = rchd_info(chd);
    stream->chd             = NULL;
    stream->file            = NULL;
+   stream->iobuf           = NULL;
    stream->hunk_bytes      = info->hunk_bytes;
    stream->unit_bytes      = info->unit_bytes;
+   stream->hunk_count      = info->hunk_count;
+#ifdef HAVE_THREADS
+   stream->ahead           = NULL;
+   stream->readahead       = CHDSTREAM_READAHEAD_HUNKS;
+   stream->run             = 0;
+   stream->path            = NULL;
+#endif
    stream->swab            = false;
    stream->frame_size      = 0;
    stream->frame_offset    = 0;
@@ -515,6 +800,11 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
    stream->hunknum         = -1;
    if (!(stream->hunkmem = (uint8_t*)malloc(info->hunk_bytes)))
       goto error;
+#ifdef HAVE_THREADS
+   if (!(stream->path = (char*)malloc(strlen(path) + 1)))
+      goto error;
+   strcpy(stream->path, path);
+#endif
 
    /* rchd reports the track's type rather than the text it was written
     * as, so this is a switch on a number where the libchdr path parsed
@@ -548,6 +838,7 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
 
    stream->chd             = chd;
    stream->file            = file;
+   stream->iobuf           = iobuf;
    stream->frames_per_hunk = info->hunk_bytes / info->unit_bytes;
    stream->track_frame     = (uint32_t)(t->logical_offset
                                         / info->unit_bytes);
@@ -559,6 +850,9 @@ chdstream_t *chdstream_open(const char *path, int32_t track)
 error:
    if (stream)
    {
+#ifdef HAVE_THREADS
+      free(stream->path);
+#endif
       free(stream->hunkmem);
       free(stream);
    }
@@ -566,6 +860,7 @@ error:
       rchd_free(chd);
    if (file)
       filestream_close(file);
+   free(iobuf);
    return NULL;
 }
 #else
@@ -652,10 +947,16 @@ void chdstream_close(chdstream_t *stream)
    if (stream->hunkmem)
       free(stream->hunkmem);
 #ifdef HAVE_RCHD
+#ifdef HAVE_THREADS
+   /* Before the path goes: the threads are still reading it */
+   chdstream_ahead_free(stream->ahead);
+   free(stream->path);
+#endif
    if (stream->chd)
       rchd_free(stream->chd);
    if (stream->file)
       filestream_close(stream->file);
+   free(stream->iobuf);
 #else
    if (stream->chd)
       chd_close(stream->chd);
@@ -674,12 +975,34 @@ chdstream_load_hunk(chdstream_t *stream, uint32_t hunknum)
 #ifdef HAVE_RCHD
    {
       rchd_request_t rq;
-
-      if (rchd_read_hunk_begin(stream->chd, hunknum,
-               stream->hunkmem) != RCHD_OK)
-         return false;
-      if (!chdstream_pump(stream->file, stream->chd, 0, &rq))
-         return false;
+#ifdef HAVE_THREADS
+      /* Read-ahead pays off only for a reader moving forward, so it
+       * starts once one has been seen, and a seek elsewhere just stops
+       * feeding it; what it already decoded may still be wanted. */
+      if ((int)hunknum == stream->hunknum + 1)
+         stream->run++;
+      else
+         stream->run = 0;
+      if (     !stream->ahead
+            && stream->readahead
+            && stream->run >= CHDSTREAM_AHEAD_TRIGGER
+            && !(stream->ahead = chdstream_ahead_new(stream)))
+         stream->readahead = 0;
+
+      if (!stream->ahead || !chdstream_ahead_take(stream, hunknum))
+#endif
+      {
+         if (rchd_read_hunk_begin(stream->chd, hunknum,
+                  stream->hunkmem) != RCHD_OK)
+            return false;
+         if (!chdstream_pump(stream->file, stream->chd, 0, &rq,
+                  stream->iobuf))
+            return false;
+      }
+#ifdef HAVE_THREADS
+      if (stream->ahead && stream->run)
+         chdstream_ahead_queue(stream, hunknum);
+#endif
    }
 #else
    if (chd_read(stream->chd, hunknum, stream->hunkmem) != CHDERR_NONE)
@@ -754,6 +1077,29 @@ ssize_t chdstream_read(chdstream_t *stream, void *data, size_t bytes)
    return bytes;
 }
 
+bool chdstream_set_cache(chdstream_t *stream, uint32_t cache_hunks,
+      uint32_t readahead_hunks)
+{
+#ifdef HAVE_RCHD
+   if (rchd_set_cache_hunks(stream->chd,
+            cache_hunks ? cache_hunks : 1) != RCHD_OK)
+      return false;
+#ifdef HAVE_THREADS
+   if (readahead_hunks != stream->readahead)
+   {
+      /* Restarted at the new depth by the next run of sequential reads */
+      chdstream_ahead_free(stream->ahead);
+      stream->ahead     = NULL;
+      stream->readahead = readahead_hunks;
+   }
+#endif
+   return true;
+#else
+   /* libchdr keeps its own cache and reads nothing ahead */
+   return false;
+#endif
+}
+
 int chdstream_getc(chdstream_t *stream)
 {
    char c = 0;
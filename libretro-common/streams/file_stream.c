@@ -1572,6 +1572,30 @@ int filestream_flush(RFILE *stream)
    return output;
 }
 
+int filestream_sync(RFILE *stream)
+{
+   int output;
+
+   if (!stream)
+      return -1;
+
+   /* The VFS interface has no sync; a flush is all it offers */
+   if (filestream_flush_cb)
+      return filestream_flush(stream);
+
+   filestream_rbuf_discard(stream);
+
+   output = retro_vfs_file_sync_impl(
+         (libretro_vfs_implementation_file*)stream->hfile);
+
+   if (output == VFS_ERROR_RETURN_VALUE)
+      stream->err_flag = true;
+   else
+      stream->last_io = FILESTREAM_LAST_IO_NONE;
+
+   return output;
+}
+
 int filestream_delete(const char *path)
 {
    if (filestream_remove_cb)
@@ -1588,6 +1612,39 @@ int filestream_rename(const char *old_path, const char *new_path)
    return retro_vfs_file_rename_impl(old_path, new_path);
 }
 
+int filestream_replace(const char *from, const char *to)
+{
+   char saved[PATH_MAX_LENGTH];
+   size_t _len;
+
+   /* On POSIX this is the atomic replace and the only step taken */
+   if (filestream_rename(from, to) == 0)
+      return 0;
+
+   /* Either a VFS whose rename will not replace an existing file, or
+    * the move itself failed.  Move the original aside first, so that at
+    * every instant either the destination or the saved copy is a
+    * complete file, and put it back if the second move fails. */
+   _len = strlen(to);
+   if (_len + sizeof(".old") > sizeof(saved))
+      return -1;
+   memcpy(saved, to, _len);
+   memcpy(saved + _len, ".old", sizeof(".old"));
+
+   filestream_delete(saved);          /* a leftover from a previous run */
+   if (filestream_rename(to, saved) != 0)
+      return -1;                      /* original untouched; give up   */
+
+   if (filestream_rename(from, to) == 0)
+   {
+      filestream_delete(saved);
+      return 0;
+   }
+
+   filestream_rename(saved, to);      /* put the original back */
+   return -1;
+}
+
 int filestream_copy(const char *src, const char *dst)
 {
    char buf[256] = {0};
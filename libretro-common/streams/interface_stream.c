@@ -713,9 +713,8 @@ int intfstream_eof(intfstream_internal_t *intf)
       case INTFSTREAM_FILE:
          return filestream_eof(intf->file.fp);
       case INTFSTREAM_MEMORY:
-         /* TODO: Add this functionality to
-          * memory_stream interface */
-         break;
+         return (memstream_pos(intf->memory.fp)
+               >= memstream_get_size(intf->memory.fp));
       case INTFSTREAM_CHD:
          /* TODO: Add this functionality to
           * chd_stream interface */
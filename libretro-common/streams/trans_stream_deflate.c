@@ -38,6 +38,8 @@ struct deflate_trans_stream
    int      level;
    int      is_inflate;
    int      finished;     /* END has been reached                         */
+   int      sync_flush;   /* a flushing trans() cuts a sync point instead
+                           * of ending the stream                         */
    uint32_t in_size;      /* size of the buffer last given to set_in       */
    uint32_t in_done;      /* input consumed so far from the current set_in  */
    uint32_t out_size;     /* size of the buffer last given to set_out      */
@@ -96,6 +98,11 @@ static bool deflate_define(void *data, const char *prop, uint32_t val)
       st->window_bits = (int)val;
       return true;
    }
+   else if (strcmp(prop, "sync_flush") == 0)
+   {
+      st->sync_flush = (val != 0);
+      return true;
+   }
    return false;
 }
 
@@ -179,9 +186,15 @@ static bool deflate_trans(
    }
 
    /* `flush` means the caller has supplied all remaining input in the
-    * current buffer and wants the stream finalized. */
+    * current buffer and wants the stream finalized - or, with sync_flush
+    * defined, cut at a byte boundary and left open. */
    if (flush && !st->is_inflate)
-      rdeflate_finish(st->stream);
+   {
+      if (st->sync_flush)
+         rdeflate_flush(st->stream);
+      else
+         rdeflate_finish(st->stream);
+   }
 
    /* The codec's process() already loops internally -- ingesting input,
     * parsing, emitting blocks and sliding its window -- until either the
@@ -232,6 +245,14 @@ static bool deflate_trans(
       return true;
    }
 
+   /* The sync point is out and the stream stays open for more input. */
+   if (status == RDEFLATE_PROCESS_BLOCK && !st->is_inflate)
+   {
+      if (err)
+         *err = TRANS_STREAM_ERROR_NONE;
+      return true;
+   }
+
    /* status == RDEFLATE_PROCESS_NEXT: more work remains.  If any input is
     * still unconsumed the caller must not advance past it.  Because a
     * caller may invoke trans() several times for one set_in (re-pointing
@@ -33,6 +33,8 @@ struct zlib_trans_stream
    int strategy;
    int level;
    bool inited;
+   /* A flushing trans() cuts a sync point instead of ending the stream */
+   bool sync_flush;
 };
 
 static void *zlib_deflate_stream_new(void)
@@ -45,6 +47,7 @@ static void *zlib_deflate_stream_new(void)
    ret->level       = 9;
    ret->window_bits = 15;
    ret->strategy    = Z_DEFAULT_STRATEGY;
+   ret->sync_flush  = false;
 
    ret->z.next_in   = NULL;
    ret->z.avail_in  = 0;
@@ -129,6 +132,8 @@ static bool zlib_deflate_define(void *data, const char *prop, uint32_t val)
       z->strategy = (int) val;
    else if (strcmp(prop, "window_bits") == 0)
       z->window_bits = (int) val;
+   else if (strcmp(prop, "sync_flush") == 0)
+      z->sync_flush = (val != 0);
    else
       return false;
 
@@ -213,7 +218,34 @@ static bool zlib_deflate_trans(
 
    pre_avail_in  = z->avail_in;
    pre_avail_out = z->avail_out;
-   zret          = deflate(z, flush ? Z_FINISH : Z_NO_FLUSH);
+   zret          = deflate(z, !flush ? Z_NO_FLUSH
+         : zt->sync_flush ? Z_SYNC_FLUSH : Z_FINISH);
+
+   if (flush && zt->sync_flush)
+   {
+      /* The sync point is out once deflate leaves output room unused.
+       * Asked again with nothing new, zlib reports Z_BUF_ERROR rather
+       * than writing a second marker: that too means done. */
+      if (zret == Z_BUF_ERROR && z->avail_in == 0)
+         zret = Z_OK;
+      else if (zret == Z_OK && z->avail_out == 0)
+      {
+         *rd = pre_avail_in - z->avail_in;
+         *wn = pre_avail_out - z->avail_out;
+         if (err)
+            *err = z->avail_in ? TRANS_STREAM_ERROR_BUFFER_FULL
+                               : TRANS_STREAM_ERROR_AGAIN;
+         return !z->avail_in;
+      }
+      if (zret == Z_OK)
+      {
+         *rd = pre_avail_in - z->avail_in;
+         *wn = pre_avail_out - z->avail_out;
+         if (err)
+            *err = TRANS_STREAM_ERROR_NONE;
+         return true;
+      }
+   }
 
    if (zret == Z_OK)
    {
@@ -0,0 +1,227 @@
+/* Replays sector access traces against a CHD through chd_stream and
+ * reports the time per sector, once per cache configuration: a single
+ * decoded hunk (what rchd kept before it had a cache), the default
+ * cache alone, and the default cache with read-ahead.
+ *
+ * A trace is a text file of "lba [count]" lines, sectors relative to
+ * the start of the track, '#' starting a comment. Without one the
+ * built-in patterns run:
+ *
+ *   seq      the whole track front to back, as FMV or CD audio plays
+ *   random   single sectors anywhere, as a loader resolving a scattered
+ *            file list does
+ *   seek     a directory sector, then a short run somewhere else, over
+ *            and over -- what a CD core reading files through its
+ *            filesystem looks like
+ *
+ * Every configuration must read the same bytes, so the digests are
+ * compared and a difference fails the run.
+ *
+ *   cc -O2 -DHAVE_RCHD -DHAVE_THREADS -DHAVE_RCHD_DEFLATE -DHAVE_RCHD_LZMA \
+ *      -DHAVE_RCHD_FLAC -DHAVE_RCHD_ZSTD -I libretro-common/include \
+ *      -o chd_trace_bench <this> libretro-common/streams/chd_stream.c \
+ *      libretro-common/formats/chd/rchd.c ... -lpthread
+ *
+ *   chd_trace_bench image.chd [track] [trace.txt]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <streams/chd_stream.h>
+
+typedef struct { uint32_t lba, count; } span_t;
+
+static double now(void)
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static span_t  *spans;
+static size_t   span_count, span_cap;
+
+static void add(uint32_t lba, uint32_t count)
+{
+   if (span_count == span_cap)
+   {
+      span_cap = span_cap ? span_cap * 2 : 1024;
+      spans    = (span_t*)realloc(spans, span_cap * sizeof(*spans));
+   }
+   spans[span_count].lba   = lba;
+   spans[span_count].count = count;
+   span_count++;
+}
+
+static uint32_t rng = 0x2545F491;
+static uint32_t next_rand(void)
+{
+   rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+   return rng;
+}
+
+static void make_pattern(const char *name, uint32_t sectors)
+{
+   uint32_t i;
+
+   span_count = 0;
+   rng        = 0x2545F491;
+   if (!strcmp(name, "seq"))
+      for (i = 0; i < sectors; i += 16)
+         add(i, sectors - i < 16 ? sectors - i : 16);
+   else if (!strcmp(name, "random"))
+      for (i = 0; i < 4096; i++)
+         add(next_rand() % sectors, 1);
+   else
+      for (i = 0; i < 512; i++)
+      {
+         uint32_t at = next_rand() % sectors;
+         add(16 + (i & 3), 1);
+         add(at, sectors - at < 24 ? sectors - at : 24);
+      }
+}
+
+static int load_trace(const char *path, uint32_t sectors)
+{
+   char  line[256];
+   FILE *f = fopen(path, "r");
+
+   if (!f)
+      return 0;
+   span_count = 0;
+   while (fgets(line, sizeof(line), f))
+   {
+      unsigned long lba, count = 1;
+      char         *hash = strchr(line, '#');
+      if (hash)
+         *hash = '\0';
+      if (sscanf(line, "%lu %lu", &lba, &count) < 1)
+         continue;
+      if (lba >= sectors)
+         continue;
+      if (count > sectors - lba)
+         count = sectors - lba;
+      add((uint32_t)lba, (uint32_t)count);
+   }
+   fclose(f);
+   return span_count != 0;
+}
+
+/* Returns the digest of everything read, or 0 if the stream failed. */
+static unsigned long long replay(const char *path, int32_t track,
+      uint32_t cache, uint32_t ahead, double *secs, uint32_t *read)
+{
+   static uint8_t     buf[2352 * 64];
+   size_t             i;
+   double             t0;
+   unsigned long long h = 1469598103934665603ULL;
+   chdstream_t       *s = chdstream_open(path, track);
+   uint32_t           frame;
+
+   if (!s)
+      return 0;
+   if (!chdstream_set_cache(s, cache, ahead))
+   {
+      chdstream_close(s);
+      return 0;
+   }
+   frame = chdstream_get_frame_size(s);
+   *read = 0;
+
+   t0 = now();
+   for (i = 0; i < span_count; i++)
+   {
+      uint32_t left = spans[i].count;
+      chdstream_seek(s, (int64_t)spans[i].lba * frame, SEEK_SET);
+      while (left)
+      {
+         uint32_t n = left > 64 ? 64 : left, k;
+         if (chdstream_read(s, buf, (size_t)n * frame) != (ssize_t)(n * frame))
+         {
+            chdstream_close(s);
+            return 0;
+         }
+         for (k = 0; k < n * frame; k += 64)
+            h = (h ^ buf[k]) * 1099511628211ULL;
+         *read += n;
+         left  -= n;
+      }
+   }
+   *secs = now() - t0;
+   chdstream_close(s);
+   return h;
+}
+
+int main(int argc, char **argv)
+{
+   static const char *patterns[] = { "seq", "random", "seek" };
+   static const uint32_t cfg[][2] = {
+      { 1, 0 },
+      { CHDSTREAM_CACHE_HUNKS, 0 },
+      { CHDSTREAM_CACHE_HUNKS, CHDSTREAM_READAHEAD_HUNKS }
+   };
+   int32_t      track = argc > 2 ? atoi(argv[2]) : CHDSTREAM_TRACK_PRIMARY;
+   chdstream_t *s;
+   uint32_t     sectors;
+   unsigned     p, c, np = 3;
+   int          bad = 0;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "usage: %s image.chd [track] [trace.txt]\n", argv[0]);
+      return 2;
+   }
+   if (!(s = chdstream_open(argv[1], track)))
+   {
+      printf("  %s: no such track\n", argv[1]);
+      return 1;
+   }
+   sectors = (uint32_t)(chdstream_get_size(s) / chdstream_get_frame_size(s));
+   chdstream_close(s);
+   if (!sectors)
+      return 1;
+
+   printf("  %s, %u sectors\n", argv[1], sectors);
+   if (argc > 3)
+   {
+      if (!load_trace(argv[3], sectors))
+      {
+         printf("  %s: no usable lines\n", argv[3]);
+         return 1;
+      }
+      np = 1;
+   }
+
+   for (p = 0; p < np; p++)
+   {
+      unsigned long long first = 0;
+
+      if (argc <= 3)
+         make_pattern(patterns[p], sectors);
+      for (c = 0; c < sizeof(cfg) / sizeof(cfg[0]); c++)
+      {
+         double             secs = 0;
+         uint32_t           n    = 0;
+         unsigned long long h    = replay(argv[1], track,
+               cfg[c][0], cfg[c][1], &secs, &n);
+
+         if (!h)
+         {
+            printf("  %-8s cache %2u ahead %u  read failed\n",
+                  argc > 3 ? "trace" : patterns[p], cfg[c][0], cfg[c][1]);
+            bad = 1;
+            continue;
+         }
+         if (!c)
+            first = h;
+         printf("  %-8s cache %2u ahead %u  %8u sectors %9.2f us/sector %s\n",
+               argc > 3 ? "trace" : patterns[p], cfg[c][0], cfg[c][1], n,
+               n ? secs * 1e6 / n : 0.0, h == first ? "" : "MISMATCH");
+         if (h != first)
+            bad = 1;
+      }
+   }
+   free(spans);
+   return bad;
+}
@@ -1,5 +1,15 @@
-/* Throughput: rmpeg1 stack vs pl_mpeg on the same stream.
- * Measures decode only; the file is read once up front. */
+/* Throughput: rmpeg1 stack vs pl_mpeg on the same stream, and per-stage
+ * timings of the decoder's IDCT, motion compensation and YCbCr->RGB kernels
+ * for every kernel set the CPU runs (scalar, SSE2, AVX2, NEON), with the
+ * full decode repeated on each set so the stage gains can be checked
+ * against the whole.
+ * Measures decode only; the file is read once up front. Without a file
+ * only the stage timings run. Build with -DBENCH_NO_REF to leave pl_mpeg
+ * out.
+ *
+ *   cc -O2 -I../../include bench.c ../../formats/mpeg1/rmpeg1_ps.c \
+ *      ../../features/features_cpu.c -o bench
+ *   bench [file [iters]] */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,10 +17,34 @@
 #include <formats/rmpeg1_ps.h>
 #include <formats/rmpeg1_video.h>
 
+/* Included rather than linked, as idct_accuracy.c does, to reach the
+ * kernels and to pick the set a decoder runs. */
+#include "../../formats/mpeg1/rmpeg1_video.c"
+
+#ifndef BENCH_NO_REF
 #define PLM_NO_STDIO 1
 #define PL_MPEG_IMPLEMENTATION
 #include <stddef.h>
 #include "pl_mpeg.h"
+#endif
+
+typedef struct { const char *name; uint64_t mask; } kset_t;
+static const kset_t ksets[] = {
+   { "scalar", 0 },
+#ifdef RMPEG1_SSE2
+   { "sse2",   RETRO_SIMD_SSE2 },
+#endif
+#ifdef RMPEG1_AVX2
+   { "avx2",   RETRO_SIMD_SSE2 | RETRO_SIMD_AVX2 },
+#endif
+#ifdef RMPEG1_NEON
+   { "neon",   RETRO_SIMD_NEON },
+#endif
+};
+#define NKSETS (sizeof(ksets)/sizeof(ksets[0]))
+
+/* Set while timing bench_ours_full on one kernel set. */
+static const kset_t *force_kset;
 
 static double now(void)
 { struct timespec t; clock_gettime(CLOCK_MONOTONIC,&t);
@@ -31,6 +65,7 @@ static size_t bench_ours_demux(void)
    rmpeg1_ps_free(ps); return n;
 }
 
+#ifndef BENCH_NO_REF
 static size_t bench_ref_demux(void)
 {
    plm_buffer_t *b = plm_buffer_create_with_memory(data,(size_t)len,0);
@@ -39,11 +74,14 @@ static size_t bench_ref_demux(void)
    plm_demux_destroy(d); plm_buffer_destroy(b); return n;
 }
 
+#endif
+
 static size_t bench_ours_full(void)
 {
    rmpeg1_ps_t *ps = rmpeg1_ps_init(0); rmpeg1_ps_packet_t p;
    rmpeg1_video_t *v = rmpeg1_video_init(); rmpeg1_video_frame_t fr;
    size_t off=0, frames=0;
+   if(force_kset) rmpeg1_dsp_init(&v->dsp, force_kset->mask);
    while(off<(size_t)len){
       size_t want=(size_t)len-off; if(want>2324) want=2324;
       size_t got=rmpeg1_ps_write(ps,data+off,want); off+=got;
@@ -63,6 +101,7 @@ static size_t bench_ours_full(void)
    rmpeg1_video_free(v); rmpeg1_ps_free(ps); return frames;
 }
 
+#ifndef BENCH_NO_REF
 static size_t bench_ref_full(void)
 {
    plm_t *plm = plm_create_with_memory(data,(size_t)len,0);
@@ -71,6 +110,120 @@ static size_t bench_ref_full(void)
    while((f=plm_decode_video(plm))!=NULL) frames++;
    plm_destroy(plm); return frames;
 }
+#endif
+
+/* ---- per-stage kernels ---------------------------------------------- */
+
+#define KB 4096                         /* blocks per timed pass */
+#define FW 720                          /* a PAL-sized plane for MC/RGB */
+#define FH 576
+
+static uint32_t krs = 0x1234567u;
+static uint32_t krnd(void){ krs^=krs<<13; krs^=krs>>17; krs^=krs<<5; return krs; }
+
+static int16_t  *kblk;                  /* KB coefficient blocks */
+static uint8_t  *kref, *kdst;           /* FW x FH reference and target */
+static uint8_t  *kcb, *kcr;             /* FW/2 x FH/2 chroma for RGB */
+static unsigned  kpos[KB];              /* in-bounds block offsets */
+
+static void kernels_setup(void)
+{
+   size_t i; int k;
+   kblk=malloc(sizeof(int16_t)*64*KB); kref=malloc(FW*FH); kdst=malloc(FW*FH);
+   kcb=malloc(FW/2*FH/2); kcr=malloc(FW/2*FH/2);
+   /* Blocks shaped like coded content: DC plus a handful of small low
+    * frequency AC terms, a quarter of them DC only. */
+   for(i=0;i<KB;i++){
+      int16_t *b=kblk+i*64; memset(b,0,128);
+      b[0]=(int16_t)((i&1)? 900+(int)(krnd()%250) : (int)(krnd()%129)-64);
+      if(i&3) for(k=0;k<6;k++) b[krnd()%20]=(int16_t)((int)(krnd()%81)-40);
+      kpos[i]=(krnd()%(FH-17))*FW + krnd()%(FW-17);
+   }
+   for(i=0;i<FW*FH;i++) kref[i]=(uint8_t)(((i%FW)+(i/FW)*3+(krnd()&15))&255);
+   for(i=0;i<FW/2*FH/2;i++){ kcb[i]=(uint8_t)(96+krnd()%64); kcr[i]=(uint8_t)(96+krnd()%64); }
+}
+
+/* ns per call of one stage on one kernel set; best of 5 */
+static double time_stage(const rmpeg1_dsp_t *d, int stage, unsigned bw)
+{
+   double best=0; int rep; size_t i;
+   for(rep=0;rep<5;rep++){
+      double t0=now(), dt;
+      for(i=0;i<KB;i++){
+         uint8_t *dst=kdst+kpos[i];
+         switch(stage){
+            case 0: d->idct_put(kblk+i*64,dst,FW); break;
+            case 1: d->idct_add(kblk+i*64,dst,FW); break;
+            case 2: case 3: case 4: case 5:
+               d->mc_put(kref+kpos[i],FW,dst,FW,bw,bw,(unsigned)(stage-2)); break;
+            default: d->mc_avg(dst,FW,kref+kpos[i],FW,bw,bw); break;
+         }
+      }
+      dt=(now()-t0)*1e9/KB;
+      if(!rep||dt<best) best=dt;
+   }
+   return best;
+}
+
+static double time_rgb(rmpeg1_yuv_row_t row)
+{
+   static uint32_t *out; rmpeg1_video_frame_t f; double best=0; int rep;
+   if(!out) out=malloc(sizeof(uint32_t)*FW*FH);
+   f.y=kref; f.cb=kcb; f.cr=kcr;
+   f.width=FW; f.height=FH; f.y_stride=FW; f.c_stride=FW/2;
+   for(rep=0;rep<5;rep++){
+      double t0=now(), dt;
+      frame_to_argb(&f,out,FW*4,row);
+      dt=(now()-t0)*1e3;
+      if(!rep||dt<best) best=dt;
+   }
+   return best;
+}
+
+static void run_kernels(void)
+{
+   static const char *names[] = { "idct put", "idct add", "mc copy",
+      "mc half-x", "mc half-y", "mc half-xy", "mc bi-avg" };
+   uint64_t have = cpu_features_get();
+   rmpeg1_dsp_t d[NKSETS]; int ok[NKSETS];
+   size_t k; int st; unsigned bw;
+
+   kernels_setup();
+   for(k=0;k<NKSETS;k++){
+      ok[k] = (ksets[k].mask & have) == ksets[k].mask;
+      rmpeg1_dsp_init(&d[k], ksets[k].mask);
+   }
+   printf(" stage kernels (ns/block, speedup vs scalar):\n  %-16s","");
+   for(k=0;k<NKSETS;k++) if(ok[k]) printf(" %14s",ksets[k].name);
+   printf("\n");
+   for(st=0;st<7;st++)
+      for(bw=16;bw>=8;bw-=8){
+         double base=0;
+         if(st<2 && bw==8) continue;     /* an IDCT block is always 8x8 */
+         printf("  %-10s %-5s",names[st], st<2?"8x8":bw==16?"16x16":"8x8");
+         for(k=0;k<NKSETS;k++){
+            double t;
+            if(!ok[k]) continue;
+            t=time_stage(&d[k],st,bw);
+            if(!k) base=t;
+            printf(" %7.1f x%5.2f",t,t>0?base/t:0.0);
+         }
+         printf("\n");
+         if(st<2) break;
+      }
+   {
+      double base=0;
+      printf("  %-16s","ycbcr->argb ms");
+      for(k=0;k<NKSETS;k++){
+         double t;
+         if(!ok[k]) continue;
+         t=time_rgb(yuv_row_select(ksets[k].mask));
+         if(!k) base=t;
+         printf(" %7.2f x%5.2f",t,t>0?base/t:0.0);
+      }
+      printf("   (%ux%u)\n",FW,FH);
+   }
+}
 
 static void run(const char *name, size_t (*fn)(void), int iters)
 {
@@ -84,15 +237,31 @@ static void run(const char *name, size_t (*fn)(void), int iters)
 
 int main(int argc, char **argv)
 {
-   FILE *f = fopen(argv[1],"rb"); int iters = argc>2?atoi(argv[2]):5;
+   FILE *f; int iters = argc>2?atoi(argv[2]):5; size_t k;
+   uint64_t have = cpu_features_get();
+   run_kernels();
+   if(argc<2) return 0;
+   if(!(f=fopen(argv[1],"rb"))) return 2;
    fseek(f,0,SEEK_END); len=ftell(f); fseek(f,0,SEEK_SET);
    data=malloc(len); if(fread(data,1,len,f)!=(size_t)len) return 2; fclose(f);
    printf("%s (%ld bytes, %d iters)\n", argv[1], len, iters);
    printf(" demux only:\n");
    run("rmpeg1_ps", bench_ours_demux, iters);
+#ifndef BENCH_NO_REF
    run("pl_mpeg demux", bench_ref_demux, iters);
+#endif
    printf(" demux + video decode:\n");
    run("rmpeg1_ps+video", bench_ours_full, iters);
+   for(k=0;k<NKSETS;k++){
+      char name[32];
+      if((ksets[k].mask & have) != ksets[k].mask) continue;
+      force_kset=&ksets[k];
+      snprintf(name,sizeof(name),"  kernels: %s",ksets[k].name);
+      run(name, bench_ours_full, iters);
+   }
+   force_kset=NULL;
+#ifndef BENCH_NO_REF
    run("pl_mpeg", bench_ref_full, iters);
+#endif
    return 0;
 }
@@ -9,6 +9,12 @@
  * Coefficient ranges are chosen to look like real intra blocks -- a large DC
  * around the 1024 predictor and small AC -- as well as 1180's own uniform
  * ranges, because an IDCT can be accurate on one and not the other.
+ *
+ * The vector IDCTs the CPU can run are then held to the scalar one exactly,
+ * put and add, over the same ranges: they are meant to be the same
+ * arithmetic, not merely within 1180 of it.
+ *
+ *   cc -O2 -I../../include idct_accuracy.c ../../features/features_cpu.c -lm
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -71,6 +77,25 @@ static int run(const char *name, int dc_lo, int dc_hi, int ac_lo, int ac_hi, int
      return (peak<=1 && mse<=0.06 && fabs(me)<=0.015 && worst_pme<=0.015)?0:1; }
 }
 
+/* Counts blocks where a vector kernel set differs from scalar by a bit. */
+static int exact(const char *name, uint64_t mask, int lo, int hi, int n)
+{
+   rmpeg1_dsp_t ref, vec; int i,k,diff=0;
+   int16_t blk[64]; uint8_t a[64], b[64];
+   if((cpu_features_get() & mask) != mask) return 0;
+   rmpeg1_dsp_init(&ref,0); rmpeg1_dsp_init(&vec,mask);
+   for(i=0;i<n;i++){
+      for(k=0;k<64;k++) blk[k]=(int16_t)((i&3)==0 && k ? 0 : rnd(lo,hi));
+      ref.idct_put(blk,a,8); vec.idct_put(blk,b,8);
+      if(memcmp(a,b,64)) { diff++; continue; }
+      for(k=0;k<64;k++) a[k]=b[k]=(uint8_t)rnd(0,255);
+      ref.idct_add(blk,a,8); vec.idct_add(blk,b,8);
+      if(memcmp(a,b,64)) diff++;
+   }
+   printf("  %-26s %d/%d blocks differ  %s\n", name, diff, n, diff?"FAIL":"OK");
+   return diff?1:0;
+}
+
 int main(void)
 {
    int bad=0;
@@ -84,6 +109,19 @@ int main(void)
      memset(z,0,sizeof(z)); idct_block(z,o,8);
      for(k=0;k<64;k++) if(o[k]!=0) allz=0;
      printf("  %-26s %s\n","all-zero input", allz?"OK (all zero out)":"FAIL"); if(!allz) bad++; }
+   printf("Vector kernels vs scalar, bit for bit (put and add)\n");
+#ifdef RMPEG1_SSE2
+   bad += exact("sse2 L=300", RETRO_SIMD_SSE2, -300, 300, 20000);
+   bad += exact("sse2 L=2048", RETRO_SIMD_SSE2, -2048, 2047, 20000);
+#endif
+#ifdef RMPEG1_AVX2
+   bad += exact("avx2 L=300", RETRO_SIMD_SSE2|RETRO_SIMD_AVX2, -300, 300, 20000);
+   bad += exact("avx2 L=2048", RETRO_SIMD_SSE2|RETRO_SIMD_AVX2, -2048, 2047, 20000);
+#endif
+#ifdef RMPEG1_NEON
+   bad += exact("neon L=300", RETRO_SIMD_NEON, -300, 300, 20000);
+   bad += exact("neon L=2048", RETRO_SIMD_NEON, -2048, 2047, 20000);
+#endif
    printf(bad?"RESULT: FAIL\n":"RESULT: PASS\n");
    return bad?1:0;
 }
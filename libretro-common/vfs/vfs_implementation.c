@@ -1293,6 +1293,32 @@ int retro_vfs_file_flush_impl(libretro_vfs_implementation_file *stream)
    return -1;
 }
 
+int retro_vfs_file_sync_impl(libretro_vfs_implementation_file *stream)
+{
+   if (!stream)
+      return -1;
+#ifdef HAVE_CDROM
+   if (stream->scheme == VFS_SCHEME_CDROM)
+      return 0;
+#endif
+#ifdef HAVE_SMBCLIENT
+   if (stream->scheme == VFS_SCHEME_SMB)
+      return 0;
+#endif
+   if (stream->fp && fflush(stream->fp) != 0)
+      return -1;
+#if defined(_WIN32) && !defined(_XBOX)
+   if (stream->fp)
+      return _commit(_fileno(stream->fp)) == 0 ? 0 : -1;
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+   if (stream->fp)
+      return fsync(fileno(stream->fp)) == 0 ? 0 : -1;
+   if (stream->fd >= 0)
+      return fsync(stream->fd) == 0 ? 0 : -1;
+#endif
+   return stream->fp ? 0 : -1;
+}
+
 int retro_vfs_file_remove_impl(const char *path)
 {
    if (path && *path)
@@ -66,6 +66,14 @@
 #define _MPF_MAP16    0xde
 #define _MPF_MAP32    0xdf
 
+/* Most keys a query condition may name and still be answered from an
+ * index; the scanner asks for two (crc:or(b"..",b"..")). */
+#define LIBRETRODB_PLAN_MAX_KEYS 32
+
+/* Nesting accepted by the in-place decoder.  Records are a flat map
+ * of scalars; anything deeper than this is a corrupt file. */
+#define LIBRETRODB_VIEW_MAX_DEPTH 16
+
 struct node_iter_ctx
 {
    libretrodb_t *db;
@@ -87,6 +95,13 @@ struct libretrodb
    uint64_t root;
    uint64_t count;
    uint64_t first_index_offset;
+   /* Read-only mapping of the whole file, when the VFS could provide
+    * one.  Every stream the handle opens then reads from it rather
+    * than the file, and libretrodb_cursor_read_item_view() hands out
+    * values that point straight into it. */
+   RFILE *map_file;
+   const uint8_t *map;
+   uint64_t map_len;
 };
 
 /* Widest index key the format is expected to carry (SHA-1 is 20
@@ -118,8 +133,14 @@ struct libretrodb_cursor
    intfstream_t *fd;
    libretrodb_query_t *query;
    libretrodb_t *db;
+   /* Record offsets to visit, in file order, when an index answered
+    * the query; see libretrodb_cursor_plan() */
+   uint64_t *plan;
+   size_t plan_count;
+   size_t plan_pos;
    int is_valid;
    int eof;
+   bool planned;
 };
 
 static int libretrodb_validate_document(const struct rmsgpack_dom_value *doc)
@@ -217,10 +238,81 @@ void libretrodb_close(libretrodb_t *db)
       intfstream_close(db->fd);
       free(db->fd);
    }
+   if (db->map_file)
+      filestream_close(db->map_file);
    if (db->path && *db->path)
       free(db->path);
-   db->path = NULL;
-   db->fd   = NULL;
+   db->path     = NULL;
+   db->fd       = NULL;
+   db->map_file = NULL;
+   db->map      = NULL;
+   db->map_len  = 0;
+}
+
+/**
+ * libretrodb_map:
+ *
+ * Map @path for reading and return a stream over the mapping, or
+ * NULL when the VFS cannot map it - the caller then reads the file.
+ * The mapping lives until libretrodb_close().
+ */
+static intfstream_t *libretrodb_map(libretrodb_t *db, const char *path)
+{
+   int64_t len       = 0;
+   const uint8_t *map;
+   intfstream_t *fd;
+   RFILE *file       = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ,
+         RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS);
+
+   if (!file)
+      return NULL;
+
+   /* A view shorter than the file would silently truncate the
+    * database; only take one that covers all of it. */
+   if (     !(map = (const uint8_t*)filestream_get_mapped_ptr(file, &len))
+         || len <= 0
+         || len != filestream_get_size(file))
+   {
+      filestream_close(file);
+      return NULL;
+   }
+
+   if (!(fd = intfstream_open_memory((void*)map,
+               RETRO_VFS_FILE_ACCESS_READ,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE, (uint64_t)len)))
+   {
+      filestream_close(file);
+      return NULL;
+   }
+
+   db->map_file = file;
+   db->map      = map;
+   db->map_len  = (uint64_t)len;
+   return fd;
+}
+
+/**
+ * libretrodb_open_stream:
+ *
+ * Open a private read stream on the database for a cursor or a scan:
+ * over the mapping when there is one, otherwise through a sliding
+ * window on the file.
+ */
+static intfstream_t *libretrodb_open_stream(libretrodb_t *db)
+{
+   intfstream_t *fd;
+
+   if (db->map)
+      return intfstream_open_memory((void*)db->map,
+            RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE, db->map_len);
+
+   if (!(fd = intfstream_open_buffered(db->path, LIBRETRODB_WINDOW_SIZE)))
+      fd = intfstream_open_file(db->path,
+            RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   return fd;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db, bool write)
@@ -229,8 +321,20 @@ int libretrodb_open(const char *path, libretrodb_t *db, bool write)
    libretrodb_metadata_t md;
    int64_t       file_size;
    unsigned mode = write ? RETRO_VFS_FILE_ACCESS_READ_WRITE | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING : RETRO_VFS_FILE_ACCESS_READ;
-   intfstream_t *fd = intfstream_open_file(path, mode, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   intfstream_t *fd = NULL;
+
    db->can_write = write;
+   db->map_file  = NULL;
+   db->map       = NULL;
+   db->map_len   = 0;
+
+   /* Databases are opened read-only far more often than not, and then
+    * nothing stops the whole file being mapped once and walked in
+    * place.  Writers keep going through the file. */
+   if (!write)
+      fd = libretrodb_map(db, path);
+   if (!fd)
+      fd = intfstream_open_file(path, mode, RETRO_VFS_FILE_ACCESS_HINT_NONE);
    if (!fd)
      return -1;
 
@@ -303,6 +407,11 @@ error:
       intfstream_close(fd);
       free(fd);
    }
+   if (db->map_file)
+      filestream_close(db->map_file);
+   db->map_file = NULL;
+   db->map      = NULL;
+   db->map_len  = 0;
    return -1;
 }
 
@@ -403,19 +512,29 @@ static int binsearch(const void *buff, const void *item,
    return -1;
 }
 
-int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
-      const void *key, struct rmsgpack_dom_value *out)
+/**
+ * libretrodb_load_index:
+ *
+ * Locate index @index_name and make its entries addressable for
+ * binsearch(): in place when the database is mapped, otherwise read
+ * into *@owned, which the caller frees.
+ *
+ * Returns: the first entry, or NULL if there is no such index or its
+ * header does not describe a usable one.
+ */
+static const uint8_t *libretrodb_load_index(libretrodb_t *db,
+      const char *index_name, libretrodb_index_t *idx, uint8_t **owned)
 {
-   libretrodb_index_t idx;
    int rv;
    uint8_t *buff;
-   uint64_t offset;
    uint64_t item_size;
    uint64_t bufflen;
    int64_t  nread = 0;
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
-      return -1;
+   *owned = NULL;
+
+   if (libretrodb_find_index(db, index_name, idx) < 0)
+      return NULL;
 
    /* idx.next, idx.count and idx.key_size all come from the file
     * with no relationship enforced between them.  binsearch() walks
@@ -424,18 +543,31 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
     * the allocation.  Require the payload the header describes to
     * actually fit in the payload the header reserved, and reject
     * degenerate key sizes outright. */
-   if (idx.key_size == 0 || idx.key_size > LIBRETRODB_MAX_KEY_SIZE)
-      return -1;
+   if (idx->key_size == 0 || idx->key_size > LIBRETRODB_MAX_KEY_SIZE)
+      return NULL;
 
-   item_size = idx.key_size + sizeof(uint64_t);
-   if (idx.count > idx.next / item_size)
-      return -1;
+   item_size = idx->key_size + sizeof(uint64_t);
+   if (idx->count > idx->next / item_size)
+      return NULL;
 
-   bufflen        = idx.next;
+   bufflen        = idx->next;
    if (bufflen == 0 || bufflen > (uint64_t)INT64_MAX)
-      return -1;
+      return NULL;
+
+   /* Mapped: search the index where it lies instead of copying it
+    * out first. */
+   if (db->map)
+   {
+      int64_t pos = intfstream_tell(db->fd);
+      if (     pos < 0
+            || (uint64_t)pos > db->map_len
+            || bufflen > db->map_len - (uint64_t)pos)
+         return NULL;
+      return db->map + pos;
+   }
+
    if (!(buff = (uint8_t*)malloc((size_t)bufflen)))
-      return -1;
+      return NULL;
 
    while (nread < (int64_t)bufflen)
    {
@@ -446,13 +578,31 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
       if (rv <= 0)
       {
          free(buff);
-         return -1;
+         return NULL;
       }
       nread += rv;
    }
 
-   rv = binsearch(buff, key, idx.count, idx.key_size, &offset);
-   free(buff);
+   *owned = buff;
+   return buff;
+}
+
+int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
+      const void *key, struct rmsgpack_dom_value *out)
+{
+   libretrodb_index_t idx;
+   int rv;
+   uint64_t offset;
+   uint8_t *owned         = NULL;
+   const uint8_t *entries = libretrodb_load_index(db, index_name,
+         &idx, &owned);
+
+   if (!entries)
+      return -1;
+
+   rv = binsearch(entries, key, idx.count, idx.key_size, &offset);
+   if (owned)
+      free(owned);
 
    if (rv == 0)
    {
@@ -463,6 +613,94 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
    return -1;
 }
 
+static int libretrodb_offset_cmp(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+   return (x > y) - (x < y);
+}
+
+/**
+ * libretrodb_cursor_plan:
+ *
+ * Turn @cursor's query into a list of records to visit when one of its
+ * conditions is a key match (see libretrodb_query_get_keys()) on a
+ * field with an index of the same name.  create_index() only succeeds
+ * when every record carrying the field carries it as a unique binary
+ * of the index's key size, so the index lookups find every record the
+ * condition can accept; the rest of the query is still checked per
+ * record.  Without such a condition the cursor walks as before.
+ */
+static void libretrodb_cursor_plan(libretrodb_cursor_t *cursor)
+{
+   unsigned cond;
+   libretrodb_t *db = cursor->db;
+
+   for (cond = 0; ; cond++)
+   {
+      libretrodb_index_t idx;
+      char name[sizeof(idx.name)];
+      const struct rmsgpack_dom_value *keys[LIBRETRODB_PLAN_MAX_KEYS];
+      const uint8_t *entries;
+      uint8_t *owned       = NULL;
+      uint64_t *offsets;
+      const char *field    = NULL;
+      uint32_t field_len   = 0;
+      size_t count         = 0;
+      int i;
+      int n                = libretrodb_query_get_keys(cursor->query,
+            cond, &field, &field_len, keys, LIBRETRODB_PLAN_MAX_KEYS);
+
+      if (n < 0)
+         return;
+      if (n == 0 || n > LIBRETRODB_PLAN_MAX_KEYS || field_len >= sizeof(name))
+         continue;
+
+      memcpy(name, field, field_len);
+      name[field_len] = '\0';
+
+      if (!(entries = libretrodb_load_index(db, name, &idx, &owned)))
+         continue;
+
+      /* libretrodb_find_index() matches on a prefix of the name */
+      if (     strcmp(idx.name, name) != 0
+            || !(offsets = (uint64_t*)malloc(n * sizeof(*offsets))))
+      {
+         if (owned)
+            free(owned);
+         continue;
+      }
+
+      /* A key of any other width cannot be in the index, so it
+       * matches no record at all */
+      for (i = 0; i < n; i++)
+         if (     keys[i]->val.binary.len == idx.key_size
+               && binsearch(entries, keys[i]->val.binary.buff,
+                  idx.count, idx.key_size, &offsets[count]) == 0)
+            count++;
+      if (owned)
+         free(owned);
+
+      /* Keep file order, which is what a walk would have returned,
+       * and visit a record named twice by or() only once */
+      if (count > 1)
+      {
+         size_t j, k;
+         qsort(offsets, count, sizeof(*offsets), libretrodb_offset_cmp);
+         for (j = 1, k = 1; j < count; j++)
+            if (offsets[j] != offsets[k - 1])
+               offsets[k++] = offsets[j];
+         count = k;
+      }
+
+      cursor->plan       = offsets;
+      cursor->plan_count = count;
+      cursor->plan_pos   = 0;
+      cursor->planned    = true;
+      return;
+   }
+}
+
 /**
  * libretrodb_cursor_reset:
  * @cursor              : Handle to database cursor.
@@ -473,7 +711,8 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-   cursor->eof = 0;
+   cursor->eof      = 0;
+   cursor->plan_pos = 0;
    return (int)intfstream_seek(cursor->fd,
          (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
          RETRO_VFS_SEEK_POSITION_START);
@@ -700,11 +939,8 @@ int libretrodb_scan_field(libretrodb_t *db, const char *field,
    if (aux_field && *aux_field)
       aux_len = strlen(aux_field);
 
-   if (!(fd = intfstream_open_buffered(db->path, LIBRETRODB_WINDOW_SIZE)))
-      if (!(fd = intfstream_open_file(db->path,
-                  RETRO_VFS_FILE_ACCESS_READ,
-                  RETRO_VFS_FILE_ACCESS_HINT_NONE)))
-         return -1;
+   if (!(fd = libretrodb_open_stream(db)))
+      return -1;
 
    if (intfstream_seek(fd, (int64_t)(db->root + sizeof(libretrodb_header_t)),
             RETRO_VFS_SEEK_POSITION_START) < 0)
@@ -830,11 +1066,8 @@ int libretrodb_read_at(libretrodb_t *db, uint64_t offset,
    if (!db || !db->path || !*db->path || !out)
       return -1;
 
-   if (!(fd = intfstream_open_buffered(db->path, LIBRETRODB_WINDOW_SIZE)))
-      if (!(fd = intfstream_open_file(db->path,
-                  RETRO_VFS_FILE_ACCESS_READ,
-                  RETRO_VFS_FILE_ACCESS_HINT_NONE)))
-         return -1;
+   if (!(fd = libretrodb_open_stream(db)))
+      return -1;
 
    if (intfstream_seek(fd, (int64_t)offset,
             RETRO_VFS_SEEK_POSITION_START) >= 0)
@@ -845,182 +1078,500 @@ int libretrodb_read_at(libretrodb_t *db, uint64_t offset,
    return rv;
 }
 
-int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
-      struct rmsgpack_dom_value *out)
+/* Big-endian field of @n bytes at @p */
+static uint64_t libretrodb_view_uint(const uint8_t *p, unsigned n)
 {
-   int rv;
+   uint64_t v = 0;
+   unsigned i;
+   for (i = 0; i < n; i++)
+      v = (v << 8) | p[i];
+   return v;
+}
 
-   if (cursor->eof)
-      return EOF;
+/* Containers only: strings and binaries belong to the mapping */
+static void libretrodb_view_free(struct rmsgpack_dom_value *v)
+{
+   uint32_t i;
 
-   /* If no query is active, use the original full-DOM path */
-   if (!cursor->query)
+   switch (v->type)
    {
-      if ((rv = rmsgpack_dom_read(cursor->fd, out)) < 0)
-         return rv;
-      if (out->type == RDT_NULL)
-      {
-         cursor->eof = 1;
-         return EOF;
-      }
-      return 0;
+      case RDT_MAP:
+         for (i = 0; i < v->val.map.len; i++)
+         {
+            libretrodb_view_free(&v->val.map.items[i].key);
+            libretrodb_view_free(&v->val.map.items[i].value);
+         }
+         free(v->val.map.items);
+         break;
+      case RDT_ARRAY:
+         for (i = 0; i < v->val.array.len; i++)
+            libretrodb_view_free(&v->val.array.items[i]);
+         free(v->val.array.items);
+         break;
+      default:
+         break;
    }
+   v->type = RDT_NULL;
+}
 
-   /* --- Fast path: folded field-level scan + inline evaluation --- */
-   {
-      int num_qfields;
+/**
+ * libretrodb_view_read:
+ *
+ * Decode the value at *@p in place, without copying string or binary
+ * payloads: their buff points into [*@p, @end) and is NOT
+ * NUL-terminated.  Maps and arrays are still allocated, as the DOM
+ * reader would.  Advances *@p past the value.
+ *
+ * Returns: 0 on success, -1 on a truncated or malformed value, in
+ * which case nothing is left allocated.
+ */
+static int libretrodb_view_read(const uint8_t **p, const uint8_t *end,
+      struct rmsgpack_dom_value *out, unsigned depth)
+{
+   const uint8_t *q = *p;
+   uint8_t  type;
+   uint64_t len     = 0;
+   unsigned width   = 0;
+   uint32_t i;
 
-      num_qfields = libretrodb_query_get_filter_fields(
-            cursor->query, NULL, NULL, 0);
+   out->type = RDT_NULL;
+
+   if (q >= end || depth > LIBRETRODB_VIEW_MAX_DEPTH)
+      return -1;
+
+   type = *q++;
 
-      /* If we can't extract field names (non-table query),
-       * fall back to the full DOM path */
-      if (num_qfields <= 0)
-         goto slow_path;
+   /* Fixed-size forms */
+   if (type < 0x80)
+   {
+      out->type     = RDT_UINT;
+      out->val.uint_ = type;
+      goto done;
+   }
+   if (type >= 0xe0)
+   {
+      out->type    = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      goto done;
+   }
+
+   switch (type)
+   {
+      case _MPF_NIL:
+         goto done;
+      case 0xc2: /* false */
+      case 0xc3: /* true */
+         out->type      = RDT_BOOL;
+         out->val.bool_ = (type == 0xc3);
+         goto done;
+      case 0xcc: case 0xcd: case 0xce: case 0xcf:
+         width = 1u << (type - 0xcc);
+         if ((size_t)(end - q) < width)
+            return -1;
+         out->type      = RDT_UINT;
+         out->val.uint_ = libretrodb_view_uint(q, width);
+         q             += width;
+         goto done;
+      case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+         width = 1u << (type - 0xd0);
+         if ((size_t)(end - q) < width)
+            return -1;
+         len = libretrodb_view_uint(q, width);
+         q  += width;
+         /* Sign-extend from the stored width */
+         if (width < 8 && (len & ((uint64_t)1 << (width * 8 - 1))))
+            len |= ~(uint64_t)0 << (width * 8);
+         out->type     = RDT_INT;
+         out->val.int_ = (int64_t)len;
+         goto done;
+      default:
+         break;
+   }
 
-      for (;;)
+   /* Variable-size forms: work out the payload length first */
+   if (type >= _MPF_FIXMAP && type < _MPF_FIXARRAY)
+      len = type - _MPF_FIXMAP;
+   else if (type >= _MPF_FIXARRAY && type < _MPF_FIXSTR)
+      len = type - _MPF_FIXARRAY;
+   else if (type >= _MPF_FIXSTR && type < _MPF_NIL)
+      len = type - _MPF_FIXSTR;
+   else
+   {
+      switch (type)
       {
-         int32_t  map_len;
-         int32_t  i;
-         int64_t  record_start;
-         int      conditions_met   = 0;
-         int      rejected         = 0;
-         int      skip_rest        = 0;
-         int      error            = 0;
-
-         /* Remember where this record starts so we can rewind
-          * if the query matches */
-         record_start = intfstream_tell(cursor->fd);
-         if (record_start < 0)
+         case 0xc4: case _MPF_STR8:                width = 1; break;
+         case 0xc5: case _MPF_STR16: case 0xdc:
+         case _MPF_MAP16:                          width = 2; break;
+         case 0xc6: case _MPF_STR32: case 0xdd:
+         case _MPF_MAP32:                          width = 4; break;
+         default:
             return -1;
+      }
+      if ((size_t)(end - q) < width)
+         return -1;
+      len = libretrodb_view_uint(q, width);
+      q  += width;
+   }
 
-         /* Read the map header */
-         map_len = rmsgpack_read_map_header(cursor->fd);
+   if (     (type >= _MPF_FIXMAP && type < _MPF_FIXARRAY)
+         || type == _MPF_MAP16 || type == _MPF_MAP32)
+   {
+      struct rmsgpack_dom_pair *items = NULL;
 
-         if (map_len == -2)
+      /* Each pair needs at least two bytes, which bounds the
+       * allocation by what the file can actually hold. */
+      if (len > (uint64_t)(end - q) / 2)
+         return -1;
+      if (len && !(items = (struct rmsgpack_dom_pair*)
+               calloc((size_t)len, sizeof(*items))))
+         return -1;
+      out->type          = RDT_MAP;
+      out->val.map.items = items;
+      out->val.map.len   = 0;
+      for (i = 0; i < (uint32_t)len; i++)
+      {
+         out->val.map.len = i + 1;
+         if (     libretrodb_view_read(&q, end, &items[i].key,   depth + 1) < 0
+               || libretrodb_view_read(&q, end, &items[i].value, depth + 1) < 0)
          {
-            /* nil sentinel — end of records */
-            cursor->eof = 1;
-            return EOF;
+            libretrodb_view_free(out);
+            return -1;
          }
+      }
+      goto done;
+   }
 
-         if (map_len < 0 || map_len > CURSOR_MAX_MAP_FIELDS)
+   if (     (type >= _MPF_FIXARRAY && type < _MPF_FIXSTR)
+         || type == 0xdc || type == 0xdd)
+   {
+      struct rmsgpack_dom_value *items = NULL;
+
+      if (len > (uint64_t)(end - q))
+         return -1;
+      if (len && !(items = (struct rmsgpack_dom_value*)
+               calloc((size_t)len, sizeof(*items))))
+         return -1;
+      out->type            = RDT_ARRAY;
+      out->val.array.items = items;
+      out->val.array.len   = 0;
+      for (i = 0; i < (uint32_t)len; i++)
+      {
+         out->val.array.len = i + 1;
+         if (libretrodb_view_read(&q, end, &items[i], depth + 1) < 0)
          {
-            /* Not a map, or too many fields for fast path.
-             * Rewind and fall through to slow path for this
-             * one record, then continue with fast path. */
-            intfstream_seek(cursor->fd, record_start,
-                  RETRO_VFS_SEEK_POSITION_START);
-            goto slow_path_single;
+            libretrodb_view_free(out);
+            return -1;
          }
+      }
+      goto done;
+   }
 
-         /* Scan fields: for each key-value pair, read the key into
-          * a stack buffer, check if the query cares, and either skip
-          * the value or parse + evaluate it immediately inline. */
-         for (i = 0; i < map_len; i++)
-         {
-            char     key_buf[64];
-            int32_t  key_len;
+   /* String or binary: point at the payload */
+   if (len > (uint64_t)(end - q))
+      return -1;
+   if (type == 0xc4 || type == 0xc5 || type == 0xc6)
+   {
+      out->type            = RDT_BINARY;
+      out->val.binary.len  = (uint32_t)len;
+      out->val.binary.buff = (char*)q;
+   }
+   else
+   {
+      out->type            = RDT_STRING;
+      out->val.string.len  = (uint32_t)len;
+      out->val.string.buff = (char*)q;
+   }
+   q += len;
 
-            if (skip_rest)
-            {
-               /* Already decided — skip both key and value */
-               if (  rmsgpack_skip_value(cursor->fd) < 0
-                  || rmsgpack_skip_value(cursor->fd) < 0)
-               { error = 1; break; }
-               continue;
-            }
+done:
+   *p = q;
+   return 0;
+}
 
-            /* Read the key string into stack buffer */
-            key_len = rmsgpack_read_key_string(
-                  cursor->fd, key_buf, sizeof(key_buf));
+/**
+ * libretrodb_cursor_read_record:
+ *
+ * Read the record at the cursor, as a view into the mapping when
+ * @view is set and the database is mapped, otherwise as an owned DOM.
+ */
+static int libretrodb_cursor_read_record(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out, bool view)
+{
+   if (view && cursor->db->map)
+   {
+      const uint8_t *p;
+      int64_t pos = intfstream_tell(cursor->fd);
 
-            if (key_len < 0)
-            {
-               /* Key read failed — skip value and continue */
-               if (rmsgpack_skip_value(cursor->fd) < 0)
-               { error = 1; break; }
-               continue;
-            }
+      if (pos < 0 || (uint64_t)pos > cursor->db->map_len)
+         return -1;
+      p = cursor->db->map + pos;
+      if (libretrodb_view_read(&p, cursor->db->map + cursor->db->map_len,
+               out, 0) < 0)
+         return -1;
+      if (intfstream_seek(cursor->fd, (int64_t)(p - cursor->db->map),
+               RETRO_VFS_SEEK_POSITION_START) < 0)
+      {
+         libretrodb_view_free(out);
+         return -1;
+      }
+      return 0;
+   }
 
-            /* Evaluate this field against the query inline.
-             * eval_field returns:
-             *   -1 = field not in query (skip it)
-             *    0 = condition failed (reject record)
-             *    1 = condition passed */
-            {
-               struct rmsgpack_dom_value field_val;
-               int eval_result;
-
-               /* Peek: is this field in the query at all?
-                * Check before parsing the value to avoid
-                * unnecessary DOM allocation */
-               eval_result = libretrodb_query_eval_field(
-                     cursor->query, key_buf, (uint32_t)key_len,
-                     NULL);
-
-               if (eval_result == -1)
-               {
-                  /* Field not in query — skip value entirely */
-                  if (rmsgpack_skip_value(cursor->fd) < 0)
-                  { error = 1; break; }
-                  continue;
-               }
-
-               /* Field IS in query — parse value and evaluate */
-               if (rmsgpack_dom_read(cursor->fd, &field_val) < 0)
-               { error = 1; break; }
-
-               eval_result = libretrodb_query_eval_field(
-                     cursor->query, key_buf, (uint32_t)key_len,
-                     &field_val);
-
-               rmsgpack_dom_value_free(&field_val);
-
-               if (eval_result == 0)
-               {
-                  /* Condition failed — reject this record.
-                   * Skip remaining fields to advance to next record. */
-                  rejected  = 1;
-                  skip_rest = 1;
-               }
-               else if (eval_result == 1)
-               {
-                  conditions_met++;
-                  /* If all conditions satisfied, we can also skip
-                   * remaining fields (they're not query-relevant) */
-                  if (conditions_met >= num_qfields)
-                     skip_rest = 1;
-               }
-            }
+   return rmsgpack_dom_read(cursor->fd, out) < 0 ? -1 : 0;
+}
+
+static void libretrodb_cursor_free_record(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *item, bool view)
+{
+   if (view && cursor->db && cursor->db->map)
+      libretrodb_view_free(item);
+   else
+      rmsgpack_dom_value_free(item);
+}
+
+/**
+ * libretrodb_cursor_eval_field:
+ *
+ * Read the value of query field @key at the cursor and evaluate it.
+ * Mapped, the value is decoded in place; a string is copied to the
+ * stack first, since glob() needs it terminated.
+ */
+static int libretrodb_cursor_eval_field(libretrodb_cursor_t *cursor,
+      const char *key, uint32_t key_len)
+{
+   struct rmsgpack_dom_value field_val;
+   int eval_result;
+
+   if (cursor->db->map)
+   {
+      char scratch[256];
+      int64_t pos = intfstream_tell(cursor->fd);
+
+      if (libretrodb_cursor_read_record(cursor, &field_val, true) < 0)
+         return -2;
+
+      if (field_val.type == RDT_STRING)
+      {
+         if (field_val.val.string.len >= sizeof(scratch))
+         {
+            /* Too long for the stack: take the owned copy */
+            if (intfstream_seek(cursor->fd, pos,
+                     RETRO_VFS_SEEK_POSITION_START) < 0)
+               return -2;
+            goto owned;
          }
+         memcpy(scratch, field_val.val.string.buff,
+               field_val.val.string.len);
+         scratch[field_val.val.string.len] = '\0';
+         field_val.val.string.buff         = scratch;
+      }
 
-         if (error)
-            return -1;
+      eval_result = libretrodb_query_eval_field(
+            cursor->query, key, key_len, &field_val);
+      libretrodb_view_free(&field_val);
+      return eval_result;
+   }
 
-         /* Reject: all conditions not met, or explicit mismatch */
-         if (rejected || conditions_met < num_qfields)
-            continue;
+owned:
+   if (rmsgpack_dom_read(cursor->fd, &field_val) < 0)
+      return -2;
+
+   eval_result = libretrodb_query_eval_field(
+         cursor->query, key, key_len, &field_val);
+
+   rmsgpack_dom_value_free(&field_val);
+   return eval_result;
+}
+
+/**
+ * libretrodb_cursor_next_match:
+ *
+ * Folded field-level scan with inline evaluation: steps over records
+ * the query rejects, parsing only the fields it names.  With @single
+ * only the record at the cursor is judged.
+ *
+ * Returns: 0 with the cursor at the start of a matching record, 1 with
+ * it at the start of a record the fast path cannot judge (the caller
+ * reads and filters that one in full), 2 when @single and the record
+ * was rejected, EOF at the end of the records, or -1 on a malformed
+ * stream.
+ */
+static int libretrodb_cursor_next_match(libretrodb_cursor_t *cursor,
+      int num_qfields, bool single)
+{
+   for (;;)
+   {
+      int32_t  map_len;
+      int32_t  i;
+      int64_t  record_start;
+      int      conditions_met   = 0;
+      int      rejected         = 0;
+      int      skip_rest        = 0;
+
+      /* Remember where this record starts so we can rewind
+       * if the query matches */
+      record_start = intfstream_tell(cursor->fd);
+      if (record_start < 0)
+         return -1;
 
-         /* Match! Rewind and do a full DOM parse so the caller
-          * gets the complete record */
+      /* Read the map header */
+      map_len = rmsgpack_read_map_header(cursor->fd);
+
+      if (map_len == -2)
+      {
+         /* nil sentinel — end of records */
+         cursor->eof = 1;
+         return EOF;
+      }
+
+      if (map_len < 0 || map_len > CURSOR_MAX_MAP_FIELDS)
+      {
+         /* Not a map, or too many fields for fast path.
+          * Rewind and let the caller take this one record the
+          * slow way. */
          intfstream_seek(cursor->fd, record_start,
                RETRO_VFS_SEEK_POSITION_START);
+         return 1;
+      }
 
-         if ((rv = rmsgpack_dom_read(cursor->fd, out)) < 0)
-            return rv;
+      /* Scan fields: for each key-value pair, read the key into
+       * a stack buffer, check if the query cares, and either skip
+       * the value or parse + evaluate it immediately inline. */
+      for (i = 0; i < map_len; i++)
+      {
+         char     key_buf[64];
+         int32_t  key_len;
+         int      eval_result;
 
-         return 0;
+         if (skip_rest)
+         {
+            /* Already decided — skip both key and value */
+            if (  rmsgpack_skip_value(cursor->fd) < 0
+               || rmsgpack_skip_value(cursor->fd) < 0)
+               return -1;
+            continue;
+         }
+
+         /* Read the key string into stack buffer */
+         key_len = rmsgpack_read_key_string(
+               cursor->fd, key_buf, sizeof(key_buf));
+
+         if (key_len < 0)
+         {
+            /* Key read failed — skip value and continue */
+            if (rmsgpack_skip_value(cursor->fd) < 0)
+               return -1;
+            continue;
+         }
+
+         /* Evaluate this field against the query inline.
+          * eval_field returns:
+          *   -1 = field not in query (skip it)
+          *    0 = condition failed (reject record)
+          *    1 = condition passed
+          *
+          * Peek first: is this field in the query at all?  Checked
+          * before parsing the value to avoid unnecessary DOM
+          * allocation */
+         if (libretrodb_query_eval_field(cursor->query, key_buf,
+                  (uint32_t)key_len, NULL) == -1)
+         {
+            /* Field not in query — skip value entirely */
+            if (rmsgpack_skip_value(cursor->fd) < 0)
+               return -1;
+            continue;
+         }
+
+         /* Field IS in query — parse value and evaluate */
+         if ((eval_result = libretrodb_cursor_eval_field(cursor,
+                     key_buf, (uint32_t)key_len)) == -2)
+            return -1;
+
+         if (eval_result == 0)
+         {
+            /* Condition failed — reject this record.
+             * Skip remaining fields to advance to next record. */
+            rejected  = 1;
+            skip_rest = 1;
+         }
+         else if (eval_result == 1)
+         {
+            conditions_met++;
+            /* If all conditions satisfied, we can also skip
+             * remaining fields (they're not query-relevant) */
+            if (conditions_met >= num_qfields)
+               skip_rest = 1;
+         }
+      }
+
+      /* Reject: all conditions not met, or explicit mismatch */
+      if (rejected || conditions_met < num_qfields)
+      {
+         if (single)
+            return 2;
+         continue;
       }
+
+      /* Match! Rewind so the caller reads the complete record */
+      intfstream_seek(cursor->fd, record_start,
+            RETRO_VFS_SEEK_POSITION_START);
+      return 0;
    }
+}
+
+static int libretrodb_cursor_read(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out, bool view)
+{
+   int rv;
+   int num_qfields = 0;
+
+   if (cursor->eof)
+      return EOF;
+
+   /* If we can't extract field names (non-table query), every
+    * record goes through the full read and filter */
+   if (cursor->query)
+      num_qfields = libretrodb_query_get_filter_fields(
+            cursor->query, NULL, NULL, 0);
 
-slow_path:
-   /* Original full-DOM path — used when no query, or when the query
-    * structure isn't a simple table filter */
    for (;;)
    {
-slow_path_single:
-      if ((rv = rmsgpack_dom_read(cursor->fd, out)) < 0)
+      bool matched         = false;
+      int64_t record_start;
+
+      if (cursor->planned)
+      {
+         /* Visit only the records the index named, judging each
+          * against the whole query: the index answered one condition
+          * of it, and may be older than the records. */
+         if (cursor->plan_pos >= cursor->plan_count)
+         {
+            cursor->eof = 1;
+            return EOF;
+         }
+         if (intfstream_seek(cursor->fd,
+                  (int64_t)cursor->plan[cursor->plan_pos++],
+                  RETRO_VFS_SEEK_POSITION_START) < 0)
+            return -1;
+         if ((rv = libretrodb_cursor_next_match(cursor,
+                     num_qfields, true)) < 0)
+            return rv;
+         if (rv == 2)
+            continue;
+         matched = (rv == 0);
+      }
+      else if (num_qfields > 0)
+      {
+         if ((rv = libretrodb_cursor_next_match(cursor,
+                     num_qfields, false)) < 0)
+            return rv;
+         matched = (rv == 0);
+      }
+
+      if ((record_start = intfstream_tell(cursor->fd)) < 0)
+         return -1;
+
+      if ((rv = libretrodb_cursor_read_record(cursor, out, view)) < 0)
          return rv;
 
       if (out->type == RDT_NULL)
@@ -1029,11 +1580,37 @@ slow_path_single:
          return EOF;
       }
 
-      if (cursor->query)
+      if (!matched && cursor->query)
       {
-         if (!libretrodb_query_filter(cursor->query, out))
+         bool keep;
+
+         /* The query functions expect terminated strings, which a
+          * view cannot give them; filter on an owned copy of the
+          * record instead.  Only records the fast path could not
+          * judge get here. */
+         if (view && cursor->db->map)
+         {
+            struct rmsgpack_dom_value owned;
+            int64_t next = intfstream_tell(cursor->fd);
+
+            if (     intfstream_seek(cursor->fd, record_start,
+                        RETRO_VFS_SEEK_POSITION_START) < 0
+                  || rmsgpack_dom_read(cursor->fd, &owned) < 0
+                  || intfstream_seek(cursor->fd, next,
+                        RETRO_VFS_SEEK_POSITION_START) < 0)
+            {
+               libretrodb_view_free(out);
+               return -1;
+            }
+            keep = libretrodb_query_filter(cursor->query, &owned) != 0;
+            rmsgpack_dom_value_free(&owned);
+         }
+         else
+            keep = libretrodb_query_filter(cursor->query, out) != 0;
+
+         if (!keep)
          {
-            rmsgpack_dom_value_free(out);
+            libretrodb_cursor_free_record(cursor, out, view);
             continue;
          }
       }
@@ -1042,6 +1619,24 @@ slow_path_single:
    }
 }
 
+int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   return libretrodb_cursor_read(cursor, out, false);
+}
+
+int libretrodb_cursor_read_item_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   return libretrodb_cursor_read(cursor, out, true);
+}
+
+void libretrodb_cursor_item_free(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *item)
+{
+   libretrodb_cursor_free_record(cursor, item, true);
+}
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -1063,12 +1658,18 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
 
    if (cursor->query)
       libretrodb_query_free(cursor->query);
-
-   cursor->is_valid = 0;
-   cursor->eof      = 1;
-   cursor->fd       = NULL;
-   cursor->db       = NULL;
-   cursor->query    = NULL;
+   if (cursor->plan)
+      free(cursor->plan);
+
+   cursor->is_valid   = 0;
+   cursor->eof        = 1;
+   cursor->fd         = NULL;
+   cursor->db         = NULL;
+   cursor->query      = NULL;
+   cursor->plan       = NULL;
+   cursor->plan_count = 0;
+   cursor->plan_pos   = 0;
+   cursor->planned    = false;
 }
 
 /**
@@ -1092,18 +1693,19 @@ int libretrodb_cursor_open(libretrodb_t *db,
 
    /* Walking the record stream is what a content scan spends its time
     * on, and most of that is the per-read trip through
-    * filestream/VFS/fread rather than parsing.  A sliding window turns
-    * those reads into a memcpy while keeping the resident cost fixed
-    * at LIBRETRODB_WINDOW_SIZE instead of the size of the database. */
-   if (!(fd = intfstream_open_buffered(db->path, LIBRETRODB_WINDOW_SIZE)))
-      if (!(fd = intfstream_open_file(db->path,
-                  RETRO_VFS_FILE_ACCESS_READ,
-                  RETRO_VFS_FILE_ACCESS_HINT_NONE)))
-         return -1;
+    * filestream/VFS/fread rather than parsing.  The mapping, or failing
+    * that a sliding window, turns those reads into a memcpy while
+    * keeping the resident cost fixed at LIBRETRODB_WINDOW_SIZE instead
+    * of the size of the database. */
+   if (!(fd = libretrodb_open_stream(db)))
+      return -1;
 
-   cursor->fd       = fd;
-   cursor->db       = db;
-   cursor->is_valid = 1;
+   cursor->fd         = fd;
+   cursor->db         = db;
+   cursor->is_valid   = 1;
+   cursor->plan       = NULL;
+   cursor->plan_count = 0;
+   cursor->planned    = false;
    libretrodb_cursor_reset(cursor);
    cursor->query    = q;
 
@@ -1116,11 +1718,17 @@ int libretrodb_cursor_open(libretrodb_t *db,
        * the cursor that references it, and a second walk over the
        * same query used to inherit the first walk's extreme. */
       libretrodb_query_reset_accumulator(q);
+      libretrodb_cursor_plan(cursor);
    }
 
    return 0;
 }
 
+bool libretrodb_cursor_uses_index(libretrodb_cursor_t *cursor)
+{
+   return cursor && cursor->planned;
+}
+
 /* bintree stores values by pointer and does not own them, so the
  * key buffers handed to bintree_insert() have to be released here.
  * They were not, leaking (key_size + 8) bytes per indexed record -
@@ -1284,6 +1892,10 @@ libretrodb_cursor_t *libretrodb_cursor_new(void)
    dbc->eof                 = 0;
    dbc->query               = NULL;
    dbc->db                  = NULL;
+   dbc->plan                = NULL;
+   dbc->plan_count          = 0;
+   dbc->plan_pos            = 0;
+   dbc->planned             = false;
 
    return dbc;
 }
@@ -1306,6 +1918,9 @@ libretrodb_t *libretrodb_new(void)
    db->count              = 0;
    db->first_index_offset = 0;
    db->path               = NULL;
+   db->map_file           = NULL;
+   db->map                = NULL;
+   db->map_len            = 0;
 
    return db;
 }
@@ -107,6 +107,10 @@ int libretrodb_cursor_open(libretrodb_t *db,
       libretrodb_cursor_t *cursor,
       libretrodb_query_t *query);
 
+/* True when @cursor visits records through an index rather than
+ * walking the database; set by libretrodb_cursor_open(). */
+bool libretrodb_cursor_uses_index(libretrodb_cursor_t *cursor);
+
 /**
  * libretrodb_cursor_reset:
  * @cursor              : Handle to database cursor.
@@ -133,6 +137,25 @@ void libretrodb_query_free(void *q);
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_cursor_read_item_view:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Receives the next matching record.
+ *
+ * Like libretrodb_cursor_read_item(), but when the database could be
+ * mapped the strings and binaries in @out point into the mapping
+ * rather than into copies.  Such buffers are NOT NUL-terminated: use
+ * their len.  Release @out with libretrodb_cursor_item_free() before
+ * the cursor is closed.
+ *
+ * Returns: 0 if successful, EOF at the end, otherwise negative.
+ **/
+int libretrodb_cursor_read_item_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out);
+
+void libretrodb_cursor_item_free(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *item);
+
 RETRO_END_DECLS
 
 #endif
@@ -21,9 +21,11 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <string/stdstring.h>
+#include <features/features_cpu.h>
 
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
@@ -48,6 +50,7 @@ int main(int argc, char ** argv)
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
       printf("\tget-names <query expression>\n");
+      printf("\tbench <query expression> [runs]\n");
       return 1;
    }
 
@@ -60,7 +63,10 @@ int main(int argc, char ** argv)
    if (!db || !cur)
       goto error;
 
-   if ((rv = libretrodb_open(path, db, true)) != 0)
+   /* Only create-index writes; everything else opens read-only, which
+    * lets the database be mapped */
+   if ((rv = libretrodb_open(path, db,
+               string_is_equal(command, "create-index"))) != 0)
    {
       printf("Could not open db file '%s'\n", path);
       goto error;
@@ -159,6 +165,59 @@ int main(int argc, char ** argv)
          rmsgpack_dom_value_free(&item);
       }
    }
+   else if (memcmp(command, "bench", 5) == 0)
+   {
+      int i;
+      int runs         = 10;
+      unsigned matches = 0;
+      retro_time_t start;
+      retro_time_t elapsed;
+
+      if (argc != 4 && argc != 5)
+      {
+         printf("Usage: %s <db file> bench <query expression> [runs]\n", argv[0]);
+         goto error;
+      }
+      if (argc == 5 && (runs = atoi(argv[4])) < 1)
+         runs = 1;
+
+      query_exp = argv[3];
+      err       = NULL;
+      q = libretrodb_query_compile(db, query_exp, strlen(query_exp), &err);
+
+      if (err)
+      {
+         printf("%s\n", err);
+         goto error;
+      }
+
+      /* Times the whole lookup, cursor open (and with it any index
+       * search) included, the way the scanner issues its queries */
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < runs; i++)
+      {
+         matches = 0;
+         if ((rv = libretrodb_cursor_open(db, cur, q)) != 0)
+         {
+            printf("Could not open cursor\n");
+            goto error;
+         }
+         while (libretrodb_cursor_read_item_view(cur, &item) == 0)
+         {
+            matches++;
+            libretrodb_cursor_item_free(cur, &item);
+         }
+         if (i == runs - 1)
+            printf("plan: %s\n", libretrodb_cursor_uses_index(cur)
+                  ? "index" : "scan");
+         /* Closing drops the cursor's reference, not ours */
+         libretrodb_cursor_close(cur);
+      }
+      elapsed = cpu_features_get_time_usec() - start;
+
+      printf("%u matches, %d runs, %lld us per query\n", matches, runs,
+            (long long)(elapsed / runs));
+   }
    else if (memcmp(command, "create-index", 12) == 0)
    {
       const char * index_name, * field_name;
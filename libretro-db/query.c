@@ -1235,6 +1235,75 @@ int libretrodb_query_get_filter_fields(libretrodb_query_t *q,
    return count;
 }
 
+/**
+ * libretrodb_query_get_keys:
+ *
+ * Describe condition @cond of a compiled table query as a set of
+ * keys, for a caller that can look records up by value rather than
+ * walk to them.  Only a binary literal, or or() over binary literals,
+ * qualifies: those are exactly "field equals one of these", which an
+ * index answers.
+ *
+ * @q           : Compiled query handle.
+ * @cond        : Condition to describe, counting from 0.
+ * @field_name  : Receives the field name (valid for the query's life).
+ * @field_len   : Receives its length.
+ * @keys        : Receives up to @max_keys pointers to the literals.
+ *
+ * Returns: the number of keys (which may exceed @max_keys, in which
+ *          case the caller should walk instead), 0 if the condition
+ *          is not a key match, or -1 once @cond is past the last one.
+ */
+int libretrodb_query_get_keys(libretrodb_query_t *q, unsigned cond,
+      const char **field_name, uint32_t *field_len,
+      const struct rmsgpack_dom_value **keys, unsigned max_keys)
+{
+   unsigned i;
+   struct argument *key_arg;
+   struct argument *val_arg;
+   struct query *rq = (struct query *)q;
+
+   if (  !rq || !rq->root.func || !rq->root.argv
+      || rq->root.func != query_func_all_map)
+      return -1;
+
+   if ((size_t)cond * 2 + 1 >= rq->root.argc)
+      return -1;
+
+   key_arg = &rq->root.argv[cond * 2];
+   val_arg = &rq->root.argv[cond * 2 + 1];
+
+   if (  key_arg->type         != AT_VALUE
+      || key_arg->a.value.type != RDT_STRING)
+      return 0;
+
+   *field_name = key_arg->a.value.val.string.buff;
+   *field_len  = key_arg->a.value.val.string.len;
+
+   if (val_arg->type == AT_VALUE)
+   {
+      if (val_arg->a.value.type != RDT_BINARY)
+         return 0;
+      if (max_keys)
+         keys[0] = &val_arg->a.value;
+      return 1;
+   }
+
+   if (val_arg->a.invocation.func != query_func_operator_or)
+      return 0;
+
+   for (i = 0; i < val_arg->a.invocation.argc; i++)
+   {
+      struct argument *arg = &val_arg->a.invocation.argv[i];
+      if (arg->type != AT_VALUE || arg->a.value.type != RDT_BINARY)
+         return 0;
+      if (i < max_keys)
+         keys[i] = &arg->a.value;
+   }
+
+   return (int)val_arg->a.invocation.argc;
+}
+
 /**
  * libretrodb_query_eval_field:
  *
@@ -46,6 +46,10 @@ int libretrodb_query_get_filter_fields(libretrodb_query_t *q,
       const char **field_names, uint32_t *field_lens,
       unsigned max_fields);
 
+int libretrodb_query_get_keys(libretrodb_query_t *q, unsigned cond,
+      const char **field_name, uint32_t *field_len,
+      const struct rmsgpack_dom_value **keys, unsigned max_keys);
+
 int libretrodb_query_eval_field(libretrodb_query_t *q,
       const char *field_name, uint32_t field_len,
       struct rmsgpack_dom_value *value);
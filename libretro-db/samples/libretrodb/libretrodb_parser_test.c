@@ -53,6 +53,12 @@
  *                           back from such an offset.  The two have
  *                           to agree with what a query returns,
  *                           including for keys that repeat.
+ *   query plans             a query keyed on an indexed field is
+ *                           answered through the index, and has to
+ *                           return what a walk would.
+ *   views                   libretrodb_cursor_read_item_view()
+ *                           decodes in place over the mapped file
+ *                           and must agree with the owned reader.
  *   query slices            libretrodb_query_compile() takes a
  *                           (pointer, length) pair, but the parser
  *                           handed identifier slices to strlcpy(),
@@ -743,6 +749,196 @@ static void case_query_slices(const char *dir)
    libretrodb_free(db);
 }
 
+/* Field by field: rmsgpack_dom_value_cmp() never reports two maps
+ * equal, and the DOM reader fills a map back to front while the view
+ * reader keeps file order. */
+static int same_record(const struct rmsgpack_dom_value *a,
+      const struct rmsgpack_dom_value *b)
+{
+   uint32_t i, j;
+
+   if (a->type != RDT_MAP || b->type != RDT_MAP)
+      return rmsgpack_dom_value_cmp(a, b) == 0;
+   if (a->val.map.len != b->val.map.len)
+      return 0;
+   for (i = 0; i < a->val.map.len; i++)
+   {
+      for (j = 0; j < b->val.map.len; j++)
+         if (rmsgpack_dom_value_cmp(&a->val.map.items[i].key,
+                  &b->val.map.items[j].key) == 0)
+            break;
+      if (     j == b->val.map.len
+            || rmsgpack_dom_value_cmp(&a->val.map.items[i].value,
+                  &b->val.map.items[j].value) != 0)
+         return 0;
+   }
+   return 1;
+}
+
+/* Walk @path with @query (NULL for all records) through the view
+ * reader, collecting each record's "name" joined by '|'.  Every view
+ * is checked against the owned copy read by a second cursor in step. */
+static char *walk_views(const char *path, const char *query, int *same)
+{
+   libretrodb_t        *db   = libretrodb_new();
+   libretrodb_cursor_t *cur  = libretrodb_cursor_new();
+   libretrodb_cursor_t *ref  = libretrodb_cursor_new();
+   libretrodb_query_t  *q    = NULL;
+   libretrodb_query_t  *rq   = NULL;
+   const char          *err  = NULL;
+   struct rmsgpack_dom_value item, owned;
+   buf_t out;
+   unsigned i;
+   long n = 0;
+
+   memset(&out, 0, sizeof(out));
+   *same = 1;
+
+   if (!db || !cur || !ref || libretrodb_open(path, db, false) != 0)
+      goto done;
+   if (query)
+   {
+      q  = (libretrodb_query_t*)libretrodb_query_compile(db, query,
+            strlen(query), &err);
+      rq = (libretrodb_query_t*)libretrodb_query_compile(db, query,
+            strlen(query), &err);
+      if (!q || !rq || err)
+         goto done_db;
+   }
+   if (     libretrodb_cursor_open(db, cur, q) != 0
+         || libretrodb_cursor_open(db, ref, rq) != 0)
+      goto done_db;
+
+   while (libretrodb_cursor_read_item_view(cur, &item) == 0)
+   {
+      if (libretrodb_cursor_read_item(ref, &owned) != 0)
+      {
+         *same = 0;
+         libretrodb_cursor_item_free(cur, &item);
+         break;
+      }
+      if (!same_record(&item, &owned))
+         *same = 0;
+      rmsgpack_dom_value_free(&owned);
+
+      if (item.type == RDT_MAP)
+         for (i = 0; i < item.val.map.len; i++)
+         {
+            struct rmsgpack_dom_value *k = &item.val.map.items[i].key;
+            struct rmsgpack_dom_value *v = &item.val.map.items[i].value;
+            if (     k->type == RDT_STRING && k->val.string.len == 4
+                  && !memcmp(k->val.string.buff, "name", 4)
+                  && v->type == RDT_STRING)
+            {
+               if (out.len)
+                  bbyte(&out, '|');
+               bput(&out, v->val.string.buff, v->val.string.len);
+            }
+         }
+      libretrodb_cursor_item_free(cur, &item);
+      if (++n > RUNAWAY_LIMIT)
+         break;
+   }
+   /* The owned walk has to run out at the same point */
+   if (libretrodb_cursor_read_item(ref, &owned) == 0)
+   {
+      *same = 0;
+      rmsgpack_dom_value_free(&owned);
+   }
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_close(ref);
+
+done_db:
+   if (q)
+      libretrodb_query_free(q);
+   if (rq)
+      libretrodb_query_free(rq);
+   libretrodb_close(db);
+done:
+   libretrodb_free(db);
+   libretrodb_cursor_free(cur);
+   libretrodb_cursor_free(ref);
+   bbyte(&out, '\0');
+   return (char*)out.data;
+}
+
+/* libretrodb_cursor_read_item_view() decodes records in place over
+ * the mapped file.  Its values have to compare equal to the owned
+ * ones, through both the field-level query path and the full filter
+ * - including a string too long for the stack copy glob() is given -
+ * and a record cut short has to end the walk, not run off the map. */
+static void case_views(const char *dir)
+{
+   static const uint8_t crc_a[4] = { 0xde, 0xad, 0xbe, 0xef };
+   static const uint8_t crc_b[4] = { 0x12, 0x34, 0x56, 0x78 };
+   char   path[512];
+   char   long_name[301];
+   char  *names;
+   int    same;
+   buf_t  body, meta;
+
+   memset(long_name, 'X', sizeof(long_name) - 1);
+   long_name[sizeof(long_name) - 1] = '\0';
+
+   memset(&body, 0, sizeof(body)); memset(&meta, 0, sizeof(meta));
+   bfixmap(&body, 3);
+   bfixstr(&body, "name");   bfixstr(&body, "Alpha");
+   bfixstr(&body, "crc");    bbin(&body, crc_a, 4);
+   bfixstr(&body, "serial"); bbin(&body, "SLUS", 4);
+   bfixmap(&body, 3);
+   bfixstr(&body, "name");   bfixstr(&body, "Beta");
+   bfixstr(&body, "crc");    bbin(&body, crc_b, 4);
+   bfixstr(&body, "users");  buint8(&body, 200);
+   bfixmap(&body, 2);
+   bfixstr(&body, "name");   bstr32(&body, long_name, 300);
+   bfixstr(&body, "crc");    bbin(&body, crc_b, 4);
+   bnil(&body);
+   meta_count(&meta, 3);
+   sprintf(path, "%s/views.rdb", dir);
+   write_rdb(path, &body, &meta);
+   bfree(&body); bfree(&meta);
+
+   begin("view walk");
+   names = walk_views(path, NULL, &same);
+   check(names && same && strncmp(names, "Alpha|Beta|XXXX", 15) == 0
+         && strlen(names) == 11 + 300, "view walk", "matches owned read");
+   free(names);
+
+   begin("view query on binary");
+   names = walk_views(path, "{'crc': b'12345678'}", &same);
+   check(names && same && strncmp(names, "Beta|XXXX", 9) == 0,
+         "view query on binary", "both records");
+   free(names);
+
+   begin("view query with glob");
+   names = walk_views(path, "{'name': glob('Be*')}", &same);
+   check(names && same && strcmp(names, "Beta") == 0,
+         "view query with glob", names);
+   free(names);
+
+   begin("view glob on long string");
+   names = walk_views(path, "{'name': glob('XX*')}", &same);
+   check(names && same && strlen(names) == 300,
+         "view glob on long string", "owned fallback");
+   free(names);
+
+   /* String length runs past the end of the file */
+   memset(&body, 0, sizeof(body)); memset(&meta, 0, sizeof(meta));
+   bfixmap(&body, 1); bfixstr(&body, "name");
+   bbyte(&body, 0xdb);
+   bbyte(&body, 0x7f); bbyte(&body, 0xff); bbyte(&body, 0xff); bbyte(&body, 0xff);
+   bput(&body, "short", 5);
+   sprintf(path, "%s/views_trunc.rdb", dir);
+   write_rdb(path, &body, NULL);
+   bfree(&body);
+
+   begin("view of truncated string");
+   names = walk_views(path, NULL, &same);
+   check(names && *names == '\0', "view of truncated string",
+         "walk ends");
+   free(names);
+}
+
 /* Build an index over a database with unique keys, then look an
  * entry up through it.  This is the only path that reaches
  * bintree_insert() and binsearch(), and until now nothing exercised
@@ -828,6 +1024,57 @@ static void case_index_round_trip(const char *dir)
    else
       check(0, "index lookup", "database would not reopen");
    libretrodb_free(db);
+
+   /* A query keyed on the indexed field is answered through the
+    * index: records come back in file order, once each, and the
+    * query's other conditions still apply. */
+   begin("query planned on index");
+   db = libretrodb_new();
+   if (db && libretrodb_open(path, db, false) == 0)
+   {
+      static const char *text =
+         "{crc:or(b\"00000151\",b\"00000007\",b\"00000151\",b\"FFFFFFFF\"),"
+         " name:glob('G*')}";
+      const char *err          = NULL;
+      libretrodb_cursor_t *cur = libretrodb_cursor_new();
+      libretrodb_query_t  *q   = (libretrodb_query_t*)
+         libretrodb_query_compile(db, text, strlen(text), &err);
+      char names[64];
+      int planned              = 0;
+      struct rmsgpack_dom_value out;
+
+      names[0] = '\0';
+      if (cur && q && !err && libretrodb_cursor_open(db, cur, q) == 0)
+      {
+         planned = libretrodb_cursor_uses_index(cur);
+         while (libretrodb_cursor_read_item(cur, &out) == 0)
+         {
+            struct rmsgpack_dom_value key, *name;
+            key.type               = RDT_STRING;
+            key.val.string.len     = 4;
+            key.val.string.buff    = (char*)"name";
+            if (     (name = rmsgpack_dom_value_map_value(&out, &key))
+                  && name->type == RDT_STRING
+                  && strlen(names) + name->val.string.len + 2 < sizeof(names))
+            {
+               if (names[0])
+                  strcat(names, "|");
+               strcat(names, name->val.string.buff);
+            }
+            rmsgpack_dom_value_free(&out);
+         }
+         libretrodb_cursor_close(cur);
+      }
+      check(planned && !strcmp(names, "G00007|G00337"),
+            "query planned on index", names);
+      if (q)
+         libretrodb_query_free(q);
+      libretrodb_cursor_free(cur);
+      libretrodb_close(db);
+   }
+   else
+      check(0, "query planned on index", "database would not reopen");
+   libretrodb_free(db);
 }
 
 /* Collector for the scan test below. */
@@ -1002,6 +1249,7 @@ int main(int argc, char **argv)
    case_minmax_zero(dir);
    case_index_round_trip(dir);
    case_field_scan(dir);
+   case_views(dir);
 
    printf("\n%d checks, %d failures\n", checks, failures);
    return failures ? 1 : 0;
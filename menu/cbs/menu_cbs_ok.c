@@ -9075,6 +9075,22 @@ static int action_ok_playlist_clean(const char *path,
    return 0;
 }
 
+#ifdef HAVE_CHEEVOS
+static int action_ok_playlist_cheevos_hash_prewarm(const char *path,
+      const char *label, unsigned type, size_t idx, size_t entry_idx)
+{
+   playlist_t *playlist               = playlist_get_cached();
+   playlist_config_t *playlist_config = NULL;
+   if (!playlist)
+      return -1;
+   playlist_config = playlist_get_config(playlist);
+   if (!playlist_config || !*playlist_config->path)
+      return -1;
+   task_push_pl_manager_cheevos_hash_prewarm(playlist_config);
+   return 0;
+}
+#endif
+
 static int action_ok_playlist_refresh(const char *path,
       const char *label, unsigned type, size_t idx, size_t entry_idx)
 {
@@ -9478,6 +9494,9 @@ static int menu_cbs_init_bind_ok_compare_label(menu_file_list_cbs_t *cbs,
          {MENU_ENUM_LABEL_PLAYLIST_MANAGER_RESET_CORES,        action_ok_playlist_reset_cores},
          {MENU_ENUM_LABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST,     action_ok_playlist_clean},
          {MENU_ENUM_LABEL_PLAYLIST_MANAGER_REFRESH_PLAYLIST,   action_ok_playlist_refresh},
+#ifdef HAVE_CHEEVOS
+         {MENU_ENUM_LABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM, action_ok_playlist_cheevos_hash_prewarm},
+#endif
          {MENU_ENUM_LABEL_ACCOUNTS_RETRO_ACHIEVEMENTS,         action_ok_push_accounts_cheevos_list},
 #ifdef HAVE_LAKKA
          {MENU_ENUM_LABEL_EJECT_DISC,                          action_ok_push_eject_disc},
@@ -247,6 +247,8 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_unlock_sound_enable,   MENU_
 #endif
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_auto_screenshot,       MENU_ENUM_SUBLABEL_CHEEVOS_AUTO_SCREENSHOT)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_start_active,          MENU_ENUM_SUBLABEL_CHEEVOS_START_ACTIVE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_background_eval,       MENU_ENUM_SUBLABEL_CHEEVOS_BACKGROUND_EVAL)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_hash_cache,            MENU_ENUM_SUBLABEL_CHEEVOS_HASH_CACHE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_verbose_enable,        MENU_ENUM_SUBLABEL_CHEEVOS_VERBOSE_ENABLE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_appearance_settings,   MENU_ENUM_SUBLABEL_CHEEVOS_APPEARANCE_SETTINGS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheevos_appearance_anchor,     MENU_ENUM_SUBLABEL_CHEEVOS_APPEARANCE_ANCHOR)
@@ -1972,6 +1974,7 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
       { MENU_ENUM_LABEL_PLAYLIST_ENTRY_RENAME, MENU_ENUM_SUBLABEL_PLAYLIST_ENTRY_RENAME },
       { MENU_ENUM_LABEL_PLAYLIST_ENTRY_REMOVE, MENU_ENUM_SUBLABEL_PLAYLIST_ENTRY_REMOVE },
       { MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE, MENU_ENUM_SUBLABEL_THREADED_DATA_RUNLOOP_ENABLE },
+      { MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS, MENU_ENUM_SUBLABEL_THREADED_DATA_RUNLOOP_WORKERS },
       { MENU_ENUM_LABEL_SHOW_ADVANCED_SETTINGS, MENU_ENUM_SUBLABEL_SHOW_ADVANCED_SETTINGS },
       { MENU_ENUM_LABEL_SAVESTATE_LIST, MENU_ENUM_SUBLABEL_SAVESTATE_LIST },
       { MENU_ENUM_LABEL_STATE_SLOT_RUN, MENU_ENUM_SUBLABEL_LOAD_STATE },
@@ -2201,17 +2204,22 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
       { MENU_ENUM_LABEL_REWIND_SETTINGS, MENU_ENUM_SUBLABEL_REWIND_SETTINGS },
       { MENU_ENUM_LABEL_REWIND_ENABLE, MENU_ENUM_SUBLABEL_REWIND_ENABLE },
       { MENU_ENUM_LABEL_REWIND_GRANULARITY, MENU_ENUM_SUBLABEL_REWIND_GRANULARITY },
+      { MENU_ENUM_LABEL_REWIND_THREADED, MENU_ENUM_SUBLABEL_REWIND_THREADED },
+      { MENU_ENUM_LABEL_REWIND_COMPRESSION, MENU_ENUM_SUBLABEL_REWIND_COMPRESSION },
+      { MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL, MENU_ENUM_SUBLABEL_REWIND_KEYFRAME_INTERVAL },
       { MENU_ENUM_LABEL_REWIND_BUFFER_SIZE, MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE },
       { MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP, MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE_STEP },
       { MENU_ENUM_LABEL_SLOWMOTION_RATIO, MENU_ENUM_SUBLABEL_SLOWMOTION_RATIO },
       { MENU_ENUM_LABEL_RUN_AHEAD_UNSUPPORTED, MENU_ENUM_SUBLABEL_RUN_AHEAD_UNSUPPORTED },
       { MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS, MENU_ENUM_SUBLABEL_RUN_AHEAD_HIDE_WARNINGS },
+      { MENU_ENUM_LABEL_RUN_AHEAD_AUTO, MENU_ENUM_SUBLABEL_RUN_AHEAD_AUTO },
       { MENU_ENUM_LABEL_RUN_AHEAD_FRAMES, MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES },
       { MENU_ENUM_LABEL_PREEMPT_FRAMES, MENU_ENUM_SUBLABEL_PREEMPT_FRAMES },
       { MENU_ENUM_LABEL_INPUT_BLOCK_TIMEOUT, MENU_ENUM_SUBLABEL_INPUT_BLOCK_TIMEOUT },
       { MENU_ENUM_LABEL_FASTFORWARD_RATIO, MENU_ENUM_SUBLABEL_FASTFORWARD_RATIO },
       { MENU_ENUM_LABEL_FASTFORWARD_FRAMESKIP, MENU_ENUM_SUBLABEL_FASTFORWARD_FRAMESKIP },
       { MENU_ENUM_LABEL_VRR_RUNLOOP_ENABLE, MENU_ENUM_SUBLABEL_VRR_RUNLOOP_ENABLE },
+      { MENU_ENUM_LABEL_FRAME_LIMIT_PRECISE, MENU_ENUM_SUBLABEL_FRAME_LIMIT_PRECISE },
       { MENU_ENUM_LABEL_MENU_THROTTLE_FRAMERATE, MENU_ENUM_SUBLABEL_MENU_ENUM_THROTTLE_FRAMERATE },
       { MENU_ENUM_LABEL_BLOCK_SRAM_OVERWRITE, MENU_ENUM_SUBLABEL_BLOCK_SRAM_OVERWRITE },
       { MENU_ENUM_LABEL_SAVESTATE_AUTO_INDEX, MENU_ENUM_SUBLABEL_SAVESTATE_AUTO_INDEX },
@@ -2357,6 +2365,7 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
       { MENU_ENUM_LABEL_CONFIGURATION_SETTINGS, MENU_ENUM_SUBLABEL_CONFIGURATION_SETTINGS },
       { MENU_ENUM_LABEL_CONFIGURATIONS_LIST, MENU_ENUM_SUBLABEL_CONFIGURATIONS_LIST },
       { MENU_ENUM_LABEL_VIDEO_THREADED, MENU_ENUM_SUBLABEL_VIDEO_THREADED },
+      { MENU_ENUM_LABEL_VIDEO_THREADED_MAILBOX, MENU_ENUM_SUBLABEL_VIDEO_THREADED_MAILBOX },
       { MENU_ENUM_LABEL_VIDEO_HARD_SYNC, MENU_ENUM_SUBLABEL_VIDEO_HARD_SYNC },
       { MENU_ENUM_LABEL_VIDEO_HARD_SYNC_FRAMES, MENU_ENUM_SUBLABEL_VIDEO_HARD_SYNC_FRAMES },
       { MENU_ENUM_LABEL_VIDEO_REFRESH_RATE_AUTO, MENU_ENUM_SUBLABEL_VIDEO_REFRESH_RATE_AUTO },
@@ -2469,6 +2478,7 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
       { MENU_ENUM_LABEL_PLAYLIST_MANAGER_LABEL_DISPLAY_MODE, MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_LABEL_DISPLAY_MODE },
       { MENU_ENUM_LABEL_PLAYLIST_MANAGER_SORT_MODE, MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_SORT_MODE },
       { MENU_ENUM_LABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST, MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST },
+      { MENU_ENUM_LABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM, MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM },
       { MENU_ENUM_LABEL_PLAYLIST_MANAGER_REFRESH_PLAYLIST, MENU_ENUM_SUBLABEL_PLAYLIST_MANAGER_REFRESH_PLAYLIST },
       { MENU_ENUM_LABEL_DELETE_PLAYLIST, MENU_ENUM_SUBLABEL_DELETE_PLAYLIST },
       { MENU_ENUM_LABEL_AI_SERVICE_URL, MENU_ENUM_SUBLABEL_AI_SERVICE_URL },
@@ -3376,6 +3386,12 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_CHEEVOS_START_ACTIVE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_cheevos_start_active);
             break;
+         case MENU_ENUM_LABEL_CHEEVOS_BACKGROUND_EVAL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_cheevos_background_eval);
+            break;
+         case MENU_ENUM_LABEL_CHEEVOS_HASH_CACHE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_cheevos_hash_cache);
+            break;
          case MENU_ENUM_LABEL_CHEEVOS_APPEARANCE_SETTINGS:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_cheevos_appearance_settings);
             break;
@@ -5225,6 +5225,17 @@ static bool menu_displaylist_parse_playlist_manager_settings(
          MENU_ENUM_LABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST,
          MENU_SETTING_ACTION_PLAYLIST_MANAGER_CLEAN_PLAYLIST, 0, 0, NULL);
 
+#ifdef HAVE_CHEEVOS
+   /* Cache achievement hashes */
+   if (     settings->bools.cheevos_enable
+         && settings->bools.cheevos_hash_cache)
+      menu_entries_append(list,
+            msg_hash_to_str(MENU_ENUM_LABEL_VALUE_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM),
+            MENU_ENUM_LABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM_STR,
+            MENU_ENUM_LABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM,
+            MENU_SETTING_ACTION_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM, 0, 0, NULL);
+#endif
+
    /* Delete playlist */
    menu_entries_append(list,
          msg_hash_to_str(MENU_ENUM_LABEL_VALUE_DELETE_PLAYLIST),
@@ -10297,6 +10308,8 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_CHEEVOS_AUTO_SCREENSHOT,                               PARSE_ONLY_BOOL,   false  },
 #endif
                {MENU_ENUM_LABEL_CHEEVOS_START_ACTIVE,                                  PARSE_ONLY_BOOL,   false  },
+               {MENU_ENUM_LABEL_CHEEVOS_BACKGROUND_EVAL,                               PARSE_ONLY_BOOL,   false  },
+               {MENU_ENUM_LABEL_CHEEVOS_HASH_CACHE,                                    PARSE_ONLY_BOOL,   false  },
             };
 
             for (i = 0; i < ARRAY_SIZE(build_list); i++)
@@ -10457,6 +10470,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_MENU_ENABLE_KIOSK_MODE,                                PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_MENU_KIOSK_MODE_PASSWORD,                              PARSE_ONLY_STRING, false},
                {MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE,                          PARSE_ONLY_BOOL,   true},
+               {MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS,                         PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_TIMEOUT,                              PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_ANIMATION,                            PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_ANIMATION_SPEED,                      PARSE_ONLY_FLOAT,  false},
@@ -10647,6 +10661,7 @@ unsigned menu_displaylist_build_list(
                   /* Hide 'Threaded Video' from the menu on Apple platforms;
                    * the underlying video_threaded setting itself is kept. */
                   { MENU_ENUM_LABEL_VIDEO_THREADED, PARSE_ONLY_BOOL, false },
+                  { MENU_ENUM_LABEL_VIDEO_THREADED_MAILBOX, PARSE_ONLY_BOOL, false },
 #endif
                   { MENU_ENUM_LABEL_VIDEO_GPU_INDEX, PARSE_ONLY_INT, false },
                   { MENU_ENUM_LABEL_VIDEO_MONITOR_INDEX, PARSE_ONLY_UINT, false },
@@ -11343,6 +11358,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_RUNAHEAD_MODE,                         PARSE_ONLY_UINT, false },
                {MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,                      PARSE_ONLY_UINT, false },
                {MENU_ENUM_LABEL_PREEMPT_FRAMES,                        PARSE_ONLY_UINT, false },
+               {MENU_ENUM_LABEL_RUN_AHEAD_AUTO,                        PARSE_ONLY_BOOL, false },
                {MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,               PARSE_ONLY_BOOL, false },
 #endif
                {MENU_ENUM_LABEL_AUDIO_LATENCY,                         PARSE_ONLY_UINT, true },
@@ -11429,6 +11445,7 @@ unsigned menu_displaylist_build_list(
                   case MENU_ENUM_LABEL_PREEMPT_FRAMES:
                      build_list[i].checked = runahead_supported && preempt_enabled;
                      break;
+                  case MENU_ENUM_LABEL_RUN_AHEAD_AUTO:
                   case MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS:
                      build_list[i].checked = runahead_supported && (runahead_enabled || preempt_enabled);
                      break;
@@ -12504,6 +12521,13 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_REWIND_GRANULARITY,      PARSE_ONLY_UINT, true },
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE,      PARSE_ONLY_SIZE, true },
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP, PARSE_ONLY_UINT, true },
+#ifdef HAVE_THREADS
+               {MENU_ENUM_LABEL_REWIND_THREADED,         PARSE_ONLY_BOOL, true },
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_RZSTD)
+               {MENU_ENUM_LABEL_REWIND_COMPRESSION,      PARSE_ONLY_BOOL, true },
+#endif
+               {MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL, PARSE_ONLY_UINT, true },
                {MENU_ENUM_LABEL_AUDIO_REWIND_MUTE,       PARSE_ONLY_BOOL, true },
             };
 
@@ -12543,6 +12567,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_AUDIO_FASTFORWARD_SPEEDUP,   PARSE_ONLY_BOOL,  true },
                {MENU_ENUM_LABEL_SLOWMOTION_RATIO,            PARSE_ONLY_FLOAT, true },
                {MENU_ENUM_LABEL_VRR_RUNLOOP_ENABLE,          PARSE_ONLY_BOOL,  true },
+               {MENU_ENUM_LABEL_FRAME_LIMIT_PRECISE,         PARSE_ONLY_BOOL,  true },
                {MENU_ENUM_LABEL_MENU_THROTTLE_FRAMERATE,     PARSE_ONLY_BOOL,  false},
             };
 
@@ -72,6 +72,7 @@
 #include "../input/input_driver.h"
 #include "../input/input_remapping.h"
 #include "../performance_counters.h"
+#include "../performance_trace.h"
 #include "../version.h"
 #include "../misc/cpufreq/cpufreq.h"
 
@@ -4483,7 +4484,11 @@ void menu_driver_frame(bool menu_is_alive, video_frame_info_t *video_info)
 {
    struct menu_state    *menu_st = &menu_driver_state;
    if (menu_is_alive && menu_st->driver_ctx->frame)
+   {
+      PERF_TRACE_BEGIN("menu_frame");
       menu_st->driver_ctx->frame(menu_st->userdata, video_info);
+      PERF_TRACE_END("menu_frame");
+   }
 }
 
 /* Teardown function for the menu driver. */
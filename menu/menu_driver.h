@@ -283,6 +283,7 @@ enum menu_settings_type
    MENU_SETTING_ACTION_PLAYLIST_MANAGER_RESET_CORES,
    MENU_SETTING_ACTION_PLAYLIST_MANAGER_CLEAN_PLAYLIST,
    MENU_SETTING_ACTION_PLAYLIST_MANAGER_REFRESH_PLAYLIST,
+   MENU_SETTING_ACTION_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM,
 
    MENU_SETTING_SCAN_METHOD,
    MENU_SETTING_SCAN_USE_DB,
@@ -24,6 +24,7 @@
 #include <formats/rjson_stream.h>
 #include <formats/rjson_helpers.h>
 #include <retro_endianness.h>
+#include <streams/cache_file.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
 
@@ -96,9 +97,20 @@ typedef struct ex_arena
    char **blocks;
 } ex_arena;
 
+/* Set of entries: their indices in ascending order, or a bitmap over
+ * all entries once that is no larger */
+typedef struct
+{
+   uint32_t *ids;
+   uint32_t count;
+   bool dense;
+} explore_set_t;
+
 typedef struct
 {
    uint32_t idx;
+   explore_set_t set;       /* entries filed under this value */
+   explore_set_t split_set; /* entries that list it after another one */
    char str[1];
 } explore_string_t;
 
@@ -123,8 +135,15 @@ struct explore_state
 
    char title[1024];
    bool has_unknown[EXPLORE_CAT_COUNT];
+   explore_set_t unknown[EXPLORE_CAT_COUNT];
    unsigned show_icons;
 
+   uint32_t         *view_bits;   /* entries passing the current view */
+   uint32_t         *level_bits;  /* scratch for one filter level */
+   uint32_t         *search_bits; /* entries matching search_key */
+   uint32_t          set_words;   /* length of each of the above */
+   char              search_key[1024];
+
    unsigned          view_levels;
    char              view_search[1024];
    uint8_t           view_op[EXPLORE_CAT_COUNT];
@@ -473,11 +492,820 @@ static void explore_load_icons(explore_state_t *state)
    }
 }
 
+/* Entry sets
+ *
+ * Every category value keeps the set of entries filed under it, so a
+ * view is an intersection of one union of sets per filter level, and
+ * the search text is one more set, kept until the text changes. */
+
+#define EX_SET_BIT(n) ((uint32_t)1 << ((n) & 31))
+
+static bool explore_set_alloc(explore_state_t *state, explore_set_t *set)
+{
+   uint32_t words = state->set_words;
+
+   set->ids       = NULL;
+   set->dense     = (set->count >= words);
+   if (!set->count)
+      return true;
+
+   if (!(set->ids = (uint32_t*)ex_arena_alloc(&state->arena,
+               (set->dense ? words : set->count) * sizeof(uint32_t))))
+      return false;
+
+   if (set->dense)
+      memset(set->ids, 0, words * sizeof(uint32_t));
+   else
+      set->count = 0; /* counted again by explore_set_add */
+   return true;
+}
+
+static void explore_set_add(explore_set_t *set, uint32_t n)
+{
+   if (!set->ids)
+      return;
+   if (set->dense)
+      set->ids[n >> 5] |= EX_SET_BIT(n);
+   else
+      set->ids[set->count++] = n;
+}
+
+static void explore_set_or(uint32_t *bits, const explore_set_t *set,
+      uint32_t words)
+{
+   uint32_t i;
+   if (!set->ids)
+      return;
+   if (set->dense)
+      for (i = 0; i != words; i++)
+         bits[i] |= set->ids[i];
+   else
+      for (i = 0; i != set->count; i++)
+         bits[set->ids[i] >> 5] |= EX_SET_BIT(set->ids[i]);
+}
+
+/* Builds the sets of the final, sorted entries. On failure the view
+ * falls back to testing every entry. */
+static void explore_build_sets(explore_state_t *state)
+{
+   unsigned cat;
+   explore_entry_t *e;
+   explore_string_t **split;
+   uint32_t i, words;
+   bool ok          = true;
+   uint32_t count   = (uint32_t)RBUF_LEN(state->entries);
+
+   state->view_bits = NULL;
+   state->set_words = words = (count + 31) / 32;
+   if (!count)
+      return;
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+   {
+      for (i = 0; i != RBUF_LEN(state->by[cat]); i++)
+      {
+         state->by[cat][i]->set.count       = 0;
+         state->by[cat][i]->split_set.count = 0;
+      }
+      state->unknown[cat].count = 0;
+   }
+
+   for (e = state->entries; e != RBUF_END(state->entries); e++)
+   {
+      for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+      {
+         if (e->by[cat])
+            e->by[cat]->set.count++;
+         else
+            state->unknown[cat].count++;
+      }
+      if (e->split)
+         for (split = e->split; *split; split++)
+            (*split)->split_set.count++;
+   }
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+   {
+      for (i = 0; i != RBUF_LEN(state->by[cat]); i++)
+      {
+         if (     !explore_set_alloc(state, &state->by[cat][i]->set)
+               || !explore_set_alloc(state, &state->by[cat][i]->split_set))
+            ok = false;
+      }
+      if (!explore_set_alloc(state, &state->unknown[cat]))
+         ok = false;
+   }
+
+   for (e = state->entries, i = 0; e != RBUF_END(state->entries); e++, i++)
+   {
+      for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+         explore_set_add(e->by[cat]
+               ? &e->by[cat]->set : &state->unknown[cat], i);
+      if (e->split)
+         for (split = e->split; *split; split++)
+            explore_set_add(&(*split)->split_set, i);
+   }
+
+   state->level_bits     = (uint32_t*)ex_arena_alloc(&state->arena,
+         words * sizeof(uint32_t));
+   state->search_bits    = (uint32_t*)ex_arena_alloc(&state->arena,
+         words * sizeof(uint32_t));
+   state->search_key[0]  = '\0';
+   if (ok && state->level_bits && state->search_bits)
+      state->view_bits   = (uint32_t*)ex_arena_alloc(&state->arena,
+            words * sizeof(uint32_t));
+}
+
+/* Tests one entry against the first @levels filters and the search
+ * text; what the sets answer for all entries at once. */
+static bool explore_entry_matches(const explore_state_t *state,
+      const explore_entry_t *e, unsigned levels)
+{
+   unsigned i;
+   for (i = 0; i != levels; i++)
+   {
+      explore_string_t* eby = e->by[state->view_cats[i]];
+      switch (state->view_op[i])
+      {
+         case EXPLORE_OP_EQUAL:
+            if (state->view_match[i] == eby)
+               continue;
+            if (state->view_use_split[i] && e->split)
+            {
+               explore_string_t** split = e->split;
+               do
+               {
+                  if (*split == state->view_match[i])
+                     break;
+               } while (*(++split));
+               if (*split)
+                  continue;
+            }
+            return false;
+         case EXPLORE_OP_MIN:
+            if (eby && eby->idx >= state->view_idx_min[i])
+               continue;
+            return false;
+         case EXPLORE_OP_MAX:
+            if (eby && eby->idx <= state->view_idx_max[i])
+               continue;
+            return false;
+         case EXPLORE_OP_RANGE:
+            if (eby && eby->idx >= state->view_idx_min[i]
+                    && eby->idx <= state->view_idx_max[i])
+               continue;
+            return false;
+      }
+   }
+
+   return (!*state->view_search || compat_strcasestr(
+            e->playlist_entry->label, state->view_search));
+}
+
+/* Returns the bitmap of entries passing the first @levels filters and
+ * the search text, or NULL if every entry has to be tested with
+ * explore_entry_matches() instead. */
+static const uint32_t *explore_filter(explore_state_t *state,
+      unsigned levels)
+{
+   unsigned i;
+   uint32_t j;
+   uint32_t words  = state->set_words;
+   uint32_t *bits  = state->view_bits;
+   uint32_t *level = state->level_bits;
+
+   if (!bits)
+      return NULL;
+
+   memset(bits, 0xFF, words * sizeof(uint32_t));
+
+   for (i = 0; i != levels; i++)
+   {
+      unsigned cat          = state->view_cats[i];
+      uint8_t op            = state->view_op[i];
+      explore_string_t **by = state->by[cat];
+      uint32_t _len         = (uint32_t)RBUF_LEN(by);
+
+      memset(level, 0, words * sizeof(uint32_t));
+
+      if (op == EXPLORE_OP_EQUAL)
+      {
+         explore_string_t *match = state->view_match[i];
+         if (!match)
+            explore_set_or(level, &state->unknown[cat], words);
+         else
+         {
+            explore_set_or(level, &match->set, words);
+            if (state->view_use_split[i])
+               explore_set_or(level, &match->split_set, words);
+         }
+      }
+      else
+      {
+         /* Ranges only look at the value an entry is filed under */
+         uint32_t lo = (op == EXPLORE_OP_MAX) ? 0 : state->view_idx_min[i];
+         uint32_t hi = (op == EXPLORE_OP_MIN) ? _len : state->view_idx_max[i];
+         for (j = lo; j < _len && j <= hi; j++)
+            explore_set_or(level, &by[j]->set, words);
+      }
+
+      for (j = 0; j != words; j++)
+         bits[j] &= level[j];
+   }
+
+   if (*state->view_search)
+   {
+      uint32_t *search = state->search_bits;
+
+      if (strcmp(state->search_key, state->view_search))
+      {
+         explore_entry_t *e;
+         memset(search, 0, words * sizeof(uint32_t));
+         for (e = state->entries, j = 0;
+               e != RBUF_END(state->entries); e++, j++)
+            if (compat_strcasestr(e->playlist_entry->label,
+                     state->view_search))
+               search[j >> 5] |= EX_SET_BIT(j);
+         strlcpy(state->search_key, state->view_search,
+               sizeof(state->search_key));
+      }
+
+      for (j = 0; j != words; j++)
+         bits[j] &= search[j];
+   }
+
+   return bits;
+}
+
+static playlist_t *explore_open_playlist(const char *path)
+{
+   playlist_config_t playlist_config;
+
+   playlist_config.base_content_directory[0] = '\0';
+   playlist_config.capacity                  = COLLECTION_SIZE;
+   playlist_config.old_format                = false;
+   playlist_config.compress                  = false;
+   playlist_config.fuzzy_archive_match       = false;
+   playlist_config.autofix_paths             = false;
+   strlcpy(playlist_config.path, path, sizeof(playlist_config.path));
+
+   return playlist_init(&playlist_config);
+}
+
+/* Database an entry of the playlist @fname is looked up in */
+static const char *explore_db_name(const struct playlist_entry *entry,
+      const char *fname)
+{
+   /* For auto scanned playlists the entry db_name matches the
+    * lpl file name and we can just use that */
+   if (entry->db_name && *entry->db_name
+         && strcasecmp(entry->db_name, fname))
+      return entry->db_name;
+   return fname;
+}
+
+static void explore_rdb_path(char *s, size_t len,
+      const char *directory_database, const char *db_name)
+{
+   char *ext_path = NULL;
+
+   fill_pathname_join_special(s, directory_database, db_name, len);
+
+   /* Replace the extension - change 'lpl' to 'rdb' */
+   if ((    ext_path = path_get_extension_mutable(s))
+         && ext_path[0] == '.'
+         && ext_path[1] == 'l'
+         && ext_path[2] == 'p'
+         && ext_path[3] == 'l')
+   {
+      ext_path[1] = 'r';
+      ext_path[2] = 'd';
+      ext_path[3] = 'b';
+   }
+}
+
+/* Index cache
+ *
+ * Building the index reads every playlist and every database they
+ * name, and reading the databases is most of the time it takes. The
+ * built index is written to FILE_PATH_EXPLORE_CACHE in the playlist
+ * directory together with the size and modification time of each
+ * playlist and database it was built from. While those all still
+ * agree, the next build loads only the playlists and takes the rest
+ * from the cache. A playlist that contributed no entries, such as the
+ * history, may change as long as its entries still only name
+ * databases that could not be opened.
+ *
+ * All integers little endian; v is a LEB128 varint, s a u16 length
+ * followed by that many bytes:
+ *
+ *   "RAEX" u32 version  u8 categories  u8 flags  s yes  s no
+ *   u32 count * (s file name, u64 size, i64 mtime, u8 used)  playlists
+ *   u32 count * (s path, u64 size, i64 mtime, u8 opened)     databases
+ *   per category: u8 has unknown, u32 count * s              sorted values
+ *   u32 count * entry, sorted:
+ *     v playlist  v index  u8 n * (u8 category, v value)
+ *     v n * (u8 category, v value)                           split values
+ *     s original title, if built with EXPLORE_SHOW_ORIGINAL_TITLE
+ *
+ * A cache that is out of date is rebuilt like one that fails to parse.
+ * Entries refer to values by position, so no record can be left out: an
+ * index with a string too long for its u16 length is not cached at all. */
+
+#define EXPLORE_CACHE_MAGIC   "RAEX"
+#define EXPLORE_CACHE_VERSION 1
+#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
+#define EXPLORE_CACHE_FLAGS   1
+#else
+#define EXPLORE_CACHE_FLAGS   0
+#endif
+
+struct explore_cache_file
+{
+   char *path;     /* playlist file name, or database path */
+   uint64_t size;
+   int64_t mtime;  /* 0 if missing */
+   bool used;      /* playlist has indexed entries; database opened */
+};
+
+/* Returns false if @path exists but the platform cannot say when it
+ * last changed. A missing file is a state the cache can record. */
+static bool explore_stat(const char *path, uint64_t *size, int64_t *mtime)
+{
+   int64_t _size;
+   if (path_get_size_mtime(path, &_size, mtime))
+   {
+      *size = (uint64_t)_size;
+      return true;
+   }
+   *size  = 0;
+   return !path_is_valid(path);
+}
+
+/* Records @path as it is now under @name. Returns NULL if out of
+ * memory or if @path cannot be told apart from a changed copy, and
+ * then the cache must not be written. */
+static struct explore_cache_file *explore_cache_file_add(
+      struct explore_cache_file **files, const char *name,
+      const char *path)
+{
+   struct explore_cache_file file;
+
+   if (!explore_stat(path, &file.size, &file.mtime))
+      return NULL;
+   if (!(file.path = strdup(name)))
+      return NULL;
+   file.used = false;
+
+   if (!RBUF_TRYFIT(*files, RBUF_LEN(*files) + 1))
+   {
+      free(file.path);
+      return NULL;
+   }
+   RBUF_PUSH(*files, file);
+   return &(*files)[RBUF_LEN(*files) - 1];
+}
+
+static const struct explore_cache_file *explore_cache_file_find(
+      const struct explore_cache_file *files, const char *path)
+{
+   size_t i;
+   for (i = 0; i != RBUF_LEN(files); i++)
+      if (string_is_equal(files[i].path, path))
+         return &files[i];
+   return NULL;
+}
+
+static void explore_cache_files_free(struct explore_cache_file **files)
+{
+   size_t i;
+   for (i = 0; i != RBUF_LEN(*files); i++)
+      free((*files)[i].path);
+   RBUF_FREE(*files);
+}
+
+/* Category and index of a value an entry lists after another one */
+static void ex_cache_put_split(cache_file_writer_t *w,
+      const explore_state_t *state, const explore_string_t *str)
+{
+   unsigned cat;
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+      if (     str->idx < RBUF_LEN(state->by[cat])
+            && state->by[cat][str->idx] == str)
+         break;
+   cache_file_put8(w, cat);
+   cache_file_put_varint(w, str->idx);
+}
+
+static bool ex_cache_str_equal(const char *s, size_t _len, const char *str)
+{
+   return s && strlen(str) == _len && !memcmp(s, str, _len);
+}
+
+static struct explore_cache_file *ex_cache_get_files(cache_file_reader_t *r)
+{
+   uint32_t i;
+   struct explore_cache_file *files = NULL;
+   uint32_t count                   = cache_file_get32(r);
+
+   for (i = 0; i < count && !r->error; i++)
+   {
+      struct explore_cache_file file;
+
+      if (!(file.path = cache_file_get_strdup(r)))
+         break;
+      file.size     = cache_file_get64(r);
+      file.mtime    = (int64_t)cache_file_get64(r);
+      file.used     = (cache_file_get8(r) != 0);
+
+      if (r->error || !RBUF_TRYFIT(files, RBUF_LEN(files) + 1))
+      {
+         free(file.path);
+         break;
+      }
+      RBUF_PUSH(files, file);
+   }
+
+   if (i < count)
+      r->error = true;
+   return files;
+}
+
+static bool explore_cache_file_changed(const struct explore_cache_file *file,
+      const char *path)
+{
+   uint64_t size;
+   int64_t mtime;
+   return     !explore_stat(path, &size, &mtime)
+         || size  != file->size
+         || mtime != file->mtime;
+}
+
+/* Whether the playlist at @path, had it been read in the last build,
+ * would still have contributed no entries */
+static bool explore_cache_playlist_unused(const char *path,
+      const char *fname, const char *directory_database,
+      const struct explore_cache_file *rdbs)
+{
+   size_t j;
+   char tmp[PATH_MAX_LENGTH];
+   bool unused          = true;
+   playlist_t *playlist = explore_open_playlist(path);
+
+   for (j = 0; unused && j < playlist_size(playlist); j++)
+   {
+      const struct explore_cache_file *rdb = NULL;
+      const struct playlist_entry *entry   = NULL;
+      playlist_get_index(playlist, j, &entry);
+
+      if (!entry->label || !*entry->label)
+         continue;
+
+      explore_rdb_path(tmp, sizeof(tmp), directory_database,
+            explore_db_name(entry, fname));
+      rdb    = explore_cache_file_find(rdbs, tmp);
+      unused = rdb && !rdb->used;
+   }
+
+   playlist_free(playlist);
+   return unused;
+}
+
+static void explore_cache_write(const explore_state_t *state,
+      const char *path,
+      const struct explore_cache_file *lpls,
+      const struct explore_cache_file *rdbs)
+{
+   size_t i, j;
+   unsigned cat;
+   const explore_entry_t *e;
+   cache_file_writer_t w = { NULL, 0, 0, false };
+
+   cache_file_put(&w, EXPLORE_CACHE_MAGIC, 4);
+   cache_file_put32(&w, EXPLORE_CACHE_VERSION);
+   cache_file_put8(&w, EXPLORE_CAT_COUNT);
+   cache_file_put8(&w, EXPLORE_CACHE_FLAGS);
+   if (     !cache_file_put_str(&w, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_YES))
+         || !cache_file_put_str(&w, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO)))
+      goto end;
+
+   cache_file_put32(&w, (uint32_t)RBUF_LEN(lpls));
+   for (i = 0; i != RBUF_LEN(lpls); i++)
+   {
+      if (!cache_file_put_str(&w, lpls[i].path))
+         goto end;
+      cache_file_put64(&w, lpls[i].size);
+      cache_file_put64(&w, (uint64_t)lpls[i].mtime);
+      cache_file_put8(&w, lpls[i].used);
+   }
+
+   cache_file_put32(&w, (uint32_t)RBUF_LEN(rdbs));
+   for (i = 0; i != RBUF_LEN(rdbs); i++)
+   {
+      if (!cache_file_put_str(&w, rdbs[i].path))
+         goto end;
+      cache_file_put64(&w, rdbs[i].size);
+      cache_file_put64(&w, (uint64_t)rdbs[i].mtime);
+      cache_file_put8(&w, rdbs[i].used);
+   }
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+   {
+      cache_file_put8(&w, state->has_unknown[cat]);
+      cache_file_put32(&w, (uint32_t)RBUF_LEN(state->by[cat]));
+      for (i = 0; i != RBUF_LEN(state->by[cat]); i++)
+         if (!cache_file_put_str(&w, state->by[cat][i]->str))
+            goto end;
+   }
+
+   cache_file_put32(&w, (uint32_t)RBUF_LEN(state->entries));
+   for (e = state->entries; e != RBUF_END(state->entries); e++)
+   {
+      unsigned n = 0;
+      const struct playlist_entry *pl_first = NULL;
+
+      for (j = 0; j != RBUF_LEN(state->playlists); j++)
+      {
+         playlist_get_index(state->playlists[j], 0, &pl_first);
+         if (     (e->playlist_entry >= pl_first)
+               && (e->playlist_entry <  pl_first
+                  + playlist_size(state->playlists[j])))
+            break;
+      }
+      if (j == RBUF_LEN(state->playlists))
+         goto end;
+
+      cache_file_put_varint(&w, (uint32_t)j);
+      cache_file_put_varint(&w, (uint32_t)(e->playlist_entry - pl_first));
+
+      for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+         if (e->by[cat])
+            n++;
+      cache_file_put8(&w, n);
+      for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+      {
+         if (!e->by[cat])
+            continue;
+         cache_file_put8(&w, cat);
+         cache_file_put_varint(&w, e->by[cat]->idx);
+      }
+
+      for (n = 0; e->split && e->split[n]; n++);
+      cache_file_put_varint(&w, n);
+      for (n = 0; e->split && e->split[n]; n++)
+         ex_cache_put_split(&w, state, e->split[n]);
+
+#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
+      if (!cache_file_put_str(&w,
+               e->original_title ? e->original_title : ""))
+         goto end;
+#endif
+   }
+
+   if (!cache_file_write(&w, path))
+      RARCH_WARN("[Explore] Failed to write index cache \"%s\".\n", path);
+
+end:
+   cache_file_writer_free(&w);
+}
+
+/* Reads back the index written by explore_cache_write(), if every
+ * playlist and database it was built from is unchanged. */
+static explore_state_t *explore_cache_load(const char *path,
+      const char *directory_playlist, const char *directory_database)
+{
+   size_t i, _len;
+   uint32_t count, used = 0, seen = 0;
+   unsigned cat;
+   const char *s;
+   cache_file_reader_t r;
+   char tmp[PATH_MAX_LENGTH];
+   void *data                        = NULL;
+   int64_t len                       = 0;
+   struct explore_cache_file *lpls   = NULL;
+   struct explore_cache_file *rdbs   = NULL;
+   libretro_vfs_implementation_dir *dir;
+   explore_state_t *state            = NULL;
+
+   if (     !path_is_valid(path)
+         || !filestream_read_file(path, &data, &len)
+         || !data)
+      return NULL;
+
+   cache_file_reader_init(&r, data, (size_t)len);
+
+   if (     !(s = (const char*)cache_file_get(&r, 4))
+         || memcmp(s, EXPLORE_CACHE_MAGIC, 4))
+      goto error;
+   if (     cache_file_get32(&r) != EXPLORE_CACHE_VERSION
+         || cache_file_get8(&r)  != EXPLORE_CAT_COUNT
+         || cache_file_get8(&r)  != EXPLORE_CACHE_FLAGS)
+      goto stale;
+
+   /* Yes and no are values of the boolean categories */
+   s = cache_file_get_str(&r, &_len);
+   if (!ex_cache_str_equal(s, _len, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_YES)))
+      goto stale;
+   s = cache_file_get_str(&r, &_len);
+   if (!ex_cache_str_equal(s, _len, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO)))
+      goto stale;
+
+   lpls = ex_cache_get_files(&r);
+   rdbs = ex_cache_get_files(&r);
+   if (r.error)
+      goto error;
+
+   for (i = 0; i != RBUF_LEN(rdbs); i++)
+      if (explore_cache_file_changed(&rdbs[i], rdbs[i].path))
+         goto stale;
+
+   for (i = 0; i != RBUF_LEN(lpls); i++)
+      if (lpls[i].used)
+         used++;
+
+   for (dir = retro_vfs_opendir_impl(directory_playlist, false); dir;)
+   {
+      const struct explore_cache_file *lpl = NULL;
+      const char *fext                     = NULL;
+      const char *fname                    = NULL;
+
+      if (!retro_vfs_readdir_impl(dir))
+      {
+         retro_vfs_closedir_impl(dir);
+         break;
+      }
+
+      if ((fname = retro_vfs_dirent_get_name_impl(dir)))
+         fext = strrchr(fname, '.');
+      if (!fext || strcasecmp(fext, ".lpl"))
+         continue;
+
+      fill_pathname_join_special(tmp, directory_playlist, fname, sizeof(tmp));
+      lpl = explore_cache_file_find(lpls, fname);
+
+      if (lpl && !explore_cache_file_changed(lpl, tmp))
+      {
+         if (lpl->used)
+            seen++;
+         continue;
+      }
+
+      if (     (lpl && lpl->used)
+            || !explore_cache_playlist_unused(tmp, fname,
+               directory_database, rdbs))
+      {
+         retro_vfs_closedir_impl(dir);
+         goto stale;
+      }
+   }
+
+   /* A playlist that contributed entries is gone */
+   if (seen != used)
+      goto stale;
+
+   if (!(state = (explore_state_t*)calloc(1, sizeof(*state))))
+      goto error;
+   state->label_explore_item_str = MENU_ENUM_LABEL_EXPLORE_ITEM_STR;
+
+   for (i = 0; i != RBUF_LEN(lpls); i++)
+   {
+      playlist_t *playlist;
+      if (!lpls[i].used)
+         continue;
+      fill_pathname_join_special(tmp, directory_playlist,
+            lpls[i].path, sizeof(tmp));
+      if (!(playlist = explore_open_playlist(tmp)))
+         goto error;
+      RBUF_PUSH(state->playlists, playlist);
+   }
+   if (RBUF_LEN(state->playlists) != used)
+      goto error;
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+   {
+      state->has_unknown[cat] = (cache_file_get8(&r) != 0);
+      count                   = cache_file_get32(&r);
+      if (count > (size_t)(r.end - r.ptr) / 2)
+         goto error;
+      for (i = 0; i != count; i++)
+      {
+         explore_string_t *str;
+         if (!(s = cache_file_get_str(&r, &_len)))
+            goto error;
+         if (!(str = (explore_string_t*)ex_arena_alloc(&state->arena,
+                     sizeof(explore_string_t) + _len)))
+            goto error;
+         memcpy(str->str, s, _len);
+         str->str[_len] = '\0';
+         str->idx       = (uint32_t)i;
+         RBUF_PUSH(state->by[cat], str);
+      }
+      if (RBUF_LEN(state->by[cat]) != count)
+         goto error;
+   }
+
+   count = cache_file_get32(&r);
+   if (     count > (size_t)(r.end - r.ptr) / 4
+         || !RBUF_TRYFIT(state->entries, count))
+      goto error;
+   RBUF_RESIZE(state->entries, count);
+
+   for (i = 0; i != count && !r.error; i++)
+   {
+      unsigned k, n;
+      explore_entry_t *e = &state->entries[i];
+      uint32_t pl        = cache_file_get_varint(&r);
+      uint32_t idx       = cache_file_get_varint(&r);
+
+      if (     pl  >= RBUF_LEN(state->playlists)
+            || idx >= playlist_size(state->playlists[pl]))
+         goto error;
+      playlist_get_index(state->playlists[pl], idx, &e->playlist_entry);
+      /* Sorting and listing take the label for granted */
+      if (!e->playlist_entry->label || !*e->playlist_entry->label)
+         goto error;
+
+      for (k = 0; k < EXPLORE_CAT_COUNT; k++)
+         e->by[k] = NULL;
+      e->split    = NULL;
+
+      for (k = 0, n = cache_file_get8(&r); k < n; k++)
+      {
+         uint32_t value;
+         cat   = cache_file_get8(&r);
+         value = cache_file_get_varint(&r);
+         if (cat >= EXPLORE_CAT_COUNT || value >= RBUF_LEN(state->by[cat]))
+            goto error;
+         e->by[cat] = state->by[cat][value];
+      }
+
+      n = cache_file_get_varint(&r);
+      if (n > (size_t)(r.end - r.ptr) / 2)
+         goto error;
+      if (n)
+      {
+         if (!(e->split = (explore_string_t**)ex_arena_alloc(&state->arena,
+                     (n + 1) * sizeof(explore_string_t*))))
+            goto error;
+         for (k = 0; k < n; k++)
+         {
+            uint32_t value;
+            cat   = cache_file_get8(&r);
+            value = cache_file_get_varint(&r);
+            if (cat >= EXPLORE_CAT_COUNT || value >= RBUF_LEN(state->by[cat]))
+               goto error;
+            e->split[k] = state->by[cat][value];
+         }
+         e->split[n] = NULL;
+      }
+
+#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
+      e->original_title = NULL;
+      if ((s = cache_file_get_str(&r, &_len)) && _len)
+      {
+         if (!(e->original_title = (char*)ex_arena_alloc(&state->arena,
+                     _len + 1)))
+            goto error;
+         memcpy(e->original_title, s, _len);
+         e->original_title[_len] = '\0';
+      }
+#endif
+   }
+   if (r.error)
+      goto error;
+
+   RARCH_LOG("[Explore] Loaded index of %u entries from cache.\n",
+         (unsigned)count);
+   goto end;
+
+stale:
+   RARCH_LOG("[Explore] Index cache is out of date, rebuilding.\n");
+   goto fail;
+
+error:
+   RARCH_WARN("[Explore] Ignoring unreadable index cache \"%s\".\n", path);
+
+fail:
+   if (state)
+   {
+      menu_explore_free_state(state);
+      free(state);
+      state = NULL;
+   }
+
+end:
+   explore_cache_files_free(&lpls);
+   explore_cache_files_free(&rdbs);
+   free(data);
+   return state;
+}
+
 explore_state_t *menu_explore_build_list(const char *directory_playlist,
       const char *directory_database)
 {
    unsigned i;
    char tmp[PATH_MAX_LENGTH];
+   char cache_path[PATH_MAX_LENGTH];
    struct explore_source
    {
       const struct playlist_entry *source;
@@ -496,10 +1324,22 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
    explore_string_t **cat_maps[EXPLORE_CAT_COUNT] = {NULL};
    explore_string_t **split_buf                   = NULL;
    libretro_vfs_implementation_dir *dir           = NULL;
+   struct explore_cache_file *lpl_files           = NULL;
+   struct explore_cache_file *rdb_files           = NULL;
+   bool cache_ok                                  = true;
+   explore_state_t *state                         = NULL;
 
-   explore_state_t *state = (explore_state_t*)calloc(1, sizeof(*state));
+   fill_pathname_join_special(cache_path, directory_playlist,
+         FILE_PATH_EXPLORE_CACHE, sizeof(cache_path));
 
-   if (!state)
+   if ((state = explore_cache_load(cache_path,
+               directory_playlist, directory_database)))
+   {
+      explore_build_sets(state);
+      return state;
+   }
+
+   if (!(state = (explore_state_t*)calloc(1, sizeof(*state))))
       return NULL;
 
    state->label_explore_item_str = MENU_ENUM_LABEL_EXPLORE_ITEM_STR;
@@ -507,21 +1347,14 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
    /* Index all playlists */
    for (dir = retro_vfs_opendir_impl(directory_playlist, false); dir;)
    {
-      playlist_config_t playlist_config;
+      char lpl_path[PATH_MAX_LENGTH];
       size_t j, used_entries                    = 0;
       playlist_t *playlist                      = NULL;
+      struct explore_cache_file *lpl_file       = NULL;
       const char *fext                          = NULL;
       const char *fname                         = NULL;
       uint32_t fhash                            = 0;
 
-      playlist_config.path[0]                   = '\0';
-      playlist_config.base_content_directory[0] = '\0';
-      playlist_config.capacity                  = 0;
-      playlist_config.old_format                = false;
-      playlist_config.compress                  = false;
-      playlist_config.fuzzy_archive_match       = false;
-      playlist_config.autofix_paths             = false;
-
       if (!retro_vfs_readdir_impl(dir))
       {
          retro_vfs_closedir_impl(dir);
@@ -535,10 +1368,13 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
       if (!fext || strcasecmp(fext, ".lpl"))
          continue;
 
-      fill_pathname_join_special(playlist_config.path,
-            directory_playlist, fname, sizeof(playlist_config.path));
-      playlist_config.capacity          = COLLECTION_SIZE;
-      playlist                          = playlist_init(&playlist_config);
+      fill_pathname_join_special(lpl_path,
+            directory_playlist, fname, sizeof(lpl_path));
+      /* Recorded before reading, so that a change made meanwhile
+       * shows as one the next time */
+      if (!(lpl_file = explore_cache_file_add(&lpl_files, fname, lpl_path)))
+         cache_ok = false;
+      playlist                          = explore_open_playlist(lpl_path);
 
       fhash = ex_hash32_nocase_filtered(
             (unsigned char*)fname, fext - fname, '0', 255);
@@ -559,12 +1395,8 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
          if (!entry->label || !*entry->label)
             continue;
 
-         /* For auto scanned playlists the entry db_name matches the
-          * lpl file name and we can just use that */
-         if (entry->db_name && *entry->db_name
-               && strcasecmp(entry->db_name, fname))
+         if ((db_name = explore_db_name(entry, fname)) != fname)
          {
-            db_name = entry->db_name;
             db_ext  = strrchr(db_name, '.');
             if (!db_ext)
                db_ext = db_name + strlen(db_name);
@@ -577,7 +1409,7 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
          {
             size_t _len;
             struct explore_rdb newrdb;
-            char *ext_path          = NULL;
+            struct explore_cache_file *rdb_file = NULL;
 
             newrdb.handle           = libretrodb_new();
             newrdb.count            = 0;
@@ -590,20 +1422,9 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
             memcpy(newrdb.systemname, db_name, _len);
             newrdb.systemname[_len] = '\0';
 
-            fill_pathname_join_special(
-                  tmp, directory_database, db_name, sizeof(tmp));
-
-            /* Replace the extension - change 'lpl' to 'rdb' */
-            if ((    ext_path = path_get_extension_mutable(tmp))
-                  && ext_path[0] == '.'
-                  && ext_path[1] == 'l'
-                  && ext_path[2] == 'p'
-                  && ext_path[3] == 'l')
-            {
-               ext_path[1] = 'r';
-               ext_path[2] = 'd';
-               ext_path[3] = 'b';
-            }
+            explore_rdb_path(tmp, sizeof(tmp), directory_database, db_name);
+            if (!(rdb_file = explore_cache_file_add(&rdb_files, tmp, tmp)))
+               cache_ok = false;
 
             if (libretrodb_open(tmp, newrdb.handle, false) != 0)
             {
@@ -613,6 +1434,8 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
                continue;
             }
 
+            if (rdb_file)
+               rdb_file->used = true;
             RBUF_PUSH(rdbs, newrdb);
             rdb_num = (int)RBUF_LEN(rdbs);
             RHMAP_SET(rdb_indices, rdb_hash, rdb_num);
@@ -640,6 +1463,8 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
          used_entries++;
       }
 
+      if (lpl_file)
+         lpl_file->used = (used_entries != 0);
       if (used_entries)
          RBUF_PUSH(state->playlists, playlist);
       else
@@ -859,6 +1684,13 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
       qsort(state->entries,
          RBUF_LEN(state->entries),
          sizeof(*state->entries), explore_qsort_func_entries);
+
+   explore_build_sets(state);
+
+   if (cache_ok)
+      explore_cache_write(state, cache_path, lpl_files, rdb_files);
+   explore_cache_files_free(&lpl_files);
+   explore_cache_files_free(&rdb_files);
    return state;
 }
 
@@ -1589,17 +2421,12 @@ unsigned menu_displaylist_explore(file_list_t *list, settings_t *settings)
             && previous_type < EXPLORE_TYPE_FIRSTITEM))
    {
       size_t first_list_entry;
+      const uint32_t*    bits;
       unsigned           view_levels      = state->view_levels;
-      char*              view_search      = state->view_search;
-      uint8_t*           view_op          = state->view_op;
-      bool*              view_use_split   = state->view_use_split;
       unsigned*          view_cats        = state->view_cats;
-      explore_string_t** view_match       = state->view_match;
-      uint32_t*          view_idx_min     = state->view_idx_min;
-      uint32_t*          view_idx_max     = state->view_idx_max;
       explore_entry_t*   entries          = state->entries, *e, *eend;
       bool* map_filtered_category         = NULL;
-      bool has_search                     = !!*view_search;
+      bool has_search                     = !!*state->view_search;
       bool is_show_all                    = (!view_levels && !has_search);
       bool is_filtered_category           = (current_cat < EXPLORE_CAT_COUNT);
       bool filtered_category_have_unknown = false;
@@ -1656,47 +2483,15 @@ unsigned menu_displaylist_explore(file_list_t *list, settings_t *settings)
                explore_action_sublabel_spacer;
       }
 
+      bits             = explore_filter(state, view_levels);
       first_list_entry = list->size;
       for (e = entries, eend = RBUF_END(entries); e != eend; e++)
       {
-         for (i = 0; i != view_levels; i++)
-         {
-            explore_string_t* eby = e->by[view_cats[i]];
-            switch (view_op[i])
-            {
-               case EXPLORE_OP_EQUAL:
-                  if (view_match[i] == eby)
-                     continue;
-                  if (view_use_split[i] && e->split)
-                  {
-                     explore_string_t** split = e->split;
-                     do
-                     {
-                        if (*split == view_match[i])
-                           break;
-                     } while (*(++split));
-                     if (*split)
-                        continue;
-                  }
-                  goto SKIP_ENTRY;
-               case EXPLORE_OP_MIN:
-                  if (eby && eby->idx >= view_idx_min[i])
-                     continue;
-                  goto SKIP_ENTRY;
-               case EXPLORE_OP_MAX:
-                  if (eby && eby->idx <= view_idx_max[i])
-                     continue;
-                  goto SKIP_ENTRY;
-               case EXPLORE_OP_RANGE:
-                  if (eby && eby->idx >= view_idx_min[i]
-                          && eby->idx <= view_idx_max[i])
-                     continue;
-                  goto SKIP_ENTRY;
-            }
-         }
-
-         if (has_search && !compat_strcasestr(e->playlist_entry->label, view_search))
-            goto SKIP_ENTRY;
+         uint32_t n = (uint32_t)(e - entries);
+         if (bits
+               ? !(bits[n >> 5] & EX_SET_BIT(n))
+               : !explore_entry_matches(state, e, view_levels))
+            continue;
 
          if (is_filtered_category)
          {
@@ -1719,8 +2514,7 @@ unsigned menu_displaylist_explore(file_list_t *list, settings_t *settings)
 #endif
          else
             explore_menu_entry(list, state, e->playlist_entry->label,
-                  (unsigned)(EXPLORE_TYPE_FIRSTITEM + (e - entries)), explore_action_ok);
-SKIP_ENTRY:;
+                  (unsigned)(EXPLORE_TYPE_FIRSTITEM + n), explore_action_ok);
       }
 
       if (is_filtered_category)
@@ -1923,10 +2717,16 @@ void menu_explore_free_state(explore_state_t *state)
       playlist_free(state->playlists[i]);
    RBUF_FREE(state->playlists);
 
-   /* Invalidate in-flight async icon loads before freeing */
-   explore_icon_load_gen++;
-   explore_unload_icons(state);
-   RBUF_FREE(state->icons);
+   /* Invalidate in-flight async icon loads before freeing. Icons are
+    * textures, loaded and unloaded only on the main thread; a state
+    * that never loaded any, such as one the explore task discards,
+    * skips this and so may be freed from the task's thread */
+   if (state->icons)
+   {
+      explore_icon_load_gen++;
+      explore_unload_icons(state);
+      RBUF_FREE(state->icons);
+   }
 
    ex_arena_free(&state->arena);
 }
@@ -8915,6 +8915,10 @@ static void general_write_handler(rarch_setting_t *setting)
          else
             task_queue_unset_threaded();
          break;
+      case MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS:
+         /* Picked up by the next task_queue_check() */
+         task_queue_set_workers(*setting->value.target.unsigned_integer);
+         break;
 #ifndef HAVE_LAKKA
       case MENU_ENUM_LABEL_GAMEMODE_ENABLE:
          if (frontend_driver_has_gamemode())
@@ -9942,7 +9946,7 @@ static void runahead_change_handler(rarch_setting_t *setting)
 
    /* Toggle or update preemptive frames if needed */
    if (     preempt_enable != !!preempt
-         || (preempt && preempt->frames != run_ahead_frames))
+         || (preempt && preempt->max_frames != run_ahead_frames))
       command_event(CMD_EVENT_PREEMPT_UPDATE, NULL);
 
 #if (defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB))
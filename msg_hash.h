@@ -29416,6 +29416,10 @@ enum msg_hash_enums
    MSG_PLAYLIST_MANAGER_CLEANING_PLAYLIST,
    MSG_PLAYLIST_MANAGER_PLAYLIST_CLEANED,
 
+   MENU_LABEL(PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM),
+   MSG_PLAYLIST_MANAGER_CHEEVOS_HASHING,
+   MSG_PLAYLIST_MANAGER_CHEEVOS_HASHED,
+
    MENU_LABEL(PLAYLIST_MANAGER_REFRESH_PLAYLIST),
    MSG_PLAYLIST_MANAGER_REFRESH_MISSING_CONFIG,
    MSG_PLAYLIST_MANAGER_REFRESH_INVALID_CONTENT_DIR,
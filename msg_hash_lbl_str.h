@@ -466,6 +466,7 @@
 #define MENU_ENUM_LABEL_PLAYLIST_MANAGER_LEFT_THUMBNAIL_MODE_STR "playlist_manager_left_thumbnail_mode"
 #define MENU_ENUM_LABEL_PLAYLIST_MANAGER_SORT_MODE_STR "playlist_manager_sort_mode"
 #define MENU_ENUM_LABEL_PLAYLIST_MANAGER_CLEAN_PLAYLIST_STR "playlist_manager_clean_playlist"
+#define MENU_ENUM_LABEL_PLAYLIST_MANAGER_CHEEVOS_HASH_PREWARM_STR "playlist_manager_cheevos_hash_prewarm"
 #define MENU_ENUM_LABEL_PLAYLIST_MANAGER_REFRESH_PLAYLIST_STR "playlist_manager_refresh_playlist"
 #define MENU_ENUM_LABEL_PLAYLIST_SETTINGS_BEGIN_STR "playlist_settings_begin"
 #define MENU_ENUM_LABEL_RDB_ENTRY_STR "rdb_entry"
@@ -705,6 +706,7 @@
 #define MENU_ENUM_LABEL_VIDEO_SOFT_FILTER_STR "soft_filter"
 #define MENU_ENUM_LABEL_VIDEO_TAB_STR "video_tab"
 #define MENU_ENUM_LABEL_VIDEO_THREADED_STR "video_threaded"
+#define MENU_ENUM_LABEL_VIDEO_THREADED_MAILBOX_STR "video_threaded_mailbox"
 #define MENU_ENUM_LABEL_VIDEO_FORCE_RESOLUTION_STR "video_force_resolution"
 #define MENU_ENUM_LABEL_WIFI_DRIVER_STR "wifi_driver"
 #define MSG_BRINGING_UP_COMMAND_INTERFACE_ON_PORT_STR "bringing_up_command_interface_at_port"
@@ -996,6 +998,8 @@
 #define MENU_ENUM_LABEL_CHEEVOS_CHALLENGE_INDICATORS_STR "cheevos_challenge_indicators"
 #define MENU_ENUM_LABEL_CHEEVOS_RICHPRESENCE_ENABLE_STR "cheevos_richpresence_enable"
 #define MENU_ENUM_LABEL_CHEEVOS_START_ACTIVE_STR "cheevos_start_active"
+#define MENU_ENUM_LABEL_CHEEVOS_BACKGROUND_EVAL_STR "cheevos_background_eval"
+#define MENU_ENUM_LABEL_CHEEVOS_HASH_CACHE_STR "cheevos_hash_cache"
 #define MENU_ENUM_LABEL_CHEEVOS_TEST_UNOFFICIAL_STR "cheevos_test_unofficial"
 #define MENU_ENUM_LABEL_CHEEVOS_UNLOCK_SOUND_ENABLE_STR "cheevos_unlock_sound_enable"
 #define MENU_ENUM_LABEL_CHEEVOS_VERBOSE_ENABLE_STR "cheevos_verbose_enable"
@@ -1469,6 +1473,9 @@
 #define MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP_STR "rewind_buffer_size_step"
 #define MENU_ENUM_LABEL_REWIND_ENABLE_STR "rewind_enable"
 #define MENU_ENUM_LABEL_REWIND_GRANULARITY_STR "rewind_granularity"
+#define MENU_ENUM_LABEL_REWIND_THREADED_STR "rewind_threaded"
+#define MENU_ENUM_LABEL_REWIND_COMPRESSION_STR "rewind_compression"
+#define MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL_STR "rewind_keyframe_interval"
 #define MENU_ENUM_LABEL_REWIND_SETTINGS_STR "rewind_settings"
 #define MENU_ENUM_LABEL_RGUI_BROWSER_DIRECTORY_STR "rgui_browser_directory"
 #define MENU_ENUM_LABEL_RGUI_CONFIG_DIRECTORY_STR "rgui_config_directory"
@@ -1477,6 +1484,7 @@
 #define MENU_ENUM_LABEL_RGUI_SHOW_START_SCREEN_STR "rgui_show_start_screen"
 #define MENU_ENUM_LABEL_RUNTIME_LOG_DIRECTORY_STR "runtime_log_directory"
 #define MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS_STR "run_ahead_hide_warnings"
+#define MENU_ENUM_LABEL_RUN_AHEAD_AUTO_STR "run_ahead_auto"
 #define MENU_ENUM_LABEL_SAVESTATE_AUTOMATIC_INTERVAL_STR "savestate_automatic_interval"
 #define MENU_ENUM_LABEL_SAVESTATE_AUTO_INDEX_STR "savestate_auto_index"
 #define MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION_STR "savestate_file_compression"
@@ -1547,6 +1555,7 @@
 #define MENU_ENUM_LABEL_SWITCH_CPU_PROFILE_STR "switch_cpu_profile"
 #define MENU_ENUM_LABEL_SYSTEM_DIRECTORY_STR "system_directory"
 #define MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE_STR "threaded_data_runloop_enable"
+#define MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS_STR "threaded_data_runloop_workers"
 #define MENU_ENUM_LABEL_THUMBNAILS_DIRECTORY_STR "thumbnails_directory"
 #define MENU_ENUM_LABEL_TIMEDATE_DATE_SEPARATOR_STR "menu_timedate_date_separator"
 #define MENU_ENUM_LABEL_TIMEDATE_ENABLE_STR "menu_timedate_enable"
@@ -1665,6 +1674,7 @@
 #define MENU_ENUM_LABEL_VIDEO_WINDOW_SHOW_DECORATIONS_STR "video_window_show_decorations"
 #define MENU_ENUM_LABEL_VIDEO_WINDOW_WIDTH_STR "video_window_width"
 #define MENU_ENUM_LABEL_VRR_RUNLOOP_ENABLE_STR "vrr_runloop_enable"
+#define MENU_ENUM_LABEL_FRAME_LIMIT_PRECISE_STR "frame_limit_precise"
 #define MENU_ENUM_LABEL_WIFI_DISCONNECT_STR "disconnect_wifi"
 #define MENU_ENUM_LABEL_WIFI_ENABLED_STR "wifi_enabled"
 #define MENU_ENUM_LABEL_WIFI_NETWORK_SCAN_STR "wifi_network_scan"
@@ -43,6 +43,9 @@
 #include <encodings/base64.h>
 #include <features/features_cpu.h>
 #include <lrc_hash.h>
+#ifdef HAVE_RZSTD
+#include <encodings/rzstd.h>
+#endif
 
 #ifdef HAVE_IFINFO
 #include <net/net_ifinfo.h>
@@ -57,6 +60,7 @@
 #include "../../file_path_special.h"
 #include "../../paths.h"
 #include "../../retroarch.h"
+#include "../../state_manager.h"
 #include "../../version.h"
 #include "../../verbosity.h"
 
@@ -1134,9 +1138,167 @@ static int select_compression(netplay_t *netplay, uint32_t compression)
    if (!ctrans->compression_stream || !ctrans->decompression_stream)
       return -1;
 
+   /* Delta savestates need no stream of their own. */
+   if (compression & NETPLAY_COMPRESSION_DELTA)
+      ret |= NETPLAY_COMPRESSION_DELTA;
+
    return ret;
 }
 
+/**
+ * netplay_delta_reserve
+ *
+ * Grows one of the delta scratch buffers to hold at least len bytes.
+ */
+static bool netplay_delta_reserve(uint8_t **buf, size_t *size, size_t len)
+{
+   uint8_t *tmp;
+
+   if (*buf && *size >= len)
+      return true;
+
+   if (!(tmp = (uint8_t*)realloc(*buf, len)))
+      return false;
+
+   *buf  = tmp;
+   *size = len;
+   return true;
+}
+
+/**
+ * netplay_delta_base_reserve
+ *
+ * Sizes a connection's delta base for a state of the given size, with the
+ * padding the patch scanners need.
+ */
+static bool netplay_delta_base_reserve(struct netplay_connection *connection,
+      size_t size)
+{
+   uint8_t *tmp;
+
+   if (connection->delta_base && connection->delta_base_size == size)
+      return true;
+
+   if (!(tmp = (uint8_t*)realloc(connection->delta_base,
+         size + STATE_MANAGER_PATCH_PAD)))
+      return false;
+
+   connection->delta_base      = tmp;
+   connection->delta_base_size = size;
+   return true;
+}
+
+/**
+ * netplay_delta_base_free
+ *
+ * Forgets a connection's delta base. The next state goes out whole.
+ */
+static void netplay_delta_base_free(struct netplay_connection *connection)
+{
+   free(connection->delta_base);
+   connection->delta_base       = NULL;
+   connection->delta_base_size  = 0;
+   connection->delta_base_frame = 0;
+}
+
+/**
+ * netplay_encode_delta_savestate
+ *
+ * Compresses the state staged in netplay->delta_state into zbuffer for one
+ * peer: as a patch against the last state that peer took, if there is one
+ * of the same size, otherwise whole. base_size receives the size of the
+ * base the patch applies to, 0 for a whole state.
+ *
+ * Returns: bytes written to zbuffer, 0 on failure.
+ */
+static size_t netplay_encode_delta_savestate(netplay_t *netplay,
+      struct netplay_connection *connection, size_t size,
+      uint32_t *base_size)
+{
+#ifdef HAVE_RZSTD
+   size_t wn = 0;
+
+   if (connection->delta_base && connection->delta_base_size == size)
+   {
+      size_t patch_len = state_manager_patch_create(connection->delta_base,
+            netplay->delta_state, size, netplay->delta_patch);
+
+      if (rzstd_encode(netplay->zbuffer, netplay->zbuffer_size,
+               netplay->delta_patch, patch_len, 3, &wn) == RZSTD_PROCESS_END)
+      {
+         *base_size = (uint32_t)size;
+         return wn;
+      }
+   }
+
+   /* No common base, or the patch did not fit; send the state whole. */
+   if (rzstd_encode(netplay->zbuffer, netplay->zbuffer_size,
+            netplay->delta_state, size, 3, &wn) == RZSTD_PROCESS_END)
+   {
+      *base_size = 0;
+      return wn;
+   }
+#endif
+
+   return 0;
+}
+
+/**
+ * netplay_decode_delta_savestate
+ *
+ * Reverses netplay_encode_delta_savestate for the payload in zbuffer,
+ * leaving the state in both the connection's delta base and state.
+ * A patch is only accepted against exactly the state we last took from
+ * this peer, identified by frame and size.
+ *
+ * Returns: true if state now holds the peer's savestate.
+ */
+static bool netplay_decode_delta_savestate(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t frame,
+      uint32_t base_frame, uint32_t base_size,
+      uint32_t state_size, uint32_t state_size_raw, void *state)
+{
+#ifdef HAVE_RZSTD
+   size_t wn = 0;
+
+   if (base_size)
+   {
+      if (     !connection->delta_base
+            || base_size  != state_size
+            || base_size  != connection->delta_base_size
+            || base_frame != connection->delta_base_frame)
+         return false;
+
+      if (!netplay_delta_reserve(&netplay->delta_patch,
+               &netplay->delta_patch_size,
+               state_manager_patch_maxsize(state_size)))
+         return false;
+
+      if (     rzstd_decode(netplay->delta_patch, netplay->delta_patch_size,
+                  netplay->zbuffer, state_size_raw, &wn) != RZSTD_PROCESS_END
+            || !state_manager_patch_apply(netplay->delta_patch, wn,
+                  connection->delta_base, state_size))
+         return false;
+   }
+   else
+   {
+      if (!netplay_delta_base_reserve(connection, state_size))
+         return false;
+
+      if (     rzstd_decode(connection->delta_base, state_size,
+                  netplay->zbuffer, state_size_raw, &wn) != RZSTD_PROCESS_END
+            || wn != state_size)
+         return false;
+   }
+
+   connection->delta_base_frame = frame;
+   memcpy(state, connection->delta_base, state_size);
+   return true;
+#else
+   return false;
+#endif
+}
+
 /**
  * netplay_handshake_init
  *
@@ -4431,6 +4593,7 @@ static void netplay_hangup(netplay_t *netplay,
    connection->flags &= ~NETPLAY_CONN_FLAG_ACTIVE;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
    netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
+   netplay_delta_base_free(connection);
 
    if (!netplay->is_server)
    {
@@ -6204,17 +6367,25 @@ static bool netplay_get_cmd(netplay_t *netplay,
             size_t   load_ptr;
             uint32_t load_frame_count;
             uint32_t rd, wn;
+            /* Base frame and base size, NETPLAY_COMPRESSION_DELTA only */
+            uint32_t delta_header[2];
+            size_t   header_size = sizeof(frame) + sizeof(state_size);
+            bool     delta       = (connection->compression_supported
+                  & NETPLAY_COMPRESSION_DELTA) != 0;
             enum trans_stream_error zerr = TRANS_STREAM_ERROR_NONE;
             struct compression_transcoder *ctrans = NULL;
             NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
 
+            if (delta)
+               header_size += sizeof(delta_header);
+
             if (netplay->is_server)
             {
                RARCH_ERR("[Netplay] NETPLAY_CMD_LOAD_SAVESTATE from client.\n");
                return netplay_cmd_nak(netplay, connection);
             }
 
-            if (cmd_size < sizeof(frame) + sizeof(state_size))
+            if (cmd_size < header_size)
             {
                RARCH_ERR("[Netplay] Received invalid payload size for NETPLAY_CMD_LOAD_SAVESTATE.\n");
                return netplay_cmd_nak(netplay, connection);
@@ -6276,7 +6447,12 @@ static bool netplay_get_cmd(netplay_t *netplay,
             RECV(&state_size, sizeof(state_size))
                return false;
             state_size     = ntohl(state_size);
-            state_size_raw = cmd_size - (sizeof(frame) + sizeof(state_size));
+            if (delta)
+            {
+               RECV(delta_header, sizeof(delta_header))
+                  return false;
+            }
+            state_size_raw = cmd_size - header_size;
 
             if (state_size_raw > netplay->zbuffer_size)
             {
@@ -6287,16 +6463,6 @@ static bool netplay_get_cmd(netplay_t *netplay,
             RECV(netplay->zbuffer, state_size_raw)
                return false;
 
-            switch (connection->compression_supported)
-            {
-               case NETPLAY_COMPRESSION_ZLIB:
-                  ctrans = &netplay->compress_zlib;
-                  break;
-               default:
-                  ctrans = &netplay->compress_nil;
-                  break;
-            }
-
             if (state_size > netplay->state_size)
             {
                /* other client state size is larger than ours, grow ours */
@@ -6319,26 +6485,50 @@ static bool netplay_get_cmd(netplay_t *netplay,
                }
             }
 
-            ctrans->decompression_backend->set_in(
-               ctrans->decompression_stream,
-               netplay->zbuffer, state_size_raw);
-            ctrans->decompression_backend->set_out(
-               ctrans->decompression_stream,
-               (uint8_t*)netplay->buffer[load_ptr].state, state_size);
-            /* trans() returns true for a finalized stream and also for
-             * "input exhausted, codec still mid-stream" (reported as
-             * TRANS_STREAM_ERROR_AGAIN), so neither the return value nor
-             * a nonzero wn means the state decompressed.  A truncated or
-             * malformed payload from a peer would otherwise be loaded as
-             * a partially-filled state buffer. */
-            if (!ctrans->decompression_backend->trans(
-                     ctrans->decompression_stream,
-                     true, &rd, &wn, &zerr)
-                  || zerr != TRANS_STREAM_ERROR_NONE
-                  || wn != state_size)
+            if (delta)
             {
-               RARCH_ERR("[Netplay] Failed to decompress peer save state.\n");
-               return netplay_cmd_nak(netplay, connection);
+               if (!netplay_decode_delta_savestate(netplay, connection,
+                        frame, ntohl(delta_header[0]),
+                        ntohl(delta_header[1]), state_size, state_size_raw,
+                        netplay->buffer[load_ptr].state))
+               {
+                  RARCH_ERR("[Netplay] Failed to decompress peer save state.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+            }
+            else
+            {
+               switch (connection->compression_supported)
+               {
+                  case NETPLAY_COMPRESSION_ZLIB:
+                     ctrans = &netplay->compress_zlib;
+                     break;
+                  default:
+                     ctrans = &netplay->compress_nil;
+                     break;
+               }
+
+               ctrans->decompression_backend->set_in(
+                  ctrans->decompression_stream,
+                  netplay->zbuffer, state_size_raw);
+               ctrans->decompression_backend->set_out(
+                  ctrans->decompression_stream,
+                  (uint8_t*)netplay->buffer[load_ptr].state, state_size);
+               /* trans() returns true for a finalized stream and also for
+                * "input exhausted, codec still mid-stream" (reported as
+                * TRANS_STREAM_ERROR_AGAIN), so neither the return value nor
+                * a nonzero wn means the state decompressed.  A truncated or
+                * malformed payload from a peer would otherwise be loaded as
+                * a partially-filled state buffer. */
+               if (!ctrans->decompression_backend->trans(
+                        ctrans->decompression_stream,
+                        true, &rd, &wn, &zerr)
+                     || zerr != TRANS_STREAM_ERROR_NONE
+                     || wn != state_size)
+               {
+                  RARCH_ERR("[Netplay] Failed to decompress peer save state.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
             }
 
             if (memcmp(netplay->buffer[load_ptr].state, "NETPLAY", 7) != 0)
@@ -7495,6 +7685,7 @@ static void netplay_free(netplay_t *netplay)
          netplay_deinit_socket_buffer(&connection->send_packet_buffer);
          netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
       }
+      netplay_delta_base_free(connection);
    }
 
    free(netplay->connections);
@@ -7509,6 +7700,8 @@ static void netplay_free(netplay_t *netplay)
    }
 
    free(netplay->zbuffer);
+   free(netplay->delta_state);
+   free(netplay->delta_patch);
 
    if (netplay->compress_nil.compression_stream)
       netplay->compress_nil.compression_backend->stream_free(
@@ -7749,6 +7942,89 @@ static void netplay_send_savestate(netplay_t *netplay,
    }
 }
 
+/**
+ * netplay_send_savestate_delta
+ * @netplay              : pointer to netplay object
+ * @serial_info          : the savestate being loaded
+ *
+ * Send a loaded savestate to those connected peers that negotiated
+ * NETPLAY_COMPRESSION_DELTA, each as a patch against the last state it took
+ * from us. Only builds at protocol 7 advertise the capability, so unlike
+ * netplay_send_savestate there is no legacy variant to send.
+ */
+static void netplay_send_savestate_delta(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info)
+{
+   uint32_t header[6];
+   size_t i;
+   size_t size       = serial_info->size;
+   bool staged       = false;
+   NETPLAY_ASSERT_MODUS(NETPLAY_MODUS_INPUT_FRAME_SYNC);
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      size_t wn;
+      uint32_t base_size;
+      struct netplay_connection *connection = &netplay->connections[i];
+
+      if (     (!(connection->flags & NETPLAY_CONN_FLAG_ACTIVE))
+            ||  (connection->mode < NETPLAY_CONNECTION_CONNECTED)
+            || !(connection->compression_supported
+               & NETPLAY_COMPRESSION_DELTA))
+         continue;
+
+      /* Stage a padded copy once for all peers. */
+      if (!staged)
+      {
+         if (     !netplay_delta_reserve(&netplay->delta_state,
+                     &netplay->delta_state_size,
+                     size + STATE_MANAGER_PATCH_PAD)
+               || !netplay_delta_reserve(&netplay->delta_patch,
+                     &netplay->delta_patch_size,
+                     state_manager_patch_maxsize(size)))
+         {
+            netplay_hangup(netplay, connection);
+            continue;
+         }
+         memcpy(netplay->delta_state, serial_info->data_const, size);
+         staged = true;
+      }
+
+      if (!(wn = netplay_encode_delta_savestate(netplay, connection,
+                  size, &base_size)))
+      {
+         netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
+      header[1] = htonl((uint32_t)wn + 4*sizeof(uint32_t));
+      header[2] = htonl(netplay->run_frame_count);
+      header[3] = htonl((uint32_t)size);
+      header[4] = htonl(connection->delta_base_frame);
+      header[5] = htonl(base_size);
+
+      if (  !netplay_send(&connection->send_packet_buffer,
+              connection->fd, header, sizeof(header))
+         || !netplay_send(&connection->send_packet_buffer,
+              connection->fd, netplay->zbuffer, wn))
+      {
+         netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      /* The socket is ordered and a peer that cannot load the state hangs
+       * up, so whatever we send here is what the peer holds next. */
+      if (netplay_delta_base_reserve(connection, size))
+      {
+         memcpy(connection->delta_base, netplay->delta_state, size);
+         connection->delta_base_frame = netplay->run_frame_count;
+      }
+      else
+         netplay_delta_base_free(connection);
+   }
+}
+
 /**
  * netplay_frontend_paused
  * @netplay              : pointer to netplay object
@@ -8066,6 +8342,7 @@ void netplay_load_savestate(netplay_t *netplay,
       if (netplay->compress_zlib.compression_backend)
          netplay_send_savestate(netplay, serial_info, NETPLAY_COMPRESSION_ZLIB,
             &netplay->compress_zlib, false);
+      netplay_send_savestate_delta(netplay, serial_info);
    }
 }
 
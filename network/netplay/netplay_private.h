@@ -73,12 +73,23 @@
 #define NETPLAY_QUIRK_PLATFORM_DEPENDENT (1 << 2)
 
 /* Compression protocols supported */
-#define NETPLAY_COMPRESSION_ZLIB (1<<0)
+#define NETPLAY_COMPRESSION_ZLIB  (1<<0)
+/* Savestates are sent as a block diff against the last state both peers
+ * hold, zstd-compressed. Negotiated alongside the above, and takes
+ * precedence over it for savestate loads. */
+#define NETPLAY_COMPRESSION_DELTA (1<<1)
 #if HAVE_ZLIB
-#define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_ZLIB
+#define NETPLAY_COMPRESSION_ZLIB_SUPPORTED NETPLAY_COMPRESSION_ZLIB
 #else
-#define NETPLAY_COMPRESSION_SUPPORTED 0
+#define NETPLAY_COMPRESSION_ZLIB_SUPPORTED 0
 #endif
+#ifdef HAVE_RZSTD
+#define NETPLAY_COMPRESSION_DELTA_SUPPORTED NETPLAY_COMPRESSION_DELTA
+#else
+#define NETPLAY_COMPRESSION_DELTA_SUPPORTED 0
+#endif
+#define NETPLAY_COMPRESSION_SUPPORTED \
+   (NETPLAY_COMPRESSION_ZLIB_SUPPORTED | NETPLAY_COMPRESSION_DELTA_SUPPORTED)
 
 /* The keys supported by netplay */
 enum netplay_keys
@@ -381,6 +392,13 @@ struct netplay_connection
    struct socket_buffer send_packet_buffer;
    struct socket_buffer recv_packet_buffer;
 
+   /* Last savestate exchanged with this peer, the base for
+    * NETPLAY_COMPRESSION_DELTA. Carries STATE_MANAGER_PATCH_PAD bytes of
+    * scratch past delta_base_size. */
+   uint8_t *delta_base;
+   size_t delta_base_size;
+   uint32_t delta_base_frame;
+
    /* What compression does this peer support? */
    uint32_t compression_supported;
 
@@ -522,6 +540,12 @@ struct netplay
 
    /* A buffer into which to compress frames for transfer */
    uint8_t *zbuffer;
+   /* Scratch for NETPLAY_COMPRESSION_DELTA: the outgoing state with
+    * patch padding, and the uncompressed patch */
+   uint8_t *delta_state;
+   uint8_t *delta_patch;
+   size_t delta_state_size;
+   size_t delta_patch_size;
 
    size_t connections_size;
    size_t buffer_size;
@@ -24,6 +24,8 @@
 #include <libretro.h>
 #include <features/features_cpu.h>
 
+#include "performance_trace.h"
+
 #ifndef MAX_COUNTERS
 #define MAX_COUNTERS 64
 #endif
@@ -33,16 +35,20 @@
    if (!perf.registered) \
       rarch_perf_register(&perf)
 
+/* Frontend counter names are string literals, so they go to the
+ * tracer as they are. */
 #define performance_counter_start_internal(is_perfcnt_enable, perf) \
    if ((is_perfcnt_enable)) \
    { \
       perf.call_cnt++; \
       perf.start = cpu_features_get_perf_counter(); \
-   }
+   } \
+   PERF_TRACE_BEGIN(perf.ident)
 
 #define performance_counter_stop_internal(is_perfcnt_enable, perf) \
    if ((is_perfcnt_enable)) \
-      perf.total += cpu_features_get_perf_counter() - perf.start
+      perf.total += cpu_features_get_perf_counter() - perf.start; \
+   PERF_TRACE_END(perf.ident)
 
 /**
  * performance_counter_start:
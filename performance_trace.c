@@ -0,0 +1,316 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_atomic.h>
+#include <compat/strl.h>
+#include <string/stdstring.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "performance_trace.h"
+
+#define PERF_TRACE_RING_MASK (PERF_TRACE_RING_SIZE - 1)
+
+/* Events this close to the overwrite point are dropped on export.
+ * The owner publishes its head after each store, but on weakly
+ * ordered CPUs the next slot can become visible before that, so
+ * a few events of slack keep a half-written one out of the file. */
+#define PERF_TRACE_SLACK 16
+
+#define PERF_TRACE_MAX_NAMES 256
+
+typedef struct perf_trace_evt
+{
+   const char *name;
+   int64_t ts;
+   char ph;
+} perf_trace_evt_t;
+
+typedef struct perf_trace_ring
+{
+   retro_atomic_size_t head; /* published count, read by the exporter */
+   size_t pos;               /* owner's own count */
+   uintptr_t owner;
+   perf_trace_evt_t ev[PERF_TRACE_RING_SIZE];
+} perf_trace_ring_t;
+
+typedef struct perf_trace_name
+{
+   const char *key;
+   char *copy;
+} perf_trace_name_t;
+
+bool perf_trace_enabled                                   = false;
+
+static int64_t perf_trace_origin                          = 0;
+static perf_trace_ring_t *perf_trace_rings[PERF_TRACE_MAX_THREADS];
+static retro_atomic_int_t perf_trace_ring_count;
+static perf_trace_name_t perf_trace_names[PERF_TRACE_MAX_NAMES];
+static retro_atomic_int_t perf_trace_name_count;
+
+#ifdef HAVE_THREADS
+static slock_t *perf_trace_lock                           = NULL;
+#define PERF_TRACE_LOCK()   if (perf_trace_lock) slock_lock(perf_trace_lock)
+#define PERF_TRACE_UNLOCK() if (perf_trace_lock) slock_unlock(perf_trace_lock)
+#define PERF_TRACE_THREAD() sthread_get_current_thread_id()
+#else
+#define PERF_TRACE_LOCK()
+#define PERF_TRACE_UNLOCK()
+#define PERF_TRACE_THREAD() 0
+#endif
+
+/* Finds the calling thread's ring, creating it the first time the
+ * thread records an event. Rings are only ever appended, so the
+ * lookup needs no lock. Threads arriving after every ring is taken
+ * get NULL and their events are dropped. */
+static perf_trace_ring_t *perf_trace_ring_get(void)
+{
+   int i;
+   perf_trace_ring_t *ring = NULL;
+   uintptr_t self          = PERF_TRACE_THREAD();
+   int count               = retro_atomic_load_acquire_int(
+         &perf_trace_ring_count);
+
+   for (i = 0; i < count; i++)
+      if (perf_trace_rings[i]->owner == self)
+         return perf_trace_rings[i];
+   if (count == PERF_TRACE_MAX_THREADS)
+      return NULL;
+
+   PERF_TRACE_LOCK();
+   count = retro_atomic_load_acquire_int(&perf_trace_ring_count);
+   if (     count < PERF_TRACE_MAX_THREADS
+         && (ring = (perf_trace_ring_t*)malloc(sizeof(*ring))))
+   {
+      ring->pos   = 0;
+      ring->owner = self;
+      retro_atomic_size_init(&ring->head, 0);
+      perf_trace_rings[count] = ring;
+      retro_atomic_store_release_int(&perf_trace_ring_count, count + 1);
+   }
+   PERF_TRACE_UNLOCK();
+   return ring;
+}
+
+void perf_trace_event(const char *name, char ph)
+{
+   perf_trace_evt_t *ev;
+   perf_trace_ring_t *ring = perf_trace_ring_get();
+
+   if (!ring)
+      return;
+
+   ev       = &ring->ev[ring->pos & PERF_TRACE_RING_MASK];
+   ev->name = name;
+   ev->ts   = cpu_features_get_time_usec();
+   ev->ph   = ph;
+   retro_atomic_store_release_size(&ring->head, ++ring->pos);
+}
+
+bool perf_trace_start(void)
+{
+#ifdef HAVE_THREADS
+   if (!perf_trace_lock && !(perf_trace_lock = slock_new()))
+      return false;
+#endif
+   /* Rings are not cleared; whatever predates the origin is skipped
+    * on export instead, since other threads may still be writing. */
+   perf_trace_origin  = cpu_features_get_time_usec();
+
+   /* Claims the first ring for the calling thread, so that tid 0 in
+    * the trace is the main loop. */
+   if (!perf_trace_ring_get())
+      return false;
+
+   perf_trace_enabled = true;
+   return true;
+}
+
+void perf_trace_stop(void)
+{
+   perf_trace_enabled = false;
+}
+
+const char *perf_trace_intern(const char *name)
+{
+   int i;
+   int count = retro_atomic_load_acquire_int(&perf_trace_name_count);
+
+   /* Cores hand out perf counter names from their own data, so the
+    * pointer alone is not enough: a core loaded later may reuse the
+    * address for another string. */
+   for (i = 0; i < count; i++)
+      if (     perf_trace_names[i].key == name
+            && string_is_equal(perf_trace_names[i].copy, name))
+         return perf_trace_names[i].copy;
+
+   PERF_TRACE_LOCK();
+   count = retro_atomic_load_acquire_int(&perf_trace_name_count);
+   for (i = 0; i < count; i++)
+      if (string_is_equal(perf_trace_names[i].copy, name))
+         break;
+   if (i == count)
+   {
+      char *copy;
+      if (count == PERF_TRACE_MAX_NAMES || !(copy = strdup(name)))
+      {
+         PERF_TRACE_UNLOCK();
+         return "(unnamed)";
+      }
+      perf_trace_names[i].key  = name;
+      perf_trace_names[i].copy = copy;
+      retro_atomic_store_release_int(&perf_trace_name_count, count + 1);
+   }
+   else
+      perf_trace_names[i].key = name;
+   PERF_TRACE_UNLOCK();
+   return perf_trace_names[i].copy;
+}
+
+static size_t perf_trace_escape(char *s, size_t len, const char *name)
+{
+   size_t _len = 0;
+   for (; *name && _len + 7 < len; name++)
+   {
+      unsigned char c = (unsigned char)*name;
+      if (c == '"' || c == '\\')
+      {
+         s[_len++] = '\\';
+         s[_len++] = (char)c;
+      }
+      else if (c < 0x20)
+         _len += snprintf(s + _len, len - _len, "\\u%04x", c);
+      else
+         s[_len++] = (char)c;
+   }
+   s[_len] = '\0';
+   return _len;
+}
+
+bool perf_trace_write(const char *path)
+{
+   int r, count;
+   char line[512];
+   char name[256];
+   bool first             = true;
+   bool ret               = true;
+   perf_trace_evt_t *copy = NULL;
+   RFILE *file            = NULL;
+
+   count = retro_atomic_load_acquire_int(&perf_trace_ring_count);
+
+   if (!(copy = (perf_trace_evt_t*)malloc(
+               PERF_TRACE_RING_SIZE * sizeof(*copy))))
+      return false;
+   if (!(file = filestream_open(path, RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+   {
+      free(copy);
+      return false;
+   }
+
+   filestream_printf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+   for (r = 0; r < count; r++)
+   {
+      size_t i, lo, h1, h2;
+      perf_trace_ring_t *ring = perf_trace_rings[r];
+
+      /* Copy first, then look at how far the owner got in the
+       * meantime; anything it may have overwritten is dropped. */
+      h1 = retro_atomic_load_acquire_size(&ring->head);
+      lo = (h1 > PERF_TRACE_RING_SIZE) ? h1 - PERF_TRACE_RING_SIZE : 0;
+      for (i = lo; i < h1; i++)
+         copy[i & PERF_TRACE_RING_MASK] = ring->ev[i & PERF_TRACE_RING_MASK];
+#ifdef RETRO_ATOMIC_HAS_CAS
+      retro_atomic_thread_fence_acquire();
+#endif
+      h2 = retro_atomic_load_acquire_size(&ring->head);
+      if (h2 + PERF_TRACE_SLACK > lo + PERF_TRACE_RING_SIZE)
+         lo = h2 + PERF_TRACE_SLACK - PERF_TRACE_RING_SIZE;
+
+      if (r == 0)
+         strlcpy(name, "RetroArch", sizeof(name));
+      else
+         snprintf(name, sizeof(name), "Thread %d", r);
+      snprintf(line, sizeof(line),
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", r, name);
+      filestream_printf(file, "%s", line);
+      first = false;
+
+      for (i = lo; i < h1; i++)
+      {
+         const perf_trace_evt_t *ev = &copy[i & PERF_TRACE_RING_MASK];
+         if (ev->ts < perf_trace_origin)
+            continue;
+         perf_trace_escape(name, sizeof(name), ev->name);
+         snprintf(line, sizeof(line),
+               ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,"
+               "\"ts\":%lld}",
+               name, ev->ph, r, (long long)(ev->ts - perf_trace_origin));
+         if (filestream_printf(file, "%s", line) < 0)
+            ret = false;
+      }
+   }
+
+   filestream_printf(file, "\n]}\n");
+   if (filestream_close(file) != 0)
+      ret = false;
+   free(copy);
+   return ret;
+}
+
+void perf_trace_deinit(void)
+{
+   int i;
+   int count;
+
+   perf_trace_enabled = false;
+
+   count = retro_atomic_load_acquire_int(&perf_trace_ring_count);
+   for (i = 0; i < count; i++)
+   {
+      free(perf_trace_rings[i]);
+      perf_trace_rings[i] = NULL;
+   }
+   retro_atomic_store_release_int(&perf_trace_ring_count, 0);
+
+   count = retro_atomic_load_acquire_int(&perf_trace_name_count);
+   for (i = 0; i < count; i++)
+   {
+      free(perf_trace_names[i].copy);
+      perf_trace_names[i].copy = NULL;
+      perf_trace_names[i].key  = NULL;
+   }
+   retro_atomic_store_release_int(&perf_trace_name_count, 0);
+
+#ifdef HAVE_THREADS
+   if (perf_trace_lock)
+   {
+      slock_free(perf_trace_lock);
+      perf_trace_lock = NULL;
+   }
+#endif
+}
@@ -0,0 +1,122 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PERFORMANCE_TRACE_H
+#define _PERFORMANCE_TRACE_H
+
+#include <stdint.h>
+#include <boolean.h>
+
+#include <retro_common_api.h>
+
+/* Frame tracing.
+ *
+ * Where the perf counters only keep a running total per counter, the
+ * tracer records every begin/end pair with a timestamp, so a single
+ * slow frame can be picked out afterwards.  Each thread that emits
+ * events gets its own ring of PERF_TRACE_RING_SIZE events which only
+ * that thread writes to; when a ring wraps the oldest events are
+ * overwritten.  Recording an event is a flag test, a clock read and a
+ * store, with no locks, so tracing can stay enabled in release builds.
+ *
+ * perf_trace_write() exports what the rings currently hold in the
+ * Chrome trace event format, which chrome://tracing and Perfetto
+ * both open.  It may run while other threads keep recording.
+ *
+ * Event names are stored as pointers and must outlive the trace;
+ * string literals are fine, anything else goes through
+ * perf_trace_intern() first. */
+
+#ifndef PERF_TRACE_RING_SIZE
+#define PERF_TRACE_RING_SIZE 16384 /* must be a power of two */
+#endif
+
+#ifndef PERF_TRACE_MAX_THREADS
+#define PERF_TRACE_MAX_THREADS 16
+#endif
+
+#define PERF_TRACE_BEGIN(name) \
+   if (perf_trace_enabled) \
+      perf_trace_event((name), 'B')
+
+#define PERF_TRACE_END(name) \
+   if (perf_trace_enabled) \
+      perf_trace_event((name), 'E')
+
+RETRO_BEGIN_DECLS
+
+extern bool perf_trace_enabled;
+
+/**
+ * perf_trace_start:
+ *
+ * Starts recording. The rings are not cleared, since other threads
+ * may still be writing to them; events from before this call are left
+ * out of the export instead.
+ *
+ * Returns: true on success, false if the rings could not be allocated.
+ **/
+bool perf_trace_start(void);
+
+/**
+ * perf_trace_stop:
+ *
+ * Stops recording. The events recorded so far are exported until the
+ * next perf_trace_start() or perf_trace_deinit().
+ **/
+void perf_trace_stop(void);
+
+/**
+ * perf_trace_event:
+ * @name               : event name, see perf_trace_intern()
+ * @ph                 : 'B' for begin, 'E' for end
+ *
+ * Records an event on the calling thread's ring. Use the
+ * PERF_TRACE_BEGIN/PERF_TRACE_END macros rather than calling this
+ * directly, so that a disabled tracer costs a single branch.
+ **/
+void perf_trace_event(const char *name, char ph);
+
+/**
+ * perf_trace_intern:
+ * @name               : name owned by someone else, e.g. a core
+ *
+ * Returns: a copy of @name owned by the tracer, valid until
+ * perf_trace_deinit(). Looking up a name seen before takes no lock.
+ **/
+const char *perf_trace_intern(const char *name);
+
+/**
+ * perf_trace_write:
+ * @path               : destination file
+ *
+ * Writes the recorded events as Chrome trace JSON.
+ *
+ * Returns: true on success, otherwise false.
+ **/
+bool perf_trace_write(const char *path);
+
+/**
+ * perf_trace_deinit:
+ *
+ * Stops recording and frees the rings and interned names. Must not
+ * race with threads still recording.
+ **/
+void perf_trace_deinit(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -66,6 +66,38 @@ typedef struct
    int db_usage;
 } playlist_manual_scan_record_t;
 
+/* Strings of the entries read from a JSON playlist.
+ *
+ * They are copied into a few large blocks rather than allocated one
+ * by one, and the values that repeat across a collection - core path,
+ * core name, database name, subsystem - are stored once and shared
+ * by every entry that has them.  Strings in a block are never freed
+ * individually: playlist_string_free() leaves them alone, and the
+ * blocks go with the playlist (or with its last entry, on
+ * playlist_clear()).  Anything assigned to an entry later is still
+ * heap-allocated, so entry strings may be a mix of both. */
+typedef struct playlist_string_block
+{
+   struct playlist_string_block *next;
+   size_t size;
+   size_t used;
+   char data[1];
+} playlist_string_block_t;
+
+typedef struct
+{
+   const char *str;   /* NULL = empty slot */
+   uint32_t hash;
+} playlist_intern_slot_t;
+
+typedef struct
+{
+   playlist_string_block_t *blocks;   /* most recent first */
+   playlist_intern_slot_t *intern;    /* parse time only */
+   size_t intern_cap;                 /* power of two */
+   size_t intern_used;
+} playlist_strings_t;
+
 enum content_playlist_flags
 {
    CNT_PLAYLIST_FLG_MOD        = (1 << 0),
@@ -83,6 +115,7 @@ struct content_playlist
    struct playlist_entry *entries;
 
    playlist_manual_scan_record_t scan_record; /* ptr alignment */
+   playlist_strings_t strings;                /* ptr alignment */
    playlist_config_t config;                  /* size_t alignment */
 
    enum playlist_label_display_mode label_display_mode;
@@ -107,7 +140,8 @@ enum json_ctx_flags
    JSON_CTX_FLG_IN_ITEMS             = (1 << 0),
    JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT = (1 << 1),
    JSON_CTX_FLG_CAPACITY_EXCEEDED    = (1 << 2),
-   JSON_CTX_FLG_OOM                  = (1 << 3)
+   JSON_CTX_FLG_OOM                  = (1 << 3),
+   JSON_CTX_FLG_INTERN_STRING        = (1 << 4)
 };
 
 typedef struct
@@ -596,6 +630,140 @@ char *playlist_get_conf_path(playlist_t *playlist)
    return playlist->config.path;
 }
 
+#define PLAYLIST_STRING_BLOCK_MIN (16 * 1024)
+#define PLAYLIST_STRING_BLOCK_MAX (1024 * 1024)
+
+static bool playlist_strings_own(const playlist_strings_t *strings,
+      const char *str)
+{
+   const playlist_string_block_t *block;
+   for (block = strings->blocks; block; block = block->next)
+      if (str >= block->data && str < block->data + block->used)
+         return true;
+   return false;
+}
+
+/* Frees an entry string, unless it lives in a string block */
+static void playlist_string_free(playlist_t *playlist, char *str)
+{
+   if (str && !playlist_strings_own(&playlist->strings, str))
+      free(str);
+}
+
+/* Copies @len bytes of @str into a block, NUL-terminated.
+ * Blocks double in size up to PLAYLIST_STRING_BLOCK_MAX, so a large
+ * playlist ends up in a handful of them and the ownership test in
+ * playlist_string_free() stays short. */
+static char *playlist_strings_copy(playlist_strings_t *strings,
+      const char *str, size_t len)
+{
+   char *s;
+   playlist_string_block_t *block = strings->blocks;
+
+   if (!block || block->size - block->used < len + 1)
+   {
+      size_t size = block ? block->size * 2 : PLAYLIST_STRING_BLOCK_MIN;
+      if (size > PLAYLIST_STRING_BLOCK_MAX)
+         size = PLAYLIST_STRING_BLOCK_MAX;
+      if (size < len + 1)
+         size = len + 1;
+      if (!(block = (playlist_string_block_t*)malloc(
+                  sizeof(*block) + size)))
+         return NULL;
+      block->next     = strings->blocks;
+      block->size     = size;
+      block->used     = 0;
+      strings->blocks = block;
+   }
+
+   s            = block->data + block->used;
+   memcpy(s, str, len);
+   s[len]       = '\0';
+   block->used += len + 1;
+   return s;
+}
+
+/* As playlist_strings_copy(), but returns the earlier copy when the
+ * same string was already interned.  Falls back to a plain copy if
+ * the table cannot grow. */
+static char *playlist_strings_intern(playlist_strings_t *strings,
+      const char *str, size_t len)
+{
+   size_t idx;
+   char *s;
+   uint32_t hash = 5381;
+   size_t i;
+
+   for (i = 0; i < len; i++)
+      hash = ((hash << 5) + hash) + (unsigned char)str[i];
+
+   /* Keep load at or below 3/4 after inserting */
+   if ((strings->intern_used + 1) * 4 > strings->intern_cap * 3)
+   {
+      size_t new_cap = strings->intern_cap ? strings->intern_cap << 1 : 64;
+      playlist_intern_slot_t *grown = (playlist_intern_slot_t*)
+         calloc(new_cap, sizeof(*grown));
+
+      if (!grown)
+         return playlist_strings_copy(strings, str, len);
+
+      for (i = 0; i < strings->intern_cap; i++)
+      {
+         if (!strings->intern[i].str)
+            continue;
+         idx = strings->intern[i].hash & (new_cap - 1);
+         while (grown[idx].str)
+            idx = (idx + 1) & (new_cap - 1);
+         grown[idx] = strings->intern[i];
+      }
+
+      free(strings->intern);
+      strings->intern     = grown;
+      strings->intern_cap = new_cap;
+   }
+
+   idx = hash & (strings->intern_cap - 1);
+   while (strings->intern[idx].str)
+   {
+      if (     strings->intern[idx].hash == hash
+            && !strncmp(strings->intern[idx].str, str, len)
+            && !strings->intern[idx].str[len])
+         return (char*)strings->intern[idx].str;
+      idx = (idx + 1) & (strings->intern_cap - 1);
+   }
+
+   if (!(s = playlist_strings_copy(strings, str, len)))
+      return NULL;
+   strings->intern[idx].str  = s;
+   strings->intern[idx].hash = hash;
+   strings->intern_used++;
+   return s;
+}
+
+/* Drops the intern table once no more strings will be added to it */
+static void playlist_strings_seal(playlist_strings_t *strings)
+{
+   if (strings->intern)
+      free(strings->intern);
+   strings->intern      = NULL;
+   strings->intern_cap  = 0;
+   strings->intern_used = 0;
+}
+
+static void playlist_strings_free(playlist_strings_t *strings)
+{
+   playlist_string_block_t *block = strings->blocks;
+
+   while (block)
+   {
+      playlist_string_block_t *next = block->next;
+      free(block);
+      block = next;
+   }
+   strings->blocks = NULL;
+   playlist_strings_seal(strings);
+}
+
 /**
  * playlist_get_index:
  * @playlist            : Playlist handle.
@@ -618,35 +786,27 @@ void playlist_get_index(playlist_t *playlist,
 
 /**
  * playlist_free_entry:
+ * @playlist            : Playlist handle.
  * @entry               : Playlist entry handle.
  *
  * Frees playlist entry.
  **/
-static void playlist_free_entry(struct playlist_entry *entry)
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
 {
    if (!entry)
       return;
 
-   if (entry->path)
-      free(entry->path);
-   if (entry->label)
-      free(entry->label);
-   if (entry->core_path)
-      free(entry->core_path);
-   if (entry->core_name)
-      free(entry->core_name);
-   if (entry->db_name)
-      free(entry->db_name);
-   if (entry->crc32)
-      free(entry->crc32);
-   if (entry->subsystem_ident)
-      free(entry->subsystem_ident);
-   if (entry->subsystem_name)
-      free(entry->subsystem_name);
-   if (entry->runtime_str)
-      free(entry->runtime_str);
-   if (entry->last_played_str)
-      free(entry->last_played_str);
+   playlist_string_free(playlist, entry->path);
+   playlist_string_free(playlist, entry->label);
+   playlist_string_free(playlist, entry->core_path);
+   playlist_string_free(playlist, entry->core_name);
+   playlist_string_free(playlist, entry->db_name);
+   playlist_string_free(playlist, entry->crc32);
+   playlist_string_free(playlist, entry->subsystem_ident);
+   playlist_string_free(playlist, entry->subsystem_name);
+   playlist_string_free(playlist, entry->runtime_str);
+   playlist_string_free(playlist, entry->last_played_str);
    if (entry->subsystem_roms)
       string_list_free(entry->subsystem_roms);
    if (entry->path_id)
@@ -700,7 +860,7 @@ void playlist_delete_index(playlist_t *playlist,
    /* Free unwanted entry */
    entry_to_delete = (struct playlist_entry *)(playlist->entries + idx);
    if (entry_to_delete)
-      playlist_free_entry(entry_to_delete);
+      playlist_free_entry(playlist, entry_to_delete);
 
    /* Shift remaining entries to fill the gap */
    memmove(playlist->entries + idx, playlist->entries + idx + 1,
@@ -743,7 +903,7 @@ void playlist_delete_by_path(playlist_t *playlist,
             &playlist->entries[i], &playlist->config))
       {
          /* Free the matching entry */
-         playlist_free_entry(&playlist->entries[i]);
+         playlist_free_entry(playlist, &playlist->entries[i]);
          deleted_any = true;
          continue;
       }
@@ -1099,8 +1259,7 @@ void playlist_update(playlist_t *playlist, size_t idx,
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path)
-         free(entry->path);
+      playlist_string_free(playlist, entry->path);
       entry->path        = strdup(update_entry->path);
 
       if (entry->path_id)
@@ -1114,40 +1273,35 @@ void playlist_update(playlist_t *playlist, size_t idx,
 
    if (update_entry->label && (update_entry->label != entry->label))
    {
-      if (entry->label)
-         free(entry->label);
+      playlist_string_free(playlist, entry->label);
       entry->label       = strdup(update_entry->label);
       playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path)
-         free(entry->core_path);
+      playlist_string_free(playlist, entry->core_path);
       entry->core_path   = strdup(update_entry->core_path);
       playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    }
 
    if (update_entry->core_name && (update_entry->core_name != entry->core_name))
    {
-      if (entry->core_name)
-         free(entry->core_name);
+      playlist_string_free(playlist, entry->core_name);
       entry->core_name   = strdup(update_entry->core_name);
       playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    }
 
    if (update_entry->db_name && (update_entry->db_name != entry->db_name))
    {
-      if (entry->db_name)
-         free(entry->db_name);
+      playlist_string_free(playlist, entry->db_name);
       entry->db_name     = strdup(update_entry->db_name);
       playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    }
 
    if (update_entry->crc32 && (update_entry->crc32 != entry->crc32))
    {
-      if (entry->crc32)
-         free(entry->crc32);
+      playlist_string_free(playlist, entry->crc32);
       entry->crc32       = strdup(update_entry->crc32);
       playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
    }
@@ -1166,8 +1320,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path)
-         free(entry->path);
+      playlist_string_free(playlist, entry->path);
       entry->path        = strdup(update_entry->path);
 
       if (entry->path_id)
@@ -1182,8 +1335,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path)
-         free(entry->core_path);
+      playlist_string_free(playlist, entry->core_path);
       entry->core_path      = strdup(update_entry->core_path);
       if (register_update)
          playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
@@ -1261,8 +1413,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 
    if (update_entry->runtime_str && (update_entry->runtime_str != entry->runtime_str))
    {
-      if (entry->runtime_str)
-         free(entry->runtime_str);
+      playlist_string_free(playlist, entry->runtime_str);
       entry->runtime_str    = strdup(update_entry->runtime_str);
       if (register_update)
          playlist->flags   |= CNT_PLAYLIST_FLG_MOD;
@@ -1270,8 +1421,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 
    if (update_entry->last_played_str && (update_entry->last_played_str != entry->last_played_str))
    {
-      if (entry->last_played_str)
-         free(entry->last_played_str);
+      playlist_string_free(playlist, entry->last_played_str);
       entry->last_played_str = NULL;
       entry->last_played_str = strdup(update_entry->last_played_str);
       if (register_update)
@@ -1350,7 +1500,7 @@ bool playlist_push_runtime(playlist_t *playlist,
    if (_len == playlist->config.capacity)
    {
       struct playlist_entry *last_entry = &playlist->entries[_len - 1];
-      playlist_free_entry(last_entry);
+      playlist_free_entry(playlist, last_entry);
       _len--;
    }
    else
@@ -1685,7 +1835,7 @@ static bool playlist_push_new_entry(playlist_t *playlist,
    if (_len == playlist->config.capacity)
    {
       struct playlist_entry *last_entry = &playlist->entries[_len - 1];
-      playlist_free_entry(last_entry);
+      playlist_free_entry(playlist, last_entry);
       _len--;
    }
    else
@@ -1942,8 +2092,6 @@ error:
    return false;
 }
 
-static bool playlist_replace_file(const char *from, const char *to);
-
 void playlist_write_runtime_file(playlist_t *playlist)
 {
    size_t i, _len;
@@ -2099,7 +2247,7 @@ end:
    /* Only now does the new content replace the old one.  If anything
     * above failed, the temporary is discarded and what is on disk is
     * exactly what it was. */
-   if (wrote_ok && playlist_replace_file(write_path, playlist->config.path))
+   if (wrote_ok && filestream_replace(write_path, playlist->config.path) == 0)
       RARCH_DBG("[Playlist] Runtime written to file: \"%s\".\n",
             playlist->config.path);
    else
@@ -2146,45 +2294,6 @@ static void playlist_cached_after_write(playlist_t *written)
    }
 }
 
-/* Move @from onto @to, replacing whatever is there.
- *
- * POSIX rename() replaces atomically and that is the whole point of
- * this, so try it first and take the single-syscall path where it
- * works.  Windows' rename() refuses when the destination exists, so
- * there the original is moved aside first: at every instant either the
- * destination or the saved copy is a complete file, and if the second
- * move fails the original is put back.  A failure anywhere leaves the
- * existing playlist untouched, which is the outcome that matters. */
-static bool playlist_replace_file(const char *from, const char *to)
-{
-   char saved[PATH_MAX_LENGTH];
-   size_t _len;
-
-   if (filestream_rename(from, to) == 0)
-      return true;
-
-   /* Either the destination exists and this platform will not replace
-    * it, or the move itself failed.  Try moving the original aside. */
-   _len = strlcpy(saved, to, sizeof(saved));
-   if (_len + STRLEN_CONST(".old") >= sizeof(saved))
-      return false;
-   strlcpy(saved + _len, ".old", sizeof(saved) - _len);
-
-   filestream_delete(saved);          /* a leftover from a previous run */
-   if (filestream_rename(to, saved) != 0)
-      return false;                   /* original untouched; give up   */
-
-   if (filestream_rename(from, to) == 0)
-   {
-      filestream_delete(saved);
-      return true;
-   }
-
-   /* Put the original back rather than leave nothing behind. */
-   filestream_rename(saved, to);
-   return false;
-}
-
 void playlist_write_file(playlist_t *playlist)
 {
    size_t i, _len;
@@ -2606,7 +2715,7 @@ end:
    /* Only now does the new content replace the old one.  If anything
     * above failed, the temporary is discarded and the playlist on disk
     * is exactly what it was. */
-   if (wrote_ok && playlist_replace_file(write_path, playlist->config.path))
+   if (wrote_ok && filestream_replace(write_path, playlist->config.path) == 0)
    {
       RARCH_LOG("[Playlist] Written to file: \"%s\".\n",
             playlist->config.path);
@@ -2668,12 +2777,14 @@ void playlist_free(playlist_t *playlist)
          struct playlist_entry *entry = &playlist->entries[i];
 
          if (entry)
-            playlist_free_entry(entry);
+            playlist_free_entry(playlist, entry);
       }
 
       RBUF_FREE(playlist->entries);
    }
 
+   playlist_strings_free(&playlist->strings);
+
    free(playlist);
 }
 
@@ -2694,9 +2805,12 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
    RBUF_CLEAR(playlist->entries);
+
+   /* Nothing refers to the string blocks any more */
+   playlist_strings_free(&playlist->strings);
 }
 
 /**
@@ -2846,9 +2960,21 @@ static bool JSONStringHandler(void *context, const char *pValue, size_t len)
                && len
                && (pValue && *pValue))
          {
-            if (*pCtx->current_string_val)
-                free(*pCtx->current_string_val);
-             *pCtx->current_string_val = strdup(pValue);
+            playlist_strings_t *strings = &pCtx->playlist->strings;
+
+            playlist_string_free(pCtx->playlist, *pCtx->current_string_val);
+            if (pCtx->flags & JSON_CTX_FLG_INTERN_STRING)
+               *pCtx->current_string_val = playlist_strings_intern(
+                     strings, pValue, len);
+            else
+               *pCtx->current_string_val = playlist_strings_copy(
+                     strings, pValue, len);
+
+            if (!*pCtx->current_string_val)
+            {
+               pCtx->flags |= JSON_CTX_FLG_OOM;
+               return false;
+            }
          }
       }
    }
@@ -2869,6 +2995,7 @@ static bool JSONStringHandler(void *context, const char *pValue, size_t len)
    }
 
    pCtx->current_string_val = NULL;
+   pCtx->flags             &= ~(JSON_CTX_FLG_INTERN_STRING);
 
    return true;
 }
@@ -2951,20 +3078,30 @@ static bool JSONObjectMemberHandler(void *context, const char *pValue, size_t le
          {
             pCtx->current_string_val     = NULL;
             pCtx->current_entry_uint_val = NULL;
-            pCtx->flags                 &= ~(JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT);
+            pCtx->flags                 &= ~(JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT
+                                             | JSON_CTX_FLG_INTERN_STRING);
             switch (pValue[0])
             {
                case 'c':
                      if (!strcmp(pValue, "core_name"))
+                     {
                         pCtx->current_string_val = &pCtx->current_entry->core_name;
+                        pCtx->flags             |= JSON_CTX_FLG_INTERN_STRING;
+                     }
                      else if (!strcmp(pValue, "core_path"))
+                     {
                         pCtx->current_string_val = &pCtx->current_entry->core_path;
+                        pCtx->flags             |= JSON_CTX_FLG_INTERN_STRING;
+                     }
                      else if (!strcmp(pValue, "crc32"))
                         pCtx->current_string_val = &pCtx->current_entry->crc32;
                      break;
                case 'd':
                      if (!strcmp(pValue, "db_name"))
+                     {
                         pCtx->current_string_val = &pCtx->current_entry->db_name;
+                        pCtx->flags             |= JSON_CTX_FLG_INTERN_STRING;
+                     }
                      break;
                case 'e':
                      if (!strcmp(pValue, "entry_slot"))
@@ -3000,9 +3137,15 @@ static bool JSONObjectMemberHandler(void *context, const char *pValue, size_t le
                      break;
                case 's':
                      if (!strcmp(pValue, "subsystem_ident"))
+                     {
                         pCtx->current_string_val = &pCtx->current_entry->subsystem_ident;
+                        pCtx->flags             |= JSON_CTX_FLG_INTERN_STRING;
+                     }
                      else if (!strcmp(pValue, "subsystem_name"))
+                     {
                         pCtx->current_string_val = &pCtx->current_entry->subsystem_name;
+                        pCtx->flags             |= JSON_CTX_FLG_INTERN_STRING;
+                     }
                      else if (!strcmp(pValue, "subsystem_roms"))
                         pCtx->flags |= (JSON_CTX_FLG_IN_SUBSYSTEM_CONTENT);
                      break;
@@ -3155,12 +3298,14 @@ static void playlist_parse_close_io(playlist_parse_t *p)
             && p->context.current_entry ==
                   p->playlist->entries + RBUF_LEN(p->playlist->entries))
       {
-         playlist_free_entry(p->context.current_entry);
+         playlist_free_entry(p->playlist, p->context.current_entry);
          p->context.current_entry = NULL;
       }
       rjson_free(p->parser);
       p->parser = NULL;
    }
+   if (p->playlist)
+      playlist_strings_seal(&p->playlist->strings);
    if (p->file)
    {
       intfstream_close(p->file);
@@ -3329,7 +3474,7 @@ stopped:
    if (     p->context.current_entry
          && p->context.current_entry ==
                playlist->entries + RBUF_LEN(playlist->entries))
-      playlist_free_entry(p->context.current_entry);
+      playlist_free_entry(p->playlist, p->context.current_entry);
 
    playlist_parse_enter_autofix(p);
    return (p->phase == PLAYLIST_PARSE_PHASE_ERROR) ? -1 : 1;
@@ -3556,7 +3701,7 @@ static int playlist_parse_step_autofix(playlist_parse_t *p,
                playlist->config.base_content_directory, p->newref_len,
                sizeof(tmp_entry_path));
 
-         free(entry->path);
+         playlist_string_free(playlist, entry->path);
          entry->path = strdup(tmp_entry_path);
 
          /* Fix subsystem roms paths*/
@@ -3665,6 +3810,10 @@ playlist_parse_t *playlist_parse_begin(const playlist_config_t *config)
    playlist->default_core_path              = NULL;
    playlist->base_content_directory         = NULL;
    playlist->entries                        = NULL;
+   playlist->strings.blocks                 = NULL;
+   playlist->strings.intern                 = NULL;
+   playlist->strings.intern_cap             = 0;
+   playlist->strings.intern_used            = 0;
    playlist->label_display_mode             = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode           = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode            = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
@@ -125,6 +125,7 @@
 #include "location_driver.h"
 
 #include "runloop.h"
+#include "performance_trace.h"
 #include "camera/camera_driver.h"
 #include "location_driver.h"
 #include "record/record_driver.h"
@@ -327,7 +328,8 @@ enum
    RA_OPT_SET_SHADER,
    RA_OPT_DATABASE_SCAN,
    RA_OPT_ACCESSIBILITY,
-   RA_OPT_LOAD_MENU_ON_ERROR
+   RA_OPT_LOAD_MENU_ON_ERROR,
+   RA_OPT_TRACE
 };
 
 /* DRIVERS */
@@ -359,6 +361,7 @@ struct rarch_state
    char path_config_append_file[PATH_MAX_LENGTH];
    char path_config_override_file[PATH_MAX_LENGTH];
    char path_core_options_file[PATH_MAX_LENGTH];
+   char path_trace[PATH_MAX_LENGTH];
    char dir_system[DIR_MAX_LENGTH];
    char dir_savefile[DIR_MAX_LENGTH];
    char dir_savestate[DIR_MAX_LENGTH];
@@ -3322,6 +3325,8 @@ static void command_event_finish_content_deinit(void)
 
             /* Deallocate preemptive frames */
             preempt_deinit(runloop_st);
+            /* The next core is measured afresh */
+            runahead_auto_stop();
          }
 #endif
 
@@ -4257,6 +4262,9 @@ bool command_event(enum event_command cmd, void *data)
 #ifdef HAVE_REWIND
          {
             bool rewind_enable        = settings->bools.rewind_enable;
+            bool rewind_threaded      = settings->bools.rewind_threaded;
+            bool rewind_compression   = settings->bools.rewind_compression;
+            unsigned rewind_keyframes = settings->uints.rewind_keyframe_interval;
             size_t rewind_buf_size    = settings->sizes.rewind_buffer_size;
             bool core_type_is_dummy   = runloop_st->current_core_type == CORE_TYPE_DUMMY;
 
@@ -4280,7 +4288,8 @@ bool command_event(enum event_command cmd, void *data)
 #endif
                {
                   state_manager_event_init(&runloop_st->rewind_st,
-                        (unsigned)rewind_buf_size);
+                        (unsigned)rewind_buf_size, rewind_threaded,
+                        rewind_compression, rewind_keyframes);
                }
             }
          }
@@ -6402,6 +6411,15 @@ void main_exit(void *args)
       runloop_log_counters(p_rarch->perf_counters_rarch, p_rarch->perf_ptr_rarch);
    }
 
+   if (*p_rarch->path_trace)
+   {
+      if (perf_trace_write(p_rarch->path_trace))
+         RARCH_LOG("[Trace] Wrote \"%s\".\n", p_rarch->path_trace);
+      else
+         RARCH_ERR("[Trace] Could not write \"%s\".\n", p_rarch->path_trace);
+   }
+   perf_trace_deinit();
+
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
 #endif
@@ -6683,9 +6701,13 @@ int rarch_main(int argc, char *argv[], void *data)
 #ifdef HAVE_QT
       ui_companion_qt.application->process_events();
 #endif
+      PERF_TRACE_BEGIN("runloop_iterate");
       ret = runloop_iterate();
+      PERF_TRACE_END("runloop_iterate");
 
+      PERF_TRACE_BEGIN("task_queue_check");
       task_queue_check();
+      PERF_TRACE_END("task_queue_check");
 
 #ifdef HAVE_MIST
    steam_poll();
@@ -6788,7 +6810,9 @@ void emscripten_mainloop(void)
       }
    }
 
+   PERF_TRACE_BEGIN("runloop_iterate");
    ret = runloop_iterate();
+   PERF_TRACE_END("runloop_iterate");
 
 #ifdef EMSCRIPTEN_AUDIO_ASYNC_BLOCK
 #ifdef HAVE_AUDIOWORKLET
@@ -6799,7 +6823,9 @@ void emscripten_mainloop(void)
 #endif
 #endif
 
+   PERF_TRACE_BEGIN("task_queue_check");
    task_queue_check();
+   PERF_TRACE_END("task_queue_check");
 
    if (ret == -1)
    {
@@ -7370,6 +7396,8 @@ static void retroarch_print_help(const char *arg0)
    strlcpy_append(buf, sizeof(buf), &_len,
          "      --load-menu-on-error       "
          "Open menu instead of quitting if specified core or content fails to load.\n"
+         "      --trace=FILE               "
+         "Records a frame trace and writes it to FILE in Chrome trace format on exit.\n"
          "  -e, --entryslot=NUMBER         "
          "Slot from which to load an entry state.\n"
          "  -s, --save=PATH                "
@@ -7655,6 +7683,7 @@ static bool retroarch_parse_input_and_config(
       { "log-file",           1, NULL, RA_OPT_LOG_FILE },
       { "accessibility",      0, NULL, RA_OPT_ACCESSIBILITY},
       { "load-menu-on-error", 0, NULL, RA_OPT_LOAD_MENU_ON_ERROR },
+      { "trace",              1, NULL, RA_OPT_TRACE },
       { "entryslot",          1, NULL, 'e' },
 #ifdef HAVE_LIBRETRODB
       { "scan",               1, NULL, RA_OPT_DATABASE_SCAN },
@@ -8250,6 +8279,12 @@ static bool retroarch_parse_input_and_config(
             case RA_OPT_LOAD_MENU_ON_ERROR:
                global->flags |= GLOB_FLG_CLI_LOAD_MENU_ON_ERR;
                break;
+            case RA_OPT_TRACE:
+               strlcpy(p_rarch->path_trace, optarg,
+                     sizeof(p_rarch->path_trace));
+               if (!perf_trace_start())
+                  RARCH_WARN("[Trace] Could not start tracing.\n");
+               break;
             case 'e':
                {
                   char *endptr;
@@ -8991,6 +9026,9 @@ void retroarch_init_task_queue(void)
     * transfers of the process could each create one and then lock
     * different objects. */
    net_http_init();
+#endif
+#ifdef HAVE_THREADS
+   task_queue_set_workers(settings->uints.threaded_data_runloop_workers);
 #endif
    task_queue_init(threaded_enable, runloop_task_msg_queue_push);
 
@@ -29,6 +29,7 @@
 #endif
 
 #include <encodings/utf.h>
+#include <features/features_cpu.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
 #include <queues/task_queue.h>
@@ -1344,6 +1345,50 @@ static void runahead_add_hooks(runloop_state_t *runloop_st)
    runahead_add_input_state_hook(runloop_st);
 }
 
+/* Cost measurements for auto-tuning; see runahead_auto_run() */
+
+enum runahead_auto_flags
+{
+   RUNAHEAD_AUTO_FLAG_ACTIVE        = (1 << 0),
+   RUNAHEAD_AUTO_FLAG_ALLOW_SECOND  = (1 << 1),
+   RUNAHEAD_AUTO_FLAG_NO_RUNAHEAD   = (1 << 2),
+   RUNAHEAD_AUTO_FLAG_NO_SECOND     = (1 << 3),
+   RUNAHEAD_AUTO_FLAG_NO_PREEMPT    = (1 << 4)
+};
+
+static struct runahead_auto
+{
+   /* Averages; always kept, so auto-tuning starts from real numbers */
+   retro_time_t run_usec;
+   retro_time_t save_usec;
+   retro_time_t load_usec;
+   retro_time_t budget_usec;
+   retro_time_t last_start;
+   retro_time_t last_cost;
+   retro_time_t window_peak;
+   retro_time_t peak_usec;
+   uint64_t last_frame_count;
+   enum runahead_auto_mode mode;
+   unsigned frames;
+   unsigned window;      /* frames into the current window */
+   unsigned overruns;    /* late frames in a row */
+   unsigned hold;        /* windows before frames may go up again */
+   unsigned back_offs;
+   uint8_t flags;
+} runahead_auto_st;
+
+/* Folds the time since @start into the average at @avg */
+static void runahead_auto_sample(retro_time_t *avg, retro_time_t start)
+{
+   retro_time_t usec = cpu_features_get_time_usec() - start;
+   if (usec < 1)
+      usec = 1;
+   if (*avg)
+      *avg += (usec - *avg) / 8;
+   else
+      *avg  = usec;
+}
+
 /* Runahead Code */
 
 static void runahead_err(runloop_state_t *runloop_st)
@@ -1449,6 +1494,7 @@ void runahead_run(void *data,
       bool use_secondary)
 {
    runloop_state_t *runloop_st = (runloop_state_t*)data;
+   retro_time_t t;
    int frame_number        = 0;
    bool last_frame         = false;
    bool suspended_frame    = false;
@@ -1558,10 +1604,12 @@ void runahead_run(void *data,
             video_driver_modify_disp_flags(0, VIDEO_FLAG_ACTIVE);
          }
 
+         t = cpu_features_get_time_usec();
          if (frame_number == 0)
             core_run();
          else
             runahead_core_run_use_last_input(runloop_st);
+         runahead_auto_sample(&runahead_auto_st.run_usec, t);
 
          if (suspended_frame)
          {
@@ -1575,6 +1623,7 @@ void runahead_run(void *data,
 
          if (frame_number == 0)
          {
+            t = cpu_features_get_time_usec();
             if (!runahead_save_state(runloop_st))
             {
                const char *_msg =
@@ -1584,10 +1633,12 @@ void runahead_run(void *data,
                RARCH_WARN("[Run-Ahead] %s\n", _msg);
                return;
             }
+            runahead_auto_sample(&runahead_auto_st.save_usec, t);
          }
 
          if (last_frame)
          {
+            t = cpu_features_get_time_usec();
             if (!runahead_load_state(runloop_st))
             {
                const char *_msg = msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE);
@@ -1596,6 +1647,7 @@ void runahead_run(void *data,
                RARCH_WARN("[Run-Ahead] %s\n", _msg);
                return;
             }
+            runahead_auto_sample(&runahead_auto_st.load_usec, t);
          }
       }
    }
@@ -1606,7 +1658,9 @@ void runahead_run(void *data,
 
       /* run main core with video suspended */
       video_driver_modify_disp_flags(0, VIDEO_FLAG_ACTIVE);
+      t = cpu_features_get_time_usec();
       core_run();
+      runahead_auto_sample(&runahead_auto_st.run_usec, t);
       if (video_st->flags & VIDEO_FLAG_RUNAHEAD_IS_ACTIVE)
          video_driver_modify_disp_flags(VIDEO_FLAG_ACTIVE, 0);
       else
@@ -1617,6 +1671,7 @@ void runahead_run(void *data,
       {
          runloop_st->flags &= ~RUNLOOP_FLAG_INPUT_IS_DIRTY;
 
+         t = cpu_features_get_time_usec();
          if (!runahead_save_state(runloop_st))
          {
             const char *_msg = msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE);
@@ -1625,7 +1680,9 @@ void runahead_run(void *data,
             RARCH_WARN("[Run-Ahead] %s\n", _msg);
             return;
          }
+         runahead_auto_sample(&runahead_auto_st.save_usec, t);
 
+         t = cpu_features_get_time_usec();
          if (!runahead_load_state_secondary(runloop_st, settings))
          {
             const char *_msg = msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE);
@@ -1634,16 +1691,19 @@ void runahead_run(void *data,
             RARCH_WARN("[Run-Ahead] %s\n", _msg);
             return;
          }
+         runahead_auto_sample(&runahead_auto_st.load_usec, t);
 
          for (frame_number = 0; frame_number < runahead_count - 1; frame_number++)
          {
             video_driver_modify_disp_flags(0, VIDEO_FLAG_ACTIVE);
             audio_st->flags             |= AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE;
+            t                            = cpu_features_get_time_usec();
             if (secondary_core_run_use_last_input(runloop_st))
                runloop_st->flags        |=  RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
             else
                runloop_st->flags        &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
+            runahead_auto_sample(&runahead_auto_st.run_usec, t);
             audio_st->flags             &= ~(AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE);
             if (video_st->flags & VIDEO_FLAG_RUNAHEAD_IS_ACTIVE)
@@ -1654,10 +1714,12 @@ void runahead_run(void *data,
       }
       audio_st->flags                   |= AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE;
+      t                                  = cpu_features_get_time_usec();
       if (secondary_core_run_use_last_input(runloop_st))
          runloop_st->flags              |=  RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
       else
          runloop_st->flags              &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
+      runahead_auto_sample(&runahead_auto_st.run_usec, t);
       audio_st->flags                   &= ~(AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE);
 #endif
@@ -1722,6 +1784,7 @@ static const char* preempt_allocate(runloop_state_t *runloop_st,
 
    preempt->state_size = info_size;
    preempt->frames     = frames;
+   preempt->max_frames = frames;
 
    for (i = 0; i < frames; i++)
    {
@@ -1749,7 +1812,7 @@ void preempt_deinit(void *data)
       return;
 
    /* Free memory */
-   for (i = 0; i < preempt->frames; i++)
+   for (i = 0; i < preempt->max_frames; i++)
       free(preempt->buffer[i]);
 
    free(preempt);
@@ -1765,27 +1828,11 @@ void preempt_deinit(void *data)
       current_core->retro_set_input_state(runloop_st->retro_ctx.state_cb);
 }
 
-/**
- * preempt_init:
- *
- * @return true on success, false on failure
- *
- * Allocates savestate buffer and sets overrides for preemptive frames.
- **/
-bool preempt_init(void *data)
+/* Sets up preemptive frames with buffers for @frames frames */
+static bool preempt_create(runloop_state_t *runloop_st, unsigned frames,
+      bool run_ahead_hide_warnings)
 {
-   runloop_state_t *runloop_st   = (runloop_state_t*)data;
-   settings_t *settings          = config_get_ptr();
-   const char *_msg              = NULL;
-   bool preemptive_frames_enable = settings->bools.preemptive_frames_enable;
-   unsigned run_ahead_frames     = settings->uints.run_ahead_frames;
-   bool run_ahead_hide_warnings  = settings->bools.run_ahead_hide_warnings;
-
-   if (     runloop_st->preempt_data
-         || !preemptive_frames_enable
-         || !run_ahead_frames
-         || !(runloop_st->current_core.flags & RETRO_CORE_FLAG_GAME_LOADED))
-      return false;
+   const char *_msg = NULL;
 
    /* Check if supported - same requirements as runahead */
    if (!core_info_current_supports_runahead())
@@ -1803,8 +1850,7 @@ bool preempt_init(void *data)
    if (video_state_get_ptr()->frame_count == 0)
       runloop_st->current_core.retro_run();
 
-   /* Allocate - same 'frames' setting as runahead */
-   if ((_msg = preempt_allocate(runloop_st, run_ahead_frames)))
+   if ((_msg = preempt_allocate(runloop_st, frames)))
       goto error;
 
    /* Only poll in preempt_run() */
@@ -1825,6 +1871,32 @@ error:
    return false;
 }
 
+/**
+ * preempt_init:
+ *
+ * @return true on success, false on failure
+ *
+ * Allocates savestate buffer and sets overrides for preemptive frames.
+ **/
+bool preempt_init(void *data)
+{
+   runloop_state_t *runloop_st   = (runloop_state_t*)data;
+   settings_t *settings          = config_get_ptr();
+   bool preemptive_frames_enable = settings->bools.preemptive_frames_enable;
+   unsigned run_ahead_frames     = settings->uints.run_ahead_frames;
+   bool run_ahead_hide_warnings  = settings->bools.run_ahead_hide_warnings;
+
+   if (     runloop_st->preempt_data
+         || !preemptive_frames_enable
+         || !run_ahead_frames
+         || !(runloop_st->current_core.flags & RETRO_CORE_FLAG_GAME_LOADED))
+      return false;
+
+   /* Same 'frames' setting as runahead */
+   return preempt_create(runloop_st, run_ahead_frames,
+         run_ahead_hide_warnings);
+}
+
 static INLINE bool preempt_analog_input_dirty(preempt_t *preempt,
       retro_input_state_t state_cb, unsigned port)
 {
@@ -1957,8 +2029,10 @@ void preempt_run(preempt_t *preempt, void *data)
 {
    runloop_state_t     *runloop_st   = (runloop_state_t*)data;
    struct retro_core_t *current_core = &runloop_st->current_core;
+   struct runahead_auto *costs       = &runahead_auto_st;
    const char *_msg                  = NULL;
    audio_driver_state_t *audio_st    = audio_state_get_ptr();
+   retro_time_t t;
    settings_t *settings              = config_get_ptr();
    unsigned input_max_users          = settings->uints.input_max_users;
    bool run_ahead_hide_warnings      = settings->bools.run_ahead_hide_warnings;
@@ -1975,26 +2049,34 @@ void preempt_run(preempt_t *preempt, void *data)
       audio_st->flags |=  AUDIO_FLAG_SUSPENDED;
       video_driver_modify_disp_flags(0, VIDEO_FLAG_ACTIVE);
 
+      t = cpu_features_get_time_usec();
       if (!current_core->retro_unserialize(
             preempt->buffer[preempt->start_ptr], preempt->state_size))
       {
          _msg = msg_hash_to_str(MSG_PREEMPT_FAILED_TO_LOAD_STATE);
          goto error;
       }
+      runahead_auto_sample(&costs->load_usec, t);
 
+      t = cpu_features_get_time_usec();
       current_core->retro_run();
+      runahead_auto_sample(&costs->run_usec, t);
       preempt->replay_ptr = PREEMPT_NEXT_PTR(preempt->start_ptr);
 
       while (preempt->replay_ptr != preempt->start_ptr)
       {
+         t = cpu_features_get_time_usec();
          if (!current_core->retro_serialize(
                preempt->buffer[preempt->replay_ptr], preempt->state_size))
          {
             _msg = msg_hash_to_str(MSG_PREEMPT_FAILED_TO_SAVE_STATE);
             goto error;
          }
+         runahead_auto_sample(&costs->save_usec, t);
 
+         t = cpu_features_get_time_usec();
          current_core->retro_run();
+         runahead_auto_sample(&costs->run_usec, t);
          preempt->replay_ptr = PREEMPT_NEXT_PTR(preempt->replay_ptr);
       }
 
@@ -2003,19 +2085,23 @@ void preempt_run(preempt_t *preempt, void *data)
    }
 
    /* Save current state and set start_ptr to oldest state */
+   t = cpu_features_get_time_usec();
    if (!current_core->retro_serialize(
          preempt->buffer[preempt->start_ptr], preempt->state_size))
    {
       _msg = msg_hash_to_str(MSG_PREEMPT_FAILED_TO_SAVE_STATE);
       goto error;
    }
+   runahead_auto_sample(&costs->save_usec, t);
 
    preempt->start_ptr = PREEMPT_NEXT_PTR(preempt->start_ptr);
    runloop_st->flags &= ~(RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE
          | RUNLOOP_FLAG_INPUT_IS_DIRTY);
 
    /* Run normal frame */
+   t = cpu_features_get_time_usec();
    current_core->retro_run();
+   runahead_auto_sample(&costs->run_usec, t);
    preempt->frame_count++;
    return;
 
@@ -2032,6 +2118,389 @@ error:
    RARCH_ERR("[Run-Ahead Preemptive] %s\n", _msg);
 }
 
+/* Auto-tuned run-ahead
+ *
+ * runahead_run() and preempt_run() time every retro_run, serialize and
+ * unserialize they make. From those averages, the cost of a frame with
+ * N frames of run-ahead is predicted as
+ *
+ *                     new input                   same input
+ *   single instance   (N+1) run + save + load     the same
+ *   second instance   (N+1) run + save + load     2 run
+ *   preemptive        (N+1) run + N save + load   run + save
+ *
+ * The most frames whose new-input frame fits in a share of the frame
+ * budget win, in the mode with the cheapest same-input frame. The budget
+ * is the display refresh period, or frame_limit_minimum_time where that
+ * is shorter, less the frame delay. Frames go up at most one per window;
+ * they come down as soon as the prediction no longer fits, or a few
+ * frames in a row run late: each overruns the budget share, or the
+ * frame after it starts late. */
+#define RUNAHEAD_AUTO_WINDOW    120 /* frames between re-evaluations */
+#define RUNAHEAD_AUTO_HOLD      4   /* windows without going up after backing off */
+#define RUNAHEAD_AUTO_OVERRUNS  3   /* late frames in a row that make it back off */
+
+static const char *runahead_auto_mode_name(enum runahead_auto_mode mode)
+{
+   switch (mode)
+   {
+      case RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE:
+         return "single instance";
+      case RUNAHEAD_AUTO_MODE_SECOND_INSTANCE:
+         return "second instance";
+      case RUNAHEAD_AUTO_MODE_PREEMPTIVE:
+         return "preemptive";
+      default:
+         break;
+   }
+   return "off";
+}
+
+/* Predicted cost of a frame; with new input if @worst */
+static retro_time_t runahead_auto_cost(enum runahead_auto_mode mode,
+      unsigned frames, bool worst)
+{
+   struct runahead_auto *st = &runahead_auto_st;
+   retro_time_t run         = st->run_usec;
+
+   switch (mode)
+   {
+      case RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE:
+         return (frames + 1) * run + st->save_usec + st->load_usec;
+      case RUNAHEAD_AUTO_MODE_SECOND_INSTANCE:
+         if (!worst)
+            return 2 * run;
+         return (frames + 1) * run + st->save_usec + st->load_usec;
+      case RUNAHEAD_AUTO_MODE_PREEMPTIVE:
+         if (!worst)
+            return run + st->save_usec;
+         return (frames + 1) * run + frames * st->save_usec + st->load_usec;
+      default:
+         break;
+   }
+
+   return run;
+}
+
+static bool runahead_auto_mode_usable(enum runahead_auto_mode mode)
+{
+   uint8_t flags = runahead_auto_st.flags;
+
+   switch (mode)
+   {
+      case RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE:
+         return !(flags & RUNAHEAD_AUTO_FLAG_NO_RUNAHEAD);
+      case RUNAHEAD_AUTO_MODE_SECOND_INSTANCE:
+#if HAVE_DYNAMIC
+         return    (flags & RUNAHEAD_AUTO_FLAG_ALLOW_SECOND)
+               && !(flags & (RUNAHEAD_AUTO_FLAG_NO_RUNAHEAD
+                           | RUNAHEAD_AUTO_FLAG_NO_SECOND));
+#else
+         return false;
+#endif
+      case RUNAHEAD_AUTO_MODE_PREEMPTIVE:
+         return !(flags & RUNAHEAD_AUTO_FLAG_NO_PREEMPT);
+      default:
+         break;
+   }
+
+   return true;
+}
+
+/* Picks the most frames, up to @max_frames, that fit in @target */
+static void runahead_auto_choose(unsigned max_frames, retro_time_t target,
+      enum runahead_auto_mode *mode, unsigned *frames)
+{
+   unsigned n;
+
+   for (n = max_frames; n > 0; n--)
+   {
+      int m;
+      enum runahead_auto_mode best = RUNAHEAD_AUTO_MODE_OFF;
+      retro_time_t best_cost       = 0;
+
+      for (m  = RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE;
+           m <= RUNAHEAD_AUTO_MODE_PREEMPTIVE; m++)
+      {
+         retro_time_t cost;
+
+         if (     !runahead_auto_mode_usable((enum runahead_auto_mode)m)
+               || runahead_auto_cost((enum runahead_auto_mode)m, n, true)
+                  > target)
+            continue;
+
+         cost = runahead_auto_cost((enum runahead_auto_mode)m, n, false);
+         /* Switching modes is not free; only for a clear gain */
+         if (m == (int)runahead_auto_st.mode)
+            cost -= cost / 5;
+
+         if (best == RUNAHEAD_AUTO_MODE_OFF || cost < best_cost)
+         {
+            best      = (enum runahead_auto_mode)m;
+            best_cost = cost;
+         }
+      }
+
+      if (best != RUNAHEAD_AUTO_MODE_OFF)
+      {
+         *mode   = best;
+         *frames = n;
+         return;
+      }
+   }
+
+   *mode   = RUNAHEAD_AUTO_MODE_OFF;
+   *frames = 0;
+}
+
+static void runahead_auto_set(runloop_state_t *runloop_st,
+      enum runahead_auto_mode mode, unsigned frames)
+{
+   struct runahead_auto *st = &runahead_auto_st;
+
+   if (!frames)
+      mode = RUNAHEAD_AUTO_MODE_OFF;
+
+   if (mode == st->mode && frames == st->frames)
+      return;
+
+   RARCH_LOG("[Run-Ahead] Auto: %u frame(s), %s.\n",
+         frames, runahead_auto_mode_name(mode));
+
+   st->mode           = mode;
+   st->frames         = frames;
+   /* A second instance or replay buffer set up for other frames
+    * has to catch up from a fresh state */
+   runloop_st->flags |= RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY;
+}
+
+static void runahead_auto_back_off(runloop_state_t *runloop_st,
+      retro_time_t target)
+{
+   enum runahead_auto_mode mode;
+   unsigned frames;
+   struct runahead_auto *st = &runahead_auto_st;
+
+   runahead_auto_choose(st->frames ? st->frames - 1 : 0, target,
+         &mode, &frames);
+   runahead_auto_set(runloop_st, mode, frames);
+   st->overruns = 0;
+   st->hold     = RUNAHEAD_AUTO_HOLD;
+   st->back_offs++;
+}
+
+static retro_time_t runahead_auto_budget(runloop_state_t *runloop_st,
+      settings_t *settings, video_driver_state_t *video_st)
+{
+   float refresh       = settings->floats.video_refresh_rate;
+   retro_time_t budget = (refresh > 0.0f)
+      ? (retro_time_t)(1000000.0f / refresh)
+      : 16667;
+
+   if (     runloop_st->frame_limit_minimum_time > 0
+         && runloop_st->frame_limit_minimum_time < budget)
+      budget  = runloop_st->frame_limit_minimum_time;
+
+   budget    -= video_st->frame_delay_effective * 1000;
+
+   return (budget > 1000) ? budget : 1000;
+}
+
+/* Sets up or tears down preemptive frames to match the current mode */
+static void runahead_auto_apply(runloop_state_t *runloop_st,
+      unsigned max_frames, bool hide_warnings, retro_time_t target)
+{
+   struct runahead_auto *st = &runahead_auto_st;
+   preempt_t *preempt       = runloop_st->preempt_data;
+
+   if (st->mode != RUNAHEAD_AUTO_MODE_PREEMPTIVE)
+   {
+      if (preempt)
+         preempt_deinit(runloop_st);
+      return;
+   }
+
+   if (preempt && preempt->max_frames < st->frames)
+   {
+      preempt_deinit(runloop_st);
+      preempt = NULL;
+   }
+
+   if (!preempt)
+   {
+      if (!preempt_create(runloop_st, max_frames, hide_warnings))
+      {
+         enum runahead_auto_mode mode;
+         unsigned frames;
+         st->flags |= RUNAHEAD_AUTO_FLAG_NO_PREEMPT;
+         runahead_auto_choose(st->frames, target, &mode, &frames);
+         runahead_auto_set(runloop_st, mode, frames);
+         return;
+      }
+      preempt = runloop_st->preempt_data;
+   }
+
+   if (preempt->frames != st->frames)
+   {
+      preempt->frames      = st->frames;
+      preempt->start_ptr   = 0;
+      preempt->frame_count = 0;
+   }
+}
+
+void runahead_auto_run(void *data, unsigned max_frames,
+      bool hide_warnings, bool use_secondary)
+{
+   runloop_state_t *runloop_st    = (runloop_state_t*)data;
+   struct runahead_auto *st       = &runahead_auto_st;
+   settings_t *settings           = config_get_ptr();
+   video_driver_state_t *video_st = video_state_get_ptr();
+   uint64_t frame_count           = video_st->frame_count;
+   retro_time_t start             = cpu_features_get_time_usec();
+   retro_time_t target, cost, t;
+
+   if (max_frames > MAX_RUNAHEAD_FRAMES)
+      max_frames = MAX_RUNAHEAD_FRAMES;
+
+   if (use_secondary)
+      st->flags |=  RUNAHEAD_AUTO_FLAG_ALLOW_SECOND;
+   else
+      st->flags &= ~RUNAHEAD_AUTO_FLAG_ALLOW_SECOND;
+
+   st->budget_usec = runahead_auto_budget(runloop_st, settings, video_st);
+   /* Leave a quarter for video, audio and the frontend */
+   target          = st->budget_usec - st->budget_usec / 4;
+
+   if (!(st->flags & RUNAHEAD_AUTO_FLAG_ACTIVE))
+   {
+      /* Start from the configured mode at one frame, to measure */
+      enum runahead_auto_mode mode = RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE;
+      if (settings->bools.preemptive_frames_enable)
+         mode = RUNAHEAD_AUTO_MODE_PREEMPTIVE;
+      else if (runahead_auto_mode_usable(RUNAHEAD_AUTO_MODE_SECOND_INSTANCE))
+         mode = RUNAHEAD_AUTO_MODE_SECOND_INSTANCE;
+      st->flags   |= RUNAHEAD_AUTO_FLAG_ACTIVE;
+      st->window   = 0;
+      st->overruns = 0;
+      runahead_auto_set(runloop_st, mode, 1);
+   }
+   else if (frame_count != st->last_frame_count + 1)
+      st->overruns = 0;
+   else if (st->last_cost <= target)
+   {
+      /* The last frame did not run over, so only now can it be told
+       * whether it was late: this frame started well over a budget
+       * after it, and it took a good part of that.  An on-time frame
+       * ends the run of late ones. */
+      if (     start - st->last_start > st->budget_usec + st->budget_usec / 2
+            && st->last_cost > target / 2)
+         st->overruns++;
+      else
+         st->overruns = 0;
+   }
+
+   st->last_start       = start;
+   st->last_frame_count = frame_count;
+
+   if (     st->frames > max_frames
+         || (st->frames && (
+                runahead_auto_cost(st->mode, st->frames, true) > target
+             || st->overruns >= RUNAHEAD_AUTO_OVERRUNS)))
+      runahead_auto_back_off(runloop_st, target);
+   else if (!runahead_auto_mode_usable(st->mode))
+   {
+      enum runahead_auto_mode mode;
+      unsigned frames;
+      runahead_auto_choose(st->frames, target, &mode, &frames);
+      runahead_auto_set(runloop_st, mode, frames);
+   }
+
+   runahead_auto_apply(runloop_st, max_frames, hide_warnings, target);
+
+   switch (st->mode)
+   {
+      case RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE:
+      case RUNAHEAD_AUTO_MODE_SECOND_INSTANCE:
+         runahead_run(runloop_st, (int)st->frames, hide_warnings,
+               st->mode == RUNAHEAD_AUTO_MODE_SECOND_INSTANCE);
+         if (!(runloop_st->flags & RUNLOOP_FLAG_RUNAHEAD_AVAILABLE))
+            st->flags |= RUNAHEAD_AUTO_FLAG_NO_RUNAHEAD;
+         else if (   st->mode == RUNAHEAD_AUTO_MODE_SECOND_INSTANCE
+                  && !(runloop_st->flags
+                     & RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE))
+            st->flags |= RUNAHEAD_AUTO_FLAG_NO_SECOND;
+         break;
+      case RUNAHEAD_AUTO_MODE_PREEMPTIVE:
+         if (runloop_st->preempt_data)
+         {
+            preempt_run(runloop_st->preempt_data, runloop_st);
+            if (!runloop_st->preempt_data)
+               st->flags |= RUNAHEAD_AUTO_FLAG_NO_PREEMPT;
+            break;
+         }
+         /* fall-through */
+      default:
+         t = cpu_features_get_time_usec();
+         core_run();
+         runahead_auto_sample(&st->run_usec, t);
+         runloop_st->flags |= RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY;
+         break;
+   }
+
+   cost          = cpu_features_get_time_usec() - start;
+   st->last_cost = cost;
+   if (cost > st->window_peak)
+      st->window_peak = cost;
+   if (cost > target)
+      st->overruns++;
+
+   if (++st->window >= RUNAHEAD_AUTO_WINDOW)
+   {
+      enum runahead_auto_mode mode;
+      unsigned frames;
+      unsigned ceiling = st->frames;
+
+      if (st->hold)
+         st->hold--;
+      else if (ceiling < max_frames)
+         ceiling++;
+
+      runahead_auto_choose(ceiling, target, &mode, &frames);
+      runahead_auto_set(runloop_st, mode, frames);
+
+      st->peak_usec   = st->window_peak;
+      st->window_peak = 0;
+      st->window      = 0;
+   }
+}
+
+bool runahead_auto_stop(void)
+{
+   if (!(runahead_auto_st.flags & RUNAHEAD_AUTO_FLAG_ACTIVE))
+      return false;
+   memset(&runahead_auto_st, 0, sizeof(runahead_auto_st));
+   return true;
+}
+
+bool runahead_auto_get_stats(runahead_auto_stats_t *stats)
+{
+   struct runahead_auto *st = &runahead_auto_st;
+
+   if (!stats || !(st->flags & RUNAHEAD_AUTO_FLAG_ACTIVE))
+      return false;
+
+   stats->run_usec    = st->run_usec;
+   stats->save_usec   = st->save_usec;
+   stats->load_usec   = st->load_usec;
+   stats->budget_usec = st->budget_usec;
+   stats->cost_usec   = runahead_auto_cost(st->mode, st->frames, true);
+   stats->peak_usec   = st->peak_usec;
+   stats->mode        = st->mode;
+   stats->frames      = st->frames;
+   stats->back_offs   = st->back_offs;
+   return true;
+}
+
 void runahead_clear_variables(void *data)
 {
    runloop_state_t *runloop_st            = (runloop_state_t*)data;
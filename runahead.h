@@ -64,8 +64,31 @@ typedef struct preemptive_frames_data
    uint8_t replay_ptr;
    /* Number of latency frames to remove */
    uint8_t frames;
+   /* Number of savestate buffers allocated; frames never exceeds it */
+   uint8_t max_frames;
 } preempt_t;
 
+enum runahead_auto_mode
+{
+   RUNAHEAD_AUTO_MODE_OFF = 0,
+   RUNAHEAD_AUTO_MODE_SINGLE_INSTANCE,
+   RUNAHEAD_AUTO_MODE_SECOND_INSTANCE,
+   RUNAHEAD_AUTO_MODE_PREEMPTIVE
+};
+
+typedef struct runahead_auto_stats
+{
+   retro_time_t run_usec;     /* one retro_run, averaged */
+   retro_time_t save_usec;    /* one serialize, averaged */
+   retro_time_t load_usec;    /* one unserialize, averaged */
+   retro_time_t budget_usec;  /* time a frame may take */
+   retro_time_t cost_usec;    /* predicted cost of a frame with new input */
+   retro_time_t peak_usec;    /* longest frame measured in the last window */
+   enum runahead_auto_mode mode;
+   unsigned frames;
+   unsigned back_offs;        /* times overruns made it drop a frame */
+} runahead_auto_stats_t;
+
 RETRO_BEGIN_DECLS
 
 typedef bool(*runahead_load_state_function)(const void*, size_t);
@@ -93,6 +116,32 @@ void preempt_deinit(void *data);
 
 void preempt_run(preempt_t *preempt, void *data);
 
+/**
+ * runahead_auto_run:
+ * @data             : runloop state
+ * @max_frames       : most frames to run ahead
+ * @hide_warnings    : do not show failures on screen
+ * @use_secondary    : whether the second instance mode may be chosen
+ *
+ * Call in place of core_run() when run-ahead is auto-tuned. Picks the
+ * mode and frame count from the measured cost of running, saving and
+ * loading the core, and runs the frame with them.
+ **/
+void runahead_auto_run(void *data, unsigned max_frames,
+      bool hide_warnings, bool use_secondary);
+
+/**
+ * runahead_auto_stop:
+ *
+ * Forgets what auto-tuning measured and chose.
+ *
+ * Returns: true if auto-tuning was running, in which case preemptive
+ * frames should be set up again from the settings.
+ **/
+bool runahead_auto_stop(void);
+
+bool runahead_auto_get_stats(runahead_auto_stats_t *stats);
+
 RETRO_END_DECLS
 
 #endif
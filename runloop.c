@@ -55,6 +55,7 @@
 #include <ctype.h>
 #include <math.h>
 #include <locale.h>
+#include <errno.h>
 
 #include <boolean.h>
 #include <clamping.h>
@@ -227,6 +228,7 @@ bool android_get_vfs_authorized_locations(
 #include "tasks/task_powerstate.h"
 #include "tasks/tasks_internal.h"
 #include "performance_counters.h"
+#include "performance_trace.h"
 
 #include "version.h"
 #include "version_git.h"
@@ -464,6 +466,11 @@ void runloop_performance_counter_register(struct retro_perf_counter *perf)
    runloop_state.perf_counters_libretro[ptr] = perf;
    runloop_state.perf_ptr_libretro           = ptr + 1;
    perf->registered                          = true;
+   /* Swapped for the tracer's equal copy once, here, so that starting
+    * and stopping the counter need not look the name up each time.
+    * The copy outlives the core. */
+   if (perf->ident)
+      perf->ident                            = perf_trace_intern(perf->ident);
 }
 
 void runloop_log_counters(
@@ -1428,12 +1435,18 @@ static void core_performance_counter_start(
       perf->call_cnt++;
       perf->start = cpu_features_get_perf_counter();
    }
+   if (perf_trace_enabled && perf->ident)
+      perf_trace_event(perf->registered
+            ? perf->ident : perf_trace_intern(perf->ident), 'B');
 }
 
 static void core_performance_counter_stop(struct retro_perf_counter *perf)
 {
    if (runloop_state.perfcnt_enable)
       perf->total += cpu_features_get_perf_counter() - perf->start;
+   if (perf_trace_enabled && perf->ident)
+      perf_trace_event(perf->registered
+            ? perf->ident : perf_trace_intern(perf->ident), 'E');
 }
 
 
@@ -4917,6 +4930,86 @@ void runloop_set_frame_limit(
    }
 }
 
+/* Waits for an absolute deadline on the cpu_features_get_time_usec()
+ * clock. The OS sleep is aimed 'spin' microseconds early and the rest
+ * is spent polling the clock, since a sleep that overshoots cannot be
+ * taken back. Where the OS can sleep until an absolute time it is
+ * used, so that a late wakeup is not made later still by the time
+ * spent computing a relative one. */
+static void runloop_frame_limit_wait(runloop_state_t *runloop_st,
+      retro_time_t deadline)
+{
+   retro_time_t spin   = runloop_st->frame_limit_spin_usec;
+   retro_time_t wake   = deadline - spin;
+   retro_time_t now    = cpu_features_get_time_usec();
+
+   if (wake > now)
+   {
+      retro_time_t overshoot;
+#if (defined(__linux__) || defined(ANDROID)) && defined(CLOCK_MONOTONIC) && defined(TIMER_ABSTIME)
+      struct timespec ts;
+      ts.tv_sec  = (time_t)(wake / 1000000);
+      ts.tv_nsec = (long)(wake % 1000000) * 1000;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+      retro_sleep_us((unsigned)(wake - now));
+#endif
+      now       = cpu_features_get_time_usec();
+      overshoot = now - wake;
+
+      /* Widen the spin window quickly when the sleep ran into it and
+       * narrow it slowly while sleeps come back in time. A single
+       * preempted wakeup only moves it part of the way. */
+      if (overshoot > spin)
+         spin += (overshoot + overshoot / 2 - spin) / 4;
+      else
+         spin -= spin / 64;
+      runloop_st->frame_limit_spin_usec = MAX(MIN(spin,
+            RUNLOOP_FRAME_LIMIT_SPIN_MAX), RUNLOOP_FRAME_LIMIT_SPIN_MIN);
+   }
+
+   while (now < deadline)
+      now = cpu_features_get_time_usec();
+}
+
+static void runloop_frame_limit_track(runloop_state_t *runloop_st,
+      retro_time_t late)
+{
+   static const retro_time_t bounds[RUNLOOP_FRAME_LIMIT_HIST_SIZE - 1] =
+   { 25, 50, 100, 250, 500, 1000 };
+   unsigned i;
+
+   for (i = 0; i < RUNLOOP_FRAME_LIMIT_HIST_SIZE - 1; i++)
+      if (late < bounds[i])
+         break;
+
+   /* Halve everything now and then so the overlay shows recent
+    * behaviour rather than the whole session. */
+   if (++runloop_st->frame_limit_count >= 8192)
+   {
+      unsigned j;
+      for (j = 0; j < RUNLOOP_FRAME_LIMIT_HIST_SIZE; j++)
+         runloop_st->frame_limit_hist[j] >>= 1;
+      runloop_st->frame_limit_count    = 0;
+      for (j = 0; j < RUNLOOP_FRAME_LIMIT_HIST_SIZE; j++)
+         runloop_st->frame_limit_count += runloop_st->frame_limit_hist[j];
+      runloop_st->frame_limit_late_max /= 2;
+   }
+   runloop_st->frame_limit_hist[i]++;
+   if (late > runloop_st->frame_limit_late_max)
+      runloop_st->frame_limit_late_max = late;
+}
+
+static void runloop_frame_limit_reset_stats(void)
+{
+   runloop_state_t *runloop_st = &runloop_state;
+   memset(runloop_st->frame_limit_hist, 0,
+         sizeof(runloop_st->frame_limit_hist));
+   runloop_st->frame_limit_count     = 0;
+   runloop_st->frame_limit_late_max  = 0;
+   runloop_st->frame_limit_spin_usec = RUNLOOP_FRAME_LIMIT_SPIN_MIN;
+}
+
 float runloop_get_fastforward_ratio(
       settings_t *settings,
       struct retro_fastforwarding_override *fastmotion_override)
@@ -5298,6 +5391,7 @@ bool runloop_event_init_core(
 
    runloop_set_frame_limit(&video_st->av_info, fastforward_ratio);
    runloop_st->frame_limit_last_time    = cpu_features_get_time_usec();
+   runloop_frame_limit_reset_stats();
 
    /* Init runtime log and read current state slot */
    runloop_runtime_log_init(runloop_st);
@@ -8148,21 +8242,43 @@ int runloop_iterate(void)
    /* Measure the time between core_run() and video_driver_frame() */
    runloop_st->core_run_time = cpu_features_get_time_usec();
 
+   PERF_TRACE_BEGIN("core_run");
    {
 #ifdef HAVE_RUNAHEAD
       bool run_ahead_enabled            = settings->bools.run_ahead_enabled;
       unsigned run_ahead_num_frames     = settings->uints.run_ahead_frames;
       bool run_ahead_hide_warnings      = settings->bools.run_ahead_hide_warnings;
       bool run_ahead_secondary_instance = settings->bools.run_ahead_secondary_instance;
+      /* Auto-tuning picks the mode and frames itself, up to
+       * run_ahead_frames, once any run-ahead mode is on */
+      bool run_ahead_auto               = settings->bools.run_ahead_auto
+            && (run_ahead_enabled || settings->bools.preemptive_frames_enable)
+            && (run_ahead_num_frames > 0);
+      bool want_runahead;
+#ifdef HAVE_NETWORKING
+      run_ahead_auto                    = run_ahead_auto && !netplay_is_enabled;
+#endif
+
+      /* Leaving auto-tuning: put preemptive frames back
+       * the way the settings have them */
+      if (!run_ahead_auto && runahead_auto_stop())
+         command_event(CMD_EVENT_PREEMPT_UPDATE, NULL);
+
       /* Run Ahead Feature replaces the call to core_run in this loop */
-      bool want_runahead                = run_ahead_enabled
+      want_runahead                     = run_ahead_enabled
             && (run_ahead_num_frames > 0)
             && (runloop_st->flags & RUNLOOP_FLAG_RUNAHEAD_AVAILABLE);
 #ifdef HAVE_NETWORKING
       want_runahead                     = want_runahead && !netplay_is_enabled;
 #endif
 
-      if (want_runahead)
+      if (run_ahead_auto)
+         runahead_auto_run(
+               runloop_st,
+               run_ahead_num_frames,
+               run_ahead_hide_warnings,
+               run_ahead_secondary_instance);
+      else if (want_runahead)
          runahead_run(
                runloop_st,
                run_ahead_num_frames,
@@ -8174,6 +8290,7 @@ int runloop_iterate(void)
 #endif
          core_run();
    }
+   PERF_TRACE_END("core_run");
 
    /* Increment runtime tick counter after each call to
     * core_run() or run_ahead() */
@@ -8287,7 +8404,16 @@ end:
 #if defined(HAVE_COCOATOUCH)
             if (!(uico_state_get_ptr()->flags & UICO_ST_FLAG_IS_ON_FOREGROUND))
 #endif
-               retro_sleep_us((unsigned)to_sleep_us);
+            {
+               if (settings->bools.frame_limit_precise)
+                  runloop_frame_limit_wait(runloop_st,
+                        runloop_st->frame_limit_last_time);
+               else
+                  retro_sleep_us((unsigned)to_sleep_us);
+               runloop_frame_limit_track(runloop_st,
+                     cpu_features_get_time_usec()
+                     - runloop_st->frame_limit_last_time);
+            }
 #endif
 
             return 1;
@@ -171,6 +171,16 @@ typedef struct core_options_callbacks
    retro_core_options_update_display_callback_t update_display;
 } core_options_callbacks_t;
 
+/* Buckets of the frame limiter's lateness histogram, by how far past
+ * its deadline the limiter woke: under 25, 50, 100, 250, 500 and
+ * 1000 us, and the rest. */
+#define RUNLOOP_FRAME_LIMIT_HIST_SIZE 7
+
+/* Bounds of the window the precise frame limiter spends polling the
+ * clock instead of sleeping, in microseconds. */
+#define RUNLOOP_FRAME_LIMIT_SPIN_MIN 200
+#define RUNLOOP_FRAME_LIMIT_SPIN_MAX 2000
+
 struct runloop
 {
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
@@ -181,6 +191,8 @@ struct runloop
    retro_time_t core_run_time;
    retro_time_t frame_limit_minimum_time;
    retro_time_t frame_limit_last_time;
+   retro_time_t frame_limit_spin_usec;
+   retro_time_t frame_limit_late_max;
    retro_usec_t frame_time_last;                /* int64_t alignment */
 
    /* Per-frame scalar state. Kept adjacent to the timing block above so the
@@ -198,6 +210,8 @@ struct runloop
 #endif
 
    uint32_t flags;
+   uint32_t frame_limit_hist[RUNLOOP_FRAME_LIMIT_HIST_SIZE];
+   uint32_t frame_limit_count;
    int16_t entry_state_slot;
    uint8_t pending_disk_control_insert;
    int8_t run_frames_and_pause;
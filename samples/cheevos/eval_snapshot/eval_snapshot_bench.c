@@ -0,0 +1,782 @@
+/* Benchmark and exactness check for background achievement evaluation
+ * (cheevos/cheevos_snapshot.c and the worker in cheevos/cheevos.c).
+ *
+ * A memory trace is replayed twice through the rcheevos runtime:
+ *
+ *   sync    every frame is evaluated on the main thread against live
+ *           memory, as rcheevos_test() does by default
+ *   worker  at the end of every frame the pages the set reads are
+ *           captured into a snapshot and the frame is evaluated on a
+ *           second thread while the main thread already applies the
+ *           next frame's writes, as with cheevos_background_eval
+ *
+ * Both must raise the same events on the same frames; any difference
+ * fails the run.  Reported per frame is the main thread's CPU time:
+ * the evaluation in sync mode, the capture and hand-off in worker mode,
+ * plus the wall time it spent blocked on a worker that was still busy
+ * (which the emulation time per frame, --core-us, normally hides).
+ *
+ * A trace is the memory image at frame 0 followed by the writes of
+ * every later frame:
+ *
+ *   "RCMT" u32 version(1) u32 mem_size u32 frames
+ *   u8 image[mem_size]
+ *   per frame: u32 writes, then per write: u32 address u32 length
+ *              u8 bytes[length]
+ *
+ * (all little-endian).  Without --trace a synthetic one is generated:
+ * a game that keeps its state in a few hot clusters of RAM, a pointer
+ * table, and a large buffer it rewrites every frame that no
+ * achievement looks at.  --save writes it out in the format above.
+ * --set reads an achievement set, one memaddr string per line, '#'
+ * starting a comment; the synthetic set is --cheevos conditions drawn
+ * from the usual shapes (compares, hit counts, deltas, pointers,
+ * PauseIf/ResetIf, bits) over the hot clusters.
+ *
+ * Usage:
+ *   eval_snapshot_bench [--frames N] [--cheevos N] [--core-us N]
+ *                       [--trace FILE] [--set FILE] [--save FILE]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <rthreads/rthreads.h>
+
+#include "../../../deps/rcheevos/include/rc_runtime.h"
+#include "../../../cheevos/cheevos_snapshot.h"
+
+#define MEM_SIZE      (2 * 1024 * 1024)
+#define CLUSTERS      32
+#define CLUSTER_SIZE  512
+#define POINTERS      16
+#define NOISE_SIZE    (64 * 1024)
+#define RESET_EVERY   300
+
+typedef struct
+{
+   uint32_t frame;
+   uint32_t id;
+   int32_t value;
+   uint8_t type;
+} event_t;
+
+typedef struct
+{
+   event_t* ev;
+   size_t count, cap;
+} event_log_t;
+
+/* Trace, as loaded or generated */
+static uint32_t mem_size;
+static uint32_t frame_count;
+static uint8_t* image;
+static uint8_t* writes;          /* concatenated per-frame write lists */
+static size_t writes_len, writes_cap;
+static size_t* frame_offset;     /* offset into writes of each frame */
+
+/* Set */
+static char** memaddrs;
+static unsigned memaddr_count;
+
+static uint8_t* mem;
+static event_log_t* log_target;
+static uint32_t log_frame;
+
+static uint32_t prng_state = 0x2545F491u;
+static uint32_t prng(void)
+{
+   prng_state ^= prng_state << 13;
+   prng_state ^= prng_state >> 17;
+   prng_state ^= prng_state << 5;
+   return prng_state;
+}
+
+static double now_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* CPU time of the calling thread, so that the main thread's share is
+ * measured the same on one core as on several */
+static double cpu_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void burn_us(double us)
+{
+   double end = now_us() + us;
+   while (now_us() < end);
+}
+
+static void put(const void* data, size_t len)
+{
+   if (writes_len + len > writes_cap)
+   {
+      writes_cap = (writes_cap + len) * 2;
+      writes     = (uint8_t*)realloc(writes, writes_cap);
+      if (!writes)
+      {
+         fprintf(stderr, "allocation failed\n");
+         exit(1);
+      }
+   }
+   memcpy(writes + writes_len, data, len);
+   writes_len += len;
+}
+
+static void put_u32(uint32_t v)
+{
+   uint8_t b[4];
+   b[0] = (uint8_t)v; b[1] = (uint8_t)(v >> 8);
+   b[2] = (uint8_t)(v >> 16); b[3] = (uint8_t)(v >> 24);
+   put(b, 4);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Synthetic trace --------------------------------------------------- */
+
+static uint32_t cluster_base[CLUSTERS];
+static uint32_t pointer_table;
+static uint32_t noise_base;
+
+static void layout(void)
+{
+   unsigned i;
+   /* 32 KB slots, so clusters never overlap each other or the rest */
+   for (i = 0; i < CLUSTERS; i++)
+      cluster_base[i] = 0x10000u + i * 0x8000u + (prng() & 0x7) * 0x800u;
+   pointer_table = 0x8000;
+   noise_base    = 0x180000;
+}
+
+static void generate_trace(uint32_t frames)
+{
+   uint32_t f, i;
+   uint8_t noise[NOISE_SIZE];
+
+   mem_size     = MEM_SIZE;
+   frame_count  = frames;
+   image        = (uint8_t*)calloc(1, mem_size);
+   frame_offset = (size_t*)malloc((frames + 1) * sizeof(size_t));
+   if (!image || !frame_offset)
+   {
+      fprintf(stderr, "allocation failed\n");
+      exit(1);
+   }
+
+   layout();
+   for (i = 0; i < POINTERS; i++)
+   {
+      uint32_t target = cluster_base[i % CLUSTERS] + 0x40;
+      memcpy(image + pointer_table + i * 4, &target, 4);
+   }
+
+   for (f = 0; f < frames; f++)
+   {
+      uint32_t count = 0;
+      size_t count_at;
+
+      frame_offset[f] = writes_len;
+      count_at        = writes_len;
+      put_u32(0);
+      if (f == 0)
+         continue;
+
+      /* Frame counter */
+      put_u32(cluster_base[0]); put_u32(4); put_u32(f);
+      count++;
+
+      /* Game state: a few small values per cluster */
+      for (i = 0; i < CLUSTERS; i++)
+      {
+         unsigned k, n = 2 + (prng() & 7);
+         for (k = 0; k < n; k++)
+         {
+            uint8_t v = (uint8_t)(prng() & 15);
+            put_u32(cluster_base[i] + 4 + (prng() % (CLUSTER_SIZE - 4)));
+            put_u32(1);
+            put(&v, 1);
+            count++;
+         }
+      }
+
+      /* A buffer nobody reads, rewritten every frame */
+      for (i = 0; i < NOISE_SIZE; i += 4)
+      {
+         uint32_t v = prng();
+         memcpy(noise + i, &v, 4);
+      }
+      put_u32(noise_base); put_u32(NOISE_SIZE); put(noise, NOISE_SIZE);
+      count++;
+
+      writes[count_at]     = (uint8_t)count;
+      writes[count_at + 1] = (uint8_t)(count >> 8);
+      writes[count_at + 2] = (uint8_t)(count >> 16);
+      writes[count_at + 3] = (uint8_t)(count >> 24);
+   }
+   frame_offset[frames] = writes_len;
+}
+
+static uint32_t hot(void)
+{
+   return cluster_base[prng() % CLUSTERS] + 4 + (prng() % (CLUSTER_SIZE - 8));
+}
+
+static void generate_set(unsigned count)
+{
+   unsigned i;
+   char buf[256];
+
+   memaddrs      = (char**)malloc(count * sizeof(char*));
+   memaddr_count = count;
+   for (i = 0; i < count; i++)
+   {
+      switch (prng() % 6)
+      {
+         case 0:
+            snprintf(buf, sizeof(buf), "0xH%x=%u_0xH%x=%u",
+                  hot(), prng() & 15, hot(), prng() & 15);
+            break;
+         case 1:
+            snprintf(buf, sizeof(buf), "0xX%x>=%u_0xH%x=%u.%u.",
+                  cluster_base[0], 50 + prng() % 200, hot(), prng() & 15,
+                  2 + prng() % 20);
+            break;
+         case 2:
+            {
+               uint32_t a = hot();
+               snprintf(buf, sizeof(buf), "d0xH%x<0xH%x_0xH%x>%u",
+                     a, a, hot(), 8 + (prng() & 7));
+            }
+            break;
+         case 3:
+            snprintf(buf, sizeof(buf), "I:0xX%x_0xH%x=%u_0xH%x<%u",
+                  pointer_table + (prng() % POINTERS) * 4,
+                  prng() % 0x180, prng() & 15, hot(), 4 + (prng() & 3));
+            break;
+         case 4:
+            snprintf(buf, sizeof(buf), "P:0xH%x=%u_0xH%x=%u.%u.",
+                  hot(), prng() & 15, hot(), prng() & 15, 1 + prng() % 4);
+            break;
+         default:
+            snprintf(buf, sizeof(buf), "R:0xM%x=1_0xL%x=%u_0xH%x>%u.%u.",
+                  hot(), hot(), prng() & 15, hot(), 10 + (prng() & 3),
+                  1 + prng() % 6);
+            break;
+      }
+      memaddrs[i] = strdup(buf);
+   }
+}
+
+/* Loading and saving ------------------------------------------------ */
+
+static bool load_trace(const char* path)
+{
+   uint8_t hdr[16];
+   uint32_t f;
+   long size;
+   FILE* fp = fopen(path, "rb");
+
+   if (!fp)
+      return false;
+   if (     fread(hdr, 1, 16, fp) != 16 || memcmp(hdr, "RCMT", 4)
+         || get_u32(hdr + 4) != 1)
+   {
+      fclose(fp);
+      return false;
+   }
+   mem_size    = get_u32(hdr + 8);
+   frame_count = get_u32(hdr + 12);
+   fseek(fp, 0, SEEK_END);
+   size = ftell(fp);
+   fseek(fp, 16, SEEK_SET);
+   if (size < 16 + (long)mem_size || !frame_count)
+   {
+      fclose(fp);
+      return false;
+   }
+
+   image        = (uint8_t*)malloc(mem_size);
+   writes_len   = writes_cap = (size_t)size - 16 - mem_size;
+   writes       = (uint8_t*)malloc(writes_len + 1);
+   frame_offset = (size_t*)malloc((frame_count + 1) * sizeof(size_t));
+   if (     !image || !writes || !frame_offset
+         || fread(image, 1, mem_size, fp) != mem_size
+         || fread(writes, 1, writes_len, fp) != writes_len)
+   {
+      fclose(fp);
+      return false;
+   }
+   fclose(fp);
+
+   /* Index the frames, checking every write lies inside memory */
+   {
+      size_t pos = 0;
+      for (f = 0; f < frame_count; f++)
+      {
+         uint32_t n, w;
+         frame_offset[f] = pos;
+         if (pos + 4 > writes_len)
+            return false;
+         n    = get_u32(writes + pos);
+         pos += 4;
+         for (w = 0; w < n; w++)
+         {
+            uint32_t addr, len;
+            if (pos + 8 > writes_len)
+               return false;
+            addr = get_u32(writes + pos);
+            len  = get_u32(writes + pos + 4);
+            if (     addr > mem_size || len > mem_size - addr
+                  || pos + 8 + len > writes_len)
+               return false;
+            pos += 8 + len;
+         }
+      }
+      frame_offset[frame_count] = pos;
+   }
+   return true;
+}
+
+static bool save_trace(const char* path)
+{
+   uint8_t hdr[16];
+   bool ok;
+   FILE* fp = fopen(path, "wb");
+
+   if (!fp)
+      return false;
+   memcpy(hdr, "RCMT", 4);
+   hdr[4] = 1; hdr[5] = hdr[6] = hdr[7] = 0;
+   memcpy(hdr + 8, &mem_size, 4);
+   memcpy(hdr + 12, &frame_count, 4);
+   ok = fwrite(hdr, 1, 16, fp) == 16
+     && fwrite(image, 1, mem_size, fp) == mem_size
+     && fwrite(writes, 1, frame_offset[frame_count], fp)
+        == frame_offset[frame_count];
+   return (fclose(fp) == 0) && ok;
+}
+
+static bool load_set(const char* path)
+{
+   char line[4096];
+   unsigned cap = 0;
+   FILE* fp     = fopen(path, "r");
+
+   if (!fp)
+      return false;
+   while (fgets(line, sizeof(line), fp))
+   {
+      char* p = strchr(line, '#');
+      if (p)
+         *p = '\0';
+      for (p = line + strlen(line); p > line
+            && (p[-1] == '\n' || p[-1] == '\r' || p[-1] == ' '); p--)
+         p[-1] = '\0';
+      if (!line[0])
+         continue;
+      if (memaddr_count == cap)
+      {
+         cap      = cap ? cap * 2 : 256;
+         memaddrs = (char**)realloc(memaddrs, cap * sizeof(char*));
+      }
+      memaddrs[memaddr_count++] = strdup(line);
+   }
+   fclose(fp);
+   return memaddr_count != 0;
+}
+
+/* Replay ------------------------------------------------------------ */
+
+static void apply_frame(uint32_t f)
+{
+   const uint8_t* p = writes + frame_offset[f];
+   uint32_t n       = get_u32(p);
+
+   p += 4;
+   while (n--)
+   {
+      uint32_t addr = get_u32(p);
+      uint32_t len  = get_u32(p + 4);
+      memcpy(mem + addr, p + 8, len);
+      p += 8 + len;
+   }
+}
+
+static void log_event(const rc_runtime_event_t* e)
+{
+   event_log_t* log = log_target;
+   if (log->count == log->cap)
+   {
+      log->cap = log->cap ? log->cap * 2 : 1024;
+      log->ev  = (event_t*)realloc(log->ev, log->cap * sizeof(event_t));
+   }
+   log->ev[log->count].frame = log_frame;
+   log->ev[log->count].id    = e->id;
+   log->ev[log->count].value = e->value;
+   log->ev[log->count].type  = e->type;
+   log->count++;
+}
+
+static uint32_t le_value(const uint8_t* buf, uint32_t n)
+{
+   uint32_t v = 0;
+   while (n--)
+      v = (v << 8) | buf[n];
+   return v;
+}
+
+static uint32_t peek_live(uint32_t address, uint32_t num_bytes, void* ud)
+{
+   if (address >= mem_size || num_bytes > mem_size - address)
+      return 0;
+   return le_value(mem + address, num_bytes);
+}
+
+static uint32_t peek_learn(uint32_t address, uint32_t num_bytes, void* ud)
+{
+   rcheevos_snapshot_add((rcheevos_snapshot_t*)ud, address, num_bytes);
+   return peek_live(address, num_bytes, NULL);
+}
+
+static unsigned live_reads;
+
+static uint32_t peek_snapshot(uint32_t address, uint32_t num_bytes, void* ud)
+{
+   uint8_t buf[4];
+   uint32_t read;
+
+   if (rcheevos_snapshot_read((rcheevos_snapshot_t*)ud,
+            address, buf, num_bytes, &read))
+      return read == num_bytes ? le_value(buf, num_bytes) : 0;
+   live_reads++;
+   return peek_live(address, num_bytes, NULL);
+}
+
+static uint32_t capture_peek(uint32_t address, uint8_t* buffer,
+      uint32_t num_bytes, void* userdata)
+{
+   if (address >= mem_size)
+      return 0;
+   if (num_bytes > mem_size - address)
+      num_bytes = mem_size - address;
+   memcpy(buffer, mem + address, num_bytes);
+   return num_bytes;
+}
+
+static bool init_runtime(rc_runtime_t* rt)
+{
+   unsigned i;
+   rc_runtime_init(rt);
+   for (i = 0; i < memaddr_count; i++)
+      if (rc_runtime_activate_achievement(rt, i + 1, memaddrs[i], NULL, 0)
+            != RC_OK)
+      {
+         fprintf(stderr, "invalid memaddr on line %u: %s\n", i + 1,
+               memaddrs[i]);
+         return false;
+      }
+   return true;
+}
+
+static void eval_frame(rc_runtime_t* rt, uint32_t f,
+      rc_runtime_peek_t peek, void* ud)
+{
+   if (f && !(f % RESET_EVERY))
+      rc_runtime_reset(rt);
+   log_frame = f;
+   rc_runtime_do_frame(rt, log_event, peek, ud, NULL);
+}
+
+static double run_sync(event_log_t* log, double core_us)
+{
+   uint32_t f;
+   double total = 0;
+   rc_runtime_t rt;
+
+   if (!init_runtime(&rt))
+      exit(1);
+   memcpy(mem, image, mem_size);
+   log_target = log;
+
+   for (f = 0; f < frame_count; f++)
+   {
+      double t0;
+      apply_frame(f);
+      if (core_us > 0)
+         burn_us(core_us);
+      t0 = cpu_us();
+      eval_frame(&rt, f, peek_live, NULL);
+      total += cpu_us() - t0;
+   }
+   rc_runtime_destroy(&rt);
+   return total / frame_count;
+}
+
+/* The worker mirrors rcheevos_bg_thread() */
+static struct
+{
+   slock_t* lock;
+   scond_t* cond;
+   rc_runtime_t* rt;
+   rcheevos_snapshot_t* snapshot;
+   uint32_t frame;
+   bool busy, quit;
+} job;
+
+static void worker(void* userdata)
+{
+   slock_lock(job.lock);
+   for (;;)
+   {
+      while (!job.busy && !job.quit)
+         scond_wait(job.cond, job.lock);
+      if (job.quit)
+         break;
+      slock_unlock(job.lock);
+
+      eval_frame(job.rt, job.frame, peek_snapshot, job.snapshot);
+
+      slock_lock(job.lock);
+      job.busy = false;
+      scond_broadcast(job.cond);
+   }
+   slock_unlock(job.lock);
+}
+
+static double run_worker(event_log_t* log, double core_us,
+      double* wait_avg, size_t* bytes_avg, uint32_t* pages)
+{
+   uint32_t f;
+   double total  = 0;
+   double waited = 0;
+   size_t bytes  = 0;
+   sthread_t* thread;
+   rc_runtime_t rt;
+
+   if (!init_runtime(&rt))
+      exit(1);
+   memcpy(mem, image, mem_size);
+   log_target   = log;
+   live_reads   = 0;
+   job.rt       = &rt;
+   job.busy     = false;
+   job.quit     = false;
+   job.lock     = slock_new();
+   job.cond     = scond_new();
+   job.snapshot = rcheevos_snapshot_new(mem_size);
+   thread       = sthread_create(worker, NULL);
+   if (!job.lock || !job.cond || !job.snapshot || !thread)
+   {
+      fprintf(stderr, "could not start the worker\n");
+      exit(1);
+   }
+
+   for (f = 0; f < frame_count; f++)
+   {
+      double t0, t1, c0;
+
+      /* "Emulating" frame f, while the worker evaluates f - 1 */
+      apply_frame(f);
+      if (core_us > 0)
+         burn_us(core_us);
+
+      c0 = cpu_us();
+      t0 = now_us();
+      slock_lock(job.lock);
+      while (job.busy)
+         scond_wait(job.cond, job.lock);
+      slock_unlock(job.lock);
+      t1      = now_us();
+      waited += t1 - t0;
+      rcheevos_snapshot_commit_misses(job.snapshot);
+
+      if (f == 0)
+      {
+         /* Warm-up: one synchronous frame learns the pages */
+         eval_frame(&rt, f, peek_learn, job.snapshot);
+         total += cpu_us() - c0;
+         continue;
+      }
+
+      bytes += rcheevos_snapshot_capture(job.snapshot, capture_peek, NULL);
+      rcheevos_snapshot_swap(job.snapshot);
+
+      slock_lock(job.lock);
+      job.frame = f;
+      job.busy  = true;
+      scond_broadcast(job.cond);
+      slock_unlock(job.lock);
+      total += cpu_us() - c0;
+   }
+
+   slock_lock(job.lock);
+   while (job.busy)
+      scond_wait(job.cond, job.lock);
+   job.quit = true;
+   scond_broadcast(job.cond);
+   slock_unlock(job.lock);
+   sthread_join(thread);
+
+   *wait_avg  = waited / frame_count;
+   *bytes_avg = frame_count > 1 ? bytes / (frame_count - 1) : 0;
+   *pages     = rcheevos_snapshot_page_count(job.snapshot);
+
+   rcheevos_snapshot_free(job.snapshot);
+   scond_free(job.cond);
+   slock_free(job.lock);
+   rc_runtime_destroy(&rt);
+   return total / frame_count;
+}
+
+int main(int argc, char** argv)
+{
+   const char* trace_path = NULL;
+   const char* set_path   = NULL;
+   const char* save_path  = NULL;
+   unsigned frames        = 1200;
+   unsigned cheevos       = 2000;
+   double core_us         = 1000;
+   event_log_t sync_log   = { NULL, 0, 0 };
+   event_log_t bg_log     = { NULL, 0, 0 };
+   double sync_us, bg_us, wait_us;
+   size_t bytes, i, triggered = 0, mismatch = (size_t)-1;
+   uint32_t pages;
+   int a;
+   int bad                = 0;
+
+   for (a = 1; a + 1 < argc; a += 2)
+   {
+      if (!strcmp(argv[a], "--frames"))
+         frames = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--cheevos"))
+         cheevos = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--core-us"))
+         core_us = atof(argv[a + 1]);
+      else if (!strcmp(argv[a], "--trace"))
+         trace_path = argv[a + 1];
+      else if (!strcmp(argv[a], "--set"))
+         set_path = argv[a + 1];
+      else if (!strcmp(argv[a], "--save"))
+         save_path = argv[a + 1];
+      else
+      {
+         fprintf(stderr, "unknown option %s\n", argv[a]);
+         return 1;
+      }
+   }
+   if (a < argc || frames < 2 || !cheevos)
+   {
+      fprintf(stderr, "usage: %s [--frames N] [--cheevos N] [--core-us N]"
+            " [--trace FILE] [--set FILE] [--save FILE]\n", argv[0]);
+      return 1;
+   }
+
+   if (trace_path)
+   {
+      if (!load_trace(trace_path))
+      {
+         fprintf(stderr, "%s: not a usable trace\n", trace_path);
+         return 1;
+      }
+   }
+   else
+      generate_trace(frames);
+
+   if (set_path)
+   {
+      if (!load_set(set_path))
+      {
+         fprintf(stderr, "%s: no achievements\n", set_path);
+         return 1;
+      }
+   }
+   else if (trace_path)
+   {
+      fprintf(stderr, "a recorded trace needs --set\n");
+      return 1;
+   }
+   else
+      generate_set(cheevos);
+
+   if (save_path && !save_trace(save_path))
+   {
+      fprintf(stderr, "%s: write failed\n", save_path);
+      return 1;
+   }
+
+   if (!(mem = (uint8_t*)malloc(mem_size)))
+      return 1;
+
+   sync_us = run_sync(&sync_log, core_us);
+   bg_us   = run_worker(&bg_log, core_us, &wait_us, &bytes, &pages);
+
+   for (i = 0; i < sync_log.count; i++)
+      if (sync_log.ev[i].type == RC_RUNTIME_EVENT_ACHIEVEMENT_TRIGGERED)
+         triggered++;
+   for (i = 0; i < sync_log.count && i < bg_log.count; i++)
+      if (     sync_log.ev[i].frame != bg_log.ev[i].frame
+            || sync_log.ev[i].id    != bg_log.ev[i].id
+            || sync_log.ev[i].value != bg_log.ev[i].value
+            || sync_log.ev[i].type  != bg_log.ev[i].type)
+      {
+         mismatch = i;
+         break;
+      }
+   if (mismatch == (size_t)-1 && sync_log.count != bg_log.count)
+      mismatch = i;
+
+   printf("%u frames, %u KB memory, %u achievements, %.0f us emulation per frame\n",
+         frame_count, mem_size / 1024, memaddr_count, core_us);
+   printf("  sync    %8.1f us/frame main thread CPU\n", sync_us);
+   printf("  worker  %8.1f us/frame main thread CPU, %.1f us blocked, "
+         "%u pages, %lu bytes captured per frame\n",
+         bg_us, wait_us, pages, (unsigned long)bytes);
+   printf("  %lu events, %lu triggers, %u reads outside the snapshot\n",
+         (unsigned long)sync_log.count, (unsigned long)triggered, live_reads);
+
+   if (mismatch != (size_t)-1)
+   {
+      if (mismatch < sync_log.count && mismatch < bg_log.count)
+         printf("  MISMATCH at event %lu: frame %u id %u type %u vs "
+               "frame %u id %u type %u\n", (unsigned long)mismatch,
+               sync_log.ev[mismatch].frame, sync_log.ev[mismatch].id,
+               sync_log.ev[mismatch].type, bg_log.ev[mismatch].frame,
+               bg_log.ev[mismatch].id, bg_log.ev[mismatch].type);
+      else
+         printf("  MISMATCH: %lu events vs %lu\n",
+               (unsigned long)sync_log.count, (unsigned long)bg_log.count);
+      bad = 1;
+   }
+   else if (!triggered && !trace_path)
+   {
+      printf("  synthetic set never triggered\n");
+      bad = 1;
+   }
+   else
+      printf("  events identical\n");
+
+   for (i = 0; i < memaddr_count; i++)
+      free(memaddrs[i]);
+   free(memaddrs);
+   free(sync_log.ev);
+   free(bg_log.ev);
+   free(image);
+   free(writes);
+   free(frame_offset);
+   free(mem);
+   return bad;
+}
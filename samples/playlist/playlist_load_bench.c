@@ -0,0 +1,286 @@
+/* Load benchmark for playlist.c's JSON reader, compiled from the
+ * shipping translation unit.
+ *
+ * A playlist shaped like a scanned collection is written out and read
+ * back with playlist_init() --runs times.  Every entry has a unique path,
+ * label and crc32, while core_path, core_name and db_name cycle through
+ * --cores cores and --dbs databases, as they do in a real collection.
+ * Reported per load:
+ *
+ *   time     wall time of playlist_init(), best and median of the runs
+ *   allocs   calls to malloc/calloc/realloc/strdup made during the load,
+ *            counted by wrapping them at link time (GNU ld --wrap)
+ *   heap     bytes the allocator holds for the loaded playlist, i.e. in
+ *            use after the load minus in use before it (glibc only)
+ *   rss      growth of the peak resident set over the first load
+ *
+ * --file reads an existing playlist instead of generating one.
+ *
+ * Usage:
+ *   playlist_load_bench [--entries N] [--cores N] [--dbs N] [--runs N]
+ *                       [--file FILE]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <boolean.h>
+#include <libretro.h>
+
+#include "../../playlist.h"
+#include "../../verbosity.h"
+#include "../../core_info.h"
+
+/* ------------------------------------------------------------------ */
+/* Stubs, as in playlist_parity_test.c                                */
+/* ------------------------------------------------------------------ */
+
+bool core_info_find(const char *core_path, core_info_t **core_info)
+{
+   (void)core_path;
+   if (core_info)
+      *core_info = NULL;
+   return false;
+}
+
+bool core_info_core_file_id_is_equal(const char *core_path_a,
+      const char *core_path_b)
+{
+   (void)core_path_a;
+   (void)core_path_b;
+   return false;
+}
+
+bool play_feature_delivery_enabled(void)
+{
+   return false;
+}
+
+void frontend_driver_attach_console(void) { }
+void frontend_driver_detach_console(void) { }
+
+/* ------------------------------------------------------------------ */
+/* Allocation counting                                                */
+/* ------------------------------------------------------------------ */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+char *__real_strdup(const char *s);
+
+static unsigned long alloc_calls;
+
+void *__wrap_malloc(size_t size)
+{
+   alloc_calls++;
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+   alloc_calls++;
+   return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   alloc_calls++;
+   return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *s)
+{
+   alloc_calls++;
+   return __real_strdup(s);
+}
+
+static long heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+   struct mallinfo2 mi = mallinfo2();
+   /* Large blocks are mmapped and only counted in hblkhd */
+   return (long)(mi.uordblks + mi.hblkhd);
+#else
+   return -1;
+#endif
+}
+
+static long peak_rss_kb(void)
+{
+   struct rusage ru;
+   if (getrusage(RUSAGE_SELF, &ru) != 0)
+      return -1;
+   return ru.ru_maxrss;
+}
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+   double x = *(const double*)a;
+   double y = *(const double*)b;
+   return (x > y) - (x < y);
+}
+
+/* ------------------------------------------------------------------ */
+
+static const char *core_names[] = {
+   "Snes9x", "Genesis Plus GX", "Mesen", "mGBA", "Beetle PSX HW",
+   "Mupen64Plus-Next", "FinalBurn Neo", "PPSSPP", "Flycast", "Gambatte",
+   "Stella", "Beetle PCE FAST", "DeSmuME", "Dolphin", "ProSystem",
+   "Handy"
+};
+#define CORE_NAME_COUNT (sizeof(core_names) / sizeof(core_names[0]))
+
+static bool write_collection(const char *path, unsigned entries,
+      unsigned cores, unsigned dbs)
+{
+   unsigned i;
+   FILE *f = fopen(path, "wb");
+
+   if (!f)
+      return false;
+
+   fprintf(f, "{\n  \"version\": \"1.5\",\n"
+         "  \"default_core_path\": \"\",\n"
+         "  \"default_core_name\": \"\",\n"
+         "  \"base_content_directory\": \"/home/user/roms\",\n"
+         "  \"items\": [\n");
+   for (i = 0; i < entries; i++)
+   {
+      unsigned core = i % cores;
+      unsigned db   = i % dbs;
+      fprintf(f,
+            "    {\n"
+            "      \"path\": \"/home/user/roms/system%02u/Game Title %06u (USA) (Rev 1).zip#Game Title %06u (USA) (Rev 1).bin\",\n"
+            "      \"label\": \"Game Title %06u (USA) (Rev 1)\",\n"
+            "      \"core_path\": \"/home/user/.config/retroarch/cores/core%02u_libretro.so\",\n"
+            "      \"core_name\": \"%s\",\n"
+            "      \"crc32\": \"%08X|crc\",\n"
+            "      \"db_name\": \"Database Number %02u - Console.lpl\"\n"
+            "    }%s\n",
+            db, i, i, i, core, core_names[core % CORE_NAME_COUNT],
+            (unsigned)(i * 2654435761u), db,
+            (i + 1 < entries) ? "," : "");
+   }
+   fprintf(f, "  ]\n}\n");
+   fclose(f);
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   int a;
+   unsigned r;
+   playlist_config_t config;
+   char path[256];
+   double *times;
+   unsigned long allocs = 0;
+   long heap_delta      = -1;
+   long rss_before, rss_after;
+   size_t loaded        = 0;
+   unsigned entries     = 30000;
+   unsigned cores       = 6;
+   unsigned dbs         = 4;
+   unsigned runs        = 5;
+   const char *file     = NULL;
+
+   for (a = 1; a + 1 < argc; a += 2)
+   {
+      if (!strcmp(argv[a], "--entries"))
+         entries = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--cores"))
+         cores = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--dbs"))
+         dbs = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--runs"))
+         runs = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--file"))
+         file = argv[a + 1];
+      else
+         break;
+   }
+   if (a < argc || !entries || !cores || !dbs || !runs)
+   {
+      fprintf(stderr, "usage: %s [--entries N] [--cores N] [--dbs N]"
+            " [--runs N] [--file FILE]\n", argv[0]);
+      return 1;
+   }
+
+   if (file)
+      snprintf(path, sizeof(path), "%s", file);
+   else
+   {
+      snprintf(path, sizeof(path), "/tmp/playlist_bench_%ld.lpl",
+            (long)getpid());
+      if (!write_collection(path, entries, cores, dbs))
+      {
+         fprintf(stderr, "cannot write %s\n", path);
+         return 1;
+      }
+   }
+
+   memset(&config, 0, sizeof(config));
+   config.capacity = 1 << 20;
+   playlist_config_set_path(&config, path);
+
+   if (!(times = (double*)calloc(runs, sizeof(*times))))
+      return 1;
+
+   rss_before = peak_rss_kb();
+   for (r = 0; r < runs; r++)
+   {
+      playlist_t *playlist;
+      unsigned long calls = alloc_calls;
+      long heap           = heap_in_use();
+      double t0           = now_ms();
+
+      playlist            = playlist_init(&config);
+      times[r]            = now_ms() - t0;
+
+      if (!playlist)
+      {
+         fprintf(stderr, "playlist_init failed\n");
+         return 1;
+      }
+      if (r == 0)
+      {
+         allocs     = alloc_calls - calls;
+         if (heap >= 0)
+            heap_delta = heap_in_use() - heap;
+         loaded     = playlist_size(playlist);
+      }
+      playlist_free(playlist);
+   }
+   rss_after = peak_rss_kb();
+
+   qsort(times, runs, sizeof(*times), cmp_double);
+
+   printf("entries %u, %u runs\n", (unsigned)loaded, runs);
+   printf("  time    best %.2f ms, median %.2f ms\n",
+         times[0], times[runs / 2]);
+   printf("  allocs  %lu (%.2f per entry)\n", allocs,
+         loaded ? (double)allocs / loaded : 0.0);
+   if (heap_delta >= 0)
+      printf("  heap    %.2f MiB (%.0f bytes per entry)\n",
+            heap_delta / (1024.0 * 1024.0),
+            loaded ? (double)heap_delta / loaded : 0.0);
+   printf("  rss     +%.2f MiB peak\n", (rss_after - rss_before) / 1024.0);
+
+   free(times);
+   if (!file)
+      unlink(path);
+   return 0;
+}
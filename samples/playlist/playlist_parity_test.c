@@ -39,6 +39,7 @@
 #include <unistd.h>
 
 #include <boolean.h>
+#include <compat/strl.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
 #include <vfs/vfs_implementation.h>
@@ -503,6 +504,103 @@ static void lane_capacity(void)
 }
 
 
+/* Entries read from JSON keep their strings in the playlist's string
+ * blocks, with repeated core/database values shared between entries.
+ * Updating, deleting and evicting such entries must neither free a
+ * block string nor disturb the entries still sharing it, and a write
+ * must round-trip the lot. */
+static const char json_shared[] =
+"{\n"
+"  \"version\": \"1.5\",\n"
+"  \"items\": [\n"
+"    { \"path\": \"/g/a.sfc\", \"label\": \"A\", \"core_path\": \"/cores/x.so\","
+"      \"core_name\": \"X\", \"db_name\": \"SNES.lpl\", \"crc32\": \"00000001|crc\" },\n"
+"    { \"path\": \"/g/b.sfc\", \"label\": \"B\", \"core_path\": \"/cores/x.so\","
+"      \"core_name\": \"X\", \"db_name\": \"SNES.lpl\", \"crc32\": \"00000002|crc\" },\n"
+"    { \"path\": \"/g/c.sfc\", \"label\": \"C\", \"core_path\": \"/cores/x.so\","
+"      \"core_name\": \"X\", \"core_name\": \"Y\", \"db_name\": \"SNES.lpl\" },\n"
+"    { \"path\": \"/g/d.sfc\", \"label\": \"D\", \"core_path\": \"/cores/x.so\","
+"      \"core_name\": \"X\", \"db_name\": \"SNES.lpl\" }\n"
+"  ]\n"
+"}\n";
+
+static void lane_shared_strings(void)
+{
+   unsigned had = failures;
+   char path[512];
+   playlist_config_t config;
+   struct playlist_entry update;
+   const struct playlist_entry *a = NULL;
+   const struct playlist_entry *b = NULL;
+   playlist_t *pl                 = NULL;
+   playlist_t *back               = NULL;
+
+   snprintf(path, sizeof(path), "%s/shared.lpl", fixture_dir);
+   CHECK(write_whole(path, json_shared), "fixture write");
+   config_defaults(&config, path);
+
+   if (!(pl = playlist_init(&config)))
+   {
+      CHECK(false, "shared: init failed");
+      return;
+   }
+   CHECK(playlist_size(pl) == 4, "shared: size %u",
+         (unsigned)playlist_size(pl));
+
+   playlist_get_index(pl, 0, &a);
+   playlist_get_index(pl, 1, &b);
+   CHECK(a && b && a->core_path == b->core_path
+         && a->db_name == b->db_name,
+         "shared: repeated values are not shared");
+   CHECK(a && b && a->path != b->path && !streq(a->crc32, b->crc32),
+         "shared: unique values were merged");
+   playlist_get_index(pl, 2, &a);
+   CHECK(a && streq(a->core_name, "Y"),
+         "shared: repeated member keeps the last value");
+
+   /* Replace a shared value on one entry only */
+   memset(&update, 0, sizeof(update));
+   update.core_name = (char*)"Z";
+   update.label     = (char*)"A2";
+   playlist_update(pl, 0, &update);
+   playlist_get_index(pl, 0, &a);
+   playlist_get_index(pl, 1, &b);
+   CHECK(a && streq(a->core_name, "Z") && streq(a->label, "A2"),
+         "shared: update not applied");
+   CHECK(b && streq(b->core_name, "X"),
+         "shared: update leaked into another entry");
+
+   playlist_delete_index(pl, 1);
+   CHECK(playlist_size(pl) == 3, "shared: delete");
+
+   playlist_write_file(pl);
+   playlist_free(pl);
+
+   if (!(back = playlist_init(&config)))
+   {
+      CHECK(false, "shared: reload failed");
+      return;
+   }
+   CHECK(playlist_size(back) == 3, "shared: reload size %u",
+         (unsigned)playlist_size(back));
+   playlist_get_index(back, 0, &a);
+   CHECK(a && streq(a->path, "/g/a.sfc") && streq(a->label, "A2")
+         && streq(a->core_name, "Z") && streq(a->core_path, "/cores/x.so")
+         && streq(a->db_name, "SNES.lpl") && streq(a->crc32, "00000001|crc"),
+         "shared: entry 0 did not round-trip");
+   playlist_get_index(back, 2, &a);
+   CHECK(a && streq(a->path, "/g/d.sfc") && streq(a->core_name, "X"),
+         "shared: entry 2 did not round-trip");
+
+   /* Cleared, then refilled from the heap */
+   playlist_clear(back);
+   CHECK(playlist_size(back) == 0, "shared: clear");
+   playlist_free(back);
+
+   if (failures == had)
+      fprintf(stderr, "[pass] shared strings lane\n");
+}
+
 /* ------------------------------------------------------------------ */
 /* Budgeted lanes: the resumable API must produce byte-identical      */
 /* playlists to the blocking path, yielding along the way.            */
@@ -1412,6 +1510,7 @@ int main(int argc, char *argv[])
    lane_compressed();
    lane_missing();
    lane_capacity();
+   lane_shared_strings();
    lane_budgeted_json();
    lane_budgeted_old_format();
    lane_budgeted_autofix();
@@ -0,0 +1,393 @@
+/* Rewind buffer benchmark, compiled from the shipping state_manager.c
+ * and driven through its public entry points, as the runloop drives it.
+ *
+ * A trace of savestates is captured into the rewind buffer once per
+ * frame, then the buffer is sought back --seek frames and rewound a
+ * further few frames one at a time. Every state that comes back out is
+ * checked against the trace. Each trace runs three ways: patches only,
+ * patches through Zstandard, and Zstandard with a keyframe every
+ * --keyframes captures. Reported per run:
+ *
+ *   capture   time per frame to serialize, diff, compress and insert,
+ *             all on this thread (the capture thread is off)
+ *   entry     average bytes of the buffer per captured frame
+ *   s/MB      seconds of history per MB of buffer at 60 fps, as the
+ *             statistics overlay reports it
+ *   seek      time to restore the state --seek frames back
+ *
+ * The built-in traces imitate the shape of three reference cores'
+ * states - size, how much work RAM moves per frame, how much video
+ * memory is rewritten, and a patch of sample data that does not
+ * compress - but are generated, so they are only a guide. Real traces
+ * can be given with --trace: a file of raw savestates of --state-size
+ * bytes each, one per frame, as written by a core's retro_serialize.
+ *
+ * Usage:
+ *   rewind_history_bench [--frames N] [--buffer MB] [--seek N]
+ *                        [--keyframes N] [--trace FILE --state-size N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <boolean.h>
+#include <libretro.h>
+
+#include "../../../state_manager.h"
+#include "../../../msg_hash.h"
+#include "../../../core_info.h"
+#include "../../../content.h"
+#include "../../../retroarch.h"
+#include "../../../runloop.h"
+#include "../../../audio/audio_driver.h"
+
+/* ------------------------------------------------------------------ */
+/* Stubs: the frontend around the state manager                       */
+/* ------------------------------------------------------------------ */
+
+static uint8_t *cur_state;
+static size_t cur_size;
+static uint64_t loaded_hash;
+static core_info_t dummy_core_info;
+
+const char *msg_hash_to_str(enum msg_hash_enums msg)
+{
+   (void)msg;
+   return "";
+}
+
+void RARCH_LOG(const char *fmt, ...) { (void)fmt; }
+void RARCH_WARN(const char *fmt, ...) { (void)fmt; }
+void RARCH_ERR(const char *fmt, ...)
+{
+   fprintf(stderr, "state manager error: %s", fmt);
+}
+
+bool core_info_get_current_core(core_info_t **core)
+{
+   *core = &dummy_core_info;
+   return true;
+}
+
+bool core_info_current_supports_rewind(void) { return true; }
+bool audio_driver_has_callback(void) { return false; }
+void audio_driver_frame_is_reverse(void) { }
+void audio_driver_setup_rewind(void) { }
+void audio_driver_sample(int16_t left, int16_t right) { }
+size_t audio_driver_sample_batch(const int16_t *data, size_t frames)
+{
+   return frames;
+}
+void audio_driver_sample_rewind(int16_t left, int16_t right) { }
+size_t audio_driver_sample_batch_rewind(const int16_t *data, size_t frames)
+{
+   return frames;
+}
+
+void runloop_msg_queue_push(const char *msg, size_t len,
+      unsigned prio, unsigned duration, bool flush,
+      char *title, enum message_queue_icon icon,
+      enum message_queue_category category) { }
+
+bool retroarch_ctl(enum rarch_ctl_state state, void *data)
+{
+   return false;
+}
+
+size_t content_get_serialized_size_rewind(void)
+{
+   return cur_size;
+}
+
+static uint64_t hash_state(const uint8_t *data, size_t len)
+{
+   size_t i;
+   uint64_t h = 0x9e3779b97f4a7c15ull;
+   for (i = 0; i + 8 <= len; i += 8)
+   {
+      uint64_t w;
+      memcpy(&w, data + i, 8);
+      h = (h ^ w) * 0x100000001b3ull;
+   }
+   for (; i < len; i++)
+      h = (h ^ data[i]) * 0x100000001b3ull;
+   return h;
+}
+
+bool content_serialize_state_rewind(void *buffer, size_t buffer_size)
+{
+   memcpy(buffer, cur_state, buffer_size);
+   return true;
+}
+
+bool content_deserialize_state(const void *data, size_t size)
+{
+   loaded_hash = hash_state((const uint8_t*)data, size);
+   return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Traces                                                             */
+/* ------------------------------------------------------------------ */
+
+typedef struct trace_model
+{
+   const char *name;
+   size_t size;          /* bytes per state */
+   size_t ram;           /* work RAM at the start of the state */
+   unsigned touched;     /* words of work RAM that move per frame */
+   unsigned runs;        /* stretches of video memory rewritten */
+   unsigned run_len;     /* bytes per stretch */
+   unsigned noisy;       /* bytes of sample data per frame */
+} trace_model_t;
+
+static const trace_model_t models[] = {
+   /* Snes9x: 128 KiB WRAM, 64 KiB VRAM, APU and the rest */
+   { "snes9x",     442 * 1024,      128 * 1024,  400,  8,  256,  512 },
+   /* mGBA: 256 KiB EWRAM + IWRAM, 96 KiB VRAM */
+   { "mgba",       400 * 1024,      288 * 1024,  600,  6,  512, 1024 },
+   /* Beetle PSX: 2 MiB RAM, 1 MiB VRAM, SPU RAM */
+   { "beetle-psx", 4400 * 1024, 2 * 1024 * 1024, 3000, 40, 2048, 4096 },
+};
+
+#define MODEL_COUNT (sizeof(models) / sizeof(models[0]))
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+   rng_state = rng_state * 1664525u + 1013904223u;
+   return rng_state >> 8;
+}
+
+static void trace_start(const trace_model_t *m, uint8_t *s)
+{
+   size_t i;
+   rng_state = 1;
+   /* Mostly small values and zeroes, as memory is */
+   for (i = 0; i < m->size; i++)
+      s[i] = (rng() % 5) ? 0 : (uint8_t)(rng() & 0x1f);
+}
+
+static void trace_step(const trace_model_t *m, uint8_t *s, unsigned frame)
+{
+   unsigned i, j;
+   size_t video = m->ram;
+   size_t rest  = m->size - m->ram;
+
+   /* Object positions and timers creep along */
+   for (i = 0; i < m->touched; i++)
+   {
+      size_t at = (rng() % (m->ram / 2)) * 2;
+      s[at]    += (uint8_t)(1 + (rng() & 3));
+   }
+   /* A frame counter */
+   memcpy(s + 16, &frame, sizeof(frame));
+   /* Tiles and sprites redrawn from a handful of patterns */
+   for (i = 0; i < m->runs; i++)
+   {
+      size_t at       = video + rng() % (rest - m->run_len - m->noisy);
+      uint8_t pattern = (uint8_t)(rng() & 7);
+      for (j = 0; j < m->run_len; j++)
+         s[at + j] = (uint8_t)(pattern * 17 + (j & 15));
+   }
+   /* Audio samples at the end do not compress */
+   for (i = 0; i < m->noisy; i++)
+      s[m->size - m->noisy + i] = (uint8_t)rng();
+}
+
+/* ------------------------------------------------------------------ */
+
+static double now_ms(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+typedef struct run_mode
+{
+   const char *name;
+   bool compress;
+   bool keyframes;
+} run_mode_t;
+
+static const run_mode_t modes[] = {
+   { "patch",          false, false },
+   { "zstd",           true,  false },
+   { "zstd+keyframes", true,  true  },
+};
+
+#define MODE_COUNT (sizeof(modes) / sizeof(modes[0]))
+
+/* Frames to rewind one at a time after the seek, each one checked */
+#define STEP_BACK 30
+
+static FILE *trace_file;
+
+static bool next_state(const trace_model_t *m, unsigned frame)
+{
+   if (trace_file)
+      return fread(cur_state, 1, cur_size, trace_file) == cur_size;
+   if (frame == 0)
+      trace_start(m, cur_state);
+   else
+      trace_step(m, cur_state, frame);
+   return true;
+}
+
+static int run(const char *name, const trace_model_t *m,
+      const run_mode_t *mode, unsigned frames, size_t buffer,
+      unsigned seek, unsigned keyframes)
+{
+   struct state_manager_rewind_state rewind_st;
+   state_manager_stats_t stats;
+   char msg[64];
+   unsigned t, f, done, i;
+   unsigned captured = 0;
+   double capture_ms = 0.0;
+   double seek_ms, seconds, mb;
+   int errors        = 0;
+   uint64_t *hashes  = (uint64_t*)calloc(frames, sizeof(*hashes));
+
+   if (trace_file)
+      rewind(trace_file);
+   if (!hashes || !next_state(m, 0))
+      return 1;
+   hashes[captured++] = hash_state(cur_state, cur_size);
+
+   memset(&rewind_st, 0, sizeof(rewind_st));
+   state_manager_event_init(&rewind_st, (unsigned)buffer, false,
+         mode->compress, mode->keyframes ? keyframes : 0);
+   if (!rewind_st.state)
+   {
+      fprintf(stderr, "state_manager_event_init failed\n");
+      return 1;
+   }
+   /* The first check only arms the hotkey */
+   state_manager_check_rewind(&rewind_st, NULL, false, 1, false,
+         msg, sizeof(msg), &t);
+
+   for (f = 1; f < frames && next_state(m, f); f++)
+   {
+      double t0;
+      hashes[captured++] = hash_state(cur_state, cur_size);
+      t0          = now_ms();
+      state_manager_check_rewind(&rewind_st, NULL, false, 1, false,
+            msg, sizeof(msg), &t);
+      capture_ms += now_ms() - t0;
+   }
+
+   state_manager_get_stats(&rewind_st, &stats);
+   seconds = stats.entries / 60.0;
+   mb      = stats.used / 1000000.0;
+
+   if (seek > stats.entries)
+      seek = stats.entries;
+   seek_ms = now_ms();
+   done    = state_manager_seek(&rewind_st, seek);
+   seek_ms = now_ms() - seek_ms;
+   if (done != seek || loaded_hash != hashes[captured - done])
+   {
+      fprintf(stderr, "%s/%s: seek %u came back wrong\n",
+            name, mode->name, seek);
+      errors++;
+   }
+
+   for (i = 0; i < STEP_BACK && done < stats.entries; i++)
+   {
+      if (!state_manager_check_rewind(&rewind_st, NULL, true, 1, false,
+               msg, sizeof(msg), &t))
+         break;
+      if (loaded_hash != hashes[captured - ++done])
+      {
+         fprintf(stderr, "%s/%s: rewind to frame %u came back wrong\n",
+               name, mode->name, captured - done);
+         errors++;
+         break;
+      }
+   }
+
+   printf("  %-15s %7.3f ms %9.0f B %8.1f %9.2f ms%s\n",
+         mode->name,
+         capture_ms / (captured - 1),
+         stats.entries ? (double)stats.used / stats.entries : 0.0,
+         mb > 0.0 ? seconds / mb : 0.0,
+         seek_ms,
+         errors ? "  MISMATCH" : "");
+
+   state_manager_event_deinit(&rewind_st, NULL);
+   free(hashes);
+   return errors;
+}
+
+int main(int argc, char *argv[])
+{
+   int a;
+   unsigned i, j;
+   int errors           = 0;
+   unsigned frames      = 1800;
+   unsigned buffer_mb   = 64;
+   unsigned seek        = 600;
+   unsigned keyframes   = 60;
+   unsigned state_size  = 0;
+   const char *trace    = NULL;
+
+   for (a = 1; a + 1 < argc; a += 2)
+   {
+      if (!strcmp(argv[a], "--frames"))
+         frames = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--buffer"))
+         buffer_mb = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--seek"))
+         seek = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--keyframes"))
+         keyframes = (unsigned)atoi(argv[a + 1]);
+      else if (!strcmp(argv[a], "--trace"))
+         trace = argv[a + 1];
+      else if (!strcmp(argv[a], "--state-size"))
+         state_size = (unsigned)atoi(argv[a + 1]);
+      else
+         break;
+   }
+   if (a < argc || frames < 2 || !buffer_mb || !seek || !keyframes
+         || (trace && !state_size))
+   {
+      fprintf(stderr, "usage: %s [--frames N] [--buffer MB] [--seek N]"
+            " [--keyframes N] [--trace FILE --state-size N]\n", argv[0]);
+      return 1;
+   }
+
+   printf("%u frames into %u MB, seek back %u, keyframe every %u\n",
+         frames, buffer_mb, seek, keyframes);
+   printf("  %-15s %10s %11s %8s %12s\n",
+         "", "capture", "entry", "s/MB", "seek");
+
+   for (i = 0; i < (trace ? 1 : MODEL_COUNT); i++)
+   {
+      const trace_model_t *m = trace ? NULL : &models[i];
+      const char *name       = trace ? trace : m->name;
+
+      cur_size = trace ? state_size : m->size;
+      if (!(cur_state = (uint8_t*)malloc(cur_size)))
+         return 1;
+      if (trace && !(trace_file = fopen(trace, "rb")))
+      {
+         fprintf(stderr, "cannot open %s\n", trace);
+         return 1;
+      }
+
+      printf("%s, %.0f KiB states\n", name, cur_size / 1024.0);
+      for (j = 0; j < MODE_COUNT; j++)
+         errors += run(name, m, &modes[j], frames,
+               (size_t)buffer_mb * 1000000, seek, keyframes);
+
+      if (trace_file)
+         fclose(trace_file);
+      free(cur_state);
+   }
+
+   return errors ? 1 : 0;
+}
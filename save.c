@@ -23,6 +23,7 @@
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
 #include <streams/rzip_stream.h>
+#include <encodings/crc32.h>
 #include <rthreads/rthreads.h>
 #include <file/file_path.h>
 #include <string/stdstring.h>
@@ -32,6 +33,7 @@
 #include "config.h"
 #endif
 
+#include "autosave.h"
 #include "content.h"
 #include "core.h"
 #include "core_info.h"
@@ -51,178 +53,493 @@ struct ram_type
 
 static struct string_list *task_save_files = NULL;
 
+/* SRAM journal.
+ *
+ * Autosave does not rewrite a save file every time save RAM changes.
+ * It appends the ranges that changed to '<save>.journal' and syncs
+ * that; only every so often, and when autosave stops, is the whole
+ * save written again - to a temporary file, renamed over the old one -
+ * after which the journal is deleted.
+ *
+ * A journal is a header followed by records, all little endian:
+ *
+ *   header : "RAJ1", u32 size of the save RAM
+ *   record : u32 offset, u32 length, u32 CRC-32 of the previous eight
+ *            bytes and the data, then the data
+ *
+ * Records hold the whole new contents of a range, so replaying a
+ * journal onto the save it was compacted into changes nothing, and a
+ * crash between the rename and the delete is harmless. A crash during
+ * an append leaves a torn last record, which fails its CRC; reading
+ * stops there. */
+#define SRAM_JOURNAL_EXT         ".journal"
+#define SRAM_JOURNAL_MAGIC       "RAJ1"
+#define SRAM_JOURNAL_HEADER_SIZE 8
+#define SRAM_JOURNAL_RECORD_SIZE 12
+
+static void sram_journal_put32(uint8_t *s, uint32_t val)
+{
+   s[0] = (uint8_t)(val);
+   s[1] = (uint8_t)(val >>  8);
+   s[2] = (uint8_t)(val >> 16);
+   s[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t sram_journal_get32(const uint8_t *s)
+{
+   return  (uint32_t)s[0]
+         | ((uint32_t)s[1] <<  8)
+         | ((uint32_t)s[2] << 16)
+         | ((uint32_t)s[3] << 24);
+}
+
+static void sram_journal_path(char *s, size_t len, const char *path)
+{
+   size_t _len = strlcpy(s, path, len);
+   if (_len < len)
+      strlcpy(s + _len, SRAM_JOURNAL_EXT, len - _len);
+}
+
+/**
+ * sram_journal_read:
+ * @path             : journal file
+ * @data             : save RAM to apply the records to, or NULL
+ * @len              : size of the save RAM
+ * @records          : number of good records, if not NULL
+ *
+ * Reads the journal at @path up to its first bad or torn record,
+ * applying the good ones to @data.
+ *
+ * Returns: offset just past the last good record, or -1 if @path is
+ * not a journal for save RAM of @len bytes.
+ **/
+static int64_t sram_journal_read(const char *path, uint8_t *data,
+      size_t len, unsigned *records)
+{
+   uint8_t head[SRAM_JOURNAL_RECORD_SIZE];
+   int64_t end      = -1;
+   unsigned count   = 0;
+   uint8_t *staging = NULL;
+   RFILE *file      = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return -1;
+
+   if (     filestream_read(file, head, SRAM_JOURNAL_HEADER_SIZE)
+         != SRAM_JOURNAL_HEADER_SIZE
+       || memcmp(head, SRAM_JOURNAL_MAGIC, 4)
+       || sram_journal_get32(head + 4) != (uint32_t)len
+       || !(staging = (uint8_t*)malloc(len)))
+      goto end;
+
+   end = SRAM_JOURNAL_HEADER_SIZE;
+
+   while (filestream_read(file, head, SRAM_JOURNAL_RECORD_SIZE)
+         == SRAM_JOURNAL_RECORD_SIZE)
+   {
+      uint32_t crc;
+      uint32_t offset = sram_journal_get32(head);
+      uint32_t size   = sram_journal_get32(head + 4);
+
+      if (     offset > len
+            || size   > len - offset
+            || filestream_read(file, staging, size) != (int64_t)size)
+         break;
+
+      crc = encoding_crc32(0, head, 8);
+      crc = encoding_crc32(crc, staging, size);
+      if (crc != sram_journal_get32(head + 8))
+         break;
+
+      if (data)
+         memcpy(data + offset, staging, size);
+      end += SRAM_JOURNAL_RECORD_SIZE + size;
+      count++;
+   }
+
+end:
+   free(staging);
+   filestream_close(file);
+   if (records)
+      *records = count;
+   return end;
+}
+
+/* Deletes the journal of save file @path, if there is one */
+static void sram_journal_remove(const char *path)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   sram_journal_path(journal_path, sizeof(journal_path), path);
+   if (path_is_valid(journal_path))
+      filestream_delete(journal_path);
+}
+
+/**
+ * sram_write_atomic:
+ * @path             : save file
+ * @data             : save RAM
+ * @len              : size of @data
+ * @compress         : whether to use rzip compression
+ *
+ * Writes @data to a temporary file, syncs it and moves it over @path
+ * so that @path always holds either the old or the new save.
+ **/
+static bool sram_write_atomic(const char *path, const void *data,
+      size_t len, bool compress)
+{
+   RFILE *file;
+   char tmp_path[PATH_MAX_LENGTH];
+   size_t _len = strlcpy(tmp_path, path, sizeof(tmp_path));
+
+   if (_len + STRLEN_CONST(".tmp") >= sizeof(tmp_path))
+      return false;
+   strlcpy(tmp_path + _len, ".tmp", sizeof(tmp_path) - _len);
+
+#if defined(HAVE_COMPRESSION)
+   if (compress)
+   {
+      if (!rzipstream_write_file(tmp_path, data, len))
+         return false;
+   }
+   else
+#endif
+   {
+      if (!filestream_write_file(tmp_path, data, len))
+         return false;
+   }
+
+   /* Neither writer syncs; a sync through another handle to the same
+    * file does the job */
+   if ((file = filestream_open(tmp_path,
+               RETRO_VFS_FILE_ACCESS_READ_WRITE
+             | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+   {
+      filestream_sync(file);
+      filestream_close(file);
+   }
+
+   if (filestream_replace(tmp_path, path) != 0)
+   {
+      filestream_delete(tmp_path);
+      return false;
+   }
+
+   return true;
+}
+
 #ifdef HAVE_THREADS
 typedef struct autosave autosave_t;
 
-/* Autosave support. */
+/* Save RAM is compared in blocks of this size; changed blocks next to
+ * each other make one journal record */
+#define AUTOSAVE_BLOCK_SIZE     64
+/* The journal is compacted into the save file every this many passes */
+#define AUTOSAVE_COMPACT_PASSES 30
+
+/* Autosave support.
+ *
+ * One thread serves every memory region. Each pass it compares the
+ * regions the core may have written with what it journaled last,
+ * appends the changed ranges to the journals, and now and then
+ * compacts them. */
 struct autosave_st
 {
    autosave_t **list;
+   slock_t *lock;      /* core memory and the DIRTY flags */
+   slock_t *io_lock;   /* region buffers, journals and save files */
+   slock_t *cond_lock;
+   scond_t *cond;
+   sthread_t *thread;
    unsigned num;
+   unsigned interval;
+   unsigned passes;    /* since the last compaction; io_lock */
+   bool compress;
+   bool quit;          /* cond_lock */
 };
 
 enum autosave_flags
 {
-   AUTOSAVE_FLAG_COMPRESS_FILES = (1 << 1),
-   AUTOSAVE_FLAG_DIRTY          = (1 << 2)
+   AUTOSAVE_FLAG_DIRTY   = (1 << 0), /* core may have written; lock */
+   AUTOSAVE_FLAG_UNSAVED = (1 << 1)  /* save file is behind; io_lock */
 };
 
+typedef struct autosave_range
+{
+   size_t offset;
+   size_t len;
+} autosave_range_t;
+
 struct autosave
 {
-   void *buffer;
-   const void *retro_buffer;
+   uint8_t *buffer;              /* save RAM as last journaled */
+   const uint8_t *retro_buffer;
    char *path;
-   slock_t *lock;
-   slock_t *cond_lock;
-   scond_t *cond;
-   sthread_t *thread;
+   char *journal_path;
+   RFILE *journal;               /* open from the first append */
+   autosave_range_t *ranges;     /* changed in the current pass */
    size_t bufsize;
-   unsigned interval;
-   /* Guarded by 'lock'.  AUTOSAVE_FLAG_QUIT is deliberately NOT kept
-    * here: it is guarded by cond_lock, and two locks protecting
-    * different bits of one byte do not protect the byte -- the
-    * read-modify-write covers all of it. */
+   size_t num_ranges;
+   size_t pending;               /* bytes the ranges add to the journal */
+   size_t journal_size;          /* 0 if there's no journal */
+   /* DIRTY is guarded by autosave_state.lock, UNSAVED by io_lock;
+    * they are kept apart, as two locks guarding bits of one byte do
+    * not guard the byte. */
    uint8_t flags;
-   /* Guarded by cond_lock. */
-   uint8_t quit;
+   uint8_t io_flags;
 };
 
 static struct autosave_st autosave_state;
 
+/* Copies what changed in @save's region into its buffer, noting the
+ * changed ranges. Called with both locks held. */
+static void autosave_diff(autosave_t *save)
+{
+   size_t offset;
+
+   save->num_ranges = 0;
+   save->pending    = 0;
+
+   for (offset = 0; offset < save->bufsize; offset += AUTOSAVE_BLOCK_SIZE)
+   {
+      size_t len = save->bufsize - offset;
+      if (len > AUTOSAVE_BLOCK_SIZE)
+         len = AUTOSAVE_BLOCK_SIZE;
+
+      if (!memcmp(save->buffer + offset, save->retro_buffer + offset, len))
+         continue;
+
+      memcpy(save->buffer + offset, save->retro_buffer + offset, len);
+
+      if (     save->num_ranges
+            &&    save->ranges[save->num_ranges - 1].offset
+                + save->ranges[save->num_ranges - 1].len == offset)
+         save->ranges[save->num_ranges - 1].len += len;
+      else
+      {
+         save->ranges[save->num_ranges].offset = offset;
+         save->ranges[save->num_ranges].len    = len;
+         save->num_ranges++;
+         save->pending                        += SRAM_JOURNAL_RECORD_SIZE;
+      }
+      save->pending += len;
+   }
+}
+
+/* Opens @save's journal for appending: after its last good record if
+ * it is usable, as a new journal otherwise */
+static bool autosave_journal_open(autosave_t *save)
+{
+   uint8_t head[SRAM_JOURNAL_HEADER_SIZE];
+   int64_t end = path_is_valid(save->journal_path)
+      ? sram_journal_read(save->journal_path, NULL, save->bufsize, NULL)
+      : -1;
+
+   if (end > 0 && (save->journal = filestream_open(save->journal_path,
+               RETRO_VFS_FILE_ACCESS_READ_WRITE
+             | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+   {
+      if (     filestream_truncate(save->journal, end) == 0
+            && filestream_seek(save->journal, end,
+               RETRO_VFS_SEEK_POSITION_START) == 0)
+      {
+         save->journal_size = (size_t)end;
+         return true;
+      }
+      filestream_close(save->journal);
+   }
+
+   if (!(save->journal = filestream_open(save->journal_path,
+               RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   memcpy(head, SRAM_JOURNAL_MAGIC, 4);
+   sram_journal_put32(head + 4, (uint32_t)save->bufsize);
+   if (filestream_write(save->journal, head, sizeof(head)) != sizeof(head))
+      return false;
+   save->journal_size = sizeof(head);
+   return true;
+}
+
+/* Appends the ranges found by autosave_diff() to @save's journal and
+ * syncs it. Called with io_lock held. */
+static bool autosave_journal_append(autosave_t *save)
+{
+   size_t i;
+
+   if (!save->journal && !autosave_journal_open(save))
+      return false;
+
+   for (i = 0; i < save->num_ranges; i++)
+   {
+      uint32_t crc;
+      uint8_t head[SRAM_JOURNAL_RECORD_SIZE];
+      const uint8_t *data = save->buffer + save->ranges[i].offset;
+      size_t len          = save->ranges[i].len;
+
+      sram_journal_put32(head,     (uint32_t)save->ranges[i].offset);
+      sram_journal_put32(head + 4, (uint32_t)len);
+      crc = encoding_crc32(0, head, 8);
+      crc = encoding_crc32(crc, data, len);
+      sram_journal_put32(head + 8, crc);
+
+      if (     filestream_write(save->journal, head, sizeof(head))
+            != sizeof(head)
+          ||   filestream_write(save->journal, data, len)
+            != (int64_t)len)
+         return false;
+   }
+
+   if (filestream_sync(save->journal) != 0)
+      return false;
+
+   save->journal_size += save->pending;
+   return true;
+}
+
+/* Writes @save's buffer out as its save file and deletes its journal.
+ * Called with io_lock held. */
+static bool autosave_compact(autosave_t *save)
+{
+   if (!sram_write_atomic(save->path, save->buffer, save->bufsize,
+            autosave_state.compress))
+   {
+      RARCH_ERR("[SRAM] %s \"%s\".\n",
+            msg_hash_to_str(MSG_FAILED_TO_SAVE_SRAM), save->path);
+      return false;
+   }
+
+   if (save->journal)
+      filestream_close(save->journal);
+   save->journal       = NULL;
+   save->journal_size  = 0;
+   if (path_is_valid(save->journal_path))
+      filestream_delete(save->journal_path);
+   save->io_flags     &= ~AUTOSAVE_FLAG_UNSAVED;
+   return true;
+}
+
+/**
+ * autosave_sync:
+ * @save             : region
+ * @compact          : whether to compact the journal as well
+ *
+ * Journals what the core changed in @save's region since the last
+ * pass. The journal is compacted if @compact is set, if it has grown
+ * past the size of the save, or if it could not be written. Called
+ * with io_lock held.
+ **/
+static void autosave_sync(autosave_t *save, bool compact)
+{
+   bool changed = false;
+
+   slock_lock(autosave_state.lock);
+   if (save->flags & AUTOSAVE_FLAG_DIRTY)
+   {
+      autosave_diff(save);
+      changed      = save->num_ranges > 0;
+      save->flags &= ~AUTOSAVE_FLAG_DIRTY;
+   }
+   slock_unlock(autosave_state.lock);
+
+   if (changed)
+   {
+      save->io_flags |= AUTOSAVE_FLAG_UNSAVED;
+
+      if (!autosave_journal_append(save))
+      {
+         RARCH_WARN("[SRAM] Could not write journal \"%s\".\n",
+               save->journal_path);
+         if (save->journal)
+            filestream_close(save->journal);
+         save->journal = NULL;
+         compact       = true;
+      }
+      else if (save->journal_size > save->bufsize)
+         compact       = true;
+   }
+
+   if (compact && (save->io_flags & AUTOSAVE_FLAG_UNSAVED))
+      autosave_compact(save);
+}
 
 /**
  * autosave_thread:
- * @data            : pointer to autosave object
+ * @data            : unused
  *
  * Callback function for (threaded) autosave.
  *
  * Performance notes:
  *  - The dirty flag allows an early-out when the core
- *    has not touched SRAM since last check, avoiding a
- *    full memcmp on every wake-up.
- *  - When a comparison is needed we scan word-at-a-time
- *    to locate the first differing region, then only
- *    memcmp/memcpy from that point onward.
- *  - The file write happens entirely outside the lock,
+ *    has not touched SRAM since last check.
+ *  - Only the changed blocks are copied and journaled,
+ *    and the whole save is written only on compaction.
+ *  - All file I/O happens outside the core memory lock,
  *    so the core is never stalled on disk I/O.
  **/
 static void autosave_thread(void *data)
 {
-   autosave_t *save = (autosave_t*)data;
+   (void)data;
 
    for (;;)
    {
-      bool differ   = false;
-      bool compress = false;
-
-      slock_lock(save->lock);
-
-      /* Fast path: if the core hasn't signalled a write
-       * since our last check, skip the expensive memcmp.
-       * Falls back to full comparison if the dirty flag
-       * was never set (conservative default). */
-      if (save->flags & AUTOSAVE_FLAG_DIRTY)
-      {
-         const size_t word_size = sizeof(size_t);
-         const size_t aligned   = save->bufsize / word_size;
-         const size_t remainder = save->bufsize % word_size;
-         const size_t *src_w    = (const size_t*)save->retro_buffer;
-         const size_t *dst_w    = (const size_t*)save->buffer;
-         size_t offset          = 0;
-         size_t i;
-
-         /* Word-at-a-time scan to find first difference.
-          * Avoids touching the entire buffer when only
-          * a small region changed (common for SRAM). */
-         for (i = 0; i < aligned; i++)
-         {
-            if (src_w[i] != dst_w[i])
-            {
-               differ = true;
-               offset = i * word_size;
-               break;
-            }
-         }
-
-         /* Check trailing bytes if no word-level diff found */
-         if (!differ && remainder > 0)
-         {
-            const unsigned char *src_b =
-               (const unsigned char*)save->retro_buffer + aligned * word_size;
-            const unsigned char *dst_b =
-               (const unsigned char*)save->buffer + aligned * word_size;
-            if (memcmp(dst_b, src_b, remainder) != 0)
-            {
-               differ = true;
-               offset = aligned * word_size;
-            }
-         }
-
-         /* Only copy from first difference onward */
-         if (differ)
-            memcpy((unsigned char*)save->buffer + offset,
-                   (const unsigned char*)save->retro_buffer + offset,
-                   save->bufsize - offset);
-
-         /* Clear dirty flag regardless — we've checked */
-         save->flags &= ~AUTOSAVE_FLAG_DIRTY;
-      }
-
-      /* COMPRESS_FILES never changes after autosave_new(), but it
-       * shares the byte with DIRTY, which the main thread sets under
-       * this lock.  Sample it here rather than reading save->flags
-       * again once the lock is dropped. */
-      compress = (save->flags & AUTOSAVE_FLAG_COMPRESS_FILES) != 0;
-
-      slock_unlock(save->lock);
-
-      if (differ)
-      {
-         intfstream_t *file = NULL;
-
-         if (compress)
-            file = intfstream_open_rzip_file(save->path,
-                  RETRO_VFS_FILE_ACCESS_WRITE);
-         else
-            file = intfstream_open_file(save->path,
-                  RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+      unsigned i;
+      bool compact;
 
-         if (file)
-         {
-            intfstream_write(file, save->buffer, save->bufsize);
-            intfstream_flush(file);
-            intfstream_close(file);
-            free(file);
-         }
-      }
+      slock_lock(autosave_state.io_lock);
+      if ((compact = ++autosave_state.passes >= AUTOSAVE_COMPACT_PASSES))
+         autosave_state.passes = 0;
+      for (i = 0; i < autosave_state.num; i++)
+         if (autosave_state.list[i])
+            autosave_sync(autosave_state.list[i], compact);
+      slock_unlock(autosave_state.io_lock);
 
-      slock_lock(save->cond_lock);
+      slock_lock(autosave_state.cond_lock);
 
-      if (save->quit)
+      if (autosave_state.quit)
       {
-         slock_unlock(save->cond_lock);
+         slock_unlock(autosave_state.cond_lock);
          break;
       }
 
-      scond_wait_timeout(save->cond,
-            save->cond_lock,
+      scond_wait_timeout(autosave_state.cond,
+            autosave_state.cond_lock,
 #if defined(_MSC_VER) && _MSC_VER <= 1200
-            save->interval * 1000000
+            autosave_state.interval * 1000000
 #else
-            save->interval * 1000000LL
+            autosave_state.interval * 1000000LL
 #endif
             );
 
-      slock_unlock(save->cond_lock);
+      slock_unlock(autosave_state.cond_lock);
    }
 }
 
+/**
+ * autosave_free:
+ * @handle          : pointer to autosave object
+ *
+ * Frees autosave object and all associated resources.
+ **/
+static void autosave_free(autosave_t *handle)
+{
+   if (handle->journal)
+      filestream_close(handle->journal);
+   free(handle->ranges);
+   free(handle->buffer);
+   free(handle->journal_path);
+   free(handle->path);
+   free(handle);
+}
+
 /**
  * autosave_new:
  * @path            : path to autosave file
  * @data            : pointer to buffer
  * @len             : size of @data buffer
- * @interval        : interval at which saves should be performed.
  *
  * Create and initialize autosave object.
  *
@@ -230,116 +547,45 @@ static void autosave_thread(void *data)
  * NULL.
  **/
 static autosave_t *autosave_new(const char *path,
-      const void *data, size_t len,
-      unsigned interval, bool compress)
+      const void *data, size_t len)
 {
-   void       *buf               = NULL;
-   autosave_t *handle            = (autosave_t*)malloc(sizeof(*handle));
+   char journal_path[PATH_MAX_LENGTH];
+   autosave_t *handle = (autosave_t*)calloc(1, sizeof(*handle));
    if (!handle)
       return NULL;
 
-   handle->flags                 = AUTOSAVE_FLAG_DIRTY;
-   handle->quit                  = 0;
-   handle->bufsize               = len;
-   handle->interval              = interval;
-   handle->buffer                = NULL;
-   handle->lock                  = NULL;
-   handle->cond_lock             = NULL;
-   handle->cond                  = NULL;
-   handle->thread                = NULL;
+   sram_journal_path(journal_path, sizeof(journal_path), path);
 
-   if (compress)
-      handle->flags             |= AUTOSAVE_FLAG_COMPRESS_FILES;
-   handle->retro_buffer          = data;
-   /* Own the path string rather than borrowing it. The caller's
+   handle->flags        = AUTOSAVE_FLAG_DIRTY;
+   handle->bufsize      = len;
+   handle->retro_buffer = (const uint8_t*)data;
+   /* Own the path strings rather than borrowing them. The caller's
     * path comes from task_save_files->elems[i].data, freed by
-    * path_deinit_savefile() during the deinit chain. The worker
-    * thread reads handle->path via intfstream_open_*(). Owning
-    * the string keeps the lifetime contract local to
-    * autosave_new/autosave_free rather than depending on top-
-    * level deinit ordering at every call site. */
-   if (!(handle->path = strdup(path)))
+    * path_deinit_savefile() during the deinit chain. */
+   handle->path         = strdup(path);
+   handle->journal_path = strdup(journal_path);
+   handle->buffer       = (uint8_t*)malloc(len);
+   /* Worst case: every other block changed */
+   handle->ranges       = (autosave_range_t*)malloc(
+         (len / (2 * AUTOSAVE_BLOCK_SIZE) + 1) * sizeof(*handle->ranges));
+
+   if (     !handle->path   || !handle->journal_path
+         || !handle->buffer || !handle->ranges)
    {
-      free(handle);
+      autosave_free(handle);
       return NULL;
    }
 
-   if (!(buf = malloc(len)))
-   {
-      free(handle->path);
-      free(handle);
-      return NULL;
-   }
-
-   handle->buffer                = buf;
-
    memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
 
-   handle->lock                  = slock_new();
-   handle->cond_lock             = slock_new();
-   handle->cond                  = scond_new();
-
-   if (!handle->lock || !handle->cond_lock || !handle->cond)
-   {
-      RARCH_ERR("[SRAM] Failed to initialize autosave synchronization primitives.\n");
-      if (handle->lock)
-         slock_free(handle->lock);
-      if (handle->cond_lock)
-         slock_free(handle->cond_lock);
-      if (handle->cond)
-         scond_free(handle->cond);
-      free(handle->path);
-      free(handle->buffer);
-      free(handle);
-      return NULL;
-   }
-
-   handle->thread                = sthread_create(autosave_thread, handle);
-
-   if (!handle->thread)
-   {
-      RARCH_ERR("[SRAM] Failed to create autosave thread.\n");
-      slock_free(handle->lock);
-      slock_free(handle->cond_lock);
-      scond_free(handle->cond);
-      free(handle->path);
-      free(handle->buffer);
-      free(handle);
-      return NULL;
-   }
+   /* Left behind by a crash: loading the save has replayed it, and
+    * it goes once the save file has caught up */
+   if (path_is_valid(journal_path))
+      handle->io_flags  |= AUTOSAVE_FLAG_UNSAVED;
 
    return handle;
 }
 
-/**
- * autosave_free:
- * @handle          : pointer to autosave object
- *
- * Frees autosave object and all associated resources.
- **/
-static void autosave_free(autosave_t *handle)
-{
-   slock_lock(handle->cond_lock);
-   handle->quit  = 1;
-   slock_unlock(handle->cond_lock);
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
-
-   slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
-
-   if (handle->buffer)
-      free(handle->buffer);
-   handle->buffer = NULL;
-
-   if (handle->path)
-      free(handle->path);
-   handle->path = NULL;
-
-   free(handle);
-}
-
 bool autosave_init(bool compress_files, unsigned autosave_interval)
 {
    unsigned i;
@@ -353,8 +599,26 @@ bool autosave_init(bool compress_files, unsigned autosave_interval)
             sizeof(*autosave_state.list))))
       return false;
 
-   autosave_state.list = list;
-   autosave_state.num  = (unsigned)task_save_files->size;
+   autosave_state.lock      = slock_new();
+   autosave_state.io_lock   = slock_new();
+   autosave_state.cond_lock = slock_new();
+   autosave_state.cond      = scond_new();
+
+   if (     !autosave_state.lock      || !autosave_state.io_lock
+         || !autosave_state.cond_lock || !autosave_state.cond)
+   {
+      RARCH_ERR("[SRAM] Failed to initialize autosave synchronization primitives.\n");
+      free(list);
+      autosave_deinit();
+      return false;
+   }
+
+   autosave_state.list     = list;
+   autosave_state.num      = (unsigned)task_save_files->size;
+   autosave_state.interval = autosave_interval;
+   autosave_state.compress = compress_files;
+   autosave_state.passes   = 0;
+   autosave_state.quit     = false;
 
    for (i = 0; i < task_save_files->size; i++)
    {
@@ -367,14 +631,12 @@ bool autosave_init(bool compress_files, unsigned autosave_interval)
 
       core_get_memory(&mem_info);
 
-      if (mem_info.size == 0)
+      if (!mem_info.data || mem_info.size == 0)
          continue;
 
       if (!(auto_st = autosave_new(path,
             mem_info.data,
-            mem_info.size,
-            autosave_interval,
-            compress_files)))
+            mem_info.size)))
       {
          RARCH_WARN("[SRAM] %s\n", msg_hash_to_str(MSG_AUTOSAVE_FAILED));
          continue;
@@ -383,6 +645,13 @@ bool autosave_init(bool compress_files, unsigned autosave_interval)
       autosave_state.list[i] = auto_st;
    }
 
+   if (!(autosave_state.thread = sthread_create(autosave_thread, NULL)))
+   {
+      RARCH_ERR("[SRAM] Failed to create autosave thread.\n");
+      autosave_deinit();
+      return false;
+   }
+
    return true;
 }
 
@@ -390,18 +659,85 @@ void autosave_deinit(void)
 {
    unsigned i;
 
+   if (autosave_state.thread)
+   {
+      slock_lock(autosave_state.cond_lock);
+      autosave_state.quit = true;
+      slock_unlock(autosave_state.cond_lock);
+      scond_signal(autosave_state.cond);
+      sthread_join(autosave_state.thread);
+      autosave_state.thread = NULL;
+   }
+
+   /* Bring every save file up to date, leaving no journal behind */
    for (i = 0; i < autosave_state.num; i++)
    {
       autosave_t *handle = autosave_state.list[i];
       if (handle)
+      {
+         autosave_sync(handle, true);
          autosave_free(handle);
+      }
       autosave_state.list[i] = NULL;
    }
 
    free(autosave_state.list);
+   if (autosave_state.lock)
+      slock_free(autosave_state.lock);
+   if (autosave_state.io_lock)
+      slock_free(autosave_state.io_lock);
+   if (autosave_state.cond_lock)
+      slock_free(autosave_state.cond_lock);
+   if (autosave_state.cond)
+      scond_free(autosave_state.cond);
+
+   autosave_state.list      = NULL;
+   autosave_state.num       = 0;
+   autosave_state.lock      = NULL;
+   autosave_state.io_lock   = NULL;
+   autosave_state.cond_lock = NULL;
+   autosave_state.cond      = NULL;
+}
+
+/* Returns: the autosave region of @slot, or NULL if autosave does
+ * not cover it */
+static autosave_t *autosave_get(unsigned slot)
+{
+   if (slot < autosave_state.num)
+      return autosave_state.list[slot];
+   return NULL;
+}
+
+/* Takes the contents of @save's region as journaled; for save RAM just
+ * loaded from disk, which is already in the save file and journal */
+static void autosave_refresh(autosave_t *save)
+{
+   slock_lock(autosave_state.io_lock);
+   slock_lock(autosave_state.lock);
+   memcpy(save->buffer, save->retro_buffer, save->bufsize);
+   save->flags &= ~AUTOSAVE_FLAG_DIRTY;
+   slock_unlock(autosave_state.lock);
+   slock_unlock(autosave_state.io_lock);
+}
 
-   autosave_state.list     = NULL;
-   autosave_state.num      = 0;
+/* Journals and compacts @save's region at once.
+ * Returns: false if the save file could not be written. */
+static bool autosave_flush(autosave_t *save)
+{
+   bool ret;
+
+   slock_lock(autosave_state.io_lock);
+   slock_lock(autosave_state.lock);
+   save->flags |= AUTOSAVE_FLAG_DIRTY;
+   slock_unlock(autosave_state.lock);
+   /* A save file that was never written is behind as well */
+   if (!path_is_valid(save->path))
+      save->io_flags |= AUTOSAVE_FLAG_UNSAVED;
+   autosave_sync(save, true);
+   ret = !(save->io_flags & AUTOSAVE_FLAG_UNSAVED);
+   slock_unlock(autosave_state.io_lock);
+
+   return ret;
 }
 
 /**
@@ -411,14 +747,8 @@ void autosave_deinit(void)
  **/
 void autosave_lock(void)
 {
-   unsigned i;
-
-   for (i = 0; i < autosave_state.num; i++)
-   {
-      autosave_t *handle = autosave_state.list[i];
-      if (handle)
-         slock_lock(handle->lock);
-   }
+   if (autosave_state.lock)
+      slock_lock(autosave_state.lock);
 }
 
 /**
@@ -432,15 +762,17 @@ void autosave_unlock(void)
 {
    unsigned i;
 
+   if (!autosave_state.lock)
+      return;
+
    for (i = 0; i < autosave_state.num; i++)
    {
       autosave_t *handle = autosave_state.list[i];
       if (handle)
-      {
          handle->flags |= AUTOSAVE_FLAG_DIRTY;
-         slock_unlock(handle->lock);
-      }
    }
+
+   slock_unlock(autosave_state.lock);
 }
 
 /**
@@ -453,18 +785,8 @@ void autosave_unlock(void)
  **/
 void autosave_mark_dirty(void)
 {
-   unsigned i;
-
-   for (i = 0; i < autosave_state.num; i++)
-   {
-      autosave_t *handle = autosave_state.list[i];
-      if (handle)
-      {
-         slock_lock(handle->lock);
-         handle->flags |= AUTOSAVE_FLAG_DIRTY;
-         slock_unlock(handle->lock);
-      }
-   }
+   autosave_lock();
+   autosave_unlock();
 }
 #endif
 
@@ -487,55 +809,83 @@ static bool content_get_memory(retro_ctx_memory_info_t *mem_info,
  * content_load_ram_file:
  * @slot             : index into task_save_files
  *
- * Load a RAM state from disk to memory.
+ * Load a RAM state from disk to memory, then replay
+ * the journal autosave may have left next to it.
  */
 static bool content_load_ram_file(unsigned slot)
 {
    int64_t rc;
    struct ram_type ram;
    retro_ctx_memory_info_t mem_info;
+   char journal_path[PATH_MAX_LENGTH];
+   unsigned records = 0;
    void *buf        = NULL;
    bool success     = false;
 
    if (!content_get_memory(&mem_info, &ram, slot))
       return false;
 
+   if (!ram.path || !*ram.path)
+      return false;
+
+   sram_journal_path(journal_path, sizeof(journal_path), ram.path);
+
    /* On first run of content, SRAM file will
     * not exist. This is a common enough occurrence
     * that we should check before attempting to
     * invoke the relevant read_file() function */
-   if (    (!ram.path || !*ram.path)
-       || !path_is_valid(ram.path))
-      return false;
-
+   if (path_is_valid(ram.path))
+   {
 #if defined(HAVE_COMPRESSION)
-   /* Always use RZIP interface when reading SRAM
-    * files - this will automatically handle uncompressed
-    * data */
-   if (!rzipstream_read_file(ram.path, &buf, &rc))
+      /* Always use RZIP interface when reading SRAM
+       * files - this will automatically handle uncompressed
+       * data */
+      if (!rzipstream_read_file(ram.path, &buf, &rc))
 #else
-   if (!filestream_read_file(ram.path, &buf, &rc))
+      if (!filestream_read_file(ram.path, &buf, &rc))
 #endif
-      return false;
+         return false;
 
-   if (rc > 0)
-   {
-      if (rc > (ssize_t)mem_info.size)
+      if (rc > 0)
       {
-         RARCH_WARN("[SRAM] SRAM is larger than implementation expects, "
-               "doing partial load (truncating %u %s %s %u).\n",
-               (unsigned)rc,
-               msg_hash_to_str(MSG_BYTES),
-               msg_hash_to_str(MSG_TO),
-               (unsigned)mem_info.size);
-         rc = mem_info.size;
+         if (rc > (ssize_t)mem_info.size)
+         {
+            RARCH_WARN("[SRAM] SRAM is larger than implementation expects, "
+                  "doing partial load (truncating %u %s %s %u).\n",
+                  (unsigned)rc,
+                  msg_hash_to_str(MSG_BYTES),
+                  msg_hash_to_str(MSG_TO),
+                  (unsigned)mem_info.size);
+            rc = mem_info.size;
+         }
+         memcpy(mem_info.data, buf, (size_t)rc);
+         success = true;
       }
-      memcpy(mem_info.data, buf, (size_t)rc);
+
+      if (buf)
+         free(buf);
+   }
+
+   /* Changes autosave journaled after the save file was last
+    * written; there are only any if content did not exit cleanly */
+   if (     path_is_valid(journal_path)
+         && sram_journal_read(journal_path, (uint8_t*)mem_info.data,
+            mem_info.size, &records) >= 0
+         && records > 0)
+   {
+      RARCH_LOG("[SRAM] Replayed %u change(s) from \"%s\".\n",
+            records, journal_path);
       success = true;
    }
 
-   if (buf)
-      free(buf);
+#ifdef HAVE_THREADS
+   if (success)
+   {
+      autosave_t *save = autosave_get(slot);
+      if (save)
+         autosave_refresh(save);
+   }
+#endif
 
    return success;
 }
@@ -596,15 +946,33 @@ static bool dump_to_file_desperate(const void *data,
  * Save a RAM state from memory to disk.
  * Skips the write if the on-disk content already
  * matches memory (common when autosave has been active).
+ * The file is replaced atomically, and any autosave
+ * journal next to it removed.
  */
 static bool content_save_ram_file(unsigned slot, bool compress)
 {
    struct ram_type ram;
    retro_ctx_memory_info_t mem_info;
+#ifdef HAVE_THREADS
+   autosave_t *save = autosave_get(slot);
+#endif
 
    if (!content_get_memory(&mem_info, &ram, slot))
       return false;
 
+#ifdef HAVE_THREADS
+   /* Autosave owns the save file and its journal while it runs */
+   if (save)
+   {
+      if (!autosave_flush(save))
+         goto fail;
+      RARCH_LOG("[SRAM] %s \"%s\".\n",
+            msg_hash_to_str(MSG_SAVED_SUCCESSFULLY_TO),
+            ram.path);
+      return true;
+   }
+#endif
+
    /* Quick check: if the file already exists and matches
     * current memory contents, skip the write entirely.
     * This is the common case when autosave has been running. */
@@ -633,6 +1001,7 @@ static bool content_save_ram_file(unsigned slot, bool compress)
                mem_info.size))
 #endif
       {
+         sram_journal_remove(ram.path);
          RARCH_LOG("[SRAM] %s \"%s\" (unchanged, skipping write).\n",
                msg_hash_to_str(MSG_SAVED_SUCCESSFULLY_TO),
                ram.path);
@@ -646,20 +1015,10 @@ static bool content_save_ram_file(unsigned slot, bool compress)
          msg_hash_to_str(MSG_TO),
          ram.path);
 
-#if defined(HAVE_COMPRESSION)
-   if (compress)
-   {
-      if (!rzipstream_write_file(
-            ram.path, mem_info.data, mem_info.size))
-         goto fail;
-   }
-   else
-#endif
-   {
-      if (!filestream_write_file(
-            ram.path, mem_info.data, mem_info.size))
-         goto fail;
-   }
+   if (!sram_write_atomic(ram.path, mem_info.data, mem_info.size,
+            compress))
+      goto fail;
+   sram_journal_remove(ram.path);
 
    RARCH_LOG("[SRAM] %s \"%s\".\n",
          msg_hash_to_str(MSG_SAVED_SUCCESSFULLY_TO),
@@ -59,3 +59,21 @@ S_BOOL(cheevos_start_active, CHEEVOS_START_ACTIVE,
       "Encore Mode",
       "Start the session with all achievements active (even the ones previously unlocked).")
 #endif
+/* Descriptor and configuration rows are #ifdef HAVE_CHEEVOS; the string
+ * tables always carry this row via the strings pass. */
+#if defined(HAVE_CHEEVOS) || defined(SETTINGS_DEF_STRINGS_PASS)
+S_BOOL(cheevos_background_eval, CHEEVOS_BACKGROUND_EVAL,
+      "cheevos_background_eval",
+      false, SD_FLAG_ADVANCED, 0, 0,
+      "Background Evaluation",
+      "Check achievements on a separate thread against a copy of the memory they use, taken at the end of each frame. Frees up frame time with large achievement sets; notifications appear one frame later.")
+#endif
+/* Descriptor and configuration rows are #ifdef HAVE_CHEEVOS; the string
+ * tables always carry this row via the strings pass. */
+#if defined(HAVE_CHEEVOS) || defined(SETTINGS_DEF_STRINGS_PASS)
+S_BOOL(cheevos_hash_cache, CHEEVOS_HASH_CACHE,
+      "cheevos_hash_cache",
+      true, SD_FLAG_ADVANCED, 0, 0,
+      "Cache Content Hashes",
+      "Remember the hash that identifies each game, so that loading it again does not read the whole file. Saves time with large disc images.")
+#endif
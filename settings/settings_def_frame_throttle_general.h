@@ -29,3 +29,8 @@ S_BOOL_EX_H(vrr_runloop_enable, VRR_RUNLOOP_ENABLE,
       false, SD_FLAG_CMD_APPLY_AUTO, 0, CMD_EVENT_NONE, setting_bool_action_left_with_refresh, NULL, NULL, NULL, setting_bool_action_left_with_refresh, setting_bool_action_right_with_refresh, 0,
       "Sync to Exact Content Framerate (G-Sync, FreeSync)",
       "No deviation from core requested timing. Use for Variable Refresh Rate screens (G-Sync, FreeSync, HDMI 2.1 VRR).")
+S_BOOL(frame_limit_precise, FRAME_LIMIT_PRECISE,
+      "frame_limit_precise",
+      DEFAULT_FRAME_LIMIT_PRECISE, SD_FLAG_NONE, 0, 0,
+      "Precise Frame Limiter",
+      "When the frame rate is limited without vsync (fast-forward, VRR, menu), sleep until shortly before the deadline and wait out the rest, instead of relying on a plain OS sleep that can wake up late. Steadier frame pacing for a fraction of a millisecond of CPU time per frame.")
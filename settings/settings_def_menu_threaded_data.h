@@ -12,4 +12,9 @@ S_BOOL(threaded_data_runloop_enable, THREADED_DATA_RUNLOOP_ENABLE,
       DEFAULT_THREADED_DATA_RUNLOOP_ENABLE, SD_FLAG_ADVANCED, 0, 0,
       "Threaded Tasks",
       "Perform tasks on a separate thread.")
+S_UINT(threaded_data_runloop_workers, THREADED_DATA_RUNLOOP_WORKERS,
+      "threaded_data_runloop_workers",
+      DEFAULT_THREADED_DATA_RUNLOOP_WORKERS, SD_FLAG_ADVANCED, SDESC_RANGE_MINMAX, CMD_EVENT_NONE, 1, 8, 1, 0, setting_action_ok_uint, NULL,
+      "Threaded Task Workers",
+      "Number of threads running tasks when 'Threaded Tasks' is enabled. Savestates, screenshots and thumbnails are always run ahead of scans and downloads; more threads also let them run alongside each other.")
 #endif
@@ -14,3 +14,18 @@ S_UINT_EX(rewind_granularity, REWIND_GRANULARITY,
       DEFAULT_REWIND_GRANULARITY, SD_FLAG_NONE, SDESC_RANGE_MINMAX, 0, 1, 32768, 1, 1, setting_action_ok_uint, NULL, NULL, NULL, NULL, NULL, 0,
       "Rewind Frames",
       "The number of frames to rewind per step. Higher values increase the rewind speed.")
+S_BOOL(rewind_threaded, REWIND_THREADED,
+      "rewind_threaded",
+      DEFAULT_REWIND_THREADED, SD_FLAG_ADVANCED, 0, CMD_EVENT_REWIND_REINIT,
+      "Threaded Rewind",
+      "Compare each rewind state with the previous one on a separate thread while the next frame runs. Lowers the cost of rewind on the emulation thread.")
+S_BOOL(rewind_compression, REWIND_COMPRESSION,
+      "rewind_compression",
+      DEFAULT_REWIND_COMPRESSION, SD_FLAG_ADVANCED, 0, CMD_EVENT_REWIND_REINIT,
+      "Compress Rewind Buffer",
+      "Compress each rewind buffer entry with Zstandard. Holds more rewind history in the same buffer size, at some extra CPU cost per frame.")
+S_UINT_EX(rewind_keyframe_interval, REWIND_KEYFRAME_INTERVAL,
+      "rewind_keyframe_interval",
+      DEFAULT_REWIND_KEYFRAME_INTERVAL, SD_FLAG_CMD_APPLY_AUTO | SD_FLAG_ADVANCED, SDESC_RANGE_MINMAX, CMD_EVENT_REWIND_REINIT, 0, 3600, 1, 1, setting_action_ok_uint, NULL, NULL, NULL, NULL, NULL, 0,
+      "Rewind Keyframe Interval",
+      "Store every this many rewind states in full, so that seeking far back restores from the nearest full state instead of undoing every frame in between. Uses more of the rewind buffer. 0 disables.")
@@ -1,4 +1,4 @@
-/* Single-source definitions: run-ahead warnings setting.
+/* Single-source definitions: run-ahead warnings and auto-tuning settings.
  * Grammar identical to settings_def_video_sync.h plus S_FLOAT and
  * the _NS no-sublabel variants; the descriptor argument span
  * matches SDESC_<kind>_ROW; row order is menu display order;
@@ -12,4 +12,9 @@ S_BOOL(run_ahead_hide_warnings, RUN_AHEAD_HIDE_WARNINGS,
       DEFAULT_RUN_AHEAD_HIDE_WARNINGS, SD_FLAG_ADVANCED, 0, 0,
       "Hide Run-Ahead Warnings",
       "Hide the warning message that appears when using Run-Ahead and the core does not support save states.")
+S_BOOL(run_ahead_auto, RUN_AHEAD_AUTO,
+      "run_ahead_auto",
+      DEFAULT_RUN_AHEAD_AUTO, SD_FLAG_ADVANCED, 0, 0,
+      "Auto-Tune Run-Ahead",
+      "Measure how long the core takes to run a frame, save and load a state, and pick the Run-Ahead mode and number of frames that fit the frame time, up to the number set. Drops a frame when frames start running late.")
 #endif
@@ -72,3 +72,8 @@ S_UINT_H(video_hard_sync_frames, VIDEO_HARD_SYNC_FRAMES,
       DEFAULT_HARD_SYNC_FRAMES, SD_FLAG_NONE, SDESC_RANGE_MINMAX, CMD_EVENT_NONE, MINIMUM_HARD_SYNC_FRAMES, MAXIMUM_HARD_SYNC_FRAMES, 1, 0, setting_action_ok_uint, NULL,
       "Hard GPU Sync Frames",
       "Set how many frames the CPU can run ahead of the GPU when using 'Hard GPU Sync'.")
+S_BOOL(video_threaded_mailbox, VIDEO_THREADED_MAILBOX,
+      "video_threaded_mailbox",
+      DEFAULT_VIDEO_THREADED_MAILBOX, SD_FLAG_CMD_APPLY_AUTO, SDESC_FLG_REFRESH, CMD_EVENT_REINIT,
+      "Threaded Video Mailbox",
+      "Pass frames to the threaded video driver through a triple-buffered mailbox. The core never waits for, or drops a frame because of, a frame still being presented; a frame not yet displayed is replaced by the newer one instead. Cores that request a software framebuffer render straight into the mailbox, skipping the per-frame copy. Uses more memory.")
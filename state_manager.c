@@ -24,9 +24,16 @@
 #include <string.h>
 
 #include <retro_inline.h>
+#include <retro_endianness.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
 
+#ifdef HAVE_RZSTD
+#include <encodings/rzstd.h>
+#elif defined(HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
 #include "state_manager.h"
 #include "msg_hash.h"
 #include "core.h"
@@ -370,11 +377,131 @@ static void state_manager_raw_decompress(const void *patch, void *data)
    }
 }
 
+/* The control words of a patch are native endian in the rewind buffer.
+ * Patches that leave the process are little endian; this converts one
+ * just encoded by state_manager_raw_compress(). */
+static void state_manager_patch_to_le(uint16_t *patch16)
+{
+#ifdef MSB_FIRST
+   for (;;)
+   {
+      uint16_t numchanged = patch16[0];
+
+      if (numchanged)
+      {
+         /* A change block: its word count, then the skip, then data. */
+         patch16[0]       = SWAP16(patch16[0]);
+         patch16[1]       = SWAP16(patch16[1]);
+         patch16         += 2 + numchanged;
+      }
+      else
+      {
+         bool end         = !patch16[1] && !patch16[2];
+         patch16[1]       = SWAP16(patch16[1]);
+         patch16[2]       = SWAP16(patch16[2]);
+         if (end)
+            break;
+         patch16         += 3;
+      }
+   }
+#endif
+}
+
+size_t state_manager_patch_maxsize(size_t len)
+{
+   return state_manager_raw_maxsize(len);
+}
+
+size_t state_manager_patch_create(void *base, void *data, size_t len,
+      void *patch)
+{
+   size_t   num16s = (len + sizeof(uint16_t) - 1) / sizeof(uint16_t);
+   uint16_t *old16 = (uint16_t*)data;
+   uint16_t *new16 = (uint16_t*)base;
+   size_t   size;
+
+   /* Same tail as a rewind block: the rounding byte and three words
+    * equal on both sides stop find_same(), and a differing fourth stops
+    * find_change(). */
+   if (len & 1)
+   {
+      ((uint8_t*)data)[len] = 0;
+      ((uint8_t*)base)[len] = 0;
+   }
+   old16[num16s] = old16[num16s + 1] = old16[num16s + 2] = 0;
+   new16[num16s] = new16[num16s + 1] = new16[num16s + 2] = 0;
+   old16[num16s + 3] = 0;
+   new16[num16s + 3] = 1;
+
+   /* raw_compress records the words of its first argument, so the
+    * result applied to 'base' yields 'data'. */
+   size = state_manager_raw_compress(data, base, len, patch);
+   state_manager_patch_to_le((uint16_t*)patch);
+   return size;
+}
+
+bool state_manager_patch_apply(const void *patch, size_t patch_len,
+      void *data, size_t len)
+{
+   uint16_t         *out16 = (uint16_t*)data;
+   const uint16_t *patch16 = (const uint16_t*)patch;
+   size_t           num16s = (len + sizeof(uint16_t) - 1) / sizeof(uint16_t);
+   size_t         patch16s = patch_len / sizeof(uint16_t);
+   size_t              pos = 0;
+   size_t               at = 0;
+
+   /* Unlike state_manager_raw_decompress(), the patch may come from
+    * somewhere else, so every count is checked against both buffers.
+    * Conversion happens word by word as the walk goes, since a
+    * malformed patch cannot be trusted to delimit itself. */
+   for (;;)
+   {
+      uint16_t numchanged;
+
+      if (at + 3 > patch16s)
+         return false;
+
+      numchanged = retro_le_to_cpu16(patch16[at]);
+
+      if (numchanged)
+      {
+         size_t skip = retro_le_to_cpu16(patch16[at + 1]);
+         at         += 2;
+
+         if (     pos + skip + numchanged > num16s
+               || at + numchanged > patch16s)
+            return false;
+
+         memcpy(out16 + pos + skip, patch16 + at,
+               numchanged * sizeof(uint16_t));
+         pos        += skip + numchanged;
+         at         += numchanged;
+      }
+      else
+      {
+         uint32_t numunchanged = retro_le_to_cpu16(patch16[at + 1])
+            | ((uint32_t)retro_le_to_cpu16(patch16[at + 2]) << 16);
+
+         if (!numunchanged)
+            return true;
+         if (pos + numunchanged > num16s)
+            return false;
+         pos += numunchanged;
+         at  += 3;
+      }
+   }
+}
+
 /* The start offsets point to 'nextstart' of any given compressed frame.
  * Each uint16 is stored native endian; anything that claims any other
  * endianness refers to the endianness of this specific item.
  * The uint32 is stored little endian.
  *
+ * 'nextstart' is followed by a size holding the length of the entry
+ * shifted left by two, or'd with the STATE_MGR_ENTRY_* flags below.
+ * The entry itself is padded to an even length, so that patches
+ * stay aligned for the uint16 reads.
+ *
  * Each size value is stored native endian if alignment is not enforced;
  * if it is, they're little endian.
  *
@@ -390,6 +517,55 @@ static void state_manager_raw_decompress(const void *patch, void *data)
  * This means that on average, ~2 * maxcompsize is
  * unused at any given moment. */
 
+/* An entry holding the whole older state rather than a patch */
+#define STATE_MGR_ENTRY_KEYFRAME (1 << 0)
+/* The entry, patch or state, as one Zstandard frame */
+#define STATE_MGR_ENTRY_ZSTD     (1 << 1)
+#define STATE_MGR_ENTRY_SHIFT    2
+
+#if defined(HAVE_ZSTD) || defined(HAVE_RZSTD)
+#define STATE_MANAGER_HAVE_ZSTD
+/* An entry is compressed every capture, most of them on the
+ * emulation thread without a worker: the fastest level. */
+#define STATE_MANAGER_ZSTD_LEVEL 1
+
+static size_t state_manager_zstd_bound(size_t len)
+{
+#ifdef HAVE_RZSTD
+   return rzstd_compress_bound(len);
+#else
+   return ZSTD_compressBound(len);
+#endif
+}
+
+/* Returns the size of the frame, or 0 if encoding failed. */
+static size_t state_manager_zstd_encode(uint8_t *dst, size_t dst_len,
+      const uint8_t *src, size_t len)
+{
+   size_t wrote = 0;
+#ifdef HAVE_RZSTD
+   if (rzstd_encode(dst, dst_len, src, len,
+            STATE_MANAGER_ZSTD_LEVEL, &wrote) != RZSTD_PROCESS_END)
+      return 0;
+#else
+   wrote = ZSTD_compress(dst, dst_len, src, len, STATE_MANAGER_ZSTD_LEVEL);
+   if (ZSTD_isError(wrote))
+      return 0;
+#endif
+   return wrote;
+}
+
+static bool state_manager_zstd_decode(uint8_t *dst, size_t dst_len,
+      const uint8_t *src, size_t len)
+{
+#ifdef HAVE_RZSTD
+   return rzstd_decode(dst, dst_len, src, len, NULL) == RZSTD_PROCESS_END;
+#else
+   return !ZSTD_isError(ZSTD_decompress(dst, dst_len, src, len));
+#endif
+}
+#endif
+
 /* These are called very few constant times per frame,
  * keep it as simple as possible. */
 static INLINE void write_size_t(void *ptr, size_t val)
@@ -405,11 +581,183 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+static void state_manager_publish_stats(state_manager_t *state)
+{
+   state_manager_stats_t stats;
+   size_t headpos   = state->head - state->data;
+   size_t tailpos   = state->tail - state->data;
+
+   stats.used       = (headpos + state->capacity - tailpos) % state->capacity;
+   stats.capacity   = state->capacity;
+   stats.entries    = state->entries;
+   stats.keyframes  = state->keyframes;
+   stats.compressed = state->scratch != NULL;
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+      slock_lock(state->lock);
+#endif
+   state->stats     = stats;
+#ifdef HAVE_THREADS
+   if (state->lock)
+      slock_unlock(state->lock);
+#endif
+}
+
+/*
+ * Writes 'len' bytes from 'src' to 'entry', as a Zstandard frame if
+ * compressing and that comes out smaller. 'src' may be 'entry'.
+ *
+ * Returns the number of bytes written; sets STATE_MGR_ENTRY_ZSTD in
+ * 'flags' if they are a frame.
+ */
+static size_t state_manager_store(state_manager_t *state,
+      const uint8_t *src, size_t len, uint8_t *entry, size_t *flags)
+{
+#ifdef STATE_MANAGER_HAVE_ZSTD
+   if (state->scratch)
+   {
+      size_t framed = state_manager_zstd_encode(state->scratch,
+            state->scratchsize, src, len);
+      if (framed && framed < len)
+      {
+         memcpy(entry, state->scratch, framed);
+         *flags |= STATE_MGR_ENTRY_ZSTD;
+         return framed;
+      }
+   }
+#endif
+   if (src != entry)
+      memcpy(entry, src, len);
+   return len;
+}
+
+/*
+ * Turns thisblock into the state before the entry starting at 'start',
+ * i.e. at its 'nextstart'.
+ *
+ * Returns false if the entry does not decode.
+ */
+static bool state_manager_apply(state_manager_t *state, const uint8_t *start)
+{
+   size_t info           = read_size_t(start + sizeof(size_t));
+   const uint8_t *entry  = start + sizeof(size_t) * 2;
+
+   if (info & STATE_MGR_ENTRY_ZSTD)
+   {
+#ifdef STATE_MANAGER_HAVE_ZSTD
+      if (!state->scratch || !state_manager_zstd_decode(state->scratch,
+               state->scratchsize, entry, info >> STATE_MGR_ENTRY_SHIFT))
+         return false;
+      entry              = state->scratch;
+#else
+      return false;
+#endif
+   }
+
+   if (info & STATE_MGR_ENTRY_KEYFRAME)
+      memcpy(state->thisblock, entry, state->blocksize);
+   else
+      state_manager_raw_decompress(entry, state->thisblock);
+   return true;
+}
+
+static bool state_manager_is_keyframe(const uint8_t *start)
+{
+   return (read_size_t(start + sizeof(size_t))
+         & STATE_MGR_ENTRY_KEYFRAME) != 0;
+}
+
+/* Forgets all history in the buffer after an entry failed to decode;
+ * thisblock is left as it was. */
+static void state_manager_discard(state_manager_t *state)
+{
+   RARCH_ERR("[Rewind] Rewind buffer entry failed to decode, "
+         "discarding older history.\n");
+   state->head      = state->tail;
+   state->entries   = 0;
+   state->keyframes = 0;
+   state_manager_publish_stats(state);
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_push_do(state_manager_t *state);
+
+static void state_manager_worker(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+   for (;;)
+   {
+      while (!state->pending && !state->quit)
+         scond_wait(state->cond, state->lock);
+      if (state->quit)
+         break;
+      slock_unlock(state->lock);
+
+      state_manager_push_do(state);
+
+      slock_lock(state->lock);
+      state->pending = false;
+      scond_signal(state->cond);
+   }
+   slock_unlock(state->lock);
+}
+
+static bool state_manager_start_worker(state_manager_t *state)
+{
+   if (!(state->lock = slock_new()))
+      return false;
+   if (!(state->cond = scond_new()))
+      return false;
+   return (state->worker = sthread_create(state_manager_worker, state))
+      != NULL;
+}
+
+static void state_manager_stop_worker(state_manager_t *state)
+{
+   if (state->worker)
+   {
+      slock_lock(state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+      sthread_join(state->worker);
+   }
+   if (state->cond)
+      scond_free(state->cond);
+   if (state->lock)
+      slock_free(state->lock);
+   state->worker = NULL;
+   state->cond   = NULL;
+   state->lock   = NULL;
+}
+#endif
+
+/* Waits for the worker to finish pushing the last captured state,
+ * after which the blocks and the buffer may be touched again. */
+static void state_manager_drain(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (!state->worker)
+      return;
+   slock_lock(state->lock);
+   while (state->pending)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+#endif
+}
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   state_manager_stop_worker(state);
+#endif
+
    if (state->data)
       free(state->data);
    /* thisblock and nextblock share a single allocation;
@@ -422,6 +770,8 @@ static void state_manager_free(state_manager_t *state)
          base = state->nextblock;
       free(base);
    }
+   if (state->scratch)
+      free(state->scratch);
 #if STRICT_BUF_SIZE
    if (state->debugblock)
       free(state->debugblock);
@@ -430,10 +780,12 @@ static void state_manager_free(state_manager_t *state)
    state->data       = NULL;
    state->thisblock  = NULL;
    state->nextblock  = NULL;
+   state->scratch    = NULL;
 }
 
 static state_manager_t *state_manager_new(
-      size_t state_size, size_t buffer_size)
+      size_t state_size, size_t buffer_size, bool threaded,
+      bool compress, unsigned keyframe_interval)
 {
    size_t max_comp_size, block_size, alloc_size, single_block_alloc;
    uint8_t *block_buf     = NULL;
@@ -444,8 +796,10 @@ static state_manager_t *state_manager_new(
       return NULL;
 
    block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-   /* the compressed data is surrounded by pointers to the other side */
-   max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
+   /* the compressed data is surrounded by pointers to the other side,
+    * and starts with its size. A keyframe, or a frame, is only kept
+    * when it is no larger than a patch could be. */
+   max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 3;
    state_data         = (uint8_t*)malloc(buffer_size);
 
    if (!state_data)
@@ -485,11 +839,34 @@ static state_manager_t *state_manager_new(
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
 
+   state->keyframe_interval = keyframe_interval;
+
+#ifdef STATE_MANAGER_HAVE_ZSTD
+   /* Large enough for a frame of either, and to decode either into */
+   if (compress)
+   {
+      state->scratchsize = state_manager_zstd_bound(
+            state_manager_raw_maxsize(state_size));
+      if (!(state->scratch = (uint8_t*)malloc(state->scratchsize)))
+         RARCH_WARN("[Rewind] Failed to allocate compression buffer.\n");
+   }
+#endif
+
 #if STRICT_BUF_SIZE
    state->debugsize   = state_size;
    state->debugblock  = (uint8_t*)malloc(state_size);
 #endif
 
+#ifdef HAVE_THREADS
+   /* Failing to start the worker only costs the overlap */
+   if (threaded && !state_manager_start_worker(state))
+   {
+      RARCH_WARN("[Rewind] Failed to start capture thread.\n");
+      state_manager_stop_worker(state);
+   }
+#endif
+
+   state_manager_publish_stats(state);
    return state;
 
 error:
@@ -505,16 +882,17 @@ error:
 static bool state_manager_pop(state_manager_t *state, const void **data)
 {
    size_t start;
-   uint8_t *out                 = NULL;
-   const uint8_t *compressed    = NULL;
 
    *data                        = NULL;
 
+   state_manager_drain(state);
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid    = false;
       state->entries--;
       *data                     = state->thisblock;
+      state_manager_publish_stats(state);
       return true;
    }
 
@@ -523,22 +901,101 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
       return false;
 
    start                        = read_size_t(state->head - sizeof(size_t));
-   state->head                  = state->data + start;
-   compressed                   = state->data + start + sizeof(size_t);
-   out                          = state->thisblock;
 
-   state_manager_raw_decompress(compressed, out);
+   if (!state_manager_apply(state, state->data + start))
+   {
+      state_manager_discard(state);
+      return false;
+   }
 
+   if (state_manager_is_keyframe(state->data + start))
+      state->keyframes--;
+   state->head                  = state->data + start;
    state->entries--;
+   state_manager_publish_stats(state);
    return true;
 }
 
+/*
+ * Goes back 'steps' entries, leaving the same thisblock and buffer as
+ * that many calls to state_manager_pop() would; but if there is a
+ * keyframe among them, decoding starts at the oldest one rather than
+ * at the head.
+ *
+ * Returns the number of entries gone back.
+ */
+static unsigned state_manager_seek_do(state_manager_t *state,
+      unsigned steps)
+{
+   unsigned depth, i;
+   unsigned done      = 0;
+   unsigned keyframes = 0;
+   unsigned key_depth = 0;
+   uint8_t *key       = NULL;
+   uint8_t *pos       = NULL;
+
+   state_manager_drain(state);
+
+   if (steps && state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      steps--;
+      done++;
+   }
+
+   /* Only the links are read on the way down */
+   pos = state->head;
+   for (depth = 0; depth < steps && pos != state->tail; depth++)
+   {
+      pos = state->data + read_size_t(pos - sizeof(size_t));
+      if (state_manager_is_keyframe(pos))
+      {
+         key       = pos;
+         key_depth = depth + 1;
+         keyframes++;
+      }
+   }
+
+   if (key)
+   {
+      if (!state_manager_apply(state, key))
+         goto error;
+      pos = key;
+      i   = key_depth;
+   }
+   else
+   {
+      pos = state->head;
+      i   = 0;
+   }
+
+   for (; i < depth; i++)
+   {
+      pos = state->data + read_size_t(pos - sizeof(size_t));
+      if (!state_manager_apply(state, pos))
+         goto error;
+   }
+
+   state->head       = pos;
+   state->entries   -= depth;
+   state->keyframes -= keyframes;
+   state_manager_publish_stats(state);
+   return done + depth;
+
+error:
+   state_manager_discard(state);
+   return done;
+}
+
 static void state_manager_push_where(state_manager_t *state, void **data)
 {
    /* We need to ensure we have an uncompressed copy of the last
     * pushed state, or we could end up applying a 'patch' to wrong
     * savestate, and that'd blow up rather quickly. */
 
+   state_manager_drain(state);
+
    if (!state->thisblock_valid)
    {
       const void *ignored;
@@ -565,9 +1022,9 @@ static void state_manager_push_do(state_manager_t *state)
 
    if (state->thisblock_valid)
    {
-      uint8_t *compressed;
-      const uint8_t *oldb, *newb;
-      size_t headpos, tailpos, remaining;
+      uint8_t *compressed, *entry;
+      size_t headpos, tailpos, remaining, len;
+      size_t flags = 0;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
       {
          RARCH_ERR("[Rewind] %s.\n",
@@ -583,23 +1040,49 @@ recheckcapacity:;
 
       if (remaining <= state->maxcompsize)
       {
+         if (state_manager_is_keyframe(state->tail))
+            state->keyframes--;
          state->tail = state->data + read_size_t(state->tail);
          state->entries--;
          goto recheckcapacity;
       }
 
-      oldb              = state->thisblock;
-      newb              = state->nextblock;
-      compressed        = state->head + sizeof(size_t);
+      entry             = state->head + sizeof(size_t) * 2;
+
+      if (     state->keyframe_interval
+            && ++state->since_keyframe >= state->keyframe_interval)
+      {
+         flags                 = STATE_MGR_ENTRY_KEYFRAME;
+         len                   = state_manager_store(state,
+               state->thisblock, state->blocksize, entry, &flags);
+         state->since_keyframe = 0;
+         state->keyframes++;
+      }
+      else
+      {
+         len                   = state_manager_raw_compress(
+               state->thisblock, state->nextblock, state->blocksize, entry);
+#ifdef STATE_MANAGER_HAVE_ZSTD
+         if (state->scratch)
+            len                = state_manager_store(state,
+                  entry, len, entry, &flags);
+#endif
+      }
 
-      compressed       += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
+      write_size_t(state->head + sizeof(size_t),
+            (len << STATE_MGR_ENTRY_SHIFT) | flags);
+      compressed        = entry + ((len + 1) & ~(size_t)1);
 
       if (compressed - state->data + state->maxcompsize > state->capacity)
       {
          compressed     = state->data;
          if (state->tail == state->data + sizeof(size_t))
+         {
+            if (state_manager_is_keyframe(state->tail))
+               state->keyframes--;
             state->tail = state->data + read_size_t(state->tail);
+            state->entries--;
+         }
       }
       write_size_t(compressed, state->head-state->data);
       compressed       += sizeof(size_t);
@@ -614,11 +1097,31 @@ recheckcapacity:;
    state->nextblock          = swap;
 
    state->entries++;
+   state_manager_publish_stats(state);
+}
+
+/* Pushes the state captured into nextblock, on the worker if there
+ * is one. The emulation thread may then run the next frame; the next
+ * push_where() or pop() waits for the push to complete. */
+static void state_manager_push_async(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (state->worker)
+   {
+      slock_lock(state->lock);
+      state->pending = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+      return;
+   }
+#endif
+   state_manager_push_do(state);
 }
 
 void state_manager_event_init(
       struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size)
+      unsigned rewind_buffer_size, bool threaded, bool compress,
+      unsigned keyframe_interval)
 {
    core_info_t *core_info = NULL;
    void *state            = NULL;
@@ -673,11 +1176,14 @@ void state_manager_event_init(
          (unsigned)(rewind_buffer_size / 1000000));
 
    rewind_st->state = state_manager_new(rewind_st->size,
-         rewind_buffer_size);
+         rewind_buffer_size, threaded, compress, keyframe_interval);
 
    if (!rewind_st->state)
+   {
       RARCH_WARN("[Rewind] %s.\n",
             msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+      return;
+   }
 
    state_manager_push_where(rewind_st->state, &state);
 
@@ -686,6 +1192,43 @@ void state_manager_event_init(
    state_manager_push_do(rewind_st->state);
 }
 
+unsigned state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned entries)
+{
+   unsigned done;
+
+   if (!rewind_st || !rewind_st->state || !entries)
+      return 0;
+   /* A replay keeps its frame count in step one pop at a time */
+   if (retroarch_ctl(RARCH_CTL_BSV_MOVIE_IS_INITED, NULL))
+      return 0;
+
+   if ((done = state_manager_seek_do(rewind_st->state, entries)))
+      content_deserialize_state(rewind_st->state->thisblock,
+            rewind_st->size);
+   return done;
+}
+
+bool state_manager_get_stats(struct state_manager_rewind_state *rewind_st,
+      state_manager_stats_t *stats)
+{
+   state_manager_t *state;
+
+   if (!rewind_st || !(state = rewind_st->state))
+      return false;
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+      slock_lock(state->lock);
+#endif
+   *stats = state->stats;
+#ifdef HAVE_THREADS
+   if (state->lock)
+      slock_unlock(state->lock);
+#endif
+   return true;
+}
+
 void state_manager_event_deinit(
       struct state_manager_rewind_state *rewind_st,
       struct retro_core_t *current_core)
@@ -860,7 +1403,7 @@ bool state_manager_check_rewind(
 
          content_serialize_state_rewind(state, rewind_st->size);
 
-         state_manager_push_do(rewind_st->state);
+         state_manager_push_async(rewind_st->state);
       }
    }
 
@@ -24,6 +24,10 @@
 #include <boolean.h>
 #include <retro_common_api.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "dynamic.h"
 
 RETRO_BEGIN_DECLS
@@ -36,6 +40,16 @@ enum state_manager_rewind_st_flags
    STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED    = (1 << 3)
 };
 
+/* What the rewind buffer holds, for the statistics overlay */
+typedef struct state_manager_stats
+{
+   size_t used;          /* bytes of the buffer taken by history */
+   size_t capacity;
+   unsigned entries;     /* states that can be rewound to */
+   unsigned keyframes;   /* of those, the ones stored whole */
+   bool compressed;
+} state_manager_stats_t;
+
 struct state_manager
 {
    uint8_t *data;
@@ -46,6 +60,9 @@ struct state_manager
 
    uint8_t *thisblock;
    uint8_t *nextblock;
+   /* Zstandard frames are built and decoded here; NULL unless
+    * compressing. */
+   uint8_t *scratch;
 #if STRICT_BUF_SIZE
    uint8_t *debugblock;
    size_t debugsize;
@@ -58,8 +75,29 @@ struct state_manager
     * (blocksize + u16 + u16) + u16 + u32 + size_t
     * (yes, the math is a bit ugly). */
    size_t maxcompsize;
+   size_t scratchsize;
+
+#ifdef HAVE_THREADS
+   /* Threaded capture: the emulation thread only serializes into
+    * nextblock; diffing it against thisblock, writing the patch and
+    * swapping the two blocks happen on the worker while the next
+    * frame runs. Everything above belongs to the worker while
+    * 'pending' is set. */
+   sthread_t *worker;
+   slock_t *lock;
+   scond_t *cond;
+   bool pending;
+   bool quit;
+#endif
+
+   state_manager_stats_t stats;
 
    unsigned entries;
+   unsigned keyframes;
+   /* Every this many entries the older state is stored whole
+    * instead of as a patch; 0 for never. */
+   unsigned keyframe_interval;
+   unsigned since_keyframe;
    bool thisblock_valid;
 };
 
@@ -73,14 +111,95 @@ struct state_manager_rewind_state
    uint8_t flags;
 };
 
+/* Bytes state_manager_patch_create() needs writable past the end of
+ * both of its buffers: the rounding byte, four sentinel words and the
+ * scanners' overread. Keep in step with STATE_MANAGER_SCAN_PAD. */
+#define STATE_MANAGER_PATCH_PAD (1 + sizeof(uint16_t) * 4 + 64)
+
+/**
+ * state_manager_patch_maxsize:
+ * @len                  : size of the states to be diffed
+ *
+ * Returns: the most bytes state_manager_patch_create() can write.
+ **/
+size_t state_manager_patch_maxsize(size_t len);
+
+/**
+ * state_manager_patch_create:
+ * @base                 : state the receiver already holds
+ * @data                 : state to be reproduced
+ * @len                  : size of both states
+ * @patch                : at least state_manager_patch_maxsize(@len) bytes
+ *
+ * Diffs two states with the rewind buffer's block scanners. Both
+ * buffers must have STATE_MANAGER_PATCH_PAD bytes of scratch after
+ * @len, which are overwritten. The patch is little endian.
+ *
+ * Returns: the number of bytes written to @patch.
+ **/
+size_t state_manager_patch_create(void *base, void *data, size_t len,
+      void *patch);
+
+/**
+ * state_manager_patch_apply:
+ * @patch                : output of state_manager_patch_create()
+ * @patch_len            : its size
+ * @data                 : @base from that call, patched in place
+ * @len                  : size of the state; @data must hold @len
+ *                         rounded up to an even number of bytes
+ *
+ * Bounds-checked, for patches that came from elsewhere.
+ *
+ * Returns: true if the patch was well-formed and fully applied.
+ **/
+bool state_manager_patch_apply(const void *patch, size_t patch_len,
+      void *data, size_t len);
+
 bool state_manager_frame_is_reversed(void);
 
 void state_manager_event_deinit(
       struct state_manager_rewind_state *rewind_st,
       struct retro_core_t *current_core);
 
+/**
+ * state_manager_event_init:
+ * @rewind_buffer_size   : bytes of compressed history to keep
+ * @threaded             : compress captured states on a worker thread;
+ *                         ignored without HAVE_THREADS
+ * @compress             : also pass each entry through Zstandard;
+ *                         ignored without HAVE_ZSTD or HAVE_RZSTD
+ * @keyframe_interval    : store every this many states whole, so that
+ *                         state_manager_seek() need not replay every
+ *                         patch; 0 for never
+ **/
 void state_manager_event_init(struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size);
+      unsigned rewind_buffer_size, bool threaded, bool compress,
+      unsigned keyframe_interval);
+
+/**
+ * state_manager_seek:
+ * @entries              : captured states to go back
+ *
+ * Loads the state captured @entries captures ago, or the oldest one
+ * held, into the core, and drops the history after it as rewinding
+ * there one step at a time would. Decoding starts from the newest
+ * keyframe on the way rather than from the present.
+ *
+ * Returns: the number of captures actually gone back.
+ **/
+unsigned state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned entries);
+
+/**
+ * state_manager_get_stats:
+ *
+ * Safe to call while the capture thread is busy; reports the
+ * buffer as of the last completed capture or rewind.
+ *
+ * Returns: false if there is no rewind buffer.
+ **/
+bool state_manager_get_stats(struct state_manager_rewind_state *rewind_st,
+      state_manager_stats_t *stats);
 
 /**
  * check_rewind:
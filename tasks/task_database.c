@@ -28,6 +28,7 @@
 #include <formats/rm3u.h>
 #include <formats/rm3u_stream.h>
 #include <encodings/crc32.h>
+#include <features/features_cpu.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
 #include "tasks_internal.h"
@@ -48,6 +49,8 @@
 #include "../retroarch.h"
 #include "../verbosity.h"
 #include "task_database_cue.h"
+#include "task_database_hash.h"
+#include "task_database_scan_cache.h"
 
 /* Scan result structure for accumulating identification results */
 typedef struct scan_result
@@ -263,7 +266,10 @@ enum db_flags_enum
    DB_HANDLE_FLAG_SCAN_WITHOUT_CORE_MATCH = (1 << 2),
    DB_HANDLE_FLAG_SHOW_HIDDEN_FILES       = (1 << 3),
    DB_HANDLE_FLAG_USE_FIRST_MATCH_ONLY    = (1 << 4),
-   DB_HANDLE_FLAG_DO_MENU_REFRESH         = (1 << 5)
+   DB_HANDLE_FLAG_DO_MENU_REFRESH         = (1 << 5),
+   /* The read-ahead pool has been tried for this scan, whether or
+    * not one could be started */
+   DB_HANDLE_FLAG_HASH_STARTED            = (1 << 6)
 };
 
 enum manual_scan_status
@@ -339,6 +345,12 @@ typedef struct manual_scan_handle
    char *content_database_path;
    database_info_handle_t *handle;
    database_state_handle_t state;
+   /* Reads content files ahead of the matcher; NULL when they are
+    * read inline.  See task_database_hash.c. */
+   task_database_hash_t *hash;
+   /* What earlier scans read; NULL if it could not be opened.  See
+    * task_database_scan_cache.c. */
+   task_database_scan_cache_t *scan_cache;
    uint8_t flags;
 #endif
    /* The caller's completion callback, run after the task's own.
@@ -824,44 +836,81 @@ static void gdi_prune(struct string_list *list, const char *name)
    free(fd);
 }
 
-static enum msg_file_type extension_to_file_type(const char *ext)
+/* Moves the database at list_index to the front of the list, with
+ * everything kept per database, and leaves list_index on it */
+static void task_database_state_promote(database_state_handle_t *db_state)
 {
-   char ext_lower[6];
-   strlcpy(ext_lower, ext, sizeof(ext_lower));
-   string_to_lower(ext_lower);
-
-   /* These were memcmp() against a fixed count, which is specified to
-    * read all n bytes.  For an extension shorter than the count - an
-    * empty extension being the common case - those bytes are
-    * uninitialised stack, which MSan reports and which vectorised
-    * memcmp() implementations really do load.  string_is_equal()
-    * stops at the terminator. */
-   if (
-            string_is_equal(ext_lower, "7z")
-         || string_is_equal(ext_lower, "zip")
-         || string_is_equal(ext_lower, "apk")
-         || string_is_equal(ext_lower, "zst")
-      )
-      return FILE_TYPE_COMPRESSED;
-   if (string_is_equal(ext_lower, "cue"))
-      return FILE_TYPE_CUE;
-   if (string_is_equal(ext_lower, "gdi"))
-      return FILE_TYPE_GDI;
-   if (string_is_equal(ext_lower, "iso"))
-      return FILE_TYPE_ISO;
-   if (string_is_equal(ext_lower, "chd"))
-      return FILE_TYPE_CHD;
-   if (string_is_equal(ext_lower, "wbfs"))
-      return FILE_TYPE_WBFS;
-   if (string_is_equal(ext_lower, "rvz"))
-      return FILE_TYPE_RVZ;
-   if (string_is_equal(ext_lower, "wia"))
-      return FILE_TYPE_WIA;
-   if (string_is_equal(ext_lower, "pbp"))
-      return FILE_TYPE_PBP;
-   if (string_is_equal(ext_lower, "lutro"))
-      return FILE_TYPE_LUTRO;
-   return FILE_TYPE_NONE;
+   struct string_list_elem entry =
+      db_state->list->elems[db_state->list_index];
+   uint64_t min = db_state->min_sizes[db_state->list_index];
+   uint64_t max = db_state->max_sizes[db_state->list_index];
+   uint8_t flag = db_state->flags[db_state->list_index];
+   memmove(&db_state->list->elems[1],
+           &db_state->list->elems[0],
+           sizeof(entry) * db_state->list_index);
+   memmove(&db_state->min_sizes[1],
+           &db_state->min_sizes[0],
+           sizeof(min) * db_state->list_index);
+   memmove(&db_state->max_sizes[1],
+           &db_state->max_sizes[0],
+           sizeof(max) * db_state->list_index);
+   memmove(&db_state->flags[1],
+           &db_state->flags[0],
+           sizeof(flag) * db_state->list_index);
+
+   /* The index caches are keyed by the same position, so they have
+    * to travel with the entry.  Leaving them behind pairs a
+    * database with another database's index, and the lookup then
+    * answers with records that belong to a different system. */
+   {
+      database_info_crc_index_t    *ci =
+         db_state->crc_index[db_state->list_index];
+      database_info_serial_index_t *si =
+         db_state->serial_index[db_state->list_index];
+
+      memmove(&db_state->crc_index[1],
+              &db_state->crc_index[0],
+              sizeof(ci) * db_state->list_index);
+      memmove(&db_state->serial_index[1],
+              &db_state->serial_index[0],
+              sizeof(si) * db_state->list_index);
+
+      db_state->crc_index[0]    = ci;
+      db_state->serial_index[0] = si;
+   }
+
+   db_state->list->elems[0] = entry;
+   db_state->min_sizes[0]   = min;
+   db_state->max_sizes[0]   = max;
+   db_state->flags[0]       = flag;
+   db_state->list_index     = 0;
+}
+
+/* Tries the database @db, a basename, first for the next content file:
+ * the one the file matched when the scan cache last saw it.  Under
+ * "first match only" the front of the list is the scan's chosen
+ * database and stays put. */
+static void task_database_state_promote_hint(manual_scan_handle_t *_db,
+      database_state_handle_t *db_state, const char *db)
+{
+   size_t i;
+
+   if (     !db
+         || !db_state->list
+         || db_state->list_index != 0
+         || (_db->flags & DB_HANDLE_FLAG_USE_FIRST_MATCH_ONLY))
+      return;
+
+   for (i = 1; i < db_state->list->size; i++)
+   {
+      const char *rdb = db_state->list->elems[i].data;
+      if (rdb && string_is_equal(path_basename_nocompression(rdb), db))
+      {
+         db_state->list_index = i;
+         task_database_state_promote(db_state);
+         break;
+      }
+   }
 }
 
 static int task_database_iterate_playlist(
@@ -869,93 +918,39 @@ static int task_database_iterate_playlist(
       database_state_handle_t *db_state,
       database_info_handle_t *db, const char *name)
 {
-   switch (extension_to_file_type(path_get_extension(name)))
+   task_database_hash_result_t res;
+
+   switch (task_database_file_type(name))
    {
-      case FILE_TYPE_COMPRESSED:
-#ifdef HAVE_COMPRESSION
-         db->type = DATABASE_TYPE_CRC_LOOKUP;
-         /* first check crc of archive itself */
-         return intfstream_file_get_crc_and_size(name,
-               0, INT64_MAX, &db_state->archive_crc,
-               &db_state->archive_size);
-#else
-         break;
-#endif
       case FILE_TYPE_CUE:
          task_database_cue_prune(_db->content_list, name);
-         db_state->serial[0] = '\0';
-         if (task_database_cue_get_serial(name, db_state->serial,
-             sizeof(db_state->serial),&db_state->size))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            db_state->serial[0] = '\0';
-            RARCH_DBG("[Scanner] CUE file serial not detected, fallback to crc.\n");
-            return task_database_cue_get_crc_and_size(name, &db_state->crc, &db_state->size);
-         }
          break;
       case FILE_TYPE_GDI:
          gdi_prune(_db->content_list, name);
-         db_state->serial[0] = '\0';
-         if (task_database_gdi_get_serial(name, db_state->serial, 
-             sizeof(db_state->serial),&db_state->size))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            db_state->serial[0] = '\0';
-            RARCH_DBG("[Scanner] GDI file serial not detected, fallback to crc.\n");
-            return task_database_gdi_get_crc_and_size(name, &db_state->crc, &db_state->size);
-         }
-         break;
-      /* Consider WBFS, RVZ and WIA files similar to ISO files. */
-      case FILE_TYPE_WBFS:
-      case FILE_TYPE_RVZ:
-      case FILE_TYPE_WIA:
-         db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, INT64_MAX, db_state->serial, sizeof(db_state->serial),&db_state->size);
-         db->type            =  DATABASE_TYPE_SERIAL_LOOKUP;
-         break;
-      case FILE_TYPE_ISO:
-         db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, INT64_MAX, db_state->serial, sizeof(db_state->serial),&db_state->size);
-         db->type            =  DATABASE_TYPE_SERIAL_LOOKUP_SIZEHINT;
-         break;
-      case FILE_TYPE_CHD:
-         db_state->serial[0] = '\0';
-         if (task_database_chd_get_serial(name, db_state->serial, sizeof(db_state->serial),&db_state->size))
-            db->type         = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type         = DATABASE_TYPE_CRC_LOOKUP;
-            db_state->serial[0] = '\0';
-            RARCH_DBG("[Scanner] CHD file serial not detected, fallback to crc.\n");
-            return task_database_chd_get_crc_and_size(name, &db_state->crc, &db_state->size);
-         }
-         break;
-      case FILE_TYPE_PBP:
-         db_state->serial[0] = '\0';
-         if (task_database_pbp_get_serial(name, db_state->serial, sizeof(db_state->serial),&db_state->size))
-            db->type         = DATABASE_TYPE_SERIAL_LOOKUP;
-         else
-         {
-            db->type         = DATABASE_TYPE_CRC_LOOKUP;
-            db_state->serial[0] = '\0';
-            RARCH_DBG("[Scanner] PBP file serial not detected, fallback to crc.\n");
-            return intfstream_file_get_crc_and_size(name, 0, INT64_MAX, &db_state->crc, &db_state->size);
-         }
-         break;
-      case FILE_TYPE_LUTRO:
-         db->type            = DATABASE_TYPE_ITERATE_LUTRO;
          break;
       default:
-         db_state->serial[0] = '\0';
-         db->type            = DATABASE_TYPE_CRC_LOOKUP;
-         return intfstream_file_get_crc_and_size(name, 0, INT64_MAX, &db_state->crc, &db_state->size);
+         break;
    }
 
-   return 1;
+   res.serial     = db_state->serial;
+   res.serial_len = sizeof(db_state->serial);
+
+   /* Read ahead by the pool when there is one, else here */
+   if (!task_database_hash_take(_db->hash,
+         _db->content_list_index, name, &res))
+      task_database_hash_content(name, _db->scan_cache, &res);
+
+   task_database_scan_cache_store(_db->scan_cache, name, &res);
+   task_database_state_promote_hint(_db, db_state,
+         task_database_scan_cache_match(_db->scan_cache, name));
+
+   db->type               = res.type;
+   db_state->crc          = res.crc;
+   db_state->size         = res.size;
+   db_state->archive_crc  = res.archive_crc;
+   db_state->archive_size = res.archive_size;
+
+   return res.ret;
 }
 #endif
 static bool add_files_from_archive(manual_scan_handle_t *_db,
@@ -1136,6 +1131,10 @@ static enum scan_verdict database_info_list_iterate_found_match(
    db_crc[0]                      = '\0';
    entry_path_str[0]              = '\0';
 
+   /* Before the label code below cuts entry_path at the archive
+    * delimiter */
+   task_database_scan_cache_set_match(_db->scan_cache, entry_path, db_path);
+
    fill_pathname(db_playlist_base_str,
          path_basename_nocompression(db_path), ".lpl", sizeof(db_playlist_base_str));
 
@@ -1209,50 +1208,8 @@ static enum scan_verdict database_info_list_iterate_found_match(
       again */
    if (db_state->list_index != 0)
    {
-      struct string_list_elem entry =
-         db_state->list->elems[db_state->list_index];
-      uint64_t min = db_state->min_sizes[db_state->list_index];
-      uint64_t max = db_state->max_sizes[db_state->list_index];
-      uint8_t flag = db_state->flags[db_state->list_index];
-      memmove(&db_state->list->elems[1],
-              &db_state->list->elems[0],
-              sizeof(entry) * db_state->list_index);
-      memmove(&db_state->min_sizes[1],
-              &db_state->min_sizes[0],
-              sizeof(min) * db_state->list_index);
-      memmove(&db_state->max_sizes[1],
-              &db_state->max_sizes[0],
-              sizeof(max) * db_state->list_index);
-      memmove(&db_state->flags[1],
-              &db_state->flags[0],
-              sizeof(flag) * db_state->list_index);
-
-      /* The index caches are keyed by the same position, so they have
-       * to travel with the entry.  Leaving them behind pairs a
-       * database with another database's index, and the lookup then
-       * answers with records that belong to a different system. */
-      {
-         database_info_crc_index_t    *ci =
-            db_state->crc_index[db_state->list_index];
-         database_info_serial_index_t *si =
-            db_state->serial_index[db_state->list_index];
-
-         memmove(&db_state->crc_index[1],
-                 &db_state->crc_index[0],
-                 sizeof(ci) * db_state->list_index);
-         memmove(&db_state->serial_index[1],
-                 &db_state->serial_index[0],
-                 sizeof(si) * db_state->list_index);
-
-         db_state->crc_index[0]    = ci;
-         db_state->serial_index[0] = si;
-      }
-
-      db_state->list->elems[0] = entry;
-      db_state->min_sizes[0]   = min;
-      db_state->max_sizes[0]   = max;
-      db_state->flags[0]       = flag;
-      db_state->flags[0]      |= DB_STATE_FLAG_MATCHED;
+      task_database_state_promote(db_state);
+      db_state->flags[0] |= DB_STATE_FLAG_MATCHED;
    }
 
    if (db_crc != db_crc_buf)
@@ -1877,7 +1834,7 @@ serial_query_done:
                {
                   if (db_state->crc == 0)
                   {
-                     if (extension_to_file_type(path_get_extension(name)) == FILE_TYPE_GDI)
+                     if (task_database_file_type(name) == FILE_TYPE_GDI)
                         task_database_gdi_get_crc_and_size(name, &db_state->crc, &db_state->size);
                      else
                         intfstream_file_get_crc_and_size(name, 0, INT64_MAX, &db_state->crc, &db_state->size);
@@ -1959,6 +1916,42 @@ static int task_database_iterate(
    return SCAN_VERDICT_ERROR;
 }
 
+/* Archive members skip task_database_iterate_playlist(): the crc
+ * lookup reads their crc from the archive on first use.  Hand it the
+ * one the pool read ahead, or the scan cache recorded, if there is
+ * one; reading it here otherwise costs the same as reading it there,
+ * and lets the cache record it. */
+static void task_database_take_archive_crc(manual_scan_handle_t *_db,
+      database_state_handle_t *db_state, const char *name)
+{
+   task_database_hash_result_t res;
+   char serial[4];
+
+   if (db_state->crc)
+      return;
+
+   res.serial     = serial;
+   res.serial_len = sizeof(serial);
+
+   if (!task_database_hash_take(_db->hash,
+            _db->content_list_index, name, &res))
+   {
+      /* Nothing to record it in: leave it to the lookup, as before */
+      if (!_db->scan_cache)
+         return;
+      task_database_hash_content(name, _db->scan_cache, &res);
+   }
+
+   if (res.type == DATABASE_TYPE_ITERATE_ARCHIVE && res.crc)
+   {
+      task_database_scan_cache_store(_db->scan_cache, name, &res);
+      task_database_state_promote_hint(_db, db_state,
+            task_database_scan_cache_match(_db->scan_cache, name));
+      db_state->crc  = res.crc;
+      db_state->size = res.size;
+   }
+}
+
 static void task_database_cleanup_state(database_state_handle_t *db_state)
 {
    if (!db_state)
@@ -2416,6 +2409,12 @@ static void free_manual_content_scan_handle(manual_scan_handle_t *manual_scan)
          dbstate->flags     = NULL;
       }
 
+      task_database_hash_free(manual_scan->hash);
+      manual_scan->hash = NULL;
+
+      task_database_scan_cache_unref(manual_scan->scan_cache);
+      manual_scan->scan_cache = NULL;
+
       if (manual_scan->content_database_path)
          free(manual_scan->content_database_path);
       manual_scan->content_database_path = NULL;
@@ -3050,7 +3049,7 @@ static bool task_manual_scan_begin_tick(retro_task_t *task,
    return error;
 }
 
-static void task_manual_content_scan_handler(retro_task_t *task)
+static void task_manual_content_scan_step(retro_task_t *task)
 {
    uint8_t flg;
    manual_scan_handle_t *manual_scan = NULL;
@@ -3198,6 +3197,25 @@ static void task_manual_content_scan_handler(retro_task_t *task)
                if (manual_scan->m3u_list)
                   string_list_append(manual_scan->m3u_list, content_path, attr);
             }
+            /* The content list is complete by the first file of the
+             * matching pass, so the pool can start reading ahead */
+            if (!(manual_scan->flags & DB_HANDLE_FLAG_HASH_STARTED))
+            {
+               char cache_path[PATH_MAX_LENGTH];
+
+               fill_pathname_join_special(cache_path,
+                     manual_scan->playlist_directory,
+                     FILE_PATH_CONTENT_SCAN_CACHE, sizeof(cache_path));
+
+               manual_scan->flags     |= DB_HANDLE_FLAG_HASH_STARTED;
+               manual_scan->scan_cache = task_database_scan_cache_open(
+                     cache_path);
+               manual_scan->hash       = task_database_hash_new(
+                     manual_scan->content_list,
+                     cpu_features_get_core_amount(),
+                     manual_scan->scan_cache);
+            }
+
             task_database_cleanup_state(dbstate);
             dbstate->list_index  = 0;
             dbstate->entry_index = 0;
@@ -3221,7 +3239,11 @@ static void task_manual_content_scan_handler(retro_task_t *task)
             /* Reminder - remove this shortcut when serial scan inside zip is solved */
             if (path_contains_compressed_file)
                if (dbinfo->type == DATABASE_TYPE_ITERATE)
+               {
                   dbinfo->type   = DATABASE_TYPE_ITERATE_ARCHIVE;
+                  task_database_take_archive_crc(manual_scan, dbstate,
+                        content_path);
+               }
 
             current_verdict = (enum scan_verdict)task_database_iterate(manual_scan, content_path, dbstate, dbinfo,
                      path_contains_compressed_file);
@@ -3430,6 +3452,20 @@ static void task_manual_content_scan_handler(retro_task_t *task)
          {
             const char *msg = NULL;
 
+#ifdef HAVE_LIBRETRODB
+            /* Every file under the content directory has been seen,
+             * so whatever the cache holds there and this scan did not
+             * record is gone.  A cancelled scan never gets here and
+             * leaves the cache as it was. */
+            if (manual_scan->scan_cache)
+            {
+               task_database_scan_cache_write(manual_scan->scan_cache,
+                     manual_scan->task_config->content_dir);
+               task_database_scan_cache_unref(manual_scan->scan_cache);
+               manual_scan->scan_cache = NULL;
+            }
+#endif
+
             /* Batch update all playlists with accumulated results,
              * spread across gathers under the shared window. */
             if (manual_scan->scan_results.count > 0)
@@ -3504,6 +3540,67 @@ task_finished:
       task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
 }
 
+#ifdef HAVE_LIBRETRODB
+/* Whether the next step of the matching pass runs without reading
+ * content inline: it is bookkeeping or a database probe, or the file
+ * it would read is already waiting in the pool. */
+static bool task_manual_content_scan_batchable(
+      manual_scan_handle_t *manual_scan)
+{
+   const char *content_path = NULL;
+
+   switch (manual_scan->status)
+   {
+      case DATABASE_SCAN_ITERATE_START:
+      case DATABASE_SCAN_ITERATE_NEXT:
+         return true;
+      case DATABASE_SCAN_ITERATE_CONTENT:
+         if (manual_scan->handle->type != DATABASE_TYPE_ITERATE)
+            return true;
+         content_path = manual_scan->content_list->elems[
+               manual_scan->content_list_index].data;
+         return content_path && task_database_hash_ready(
+               manual_scan->hash, manual_scan->content_list_index,
+               content_path);
+      default:
+         break;
+   }
+
+   return false;
+}
+#endif
+
+static void task_manual_content_scan_handler(retro_task_t *task)
+{
+#ifdef HAVE_LIBRETRODB
+   nbio_budget_t b;
+   manual_scan_handle_t *manual_scan = task
+      ? (manual_scan_handle_t*)task->state : NULL;
+
+   /* One step per tick suits reading content inline, where a step is
+    * a whole file.  With the pool reading ahead, most steps are a
+    * lookup, and a step per tick would pace the scan by the ticks
+    * rather than the disk: keep stepping while results are waiting,
+    * under the same shared window as the BEGIN family. */
+   if (manual_scan && manual_scan->hash)
+   {
+      task_nbio_slice_open(&b);
+      /* The first step below is this tick's floor item */
+      b.floor = 0;
+      do
+      {
+         task_manual_content_scan_step(task);
+      } while (   !(task_get_flags(task) & RETRO_TASK_FLG_FINISHED)
+               && task_manual_content_scan_batchable(manual_scan)
+               && task_nbio_slice_within_budget(&b, 0, 0));
+      task_nbio_slice_close(&b);
+      return;
+   }
+#endif
+
+   task_manual_content_scan_step(task);
+}
+
 static bool task_manual_content_scan_finder(retro_task_t *task, void *user_data)
 {
    manual_scan_handle_t *manual_scan = NULL;
@@ -0,0 +1,539 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Content identification for the database scanner, and a pool that
+ * runs it ahead of the scan.
+ *
+ * Matching a content file against the databases is cheap once the
+ * indexes are built; reading it to get its crc or serial is not, and
+ * used to happen on the task thread one file per tick.  The pool
+ * reads the next few files of the content list on threads of its own
+ * while the task thread matches the ones already read, so on a large
+ * library the scan is bound by the disk rather than by the ticks.
+ *
+ * Results are only a faster route to the same keys: anything the
+ * pool did not produce is read inline by the scanner as before. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <file/file_path.h>
+#include <string/stdstring.h>
+#ifdef HAVE_COMPRESSION
+#include <file/archive_file.h>
+#endif
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "../verbosity.h"
+#include "task_database_cue.h"
+#include "task_database_hash.h"
+#include "task_database_scan_cache.h"
+
+enum task_database_hash_slot_state
+{
+   HASH_SLOT_FREE = 0,
+   HASH_SLOT_BUSY,
+   HASH_SLOT_DONE
+};
+
+typedef struct task_database_hash_slot
+{
+   task_database_hash_result_t res;
+   size_t index;
+   enum task_database_hash_slot_state state;
+   char serial[4096]; /* as database_state_handle_t */
+} task_database_hash_slot_t;
+
+struct task_database_hash
+{
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond;
+#endif
+   /* Snapshot of the content list; NULL for pruned entries */
+   char **paths;
+   /* Set for entries a cue or gdi sheet already read lists as its
+    * tracks.  The scanner prunes those when it gets to the sheet;
+    * this only keeps the pool from reading them first. */
+   uint8_t *skip;
+   size_t count;
+   /* Next entry to hand to a reader */
+   size_t next;
+   /* Lowest entry the scanner may still take */
+   size_t consumed;
+   task_database_scan_cache_t *cache;
+   /* Threads still running plus the owner */
+   unsigned refs;
+   bool quit;
+   task_database_hash_slot_t slots[TASK_DATABASE_HASH_WINDOW];
+};
+
+enum msg_file_type task_database_file_type(const char *path)
+{
+   char ext_lower[6];
+   const char *ext = path_get_extension(path);
+   strlcpy(ext_lower, ext, sizeof(ext_lower));
+   string_to_lower(ext_lower);
+
+   /* These were memcmp() against a fixed count, which is specified to
+    * read all n bytes.  For an extension shorter than the count - an
+    * empty extension being the common case - those bytes are
+    * uninitialised stack, which MSan reports and which vectorised
+    * memcmp() implementations really do load.  string_is_equal()
+    * stops at the terminator. */
+   if (
+            string_is_equal(ext_lower, "7z")
+         || string_is_equal(ext_lower, "zip")
+         || string_is_equal(ext_lower, "apk")
+         || string_is_equal(ext_lower, "zst")
+      )
+      return FILE_TYPE_COMPRESSED;
+   if (string_is_equal(ext_lower, "cue"))
+      return FILE_TYPE_CUE;
+   if (string_is_equal(ext_lower, "gdi"))
+      return FILE_TYPE_GDI;
+   if (string_is_equal(ext_lower, "iso"))
+      return FILE_TYPE_ISO;
+   if (string_is_equal(ext_lower, "chd"))
+      return FILE_TYPE_CHD;
+   if (string_is_equal(ext_lower, "wbfs"))
+      return FILE_TYPE_WBFS;
+   if (string_is_equal(ext_lower, "rvz"))
+      return FILE_TYPE_RVZ;
+   if (string_is_equal(ext_lower, "wia"))
+      return FILE_TYPE_WIA;
+   if (string_is_equal(ext_lower, "pbp"))
+      return FILE_TYPE_PBP;
+   if (string_is_equal(ext_lower, "lutro"))
+      return FILE_TYPE_LUTRO;
+   return FILE_TYPE_NONE;
+}
+
+int task_database_hash_content(const char *name,
+      task_database_scan_cache_t *cache,
+      task_database_hash_result_t *res)
+{
+   res->size         = 0;
+   res->archive_size = 0;
+   res->crc          = 0;
+   res->archive_crc  = 0;
+   res->type         = DATABASE_TYPE_CRC_LOOKUP;
+   res->ret          = 1;
+   res->serial[0]    = '\0';
+
+   /* Taken before the read, so that a file changing under it is read
+    * again next time rather than cached as it was */
+   task_database_scan_cache_stat(name, res);
+   if (task_database_scan_cache_lookup(cache, name, res))
+      return res->ret;
+
+   /* A member of an archive: the scanner looks it up by the crc the
+    * archive records for it. */
+   if (path_contains_compressed_file(name))
+   {
+      res->type = DATABASE_TYPE_ITERATE_ARCHIVE;
+#ifdef HAVE_COMPRESSION
+      res->crc  = file_archive_get_file_crc32_and_size(name, &res->size);
+#endif
+      return res->ret;
+   }
+
+   switch (task_database_file_type(name))
+   {
+      case FILE_TYPE_COMPRESSED:
+#ifdef HAVE_COMPRESSION
+         /* first check crc of archive itself */
+         res->ret = intfstream_file_get_crc_and_size(name,
+               0, INT64_MAX, &res->archive_crc, &res->archive_size);
+         /* The crc lookup falls back to the first member when the
+          * archive itself does not match; read that now as well. */
+         if (res->ret)
+            res->crc = file_archive_get_file_crc32_and_size(name,
+                  &res->size);
+#else
+         res->type = DATABASE_TYPE_ITERATE;
+#endif
+         break;
+      case FILE_TYPE_CUE:
+         if (task_database_cue_get_serial(name, res->serial,
+               res->serial_len, &res->size))
+            res->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         else
+         {
+            res->serial[0] = '\0';
+            RARCH_DBG("[Scanner] CUE file serial not detected, fallback to crc.\n");
+            res->ret = task_database_cue_get_crc_and_size(name,
+                  &res->crc, &res->size);
+         }
+         break;
+      case FILE_TYPE_GDI:
+         if (task_database_gdi_get_serial(name, res->serial,
+               res->serial_len, &res->size))
+            res->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         else
+         {
+            res->serial[0] = '\0';
+            RARCH_DBG("[Scanner] GDI file serial not detected, fallback to crc.\n");
+            res->ret = task_database_gdi_get_crc_and_size(name,
+                  &res->crc, &res->size);
+         }
+         break;
+      /* Consider WBFS, RVZ and WIA files similar to ISO files. */
+      case FILE_TYPE_WBFS:
+      case FILE_TYPE_RVZ:
+      case FILE_TYPE_WIA:
+         intfstream_file_get_serial(name, 0, INT64_MAX, res->serial,
+               res->serial_len, &res->size);
+         res->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         break;
+      case FILE_TYPE_ISO:
+         intfstream_file_get_serial(name, 0, INT64_MAX, res->serial,
+               res->serial_len, &res->size);
+         res->type = DATABASE_TYPE_SERIAL_LOOKUP_SIZEHINT;
+         break;
+      case FILE_TYPE_CHD:
+         if (task_database_chd_get_serial(name, res->serial,
+               res->serial_len, &res->size))
+            res->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         else
+         {
+            res->serial[0] = '\0';
+            RARCH_DBG("[Scanner] CHD file serial not detected, fallback to crc.\n");
+            res->ret = task_database_chd_get_crc_and_size(name,
+                  &res->crc, &res->size);
+         }
+         break;
+      case FILE_TYPE_PBP:
+         if (task_database_pbp_get_serial(name, res->serial,
+               res->serial_len, &res->size))
+            res->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         else
+         {
+            res->serial[0] = '\0';
+            RARCH_DBG("[Scanner] PBP file serial not detected, fallback to crc.\n");
+            res->ret = intfstream_file_get_crc_and_size(name,
+                  0, INT64_MAX, &res->crc, &res->size);
+         }
+         break;
+      case FILE_TYPE_LUTRO:
+         res->type = DATABASE_TYPE_ITERATE_LUTRO;
+         break;
+      default:
+         res->ret  = intfstream_file_get_crc_and_size(name,
+               0, INT64_MAX, &res->crc, &res->size);
+         break;
+   }
+
+   return res->ret;
+}
+
+#ifdef HAVE_THREADS
+static void task_database_hash_destroy(task_database_hash_t *hash)
+{
+   size_t i;
+
+   for (i = 0; i < hash->count; i++)
+      free(hash->paths[i]);
+   free(hash->paths);
+   free(hash->skip);
+   task_database_scan_cache_unref(hash->cache);
+   scond_free(hash->cond);
+   slock_free(hash->lock);
+   free(hash);
+}
+
+/* Drops one reference; the last one out frees the pool */
+static void task_database_hash_unref(task_database_hash_t *hash)
+{
+   bool last;
+
+   slock_lock(hash->lock);
+   last = (--hash->refs == 0);
+   slock_unlock(hash->lock);
+
+   if (last)
+      task_database_hash_destroy(hash);
+}
+
+/* 'lock' must be held.  Marks the tracks sheet 'name' lists, among
+ * the entries not yet handed out and within reach of the window. */
+static void task_database_hash_skip_tracks(task_database_hash_t *hash,
+      const char *name, enum msg_file_type type)
+{
+   char path[PATH_MAX_LENGTH];
+   size_t end       = hash->next + TASK_DATABASE_HASH_WINDOW * 2;
+   intfstream_t *fd = NULL;
+
+   if (end > hash->count)
+      end = hash->count;
+   if (hash->next >= end)
+      return;
+
+   /* Reading the sheet is cheap next to the tracks it saves */
+   slock_unlock(hash->lock);
+   fd = intfstream_open_file(name,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   slock_lock(hash->lock);
+
+   if (!fd)
+      return;
+
+   path[0] = '\0';
+   for (;;)
+   {
+      size_t i;
+
+      if (type == FILE_TYPE_CUE)
+      {
+         if (!cue_next_file(fd, name, path, sizeof(path)))
+            break;
+      }
+      else if (!gdi_next_file(fd, name, path, sizeof(path)))
+         break;
+
+      for (i = hash->next; i < end; i++)
+         if (hash->paths[i] && string_is_equal(path, hash->paths[i]))
+            hash->skip[i] = 1;
+   }
+
+   intfstream_close(fd);
+   free(fd);
+}
+
+static void task_database_hash_thread(void *data)
+{
+   task_database_hash_t *hash = (task_database_hash_t*)data;
+
+   sthread_setname("ra-db-hash");
+
+   slock_lock(hash->lock);
+   for (;;)
+   {
+      size_t index;
+      const char *name;
+      enum msg_file_type type;
+      task_database_hash_slot_t *slot;
+
+      if (hash->quit)
+         break;
+
+      if (     hash->next >= hash->count
+            || hash->next >= hash->consumed + TASK_DATABASE_HASH_WINDOW
+            || hash->slots[hash->next % TASK_DATABASE_HASH_WINDOW].state
+               == HASH_SLOT_BUSY)
+      {
+         if (hash->next >= hash->count && hash->consumed >= hash->count)
+            break;
+         scond_wait(hash->cond, hash->lock);
+         continue;
+      }
+
+      index       = hash->next++;
+      name        = hash->paths[index];
+      slot        = &hash->slots[index % TASK_DATABASE_HASH_WINDOW];
+
+      if (!name || hash->skip[index])
+      {
+         /* The scanner reads it itself if it ever gets to it */
+         slot->state = HASH_SLOT_FREE;
+         continue;
+      }
+
+      slot->index = index;
+      slot->state = HASH_SLOT_BUSY;
+      type        = task_database_file_type(name);
+
+      if (type == FILE_TYPE_CUE || type == FILE_TYPE_GDI)
+         task_database_hash_skip_tracks(hash, name, type);
+
+      slock_unlock(hash->lock);
+
+      slot->res.serial     = slot->serial;
+      slot->res.serial_len = sizeof(slot->serial);
+      task_database_hash_content(name, hash->cache, &slot->res);
+
+      slock_lock(hash->lock);
+      slot->state = HASH_SLOT_DONE;
+      scond_broadcast(hash->cond);
+   }
+   slock_unlock(hash->lock);
+
+   task_database_hash_unref(hash);
+}
+#endif
+
+task_database_hash_t *task_database_hash_new(
+      const struct string_list *list, unsigned threads,
+      task_database_scan_cache_t *cache)
+{
+#ifdef HAVE_THREADS
+   size_t i;
+   unsigned started           = 0;
+   task_database_hash_t *hash = NULL;
+
+   if (!list || list->size < 2 || !threads)
+      return NULL;
+   if (threads > TASK_DATABASE_HASH_MAX_THREADS)
+      threads = TASK_DATABASE_HASH_MAX_THREADS;
+
+   if (!(hash = (task_database_hash_t*)calloc(1, sizeof(*hash))))
+      return NULL;
+
+   hash->count = list->size;
+   hash->paths = (char**)calloc(hash->count, sizeof(*hash->paths));
+   hash->skip  = (uint8_t*)calloc(hash->count, sizeof(*hash->skip));
+   hash->lock  = slock_new();
+   hash->cond  = scond_new();
+
+   if (!hash->paths || !hash->skip || !hash->lock || !hash->cond)
+   {
+      free(hash->paths);
+      hash->paths = NULL;
+      hash->count = 0;
+      task_database_hash_destroy(hash);
+      return NULL;
+   }
+
+   for (i = 0; i < hash->count; i++)
+      if (list->elems[i].data)
+         hash->paths[i] = strdup(list->elems[i].data);
+
+   hash->cache = task_database_scan_cache_ref(cache);
+
+   /* Held across the spawn so no thread can drop the count to zero
+    * before the owner's reference is in it */
+   slock_lock(hash->lock);
+   hash->refs = 1;
+   for (i = 0; i < threads; i++)
+   {
+      sthread_t *thread = sthread_create(task_database_hash_thread, hash);
+      if (!thread)
+         break;
+      sthread_detach(thread);
+      hash->refs++;
+      started++;
+   }
+   slock_unlock(hash->lock);
+
+   if (!started)
+   {
+      task_database_hash_unref(hash);
+      return NULL;
+   }
+
+   return hash;
+#else
+   return NULL;
+#endif
+}
+
+bool task_database_hash_ready(task_database_hash_t *hash,
+      size_t index, const char *name)
+{
+#ifdef HAVE_THREADS
+   bool ready = false;
+
+   if (     !hash
+         || index >= hash->count
+         || !hash->paths[index]
+         || !string_is_equal(hash->paths[index], name))
+      return false;
+
+   slock_lock(hash->lock);
+   if (index < hash->next)
+   {
+      task_database_hash_slot_t *slot =
+         &hash->slots[index % TASK_DATABASE_HASH_WINDOW];
+      ready = (slot->index == index && slot->state == HASH_SLOT_DONE);
+   }
+   slock_unlock(hash->lock);
+
+   return ready;
+#else
+   return false;
+#endif
+}
+
+bool task_database_hash_take(task_database_hash_t *hash,
+      size_t index, const char *name, task_database_hash_result_t *res)
+{
+#ifdef HAVE_THREADS
+   bool found = false;
+   task_database_hash_slot_t *slot;
+
+   if (!hash || index >= hash->count)
+      return false;
+
+   /* The list only ever grows at the end and prunes in place, so an
+    * index keeps naming the same file; check regardless. */
+   if (!hash->paths[index] || !string_is_equal(hash->paths[index], name))
+      return false;
+
+   slot = &hash->slots[index % TASK_DATABASE_HASH_WINDOW];
+
+   slock_lock(hash->lock);
+
+   /* Not handed out yet: the readers are behind, so read it inline
+    * rather than queue behind them, and have them skip it. */
+   if (index >= hash->next)
+      hash->next = index + 1;
+   else
+   {
+      while (slot->index == index && slot->state == HASH_SLOT_BUSY)
+         scond_wait(hash->cond, hash->lock);
+
+      if (slot->index == index && slot->state == HASH_SLOT_DONE)
+      {
+         char *serial      = res->serial;
+         size_t serial_len = res->serial_len;
+
+         *res              = slot->res;
+         res->serial       = serial;
+         res->serial_len   = serial_len;
+         strlcpy(res->serial, slot->serial, serial_len);
+
+         slot->state       = HASH_SLOT_FREE;
+         found             = true;
+      }
+   }
+
+   /* Past this entry now; the window moves on */
+   hash->consumed = index + 1;
+   scond_broadcast(hash->cond);
+   slock_unlock(hash->lock);
+
+   return found;
+#else
+   return false;
+#endif
+}
+
+void task_database_hash_free(task_database_hash_t *hash)
+{
+#ifdef HAVE_THREADS
+   if (!hash)
+      return;
+
+   slock_lock(hash->lock);
+   hash->quit = true;
+   scond_broadcast(hash->cond);
+   slock_unlock(hash->lock);
+
+   task_database_hash_unref(hash);
+#endif
+}
@@ -0,0 +1,125 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TASK_DATABASE_HASH
+#define TASK_DATABASE_HASH
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <lists/string_list.h>
+
+#include "../database_info.h"
+#include "../msg_hash.h"
+
+RETRO_BEGIN_DECLS
+
+/* How far ahead of the matcher the pool may read.  Each slot holds a
+ * serial buffer, so this bounds the pool's memory as well. */
+#define TASK_DATABASE_HASH_WINDOW      32
+#define TASK_DATABASE_HASH_MAX_THREADS 4
+
+/* The keys the scanner identifies one content file by, and the lookup
+ * to run with them.  Fields mirror database_state_handle_t; whatever
+ * the file type does not produce is left zero. */
+typedef struct task_database_hash_result
+{
+   /* Caller's buffer: the serial is written here */
+   char *serial;
+   size_t serial_len;
+   uint64_t size;
+   uint64_t archive_size;
+   uint32_t crc;
+   uint32_t archive_crc;
+   /* Size and modification time of the file on disk, which the scan
+    * cache keys on; mtime is 0 when unknown */
+   uint64_t file_size;
+   int64_t mtime;
+   enum database_type type;
+   /* Result of the read that produced the keys; 0 if it failed */
+   int ret;
+} task_database_hash_result_t;
+
+typedef struct task_database_hash task_database_hash_t;
+/* See task_database_scan_cache.h */
+typedef struct task_database_scan_cache task_database_scan_cache_t;
+
+enum msg_file_type task_database_file_type(const char *path);
+
+/**
+ * task_database_hash_content:
+ * @name                 : content path, possibly an archive member
+ * @cache                : scan cache to answer from, or NULL
+ * @res                  : receives the keys; @res->serial must be set
+ *
+ * Reads @name and works out how it is to be looked up, unless @cache
+ * already knows the file as it is now.  Touches no scanner state, so
+ * it may run on any thread.
+ *
+ * Returns: @res->ret.
+ **/
+int task_database_hash_content(const char *name,
+      task_database_scan_cache_t *cache,
+      task_database_hash_result_t *res);
+
+/**
+ * task_database_hash_new:
+ * @list                 : content list of the scan, in scan order
+ * @threads              : reader threads, at most
+ *                         TASK_DATABASE_HASH_MAX_THREADS
+ * @cache                : scan cache for the readers, or NULL; the pool
+ *                         holds a reference until its last thread exits
+ *
+ * Starts hashing the entries of @list ahead of the scan, in order.
+ * @list is copied; entries appended to it later are not covered.
+ *
+ * Returns: the pool, or NULL if there is nothing to gain from one or
+ * no threads are available - callers then hash inline.
+ **/
+task_database_hash_t *task_database_hash_new(
+      const struct string_list *list, unsigned threads,
+      task_database_scan_cache_t *cache);
+
+/**
+ * task_database_hash_ready:
+ *
+ * Returns: true if the pool has finished reading entry @index, @name,
+ * so that taking it neither waits nor falls back to an inline read.
+ **/
+bool task_database_hash_ready(task_database_hash_t *hash,
+      size_t index, const char *name);
+
+/**
+ * task_database_hash_take:
+ * @index                : position of @name in the content list
+ * @res                  : receives the keys, as task_database_hash_content()
+ *
+ * Collects the result for entry @index, waiting if a reader is still
+ * on it, and lets the pool move past it.  Entries must be taken in
+ * ascending order; skipped ones are dropped.
+ *
+ * Returns: false if the pool has no result for @name, in which case
+ * the caller hashes it inline.
+ **/
+bool task_database_hash_take(task_database_hash_t *hash,
+      size_t index, const char *name, task_database_hash_result_t *res);
+
+/* Never waits for a reader still inside a file: the last thread out
+ * releases the pool. */
+void task_database_hash_free(task_database_hash_t *hash);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,502 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* What earlier scans learned about each content file.
+ *
+ * Identifying a file means reading all of it for its crc, or the head
+ * of a disc image for its serial.  On a network share that dominates a
+ * rescan, although almost nothing in a library changes between two
+ * scans.  Each file is recorded here with its size and modification
+ * time; while both still agree, the next scan takes the keys from the
+ * record instead of reading the file again.
+ *
+ * The file is a header followed by one record per content file, all
+ * integers little endian:
+ *
+ *   "RASC" u32 version  u32 count
+ *   u16 len, path       u64 file size   i64 mtime
+ *   u64 size            u64 archive size
+ *   u32 crc             u32 archive crc  u8 type
+ *   u16 len, serial     u16 len, matched database
+ *
+ * It is read and written through streams/cache_file.h. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <retro_miscellaneous.h>
+#include <array/rhmap.h>
+#include <file/file_path.h>
+#include <streams/cache_file.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "../verbosity.h"
+#include "task_database_scan_cache.h"
+
+#define SCAN_CACHE_MAGIC      "RASC"
+/* Offset of the record count in the header */
+#define SCAN_CACHE_COUNT_OFS  8
+
+typedef struct scan_cache_entry
+{
+   /* Also the map key, which borrows it */
+   char *path;
+   char *serial;
+   /* Basename of the database matched, NULL if none */
+   char *db;
+   uint64_t file_size;
+   int64_t mtime;
+   uint64_t size;
+   uint64_t archive_size;
+   uint32_t crc;
+   uint32_t archive_crc;
+   uint8_t type;
+} scan_cache_entry_t;
+
+struct task_database_scan_cache
+{
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   /* Loaded by task_database_scan_cache_open(); read-only after */
+   scan_cache_entry_t **stored;
+   /* Recorded by this scan */
+   scan_cache_entry_t **fresh;
+   unsigned refs;
+   char path[PATH_MAX_LENGTH];
+};
+
+static void scan_cache_entry_free(scan_cache_entry_t *e)
+{
+   if (!e)
+      return;
+   free(e->path);
+   free(e->serial);
+   free(e->db);
+   free(e);
+}
+
+static void scan_cache_map_free(scan_cache_entry_t **map)
+{
+   size_t i, cap;
+
+   for (i = 0, cap = RHMAP_CAP(map); i != cap; i++)
+      if (RHMAP_KEY(map, i))
+         scan_cache_entry_free(map[i]);
+   RHMAP_FREE(map);
+}
+
+/* Takes @e into @map, replacing any entry for the same path.  Frees
+ * @e if it cannot be added. */
+static scan_cache_entry_t **scan_cache_map_put(scan_cache_entry_t **map,
+      scan_cache_entry_t *e)
+{
+   ptrdiff_t idx;
+
+   if (!map)
+   {
+      RHMAP_FIT(map, 16);
+      if (!map)
+      {
+         scan_cache_entry_free(e);
+         return NULL;
+      }
+      RHMAP_BORROW_KEYS(map);
+   }
+
+   /* The old entry owns the key the map holds: swap the value in place
+    * rather than delete and re-insert */
+   if ((idx = RHMAP_IDX_STR(map, e->path)) >= 0)
+   {
+      scan_cache_entry_t *old = map[idx];
+      RHMAP_KEY_STR(map, idx) = e->path;
+      map[idx]                = e;
+      scan_cache_entry_free(old);
+      return map;
+   }
+
+   if (!RHMAP_TRYFIT(map, RHMAP_LEN(map) + 1))
+   {
+      scan_cache_entry_free(e);
+      return map;
+   }
+
+   RHMAP_SET_STR(map, e->path, e);
+   return map;
+}
+
+static scan_cache_entry_t *scan_cache_map_get(scan_cache_entry_t **map,
+      const char *name)
+{
+   /* RHMAP_GET_STR may grow the map; RHMAP_IDX_STR only reads it, which
+    * is what makes lookups on 'stored' safe from the reader threads */
+   ptrdiff_t idx = RHMAP_IDX_STR(map, name);
+   return (idx >= 0) ? map[idx] : NULL;
+}
+
+static scan_cache_entry_t **scan_cache_load(const char *path)
+{
+   uint32_t i, count;
+   cache_file_reader_t r;
+   const uint8_t *magic;
+   void *data                 = NULL;
+   int64_t len                = 0;
+   scan_cache_entry_t **map   = NULL;
+
+   if (!path_is_valid(path))
+      return NULL;
+
+   if (!filestream_read_file(path, &data, &len) || !data)
+      return NULL;
+
+   cache_file_reader_init(&r, data, (size_t)len);
+   magic = cache_file_get(&r, 4);
+
+   if (     !magic
+         || memcmp(magic, SCAN_CACHE_MAGIC, 4)
+         || cache_file_get32(&r) != TASK_DATABASE_SCAN_CACHE_VERSION)
+   {
+      RARCH_LOG("[Scanner] Ignoring scan cache of another version: \"%s\".\n",
+            path);
+      free(data);
+      return NULL;
+   }
+
+   count = cache_file_get32(&r);
+
+   for (i = 0; i < count; i++)
+   {
+      scan_cache_entry_t *e = (scan_cache_entry_t*)
+         calloc(1, sizeof(*e));
+
+      if (!e || !(e->path = cache_file_get_strdup(&r)))
+      {
+         scan_cache_entry_free(e);
+         break;
+      }
+      e->file_size    = cache_file_get64(&r);
+      e->mtime        = (int64_t)cache_file_get64(&r);
+      e->size         = cache_file_get64(&r);
+      e->archive_size = cache_file_get64(&r);
+      e->crc          = cache_file_get32(&r);
+      e->archive_crc  = cache_file_get32(&r);
+      e->type         = (uint8_t)cache_file_get8(&r);
+
+      if (     !(e->serial = cache_file_get_strdup(&r))
+            || !(e->db     = cache_file_get_strdup(&r)))
+      {
+         scan_cache_entry_free(e);
+         break;
+      }
+      if (!*e->db)
+      {
+         free(e->db);
+         e->db = NULL;
+      }
+
+      map = scan_cache_map_put(map, e);
+   }
+
+   if (i < count)
+      RARCH_WARN("[Scanner] Scan cache is truncated, kept %u of %u entries.\n",
+            (unsigned)i, (unsigned)count);
+
+   free(data);
+   return map;
+}
+
+/* Returns false if @e cannot be represented, and then adds nothing */
+static bool scan_cache_put_entry(cache_file_writer_t *w,
+      const scan_cache_entry_t *e)
+{
+   size_t mark = w->len;
+
+   if (!cache_file_put_str(w, e->path))
+      goto error;
+   cache_file_put64(w, e->file_size);
+   cache_file_put64(w, (uint64_t)e->mtime);
+   cache_file_put64(w, e->size);
+   cache_file_put64(w, e->archive_size);
+   cache_file_put32(w, e->crc);
+   cache_file_put32(w, e->archive_crc);
+   cache_file_put8(w, e->type);
+   if (     !cache_file_put_str(w, e->serial)
+         || !cache_file_put_str(w, e->db))
+      goto error;
+   return true;
+
+error:
+   w->len = mark;
+   return false;
+}
+
+/* True if @path is @root or lies beneath it */
+static bool scan_cache_under_root(const char *path, const char *root,
+      size_t root_len)
+{
+   if (!root_len || !string_starts_with_size(path, root, root_len))
+      return false;
+   return    PATH_CHAR_IS_SLASH(root[root_len - 1])
+          || path[root_len] == '\0'
+          || PATH_CHAR_IS_SLASH(path[root_len])
+          || path[root_len] == '#';
+}
+
+task_database_scan_cache_t *task_database_scan_cache_open(const char *path)
+{
+   task_database_scan_cache_t *cache = NULL;
+
+   if (!path || !*path)
+      return NULL;
+
+   if (!(cache = (task_database_scan_cache_t*)calloc(1, sizeof(*cache))))
+      return NULL;
+
+#ifdef HAVE_THREADS
+   if (!(cache->lock = slock_new()))
+   {
+      free(cache);
+      return NULL;
+   }
+#endif
+
+   cache->refs   = 1;
+   strlcpy(cache->path, path, sizeof(cache->path));
+   cache->stored = scan_cache_load(path);
+
+   if (cache->stored)
+      RARCH_LOG("[Scanner] Scan cache holds %u entries.\n",
+            (unsigned)RHMAP_LEN(cache->stored));
+
+   return cache;
+}
+
+task_database_scan_cache_t *task_database_scan_cache_ref(
+      task_database_scan_cache_t *cache)
+{
+   if (!cache)
+      return NULL;
+#ifdef HAVE_THREADS
+   slock_lock(cache->lock);
+#endif
+   cache->refs++;
+#ifdef HAVE_THREADS
+   slock_unlock(cache->lock);
+#endif
+   return cache;
+}
+
+void task_database_scan_cache_unref(task_database_scan_cache_t *cache)
+{
+   bool last;
+
+   if (!cache)
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(cache->lock);
+#endif
+   last = (--cache->refs == 0);
+#ifdef HAVE_THREADS
+   slock_unlock(cache->lock);
+#endif
+
+   if (!last)
+      return;
+
+   scan_cache_map_free(cache->stored);
+   scan_cache_map_free(cache->fresh);
+#ifdef HAVE_THREADS
+   slock_free(cache->lock);
+#endif
+   free(cache);
+}
+
+void task_database_scan_cache_stat(const char *name,
+      task_database_hash_result_t *res)
+{
+   char path[PATH_MAX_LENGTH];
+   const char *delim = path_get_archive_delim(name);
+   int64_t size, mtime;
+
+   res->file_size    = 0;
+   res->mtime        = 0;
+
+   /* An archive member changes only with its archive */
+   if (delim)
+   {
+      size_t _len = (size_t)(delim - name);
+      if (_len >= sizeof(path))
+         return;
+      memcpy(path, name, _len);
+      path[_len] = '\0';
+      name       = path;
+   }
+
+   if (path_get_size_mtime(name, &size, &mtime))
+   {
+      res->file_size = (uint64_t)size;
+      res->mtime     = mtime;
+   }
+}
+
+bool task_database_scan_cache_lookup(task_database_scan_cache_t *cache,
+      const char *name, task_database_hash_result_t *res)
+{
+   scan_cache_entry_t *e;
+
+   if (     !cache
+         || !res->mtime
+         || !(e = scan_cache_map_get(cache->stored, name))
+         ||  e->mtime     != res->mtime
+         ||  e->file_size != res->file_size)
+      return false;
+
+   res->size         = e->size;
+   res->archive_size = e->archive_size;
+   res->crc          = e->crc;
+   res->archive_crc  = e->archive_crc;
+   res->type         = (enum database_type)e->type;
+   res->ret          = 1;
+   strlcpy(res->serial, e->serial ? e->serial : "", res->serial_len);
+   return true;
+}
+
+const char *task_database_scan_cache_match(task_database_scan_cache_t *cache,
+      const char *name)
+{
+   scan_cache_entry_t *e;
+   if (!cache || !(e = scan_cache_map_get(cache->stored, name)))
+      return NULL;
+   return e->db;
+}
+
+void task_database_scan_cache_store(task_database_scan_cache_t *cache,
+      const char *name, const task_database_hash_result_t *res)
+{
+   scan_cache_entry_t *e;
+
+   /* A failed read says nothing about the file next time */
+   if (!cache || !name || !res->mtime || !res->ret)
+      return;
+
+   if (!(e = (scan_cache_entry_t*)calloc(1, sizeof(*e))))
+      return;
+
+   e->path         = strdup(name);
+   e->serial       = strdup(res->serial ? res->serial : "");
+   e->file_size    = res->file_size;
+   e->mtime        = res->mtime;
+   e->size         = res->size;
+   e->archive_size = res->archive_size;
+   e->crc          = res->crc;
+   e->archive_crc  = res->archive_crc;
+   e->type         = (uint8_t)res->type;
+
+   if (!e->path || !e->serial)
+   {
+      scan_cache_entry_free(e);
+      return;
+   }
+
+   cache->fresh = scan_cache_map_put(cache->fresh, e);
+}
+
+void task_database_scan_cache_set_match(task_database_scan_cache_t *cache,
+      const char *name, const char *db_path)
+{
+   scan_cache_entry_t *e;
+
+   if (     !cache
+         || !name
+         || !db_path
+         || !(e = scan_cache_map_get(cache->fresh, name)))
+      return;
+
+   free(e->db);
+   e->db = strdup(path_basename_nocompression(db_path));
+}
+
+bool task_database_scan_cache_write(task_database_scan_cache_t *cache,
+      const char *root)
+{
+   size_t i, cap;
+   cache_file_writer_t w;
+   scan_cache_entry_t **on_disk = NULL;
+   uint32_t count               = 0;
+   uint32_t pruned              = 0;
+   size_t root_len              = root ? strlen(root) : 0;
+   bool ok                      = false;
+
+   /* Nothing fresh does not mean nothing to do: a rescan of a directory
+    * whose files have all gone must still drop their entries below */
+   if (!cache)
+      return false;
+
+   /* Re-read rather than reuse 'stored': another scan may have written
+    * entries for its own directory since this one started */
+   on_disk = scan_cache_load(cache->path);
+
+   memset(&w, 0, sizeof(w));
+   cache_file_put(&w, SCAN_CACHE_MAGIC, 4);
+   cache_file_put32(&w, TASK_DATABASE_SCAN_CACHE_VERSION);
+   cache_file_put32(&w, 0); /* count, patched below */
+
+   for (i = 0, cap = RHMAP_CAP(cache->fresh); i != cap; i++)
+      if (     RHMAP_KEY(cache->fresh, i)
+            && scan_cache_put_entry(&w, cache->fresh[i]))
+         count++;
+
+   for (i = 0, cap = RHMAP_CAP(on_disk); i != cap; i++)
+   {
+      scan_cache_entry_t *e;
+      if (!RHMAP_KEY(on_disk, i))
+         continue;
+      e = on_disk[i];
+      if (scan_cache_map_get(cache->fresh, e->path))
+         continue;
+      if (scan_cache_under_root(e->path, root, root_len))
+      {
+         pruned++;
+         continue;
+      }
+      if (scan_cache_put_entry(&w, e))
+         count++;
+   }
+
+   scan_cache_map_free(on_disk);
+
+   /* Neither recorded nor removed anything: the file is already right */
+   if (!cache->fresh && !pruned)
+   {
+      cache_file_writer_free(&w);
+      return true;
+   }
+
+   cache_file_patch32(&w, SCAN_CACHE_COUNT_OFS, count);
+
+   if ((ok = cache_file_write(&w, cache->path)))
+      RARCH_LOG("[Scanner] Scan cache written: %u entries.\n", (unsigned)count);
+   else
+      RARCH_WARN("[Scanner] Failed to write scan cache: \"%s\".\n",
+            cache->path);
+
+   cache_file_writer_free(&w);
+   return ok;
+}
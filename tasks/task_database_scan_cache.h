@@ -0,0 +1,99 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TASK_DATABASE_SCAN_CACHE
+#define TASK_DATABASE_SCAN_CACHE
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+#include "task_database_hash.h"
+
+RETRO_BEGIN_DECLS
+
+/* Bumped whenever the record layout, or what task_database_hash_content()
+ * produces for a file, changes; a cache of another version is ignored */
+#define TASK_DATABASE_SCAN_CACHE_VERSION 1
+
+/**
+ * task_database_scan_cache_open:
+ * @path                 : cache file; need not exist yet
+ *
+ * Loads what earlier scans recorded.  What is loaded is never modified
+ * afterwards, so lookups may run on any thread while the scan records
+ * on its own.
+ *
+ * Returns: the cache, holding one reference, or NULL on OOM.
+ **/
+task_database_scan_cache_t *task_database_scan_cache_open(const char *path);
+
+task_database_scan_cache_t *task_database_scan_cache_ref(
+      task_database_scan_cache_t *cache);
+
+void task_database_scan_cache_unref(task_database_scan_cache_t *cache);
+
+/**
+ * task_database_scan_cache_stat:
+ * @name                 : content path, possibly an archive member
+ *
+ * Fills in the key of @res: the size and modification time of @name,
+ * or of the archive holding it.  @res->mtime is left 0 where the
+ * platform cannot say, which keeps the file out of the cache.
+ **/
+void task_database_scan_cache_stat(const char *name,
+      task_database_hash_result_t *res);
+
+/**
+ * task_database_scan_cache_lookup:
+ * @res                  : keyed by task_database_scan_cache_stat()
+ *
+ * Returns: true, with the rest of @res filled in, if an earlier scan
+ * read @name at this size and modification time.
+ **/
+bool task_database_scan_cache_lookup(task_database_scan_cache_t *cache,
+      const char *name, task_database_hash_result_t *res);
+
+/* Database the entry matched when the cache was last written, or NULL.
+ * Only a hint: it is tried first, not trusted. */
+const char *task_database_scan_cache_match(task_database_scan_cache_t *cache,
+      const char *name);
+
+/* The following run on the scan's own thread only. */
+
+/* Records @res for @name, replacing anything loaded for it */
+void task_database_scan_cache_store(task_database_scan_cache_t *cache,
+      const char *name, const task_database_hash_result_t *res);
+
+/* Notes the database @name matched; @db_path is the .rdb */
+void task_database_scan_cache_set_match(task_database_scan_cache_t *cache,
+      const char *name, const char *db_path);
+
+/**
+ * task_database_scan_cache_write:
+ * @root                 : content directory (or file) the scan covered
+ *
+ * Writes everything recorded by this scan back to the cache file, along
+ * with the entries the file holds for content outside @root.  Entries
+ * under @root this scan did not record are dropped: the files are gone.
+ *
+ * Returns: true on success.
+ **/
+bool task_database_scan_cache_write(task_database_scan_cache_t *cache,
+      const char *root);
+
+RETRO_END_DECLS
+
+#endif
@@ -1108,6 +1108,7 @@ bool task_push_image_load(const char *fullpath,
    t->cleanup         = task_image_load_free;
    t->callback        = cb;
    t->user_data       = user_data;
+   t->priority        = TASK_PRIORITY_LATENCY;
 
    task_queue_push(t);
 
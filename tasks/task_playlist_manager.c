@@ -33,6 +33,11 @@
 #include "../file_path_special.h"
 #include "../playlist.h"
 #include "../core_info.h"
+#include "../verbosity.h"
+
+#ifdef HAVE_CHEEVOS
+#include "../cheevos/cheevos.h"
+#endif
 
 enum pl_manager_status
 {
@@ -46,6 +51,8 @@ enum pl_manager_status
    PL_MANAGER_CHECK_DUPLICATE_END,
    PL_MANAGER_ITERATE_FETCH_M3U,
    PL_MANAGER_ITERATE_CLEAN_M3U,
+   PL_MANAGER_PARSE_CHEEVOS_HASH,
+   PL_MANAGER_ITERATE_ENTRY_CHEEVOS_HASH,
    PL_MANAGER_END
 };
 
@@ -60,6 +67,10 @@ typedef struct pl_manager_handle
    playlist_config_t playlist_config; /* size_t alignment */
    playlist_parse_t *parse;           /* in-flight playlist read */
    enum pl_manager_status status;
+#ifdef HAVE_CHEEVOS
+   /* Entries per rcheevos_prewarm_hash() result */
+   unsigned cheevos_results[RCHEEVOS_PREWARM_HASHED + 1];
+#endif
 } pl_manager_handle_t;
 
 /* Per-frame I/O window, consulted between batches of parse work.
@@ -862,3 +873,248 @@ error:
 
    return false;
 }
+
+/****************************/
+/* Cache Achievement Hashes */
+/****************************/
+
+#ifdef HAVE_CHEEVOS
+static void task_pl_manager_cheevos_hash_entry(
+      pl_manager_handle_t *pl_manager, const char *path)
+{
+   rm3u_t *m3u = NULL;
+
+   pl_manager->cheevos_results[rcheevos_prewarm_hash(path)]++;
+
+   /* A disc swap hashes the new disc on its own, so the discs
+    * of an M3U are worth caching as well */
+   if (rm3u_is_m3u_filestream(path) && (m3u = rm3u_load_filestream(path)))
+   {
+      size_t i;
+      for (i = 0; i < rm3u_get_size(m3u); i++)
+      {
+         rm3u_entry_t *m3u_entry = NULL;
+         if (     rm3u_get_entry(m3u, i, &m3u_entry)
+               && m3u_entry->full_path
+               && *m3u_entry->full_path)
+            rcheevos_prewarm_hash(m3u_entry->full_path);
+      }
+      rm3u_free(m3u);
+   }
+}
+
+static void task_pl_manager_cheevos_hash_prewarm_handler(retro_task_t *task)
+{
+   uint8_t flg;
+   pl_manager_handle_t *pl_manager = NULL;
+
+   if (!task)
+      goto task_finished;
+
+   pl_manager = (pl_manager_handle_t*)task->state;
+
+   if (!pl_manager)
+      goto task_finished;
+
+   flg = task_get_flags(task);
+
+   if ((flg & RETRO_TASK_FLG_CANCELLED) > 0)
+   {
+      /* Keep what was hashed so far */
+      rcheevos_prewarm_end();
+      goto task_finished;
+   }
+
+   switch (pl_manager->status)
+   {
+      case PL_MANAGER_BEGIN:
+         /* Load playlist */
+         if (!path_is_valid(pl_manager->playlist_config.path))
+            goto task_finished;
+
+         if (!(pl_manager->parse = playlist_parse_begin(
+               &pl_manager->playlist_config)))
+            goto task_finished;
+
+         pl_manager->status = PL_MANAGER_PARSE_CHEEVOS_HASH;
+         break;
+      case PL_MANAGER_PARSE_CHEEVOS_HASH:
+         {
+            int r = pl_manager_parse_step(pl_manager);
+            if (r < 0)
+               goto task_finished;
+            if (r > 0)
+               pl_manager->status = PL_MANAGER_ITERATE_ENTRY_CHEEVOS_HASH;
+         }
+         break;
+      case PL_MANAGER_ITERATE_ENTRY_CHEEVOS_HASH:
+         {
+            const struct playlist_entry *entry = NULL;
+
+            /* Get current entry */
+            playlist_get_index(
+                  pl_manager->playlist, pl_manager->list_index, &entry);
+
+            if (entry && entry->path && *entry->path)
+            {
+               size_t _len;
+               char task_title[128];
+               /* Update progress display */
+               task_free_title(task);
+               _len = strlcpy(task_title,
+                     msg_hash_to_str(MSG_PLAYLIST_MANAGER_CHEEVOS_HASHING),
+                     sizeof(task_title));
+
+               if (entry->label && *entry->label)
+                  strlcpy(task_title + _len, entry->label, sizeof(task_title) - _len);
+               else
+                  fill_pathname(task_title + _len, path_basename(entry->path), "",
+                        sizeof(task_title) - _len);
+
+               task_set_title(task, strdup(task_title));
+               task_set_progress(task, (pl_manager->list_index * 100) / pl_manager->list_size);
+
+               task_pl_manager_cheevos_hash_entry(pl_manager, entry->path);
+            }
+
+            /* Increment entry index */
+            pl_manager->list_index++;
+            if (pl_manager->list_index >= pl_manager->list_size)
+               pl_manager->status = PL_MANAGER_END;
+         }
+         break;
+      case PL_MANAGER_END:
+         {
+            size_t _len;
+            char task_title[128];
+
+            rcheevos_prewarm_end();
+
+            RARCH_LOG("[Playlist] Achievement hashes for \"%s\": "
+                  "%u computed, %u already cached, %u skipped, %u failed.\n",
+                  pl_manager->playlist_name,
+                  pl_manager->cheevos_results[RCHEEVOS_PREWARM_HASHED],
+                  pl_manager->cheevos_results[RCHEEVOS_PREWARM_CACHED],
+                  pl_manager->cheevos_results[RCHEEVOS_PREWARM_SKIPPED],
+                  pl_manager->cheevos_results[RCHEEVOS_PREWARM_FAILED]);
+
+            /* Update progress display */
+            task_free_title(task);
+            _len = strlcpy(task_title,
+                  msg_hash_to_str(MSG_PLAYLIST_MANAGER_CHEEVOS_HASHED),
+                  sizeof(task_title));
+            strlcpy(task_title + _len, pl_manager->playlist_name, sizeof(task_title) - _len);
+
+            task_set_title(task, strdup(task_title));
+         }
+         /* fall-through */
+      default:
+         task_set_progress(task, 100);
+         goto task_finished;
+   }
+
+   return;
+
+task_finished:
+   if (task)
+      task_set_flags(task, RETRO_TASK_FLG_FINISHED, true);
+}
+
+static bool task_pl_manager_cheevos_hash_prewarm_finder(
+      retro_task_t *task, void *user_data)
+{
+   pl_manager_handle_t *pl_manager = NULL;
+
+   if (!task || !user_data)
+      return false;
+
+   if (task->handler != task_pl_manager_cheevos_hash_prewarm_handler)
+      return false;
+
+   pl_manager = (pl_manager_handle_t*)task->state;
+   if (!pl_manager)
+      return false;
+
+   return string_is_equal((const char*)user_data,
+         pl_manager->playlist_config.path);
+}
+
+bool task_push_pl_manager_cheevos_hash_prewarm(
+      const playlist_config_t *playlist_config)
+{
+   size_t _len;
+   task_finder_data_t find_data;
+   char task_title[128];
+   char playlist_name[NAME_MAX_LENGTH];
+   retro_task_t *task              = task_init();
+   pl_manager_handle_t *pl_manager = (pl_manager_handle_t*)
+      calloc(1, sizeof(pl_manager_handle_t));
+   /* Sanity check */
+   if (!playlist_config || !task || !pl_manager || !*playlist_config->path)
+      goto error;
+
+   fill_pathname(playlist_name,
+         path_basename(playlist_config->path), "",
+         sizeof(playlist_name));
+
+   if (!*playlist_name)
+      goto error;
+
+   /* Prewarming the same playlist twice at once
+    * gains nothing */
+   find_data.func                = task_pl_manager_cheevos_hash_prewarm_finder;
+   find_data.userdata            = (void*)playlist_config->path;
+
+   if (task_queue_find(&find_data))
+      goto error;
+
+   /* Opens the hash cache, which must happen
+    * on the main thread */
+   if (!rcheevos_prewarm_begin())
+      goto error;
+
+   /* Configure handle */
+   if (!playlist_config_copy(playlist_config, &pl_manager->playlist_config))
+      goto error;
+
+   pl_manager->playlist_name       = strdup(playlist_name);
+   pl_manager->playlist            = NULL;
+   pl_manager->list_size           = 0;
+   pl_manager->list_index          = 0;
+   pl_manager->m3u_list            = NULL;
+   pl_manager->m3u_index           = 0;
+   pl_manager->status              = PL_MANAGER_BEGIN;
+
+   /* Configure task */
+   _len = strlcpy(task_title,
+         msg_hash_to_str(MSG_PLAYLIST_MANAGER_CHEEVOS_HASHING),
+         sizeof(task_title));
+   strlcpy(task_title + _len, playlist_name, sizeof(task_title) - _len);
+
+   task->handler                 = task_pl_manager_cheevos_hash_prewarm_handler;
+   task->state                   = pl_manager;
+   task->title                   = strdup(task_title);
+   task->progress                = 0;
+   task->callback                = NULL;
+   task->cleanup                 = task_pl_manager_free;
+
+   task->flags                  |= RETRO_TASK_FLG_ALTERNATIVE_LOOK;
+
+   task_queue_push(task);
+
+   return true;
+
+error:
+
+   if (task)
+   {
+      free(task);
+      task = NULL;
+   }
+
+   free_pl_manager_handle(pl_manager);
+   pl_manager = NULL;
+
+   return false;
+}
+#endif
@@ -149,6 +149,12 @@ typedef struct
 
 typedef save_task_state_t load_task_data_t;
 
+/* Every savestate task runs on this one worker of the task pool. The
+ * save, load and undo tasks share undo_save_buf, undo_load_buf and
+ * the spare below without a lock, which only holds while no two of
+ * them ever run at once. */
+#define SAVE_TASK_AFFINITY (TASK_AFFINITY_ANY + 1)
+
 /* Holds the previous saved state
  * Can be restored to disk with undo_save_state(). */
 static struct save_state_buf undo_save_buf;
@@ -864,6 +870,8 @@ static bool task_push_undo_save_state(const char *path, void *data, size_t len)
       task->state           = state;
       task->handler         = task_save_handler;
       task->callback        = undo_save_state_cb;
+      task->priority        = TASK_PRIORITY_LATENCY;
+      task->affinity        = SAVE_TASK_AFFINITY;
       task->title           = strdup(msg_hash_to_str(MSG_UNDOING_SAVE_STATE));
 
       if (state->flags & SAVE_TASK_FLAG_MUTE)
@@ -1537,6 +1545,8 @@ static void task_push_save_state(const char *path, void *data, size_t len, bool
    task->state                   = state;
    task->handler                 = task_save_handler;
    task->callback                = save_state_cb;
+   task->priority                = TASK_PRIORITY_LATENCY;
+   task->affinity                = SAVE_TASK_AFFINITY;
    task->title                   = strdup(msg_hash_to_str(MSG_SAVING_STATE));
 
    if (state->flags & SAVE_TASK_FLAG_MUTE)
@@ -1662,6 +1672,8 @@ static void task_push_load_and_save_state(const char *path, void *data,
    task->type                   = TASK_TYPE_BLOCKING;
    task->handler                = task_load_handler;
    task->callback               = content_load_and_save_state_cb;
+   task->priority               = TASK_PRIORITY_LATENCY;
+   task->affinity               = SAVE_TASK_AFFINITY;
    task->title                  = strdup(msg_hash_to_str(MSG_LOADING_STATE));
 
    load_state_task_pending      = true;
@@ -1895,6 +1907,10 @@ bool content_save_state_in_progress(void* data)
 
 void content_wait_for_save_state_task(void)
 {
+#ifdef HAVE_CHEEVOS
+   /* The task may be waiting for achievements to finish a frame */
+   rcheevos_sync();
+#endif
    task_queue_wait(content_save_state_in_progress, NULL);
 }
 
@@ -1926,6 +1942,10 @@ bool content_load_state_in_progress(void* data)
 
 void content_wait_for_load_state_task(void)
 {
+#ifdef HAVE_CHEEVOS
+   /* The task may be waiting for achievements to finish a frame */
+   rcheevos_sync();
+#endif
    task_queue_wait(content_load_state_in_progress, NULL);
 }
 
@@ -1985,6 +2005,8 @@ bool content_load_state(const char *path,
    task->state                  = state;
    task->handler                = task_load_handler;
    task->callback               = content_load_state_cb;
+   task->priority               = TASK_PRIORITY_LATENCY;
+   task->affinity               = SAVE_TASK_AFFINITY;
    task->title                  = strdup(msg_hash_to_str(MSG_LOADING_STATE));
 
    load_state_task_pending      = true;
@@ -38,6 +38,7 @@
 
 #ifdef HAVE_RPNG
 #include <formats/rpng.h>
+#include <features/features_cpu.h>
 #define IMG_EXT "png"
 #else
 #define IMG_EXT "bmp"
@@ -114,19 +115,25 @@ static bool screenshot_save_png(const char *path, const uint8_t *data,
          RETRO_VFS_FILE_ACCESS_WRITE,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-   /* Stream the encode straight into the file.  The VFS gives every
+   /* The encode goes straight into the file.  The VFS gives every
     * file a 64 KiB stdio buffer, so the encoder's 16 KiB IDAT chunks
     * already coalesce into large writes; measured at 4K, buffering the
     * whole compressed image first and writing it in one call is
     * indistinguishable in wall time (deflate dominates by two orders
     * of magnitude) while costing a raw-frame-sized allocation that
-    * no-overcommit platforms would have to commit up front.  Peak
-    * scratch this way is a handful of rows plus the deflate window. */
+    * no-overcommit platforms would have to commit up front. */
    if (!intf_s)
       return false;
 
-   ret = rpng_save_image_stream_fmt(data, intf_s,
-         width, height, pitch, fmt, hdr);
+   /* Deflate is the whole cost of a screenshot, so cut the rows into
+    * one band per core and compress them in parallel.  That holds the
+    * compressed bands in memory until they are written, a fraction of
+    * the raw frame.  Single-core machines, short frames and builds
+    * without threads are handed to the single-stream encoder instead,
+    * whose peak scratch is a handful of rows plus the deflate window. */
+   ret = rpng_save_image_stream_fmt_threaded(data, intf_s,
+         width, height, pitch, fmt, hdr,
+         (unsigned)cpu_features_get_core_amount());
 
    intfstream_close(intf_s);
    free(intf_s);
@@ -681,6 +688,7 @@ static bool screenshot_dump(
       task->type         = TASK_TYPE_BLOCKING;
       task->state        = state;
       task->handler      = task_screenshot_handler;
+      task->priority     = TASK_PRIORITY_LATENCY;
       if (savestate)
          task->flags    |=  RETRO_TASK_FLG_MUTE;
       else
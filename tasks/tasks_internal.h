@@ -221,6 +221,10 @@ bool task_push_core_restore(const char *backup_path,
 
 bool task_push_pl_manager_reset_cores(const playlist_config_t *playlist_config);
 bool task_push_pl_manager_clean_playlist(const playlist_config_t *playlist_config);
+#ifdef HAVE_CHEEVOS
+/* Computes the achievement hash of every entry into the hash cache */
+bool task_push_pl_manager_cheevos_hash_prewarm(const playlist_config_t *playlist_config);
+#endif
 
 /* downscale_cap: if non-zero, the decoded image is capped to this many
  * pixels on its longest side before upload, preserving aspect ratio.